@@ -0,0 +1,79 @@
+#!/bin/bash
+# This script measures the overhead of the extension on an OLTP workload that
+# never touches a hypertable. It runs the same pgbench workloads against two
+# databases, one without the extension and one with the extension and a
+# hypertable, and prints the throughput of each along with the overhead.
+#
+# The workloads are pgbench's built-in TPC-B like transactions, run with both
+# the simple and the extended query protocol so that planning is part of every
+# statement, and a transaction that creates, fills and drops a temporary
+# table, to include utility commands. The server must have timescaledb in
+# shared_preload_libraries.
+
+if [[ -z "$1" || -z "$2" ]]; then
+    echo "Usage: $0 seconds clients [pgbench CONNECTION OPTIONS]"
+    echo "    seconds - Duration of each pgbench run"
+    echo "    clients - Number of concurrent clients, also used as the scale"
+    echo "    "
+    echo "Any connection options for psql/pgbench (e.g. -h host, -U username) should be listed at the end"
+    exit 1
+fi
+
+SECONDS_PER_RUN=$1
+CLIENTS=$2
+
+shift 2
+set -e
+CONNECTION="$@"
+DB_PLAIN=bench_oltp_plain
+DB_TIMESCALEDB=bench_oltp_timescaledb
+TEMP_TABLE_SCRIPT=$(mktemp)
+trap 'rm -f $TEMP_TABLE_SCRIPT' EXIT
+
+cat > $TEMP_TABLE_SCRIPT <<EOF
+\set aid random(1, 100000 * :scale)
+BEGIN;
+CREATE TEMP TABLE bench_tmp (aid int, abalance int) ON COMMIT DROP;
+INSERT INTO bench_tmp SELECT aid, abalance FROM pgbench_accounts WHERE aid BETWEEN :aid AND :aid + 10;
+CREATE INDEX ON bench_tmp (aid);
+UPDATE bench_tmp SET abalance = abalance + 1;
+COMMIT;
+EOF
+
+setup_db() {
+    psql $CONNECTION -qX -d postgres -v "ON_ERROR_STOP=1" -c "DROP DATABASE IF EXISTS $1;" -c "CREATE DATABASE $1;"
+    pgbench $CONNECTION -q -i -s $CLIENTS $1 > /dev/null 2>&1
+}
+
+# Print the tps of a pgbench run, excluding connection establishment
+run_pgbench() {
+    pgbench $CONNECTION -n -c $CLIENTS -j $CLIENTS -T $SECONDS_PER_RUN "$@" 2>/dev/null |
+        sed -n 's/^tps = \([0-9.]*\) (excluding connections establishing)$/\1/p'
+}
+
+echo "Creating databases with scale $CLIENTS..."
+setup_db $DB_PLAIN
+setup_db $DB_TIMESCALEDB
+psql $CONNECTION -qX -d $DB_TIMESCALEDB -v "ON_ERROR_STOP=1" <<EOF
+SET client_min_messages = error;
+CREATE EXTENSION timescaledb;
+CREATE TABLE bench_metrics (time timestamptz NOT NULL, device int, value float);
+SELECT create_hypertable('bench_metrics', 'time');
+INSERT INTO bench_metrics
+SELECT t, d, random() FROM generate_series(now() - interval '30 days', now(), interval '1 hour') t,
+       generate_series(1, 10) d;
+EOF
+
+printf "%-24s %12s %12s %10s\n" "workload" "plain tps" "tsdb tps" "overhead"
+
+for WORKLOAD in "tpcb simple:-M simple" "tpcb extended:-M extended" "tpcb prepared:-M prepared" \
+                "temp table ddl:-M simple -f $TEMP_TABLE_SCRIPT"; do
+    NAME=${WORKLOAD%%:*}
+    ARGS=${WORKLOAD#*:}
+    TPS_PLAIN=$(run_pgbench $ARGS $DB_PLAIN)
+    TPS_TIMESCALEDB=$(run_pgbench $ARGS $DB_TIMESCALEDB)
+    OVERHEAD=$(echo "$TPS_PLAIN $TPS_TIMESCALEDB" | awk '{ printf "%.2f%%", ($1 - $2) * 100 / $1 }')
+    printf "%-24s %12.1f %12.1f %10s\n" "$NAME" $TPS_PLAIN $TPS_TIMESCALEDB $OVERHEAD
+done
+
+psql $CONNECTION -qX -d postgres -c "DROP DATABASE $DB_PLAIN;" -c "DROP DATABASE $DB_TIMESCALEDB;"
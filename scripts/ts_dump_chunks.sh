@@ -0,0 +1,107 @@
+#!/bin/bash
+# This script is used for backing up a single hypertable chunk by chunk, so
+# that large hypertables can be backed up and restored in parallel. The backup
+# is a directory that contains (1) a .sql file for recreating the hypertable
+# and its indices, as made by ts_dump.sh, and (2) a gzipped .csv file with the
+# data of each chunk, plus one with the rows of the hypertable's own table,
+# e.g., those that a deferred migration has not moved to chunks yet. It also
+# records the start of each chunk's time interval, so that the restore can
+# create all chunks before loading them. Restore it with ts_restore_chunks.sh.
+#
+# Compressed chunks are read through the hypertable, restricted to the chunk's
+# dimension constraints, since the chunk's own table holds only its
+# uncompressed rows. Such a query also returns the rows of the hypertable's own
+# table in the chunk's range, so a hypertable with compressed chunks cannot be
+# backed up while its own table holds rows. They are restored uncompressed.
+#
+# Chunks are copied by separate connections, but all of them read the same
+# snapshot. The snapshot is exported by a transaction that is kept open until
+# the backup is done, so the backup is consistent.
+
+
+if [[ -z "$1" || -z "$2" || -z "$3" ]]; then
+    echo "Usage: $0 hypertable output_name jobs [pg_dump CONNECTION OPTIONS]"
+    echo "    hypertable  - Hypertable to backup"
+    echo "    output_name - Output files will be stored in a directory named [output_name]"
+    echo "    jobs        - Number of chunks to backup in parallel"
+    echo "    "
+    echo "Any connection options for pg_dump/psql (e.g. -d database, -U username) should be listed at the end"
+    exit 1
+fi
+
+HYPERTABLE=$1
+PREFIX=$2
+JOBS=$3
+
+shift 3
+set -e
+CONNECTION="$@"
+mkdir $PREFIX
+
+echo "Exporting snapshot..."
+coproc SNAPSHOT_PSQL { psql $CONNECTION -qAtX -v "ON_ERROR_STOP=1"; }
+trap 'kill $SNAPSHOT_PSQL_PID 2> /dev/null' EXIT
+echo "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY; SELECT pg_export_snapshot();" >&${SNAPSHOT_PSQL[1]}
+read -r SNAPSHOT <&${SNAPSHOT_PSQL[0]}
+
+# Run psql commands in a transaction that uses the exported snapshot
+psql_in_snapshot() {
+    psql $CONNECTION -qAtX -v "ON_ERROR_STOP=1" <<EOF
+BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY;
+SET TRANSACTION SNAPSHOT '$SNAPSHOT';
+$1
+COMMIT;
+EOF
+}
+
+# Copy the chunk's columns in the order of the hypertable's columns, since
+# chunks do not have the hypertable's dropped columns
+dump_chunk() {
+    echo "Backing up chunk $1 as $PREFIX/$1.csv.gz..."
+    local RESTRICTION=$(psql_in_snapshot "SELECT string_agg(pg_get_expr(con.conbin, con.conrelid), ' AND ')
+FROM _timescaledb_catalog.compressed_chunk comp
+INNER JOIN _timescaledb_catalog.chunk c ON (c.id = comp.chunk_id)
+INNER JOIN _timescaledb_catalog.chunk_constraint cc ON (cc.chunk_id = c.id)
+INNER JOIN pg_constraint con ON (con.conrelid = '$1'::regclass AND con.conname = cc.constraint_name)
+WHERE format('%I.%I', c.schema_name, c.table_name)::regclass = '$1'::regclass
+AND cc.dimension_slice_id IS NOT NULL;")
+    if [[ -z "$RESTRICTION" ]]; then
+        psql_in_snapshot "\\COPY (SELECT $COLUMNS FROM ONLY $1) TO PROGRAM 'gzip > $PREFIX/$1.csv.gz' DELIMITER ',' CSV"
+    else
+        psql_in_snapshot "\\COPY (SELECT $COLUMNS FROM $HYPERTABLE WHERE $RESTRICTION) TO PROGRAM 'gzip > $PREFIX/$1.csv.gz' DELIMITER ',' CSV"
+    fi
+}
+
+echo "Backing up schema as $PREFIX/schema.sql..."
+pg_dump $CONNECTION --snapshot=$SNAPSHOT --schema-only -t $HYPERTABLE -f $PREFIX/schema.sql
+echo "--" >> $PREFIX/schema.sql
+echo "-- Restore to hypertable" >> $PREFIX/schema.sql
+echo "--" >> $PREFIX/schema.sql
+psql_in_snapshot "SELECT _timescaledb_internal.get_create_command('$HYPERTABLE');" >> $PREFIX/schema.sql
+
+HAS_COMPRESSED_AND_OWN_ROWS=$(psql_in_snapshot "SELECT EXISTS (SELECT 1 FROM _timescaledb_catalog.compressed_chunk comp INNER JOIN _timescaledb_catalog.hypertable h ON (h.id = comp.hypertable_id) WHERE format('%I.%I', h.schema_name, h.table_name)::regclass = '$HYPERTABLE'::regclass) AND EXISTS (SELECT 1 FROM ONLY $HYPERTABLE);")
+if [[ "$HAS_COMPRESSED_AND_OWN_ROWS" == "t" ]]; then
+    echo "Hypertable $HYPERTABLE has compressed chunks and rows in its own table, move them to chunks with move_data_to_chunks() first."
+    exit 1
+fi
+
+echo "Backing up chunk intervals as $PREFIX/chunks.txt..."
+psql_in_snapshot "SELECT DISTINCT ds.range_start
+FROM _timescaledb_catalog.hypertable h
+INNER JOIN _timescaledb_catalog.chunk c ON (c.hypertable_id = h.id)
+INNER JOIN _timescaledb_catalog.chunk_constraint cc ON (cc.chunk_id = c.id)
+INNER JOIN _timescaledb_catalog.dimension_slice ds ON (ds.id = cc.dimension_slice_id)
+INNER JOIN _timescaledb_catalog.dimension d ON (d.id = ds.dimension_id)
+WHERE format('%I.%I', h.schema_name, h.table_name)::regclass = '$HYPERTABLE'::regclass
+AND d.interval_length IS NOT NULL
+ORDER BY ds.range_start;" > $PREFIX/chunks.txt
+
+COLUMNS=$(psql_in_snapshot "SELECT string_agg(quote_ident(attname), ', ' ORDER BY attnum) FROM pg_attribute WHERE attrelid = '$HYPERTABLE'::regclass AND attnum > 0 AND NOT attisdropped;")
+CHUNKS=$(psql_in_snapshot "SELECT '$HYPERTABLE'::regclass UNION ALL (SELECT inhrelid::regclass FROM pg_inherits WHERE inhparent = '$HYPERTABLE'::regclass ORDER BY inhrelid);")
+
+echo "Backing up data with $JOBS jobs..."
+export CONNECTION SNAPSHOT PREFIX COLUMNS HYPERTABLE
+export -f psql_in_snapshot dump_chunk
+echo "$CHUNKS" | xargs -r -n 1 -P $JOBS bash -c 'dump_chunk "$0"'
+
+echo "COMMIT;" >&${SNAPSHOT_PSQL[1]}
@@ -0,0 +1,63 @@
+#!/bin/bash
+# This script is used for restoring a hypertable from a directory made with
+# ts_dump_chunks.sh. The hypertable is created first, then all of its chunks
+# are created in a single transaction, for the time intervals recorded by the
+# backup, and then the chunks' data files are restored in parallel, each by its
+# own connection. Creating a chunk locks the hypertable until the creating
+# transaction commits, so chunks created by the loads themselves would make
+# the loads wait for each other.
+#
+# Chunks are created for every space partition of a recorded time interval,
+# so partitions that had no chunk in that interval get an empty one. The rows
+# of the hypertable's own table are restored into chunks like any others; if
+# they fall outside the recorded intervals, their load still creates chunks.
+
+
+if [[ -z "$1" || -z "$2" || -z "$3" ]]; then
+    echo "Usage: $0 hypertable directory jobs"
+    echo "    hypertable - Hypertable to restore"
+    echo "    directory  - Name of the directory created by ts_dump_chunks.sh to restore"
+    echo "    jobs       - Number of chunks to restore in parallel"
+    echo "    "
+    echo "Any connection options for psql (e.g. -d database, -U username) should be listed at the end"
+    exit 1
+
+fi
+
+HYPERTABLE=$1
+PREFIX=$2
+JOBS=$3
+shift 3
+CONNECTION="$@"
+
+restore_chunk() {
+    echo "Restoring $1..."
+    psql $CONNECTION -qX -v "ON_ERROR_STOP=1" <<EOF
+SET timescaledb.defer_chunk_index_build = on;
+\\COPY $HYPERTABLE FROM PROGRAM 'gunzip -c $1' DELIMITER ',' CSV
+EOF
+}
+
+echo "Restoring hypertable's schema..."
+psql -q -v "ON_ERROR_STOP=1" $CONNECTION < $PREFIX/schema.sql
+if [ $? -ne 0 ]; then
+    echo "Restoring schema failed, exiting."
+    exit 1
+fi
+
+echo "Creating hypertable's chunks..."
+sed "s/.*/SELECT create_chunks_ahead('$HYPERTABLE', 0, &::bigint);/" $PREFIX/chunks.txt | \
+    psql -q -v "ON_ERROR_STOP=1" --single-transaction $CONNECTION > /dev/null
+if [ $? -ne 0 ]; then
+    echo "Creating chunks failed, exiting."
+    exit 1
+fi
+
+echo "Restoring hypertable's data with $JOBS jobs..."
+export CONNECTION HYPERTABLE
+export -f restore_chunk
+ls $PREFIX/*.csv.gz | xargs -r -n 1 -P $JOBS bash -c 'restore_chunk "$0"'
+if [ $? -ne 0 ]; then
+    echo "Restoring data failed, exiting."
+    exit 1
+fi
@@ -0,0 +1,151 @@
+-- Policies that the background job scheduler of the database runs
+-- periodically on a hypertable. Each add function returns the ID of the
+-- policy's job, which can be passed to alter_job_schedule(). A hypertable
+-- can have one policy of each type, and its policies are removed when it is
+-- dropped.
+
+-- Add a retention policy that drops the chunks of a hypertable that are older
+-- than an interval, relative to the time of each run.
+--
+-- hypertable - Hypertable to drop chunks of. Its time column must be of
+--     a TIMESTAMP, TIMESTAMPTZ or DATE type
+-- older_than - Drop chunks that end before this long ago
+-- cascade - Drop the objects that depend on the chunks, like drop_chunks()
+-- schedule_interval - Time between runs of the policy
+-- if_not_exists - If set, and the hypertable already has a retention policy,
+--     generate a notice and return the existing policy's job instead of an error
+CREATE OR REPLACE FUNCTION add_drop_chunks_policy(
+    hypertable              REGCLASS,
+    older_than              INTERVAL,
+    cascade                 BOOLEAN = FALSE,
+    schedule_interval       INTERVAL = '1 day',
+    if_not_exists           BOOLEAN = FALSE
+) RETURNS INTEGER
+AS '@MODULE_PATHNAME@', 'bgw_policy_drop_chunks_add' LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION remove_drop_chunks_policy(
+    hypertable              REGCLASS,
+    if_exists               BOOLEAN = FALSE
+) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'bgw_policy_drop_chunks_remove' LANGUAGE C VOLATILE;
+
+-- Add a policy that creates the chunks of a hypertable for the current time
+-- interval and a number of following ones ahead of the data, like
+-- create_chunks_ahead().
+CREATE OR REPLACE FUNCTION add_create_chunks_ahead_policy(
+    hypertable              REGCLASS,
+    num_intervals           INTEGER = 1,
+    schedule_interval       INTERVAL = '1 day',
+    if_not_exists           BOOLEAN = FALSE
+) RETURNS INTEGER
+AS '@MODULE_PATHNAME@', 'bgw_policy_create_chunks_ahead_add' LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION remove_create_chunks_ahead_policy(
+    hypertable              REGCLASS,
+    if_exists               BOOLEAN = FALSE
+) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'bgw_policy_create_chunks_ahead_remove' LANGUAGE C VOLATILE;
+
+-- Add a policy that reorders the chunks of a hypertable that end more than
+-- an interval ago, like reorder_chunk(). Each run reorders the most recent
+-- of these chunks that is not yet ordered on the index.
+--
+-- hypertable - Hypertable to reorder chunks of. Its time column must be of
+--     a TIMESTAMP, TIMESTAMPTZ or DATE type
+-- index_name - B-tree index of the hypertable to order the chunks by
+-- older_than - Reorder chunks that end before this long ago. The default
+--     reorders all chunks whose time interval has passed.
+CREATE OR REPLACE FUNCTION add_reorder_policy(
+    hypertable              REGCLASS,
+    index_name              NAME,
+    older_than              INTERVAL = '0',
+    schedule_interval       INTERVAL = '1 day',
+    if_not_exists           BOOLEAN = FALSE
+) RETURNS INTEGER
+AS '@MODULE_PATHNAME@', 'bgw_policy_reorder_add' LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION remove_reorder_policy(
+    hypertable              REGCLASS,
+    if_exists               BOOLEAN = FALSE
+) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'bgw_policy_reorder_remove' LANGUAGE C VOLATILE;
+
+-- Add a tiering policy that moves the chunks of a hypertable that end more
+-- than an interval ago to other tablespaces, like move_chunk(). Each run
+-- moves the oldest of these chunks that is not yet in the tablespaces.
+--
+-- hypertable - Hypertable to move chunks of. Its time column must be of
+--     a TIMESTAMP, TIMESTAMPTZ or DATE type
+-- older_than - Move chunks that end before this long ago
+-- tablespace - Tablespace to move the chunks' data to. It must be attached
+--     to the hypertable.
+-- index_tablespace - Tablespace to move the chunks' indexes to. Defaults to
+--     the data tablespace, and must also be attached to the hypertable.
+CREATE OR REPLACE FUNCTION add_move_chunks_policy(
+    hypertable              REGCLASS,
+    older_than              INTERVAL,
+    tablespace              NAME,
+    index_tablespace        NAME = NULL,
+    schedule_interval       INTERVAL = '1 day',
+    if_not_exists           BOOLEAN = FALSE
+) RETURNS INTEGER
+AS '@MODULE_PATHNAME@', 'bgw_policy_move_chunks_add' LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION remove_move_chunks_policy(
+    hypertable              REGCLASS,
+    if_exists               BOOLEAN = FALSE
+) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'bgw_policy_move_chunks_remove' LANGUAGE C VOLATILE;
+
+-- Add a policy that rebuilds the chunks' copy of a hypertable index with
+-- another index access method once the chunks end more than an interval ago,
+-- e.g., a B-tree on time as a much smaller BRIN index for chunks that are no
+-- longer written to. New chunks get the hypertable index as is. Each run
+-- rebuilds the index of the most recent of these chunks that does not use the
+-- access method yet.
+--
+-- hypertable - Hypertable to rebuild chunk indexes of. Its time column must
+--     be of a TIMESTAMP, TIMESTAMPTZ or DATE type
+-- index_name - Index of the hypertable whose chunk copies are rebuilt. It
+--     cannot be a unique or constraint index.
+-- older_than - Rebuild the indexes of chunks that end before this long ago
+-- access_method - Index access method to rebuild the chunk indexes with,
+--     using the default operator classes of the method
+CREATE OR REPLACE FUNCTION add_cold_index_policy(
+    hypertable              REGCLASS,
+    index_name              NAME,
+    older_than              INTERVAL,
+    access_method           NAME = 'brin',
+    schedule_interval       INTERVAL = '1 day',
+    if_not_exists           BOOLEAN = FALSE
+) RETURNS INTEGER
+AS '@MODULE_PATHNAME@', 'bgw_policy_cold_index_add' LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION remove_cold_index_policy(
+    hypertable              REGCLASS,
+    if_exists               BOOLEAN = FALSE
+) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'bgw_policy_cold_index_remove' LANGUAGE C VOLATILE;
+
+-- Change the schedule of a job. NULL arguments keep the current setting.
+--
+-- schedule_interval - Time between runs
+-- max_runtime - Time after which a run is canceled, or zero for no limit
+-- max_retries - Number of times a failed run is retried before waiting for
+--     the next scheduled run, or -1 to always retry
+-- retry_period - Time before the first retry, which doubles with each
+--     consecutive failure up to the schedule interval
+CREATE OR REPLACE FUNCTION alter_job_schedule(
+    job_id                  INTEGER,
+    schedule_interval       INTERVAL = NULL,
+    max_runtime             INTERVAL = NULL,
+    max_retries             INTEGER = NULL,
+    retry_period            INTERVAL = NULL
+) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'bgw_job_alter_schedule' LANGUAGE C VOLATILE;
+
+-- Run a job in the current session, e.g., to test a policy.
+CREATE OR REPLACE FUNCTION _timescaledb_internal.bgw_job_run(
+    job_id                  INTEGER
+) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'bgw_job_run' LANGUAGE C VOLATILE STRICT;
@@ -14,3 +14,13 @@ CREATE TABLE IF NOT EXISTS  _timescaledb_cache.cache_inval_extension();
 -- not actually strictly needed but good for sanity as all tables should be dumped.
 SELECT pg_catalog.pg_extension_config_dump('_timescaledb_cache.cache_inval_hypertable', '');
 SELECT pg_catalog.pg_extension_config_dump('_timescaledb_cache.cache_inval_extension', '');
+
+-- Statistics of the current backend's metadata caches: the hypertable cache,
+-- the chunk cache of each cached hypertable and the chunk insert state caches
+-- of finished inserts. Useful when tuning max_cached_chunks_per_hypertable,
+-- max_open_chunks_per_insert and hypertable_cache_memory_limit.
+CREATE OR REPLACE FUNCTION _timescaledb_internal.cache_stats()
+    RETURNS TABLE(cache_name TEXT, hypertable REGCLASS, num_entries BIGINT, max_entries INTEGER,
+                  hits BIGINT, misses BIGINT, evictions BIGINT, memory_bytes BIGINT,
+                  max_memory_bytes BIGINT)
+    AS '@MODULE_PATHNAME@', 'cache_stats' LANGUAGE C VOLATILE STRICT;
@@ -11,3 +11,11 @@ CREATE OR REPLACE FUNCTION _timescaledb_internal.dimension_calculate_default_ran
     OUT range_start       BIGINT,
     OUT range_end         BIGINT)
     AS '@MODULE_PATHNAME@', 'dimension_calculate_closed_range_default' LANGUAGE C STABLE;
+
+-- Calculate the interval of the first open dimension of a hypertable that
+-- adaptive chunking would use for a new chunk at the given coordinate.
+CREATE OR REPLACE FUNCTION _timescaledb_internal.calculate_chunk_interval(
+        hypertable          REGCLASS,
+        dimension_coord     BIGINT,
+        chunk_target_size   BIGINT
+) RETURNS BIGINT AS '@MODULE_PATHNAME@', 'chunk_adaptive_calculate_chunk_interval' LANGUAGE C STABLE;
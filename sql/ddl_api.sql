@@ -13,6 +13,8 @@
 -- if_not_exists - (Optional) Do not fail if table is already a hypertable
 -- partitioning_func - (Optional) The partitioning function to use for spatial partitioning
 -- migrate_data - (Optional) Set to true to migrate any existing data in the table to chunks
+-- defer_migration - (Optional) Set to true to leave existing data in the table, to be
+--     migrated in batches with move_data_to_chunks()
 CREATE OR REPLACE FUNCTION  create_hypertable(
     main_table              REGCLASS,
     time_column_name        NAME,
@@ -24,9 +26,78 @@ CREATE OR REPLACE FUNCTION  create_hypertable(
     create_default_indexes  BOOLEAN = TRUE,
     if_not_exists           BOOLEAN = FALSE,
     partitioning_func       REGPROC = NULL,
-    migrate_data            BOOLEAN = FALSE
+    migrate_data            BOOLEAN = FALSE,
+    defer_migration         BOOLEAN = FALSE
 ) RETURNS VOID AS '@MODULE_PATHNAME@', 'hypertable_create' LANGUAGE C VOLATILE;
 
+-- Move a batch of rows still stored in the main table of a hypertable
+-- (e.g., after create_hypertable(..., defer_migration => true)) to chunks.
+--
+-- Rows are moved in time order, oldest first, and the number of rows moved is
+-- returned. Call repeatedly, in separate transactions, until it returns
+-- zero. Since every batch commits on its own, an interrupted migration can
+-- be resumed by calling the function again. Rows locked by another session
+-- are skipped, so several sessions can move data concurrently.
+--
+-- The oldest rows are found with an ORDER BY on the time column over the main
+-- table, which uses the index on the time column that create_hypertable()
+-- creates by default. Without such an index, every call sorts all the rows
+-- that remain in the main table, so create one before migrating large tables.
+--
+-- Queries on the hypertable read the main table as long as it has any blocks.
+-- Once the last rows are moved, the main table is truncated so that they no
+-- longer do. This is skipped while other sessions use the hypertable, and
+-- left to the next call, or to a VACUUM of the main table.
+--
+-- main_table - The hypertable to move data for
+-- batch_size - (Optional) The maximum number of rows to move
+CREATE OR REPLACE FUNCTION move_data_to_chunks(
+    main_table  REGCLASS,
+    batch_size  INTEGER = 100000
+)
+    RETURNS BIGINT LANGUAGE PLPGSQL VOLATILE AS
+$BODY$
+DECLARE
+    time_column NAME;
+    rows_moved  BIGINT;
+BEGIN
+    SELECT time_dimension.column_name
+    FROM _timescaledb_catalog.hypertable h
+    INNER JOIN pg_class c ON (c.relname = h.table_name)
+    INNER JOIN pg_namespace n ON (n.oid = c.relnamespace AND n.nspname = h.schema_name)
+    INNER JOIN _timescaledb_internal.dimension_get_time(h.id) time_dimension ON(true)
+    WHERE c.oid = main_table
+    INTO time_column;
+
+    IF time_column IS NULL THEN
+        RAISE 'table "%" is not a hypertable', main_table
+        USING ERRCODE = 'IO001';
+    END IF;
+
+    EXECUTE format(
+        $$
+        WITH moved AS (
+            DELETE FROM ONLY %1$s
+            WHERE ctid = ANY(ARRAY(
+                SELECT ctid FROM ONLY %1$s
+                ORDER BY %2$I
+                LIMIT %3$s
+                FOR UPDATE SKIP LOCKED))
+            RETURNING *
+        )
+        INSERT INTO %1$s SELECT * FROM moved
+        $$, main_table, time_column, batch_size);
+
+    GET DIAGNOSTICS rows_moved = ROW_COUNT;
+
+    IF rows_moved < batch_size THEN
+        PERFORM _timescaledb_internal.truncate_main_table_if_empty(main_table);
+    END IF;
+
+    RETURN rows_moved;
+END
+$BODY$;
+
 -- Update chunk_time_interval for a hypertable.
 --
 -- main_table - The OID of the table corresponding to a hypertable whose time
@@ -41,13 +112,393 @@ CREATE OR REPLACE FUNCTION  set_chunk_time_interval(
     dimension_name          NAME = NULL
 ) RETURNS VOID AS '@MODULE_PATHNAME@', 'dimension_set_interval' LANGUAGE C VOLATILE;
 
+-- Size new chunks adaptively instead of with a fixed chunk_time_interval.
+-- Whenever a chunk is created, the interval of the first time dimension is
+-- recalculated so that the chunk is about the target size on disk, including
+-- indexes, given the sizes of the chunks just before it.
+--
+-- main_table - Hypertable to set adaptive chunking for
+-- chunk_target_size - Target size of a chunk, e.g., '1GB'. 'estimate' derives
+--     the target from shared_buffers, and 'off' or NULL turns adaptive
+--     chunking off, keeping the current interval.
+--
+-- Returns the target size in bytes, or zero if adaptive chunking is off.
+CREATE OR REPLACE FUNCTION set_adaptive_chunking(
+    main_table              REGCLASS,
+    chunk_target_size       TEXT
+) RETURNS BIGINT AS '@MODULE_PATHNAME@', 'chunk_adaptive_set' LANGUAGE C VOLATILE;
+
+-- Pre-create chunks ahead of the data so that inserts that cross into a new
+-- time interval do not create tables on the insert path.
+--
+-- main_table - Hypertable to create chunks for
+-- num_intervals - Number of time intervals, following the one that covers
+--     from_time, to create chunks for. Chunks are created in all space
+--     partitions.
+-- from_time - Time to start from. Defaults to the current time, which is only
+--     possible for TIMESTAMP/TIMESTAMPTZ/DATE time columns.
+--
+-- Returns the number of chunks created.
+CREATE OR REPLACE FUNCTION create_chunks_ahead(
+    main_table              REGCLASS,
+    num_intervals           INTEGER = 1
+) RETURNS INTEGER AS '@MODULE_PATHNAME@', 'chunk_create_ahead' LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION create_chunks_ahead(
+    main_table              REGCLASS,
+    num_intervals           INTEGER,
+    from_time               ANYELEMENT
+) RETURNS INTEGER AS '@MODULE_PATHNAME@', 'chunk_create_ahead' LANGUAGE C VOLATILE;
+
+-- Merge adjacent chunks in the same space partition into larger chunks, e.g.,
+-- after the chunk time interval was set too small. Each run of adjacent
+-- chunks is merged into its first chunk, so that the merged chunk covers at
+-- most the target interval, and the other chunks are dropped. The chunks are
+-- locked while their rows are copied, so only chunks that no longer receive
+-- inserts should be merged. Compressed chunks are not merged.
+--
+-- main_table - Hypertable to merge chunks of
+-- older_than - Only merge chunks that end before this time. Defaults to all
+--     chunks.
+-- target_interval - Maximum time interval of a merged chunk, as an INTERVAL
+--     or integer. Defaults to the current chunk time interval.
+--
+-- Returns the number of chunks merged into other chunks.
+CREATE OR REPLACE FUNCTION merge_chunks(
+    main_table              REGCLASS,
+    older_than              "any" = NULL,
+    target_interval         "any" = NULL
+) RETURNS INTEGER AS '@MODULE_PATHNAME@', 'chunk_merge_chunks' LANGUAGE C VOLATILE;
+
+-- Redistribute the rows of existing chunks according to the current number
+-- of space partitions, e.g., after set_number_partitions(), which otherwise
+-- only affects new chunks. Chunks that do not match the current partitioning
+-- are replaced by chunks that do, in the same time range. The replaced chunks
+-- are locked while their rows are moved, so this is meant for recent chunks
+-- rather than the whole history. Compressed chunks are not repartitioned.
+--
+-- main_table - Hypertable to repartition chunks of
+-- newer_than - Only repartition chunks that end after this time. Defaults to
+--     all chunks.
+--
+-- Returns the number of chunks that were repartitioned.
+CREATE OR REPLACE FUNCTION repartition_chunks(
+    main_table              REGCLASS,
+    newer_than              "any" = NULL
+) RETURNS INTEGER AS '@MODULE_PATHNAME@', 'chunk_repartition_chunks' LANGUAGE C VOLATILE;
+
+-- Turn a view that aggregates a hypertable by time_bucket() into a continuous
+-- aggregate: the view's results are materialized into a new hypertable, and
+-- the view is replaced to read the materialization instead. The original
+-- query is kept as a partial view, next to the view. The view must select
+-- from a single hypertable, group by a time_bucket() with a constant width
+-- on the hypertable's time column, and only use immutable functions.
+--
+-- Inserts, updates, and deletes on the hypertable are logged from then on, so
+-- that refresh_continuous_aggregate() only recomputes the buckets they
+-- touched. Inserts into the hypertable wait for the transaction that creates
+-- the continuous aggregate.
+--
+-- view - The view to materialize
+CREATE OR REPLACE FUNCTION create_continuous_aggregate(
+    view    REGCLASS
+)
+    RETURNS VOID LANGUAGE PLPGSQL VOLATILE AS
+$BODY$
+DECLARE
+    bucket          RECORD;
+    time_dim        RECORD;
+    raw_table       REGCLASS;
+    view_schema     NAME;
+    partial_view    NAME;
+    mat_table       NAME;
+BEGIN
+    SELECT * INTO STRICT bucket
+    FROM _timescaledb_internal.continuous_agg_view_bucket(view);
+
+    SELECT format('%I.%I', h.schema_name, h.table_name)::regclass INTO STRICT raw_table
+    FROM _timescaledb_catalog.hypertable h
+    WHERE h.id = bucket.raw_hypertable_id;
+
+    SELECT * INTO STRICT time_dim
+    FROM _timescaledb_internal.dimension_get_time(bucket.raw_hypertable_id);
+
+    SELECT n.nspname INTO STRICT view_schema
+    FROM pg_class c
+    INNER JOIN pg_namespace n ON (n.oid = c.relnamespace)
+    WHERE c.oid = view;
+
+    -- No insert may miss both the initial materialization and the log
+    EXECUTE format('LOCK TABLE %s IN SHARE MODE', raw_table);
+
+    partial_view := format('_partial_view_%s', view::oid);
+    mat_table := format('_materialized_hypertable_%s', view::oid);
+
+    EXECUTE format('CREATE VIEW %I.%I AS %s', view_schema, partial_view,
+                   trim(trailing ';' from pg_get_viewdef(view)));
+    EXECUTE format('CREATE TABLE %I.%I AS SELECT * FROM %I.%I WITH NO DATA',
+                   view_schema, mat_table, view_schema, partial_view);
+
+    -- The materialization has far fewer rows per time interval
+    PERFORM create_hypertable(format('%I.%I', view_schema, mat_table)::regclass,
+                              bucket.bucket_column,
+                              chunk_time_interval => time_dim.interval_length * 10);
+
+    PERFORM _timescaledb_internal.continuous_agg_register(view,
+        format('%I.%I', view_schema, partial_view)::regclass,
+        format('%I.%I', view_schema, mat_table)::regclass);
+
+    -- Inserts are logged by the insert path, which needs no trigger
+    IF NOT EXISTS (SELECT 1 FROM pg_trigger
+                   WHERE tgrelid = raw_table AND tgname = 'ts_continuous_agg_invalidation') THEN
+        EXECUTE format(
+            $$
+            CREATE TRIGGER ts_continuous_agg_invalidation
+            AFTER UPDATE OR DELETE ON %s
+            FOR EACH ROW EXECUTE PROCEDURE _timescaledb_internal.continuous_agg_invalidation_trigger(%s)
+            $$, raw_table, bucket.raw_hypertable_id);
+    END IF;
+
+    EXECUTE format('INSERT INTO %I.%I SELECT * FROM %I.%I',
+                   view_schema, mat_table, view_schema, partial_view);
+    EXECUTE format('CREATE OR REPLACE VIEW %s AS SELECT * FROM %I.%I',
+                   view, view_schema, mat_table);
+END
+$BODY$;
+
+-- Bring a continuous aggregate up to date with the modifications of its
+-- hypertable since the last refresh. All buckets from the one of the earliest
+-- modified time to the one of the latest modified time are recomputed from
+-- the hypertable and replaced in the materialization. Truncating the
+-- hypertable invalidates all buckets, and dropping chunks with cascade
+-- invalidates all buckets before the dropped time.
+--
+-- view - The continuous aggregate to refresh
+--
+-- Returns the number of rows materialized.
+CREATE OR REPLACE FUNCTION refresh_continuous_aggregate(
+    view    REGCLASS
+)
+    RETURNS BIGINT LANGUAGE PLPGSQL VOLATILE AS
+$BODY$
+DECLARE
+    cagg                RECORD;
+    invalidation        RECORD;
+    width_sql           TEXT;
+    range_sql           TEXT;
+    rows_materialized   BIGINT;
+BEGIN
+    SELECT ca.mat_hypertable_id, ca.partial_view_schema, ca.partial_view_name, ca.bucket_width,
+           h.schema_name AS mat_schema, h.table_name AS mat_table,
+           mat_dim.column_name AS bucket_column, raw_dim.column_type AS time_type
+    INTO cagg
+    FROM _timescaledb_catalog.continuous_agg ca
+    INNER JOIN pg_class c ON (c.relname = ca.user_view_name)
+    INNER JOIN pg_namespace n ON (n.oid = c.relnamespace AND n.nspname = ca.user_view_schema)
+    INNER JOIN _timescaledb_catalog.hypertable h ON (h.id = ca.mat_hypertable_id)
+    INNER JOIN _timescaledb_internal.dimension_get_time(ca.mat_hypertable_id) mat_dim ON (true)
+    INNER JOIN _timescaledb_internal.dimension_get_time(ca.raw_hypertable_id) raw_dim ON (true)
+    WHERE c.oid = view;
+
+    IF NOT FOUND THEN
+        RAISE 'view "%" is not a continuous aggregate', view
+        USING ERRCODE = 'wrong_object_type';
+    END IF;
+
+    SELECT * INTO STRICT invalidation
+    FROM _timescaledb_internal.continuous_agg_take_invalidation(cagg.mat_hypertable_id);
+
+    IF invalidation.lowest IS NULL THEN
+        RETURN 0;
+    END IF;
+
+    IF cagg.time_type IN ('SMALLINT'::regtype, 'INTEGER'::regtype, 'BIGINT'::regtype) THEN
+        width_sql := format('%s::%s', cagg.bucket_width, cagg.time_type);
+    ELSE
+        width_sql := format('%L::interval', cagg.bucket_width || ' microseconds');
+    END IF;
+
+    -- The bounds are constants, which the hypertable expansion turns into
+    -- ranges of time to exclude chunks of the hypertable with. The extremes
+    -- of the internal time, e.g., of a truncate, leave the range open.
+    range_sql := 'true';
+
+    IF invalidation.lowest > (-9223372036854775808)::bigint THEN
+        range_sql := format('%1$I >= time_bucket(%2$s, %3$s::%4$s)',
+                            cagg.bucket_column, width_sql,
+                            _timescaledb_internal.time_literal_sql(invalidation.lowest, cagg.time_type),
+                            cagg.time_type);
+    END IF;
+
+    IF invalidation.greatest < 9223372036854775807 THEN
+        range_sql := format('%1$s AND %2$I <= time_bucket(%3$s, %4$s::%5$s)',
+                            range_sql, cagg.bucket_column, width_sql,
+                            _timescaledb_internal.time_literal_sql(invalidation.greatest, cagg.time_type),
+                            cagg.time_type);
+    END IF;
+
+    EXECUTE format('DELETE FROM %I.%I WHERE %s', cagg.mat_schema, cagg.mat_table, range_sql);
+    EXECUTE format('INSERT INTO %I.%I SELECT * FROM %I.%I WHERE %s',
+                   cagg.mat_schema, cagg.mat_table,
+                   cagg.partial_view_schema, cagg.partial_view_name, range_sql);
+
+    GET DIAGNOSTICS rows_materialized = ROW_COUNT;
+
+    RETURN rows_materialized;
+END
+$BODY$;
+
+-- Drop a continuous aggregate, including its partial view and
+-- materialization.
+--
+-- view - The continuous aggregate to drop
+CREATE OR REPLACE FUNCTION drop_continuous_aggregate(
+    view    REGCLASS
+)
+    RETURNS VOID LANGUAGE PLPGSQL VOLATILE AS
+$BODY$
+DECLARE
+    cagg    RECORD;
+BEGIN
+    SELECT ca.raw_hypertable_id, ca.partial_view_schema, ca.partial_view_name,
+           h.schema_name AS mat_schema, h.table_name AS mat_table,
+           format('%I.%I', raw.schema_name, raw.table_name) AS raw_table
+    INTO cagg
+    FROM _timescaledb_catalog.continuous_agg ca
+    INNER JOIN pg_class c ON (c.relname = ca.user_view_name)
+    INNER JOIN pg_namespace n ON (n.oid = c.relnamespace AND n.nspname = ca.user_view_schema)
+    INNER JOIN _timescaledb_catalog.hypertable h ON (h.id = ca.mat_hypertable_id)
+    INNER JOIN _timescaledb_catalog.hypertable raw ON (raw.id = ca.raw_hypertable_id)
+    WHERE c.oid = view;
+
+    IF NOT FOUND THEN
+        RAISE 'view "%" is not a continuous aggregate', view
+        USING ERRCODE = 'wrong_object_type';
+    END IF;
+
+    EXECUTE format('DROP VIEW %s', view);
+    EXECUTE format('DROP VIEW %I.%I', cagg.partial_view_schema, cagg.partial_view_name);
+
+    -- Dropping the materialization hypertable removes the catalog entry
+    EXECUTE format('DROP TABLE %I.%I', cagg.mat_schema, cagg.mat_table);
+
+    IF NOT EXISTS (SELECT 1 FROM _timescaledb_catalog.continuous_agg
+                   WHERE raw_hypertable_id = cagg.raw_hypertable_id) THEN
+        EXECUTE format('DROP TRIGGER IF EXISTS ts_continuous_agg_invalidation ON %s', cagg.raw_table);
+    END IF;
+END
+$BODY$;
+
+-- Rewrite a chunk sorted on an index, like CLUSTER, but without blocking
+-- reads while the chunk is rewritten. Writes to the chunk are blocked, so it
+-- is meant for chunks that no longer receive inserts. Reads are blocked only
+-- while the new data is swapped in, until the end of the transaction.
+--
+-- chunk - Chunk to reorder
+-- index - Index of the chunk or of its hypertable to order by. Defaults
+--     to the index the chunk was last reordered or clustered on.
+-- verbose - Report progress like CLUSTER VERBOSE
+CREATE OR REPLACE FUNCTION reorder_chunk(
+    chunk                   REGCLASS,
+    index                   REGCLASS = NULL,
+    verbose                 BOOLEAN = FALSE
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'reorder_chunk_sql' LANGUAGE C VOLATILE;
+
+-- Move a chunk to other tablespaces, e.g., from fast to cheaper storage as it
+-- ages. Like reorder_chunk(), writes to the chunk are blocked while it is
+-- copied, and reads only while the copy is swapped in. A compressed chunk is
+-- moved with its compressed data.
+--
+-- chunk - Chunk to move
+-- tablespace - Tablespace to move the chunk's data to. It must be attached
+--     to the chunk's hypertable with attach_tablespace().
+-- index_tablespace - Tablespace to move the chunk's indexes to. Defaults to
+--     the data tablespace, and must also be attached to the hypertable.
+-- reorder_index - If set, also reorder the chunk on this index of the chunk
+--     or of its hypertable
+-- verbose - Report progress like CLUSTER VERBOSE
+CREATE OR REPLACE FUNCTION move_chunk(
+    chunk                   REGCLASS,
+    tablespace              NAME,
+    index_tablespace        NAME = NULL,
+    reorder_index           REGCLASS = NULL,
+    verbose                 BOOLEAN = FALSE
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'move_chunk_sql' LANGUAGE C VOLATILE;
+
+-- Rewrite a chunk with the physical layout of its hypertable. Chunks created
+-- before a column was dropped from the hypertable lack the dropped column's
+-- position, so rows inserted into them are converted one by one, while newer
+-- chunks get the hypertable's layout. Like move_chunk(), writes to the chunk
+-- are blocked while it is copied, and reads only while the copy is swapped
+-- in. Compressed chunks cannot be normalized.
+--
+-- chunk - Chunk to rewrite
+--
+-- Returns true if the chunk was rewritten, or false if it already had the
+-- hypertable's layout.
+CREATE OR REPLACE FUNCTION normalize_chunk_rowtype(
+    chunk                   REGCLASS
+) RETURNS BOOLEAN AS '@MODULE_PATHNAME@', 'chunk_normalize_rowtype' LANGUAGE C VOLATILE;
+
+-- Compress a chunk into batches of up to 1000 rows that are stored column by
+-- column, with each column compressed by an encoding that suits its type.
+-- Queries on the hypertable decompress the batches as they read them. A
+-- compressed chunk still takes inserts, which are stored uncompressed, but its
+-- rows cannot be updated or deleted until it is decompressed.
+--
+-- chunk - Chunk to compress
+-- segment_by - Column, e.g., a device ID, whose value all rows of a batch
+--     share. Defaults to batches in time order only.
+CREATE OR REPLACE FUNCTION compress_chunk(
+    chunk                   REGCLASS,
+    segment_by              NAME = NULL
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'compress_chunk_sql' LANGUAGE C VOLATILE;
+
+-- Move the rows of a compressed chunk back into the chunk.
+CREATE OR REPLACE FUNCTION decompress_chunk(
+    chunk                   REGCLASS
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'decompress_chunk_sql' LANGUAGE C VOLATILE;
+
+-- Keep a bloom filter of the values of a column in each chunk, e.g., of a
+-- request or trace ID, so that queries for a value of the column skip the
+-- chunks that cannot contain it. A chunk's filter is built when the chunk is
+-- reordered, or with build_bloom_filters(), and is deleted when rows are
+-- written to the chunk. The column's type must have a hash function.
+--
+-- main_table - Hypertable to keep filters for
+-- column_name - Column to keep filters of
+-- if_not_exists - Only give a notice if the column already has filters
+CREATE OR REPLACE FUNCTION add_bloom_filter(
+    main_table              REGCLASS,
+    column_name             NAME,
+    if_not_exists           BOOLEAN = FALSE
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'chunk_bloom_filter_add_column' LANGUAGE C VOLATILE;
+
+-- Stop keeping bloom filters of a column, and delete the filters of all
+-- chunks.
+CREATE OR REPLACE FUNCTION remove_bloom_filter(
+    main_table              REGCLASS,
+    column_name             NAME,
+    if_exists               BOOLEAN = FALSE
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'chunk_bloom_filter_remove_column' LANGUAGE C VOLATILE;
+
+-- Build the bloom filters of a chunk, e.g., of a chunk that no longer
+-- receives inserts. Writes to the chunk are blocked while it is read.
+--
+-- Returns false if the chunk's hypertable has no columns with filters.
+CREATE OR REPLACE FUNCTION build_bloom_filters(
+    chunk                   REGCLASS
+) RETURNS BOOLEAN AS '@MODULE_PATHNAME@', 'chunk_bloom_filter_build_sql' LANGUAGE C VOLATILE;
+
 CREATE OR REPLACE FUNCTION  set_number_partitions(
     main_table              REGCLASS,
     number_partitions       INTEGER,
     dimension_name          NAME = NULL
 ) RETURNS VOID AS '@MODULE_PATHNAME@', 'dimension_set_num_slices' LANGUAGE C VOLATILE;
 
--- Drop chunks that are older than a timestamp.
+-- Drop chunks that are older than a timestamp. With cascade, the continuous
+-- aggregates of the hypertables recompute their buckets of the dropped data
+-- on the next refresh.
 CREATE OR REPLACE FUNCTION drop_chunks(
     older_than anyelement,
     table_name  NAME = NULL,
@@ -148,3 +599,31 @@ AS '@MODULE_PATHNAME@', 'tablespace_detach_all_from_hypertable' LANGUAGE C VOLAT
 
 CREATE OR REPLACE FUNCTION show_tablespaces(hypertable REGCLASS) RETURNS SETOF NAME
 AS '@MODULE_PATHNAME@', 'tablespace_show' LANGUAGE C VOLATILE STRICT;
+
+-- Attach a data node, a postgres_fdw foreign server, to a hypertable. New
+-- chunks of the hypertable are then created as foreign tables on its data
+-- nodes, which must have a hypertable with the same schema, name and
+-- columns. Dropping chunks, or the hypertable, deletes their rows from the
+-- data nodes.
+--
+-- Queries read the rows of each chunk from its data node and aggregate them
+-- locally. The restrictions of a chunk in a space dimension are only applied
+-- on the data node if timescaledb is in the server's extensions option.
+CREATE OR REPLACE FUNCTION attach_data_node(
+    node_name NAME,
+    hypertable REGCLASS,
+    if_not_attached BOOLEAN = false
+) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'data_node_attach' LANGUAGE C VOLATILE;
+
+-- Stop creating new chunks of a hypertable on a data node. Existing chunks
+-- on the node are kept.
+CREATE OR REPLACE FUNCTION detach_data_node(
+    node_name NAME,
+    hypertable REGCLASS,
+    if_attached BOOLEAN = false
+) RETURNS INTEGER
+AS '@MODULE_PATHNAME@', 'data_node_detach' LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION show_data_nodes(hypertable REGCLASS) RETURNS SETOF NAME
+AS '@MODULE_PATHNAME@', 'data_node_show' LANGUAGE C VOLATILE STRICT;
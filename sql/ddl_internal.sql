@@ -19,61 +19,14 @@ CREATE OR REPLACE FUNCTION _timescaledb_internal.drop_chunks_impl(
     cascade  BOOLEAN = FALSE,
     truncate_before  BOOLEAN = FALSE
 )
-    RETURNS VOID LANGUAGE PLPGSQL VOLATILE AS
-$BODY$
-DECLARE
-    chunk_row _timescaledb_catalog.chunk;
-    cascade_mod TEXT = '';
-    exist_count INT = 0;
-BEGIN
-    IF older_than_time IS NULL AND table_name IS NULL AND schema_name IS NULL THEN
-        RAISE 'Cannot have all 3 arguments to drop_chunks_older_than be NULL';
-    END IF;
-
-    IF cascade THEN
-        cascade_mod = 'CASCADE';
-    END IF;
-
-    IF table_name IS NOT NULL THEN
-        SELECT COUNT(*)
-        FROM _timescaledb_catalog.hypertable h
-        WHERE (drop_chunks_impl.schema_name IS NULL OR h.schema_name = drop_chunks_impl.schema_name)
-        AND drop_chunks_impl.table_name = h.table_name
-        INTO STRICT exist_count;
-
-        IF exist_count = 0 THEN
-            RAISE 'hypertable % does not exist', drop_chunks_impl.table_name
-            USING ERRCODE = 'IO001';
-        END IF;
-    END IF;
+    RETURNS VOID AS '@MODULE_PATHNAME@', 'chunk_drop_chunks' LANGUAGE C VOLATILE;
 
-    FOR chunk_row IN SELECT *
-        FROM _timescaledb_catalog.chunk c
-        INNER JOIN _timescaledb_catalog.hypertable h ON (h.id = c.hypertable_id)
-        INNER JOIN _timescaledb_internal.dimension_get_time(h.id) time_dimension ON(true)
-        INNER JOIN _timescaledb_catalog.dimension_slice ds
-            ON (ds.dimension_id = time_dimension.id)
-        INNER JOIN _timescaledb_catalog.chunk_constraint cc
-            ON (cc.dimension_slice_id = ds.id AND cc.chunk_id = c.id)
-        WHERE (older_than_time IS NULL OR ds.range_end <= older_than_time)
-        AND (drop_chunks_impl.schema_name IS NULL OR h.schema_name = drop_chunks_impl.schema_name)
-        AND (drop_chunks_impl.table_name IS NULL OR h.table_name = drop_chunks_impl.table_name)
-    LOOP
-        IF truncate_before THEN
-            EXECUTE format(
-                $$
-                TRUNCATE %I.%I %s
-                $$, chunk_row.schema_name, chunk_row.table_name, cascade_mod
-            );
-        END IF;
-        EXECUTE format(
-                $$
-                DROP TABLE %I.%I %s
-                $$, chunk_row.schema_name, chunk_row.table_name, cascade_mod
-        );
-    END LOOP;
-END
-$BODY$;
+-- Truncate the main table of a hypertable if it holds no rows and can be
+-- locked without waiting. Returns true if it was truncated.
+CREATE OR REPLACE FUNCTION _timescaledb_internal.truncate_main_table_if_empty(
+    main_table  REGCLASS
+)
+    RETURNS BOOLEAN AS '@MODULE_PATHNAME@', 'hypertable_truncate_if_empty' LANGUAGE C VOLATILE STRICT;
 
 CREATE OR REPLACE FUNCTION _timescaledb_internal.drop_chunks_type_check(
     given_type REGTYPE,
@@ -118,3 +71,30 @@ AS '@MODULE_PATHNAME@', 'chunk_index_clone' LANGUAGE C VOLATILE STRICT;
 
 CREATE OR REPLACE FUNCTION _timescaledb_internal.chunk_index_replace(chunk_index_oid_old OID, chunk_index_oid_new OID) RETURNS VOID
 AS '@MODULE_PATHNAME@', 'chunk_index_replace' LANGUAGE C VOLATILE STRICT;
+
+-- Get the encoding of a column of a compressed chunk's batch
+CREATE OR REPLACE FUNCTION _timescaledb_internal.compressed_column_algorithm(compressed BYTEA) RETURNS TEXT
+AS '@MODULE_PATHNAME@', 'compression_algorithm_name' LANGUAGE C IMMUTABLE STRICT;
+
+-- Continuous aggregates, see continuous_agg.c
+CREATE OR REPLACE FUNCTION _timescaledb_internal.continuous_agg_view_bucket(
+    view                REGCLASS,
+    OUT raw_hypertable_id INTEGER,
+    OUT bucket_column   NAME,
+    OUT bucket_width    BIGINT
+) AS '@MODULE_PATHNAME@', 'continuous_agg_view_bucket' LANGUAGE C STABLE STRICT;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.continuous_agg_register(
+    user_view           REGCLASS,
+    partial_view        REGCLASS,
+    mat_hypertable      REGCLASS
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'continuous_agg_register' LANGUAGE C VOLATILE STRICT;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.continuous_agg_take_invalidation(
+    mat_hypertable_id   INTEGER,
+    OUT lowest          BIGINT,
+    OUT greatest        BIGINT
+) AS '@MODULE_PATHNAME@', 'continuous_agg_take_invalidation' LANGUAGE C VOLATILE STRICT;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.continuous_agg_invalidation_trigger() RETURNS TRIGGER
+AS '@MODULE_PATHNAME@', 'continuous_agg_invalidation_trigger' LANGUAGE C;
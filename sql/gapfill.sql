@@ -0,0 +1,43 @@
+-- time_bucket_gapfill buckets like time_bucket, and in addition marks the
+-- grouping column of a query whose missing buckets between start and finish
+-- are filled in. Start is inclusive and finish is exclusive. The functions
+-- are not strict so that the gap filling node can report NULL arguments.
+CREATE OR REPLACE FUNCTION time_bucket_gapfill(bucket_width INTERVAL, ts TIMESTAMP, start TIMESTAMP, finish TIMESTAMP)
+    RETURNS TIMESTAMP AS '@MODULE_PATHNAME@', 'gapfill_timestamp_bucket' LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION time_bucket_gapfill(bucket_width INTERVAL, ts TIMESTAMPTZ, start TIMESTAMPTZ, finish TIMESTAMPTZ)
+    RETURNS TIMESTAMPTZ AS '@MODULE_PATHNAME@', 'gapfill_timestamptz_bucket' LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION time_bucket_gapfill(bucket_width INTERVAL, ts DATE, start DATE, finish DATE)
+    RETURNS DATE AS '@MODULE_PATHNAME@', 'gapfill_date_bucket' LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION time_bucket_gapfill(bucket_width BIGINT, ts BIGINT, start BIGINT, finish BIGINT)
+    RETURNS BIGINT AS '@MODULE_PATHNAME@', 'gapfill_int64_bucket' LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION time_bucket_gapfill(bucket_width INT, ts INT, start INT, finish INT)
+    RETURNS INT AS '@MODULE_PATHNAME@', 'gapfill_int32_bucket' LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION time_bucket_gapfill(bucket_width SMALLINT, ts SMALLINT, start SMALLINT, finish SMALLINT)
+    RETURNS SMALLINT AS '@MODULE_PATHNAME@', 'gapfill_int16_bucket' LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- locf and interpolate return their argument. In the select list of a gap
+-- filled query, they set the value of the column in the filled rows to the
+-- last value of the group, or to a linear interpolation between the values
+-- of the neighboring rows of the group.
+CREATE OR REPLACE FUNCTION locf(value ANYELEMENT) RETURNS ANYELEMENT
+    AS '@MODULE_PATHNAME@', 'gapfill_marker' LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION interpolate(value SMALLINT) RETURNS SMALLINT
+    AS '@MODULE_PATHNAME@', 'gapfill_marker' LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION interpolate(value INT) RETURNS INT
+    AS '@MODULE_PATHNAME@', 'gapfill_marker' LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION interpolate(value BIGINT) RETURNS BIGINT
+    AS '@MODULE_PATHNAME@', 'gapfill_marker' LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION interpolate(value REAL) RETURNS REAL
+    AS '@MODULE_PATHNAME@', 'gapfill_marker' LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION interpolate(value FLOAT) RETURNS FLOAT
+    AS '@MODULE_PATHNAME@', 'gapfill_marker' LANGUAGE C IMMUTABLE PARALLEL SAFE;
@@ -35,3 +35,41 @@ CREATE AGGREGATE histogram (DOUBLE PRECISION, DOUBLE PRECISION, DOUBLE PRECISION
     FINALFUNC = _timescaledb_internal.hist_finalfunc,
     FINALFUNC_EXTRA
 );
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.approx_percentile_sfunc(state INTERNAL, val DOUBLE PRECISION, percentile DOUBLE PRECISION)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'approx_percentile_sfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.approx_percentile_combinefunc(state1 INTERNAL, state2 INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'approx_percentile_combinefunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.approx_percentile_serializefunc(INTERNAL)
+RETURNS bytea
+AS '@MODULE_PATHNAME@', 'approx_percentile_serializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.approx_percentile_deserializefunc(bytea, INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'approx_percentile_deserializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.approx_percentile_finalfunc(state INTERNAL, val DOUBLE PRECISION, percentile DOUBLE PRECISION)
+RETURNS DOUBLE PRECISION
+AS '@MODULE_PATHNAME@', 'approx_percentile_finalfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- An approximate percentile with a relative error of at most 1%, in bounded memory
+DROP AGGREGATE IF EXISTS approx_percentile (DOUBLE PRECISION, DOUBLE PRECISION);
+CREATE AGGREGATE approx_percentile (DOUBLE PRECISION, DOUBLE PRECISION) (
+    SFUNC = _timescaledb_internal.approx_percentile_sfunc,
+    STYPE = INTERNAL,
+    COMBINEFUNC = _timescaledb_internal.approx_percentile_combinefunc,
+    SERIALFUNC = _timescaledb_internal.approx_percentile_serializefunc,
+    DESERIALFUNC = _timescaledb_internal.approx_percentile_deserializefunc,
+    PARALLEL = SAFE,
+    FINALFUNC = _timescaledb_internal.approx_percentile_finalfunc,
+    FINALFUNC_EXTRA
+);
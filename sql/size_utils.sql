@@ -1,5 +1,38 @@
 -- This file contains utility functions to get the relation size
 -- of hypertables, chunks, and indexes on hypertables.
+--
+-- The sizes are calculated in C from the chunks in the catalog, which
+-- avoids joining pg_class and calling pg_total_relation_size() for each chunk.
+
+-- Get the sizes of each chunk of a hypertable, like pg_total_relation_size()
+-- and its parts
+CREATE OR REPLACE FUNCTION _timescaledb_internal.chunk_sizes(
+    main_table              REGCLASS
+)
+RETURNS TABLE (chunk_id INTEGER,
+               table_bytes BIGINT,
+               index_bytes BIGINT,
+               toast_bytes BIGINT,
+               total_bytes BIGINT)
+AS '@MODULE_PATHNAME@', 'hypertable_chunk_sizes' LANGUAGE C STABLE STRICT;
+
+-- Get the sizes of the indexes of a hypertable, summed across chunks
+CREATE OR REPLACE FUNCTION _timescaledb_internal.index_sizes(
+    main_table              REGCLASS
+)
+RETURNS TABLE (index_name TEXT,
+               total_bytes BIGINT)
+AS '@MODULE_PATHNAME@', 'hypertable_index_sizes' LANGUAGE C STABLE STRICT;
+
+-- Get the approximate number of rows in a hypertable, from the row estimates
+-- of its chunks as of their last VACUUM or ANALYZE. This is much cheaper than
+-- count(*) on large hypertables.
+--
+-- main_table - hypertable to get the row count of
+CREATE OR REPLACE FUNCTION hypertable_approximate_row_count(
+    main_table              REGCLASS
+)
+RETURNS BIGINT AS '@MODULE_PATHNAME@', 'hypertable_approximate_row_count' LANGUAGE C STABLE STRICT;
 
 -- Get relation size of hypertable
 -- like pg_relation_size(hypertable)
@@ -20,49 +53,14 @@ RETURNS TABLE (table_bytes BIGINT,
                index_bytes BIGINT,
                toast_bytes BIGINT,
                total_bytes BIGINT
-               ) LANGUAGE PLPGSQL STABLE
+               ) LANGUAGE SQL STABLE
                AS
 $BODY$
-DECLARE
-        table_name       NAME;
-        schema_name      NAME;
-BEGIN
-        SELECT relname, nspname
-        INTO STRICT table_name, schema_name
-        FROM pg_class c
-        INNER JOIN pg_namespace n ON (n.OID = c.relnamespace)
-        WHERE c.OID = main_table;
-
-        RETURN QUERY EXECUTE format(
-        $$
-        SELECT table_bytes,
-               index_bytes,
-               toast_bytes,
-               total_bytes
-               FROM (
-               SELECT *, total_bytes-index_bytes-COALESCE(toast_bytes,0) AS table_bytes FROM (
-                      SELECT
-                      sum(pg_total_relation_size('"' || c.schema_name || '"."' || c.table_name || '"'))::bigint as total_bytes,
-                      sum(pg_indexes_size('"' || c.schema_name || '"."' || c.table_name || '"'))::bigint AS index_bytes,
-                      sum(pg_total_relation_size(reltoastrelid))::bigint AS toast_bytes
-                      FROM
-                      _timescaledb_catalog.hypertable h,
-                      _timescaledb_catalog.chunk c,
-                      pg_class pgc,
-                      pg_namespace pns
-                      WHERE h.schema_name = %L
-                      AND h.table_name = %L
-                      AND c.hypertable_id = h.id
-                      AND pgc.relname = h.table_name
-                      AND pns.oid = pgc.relnamespace
-                      AND pns.nspname = h.schema_name
-                      AND relkind = 'r'
-                      ) sub1
-               ) sub2;
-        $$,
-        schema_name, table_name);
-
-END;
+        SELECT (sum(s.total_bytes) - sum(s.index_bytes) - COALESCE(sum(s.toast_bytes), 0))::bigint,
+               sum(s.index_bytes)::bigint,
+               sum(s.toast_bytes)::bigint,
+               sum(s.total_bytes)::bigint
+        FROM _timescaledb_internal.chunk_sizes(main_table) s;
 $BODY$;
 
 CREATE OR REPLACE FUNCTION _timescaledb_internal.range_value_to_pretty(
@@ -178,70 +176,26 @@ RETURNS TABLE (chunk_id INT,
                index_bytes BIGINT,
                toast_bytes BIGINT,
                total_bytes BIGINT)
-               LANGUAGE PLPGSQL STABLE
+               LANGUAGE SQL STABLE
                AS
 $BODY$
-DECLARE
-        table_name       NAME;
-        schema_name      NAME;
-BEGIN
-        SELECT relname, nspname
-        INTO STRICT table_name, schema_name
-        FROM pg_class c
-        INNER JOIN pg_namespace n ON (n.OID = c.relnamespace)
-        WHERE c.OID = main_table;
-
-        RETURN QUERY EXECUTE format(
-        $$
-
-        SELECT chunk_id,
-        chunk_table,
-        partitioning_columns,
-        partitioning_column_types,
-        partitioning_hash_functions,
-        ranges,
-        table_bytes,
-        index_bytes,
-        toast_bytes,
-        total_bytes
-        FROM (
-        SELECT *,
-              total_bytes-index_bytes-COALESCE(toast_bytes,0) AS table_bytes
-              FROM (
-               SELECT c.id as chunk_id,
-               '"' || c.schema_name || '"."' || c.table_name || '"' as chunk_table,
-               pg_total_relation_size('"' || c.schema_name || '"."' || c.table_name || '"') AS total_bytes,
-               pg_indexes_size('"' || c.schema_name || '"."' || c.table_name || '"') AS index_bytes,
-               pg_total_relation_size(reltoastrelid) AS toast_bytes,
-               array_agg(d.column_name ORDER BY d.interval_length, d.column_name ASC) as partitioning_columns,
-               array_agg(d.column_type ORDER BY d.interval_length, d.column_name ASC) as partitioning_column_types,
-               array_agg(d.partitioning_func_schema || '.' || d.partitioning_func ORDER BY d.interval_length, d.column_name ASC) as partitioning_hash_functions,
-               array_agg(int8range(range_start, range_end) ORDER BY d.interval_length, d.column_name ASC) as ranges
-               FROM
-               _timescaledb_catalog.hypertable h,
-               _timescaledb_catalog.chunk c,
-               _timescaledb_catalog.chunk_constraint cc,
-               _timescaledb_catalog.dimension d,
-               _timescaledb_catalog.dimension_slice ds,
-               pg_class pgc,
-               pg_namespace pns
-               WHERE h.schema_name = %L
-                     AND h.table_name = %L
-                     AND pgc.relname = h.table_name
-                     AND pns.oid = pgc.relnamespace
-                     AND pns.nspname = h.schema_name
-                     AND relkind = 'r'
-                     AND c.hypertable_id = h.id
-                     AND c.id = cc.chunk_id
-                     AND cc.dimension_slice_id = ds.id
-                     AND ds.dimension_id = d.id
-               GROUP BY c.id, pgc.reltoastrelid, pgc.oid ORDER BY c.id
-               ) sub1
-        ) sub2;
-        $$,
-        schema_name, table_name);
-
-END;
+        SELECT c.id,
+               '"' || c.schema_name || '"."' || c.table_name || '"',
+               array_agg(d.column_name ORDER BY d.interval_length, d.column_name ASC),
+               array_agg(d.column_type ORDER BY d.interval_length, d.column_name ASC),
+               array_agg(d.partitioning_func_schema || '.' || d.partitioning_func ORDER BY d.interval_length, d.column_name ASC),
+               array_agg(int8range(ds.range_start, ds.range_end) ORDER BY d.interval_length, d.column_name ASC),
+               s.table_bytes,
+               s.index_bytes,
+               s.toast_bytes,
+               s.total_bytes
+        FROM _timescaledb_internal.chunk_sizes(main_table) s
+        INNER JOIN _timescaledb_catalog.chunk c ON (c.id = s.chunk_id)
+        INNER JOIN _timescaledb_catalog.chunk_constraint cc ON (cc.chunk_id = c.id)
+        INNER JOIN _timescaledb_catalog.dimension_slice ds ON (ds.id = cc.dimension_slice_id)
+        INNER JOIN _timescaledb_catalog.dimension d ON (d.id = ds.dimension_id)
+        GROUP BY c.id, s.table_bytes, s.index_bytes, s.toast_bytes, s.total_bytes
+        ORDER BY c.id;
 $BODY$;
 
 -- Get relation size of the chunks of an hypertable
@@ -277,72 +231,28 @@ RETURNS TABLE (chunk_id INT,
                toast_size  TEXT,
                total_size  TEXT
                )
-               LANGUAGE PLPGSQL STABLE
+               LANGUAGE SQL STABLE
                AS
 $BODY$
-DECLARE
-        table_name       NAME;
-        schema_name      NAME;
-BEGIN
-        SELECT relname, nspname
-        INTO STRICT table_name, schema_name
-        FROM pg_class c
-        INNER JOIN pg_namespace n ON (n.OID = c.relnamespace)
-        WHERE c.OID = main_table;
-
-        RETURN QUERY EXECUTE format(
-        $$
-
-        SELECT chunk_id,
-        chunk_table,
-        partitioning_columns,
-        partitioning_column_types,
-        partitioning_functions,
-        ranges,
-        pg_size_pretty(table_bytes) AS table,
-        pg_size_pretty(index_bytes) AS index,
-        pg_size_pretty(toast_bytes) AS toast,
-        pg_size_pretty(total_bytes) AS total
-        FROM (
-        SELECT *,
-              total_bytes-index_bytes-COALESCE(toast_bytes,0) AS table_bytes
-              FROM (
-               SELECT c.id as chunk_id,
-               '"' || c.schema_name || '"."' || c.table_name || '"' as chunk_table,
-               pg_total_relation_size('"' || c.schema_name || '"."' || c.table_name || '"') AS total_bytes,
-               pg_indexes_size('"' || c.schema_name || '"."' || c.table_name || '"') AS index_bytes,
-               pg_total_relation_size(reltoastrelid) AS toast_bytes,
-               array_agg(d.column_name ORDER BY d.interval_length, d.column_name ASC) as partitioning_columns,
-               array_agg(d.column_type ORDER BY d.interval_length, d.column_name ASC) as partitioning_column_types,
-               array_agg(d.partitioning_func_schema || '.' || d.partitioning_func ORDER BY d.interval_length, d.column_name ASC) as partitioning_functions,
-               array_agg('[' || _timescaledb_internal.range_value_to_pretty(range_start, column_type) ||
+        SELECT c.id,
+               '"' || c.schema_name || '"."' || c.table_name || '"',
+               array_agg(d.column_name ORDER BY d.interval_length, d.column_name ASC),
+               array_agg(d.column_type ORDER BY d.interval_length, d.column_name ASC),
+               array_agg(d.partitioning_func_schema || '.' || d.partitioning_func ORDER BY d.interval_length, d.column_name ASC),
+               array_agg('[' || _timescaledb_internal.range_value_to_pretty(ds.range_start, d.column_type) ||
                          ',' ||
-                         _timescaledb_internal.range_value_to_pretty(range_end, column_type) || ')' ORDER BY d.interval_length, d.column_name ASC) as ranges
-               FROM
-               _timescaledb_catalog.hypertable h,
-               _timescaledb_catalog.chunk c,
-               _timescaledb_catalog.chunk_constraint cc,
-               _timescaledb_catalog.dimension d,
-               _timescaledb_catalog.dimension_slice ds,
-               pg_class pgc,
-               pg_namespace pns
-               WHERE h.schema_name = %L
-                     AND h.table_name = %L
-                     AND pgc.relname = h.table_name
-                     AND pns.oid = pgc.relnamespace
-                     AND pns.nspname = h.schema_name
-                     AND relkind = 'r'
-                     AND c.hypertable_id = h.id
-                     AND c.id = cc.chunk_id
-                     AND cc.dimension_slice_id = ds.id
-                     AND ds.dimension_id = d.id
-               GROUP BY c.id, pgc.reltoastrelid, pgc.oid ORDER BY c.id
-               ) sub1
-        ) sub2;
-        $$,
-        schema_name, table_name);
-
-END;
+                         _timescaledb_internal.range_value_to_pretty(ds.range_end, d.column_type) || ')' ORDER BY d.interval_length, d.column_name ASC),
+               pg_size_pretty(s.table_bytes),
+               pg_size_pretty(s.index_bytes),
+               pg_size_pretty(s.toast_bytes),
+               pg_size_pretty(s.total_bytes)
+        FROM _timescaledb_internal.chunk_sizes(main_table) s
+        INNER JOIN _timescaledb_catalog.chunk c ON (c.id = s.chunk_id)
+        INNER JOIN _timescaledb_catalog.chunk_constraint cc ON (cc.chunk_id = c.id)
+        INNER JOIN _timescaledb_catalog.dimension_slice ds ON (ds.id = cc.dimension_slice_id)
+        INNER JOIN _timescaledb_catalog.dimension d ON (d.id = ds.dimension_id)
+        GROUP BY c.id, s.table_bytes, s.index_bytes, s.toast_bytes, s.total_bytes
+        ORDER BY c.id;
 $BODY$;
 
 
@@ -359,38 +269,11 @@ CREATE OR REPLACE FUNCTION indexes_relation_size(
 )
 RETURNS TABLE (index_name TEXT,
                total_bytes BIGINT)
-               LANGUAGE PLPGSQL STABLE
+               LANGUAGE SQL STABLE
                AS
 $BODY$
-<<main>>
-DECLARE
-        table_name       NAME;
-        schema_name      NAME;
-BEGIN
-        SELECT relname, nspname
-        INTO STRICT table_name, schema_name
-        FROM pg_class c
-        INNER JOIN pg_namespace n ON (n.OID = c.relnamespace)
-        WHERE c.OID = main_table;
-
-        RETURN QUERY
-        SELECT h.schema_name || '.' || ci.hypertable_index_name,
-               sum(pg_relation_size(c.oid))::bigint
-        FROM
-        pg_class c,
-        pg_namespace n,
-        _timescaledb_catalog.hypertable h,
-        _timescaledb_catalog.chunk ch,
-        _timescaledb_catalog.chunk_index ci
-        WHERE ch.schema_name = n.nspname
-            AND c.relnamespace = n.oid
-            AND c.relname = ci.index_name
-            AND ch.id = ci.chunk_id
-            AND h.id = ci.hypertable_id
-            AND h.schema_name = main.schema_name
-            AND h.table_name = main.table_name
-        GROUP BY h.schema_name, ci.hypertable_index_name;
-END;
+        SELECT s.index_name, s.total_bytes
+        FROM _timescaledb_internal.index_sizes(main_table) s;
 $BODY$;
 
 
@@ -30,39 +30,30 @@ $BODY$
     SELECT (time_bucket(bucket_width, ts-"offset")+"offset")::date;
 $BODY$;
 
+-- Integer time is bucketed by truncating the quotient toward 0
+CREATE OR REPLACE FUNCTION time_bucket(bucket_width BIGINT, ts BIGINT) RETURNS BIGINT
+	AS '@MODULE_PATHNAME@', 'int64_bucket' LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
 
-CREATE OR REPLACE FUNCTION time_bucket(bucket_width BIGINT, ts BIGINT)
-    RETURNS BIGINT LANGUAGE SQL IMMUTABLE PARALLEL SAFE AS
-$BODY$
-    SELECT (ts / bucket_width)*bucket_width;
-$BODY$;
+CREATE OR REPLACE FUNCTION time_bucket(bucket_width INT, ts INT) RETURNS INT
+	AS '@MODULE_PATHNAME@', 'int32_bucket' LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
 
-CREATE OR REPLACE FUNCTION time_bucket(bucket_width INT, ts INT)
-    RETURNS INT LANGUAGE SQL IMMUTABLE PARALLEL SAFE AS
-$BODY$
-    SELECT (ts / bucket_width)*bucket_width;
-$BODY$;
-
-CREATE OR REPLACE FUNCTION time_bucket(bucket_width SMALLINT, ts SMALLINT)
-    RETURNS SMALLINT LANGUAGE SQL IMMUTABLE PARALLEL SAFE AS
-$BODY$
-    SELECT (ts / bucket_width)*bucket_width;
-$BODY$;
+CREATE OR REPLACE FUNCTION time_bucket(bucket_width SMALLINT, ts SMALLINT) RETURNS SMALLINT
+	AS '@MODULE_PATHNAME@', 'int16_bucket' LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
 
 CREATE OR REPLACE FUNCTION time_bucket(bucket_width BIGINT, ts BIGINT, "offset" BIGINT)
     RETURNS BIGINT LANGUAGE SQL IMMUTABLE PARALLEL SAFE AS
 $BODY$
-    SELECT (((ts-"offset") / bucket_width)*bucket_width)+"offset";
+    SELECT time_bucket(bucket_width, ts-"offset")+"offset";
 $BODY$;
 
 CREATE OR REPLACE FUNCTION time_bucket(bucket_width INT, ts INT, "offset" INT)
     RETURNS INT LANGUAGE SQL IMMUTABLE PARALLEL SAFE AS
 $BODY$
-    SELECT (((ts-"offset") / bucket_width)*bucket_width)+"offset";
+    SELECT time_bucket(bucket_width, ts-"offset")+"offset";
 $BODY$;
 
 CREATE OR REPLACE FUNCTION time_bucket(bucket_width SMALLINT, ts SMALLINT, "offset" SMALLINT)
     RETURNS SMALLINT LANGUAGE SQL IMMUTABLE PARALLEL SAFE AS
 $BODY$
-    SELECT (((ts-"offset") / bucket_width)*bucket_width)+"offset";
+    SELECT time_bucket(bucket_width, ts-"offset")+"offset";
 $BODY$;
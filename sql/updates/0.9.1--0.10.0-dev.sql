@@ -0,0 +1,203 @@
+DROP FUNCTION IF EXISTS create_hypertable(regclass,name,name,integer,name,name,anyelement,boolean,boolean,regproc,boolean);
+
+-- A background job is a policy that the job scheduler runs periodically
+-- on a hypertable. The policy's settings are stored in the policy table of
+-- the job's type. Failed runs are retried after 'retry_period', backing off
+-- exponentially up to the 'schedule_interval', and jobs that run longer than
+-- 'max_runtime' (if non-zero) are canceled.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.bgw_job (
+    id                  SERIAL      NOT NULL PRIMARY KEY,
+    job_type            NAME        NOT NULL CHECK (job_type IN ('drop_chunks', 'create_chunks_ahead', 'reorder', 'move_chunks', 'cold_index')),
+    hypertable_id       INTEGER     NOT NULL REFERENCES _timescaledb_catalog.hypertable(id) ON DELETE CASCADE,
+    schedule_interval   INTERVAL    NOT NULL CHECK (schedule_interval > INTERVAL '0'),
+    max_runtime         INTERVAL    NOT NULL CHECK (max_runtime >= INTERVAL '0'),
+    max_retries         INTEGER     NOT NULL CHECK (max_retries >= -1),
+    retry_period        INTERVAL    NOT NULL CHECK (retry_period > INTERVAL '0'),
+    UNIQUE (hypertable_id, job_type)
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.bgw_job', '');
+SELECT pg_catalog.pg_extension_config_dump(pg_get_serial_sequence('_timescaledb_catalog.bgw_job','id'), '');
+
+-- Run statistics and the next start time of each background job. This is
+-- runtime state that the scheduler recreates, so it is not dumped.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.bgw_job_stat (
+    job_id                  INTEGER     NOT NULL PRIMARY KEY REFERENCES _timescaledb_catalog.bgw_job(id) ON DELETE CASCADE,
+    last_start              TIMESTAMPTZ NOT NULL,
+    last_finish             TIMESTAMPTZ NOT NULL,
+    next_start              TIMESTAMPTZ NOT NULL,
+    last_run_success        BOOLEAN     NOT NULL,
+    total_runs              BIGINT      NOT NULL,
+    total_failures          BIGINT      NOT NULL,
+    consecutive_failures    INTEGER     NOT NULL
+);
+
+-- Retention policy: drop the chunks of the job's hypertable that are older
+-- than 'older_than'.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.bgw_policy_drop_chunks (
+    job_id      INTEGER     NOT NULL PRIMARY KEY REFERENCES _timescaledb_catalog.bgw_job(id) ON DELETE CASCADE,
+    older_than  INTERVAL    NOT NULL CHECK (older_than > INTERVAL '0'),
+    "cascade"   BOOLEAN     NOT NULL
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.bgw_policy_drop_chunks', '');
+
+-- Chunk pre-creation policy: create the chunks for the current time interval
+-- and the 'num_intervals' following ones.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.bgw_policy_create_chunks_ahead (
+    job_id          INTEGER     NOT NULL PRIMARY KEY REFERENCES _timescaledb_catalog.bgw_job(id) ON DELETE CASCADE,
+    num_intervals   INTEGER     NOT NULL CHECK (num_intervals >= 0)
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.bgw_policy_create_chunks_ahead', '');
+
+-- Reorder policy: rewrite the chunks of the job's hypertable that end more
+-- than 'older_than' ago in the order of the chunks' copy of the hypertable
+-- index 'hypertable_index_name'.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.bgw_policy_reorder (
+    job_id                  INTEGER     NOT NULL PRIMARY KEY REFERENCES _timescaledb_catalog.bgw_job(id) ON DELETE CASCADE,
+    hypertable_index_name   NAME        NOT NULL,
+    older_than              INTERVAL    NOT NULL CHECK (older_than >= INTERVAL '0')
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.bgw_policy_reorder', '');
+
+-- Compressed chunks: the rows of chunk 'chunk_id' are stored in compressed
+-- batches in the table 'schema_name.table_name'. The rows of a batch have the
+-- same value of the chunk's column 'segment_by', if there is one.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.compressed_chunk (
+    chunk_id        INTEGER     NOT NULL PRIMARY KEY REFERENCES _timescaledb_catalog.chunk(id) ON DELETE CASCADE,
+    hypertable_id   INTEGER     NOT NULL REFERENCES _timescaledb_catalog.hypertable(id) ON DELETE CASCADE,
+    schema_name     NAME        NOT NULL,
+    table_name      NAME        NOT NULL,
+    num_rows        BIGINT      NOT NULL CHECK (num_rows >= 0),
+    segment_by      NAME        NULL,
+    UNIQUE (schema_name, table_name)
+);
+CREATE INDEX IF NOT EXISTS compressed_chunk_hypertable_id_idx
+ON _timescaledb_catalog.compressed_chunk(hypertable_id);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.compressed_chunk', '');
+
+-- Move chunks policy: move the chunks of the job's hypertable that end more
+-- than 'older_than' ago to the tablespace 'tablespace_name', and their indexes
+-- to the tablespace 'index_tablespace_name'. Both tablespaces are attached to
+-- the hypertable.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.bgw_policy_move_chunks (
+    job_id                  INTEGER     NOT NULL PRIMARY KEY REFERENCES _timescaledb_catalog.bgw_job(id) ON DELETE CASCADE,
+    older_than              INTERVAL    NOT NULL CHECK (older_than >= INTERVAL '0'),
+    tablespace_name         NAME        NOT NULL,
+    index_tablespace_name   NAME        NOT NULL
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.bgw_policy_move_chunks', '');
+
+-- Cold index policy: rebuild the chunks' copy of the hypertable index
+-- 'hypertable_index_name' with the index access method 'access_method', e.g.,
+-- BRIN, for the chunks of the job's hypertable that end more than
+-- 'older_than' ago.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.bgw_policy_cold_index (
+    job_id                  INTEGER     NOT NULL PRIMARY KEY REFERENCES _timescaledb_catalog.bgw_job(id) ON DELETE CASCADE,
+    hypertable_index_name   NAME        NOT NULL,
+    older_than              INTERVAL    NOT NULL CHECK (older_than >= INTERVAL '0'),
+    access_method           NAME        NOT NULL
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.bgw_policy_cold_index', '');
+
+-- Adaptive chunking: size the chunks of the hypertable's first open
+-- dimension so that each chunk is about 'target_size' bytes on disk,
+-- including its indexes. The interval of the dimension is recalculated from
+-- the sizes of the preceding chunks whenever a new chunk is created.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.chunk_sizing (
+    hypertable_id   INTEGER     NOT NULL PRIMARY KEY REFERENCES _timescaledb_catalog.hypertable(id) ON DELETE CASCADE,
+    target_size     BIGINT      NOT NULL CHECK (target_size > 0)
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.chunk_sizing', '');
+
+-- Continuous aggregates: the time_bucket() aggregation of the view
+-- 'partial_view_schema.partial_view_name' over the raw hypertable is
+-- materialized into the hypertable 'mat_hypertable_id', which the user view
+-- 'user_view_schema.user_view_name' reads. 'bucket_width' is the width of the
+-- buckets in the internal time units of the raw hypertable.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.continuous_agg (
+    mat_hypertable_id   INTEGER     NOT NULL PRIMARY KEY REFERENCES _timescaledb_catalog.hypertable(id) ON DELETE CASCADE,
+    raw_hypertable_id   INTEGER     NOT NULL REFERENCES _timescaledb_catalog.hypertable(id) ON DELETE CASCADE,
+    user_view_schema    NAME        NOT NULL,
+    user_view_name      NAME        NOT NULL,
+    partial_view_schema NAME        NOT NULL,
+    partial_view_name   NAME        NOT NULL,
+    bucket_width        BIGINT      NOT NULL CHECK (bucket_width > 0),
+    UNIQUE (user_view_schema, user_view_name)
+);
+CREATE INDEX IF NOT EXISTS continuous_agg_raw_hypertable_id_idx
+ON _timescaledb_catalog.continuous_agg(raw_hypertable_id);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.continuous_agg', '');
+
+-- Ranges of time, in internal time units, that were modified since the
+-- continuous aggregates were last refreshed. Modifications of a raw
+-- hypertable are logged under the raw hypertable, and are copied to each of
+-- its continuous aggregates, under the materialization hypertable, when any
+-- of them is refreshed.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.continuous_aggs_invalidation_log (
+    hypertable_id           INTEGER     NOT NULL REFERENCES _timescaledb_catalog.hypertable(id) ON DELETE CASCADE,
+    lowest_modified_value   BIGINT      NOT NULL,
+    greatest_modified_value BIGINT      NOT NULL,
+    CHECK (lowest_modified_value <= greatest_modified_value)
+);
+CREATE INDEX IF NOT EXISTS continuous_aggs_invalidation_log_hypertable_id_idx
+ON _timescaledb_catalog.continuous_aggs_invalidation_log(hypertable_id);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.continuous_aggs_invalidation_log', '');
+
+-- The actual range of time, in internal time units, of the rows in a chunk,
+-- which can be narrower than the chunk's time slice. The range is only
+-- widened as rows are inserted, so it can be wider than the rows that are
+-- left. An empty chunk has min_value > max_value. Chunks without a row here
+-- have an unknown range.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.chunk_time_range (
+    chunk_id    INTEGER     NOT NULL PRIMARY KEY REFERENCES _timescaledb_catalog.chunk(id) ON DELETE CASCADE,
+    min_value   BIGINT      NOT NULL,
+    max_value   BIGINT      NOT NULL
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.chunk_time_range', '');
+
+-- Columns of a hypertable, e.g., request or trace IDs, whose values each
+-- chunk keeps a bloom filter of, so that lookups of a value can skip the
+-- chunks that cannot contain it.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.hypertable_bloom_column (
+    hypertable_id   INTEGER     NOT NULL REFERENCES _timescaledb_catalog.hypertable(id) ON DELETE CASCADE,
+    column_name     NAME        NOT NULL,
+    PRIMARY KEY (hypertable_id, column_name)
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.hypertable_bloom_column', '');
+
+-- The bloom filter of the values of a column in a chunk: a bit array with
+-- num_hashes bits set for each value, using the hash function of the column
+-- type's default hash operator class. Filters are built when a chunk is
+-- reordered or by build_bloom_filters(), and removed when rows are written
+-- to the chunk. Chunks without a row here have no filter for the column.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.chunk_bloom_filter (
+    chunk_id        INTEGER     NOT NULL REFERENCES _timescaledb_catalog.chunk(id) ON DELETE CASCADE,
+    column_name     NAME        NOT NULL,
+    num_hashes      INTEGER     NOT NULL CHECK (num_hashes > 0),
+    filter          BYTEA       NOT NULL,
+    PRIMARY KEY (chunk_id, column_name)
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.chunk_bloom_filter', '');
+
+-- The hypertable_data_node table maps data nodes to hypertables. A data node
+-- is a postgres_fdw foreign server, and new chunks of the hypertable are
+-- created as foreign tables on one of its data nodes, chosen by the chunk's
+-- closed (space) dimension slice. Each chunk reads and writes the hypertable
+-- with the same name on its data node.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.hypertable_data_node (
+    hypertable_id   INTEGER     NOT NULL REFERENCES _timescaledb_catalog.hypertable(id) ON DELETE CASCADE,
+    node_name       NAME        NOT NULL,
+    PRIMARY KEY (hypertable_id, node_name)
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.hypertable_data_node', '');
+
+GRANT SELECT ON _timescaledb_catalog.bgw_job, _timescaledb_catalog.bgw_job_stat,
+    _timescaledb_catalog.bgw_policy_drop_chunks, _timescaledb_catalog.bgw_policy_create_chunks_ahead,
+    _timescaledb_catalog.bgw_policy_reorder, _timescaledb_catalog.compressed_chunk,
+    _timescaledb_catalog.bgw_policy_move_chunks, _timescaledb_catalog.chunk_sizing,
+    _timescaledb_catalog.continuous_agg, _timescaledb_catalog.continuous_aggs_invalidation_log,
+    _timescaledb_catalog.chunk_time_range, _timescaledb_catalog.hypertable_bloom_column,
+    _timescaledb_catalog.chunk_bloom_filter, _timescaledb_catalog.bgw_policy_cold_index,
+    _timescaledb_catalog.hypertable_data_node TO PUBLIC;
+
+CREATE SCHEMA IF NOT EXISTS timescaledb_information;
+GRANT USAGE ON SCHEMA timescaledb_information TO PUBLIC;
@@ -0,0 +1,51 @@
+-- Cumulative ingest and chunk-lifecycle statistics of each hypertable,
+-- summed over all backends since the server started or the statistics were
+-- last reset. Only available when timescaledb is in shared_preload_libraries.
+CREATE OR REPLACE FUNCTION _timescaledb_internal.hypertable_stats()
+    RETURNS TABLE(hypertable_id INTEGER, rows_inserted BIGINT, rows_copied BIGINT,
+                  chunks_created BIGINT, chunk_create_time DOUBLE PRECISION,
+                  chunk_find_scans BIGINT, cache_evictions BIGINT, tuples_converted BIGINT)
+    AS '@MODULE_PATHNAME@', 'hypertable_stats' LANGUAGE C VOLATILE STRICT;
+
+-- Reset the statistics of all hypertables in the current database
+CREATE OR REPLACE FUNCTION _timescaledb_internal.hypertable_stats_reset()
+    RETURNS VOID
+    AS '@MODULE_PATHNAME@', 'hypertable_stats_reset' LANGUAGE C VOLATILE STRICT;
+
+REVOKE EXECUTE ON FUNCTION _timescaledb_internal.hypertable_stats_reset() FROM PUBLIC;
+
+-- chunk_create_time is in milliseconds and includes waiting for the lock on
+-- the hypertable. Hypertables created since the last reset that have not
+-- been inserted into have no row.
+CREATE OR REPLACE VIEW timescaledb_information.hypertable_stats AS
+SELECT ht.schema_name AS hypertable_schema,
+       ht.table_name AS hypertable_name,
+       s.rows_inserted,
+       s.rows_copied,
+       s.chunks_created,
+       s.chunk_create_time,
+       s.chunk_find_scans,
+       s.cache_evictions,
+       s.tuples_converted
+FROM _timescaledb_catalog.hypertable ht
+INNER JOIN _timescaledb_internal.hypertable_stats() s ON (s.hypertable_id = ht.id);
+
+GRANT SELECT ON timescaledb_information.hypertable_stats TO PUBLIC;
+
+-- Time the current backend has spent in metadata operations that can stall
+-- inserts: catalog scans, per catalog table, chunk creation, chunk index
+-- builds and hypertable cache rebuilds. Times are in milliseconds.
+CREATE OR REPLACE FUNCTION _timescaledb_internal.timing_stats()
+    RETURNS TABLE(operation TEXT, relation REGCLASS, calls BIGINT,
+                  total_time DOUBLE PRECISION, max_time DOUBLE PRECISION)
+    AS '@MODULE_PATHNAME@', 'timing_stats' LANGUAGE C VOLATILE STRICT;
+
+-- The metadata operation a backend is in, if any. PostgreSQL shows these as
+-- the "Extension" wait event in pg_stat_activity, e.g.:
+--
+-- SELECT pid, wait_event_type, wait_event,
+--        _timescaledb_internal.backend_wait_event(pid)
+-- FROM pg_stat_activity;
+CREATE OR REPLACE FUNCTION _timescaledb_internal.backend_wait_event(pid INTEGER)
+    RETURNS TEXT
+    AS '@MODULE_PATHNAME@', 'backend_wait_event' LANGUAGE C VOLATILE STRICT;
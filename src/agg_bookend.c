@@ -2,8 +2,12 @@
 #include <fmgr.h>
 #include <catalog/namespace.h>
 #include <nodes/value.h>
+#include <catalog/pg_type.h>
+#include <utils/builtins.h>
+#include <utils/date.h>
 #include <utils/lsyscache.h>
 #include <utils/datum.h>
+#include <utils/timestamp.h>
 #include <lib/stringinfo.h>
 #include <libpq/pqformat.h>
 
@@ -181,11 +185,24 @@ polydatum_deserialize(PolyDatum *result, StringInfo buf, PolyDatumIOState *state
 	return result;
 }
 
+/*
+ * Memory that holds the copy of a by-reference datum in the aggregate state.
+ * It is reused by later copies that fit, so that replacing the state does not
+ * allocate on every row when the input is ordered on the comparison element.
+ */
+typedef struct PolyDatumBuffer
+{
+	Pointer		data;
+	Size		size;			/* usable size of data, 0 if it cannot be reused */
+} PolyDatumBuffer;
+
 /* Internal state for bookend aggregates */
 typedef struct InternalCmpAggStore
 {
 	PolyDatum	value;
 	PolyDatum	cmp;			/* the comparison element. e.g. time */
+	PolyDatumBuffer value_buf;
+	PolyDatumBuffer cmp_buf;
 } InternalCmpAggStore;
 
 /* State used to cache data for serialize/deserialize operations */
@@ -208,25 +225,149 @@ typeinfocache_init(TypeInfoCache *tic)
 	tic->type = InvalidOid;
 }
 
+/*
+ * Copy a datum into the aggregate state, in the current memory context.
+ * By-reference datums are copied into the state's buffer if they fit. The
+ * previous datum of the state is overwritten, which is safe since the
+ * aggregate's result is copied out of the state when it is returned.
+ */
 inline static void
-typeinfocache_polydatumcopy(TypeInfoCache *tic, PolyDatum input, PolyDatum *output)
+typeinfocache_polydatumcopy(TypeInfoCache *tic, PolyDatum input, PolyDatum *output, PolyDatumBuffer *buf)
 {
+	Size		size;
+
 	if (tic->type != input.type)
 	{
 		tic->type = input.type;
 		get_typlenbyval(tic->type, &tic->typelen, &tic->typebyval);
 	}
 	*output = input;
-	if (!input.is_null)
-		output->datum = datumCopy(input.datum, tic->typebyval, tic->typelen);
-	else
+
+	if (input.is_null)
+	{
 		output->datum = PointerGetDatum(NULL);
+		return;
+	}
+
+	if (tic->typebyval)
+		return;
+
+	/* Expanded objects are flattened by datumCopy() */
+	if (tic->typelen == -1 && VARATT_IS_EXTERNAL_EXPANDED(DatumGetPointer(input.datum)))
+	{
+		output->datum = datumCopy(input.datum, tic->typebyval, tic->typelen);
+
+		if (NULL != buf->data)
+			pfree(buf->data);
+		buf->data = DatumGetPointer(output->datum);
+		buf->size = 0;
+		return;
+	}
+
+	size = datumGetSize(input.datum, tic->typebyval, tic->typelen);
+
+	if (size > buf->size)
+	{
+		if (NULL != buf->data)
+			pfree(buf->data);
+		buf->data = palloc(size);
+		buf->size = size;
+	}
+
+	memcpy(buf->data, DatumGetPointer(input.datum), size);
+	output->datum = PointerGetDatum(buf->data);
+}
+
+/*
+ * Comparison of the comparison element's value for common built-in types,
+ * which avoids a call through fmgr for every row. Returns less than, equal
+ * to, or greater than zero, like the types' btree comparison functions.
+ */
+typedef int (*CmpInternalFunc) (Datum left, Datum right);
+
+static int
+cmp_internal_int2(Datum left, Datum right)
+{
+	int16		l = DatumGetInt16(left);
+	int16		r = DatumGetInt16(right);
+
+	return (l > r) - (l < r);
+}
+
+static int
+cmp_internal_int4(Datum left, Datum right)
+{
+	int32		l = DatumGetInt32(left);
+	int32		r = DatumGetInt32(right);
+
+	return (l > r) - (l < r);
+}
+
+static int
+cmp_internal_int8(Datum left, Datum right)
+{
+	int64		l = DatumGetInt64(left);
+	int64		r = DatumGetInt64(right);
+
+	return (l > r) - (l < r);
+}
+
+static int
+cmp_internal_float8(Datum left, Datum right)
+{
+	return float8_cmp_internal(DatumGetFloat8(left), DatumGetFloat8(right));
+}
+
+static int
+cmp_internal_date(Datum left, Datum right)
+{
+	DateADT		l = DatumGetDateADT(left);
+	DateADT		r = DatumGetDateADT(right);
+
+	return (l > r) - (l < r);
+}
+
+static int
+cmp_internal_timestamp(Datum left, Datum right)
+{
+	return timestamp_cmp_internal(DatumGetTimestamp(left), DatumGetTimestamp(right));
+}
+
+static int
+cmp_internal_timestamptz(Datum left, Datum right)
+{
+	return timestamp_cmp_internal(DatumGetTimestampTz(left), DatumGetTimestampTz(right));
+}
+
+static CmpInternalFunc
+cmp_internal_for_type(Oid type)
+{
+	switch (type)
+	{
+		case INT2OID:
+			return cmp_internal_int2;
+		case INT4OID:
+			return cmp_internal_int4;
+		case INT8OID:
+			return cmp_internal_int8;
+		case FLOAT8OID:
+			return cmp_internal_float8;
+		case DATEOID:
+			return cmp_internal_date;
+		case TIMESTAMPOID:
+			return cmp_internal_timestamp;
+		case TIMESTAMPTZOID:
+			return cmp_internal_timestamptz;
+		default:
+			return NULL;
+	}
 }
 
 typedef struct CmpFuncCache
 {
 	Oid			cmp_type;
 	char		op;
+	CmpInternalFunc cmp_internal;	/* NULL if compared with the operator */
 	FmgrInfo	proc;
 } CmpFuncCache;
 
@@ -249,15 +390,32 @@ cmpfunccache_cmp(CmpFuncCache *cache, FunctionCallInfo fcinfo, char *opname, Pol
 
 		if (!OidIsValid(left.type))
 			elog(ERROR, "could not determine the type of the comparison_element");
-		cmp_op = OpernameGetOprid(list_make1(makeString(opname)), left.type, left.type);
-		if (!OidIsValid(cmp_op))
-			elog(ERROR, "could not find a %s operator for type %d", opname, left.type);
-		cmp_regproc = get_opcode(cmp_op);
-		if (!OidIsValid(cmp_regproc))
-			elog(ERROR, "could not find the procedure for the %s operator for type %d", opname, left.type);
-		fmgr_info_cxt(cmp_regproc, &cache->proc,
-					  fcinfo->flinfo->fn_mcxt);
+
+		cache->cmp_internal = cmp_internal_for_type(left.type);
+
+		if (NULL == cache->cmp_internal)
+		{
+			cmp_op = OpernameGetOprid(list_make1(makeString(opname)), left.type, left.type);
+			if (!OidIsValid(cmp_op))
+				elog(ERROR, "could not find a %s operator for type %d", opname, left.type);
+			cmp_regproc = get_opcode(cmp_op);
+			if (!OidIsValid(cmp_regproc))
+				elog(ERROR, "could not find the procedure for the %s operator for type %d", opname, left.type);
+			fmgr_info_cxt(cmp_regproc, &cache->proc,
+						  fcinfo->flinfo->fn_mcxt);
+		}
+
+		cache->cmp_type = left.type;
+		cache->op = opname[0];
+	}
+
+	if (NULL != cache->cmp_internal)
+	{
+		int			cmp = cache->cmp_internal(left.datum, right.datum);
+
+		return cache->op == '<' ? cmp < 0 : cmp > 0;
 	}
+
 	return DatumGetBool(FunctionCall2Coll(&cache->proc, fcinfo->fncollation, left.datum, right.datum));
 }
 
@@ -298,9 +456,9 @@ bookend_sfunc(MemoryContext aggcontext, InternalCmpAggStore *state, PolyDatum va
 
 	if (state == NULL)
 	{
-		state = (InternalCmpAggStore *) MemoryContextAlloc(aggcontext, sizeof(InternalCmpAggStore));
-		typeinfocache_polydatumcopy(&cache->value_type_cache, value, &state->value);
-		typeinfocache_polydatumcopy(&cache->cmp_type_cache, cmp, &state->cmp);
+		state = (InternalCmpAggStore *) MemoryContextAllocZero(aggcontext, sizeof(InternalCmpAggStore));
+		typeinfocache_polydatumcopy(&cache->value_type_cache, value, &state->value, &state->value_buf);
+		typeinfocache_polydatumcopy(&cache->cmp_type_cache, cmp, &state->cmp, &state->cmp_buf);
 	}
 	else
 	{
@@ -310,8 +468,8 @@ bookend_sfunc(MemoryContext aggcontext, InternalCmpAggStore *state, PolyDatum va
 		}
 		else if (cmpfunccache_cmp(&cache->cmp_func_cache, fcinfo, opname, cmp, state->cmp))
 		{
-			typeinfocache_polydatumcopy(&cache->value_type_cache, value, &state->value);
-			typeinfocache_polydatumcopy(&cache->cmp_type_cache, cmp, &state->cmp);
+			typeinfocache_polydatumcopy(&cache->value_type_cache, value, &state->value, &state->value_buf);
+			typeinfocache_polydatumcopy(&cache->cmp_type_cache, cmp, &state->cmp, &state->cmp_buf);
 		}
 	}
 	MemoryContextSwitchTo(old_context);
@@ -341,9 +499,9 @@ bookend_combinefunc(MemoryContext aggcontext, InternalCmpAggStore *state1, Inter
 	{
 		old_context = MemoryContextSwitchTo(aggcontext);
 
-		state1 = (InternalCmpAggStore *) MemoryContextAlloc(aggcontext, sizeof(InternalCmpAggStore));
-		typeinfocache_polydatumcopy(&cache->value_type_cache, state2->value, &state1->value);
-		typeinfocache_polydatumcopy(&cache->cmp_type_cache, state2->cmp, &state1->cmp);
+		state1 = (InternalCmpAggStore *) MemoryContextAllocZero(aggcontext, sizeof(InternalCmpAggStore));
+		typeinfocache_polydatumcopy(&cache->value_type_cache, state2->value, &state1->value, &state1->value_buf);
+		typeinfocache_polydatumcopy(&cache->cmp_type_cache, state2->cmp, &state1->cmp, &state1->cmp_buf);
 
 		MemoryContextSwitchTo(old_context);
 		PG_RETURN_POINTER(state1);
@@ -362,8 +520,8 @@ bookend_combinefunc(MemoryContext aggcontext, InternalCmpAggStore *state1, Inter
 	if (cmpfunccache_cmp(&cache->cmp_func_cache, fcinfo, opname, state2->cmp, state1->cmp))
 	{
 		old_context = MemoryContextSwitchTo(aggcontext);
-		typeinfocache_polydatumcopy(&cache->value_type_cache, state2->value, &state1->value);
-		typeinfocache_polydatumcopy(&cache->cmp_type_cache, state2->cmp, &state1->cmp);
+		typeinfocache_polydatumcopy(&cache->value_type_cache, state2->value, &state1->value, &state1->value_buf);
+		typeinfocache_polydatumcopy(&cache->cmp_type_cache, state2->cmp, &state1->cmp, &state1->cmp_buf);
 		MemoryContextSwitchTo(old_context);
 	}
 
@@ -492,7 +650,7 @@ bookend_deserializefunc(PG_FUNCTION_ARGS)
 		my_extra = (InternalCmpAggStoreIOState *) fcinfo->flinfo->fn_extra;
 	}
 
-	result = palloc(sizeof(InternalCmpAggStore));
+	result = palloc0(sizeof(InternalCmpAggStore));
 	polydatum_deserialize(&result->value, &buf, &my_extra->value, fcinfo);
 	polydatum_deserialize(&result->cmp, &buf, &my_extra->cmp, fcinfo);
 	PG_RETURN_POINTER(result);
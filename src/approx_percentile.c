@@ -0,0 +1,481 @@
+#include <postgres.h>
+#include <math.h>
+#include <fmgr.h>
+
+#include "compat.h"
+
+/* aggregate approx_percentile:
+ *	 approx_percentile(state, val, percentile) returns the approximate value at the percentile
+ *
+ * Usage:
+ *	 SELECT grouping_element, approx_percentile(field, 0.99) FROM table GROUP BY grouping_element.
+ *
+ * Description:
+ * The aggregate collects the values in a sketch of logarithmically sized
+ * buckets, like DDSketch: a positive value x falls into the bucket
+ * ceil(log(x) / log(gamma)), where gamma = (1 + a) / (1 - a) for the relative
+ * accuracy a. Any value in a bucket is at most a relative distance of a from
+ * the bucket's estimate, so the percentiles of the sketch have the same
+ * relative accuracy. Negative values are kept in a separate set of buckets by
+ * their magnitude, and zeros are counted on their own.
+ *
+ * Unlike percentile_cont(), which sorts all values, the sketch's memory is
+ * bounded: each set of buckets covers at most SKETCH_MAX_BUCKETS consecutive
+ * buckets. If the values span more than that, the buckets with the smallest
+ * magnitudes are merged, which keeps the accuracy for the upper percentiles.
+ * Sketches are merged by adding their buckets, so the aggregate can be
+ * computed in parallel and per chunk.
+ */
+
+TS_FUNCTION_INFO_V1(approx_percentile_sfunc);
+TS_FUNCTION_INFO_V1(approx_percentile_combinefunc);
+TS_FUNCTION_INFO_V1(approx_percentile_serializefunc);
+TS_FUNCTION_INFO_V1(approx_percentile_deserializefunc);
+TS_FUNCTION_INFO_V1(approx_percentile_finalfunc);
+
+#define SKETCH_RELATIVE_ACCURACY 0.01
+#define SKETCH_MAX_BUCKETS 2048
+#define SKETCH_INITIAL_BUCKETS 64
+
+/* A set of consecutive buckets, starting at the bucket with key "offset" */
+typedef struct SketchStore
+{
+	int32		offset;
+	int32		nbuckets;
+	int64	   *counts;
+} SketchStore;
+
+typedef struct Sketch
+{
+	double		percentile;
+	int64		count;			/* the number of values */
+	int64		zero_count;
+	double		min;
+	double		max;
+	SketchStore positive;
+	SketchStore negative;		/* negative values by their magnitude */
+} Sketch;
+
+/* The serialized sketch: the fixed fields followed by the counts of the stores */
+typedef struct SketchData
+{
+	double		percentile;
+	int64		count;
+	int64		zero_count;
+	double		min;
+	double		max;
+	int32		positive_offset;
+	int32		positive_nbuckets;
+	int32		negative_offset;
+	int32		negative_nbuckets;
+	int64		counts[FLEXIBLE_ARRAY_MEMBER];
+} SketchData;
+
+static inline double
+sketch_gamma(void)
+{
+	return (1.0 + SKETCH_RELATIVE_ACCURACY) / (1.0 - SKETCH_RELATIVE_ACCURACY);
+}
+
+/* Get the key of the bucket of a positive value */
+static inline int32
+sketch_key(double magnitude)
+{
+	return (int32) ceil(log(magnitude) / log(sketch_gamma()));
+}
+
+/* Get the estimate of a bucket, which is within the relative accuracy of all its values */
+static inline double
+sketch_value(int32 key)
+{
+	double		gamma = sketch_gamma();
+
+	return 2.0 * pow(gamma, key) / (1.0 + gamma);
+}
+
+/*
+ * Make the store cover the buckets lo to hi, in the current memory context.
+ * If the store would exceed the maximum number of buckets, the lowest buckets
+ * are merged into the lowest remaining one.
+ */
+static void
+sketch_store_extend(SketchStore *store, int32 lo, int32 hi)
+{
+	int64	   *counts;
+	int32		offset;
+	int32		nbuckets;
+	int32		i;
+
+	if (store->nbuckets > 0)
+	{
+		lo = Min(lo, store->offset);
+		hi = Max(hi, store->offset + store->nbuckets - 1);
+	}
+
+	if (hi - lo + 1 > SKETCH_MAX_BUCKETS)
+	{
+		nbuckets = SKETCH_MAX_BUCKETS;
+		offset = hi - SKETCH_MAX_BUCKETS + 1;
+	}
+	else
+	{
+		/* Leave room on both sides to grow without reallocating every time */
+		nbuckets = Max(hi - lo + 1, Max(store->nbuckets * 2, SKETCH_INITIAL_BUCKETS));
+		nbuckets = Min(nbuckets, SKETCH_MAX_BUCKETS);
+		offset = lo - (nbuckets - (hi - lo + 1)) / 2;
+	}
+
+	counts = palloc0(sizeof(int64) * nbuckets);
+
+	for (i = 0; i < store->nbuckets; i++)
+	{
+		int32		key = Max(store->offset + i, offset);
+
+		counts[key - offset] += store->counts[i];
+	}
+
+	if (NULL != store->counts)
+		pfree(store->counts);
+
+	store->counts = counts;
+	store->offset = offset;
+	store->nbuckets = nbuckets;
+}
+
+static inline void
+sketch_store_add(SketchStore *store, int32 key, int64 count)
+{
+	if (store->nbuckets == 0 || key < store->offset || key >= store->offset + store->nbuckets)
+		sketch_store_extend(store, key, key);
+
+	/* The bucket might have been merged into the lowest bucket */
+	if (key < store->offset)
+		key = store->offset;
+
+	store->counts[key - store->offset] += count;
+}
+
+static void
+sketch_store_merge(SketchStore *store, SketchStore *other)
+{
+	int32		i;
+
+	if (other->nbuckets == 0)
+		return;
+
+	sketch_store_extend(store, other->offset, other->offset + other->nbuckets - 1);
+
+	for (i = 0; i < other->nbuckets; i++)
+		if (other->counts[i] != 0)
+			sketch_store_add(store, other->offset + i, other->counts[i]);
+}
+
+static void
+sketch_check_percentile(double percentile)
+{
+	if (isnan(percentile) || percentile < 0.0 || percentile > 1.0)
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("percentile value %g is not between 0 and 1", percentile)));
+}
+
+static Sketch *
+sketch_create(MemoryContext aggcontext, double percentile)
+{
+	Sketch	   *sketch;
+
+	sketch_check_percentile(percentile);
+
+	sketch = MemoryContextAllocZero(aggcontext, sizeof(Sketch));
+	sketch->percentile = percentile;
+
+	return sketch;
+}
+
+static void
+sketch_add(Sketch *sketch, double val)
+{
+	if (sketch->count == 0 || val < sketch->min)
+		sketch->min = val;
+	if (sketch->count == 0 || val > sketch->max)
+		sketch->max = val;
+
+	sketch->count++;
+
+	if (val > 0.0)
+		sketch_store_add(&sketch->positive, sketch_key(val), 1);
+	else if (val < 0.0)
+		sketch_store_add(&sketch->negative, sketch_key(-val), 1);
+	else
+		sketch->zero_count++;
+}
+
+/* approx_percentile(state, val, percentile) */
+Datum
+approx_percentile_sfunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	MemoryContext old_context;
+	Sketch	   *sketch = (PG_ARGISNULL(0) ? NULL : (Sketch *) PG_GETARG_POINTER(0));
+	double		val;
+	double		percentile;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "approx_percentile_sfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(2))
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+				 errmsg("percentile cannot be NULL")));
+
+	percentile = PG_GETARG_FLOAT8(2);
+
+	/* The percentile is checked once, when the group's state is created */
+	if (sketch == NULL)
+		sketch = sketch_create(aggcontext, percentile);
+	else if (sketch->percentile != percentile)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("percentile must be the same for all rows")));
+
+	/* NULL values are not counted, like in other aggregates */
+	if (PG_ARGISNULL(1))
+		PG_RETURN_POINTER(sketch);
+
+	val = PG_GETARG_FLOAT8(1);
+
+	if (isnan(val) || isinf(val))
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("approx_percentile cannot aggregate NaN or infinite values")));
+
+	old_context = MemoryContextSwitchTo(aggcontext);
+	sketch_add(sketch, val);
+	MemoryContextSwitchTo(old_context);
+
+	PG_RETURN_POINTER(sketch);
+}
+
+/* approx_percentile_combinefunc(internal, internal) => internal */
+Datum
+approx_percentile_combinefunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	MemoryContext old_context;
+	Sketch	   *state1 = (PG_ARGISNULL(0) ? NULL : (Sketch *) PG_GETARG_POINTER(0));
+	Sketch	   *state2 = (PG_ARGISNULL(1) ? NULL : (Sketch *) PG_GETARG_POINTER(1));
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "approx_percentile_combinefunc called in non-aggregate context");
+	}
+
+	if (state2 == NULL)
+		PG_RETURN_POINTER(state1);
+
+	if (state1 == NULL)
+		state1 = sketch_create(aggcontext, state2->percentile);
+	else if (state1->percentile != state2->percentile)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("percentile must be the same for all rows")));
+
+	if (state2->count == 0)
+		PG_RETURN_POINTER(state1);
+
+	if (state1->count == 0 || state2->min < state1->min)
+		state1->min = state2->min;
+	if (state1->count == 0 || state2->max > state1->max)
+		state1->max = state2->max;
+
+	state1->count += state2->count;
+	state1->zero_count += state2->zero_count;
+
+	old_context = MemoryContextSwitchTo(aggcontext);
+	sketch_store_merge(&state1->positive, &state2->positive);
+	sketch_store_merge(&state1->negative, &state2->negative);
+	MemoryContextSwitchTo(old_context);
+
+	PG_RETURN_POINTER(state1);
+}
+
+/*
+ * approx_percentile_serializefunc(internal) => bytea
+ *
+ * Serialized states are only exchanged between the processes of a parallel
+ * query, so the state is copied as is, in the server's byte order.
+ */
+Datum
+approx_percentile_serializefunc(PG_FUNCTION_ARGS)
+{
+	Sketch	   *sketch;
+	SketchData *data;
+	Size		size;
+	bytea	   *result;
+
+	Assert(!PG_ARGISNULL(0));
+	sketch = (Sketch *) PG_GETARG_POINTER(0);
+	size = offsetof(SketchData, counts) +
+		sizeof(int64) * (sketch->positive.nbuckets + sketch->negative.nbuckets);
+
+	result = palloc0(VARHDRSZ + size);
+	SET_VARSIZE(result, VARHDRSZ + size);
+	data = (SketchData *) VARDATA(result);
+
+	data->percentile = sketch->percentile;
+	data->count = sketch->count;
+	data->zero_count = sketch->zero_count;
+	data->min = sketch->min;
+	data->max = sketch->max;
+	data->positive_offset = sketch->positive.offset;
+	data->positive_nbuckets = sketch->positive.nbuckets;
+	data->negative_offset = sketch->negative.offset;
+	data->negative_nbuckets = sketch->negative.nbuckets;
+
+	if (sketch->positive.nbuckets > 0)
+		memcpy(data->counts, sketch->positive.counts,
+			   sizeof(int64) * sketch->positive.nbuckets);
+	if (sketch->negative.nbuckets > 0)
+		memcpy(data->counts + sketch->positive.nbuckets, sketch->negative.counts,
+			   sizeof(int64) * sketch->negative.nbuckets);
+
+	PG_RETURN_BYTEA_P(result);
+}
+
+static void
+sketch_store_deserialize(SketchStore *store, int32 offset, int32 nbuckets, int64 *counts)
+{
+	store->offset = offset;
+	store->nbuckets = nbuckets;
+	store->counts = NULL;
+
+	if (nbuckets > 0)
+	{
+		store->counts = palloc(sizeof(int64) * nbuckets);
+		memcpy(store->counts, counts, sizeof(int64) * nbuckets);
+	}
+}
+
+/* approx_percentile_deserializefunc(bytea, internal) => internal */
+Datum
+approx_percentile_deserializefunc(PG_FUNCTION_ARGS)
+{
+	bytea	   *state;
+	SketchData	data;
+	Sketch	   *sketch;
+	Size		size;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	Assert(!PG_ARGISNULL(0));
+	state = PG_GETARG_BYTEA_P(0);
+	size = VARSIZE(state) - VARHDRSZ;
+
+	if (size < offsetof(SketchData, counts))
+		elog(ERROR, "invalid approx_percentile state");
+
+	memcpy(&data, VARDATA(state), offsetof(SketchData, counts));
+
+	if (data.positive_nbuckets < 0 || data.positive_nbuckets > SKETCH_MAX_BUCKETS ||
+		data.negative_nbuckets < 0 || data.negative_nbuckets > SKETCH_MAX_BUCKETS ||
+		size != offsetof(SketchData, counts) +
+		sizeof(int64) * (data.positive_nbuckets + data.negative_nbuckets))
+		elog(ERROR, "invalid approx_percentile state");
+
+	sketch = palloc(sizeof(Sketch));
+	sketch->percentile = data.percentile;
+	sketch->count = data.count;
+	sketch->zero_count = data.zero_count;
+	sketch->min = data.min;
+	sketch->max = data.max;
+	sketch_store_deserialize(&sketch->positive, data.positive_offset, data.positive_nbuckets,
+							 ((SketchData *) VARDATA(state))->counts);
+	sketch_store_deserialize(&sketch->negative, data.negative_offset, data.negative_nbuckets,
+							 ((SketchData *) VARDATA(state))->counts + data.positive_nbuckets);
+
+	PG_RETURN_POINTER(sketch);
+}
+
+/*
+ * approx_percentile_finalfunc(internal, val DOUBLE PRECISION, percentile DOUBLE PRECISION) => DOUBLE PRECISION
+ *
+ * Walks the buckets in the order of their values, from the most negative
+ * value to the largest positive one, up to the bucket that holds the value at
+ * the percentile's rank.
+ */
+Datum
+approx_percentile_finalfunc(PG_FUNCTION_ARGS)
+{
+	Sketch	   *sketch;
+	double		rank;
+	double		cumulative = 0;
+	double		result = 0;
+	bool		found = false;
+	int32		i;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "approx_percentile_finalfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	sketch = (Sketch *) PG_GETARG_POINTER(0);
+
+	if (sketch->count == 0)
+		PG_RETURN_NULL();
+
+	/* The extremes are known exactly */
+	if (sketch->percentile == 0.0)
+		PG_RETURN_FLOAT8(sketch->min);
+	if (sketch->percentile == 1.0)
+		PG_RETURN_FLOAT8(sketch->max);
+
+	rank = sketch->percentile * (sketch->count - 1);
+
+	for (i = sketch->negative.nbuckets - 1; i >= 0 && !found; i--)
+	{
+		cumulative += sketch->negative.counts[i];
+
+		if (cumulative > rank)
+		{
+			result = -sketch_value(sketch->negative.offset + i);
+			found = true;
+		}
+	}
+
+	if (!found)
+	{
+		cumulative += sketch->zero_count;
+
+		if (cumulative > rank)
+		{
+			result = 0;
+			found = true;
+		}
+	}
+
+	for (i = 0; i < sketch->positive.nbuckets && !found; i++)
+	{
+		cumulative += sketch->positive.counts[i];
+
+		if (cumulative > rank)
+		{
+			result = sketch_value(sketch->positive.offset + i);
+			found = true;
+		}
+	}
+
+	/* The estimate of a bucket might lie beyond the values of the group */
+	result = Max(result, sketch->min);
+	result = Min(result, sketch->max);
+
+	PG_RETURN_FLOAT8(result);
+}
@@ -0,0 +1,395 @@
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <access/xact.h>
+#include <miscadmin.h>
+#include <utils/builtins.h>
+#include <utils/lsyscache.h>
+#include <utils/timestamp.h>
+
+#include "bgw_job.h"
+#include "bgw_job_stat.h"
+#include "bgw_policy.h"
+#include "catalog.h"
+#include "hypertable.h"
+#include "scanner.h"
+#include "utils.h"
+#include "compat.h"
+
+/*
+ * Background jobs.
+ *
+ * A job runs a policy, e.g., retention, on a hypertable at a fixed
+ * interval. The job scheduler of each database (see bgw_scheduler.c) reads
+ * the jobs from the catalog and starts a background worker for each job run.
+ */
+
+static const char *job_type_names[_MAX_JOB_TYPE] = {
+	[JOB_TYPE_DROP_CHUNKS] = "drop_chunks",
+	[JOB_TYPE_CREATE_CHUNKS_AHEAD] = "create_chunks_ahead",
+	[JOB_TYPE_REORDER] = "reorder",
+	[JOB_TYPE_MOVE_CHUNKS] = "move_chunks",
+	[JOB_TYPE_COLD_INDEX] = "cold_index",
+};
+
+/* Defaults for new jobs. They can be changed with alter_job_schedule() */
+#define DEFAULT_MAX_RUNTIME "0"
+#define DEFAULT_MAX_RETRIES -1
+#define DEFAULT_RETRY_PERIOD "5 min"
+
+const char *
+bgw_job_type_name(JobType type)
+{
+	Assert(type >= 0 && type < _MAX_JOB_TYPE);
+	return job_type_names[type];
+}
+
+static JobType
+bgw_job_type_from_name(const char *name)
+{
+	int			i;
+
+	for (i = 0; i < _MAX_JOB_TYPE; i++)
+		if (strcmp(job_type_names[i], name) == 0)
+			return (JobType) i;
+
+	elog(ERROR, "unknown job type \"%s\"", name);
+	pg_unreachable();
+}
+
+static BgwJob *
+bgw_job_from_tuple(HeapTuple tuple)
+{
+	BgwJob	   *job = palloc0(sizeof(BgwJob));
+
+	memcpy(&job->fd, GETSTRUCT(tuple), sizeof(FormData_bgw_job));
+	job->type = bgw_job_type_from_name(NameStr(job->fd.job_type));
+
+	return job;
+}
+
+static bool
+bgw_job_tuple_append(TupleInfo *ti, void *data)
+{
+	List	  **jobs = data;
+
+	*jobs = lappend(*jobs, bgw_job_from_tuple(ti->tuple));
+	return true;
+}
+
+static bool
+bgw_job_tuple_found(TupleInfo *ti, void *data)
+{
+	BgwJob	  **job = data;
+
+	*job = bgw_job_from_tuple(ti->tuple);
+	return false;
+}
+
+static int
+bgw_job_scan_internal(int indexid,
+					  ScanKeyData *scankey,
+					  int nkeys,
+					  tuple_found_func tuple_found,
+					  void *data,
+					  int limit,
+					  LOCKMODE lockmode)
+{
+	Catalog    *catalog = catalog_get();
+	ScannerCtx	scanctx = {
+		.table = catalog_table_get_id(catalog, BGW_JOB),
+		.index = CATALOG_INDEX(catalog, BGW_JOB, indexid),
+		.nkeys = nkeys,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.limit = limit,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+	};
+
+	return scanner_scan(&scanctx);
+}
+
+/*
+ * Get all jobs in the database, ordered by ID.
+ */
+List *
+bgw_job_get_all(void)
+{
+	List	   *jobs = NIL;
+
+	bgw_job_scan_internal(BGW_JOB_PKEY_IDX, NULL, 0, bgw_job_tuple_append,
+						  &jobs, 0, AccessShareLock);
+
+	return jobs;
+}
+
+BgwJob *
+bgw_job_find(int32 job_id, bool fail_if_not_found)
+{
+	ScanKeyData scankey[1];
+	BgwJob	   *job = NULL;
+
+	ScanKeyInit(&scankey[0], Anum_bgw_job_pkey_idx_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(job_id));
+
+	bgw_job_scan_internal(BGW_JOB_PKEY_IDX, scankey, 1, bgw_job_tuple_found,
+						  &job, 1, AccessShareLock);
+
+	if (NULL == job && fail_if_not_found)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("job %d does not exist", job_id)));
+
+	return job;
+}
+
+BgwJob *
+bgw_job_find_by_hypertable_id(int32 hypertable_id, JobType type)
+{
+	ScanKeyData scankey[2];
+	BgwJob	   *job = NULL;
+
+	ScanKeyInit(&scankey[0], Anum_bgw_job_hypertable_id_job_type_idx_hypertable_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(hypertable_id));
+	ScanKeyInit(&scankey[1], Anum_bgw_job_hypertable_id_job_type_idx_job_type,
+				BTEqualStrategyNumber, F_NAMEEQ,
+				DirectFunctionCall1(namein, CStringGetDatum(bgw_job_type_name(type))));
+
+	bgw_job_scan_internal(BGW_JOB_HYPERTABLE_ID_JOB_TYPE_IDX, scankey, 2,
+						  bgw_job_tuple_found, &job, 1, AccessShareLock);
+
+	return job;
+}
+
+/*
+ * Add a job of the given type to the catalog and schedule its first run. The
+ * job's policy settings should be added by the caller.
+ *
+ * Returns the ID of the new job.
+ */
+int32
+bgw_job_insert(JobType type, int32 hypertable_id, Interval *schedule_interval)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	TupleDesc	desc;
+	Datum		values[Natts_bgw_job];
+	bool		nulls[Natts_bgw_job] = {false};
+	CatalogSecurityContext sec_ctx;
+	int32		job_id;
+
+	rel = heap_open(catalog_table_get_id(catalog, BGW_JOB), RowExclusiveLock);
+	desc = RelationGetDescr(rel);
+
+	catalog_become_owner(catalog, &sec_ctx);
+	job_id = catalog_table_next_seq_id(catalog, BGW_JOB);
+
+	values[Anum_bgw_job_id - 1] = Int32GetDatum(job_id);
+	values[Anum_bgw_job_job_type - 1] =
+		DirectFunctionCall1(namein, CStringGetDatum(bgw_job_type_name(type)));
+	values[Anum_bgw_job_hypertable_id - 1] = Int32GetDatum(hypertable_id);
+	values[Anum_bgw_job_schedule_interval - 1] = IntervalPGetDatum(schedule_interval);
+	values[Anum_bgw_job_max_runtime - 1] =
+		DirectFunctionCall3(interval_in, CStringGetDatum(DEFAULT_MAX_RUNTIME),
+							ObjectIdGetDatum(InvalidOid), Int32GetDatum(-1));
+	values[Anum_bgw_job_max_retries - 1] = Int32GetDatum(DEFAULT_MAX_RETRIES);
+	values[Anum_bgw_job_retry_period - 1] =
+		DirectFunctionCall3(interval_in, CStringGetDatum(DEFAULT_RETRY_PERIOD),
+							ObjectIdGetDatum(InvalidOid), Int32GetDatum(-1));
+
+	catalog_insert_values(rel, desc, values, nulls);
+	catalog_restore_user(&sec_ctx);
+	heap_close(rel, RowExclusiveLock);
+
+	bgw_job_stat_insert(job_id, bgw_job_stat_initial_start(schedule_interval,
+														   GetCurrentTimestamp()));
+
+	return job_id;
+}
+
+/*
+ * Delete a job's tuple along with its policy and statistics, which reference
+ * it.
+ */
+static bool
+bgw_job_tuple_delete(TupleInfo *ti, void *data)
+{
+	FormData_bgw_job *fd = (FormData_bgw_job *) GETSTRUCT(ti->tuple);
+	CatalogSecurityContext sec_ctx;
+
+	bgw_job_stat_delete(fd->id);
+	bgw_policy_delete(fd->id, bgw_job_type_from_name(NameStr(fd->job_type)));
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+int
+bgw_job_delete_by_id(int32 job_id)
+{
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_bgw_job_pkey_idx_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(job_id));
+
+	return bgw_job_scan_internal(BGW_JOB_PKEY_IDX, scankey, 1,
+								 bgw_job_tuple_delete, NULL, 1,
+								 RowExclusiveLock);
+}
+
+int
+bgw_job_delete_by_hypertable_id(int32 hypertable_id)
+{
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_bgw_job_hypertable_id_job_type_idx_hypertable_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(hypertable_id));
+
+	return bgw_job_scan_internal(BGW_JOB_HYPERTABLE_ID_JOB_TYPE_IDX, scankey, 1,
+								 bgw_job_tuple_delete, NULL, 0,
+								 RowExclusiveLock);
+}
+
+/*
+ * Get a job's maximum run time in milliseconds, or 0 if the run time is not
+ * limited.
+ */
+int64
+bgw_job_timeout_ms(BgwJob *job)
+{
+	int64		usecs = interval_to_usec(&job->fd.max_runtime);
+
+	if (usecs <= 0)
+		return 0;
+
+	return Max(usecs / 1000, 1);
+}
+
+/*
+ * Run a job in the current transaction.
+ *
+ * The job runs with the privileges of the hypertable's owner, no matter who
+ * created the job or who runs the scheduler.
+ */
+void
+bgw_job_execute(BgwJob *job)
+{
+	Oid			table_relid = hypertable_id_to_relid(job->fd.hypertable_id);
+	Oid			saved_uid;
+	int			saved_sec_ctx;
+
+	if (!OidIsValid(table_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("hypertable of job %d does not exist", job->fd.id)));
+
+	GetUserIdAndSecContext(&saved_uid, &saved_sec_ctx);
+	SetUserIdAndSecContext(rel_get_owner(table_relid),
+						   saved_sec_ctx | SECURITY_LOCAL_USERID_CHANGE);
+
+	bgw_policy_execute(job, table_relid);
+
+	SetUserIdAndSecContext(saved_uid, saved_sec_ctx);
+}
+
+static bool
+bgw_job_tuple_update(TupleInfo *ti, void *data)
+{
+	BgwJob	   *job = data;
+	HeapTuple	tuple = heap_copytuple(ti->tuple);
+	FormData_bgw_job *fd = (FormData_bgw_job *) GETSTRUCT(tuple);
+	CatalogSecurityContext sec_ctx;
+
+	fd->schedule_interval = job->fd.schedule_interval;
+	fd->max_runtime = job->fd.max_runtime;
+	fd->max_retries = job->fd.max_retries;
+	fd->retry_period = job->fd.retry_period;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_update(ti->scanrel, tuple);
+	catalog_restore_user(&sec_ctx);
+
+	heap_freetuple(tuple);
+
+	return false;
+}
+
+TS_FUNCTION_INFO_V1(bgw_job_alter_schedule);
+
+/*
+ * Change the schedule of a job. NULL arguments keep the current setting.
+ *
+ * A new schedule interval takes effect after the next run of the job.
+ */
+Datum
+bgw_job_alter_schedule(PG_FUNCTION_ARGS)
+{
+	int32		job_id = PG_GETARG_INT32(0);
+	BgwJob	   *job = bgw_job_find(job_id, true);
+	ScanKeyData scankey[1];
+
+	hypertable_permissions_check(hypertable_id_to_relid(job->fd.hypertable_id), GetUserId());
+
+	if (!PG_ARGISNULL(1))
+		job->fd.schedule_interval = *PG_GETARG_INTERVAL_P(1);
+	if (!PG_ARGISNULL(2))
+		job->fd.max_runtime = *PG_GETARG_INTERVAL_P(2);
+	if (!PG_ARGISNULL(3))
+		job->fd.max_retries = PG_GETARG_INT32(3);
+	if (!PG_ARGISNULL(4))
+		job->fd.retry_period = *PG_GETARG_INTERVAL_P(4);
+
+	/* The catalog's check constraints do not apply to catalog updates */
+	if (interval_to_usec(&job->fd.schedule_interval) <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid schedule interval: must be greater than zero")));
+
+	if (interval_to_usec(&job->fd.max_runtime) < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid maximum run time: must be zero or greater")));
+
+	if (job->fd.max_retries < -1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid maximum number of retries: must be -1 or greater")));
+
+	if (interval_to_usec(&job->fd.retry_period) <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid retry period: must be greater than zero")));
+
+	ScanKeyInit(&scankey[0], Anum_bgw_job_pkey_idx_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(job_id));
+
+	bgw_job_scan_internal(BGW_JOB_PKEY_IDX, scankey, 1, bgw_job_tuple_update,
+						  job, 1, RowExclusiveLock);
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(bgw_job_run);
+
+/*
+ * Run a job right away in the current session, e.g., to test a policy. The
+ * run is recorded in the job's statistics, but it does not change when the
+ * scheduler runs the job next.
+ */
+Datum
+bgw_job_run(PG_FUNCTION_ARGS)
+{
+	BgwJob	   *job = bgw_job_find(PG_GETARG_INT32(0), true);
+
+	hypertable_permissions_check(hypertable_id_to_relid(job->fd.hypertable_id), GetUserId());
+
+	bgw_job_stat_mark_start(job);
+	bgw_job_execute(job);
+	bgw_job_stat_mark_end(job, true, false);
+
+	PG_RETURN_VOID();
+}
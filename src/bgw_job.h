@@ -0,0 +1,35 @@
+#ifndef TIMESCALEDB_BGW_JOB_H
+#define TIMESCALEDB_BGW_JOB_H
+
+#include <postgres.h>
+#include <nodes/pg_list.h>
+
+#include "catalog.h"
+
+typedef enum JobType
+{
+	JOB_TYPE_DROP_CHUNKS = 0,
+	JOB_TYPE_CREATE_CHUNKS_AHEAD,
+	JOB_TYPE_REORDER,
+	JOB_TYPE_MOVE_CHUNKS,
+	JOB_TYPE_COLD_INDEX,
+	_MAX_JOB_TYPE,
+} JobType;
+
+typedef struct BgwJob
+{
+	FormData_bgw_job fd;
+	JobType		type;
+} BgwJob;
+
+extern const char *bgw_job_type_name(JobType type);
+extern List *bgw_job_get_all(void);
+extern BgwJob *bgw_job_find(int32 job_id, bool fail_if_not_found);
+extern BgwJob *bgw_job_find_by_hypertable_id(int32 hypertable_id, JobType type);
+extern int32 bgw_job_insert(JobType type, int32 hypertable_id, Interval *schedule_interval);
+extern int	bgw_job_delete_by_id(int32 job_id);
+extern int	bgw_job_delete_by_hypertable_id(int32 hypertable_id);
+extern int64 bgw_job_timeout_ms(BgwJob *job);
+extern void bgw_job_execute(BgwJob *job);
+
+#endif							/* TIMESCALEDB_BGW_JOB_H */
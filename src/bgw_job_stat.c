@@ -0,0 +1,303 @@
+#include <postgres.h>
+#include <math.h>
+#include <access/htup_details.h>
+#include <utils/builtins.h>
+#include <utils/timestamp.h>
+
+#include "bgw_job_stat.h"
+#include "catalog.h"
+#include "scanner.h"
+
+/*
+ * Statistics of background job runs.
+ *
+ * Besides the run counts, a job's statistics hold the time when the job is
+ * to run next. A job that fails is retried after the job's retry period,
+ * which doubles with each consecutive failure but never exceeds the schedule
+ * interval. After more than 'max_retries' consecutive failures (unless it is
+ * -1), the job is only run on its regular schedule.
+ *
+ * A job that is running has a last_start that is later than its
+ * last_finish. If its worker goes away without recording the end of the run,
+ * e.g., because it was terminated, the scheduler records the run as failed.
+ */
+
+/* Limit of the retry back off, which doubles the retry period each time */
+#define MAX_BACKOFF_EXPONENT 16
+
+static TimestampTz
+timestamp_plus_interval(TimestampTz timestamp, Interval *interval)
+{
+	return DatumGetTimestampTz(DirectFunctionCall2(timestamptz_pl_interval,
+												   TimestampTzGetDatum(timestamp),
+												   IntervalPGetDatum(interval)));
+}
+
+static Interval *
+interval_times(Interval *interval, double factor)
+{
+	return DatumGetIntervalP(DirectFunctionCall2(interval_mul,
+												 IntervalPGetDatum(interval),
+												 Float8GetDatum(factor)));
+}
+
+/*
+ * Get the time of the first run of a new job.
+ *
+ * The first run is one schedule interval from now, plus a random delay of up
+ * to a tenth of the interval. This way, the runs of jobs that are created
+ * together, e.g., by a script, are spread out instead of all starting at
+ * once.
+ */
+TimestampTz
+bgw_job_stat_initial_start(Interval *schedule_interval, TimestampTz now)
+{
+	double		jitter = 0.1 * ((double) random() / MAX_RANDOM_VALUE);
+
+	return timestamp_plus_interval(now, interval_times(schedule_interval, 1.0 + jitter));
+}
+
+static TimestampTz
+next_start_on_success(BgwJob *job, FormData_bgw_job_stat *fd)
+{
+	TimestampTz next_start = timestamp_plus_interval(fd->last_start,
+													 &job->fd.schedule_interval);
+
+	/* Do not run again right away if the run took longer than the interval */
+	if (next_start <= fd->last_finish)
+		next_start = timestamp_plus_interval(fd->last_finish,
+											 &job->fd.schedule_interval);
+
+	return next_start;
+}
+
+static TimestampTz
+next_start_on_failure(BgwJob *job, FormData_bgw_job_stat *fd)
+{
+	TimestampTz next_scheduled = timestamp_plus_interval(fd->last_finish,
+														 &job->fd.schedule_interval);
+	TimestampTz next_retry;
+	int			exponent;
+
+	if (job->fd.max_retries >= 0 && fd->consecutive_failures > job->fd.max_retries)
+		return next_scheduled;
+
+	exponent = Min(fd->consecutive_failures - 1, MAX_BACKOFF_EXPONENT);
+	next_retry = timestamp_plus_interval(fd->last_finish,
+										 interval_times(&job->fd.retry_period,
+														ldexp(1.0, exponent)));
+
+	return Min(next_retry, next_scheduled);
+}
+
+static int
+bgw_job_stat_scan_job_id(int32 job_id, tuple_found_func tuple_found, void *data, LOCKMODE lockmode)
+{
+	Catalog    *catalog = catalog_get();
+	ScanKeyData scankey[1];
+	ScannerCtx	scanctx = {
+		.table = catalog_table_get_id(catalog, BGW_JOB_STAT),
+		.index = CATALOG_INDEX(catalog, BGW_JOB_STAT, BGW_JOB_STAT_PKEY_IDX),
+		.nkeys = 1,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.limit = 1,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+	};
+
+	ScanKeyInit(&scankey[0], Anum_bgw_job_stat_pkey_idx_job_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(job_id));
+
+	return scanner_scan(&scanctx);
+}
+
+static bool
+bgw_job_stat_tuple_found(TupleInfo *ti, void *data)
+{
+	BgwJobStat **stat = data;
+
+	*stat = palloc(sizeof(BgwJobStat));
+	memcpy(&(*stat)->fd, GETSTRUCT(ti->tuple), sizeof(FormData_bgw_job_stat));
+
+	return false;
+}
+
+BgwJobStat *
+bgw_job_stat_find(int32 job_id)
+{
+	BgwJobStat *stat = NULL;
+
+	bgw_job_stat_scan_job_id(job_id, bgw_job_stat_tuple_found, &stat, AccessShareLock);
+
+	return stat;
+}
+
+void
+bgw_job_stat_insert(int32 job_id, TimestampTz next_start)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	Datum		values[Natts_bgw_job_stat];
+	bool		nulls[Natts_bgw_job_stat] = {false};
+	CatalogSecurityContext sec_ctx;
+
+	rel = heap_open(catalog_table_get_id(catalog, BGW_JOB_STAT), RowExclusiveLock);
+
+	values[Anum_bgw_job_stat_job_id - 1] = Int32GetDatum(job_id);
+	values[Anum_bgw_job_stat_last_start - 1] = TimestampTzGetDatum(DT_NOBEGIN);
+	values[Anum_bgw_job_stat_last_finish - 1] = TimestampTzGetDatum(DT_NOBEGIN);
+	values[Anum_bgw_job_stat_next_start - 1] = TimestampTzGetDatum(next_start);
+	values[Anum_bgw_job_stat_last_run_success - 1] = BoolGetDatum(true);
+	values[Anum_bgw_job_stat_total_runs - 1] = Int64GetDatum(0);
+	values[Anum_bgw_job_stat_total_failures - 1] = Int64GetDatum(0);
+	values[Anum_bgw_job_stat_consecutive_failures - 1] = Int32GetDatum(0);
+
+	catalog_become_owner(catalog, &sec_ctx);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+
+	heap_close(rel, RowExclusiveLock);
+}
+
+static bool
+bgw_job_stat_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return false;
+}
+
+int
+bgw_job_stat_delete(int32 job_id)
+{
+	return bgw_job_stat_scan_job_id(job_id, bgw_job_stat_tuple_delete, NULL, RowExclusiveLock);
+}
+
+typedef struct JobRunInfo
+{
+	BgwJob	   *job;
+	bool		success;
+	bool		reschedule;
+	bool		only_if_running;
+} JobRunInfo;
+
+static void
+bgw_job_stat_tuple_update(TupleInfo *ti, HeapTuple tuple)
+{
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_update(ti->scanrel, tuple);
+	catalog_restore_user(&sec_ctx);
+
+	heap_freetuple(tuple);
+}
+
+static bool
+bgw_job_stat_tuple_mark_start(TupleInfo *ti, void *data)
+{
+	HeapTuple	tuple = heap_copytuple(ti->tuple);
+	FormData_bgw_job_stat *fd = (FormData_bgw_job_stat *) GETSTRUCT(tuple);
+
+	fd->last_start = GetCurrentTimestamp();
+	fd->total_runs++;
+
+	bgw_job_stat_tuple_update(ti, tuple);
+
+	return false;
+}
+
+static bool
+bgw_job_stat_tuple_mark_end(TupleInfo *ti, void *data)
+{
+	JobRunInfo *info = data;
+	HeapTuple	tuple;
+	FormData_bgw_job_stat *fd;
+
+	if (info->only_if_running &&
+		((FormData_bgw_job_stat *) GETSTRUCT(ti->tuple))->last_finish >=
+		((FormData_bgw_job_stat *) GETSTRUCT(ti->tuple))->last_start)
+		return false;
+
+	tuple = heap_copytuple(ti->tuple);
+	fd = (FormData_bgw_job_stat *) GETSTRUCT(tuple);
+
+	fd->last_finish = GetCurrentTimestamp();
+	fd->last_run_success = info->success;
+
+	if (info->success)
+		fd->consecutive_failures = 0;
+	else
+	{
+		fd->total_failures++;
+		fd->consecutive_failures++;
+	}
+
+	if (info->reschedule)
+		fd->next_start = info->success ?
+			next_start_on_success(info->job, fd) :
+			next_start_on_failure(info->job, fd);
+
+	bgw_job_stat_tuple_update(ti, tuple);
+
+	return false;
+}
+
+/*
+ * Record the start of a job run.
+ */
+void
+bgw_job_stat_mark_start(BgwJob *job)
+{
+	if (bgw_job_stat_scan_job_id(job->fd.id, bgw_job_stat_tuple_mark_start,
+								 NULL, RowExclusiveLock) > 0)
+		return;
+
+	/* Statistics are not dumped, so restored jobs have none */
+	bgw_job_stat_insert(job->fd.id,
+						bgw_job_stat_initial_start(&job->fd.schedule_interval,
+												   GetCurrentTimestamp()));
+	bgw_job_stat_scan_job_id(job->fd.id, bgw_job_stat_tuple_mark_start,
+							 NULL, RowExclusiveLock);
+}
+
+/*
+ * Record the end of a job run. If "reschedule" is set, the next start of the
+ * job is computed from the result of the run.
+ */
+void
+bgw_job_stat_mark_end(BgwJob *job, bool success, bool reschedule)
+{
+	JobRunInfo	info = {
+		.job = job,
+		.success = success,
+		.reschedule = reschedule,
+	};
+
+	bgw_job_stat_scan_job_id(job->fd.id, bgw_job_stat_tuple_mark_end,
+							 &info, RowExclusiveLock);
+}
+
+/*
+ * Record a failed run of a job whose worker stopped without recording the
+ * end of the run.
+ */
+void
+bgw_job_stat_mark_crash_if_running(BgwJob *job)
+{
+	JobRunInfo	info = {
+		.job = job,
+		.success = false,
+		.reschedule = true,
+		.only_if_running = true,
+	};
+
+	bgw_job_stat_scan_job_id(job->fd.id, bgw_job_stat_tuple_mark_end,
+							 &info, RowExclusiveLock);
+}
@@ -0,0 +1,22 @@
+#ifndef TIMESCALEDB_BGW_JOB_STAT_H
+#define TIMESCALEDB_BGW_JOB_STAT_H
+
+#include <postgres.h>
+
+#include "bgw_job.h"
+#include "catalog.h"
+
+typedef struct BgwJobStat
+{
+	FormData_bgw_job_stat fd;
+} BgwJobStat;
+
+extern BgwJobStat *bgw_job_stat_find(int32 job_id);
+extern void bgw_job_stat_insert(int32 job_id, TimestampTz next_start);
+extern int	bgw_job_stat_delete(int32 job_id);
+extern void bgw_job_stat_mark_start(BgwJob *job);
+extern void bgw_job_stat_mark_end(BgwJob *job, bool success, bool reschedule);
+extern void bgw_job_stat_mark_crash_if_running(BgwJob *job);
+extern TimestampTz bgw_job_stat_initial_start(Interval *schedule_interval, TimestampTz now);
+
+#endif							/* TIMESCALEDB_BGW_JOB_STAT_H */
@@ -0,0 +1,914 @@
+#include <postgres.h>
+#include <access/genam.h>
+#include <access/htup_details.h>
+#include <access/xact.h>
+#include <catalog/index.h>
+#include <catalog/pg_am.h>
+#include <catalog/pg_type.h>
+#include <commands/defrem.h>
+#include <miscadmin.h>
+#include <utils/builtins.h>
+#include <utils/date.h>
+#include <utils/lsyscache.h>
+#include <utils/rel.h>
+#include <utils/timestamp.h>
+
+#include "bgw_job.h"
+#include "bgw_policy.h"
+#include "catalog.h"
+#include "chunk.h"
+#include "chunk_index.h"
+#include "dimension.h"
+#include "errors.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "reorder.h"
+#include "scanner.h"
+#include "tablespace.h"
+#include "utils.h"
+#include "compat.h"
+
+/*
+ * Policies run by background jobs.
+ *
+ * Each job type has a policy table that holds the settings of the job, keyed
+ * on the job ID:
+ *
+ * - drop_chunks: drop the chunks that are older than an interval (retention).
+ * - create_chunks_ahead: create the chunks for upcoming time intervals.
+ * - reorder: reorder the chunks that are older than an interval on an index
+ *   (see reorder.c).
+ * - move_chunks: move the chunks that are older than an interval to other
+ *   tablespaces, e.g., from fast to cheaper storage (tiering).
+ * - cold_index: rebuild the chunks' copy of a hypertable index with another
+ *   index access method for the chunks that are older than an interval, e.g.,
+ *   BRIN instead of B-tree on time. New chunks get the hypertable index as
+ *   is, so each chunk's index suits its age.
+ *
+ * A hypertable has at most one policy of each type.
+ */
+
+static const CatalogTable policy_tables[_MAX_JOB_TYPE] = {
+	[JOB_TYPE_DROP_CHUNKS] = BGW_POLICY_DROP_CHUNKS,
+	[JOB_TYPE_CREATE_CHUNKS_AHEAD] = BGW_POLICY_CREATE_CHUNKS_AHEAD,
+	[JOB_TYPE_REORDER] = BGW_POLICY_REORDER,
+	[JOB_TYPE_MOVE_CHUNKS] = BGW_POLICY_MOVE_CHUNKS,
+	[JOB_TYPE_COLD_INDEX] = BGW_POLICY_COLD_INDEX,
+};
+
+/* All policy tables have their primary key on the job ID */
+#define POLICY_PKEY_IDX 0
+#define Anum_policy_pkey_idx_job_id 1
+
+#define DEFAULT_SCHEDULE_INTERVAL "1 day"
+
+static int
+policy_scan_by_job_id(JobType type, int32 job_id, tuple_found_func tuple_found,
+					  void *data, LOCKMODE lockmode)
+{
+	Catalog    *catalog = catalog_get();
+	CatalogTable table = policy_tables[type];
+	ScanKeyData scankey[1];
+	ScannerCtx	scanctx = {
+		.table = catalog_table_get_id(catalog, table),
+		.index = CATALOG_INDEX(catalog, table, POLICY_PKEY_IDX),
+		.nkeys = 1,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.limit = 1,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+	};
+
+	ScanKeyInit(&scankey[0], Anum_policy_pkey_idx_job_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(job_id));
+
+	return scanner_scan(&scanctx);
+}
+
+typedef struct PolicyFormData
+{
+	void	   *fd;
+	Size		size;
+} PolicyFormData;
+
+static bool
+policy_tuple_found(TupleInfo *ti, void *data)
+{
+	PolicyFormData *form = data;
+
+	form->fd = palloc(form->size);
+	memcpy(form->fd, GETSTRUCT(ti->tuple), form->size);
+
+	return false;
+}
+
+static void *
+policy_find(JobType type, int32 job_id, Size size)
+{
+	PolicyFormData form = {
+		.size = size,
+	};
+
+	policy_scan_by_job_id(type, job_id, policy_tuple_found, &form, AccessShareLock);
+
+	if (NULL == form.fd)
+		elog(ERROR, "policy of job %d not found", job_id);
+
+	return form.fd;
+}
+
+static void
+policy_insert(JobType type, Datum *values)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	TupleDesc	desc;
+	bool		nulls[Max(Max(Max(Natts_bgw_policy_reorder, Natts_bgw_policy_move_chunks),
+							  Max(Natts_bgw_policy_drop_chunks, Natts_bgw_policy_create_chunks_ahead)),
+						  Natts_bgw_policy_cold_index)] = {false};
+	CatalogSecurityContext sec_ctx;
+
+	rel = heap_open(catalog_table_get_id(catalog, policy_tables[type]), RowExclusiveLock);
+	desc = RelationGetDescr(rel);
+
+	catalog_become_owner(catalog, &sec_ctx);
+	catalog_insert_values(rel, desc, values, nulls);
+	catalog_restore_user(&sec_ctx);
+
+	heap_close(rel, RowExclusiveLock);
+}
+
+static bool
+policy_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return false;
+}
+
+int
+bgw_policy_delete(int32 job_id, JobType type)
+{
+	return policy_scan_by_job_id(type, job_id, policy_tuple_delete, NULL, RowExclusiveLock);
+}
+
+static Hypertable *
+policy_get_time_dimension(Cache *hcache, Oid table_relid, Dimension **time_dim)
+{
+	Hypertable *ht = hypertable_cache_get_entry(hcache, table_relid);
+
+	if (NULL == ht)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_HYPERTABLE_NOT_EXIST),
+				 errmsg("table \"%s\" is not a hypertable",
+						get_rel_name(table_relid))));
+
+	*time_dim = hyperspace_get_open_dimension(ht->space, 0);
+
+	if (NULL == *time_dim)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_DIMENSION_NOT_EXIST),
+				 errmsg("hypertable \"%s\" has no time dimension",
+						get_rel_name(table_relid))));
+
+	return ht;
+}
+
+/*
+ * Get the time that is the given interval before the start of the current
+ * transaction, in the internal time format of the time column.
+ */
+static int64
+policy_time_cutoff(JobType type, Interval *older_than, Oid time_type)
+{
+	Datum		cutoff = DirectFunctionCall2(timestamptz_mi_interval,
+											 TimestampTzGetDatum(GetCurrentTransactionStartTimestamp()),
+											 IntervalPGetDatum(older_than));
+
+	/* Same conversions as drop_chunks() with an interval */
+	switch (time_type)
+	{
+		case TIMESTAMPTZOID:
+			break;
+		case TIMESTAMPOID:
+			cutoff = DirectFunctionCall1(timestamptz_timestamp, cutoff);
+			break;
+		case DATEOID:
+			cutoff = DirectFunctionCall1(timestamptz_date, cutoff);
+			break;
+		default:
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("%s policies require a time column of type TIMESTAMP, TIMESTAMPTZ, or DATE",
+							bgw_job_type_name(type))));
+			pg_unreachable();
+	}
+
+	return time_value_to_internal(cutoff, time_type);
+}
+
+/*
+ * Drop the chunks that are older than the policy's interval, relative to the
+ * start of the current transaction.
+ */
+static void
+policy_drop_chunks_execute(BgwJob *job, Oid table_relid)
+{
+	FormData_bgw_policy_drop_chunks *policy =
+	policy_find(JOB_TYPE_DROP_CHUNKS, job->fd.id, sizeof(FormData_bgw_policy_drop_chunks));
+	Cache	   *hcache = hypertable_cache_pin();
+	Dimension  *time_dim;
+	Hypertable *ht = policy_get_time_dimension(hcache, table_relid, &time_dim);
+	NameData	schema_name = ht->fd.schema_name;
+	NameData	table_name = ht->fd.table_name;
+	Oid			time_type = time_dim->fd.column_type;
+
+	cache_release(hcache);
+
+	DirectFunctionCall5(chunk_drop_chunks,
+						Int64GetDatum(policy_time_cutoff(JOB_TYPE_DROP_CHUNKS, &policy->older_than, time_type)),
+						NameGetDatum(&table_name),
+						NameGetDatum(&schema_name),
+						BoolGetDatum(policy->cascade),
+						BoolGetDatum(false));
+}
+
+static void
+policy_create_chunks_ahead_execute(BgwJob *job, Oid table_relid)
+{
+	FormData_bgw_policy_create_chunks_ahead *policy =
+	policy_find(JOB_TYPE_CREATE_CHUNKS_AHEAD, job->fd.id,
+				sizeof(FormData_bgw_policy_create_chunks_ahead));
+
+	DirectFunctionCall2(chunk_create_ahead,
+						ObjectIdGetDatum(table_relid),
+						Int32GetDatum(policy->num_intervals));
+}
+
+static Oid
+policy_index_relam(Oid index_relid)
+{
+	Relation	index_rel = index_open(index_relid, AccessShareLock);
+	Oid			relam = index_rel->rd_rel->relam;
+
+	index_close(index_rel, AccessShareLock);
+
+	return relam;
+}
+
+/*
+ * Reorder one chunk that ends more than the policy's interval ago: the most
+ * recent one that is not yet ordered on the policy's index. Reordering one
+ * chunk per run keeps the exclusive lock, which is held until the end of the
+ * job's transaction, to a single chunk. Older chunks are reordered by the
+ * following runs.
+ */
+static void
+policy_reorder_execute(BgwJob *job, Oid table_relid)
+{
+	FormData_bgw_policy_reorder *policy =
+	policy_find(JOB_TYPE_REORDER, job->fd.id, sizeof(FormData_bgw_policy_reorder));
+	Cache	   *hcache = hypertable_cache_pin();
+	Dimension  *time_dim;
+	Hypertable *ht = policy_get_time_dimension(hcache, table_relid, &time_dim);
+	Oid			index_relid = get_relname_relid(NameStr(policy->hypertable_index_name),
+												get_rel_namespace(table_relid));
+	List	   *chunks;
+	ListCell   *lc;
+	Oid			chunk_relid = InvalidOid;
+	Oid			chunk_index_relid = InvalidOid;
+
+	if (!OidIsValid(index_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("index \"%s\" of the reorder policy of hypertable \"%s\" does not exist",
+						NameStr(policy->hypertable_index_name),
+						get_rel_name(table_relid))));
+
+	chunks = chunk_get_all_ending_before(ht,
+										 policy_time_cutoff(JOB_TYPE_REORDER,
+															&policy->older_than,
+															time_dim->fd.column_type),
+										 false);
+
+	/* The chunks are ordered by time, so the last match is the most recent */
+	foreach(lc, chunks)
+	{
+		Chunk	   *chunk = lfirst(lc);
+		ChunkIndexMapping *cim = chunk_index_get_by_hypertable_indexrelid(chunk, index_relid);
+
+		/* The cold_index policy can have rebuilt the index as non-B-tree */
+		if (NULL != cim && policy_index_relam(cim->indexoid) == BTREE_AM_OID &&
+			!reorder_index_is_clustered(cim->indexoid))
+		{
+			chunk_relid = chunk->table_id;
+			chunk_index_relid = cim->indexoid;
+		}
+	}
+
+	cache_release(hcache);
+
+	if (OidIsValid(chunk_relid))
+		reorder_chunk(chunk_relid, chunk_index_relid, false);
+}
+
+/*
+ * Move one chunk that ends more than the policy's interval ago to the
+ * policy's tablespaces: the oldest one that is not yet in them, since it is
+ * the least likely to be read. Like the reorder policy, each run moves a
+ * single chunk to hold the exclusive lock on only one chunk.
+ */
+static void
+policy_move_chunks_execute(BgwJob *job, Oid table_relid)
+{
+	FormData_bgw_policy_move_chunks *policy =
+	policy_find(JOB_TYPE_MOVE_CHUNKS, job->fd.id, sizeof(FormData_bgw_policy_move_chunks));
+	Cache	   *hcache = hypertable_cache_pin();
+	Dimension  *time_dim;
+	Hypertable *ht = policy_get_time_dimension(hcache, table_relid, &time_dim);
+	Oid			tspc_oid = tablespace_get_attached_oid(ht, NameStr(policy->tablespace_name));
+	Oid			index_tspc_oid = tablespace_get_attached_oid(ht, NameStr(policy->index_tablespace_name));
+	List	   *chunks;
+	ListCell   *lc;
+	Oid			chunk_relid = InvalidOid;
+
+	chunks = chunk_get_all_ending_before(ht,
+										 policy_time_cutoff(JOB_TYPE_MOVE_CHUNKS,
+															&policy->older_than,
+															time_dim->fd.column_type),
+										 false);
+
+	/* The chunks are ordered by time, so the first match is the oldest */
+	foreach(lc, chunks)
+	{
+		Chunk	   *chunk = lfirst(lc);
+
+		if (!move_chunk_is_in_tablespaces(chunk->table_id, tspc_oid, index_tspc_oid))
+		{
+			chunk_relid = chunk->table_id;
+			break;
+		}
+	}
+
+	cache_release(hcache);
+
+	if (OidIsValid(chunk_relid))
+		move_chunk(chunk_relid, &policy->tablespace_name,
+				   &policy->index_tablespace_name, InvalidOid, false);
+}
+
+/*
+ * Rebuild the index of one chunk that ends more than the policy's interval
+ * ago with the policy's access method: the most recent one whose index does
+ * not use it yet. Like the reorder policy, each run rebuilds a single
+ * chunk's index to block writes to only one chunk at a time.
+ */
+static void
+policy_cold_index_execute(BgwJob *job, Oid table_relid)
+{
+	FormData_bgw_policy_cold_index *policy =
+	policy_find(JOB_TYPE_COLD_INDEX, job->fd.id, sizeof(FormData_bgw_policy_cold_index));
+	Cache	   *hcache = hypertable_cache_pin();
+	Dimension  *time_dim;
+	Hypertable *ht = policy_get_time_dimension(hcache, table_relid, &time_dim);
+	Oid			index_relid = get_relname_relid(NameStr(policy->hypertable_index_name),
+												get_rel_namespace(table_relid));
+	Oid			amoid = get_index_am_oid(NameStr(policy->access_method), false);
+	List	   *chunks;
+	ListCell   *lc;
+	Oid			chunk_index_relid = InvalidOid;
+
+	if (!OidIsValid(index_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("index \"%s\" of the cold_index policy of hypertable \"%s\" does not exist",
+						NameStr(policy->hypertable_index_name),
+						get_rel_name(table_relid))));
+
+	chunks = chunk_get_all_ending_before(ht,
+										 policy_time_cutoff(JOB_TYPE_COLD_INDEX,
+															&policy->older_than,
+															time_dim->fd.column_type),
+										 false);
+
+	/* The chunks are ordered by time, so the last match is the most recent */
+	foreach(lc, chunks)
+	{
+		Chunk	   *chunk = lfirst(lc);
+		ChunkIndexMapping *cim = chunk_index_get_by_hypertable_indexrelid(chunk, index_relid);
+
+		if (NULL != cim && policy_index_relam(cim->indexoid) != amoid)
+			chunk_index_relid = cim->indexoid;
+	}
+
+	cache_release(hcache);
+
+	if (OidIsValid(chunk_index_relid))
+		chunk_index_set_access_method(chunk_index_relid, amoid);
+}
+
+/*
+ * Run the policy of a job on the job's hypertable.
+ */
+void
+bgw_policy_execute(BgwJob *job, Oid table_relid)
+{
+	switch (job->type)
+	{
+		case JOB_TYPE_DROP_CHUNKS:
+			policy_drop_chunks_execute(job, table_relid);
+			break;
+		case JOB_TYPE_CREATE_CHUNKS_AHEAD:
+			policy_create_chunks_ahead_execute(job, table_relid);
+			break;
+		case JOB_TYPE_REORDER:
+			policy_reorder_execute(job, table_relid);
+			break;
+		case JOB_TYPE_MOVE_CHUNKS:
+			policy_move_chunks_execute(job, table_relid);
+			break;
+		case JOB_TYPE_COLD_INDEX:
+			policy_cold_index_execute(job, table_relid);
+			break;
+		default:
+			elog(ERROR, "unknown job type %d", job->type);
+	}
+}
+
+/*
+ * Get the hypertable that a policy is added to or removed from, checking that
+ * the current user owns it.
+ */
+static Hypertable *
+policy_get_hypertable(Cache *hcache, Oid table_relid)
+{
+	Hypertable *ht;
+
+	if (!OidIsValid(table_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid hypertable: cannot be NULL")));
+
+	hypertable_permissions_check(table_relid, GetUserId());
+	ht = hypertable_cache_get_entry(hcache, table_relid);
+
+	if (NULL == ht)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_HYPERTABLE_NOT_EXIST),
+				 errmsg("table \"%s\" is not a hypertable",
+						get_rel_name(table_relid))));
+
+	return ht;
+}
+
+/*
+ * Check for an existing policy of the given type. Returns the existing job's
+ * ID, or 0 if there is none.
+ */
+static int32
+policy_check_exists(Hypertable *ht, JobType type, bool if_not_exists)
+{
+	BgwJob	   *job = bgw_job_find_by_hypertable_id(ht->fd.id, type);
+
+	if (NULL == job)
+		return 0;
+
+	if (!if_not_exists)
+		ereport(ERROR,
+				(errcode(ERRCODE_DUPLICATE_OBJECT),
+				 errmsg("%s policy already exists for hypertable \"%s\"",
+						bgw_job_type_name(type),
+						get_rel_name(ht->main_table_relid))));
+
+	ereport(NOTICE,
+			(errmsg("%s policy already exists for hypertable \"%s\", skipping",
+					bgw_job_type_name(type),
+					get_rel_name(ht->main_table_relid))));
+
+	return job->fd.id;
+}
+
+static Interval *
+policy_schedule_interval(FunctionCallInfo fcinfo, int argno)
+{
+	Interval   *schedule_interval;
+
+	if (PG_ARGISNULL(argno))
+		return DatumGetIntervalP(DirectFunctionCall3(interval_in,
+													 CStringGetDatum(DEFAULT_SCHEDULE_INTERVAL),
+													 ObjectIdGetDatum(InvalidOid),
+													 Int32GetDatum(-1)));
+
+	schedule_interval = PG_GETARG_INTERVAL_P(argno);
+
+	if (interval_to_usec(schedule_interval) <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid schedule interval: must be greater than zero")));
+
+	return schedule_interval;
+}
+
+static void
+policy_remove(Oid table_relid, JobType type, bool if_exists)
+{
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = policy_get_hypertable(hcache, table_relid);
+	BgwJob	   *job = bgw_job_find_by_hypertable_id(ht->fd.id, type);
+
+	if (NULL == job)
+	{
+		if (!if_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_OBJECT),
+					 errmsg("%s policy does not exist for hypertable \"%s\"",
+							bgw_job_type_name(type),
+							get_rel_name(table_relid))));
+
+		ereport(NOTICE,
+				(errmsg("%s policy does not exist for hypertable \"%s\", skipping",
+						bgw_job_type_name(type),
+						get_rel_name(table_relid))));
+	}
+	else
+		bgw_job_delete_by_id(job->fd.id);
+
+	cache_release(hcache);
+}
+
+TS_FUNCTION_INFO_V1(bgw_policy_drop_chunks_add);
+
+/*
+ * Add a retention policy that drops the chunks of a hypertable that are older
+ * than an interval.
+ *
+ * Returns the ID of the policy's job.
+ */
+Datum
+bgw_policy_drop_chunks_add(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_GETARG_OID(0);
+	Interval   *older_than = PG_GETARG_INTERVAL_P(1);
+	bool		cascade = PG_ARGISNULL(2) ? false : PG_GETARG_BOOL(2);
+	bool		if_not_exists = PG_ARGISNULL(4) ? false : PG_GETARG_BOOL(4);
+	Interval   *schedule_interval = policy_schedule_interval(fcinfo, 3);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = policy_get_hypertable(hcache, table_relid);
+	Dimension  *time_dim = hyperspace_get_open_dimension(ht->space, 0);
+	Datum		values[Natts_bgw_policy_drop_chunks];
+	int32		job_id;
+
+	if (NULL == time_dim ||
+		(time_dim->fd.column_type != TIMESTAMPOID &&
+		 time_dim->fd.column_type != TIMESTAMPTZOID &&
+		 time_dim->fd.column_type != DATEOID))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("drop_chunks policies require a time column of type TIMESTAMP, TIMESTAMPTZ, or DATE")));
+
+	if (PG_ARGISNULL(1) || interval_to_usec(older_than) <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid older_than interval: must be greater than zero")));
+
+	job_id = policy_check_exists(ht, JOB_TYPE_DROP_CHUNKS, if_not_exists);
+
+	if (job_id == 0)
+	{
+		job_id = bgw_job_insert(JOB_TYPE_DROP_CHUNKS, ht->fd.id, schedule_interval);
+
+		values[Anum_bgw_policy_drop_chunks_job_id - 1] = Int32GetDatum(job_id);
+		values[Anum_bgw_policy_drop_chunks_older_than - 1] = IntervalPGetDatum(older_than);
+		values[Anum_bgw_policy_drop_chunks_cascade - 1] = BoolGetDatum(cascade);
+		policy_insert(JOB_TYPE_DROP_CHUNKS, values);
+	}
+
+	cache_release(hcache);
+
+	PG_RETURN_INT32(job_id);
+}
+
+TS_FUNCTION_INFO_V1(bgw_policy_drop_chunks_remove);
+
+Datum
+bgw_policy_drop_chunks_remove(PG_FUNCTION_ARGS)
+{
+	policy_remove(PG_GETARG_OID(0), JOB_TYPE_DROP_CHUNKS,
+				  PG_ARGISNULL(1) ? false : PG_GETARG_BOOL(1));
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(bgw_policy_create_chunks_ahead_add);
+
+/*
+ * Add a policy that creates the chunks of a hypertable for the current time
+ * interval and a number of following intervals.
+ *
+ * Returns the ID of the policy's job.
+ */
+Datum
+bgw_policy_create_chunks_ahead_add(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_GETARG_OID(0);
+	int32		num_intervals = PG_ARGISNULL(1) ? 1 : PG_GETARG_INT32(1);
+	bool		if_not_exists = PG_ARGISNULL(3) ? false : PG_GETARG_BOOL(3);
+	Interval   *schedule_interval = policy_schedule_interval(fcinfo, 2);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = policy_get_hypertable(hcache, table_relid);
+	Dimension  *time_dim = hyperspace_get_open_dimension(ht->space, 0);
+	Datum		values[Natts_bgw_policy_create_chunks_ahead];
+	int32		job_id;
+
+	/* The policy creates chunks relative to the current time */
+	if (NULL == time_dim ||
+		(time_dim->fd.column_type != TIMESTAMPOID &&
+		 time_dim->fd.column_type != TIMESTAMPTZOID &&
+		 time_dim->fd.column_type != DATEOID))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("create_chunks_ahead policies require a time column of type TIMESTAMP, TIMESTAMPTZ, or DATE")));
+
+	if (num_intervals < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid number of intervals: must be zero or greater")));
+
+	job_id = policy_check_exists(ht, JOB_TYPE_CREATE_CHUNKS_AHEAD, if_not_exists);
+
+	if (job_id == 0)
+	{
+		job_id = bgw_job_insert(JOB_TYPE_CREATE_CHUNKS_AHEAD, ht->fd.id, schedule_interval);
+
+		values[Anum_bgw_policy_create_chunks_ahead_job_id - 1] = Int32GetDatum(job_id);
+		values[Anum_bgw_policy_create_chunks_ahead_num_intervals - 1] = Int32GetDatum(num_intervals);
+		policy_insert(JOB_TYPE_CREATE_CHUNKS_AHEAD, values);
+	}
+
+	cache_release(hcache);
+
+	PG_RETURN_INT32(job_id);
+}
+
+TS_FUNCTION_INFO_V1(bgw_policy_create_chunks_ahead_remove);
+
+Datum
+bgw_policy_create_chunks_ahead_remove(PG_FUNCTION_ARGS)
+{
+	policy_remove(PG_GETARG_OID(0), JOB_TYPE_CREATE_CHUNKS_AHEAD,
+				  PG_ARGISNULL(1) ? false : PG_GETARG_BOOL(1));
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(bgw_policy_reorder_add);
+
+/*
+ * Add a policy that reorders the chunks of a hypertable that are older than
+ * an interval on the chunks' copy of a hypertable index.
+ *
+ * Returns the ID of the policy's job.
+ */
+Datum
+bgw_policy_reorder_add(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_GETARG_OID(0);
+	Name		index_name = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1);
+	Interval   *older_than = PG_ARGISNULL(2) ? NULL : PG_GETARG_INTERVAL_P(2);
+	bool		if_not_exists = PG_ARGISNULL(4) ? false : PG_GETARG_BOOL(4);
+	Interval   *schedule_interval = policy_schedule_interval(fcinfo, 3);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = policy_get_hypertable(hcache, table_relid);
+	Dimension  *time_dim = hyperspace_get_open_dimension(ht->space, 0);
+	Datum		values[Natts_bgw_policy_reorder];
+	Oid			index_relid = InvalidOid;
+	Relation	index_rel;
+	Oid			relam;
+	int32		job_id;
+
+	if (NULL == time_dim ||
+		(time_dim->fd.column_type != TIMESTAMPOID &&
+		 time_dim->fd.column_type != TIMESTAMPTZOID &&
+		 time_dim->fd.column_type != DATEOID))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("reorder policies require a time column of type TIMESTAMP, TIMESTAMPTZ, or DATE")));
+
+	if (NULL != index_name)
+		index_relid = get_relname_relid(NameStr(*index_name), get_rel_namespace(table_relid));
+
+	if (!OidIsValid(index_relid) || IndexGetRelation(index_relid, true) != table_relid)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid reorder index: \"%s\" is not an index of hypertable \"%s\"",
+						NULL == index_name ? "" : NameStr(*index_name),
+						get_rel_name(table_relid))));
+
+	index_rel = index_open(index_relid, AccessShareLock);
+	relam = index_rel->rd_rel->relam;
+	index_close(index_rel, AccessShareLock);
+
+	if (relam != BTREE_AM_OID)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("invalid reorder index: only B-tree indexes are supported")));
+
+	if (NULL == older_than || interval_to_usec(older_than) < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid older_than interval: must be zero or greater")));
+
+	job_id = policy_check_exists(ht, JOB_TYPE_REORDER, if_not_exists);
+
+	if (job_id == 0)
+	{
+		job_id = bgw_job_insert(JOB_TYPE_REORDER, ht->fd.id, schedule_interval);
+
+		values[Anum_bgw_policy_reorder_job_id - 1] = Int32GetDatum(job_id);
+		values[Anum_bgw_policy_reorder_hypertable_index_name - 1] = NameGetDatum(index_name);
+		values[Anum_bgw_policy_reorder_older_than - 1] = IntervalPGetDatum(older_than);
+		policy_insert(JOB_TYPE_REORDER, values);
+	}
+
+	cache_release(hcache);
+
+	PG_RETURN_INT32(job_id);
+}
+
+TS_FUNCTION_INFO_V1(bgw_policy_reorder_remove);
+
+Datum
+bgw_policy_reorder_remove(PG_FUNCTION_ARGS)
+{
+	policy_remove(PG_GETARG_OID(0), JOB_TYPE_REORDER,
+				  PG_ARGISNULL(1) ? false : PG_GETARG_BOOL(1));
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(bgw_policy_move_chunks_add);
+
+/*
+ * Add a tiering policy that moves the chunks of a hypertable that are older
+ * than an interval to tablespaces that are attached to the hypertable.
+ *
+ * Returns the ID of the policy's job.
+ */
+Datum
+bgw_policy_move_chunks_add(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_GETARG_OID(0);
+	Interval   *older_than = PG_ARGISNULL(1) ? NULL : PG_GETARG_INTERVAL_P(1);
+	Name		tablespace = PG_ARGISNULL(2) ? NULL : PG_GETARG_NAME(2);
+	Name		index_tablespace = PG_ARGISNULL(3) ? tablespace : PG_GETARG_NAME(3);
+	bool		if_not_exists = PG_ARGISNULL(5) ? false : PG_GETARG_BOOL(5);
+	Interval   *schedule_interval = policy_schedule_interval(fcinfo, 4);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = policy_get_hypertable(hcache, table_relid);
+	Dimension  *time_dim = hyperspace_get_open_dimension(ht->space, 0);
+	Datum		values[Natts_bgw_policy_move_chunks];
+	int32		job_id;
+
+	if (NULL == time_dim ||
+		(time_dim->fd.column_type != TIMESTAMPOID &&
+		 time_dim->fd.column_type != TIMESTAMPTZOID &&
+		 time_dim->fd.column_type != DATEOID))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("move_chunks policies require a time column of type TIMESTAMP, TIMESTAMPTZ, or DATE")));
+
+	if (NULL == older_than || interval_to_usec(older_than) < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid older_than interval: must be zero or greater")));
+
+	if (NULL == tablespace)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid tablespace: cannot be NULL")));
+
+	/* Fail early rather than in every run of the job */
+	tablespace_get_attached_oid(ht, NameStr(*tablespace));
+	tablespace_get_attached_oid(ht, NameStr(*index_tablespace));
+
+	job_id = policy_check_exists(ht, JOB_TYPE_MOVE_CHUNKS, if_not_exists);
+
+	if (job_id == 0)
+	{
+		job_id = bgw_job_insert(JOB_TYPE_MOVE_CHUNKS, ht->fd.id, schedule_interval);
+
+		values[Anum_bgw_policy_move_chunks_job_id - 1] = Int32GetDatum(job_id);
+		values[Anum_bgw_policy_move_chunks_older_than - 1] = IntervalPGetDatum(older_than);
+		values[Anum_bgw_policy_move_chunks_tablespace_name - 1] = NameGetDatum(tablespace);
+		values[Anum_bgw_policy_move_chunks_index_tablespace_name - 1] = NameGetDatum(index_tablespace);
+		policy_insert(JOB_TYPE_MOVE_CHUNKS, values);
+	}
+
+	cache_release(hcache);
+
+	PG_RETURN_INT32(job_id);
+}
+
+TS_FUNCTION_INFO_V1(bgw_policy_move_chunks_remove);
+
+Datum
+bgw_policy_move_chunks_remove(PG_FUNCTION_ARGS)
+{
+	policy_remove(PG_GETARG_OID(0), JOB_TYPE_MOVE_CHUNKS,
+				  PG_ARGISNULL(1) ? false : PG_GETARG_BOOL(1));
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(bgw_policy_cold_index_add);
+
+/*
+ * Add a policy that rebuilds the chunks' copy of a hypertable index with
+ * another index access method for the chunks of the hypertable that are older
+ * than an interval.
+ *
+ * Returns the ID of the policy's job.
+ */
+Datum
+bgw_policy_cold_index_add(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_GETARG_OID(0);
+	Name		index_name = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1);
+	Interval   *older_than = PG_ARGISNULL(2) ? NULL : PG_GETARG_INTERVAL_P(2);
+	Name		access_method = PG_ARGISNULL(3) ? NULL : PG_GETARG_NAME(3);
+	bool		if_not_exists = PG_ARGISNULL(5) ? false : PG_GETARG_BOOL(5);
+	Interval   *schedule_interval = policy_schedule_interval(fcinfo, 4);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = policy_get_hypertable(hcache, table_relid);
+	Dimension  *time_dim = hyperspace_get_open_dimension(ht->space, 0);
+	Datum		values[Natts_bgw_policy_cold_index];
+	Oid			index_relid = InvalidOid;
+	Oid			amoid;
+	int32		job_id;
+
+	if (NULL == time_dim ||
+		(time_dim->fd.column_type != TIMESTAMPOID &&
+		 time_dim->fd.column_type != TIMESTAMPTZOID &&
+		 time_dim->fd.column_type != DATEOID))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cold_index policies require a time column of type TIMESTAMP, TIMESTAMPTZ, or DATE")));
+
+	if (NULL != index_name)
+		index_relid = get_relname_relid(NameStr(*index_name), get_rel_namespace(table_relid));
+
+	if (!OidIsValid(index_relid) || IndexGetRelation(index_relid, true) != table_relid)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid cold index: \"%s\" is not an index of hypertable \"%s\"",
+						NULL == index_name ? "" : NameStr(*index_name),
+						get_rel_name(table_relid))));
+
+	if (NULL == older_than || interval_to_usec(older_than) < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid older_than interval: must be zero or greater")));
+
+	if (NULL == access_method)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid access method: cannot be NULL")));
+
+	/* Fail early rather than in every run of the job */
+	amoid = get_index_am_oid(NameStr(*access_method), false);
+	chunk_index_check_access_method(index_relid, amoid);
+
+	job_id = policy_check_exists(ht, JOB_TYPE_COLD_INDEX, if_not_exists);
+
+	if (job_id == 0)
+	{
+		job_id = bgw_job_insert(JOB_TYPE_COLD_INDEX, ht->fd.id, schedule_interval);
+
+		values[Anum_bgw_policy_cold_index_job_id - 1] = Int32GetDatum(job_id);
+		values[Anum_bgw_policy_cold_index_hypertable_index_name - 1] = NameGetDatum(index_name);
+		values[Anum_bgw_policy_cold_index_older_than - 1] = IntervalPGetDatum(older_than);
+		values[Anum_bgw_policy_cold_index_access_method - 1] = NameGetDatum(access_method);
+		policy_insert(JOB_TYPE_COLD_INDEX, values);
+	}
+
+	cache_release(hcache);
+
+	PG_RETURN_INT32(job_id);
+}
+
+TS_FUNCTION_INFO_V1(bgw_policy_cold_index_remove);
+
+Datum
+bgw_policy_cold_index_remove(PG_FUNCTION_ARGS)
+{
+	policy_remove(PG_GETARG_OID(0), JOB_TYPE_COLD_INDEX,
+				  PG_ARGISNULL(1) ? false : PG_GETARG_BOOL(1));
+
+	PG_RETURN_VOID();
+}
@@ -0,0 +1,11 @@
+#ifndef TIMESCALEDB_BGW_POLICY_H
+#define TIMESCALEDB_BGW_POLICY_H
+
+#include <postgres.h>
+
+#include "bgw_job.h"
+
+extern int	bgw_policy_delete(int32 job_id, JobType type);
+extern void bgw_policy_execute(BgwJob *job, Oid table_relid);
+
+#endif							/* TIMESCALEDB_BGW_POLICY_H */
@@ -0,0 +1,413 @@
+#include <postgres.h>
+#include <access/xact.h>
+#include <miscadmin.h>
+#include <pgstat.h>
+#include <postmaster/bgworker.h>
+#include <storage/ipc.h>
+#include <storage/latch.h>
+#include <storage/proc.h>
+#include <utils/guc.h>
+#include <utils/memutils.h>
+#include <utils/snapmgr.h>
+#include <utils/timeout.h>
+#include <utils/timestamp.h>
+
+#include "bgw_job.h"
+#include "bgw_job_stat.h"
+#include "bgw_scheduler.h"
+#include "extension.h"
+#include "guc.h"
+#include "compat.h"
+
+/*
+ * The job scheduler of a database.
+ *
+ * The launcher in the loader library starts a scheduler for each database
+ * (see loader/bgw_launcher.c). The scheduler reads the jobs and their
+ * statistics from the catalog and starts a background worker for each job
+ * that is due, running at most timescaledb.max_concurrent_jobs workers at a
+ * time. It then sleeps until the next job is due or a worker exits, but at
+ * most a minute, so that it picks up new and changed jobs.
+ *
+ * The scheduler records the start of a run before it starts the worker, and
+ * the worker records the end of the run. A worker that exits without
+ * recording the end, e.g., because it crashed or timed out, has its run
+ * recorded as failed by the scheduler.
+ *
+ * The scheduler exits when the extension is dropped or updated, in which
+ * case the launcher starts a new one that loads the new version.
+ */
+
+/* Upper bound on the time between scans of the job catalog */
+#define MAX_SCHEDULER_SLEEP_MS 60000
+
+typedef struct RunningJob
+{
+	BgwJob		job;
+	BackgroundWorkerHandle *handle;
+} RunningJob;
+
+typedef struct DueJob
+{
+	BgwJob		job;
+	TimestampTz next_start;
+} DueJob;
+
+/* Jobs that have a worker. Allocated in the scheduler's memory context */
+static List *running_jobs = NIL;
+static MemoryContext scheduler_mctx = NULL;
+
+static volatile sig_atomic_t got_sighup = false;
+
+static void
+scheduler_sighup(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	got_sighup = true;
+	SetLatch(MyLatch);
+
+	errno = save_errno;
+}
+
+static bool
+scheduler_job_is_running(int32 job_id)
+{
+	ListCell   *lc;
+
+	foreach(lc, running_jobs)
+	{
+		RunningJob *running = lfirst(lc);
+
+		if (running->job.fd.id == job_id)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Forget the workers that have exited. Runs must be recorded in a
+ * transaction.
+ */
+static void
+scheduler_reap_workers(void)
+{
+	ListCell   *lc,
+			   *prev = NULL,
+			   *next;
+
+	for (lc = list_head(running_jobs); lc != NULL; lc = next)
+	{
+		RunningJob *running = lfirst(lc);
+		pid_t		pid;
+
+		next = lnext(lc);
+
+		if (GetBackgroundWorkerPid(running->handle, &pid) != BGWH_STOPPED)
+		{
+			prev = lc;
+			continue;
+		}
+
+		/* Only has an effect if the worker did not record the end */
+		bgw_job_stat_mark_crash_if_running(&running->job);
+
+		running_jobs = list_delete_cell(running_jobs, lc, prev);
+		pfree(running->handle);
+		pfree(running);
+	}
+}
+
+static void
+scheduler_terminate_workers(int code, Datum arg)
+{
+	ListCell   *lc;
+
+	foreach(lc, running_jobs)
+	{
+		RunningJob *running = lfirst(lc);
+
+		TerminateBackgroundWorker(running->handle);
+	}
+}
+
+static bool
+scheduler_start_worker(BgwJob *job)
+{
+	BackgroundWorker worker;
+	BackgroundWorkerHandle *handle;
+	RunningJob *running;
+	MemoryContext old = MemoryContextSwitchTo(scheduler_mctx);
+
+	memset(&worker, 0, sizeof(worker));
+	snprintf(worker.bgw_name, BGW_MAXLEN, "timescaledb job %d", job->fd.id);
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS | BGWORKER_BACKEND_DATABASE_CONNECTION;
+	worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+	worker.bgw_restart_time = BGW_NEVER_RESTART;
+	StrNCpy(worker.bgw_library_name, BGW_LIBRARY_NAME, BGW_MAXLEN);
+	StrNCpy(worker.bgw_function_name, BGW_JOB_WORKER_MAIN, BGW_MAXLEN);
+	worker.bgw_main_arg = Int32GetDatum(job->fd.id);
+	memcpy(worker.bgw_extra, &MyDatabaseId, sizeof(Oid));
+	worker.bgw_notify_pid = MyProcPid;
+
+	if (!RegisterDynamicBackgroundWorker(&worker, &handle))
+	{
+		MemoryContextSwitchTo(old);
+		return false;
+	}
+
+	running = palloc(sizeof(RunningJob));
+	running->job = *job;
+	running->handle = handle;
+	running_jobs = lappend(running_jobs, running);
+
+	MemoryContextSwitchTo(old);
+
+	return true;
+}
+
+static int
+due_job_cmp(const void *left, const void *right)
+{
+	TimestampTz l = ((const DueJob *) left)->next_start;
+	TimestampTz r = ((const DueJob *) right)->next_start;
+
+	if (l < r)
+		return -1;
+	if (l > r)
+		return 1;
+	return 0;
+}
+
+/*
+ * Collect the jobs that are due and not running, ordered by when they were
+ * due. Also sets the time when the next job that is not due yet will be due.
+ *
+ * On the first scan, runs that were in progress when the previous scheduler
+ * exited are recorded as failed.
+ */
+static DueJob *
+scheduler_get_due_jobs(TimestampTz now, bool first_scan, int *num_due,
+					   TimestampTz *next_wakeup)
+{
+	List	   *jobs = bgw_job_get_all();
+	DueJob	   *due = MemoryContextAlloc(scheduler_mctx,
+										 sizeof(DueJob) * Max(list_length(jobs), 1));
+	ListCell   *lc;
+
+	*num_due = 0;
+
+	foreach(lc, jobs)
+	{
+		BgwJob	   *job = lfirst(lc);
+		BgwJobStat *stat;
+
+		if (scheduler_job_is_running(job->fd.id))
+			continue;
+
+		if (first_scan)
+			bgw_job_stat_mark_crash_if_running(job);
+
+		stat = bgw_job_stat_find(job->fd.id);
+
+		if (NULL == stat)
+		{
+			/* Statistics are not dumped, so restored jobs have none */
+			bgw_job_stat_insert(job->fd.id,
+								bgw_job_stat_initial_start(&job->fd.schedule_interval, now));
+			stat = bgw_job_stat_find(job->fd.id);
+		}
+
+		if (stat->fd.next_start <= now)
+		{
+			due[*num_due].job = *job;
+			due[*num_due].next_start = stat->fd.next_start;
+			(*num_due)++;
+		}
+		else if (stat->fd.next_start < *next_wakeup)
+			*next_wakeup = stat->fd.next_start;
+	}
+
+	qsort(due, *num_due, sizeof(DueJob), due_job_cmp);
+
+	return due;
+}
+
+static void
+scheduler_wait(TimestampTz now, TimestampTz next_wakeup)
+{
+	long		secs;
+	int			usecs;
+	long		timeout_ms;
+	int			rc;
+
+	TimestampDifference(now, next_wakeup, &secs, &usecs);
+
+	if (secs >= MAX_SCHEDULER_SLEEP_MS / 1000)
+		timeout_ms = MAX_SCHEDULER_SLEEP_MS;
+	else
+		timeout_ms = secs * 1000 + usecs / 1000;
+
+	rc = WaitLatchCompat(MyLatch,
+						 WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+						 timeout_ms);
+	ResetLatch(MyLatch);
+
+	if (rc & WL_POSTMASTER_DEATH)
+		proc_exit(1);
+}
+
+TS_FUNCTION_INFO_V1(bgw_scheduler_main);
+
+/*
+ * Main loop of the scheduler. Called by the loader in a background worker
+ * that is connected to the scheduler's database and not in a transaction.
+ */
+Datum
+bgw_scheduler_main(PG_FUNCTION_ARGS)
+{
+	bool		first_scan = true;
+
+	pqsignal(SIGHUP, scheduler_sighup);
+
+	scheduler_mctx = AllocSetContextCreate(TopMemoryContext,
+										   "Job scheduler",
+										   ALLOCSET_DEFAULT_SIZES);
+
+	before_shmem_exit(scheduler_terminate_workers, (Datum) 0);
+
+	srandom((unsigned int) (MyProcPid ^ GetCurrentTimestamp()));
+
+	for (;;)
+	{
+		TimestampTz now;
+		TimestampTz next_wakeup = DT_NOEND;
+		DueJob	   *due;
+		int			num_due;
+		int			i;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (got_sighup)
+		{
+			got_sighup = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+
+		StartTransactionCommand();
+		PushActiveSnapshot(GetTransactionSnapshot());
+
+		if (!extension_is_loaded())
+		{
+			PopActiveSnapshot();
+			CommitTransactionCommand();
+			break;
+		}
+
+		now = GetCurrentTimestamp();
+		scheduler_reap_workers();
+		due = scheduler_get_due_jobs(now, first_scan, &num_due, &next_wakeup);
+		first_scan = false;
+
+		PopActiveSnapshot();
+		CommitTransactionCommand();
+
+		for (i = 0; i < num_due && list_length(running_jobs) < guc_max_concurrent_jobs; i++)
+		{
+			BgwJob	   *job = &due[i].job;
+			bool		started;
+
+			StartTransactionCommand();
+			bgw_job_stat_mark_start(job);
+			CommitTransactionCommand();
+
+			started = scheduler_start_worker(job);
+
+			if (!started)
+			{
+				ereport(WARNING,
+						(errcode(ERRCODE_CONFIGURATION_LIMIT_EXCEEDED),
+						 errmsg("could not start a worker for job %d", job->fd.id),
+						 errhint("Consider increasing max_worker_processes.")));
+
+				StartTransactionCommand();
+				bgw_job_stat_mark_end(job, false, true);
+				CommitTransactionCommand();
+				break;
+			}
+		}
+
+		pfree(due);
+
+		/*
+		 * Jobs that are due but wait for a free slot are started when a
+		 * worker exits, which sets the latch
+		 */
+		scheduler_wait(GetCurrentTimestamp(), next_wakeup);
+	}
+
+	proc_exit(0);
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(bgw_job_worker_main);
+
+/*
+ * Run a job in a background worker. Called by the loader in a worker that is
+ * connected to the job's database and not in a transaction.
+ */
+Datum
+bgw_job_worker_main(PG_FUNCTION_ARGS)
+{
+	int32		job_id = PG_GETARG_INT32(0);
+	BgwJob		job;
+	BgwJob	   *found;
+	volatile bool success = false;
+
+	StartTransactionCommand();
+	found = bgw_job_find(job_id, false);
+
+	/* The job was removed after it was started */
+	if (NULL == found)
+	{
+		CommitTransactionCommand();
+		PG_RETURN_VOID();
+	}
+
+	job = *found;
+	CommitTransactionCommand();
+
+	PG_TRY();
+	{
+		int64		timeout_ms = bgw_job_timeout_ms(&job);
+
+		StartTransactionCommand();
+		PushActiveSnapshot(GetTransactionSnapshot());
+
+		/* The maximum run time applies like a statement timeout */
+		if (timeout_ms > 0)
+			enable_timeout_after(STATEMENT_TIMEOUT, (int) Min(timeout_ms, PG_INT32_MAX));
+
+		bgw_job_execute(&job);
+
+		disable_timeout(STATEMENT_TIMEOUT, false);
+		PopActiveSnapshot();
+		CommitTransactionCommand();
+		success = true;
+	}
+	PG_CATCH();
+	{
+		disable_timeout(STATEMENT_TIMEOUT, false);
+		EmitErrorReport();
+		AbortCurrentTransaction();
+		FlushErrorState();
+	}
+	PG_END_TRY();
+
+	StartTransactionCommand();
+	bgw_job_stat_mark_end(&job, success, true);
+	CommitTransactionCommand();
+
+	PG_RETURN_VOID();
+}
@@ -0,0 +1,34 @@
+#ifndef TIMESCALEDB_BGW_SCHEDULER_H
+#define TIMESCALEDB_BGW_SCHEDULER_H
+
+#include <postgres.h>
+#include <fmgr.h>
+
+/*
+ * Entry points of the background workers. The workers start in the loader
+ * library, which loads the versioned library of the database's extension and
+ * calls the functions of the same name without the "ts_" prefix, e.g.,
+ * bgw_scheduler_main().
+ */
+#define BGW_LIBRARY_NAME "timescaledb"
+#define BGW_LAUNCHER_MAIN "ts_bgw_launcher_main"
+#define BGW_SCHEDULER_MAIN "ts_bgw_scheduler_main"
+#define BGW_JOB_WORKER_MAIN "ts_bgw_job_worker_main"
+#define BGW_MAINTENANCE_WORKER_MAIN "ts_bgw_maintenance_worker_main"
+
+/*
+ * The extra data of a maintenance worker: the database and user to connect
+ * as, and the dynamic shared memory segment with the chunks to process.
+ */
+typedef struct BgwMaintenanceWorkerArgs
+{
+	Oid			dboid;
+	Oid			userid;
+	uint32		dsm_handle;
+} BgwMaintenanceWorkerArgs;
+
+PGDLLEXPORT Datum bgw_scheduler_main(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum bgw_job_worker_main(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum bgw_maintenance_worker_main(PG_FUNCTION_ARGS);
+
+#endif							/* TIMESCALEDB_BGW_SCHEDULER_H */
@@ -187,7 +187,10 @@ cache_remove(Cache *cache, void *key)
 	hash_search(cache->htab, key, HASH_REMOVE, &found);
 
 	if (found)
+	{
 		cache->stats.numelements--;
+		cache->stats.evictions++;
+	}
 
 	return found;
 }
@@ -10,6 +10,7 @@
 #include "compat.h"
 #include "extension.h"
 #include "hypertable_cache.h"
+#include "chunk_insert_state.h"
 
 /*
  * Notes on the way cache invalidation works.
@@ -37,6 +38,15 @@
  * (e.g., when replacing a negative hypertable entry with a positive one). Note,
  * also, that INSERTS can taint the cache if the transaction that did the INSERT
  * fails. This is why we also need to invalidate caches on transaction failure.
+ *
+ * Changes that only affect a single hypertable are signaled via a relcache
+ * invalidation of the hypertable's main table instead of the proxy table. On
+ * receiving such an event, only that hypertable is evicted from the cache, so
+ * that, e.g., dropping chunks from one hypertable does not force all backends
+ * to rebuild the cache entries of every other hypertable.
+ *
+ * Relcache invalidations of chunks evict the chunk's cached insert state,
+ * e.g., its planned CHECK constraints.
  */
 
 void		_cache_invalidate_init(void);
@@ -46,6 +56,7 @@ static void
 cache_invalidate_all(void)
 {
 	hypertable_cache_invalidate_callback();
+	chunk_insert_state_cache_invalidate(InvalidOid);
 }
 
 /*
@@ -66,10 +77,22 @@ cache_invalidate_callback(Datum arg, Oid relid)
 	if (!extension_is_loaded())
 		return;
 
+	/* An invalid OID means that all relcache entries are invalidated */
+	if (!OidIsValid(relid))
+	{
+		cache_invalidate_all();
+		return;
+	}
+
 	catalog = catalog_get();
 
 	if (relid == catalog_get_cache_proxy_id(catalog, CACHE_TYPE_HYPERTABLE))
 		hypertable_cache_invalidate_callback();
+	else
+	{
+		hypertable_cache_invalidate_entry(relid);
+		chunk_insert_state_cache_invalidate(relid);
+	}
 }
 
 TS_FUNCTION_INFO_V1(timescaledb_invalidate_cache);
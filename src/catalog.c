@@ -16,6 +16,8 @@
 #include "compat.h"
 #include "catalog.h"
 #include "extension.h"
+#include "hypertable.h"
+#include "scanner.h"
 
 #if PG10
 #include <utils/regproc.h>
@@ -29,6 +31,21 @@ static const char *catalog_table_names[_MAX_CATALOG_TABLES + 1] = {
 	[CHUNK_CONSTRAINT] = CHUNK_CONSTRAINT_TABLE_NAME,
 	[CHUNK_INDEX] = CHUNK_INDEX_TABLE_NAME,
 	[TABLESPACE] = TABLESPACE_TABLE_NAME,
+	[BGW_JOB] = BGW_JOB_TABLE_NAME,
+	[BGW_JOB_STAT] = BGW_JOB_STAT_TABLE_NAME,
+	[BGW_POLICY_DROP_CHUNKS] = BGW_POLICY_DROP_CHUNKS_TABLE_NAME,
+	[BGW_POLICY_CREATE_CHUNKS_AHEAD] = BGW_POLICY_CREATE_CHUNKS_AHEAD_TABLE_NAME,
+	[BGW_POLICY_REORDER] = BGW_POLICY_REORDER_TABLE_NAME,
+	[COMPRESSED_CHUNK] = COMPRESSED_CHUNK_TABLE_NAME,
+	[BGW_POLICY_MOVE_CHUNKS] = BGW_POLICY_MOVE_CHUNKS_TABLE_NAME,
+	[CHUNK_SIZING] = CHUNK_SIZING_TABLE_NAME,
+	[CONTINUOUS_AGG] = CONTINUOUS_AGG_TABLE_NAME,
+	[CONTINUOUS_AGGS_INVALIDATION_LOG] = CONTINUOUS_AGGS_INVALIDATION_LOG_TABLE_NAME,
+	[CHUNK_TIME_RANGE] = CHUNK_TIME_RANGE_TABLE_NAME,
+	[HYPERTABLE_BLOOM_COLUMN] = HYPERTABLE_BLOOM_COLUMN_TABLE_NAME,
+	[CHUNK_BLOOM_FILTER] = CHUNK_BLOOM_FILTER_TABLE_NAME,
+	[BGW_POLICY_COLD_INDEX] = BGW_POLICY_COLD_INDEX_TABLE_NAME,
+	[HYPERTABLE_DATA_NODE] = HYPERTABLE_DATA_NODE_TABLE_NAME,
 	[_MAX_CATALOG_TABLES] = "invalid table",
 };
 
@@ -88,6 +105,100 @@ static const TableIndexDef catalog_table_index_definitions[_MAX_CATALOG_TABLES]
 			[TABLESPACE_PKEY_IDX] = "tablespace_pkey",
 			[TABLESPACE_HYPERTABLE_ID_TABLESPACE_NAME_IDX] = "tablespace_hypertable_id_tablespace_name_key",
 		}
+	},
+	[BGW_JOB] = {
+		.length = _MAX_BGW_JOB_INDEX,
+		.names = (char *[]) {
+			[BGW_JOB_PKEY_IDX] = "bgw_job_pkey",
+			[BGW_JOB_HYPERTABLE_ID_JOB_TYPE_IDX] = "bgw_job_hypertable_id_job_type_key",
+		}
+	},
+	[BGW_JOB_STAT] = {
+		.length = _MAX_BGW_JOB_STAT_INDEX,
+		.names = (char *[]) {
+			[BGW_JOB_STAT_PKEY_IDX] = "bgw_job_stat_pkey",
+		}
+	},
+	[BGW_POLICY_DROP_CHUNKS] = {
+		.length = _MAX_BGW_POLICY_DROP_CHUNKS_INDEX,
+		.names = (char *[]) {
+			[BGW_POLICY_DROP_CHUNKS_PKEY_IDX] = "bgw_policy_drop_chunks_pkey",
+		}
+	},
+	[BGW_POLICY_CREATE_CHUNKS_AHEAD] = {
+		.length = _MAX_BGW_POLICY_CREATE_CHUNKS_AHEAD_INDEX,
+		.names = (char *[]) {
+			[BGW_POLICY_CREATE_CHUNKS_AHEAD_PKEY_IDX] = "bgw_policy_create_chunks_ahead_pkey",
+		}
+	},
+	[BGW_POLICY_REORDER] = {
+		.length = _MAX_BGW_POLICY_REORDER_INDEX,
+		.names = (char *[]) {
+			[BGW_POLICY_REORDER_PKEY_IDX] = "bgw_policy_reorder_pkey",
+		}
+	},
+	[COMPRESSED_CHUNK] = {
+		.length = _MAX_COMPRESSED_CHUNK_INDEX,
+		.names = (char *[]) {
+			[COMPRESSED_CHUNK_PKEY_IDX] = "compressed_chunk_pkey",
+			[COMPRESSED_CHUNK_HYPERTABLE_ID_IDX] = "compressed_chunk_hypertable_id_idx",
+		}
+	},
+	[BGW_POLICY_MOVE_CHUNKS] = {
+		.length = _MAX_BGW_POLICY_MOVE_CHUNKS_INDEX,
+		.names = (char *[]) {
+			[BGW_POLICY_MOVE_CHUNKS_PKEY_IDX] = "bgw_policy_move_chunks_pkey",
+		}
+	},
+	[CHUNK_SIZING] = {
+		.length = _MAX_CHUNK_SIZING_INDEX,
+		.names = (char *[]) {
+			[CHUNK_SIZING_PKEY_IDX] = "chunk_sizing_pkey",
+		}
+	},
+	[CONTINUOUS_AGG] = {
+		.length = _MAX_CONTINUOUS_AGG_INDEX,
+		.names = (char *[]) {
+			[CONTINUOUS_AGG_PKEY_IDX] = "continuous_agg_pkey",
+			[CONTINUOUS_AGG_USER_VIEW_SCHEMA_USER_VIEW_NAME_IDX] = "continuous_agg_user_view_schema_user_view_name_key",
+			[CONTINUOUS_AGG_RAW_HYPERTABLE_ID_IDX] = "continuous_agg_raw_hypertable_id_idx",
+		}
+	},
+	[CONTINUOUS_AGGS_INVALIDATION_LOG] = {
+		.length = _MAX_CONTINUOUS_AGGS_INVALIDATION_LOG_INDEX,
+		.names = (char *[]) {
+			[CONTINUOUS_AGGS_INVALIDATION_LOG_HYPERTABLE_ID_IDX] = "continuous_aggs_invalidation_log_hypertable_id_idx",
+		}
+	},
+	[CHUNK_TIME_RANGE] = {
+		.length = _MAX_CHUNK_TIME_RANGE_INDEX,
+		.names = (char *[]) {
+			[CHUNK_TIME_RANGE_PKEY_IDX] = "chunk_time_range_pkey",
+		}
+	},
+	[HYPERTABLE_BLOOM_COLUMN] = {
+		.length = _MAX_HYPERTABLE_BLOOM_COLUMN_INDEX,
+		.names = (char *[]) {
+			[HYPERTABLE_BLOOM_COLUMN_PKEY_IDX] = "hypertable_bloom_column_pkey",
+		}
+	},
+	[CHUNK_BLOOM_FILTER] = {
+		.length = _MAX_CHUNK_BLOOM_FILTER_INDEX,
+		.names = (char *[]) {
+			[CHUNK_BLOOM_FILTER_PKEY_IDX] = "chunk_bloom_filter_pkey",
+		}
+	},
+	[BGW_POLICY_COLD_INDEX] = {
+		.length = _MAX_BGW_POLICY_COLD_INDEX_INDEX,
+		.names = (char *[]) {
+			[BGW_POLICY_COLD_INDEX_PKEY_IDX] = "bgw_policy_cold_index_pkey",
+		}
+	},
+	[HYPERTABLE_DATA_NODE] = {
+		.length = _MAX_HYPERTABLE_DATA_NODE_INDEX,
+		.names = (char *[]) {
+			[HYPERTABLE_DATA_NODE_PKEY_IDX] = "hypertable_data_node_pkey",
+		}
 	}
 };
 
@@ -99,6 +210,21 @@ static const char *catalog_table_serial_id_names[_MAX_CATALOG_TABLES] = {
 	[CHUNK_CONSTRAINT] = CATALOG_SCHEMA_NAME ".chunk_constraint_name",
 	[CHUNK_INDEX] = NULL,
 	[TABLESPACE] = CATALOG_SCHEMA_NAME ".tablespace_id_seq",
+	[BGW_JOB] = CATALOG_SCHEMA_NAME ".bgw_job_id_seq",
+	[BGW_JOB_STAT] = NULL,
+	[BGW_POLICY_DROP_CHUNKS] = NULL,
+	[BGW_POLICY_CREATE_CHUNKS_AHEAD] = NULL,
+	[BGW_POLICY_REORDER] = NULL,
+	[COMPRESSED_CHUNK] = NULL,
+	[BGW_POLICY_MOVE_CHUNKS] = NULL,
+	[CHUNK_SIZING] = NULL,
+	[CONTINUOUS_AGG] = NULL,
+	[CONTINUOUS_AGGS_INVALIDATION_LOG] = NULL,
+	[CHUNK_TIME_RANGE] = NULL,
+	[HYPERTABLE_BLOOM_COLUMN] = NULL,
+	[CHUNK_BLOOM_FILTER] = NULL,
+	[BGW_POLICY_COLD_INDEX] = NULL,
+	[HYPERTABLE_DATA_NODE] = NULL,
 };
 
 typedef struct InternalFunctionDef
@@ -180,47 +306,7 @@ catalog_get(void)
 		elog(ERROR, "Oid lookup failed for schema %s", CATALOG_SCHEMA_NAME);
 
 	for (i = 0; i < _MAX_CATALOG_TABLES; i++)
-	{
-		Oid			id;
-		const char *sequence_name;
-		Size		number_indexes,
-					j;
-
-		id = get_relname_relid(catalog_table_names[i], catalog.schema_id);
-
-		if (id == InvalidOid)
-			elog(ERROR, "Oid lookup failed for table %s", catalog_table_names[i]);
-
-		catalog.tables[i].id = id;
-
-		number_indexes = catalog_table_index_definitions[i].length;
-		Assert(number_indexes <= _MAX_TABLE_INDEXES);
-
-		for (j = 0; j < number_indexes; j++)
-		{
-			id = get_relname_relid(catalog_table_index_definitions[i].names[j],
-								   catalog.schema_id);
-
-			if (id == InvalidOid)
-				elog(ERROR, "Oid lookup failed for table index %s",
-					 catalog_table_index_definitions[i].names[j]);
-
-			catalog.tables[i].index_ids[j] = id;
-		}
-
 		catalog.tables[i].name = catalog_table_names[i];
-		sequence_name = catalog_table_serial_id_names[i];
-
-		if (NULL != sequence_name)
-		{
-			RangeVar   *sequence;
-
-			sequence = makeRangeVarFromNameList(stringToQualifiedNameList(sequence_name));
-			catalog.tables[i].serial_relid = RangeVarGetRelid(sequence, NoLock, false);
-		}
-		else
-			catalog.tables[i].serial_relid = InvalidOid;
-	}
 
 	catalog.cache_schema_id = get_namespace_oid(CACHE_SCHEMA_NAME, false);
 
@@ -230,21 +316,6 @@ catalog_get(void)
 
 	catalog.internal_schema_id = get_namespace_oid(INTERNAL_SCHEMA_NAME, false);
 
-	for (i = 0; i < _MAX_INTERNAL_FUNCTIONS; i++)
-	{
-		InternalFunctionDef def = internal_function_definitions[i];
-		FuncCandidateList funclist =
-		FuncnameGetCandidates(list_make2(makeString(INTERNAL_SCHEMA_NAME),
-										 makeString(def.name)),
-							  def.args, NULL, false, false, false);
-
-		if (funclist == NULL || funclist->next)
-			elog(ERROR, "Oid lookup failed for the function %s with %d args", def.name, def.args);
-
-		catalog.functions[i].function_id = funclist->oid;
-	}
-
-
 	return &catalog;
 }
 
@@ -283,6 +354,21 @@ catalog_get_cache_proxy_id(Catalog *catalog, CacheType type)
 Oid
 catalog_get_internal_function_id(Catalog *catalog, InternalFunction func)
 {
+	if (!catalog->functions[func].resolved)
+	{
+		InternalFunctionDef def = internal_function_definitions[func];
+		FuncCandidateList funclist =
+		FuncnameGetCandidates(list_make2(makeString(INTERNAL_SCHEMA_NAME),
+										 makeString(def.name)),
+							  def.args, NULL, false, false, false);
+
+		if (funclist == NULL || funclist->next)
+			elog(ERROR, "Oid lookup failed for the function %s with %d args", def.name, def.args);
+
+		catalog->functions[func].function_id = funclist->oid;
+		catalog->functions[func].resolved = true;
+	}
+
 	return catalog->functions[func].function_id;
 }
 
@@ -322,12 +408,81 @@ catalog_restore_user(CatalogSecurityContext *sec_ctx)
 	SetUserIdAndSecContext(sec_ctx->saved_uid, sec_ctx->saved_security_context);
 }
 
+/*
+ * Resolve the OIDs of a catalog table, its indexes, and its serial sequence.
+ *
+ * This is done the first time a table is accessed rather than when the catalog
+ * is initialized, so that a backend only pays for the lookups of the tables it
+ * actually uses.
+ */
+static void
+catalog_table_resolve(Catalog *catalog, CatalogTable table)
+{
+	const char *sequence_name;
+	Size		number_indexes,
+				i;
+	Oid			id;
+
+	Assert(catalog_is_valid(catalog));
+
+	id = get_relname_relid(catalog_table_names[table], catalog->schema_id);
+
+	if (id == InvalidOid)
+		elog(ERROR, "Oid lookup failed for table %s", catalog_table_names[table]);
+
+	catalog->tables[table].id = id;
+
+	number_indexes = catalog_table_index_definitions[table].length;
+	Assert(number_indexes <= _MAX_TABLE_INDEXES);
+
+	for (i = 0; i < number_indexes; i++)
+	{
+		id = get_relname_relid(catalog_table_index_definitions[table].names[i],
+							   catalog->schema_id);
+
+		if (id == InvalidOid)
+			elog(ERROR, "Oid lookup failed for table index %s",
+				 catalog_table_index_definitions[table].names[i]);
+
+		catalog->tables[table].index_ids[i] = id;
+	}
+
+	sequence_name = catalog_table_serial_id_names[table];
+
+	if (NULL != sequence_name)
+	{
+		RangeVar   *sequence;
+
+		sequence = makeRangeVarFromNameList(stringToQualifiedNameList(sequence_name));
+		catalog->tables[table].serial_relid = RangeVarGetRelid(sequence, NoLock, false);
+	}
+	else
+		catalog->tables[table].serial_relid = InvalidOid;
+
+	catalog->tables[table].resolved = true;
+}
+
+#define catalog_table_ensure_resolved(catalog, table)	\
+	do {												\
+		if (!(catalog)->tables[table].resolved)			\
+			catalog_table_resolve(catalog, table);		\
+	} while (0)
+
 Oid
 catalog_table_get_id(Catalog *catalog, CatalogTable table)
 {
+	catalog_table_ensure_resolved(catalog, table);
 	return catalog->tables[table].id;
 }
 
+Oid
+catalog_table_get_index_id(Catalog *catalog, CatalogTable table, int indexid)
+{
+	Assert(indexid >= 0 && indexid < catalog_table_index_definitions[table].length);
+	catalog_table_ensure_resolved(catalog, table);
+	return catalog->tables[table].index_ids[indexid];
+}
+
 CatalogTable
 catalog_table_get(Catalog *catalog, Oid relid)
 {
@@ -345,9 +500,28 @@ catalog_table_get(Catalog *catalog, Oid relid)
 	}
 
 	for (i = 0; i < _MAX_CATALOG_TABLES; i++)
-		if (catalog->tables[i].id == relid)
+		if (catalog->tables[i].resolved && catalog->tables[i].id == relid)
 			return (CatalogTable) i;
 
+	/*
+	 * The table might not have been resolved yet. Fall back to a name lookup
+	 * in the catalog schema so that we do not need to resolve all tables.
+	 */
+	if (get_rel_namespace(relid) == catalog->schema_id)
+	{
+		const char *relname = get_rel_name(relid);
+
+		for (i = 0; i < _MAX_CATALOG_TABLES; i++)
+			if (!catalog->tables[i].resolved &&
+				strcmp(catalog_table_names[i], relname) == 0)
+			{
+				catalog_table_resolve(catalog, (CatalogTable) i);
+
+				if (catalog->tables[i].id == relid)
+					return (CatalogTable) i;
+			}
+	}
+
 	return INVALID_CATALOG_TABLE;
 }
 
@@ -363,7 +537,10 @@ catalog_table_name(CatalogTable table)
 int64
 catalog_table_next_seq_id(Catalog *catalog, CatalogTable table)
 {
-	Oid			relid = catalog->tables[table].serial_relid;
+	Oid			relid;
+
+	catalog_table_ensure_resolved(catalog, table);
+	relid = catalog->tables[table].serial_relid;
 
 	if (!OidIsValid(relid))
 		elog(ERROR, "No serial id column for table %s", catalog_table_names[table]);
@@ -371,24 +548,6 @@ catalog_table_next_seq_id(Catalog *catalog, CatalogTable table)
 	return DatumGetInt64(DirectFunctionCall1(nextval_oid, ObjectIdGetDatum(relid)));
 }
 
-#if PG96
-#define CatalogTupleInsert(relation, tuple)		\
-	do {										\
-		simple_heap_insert(relation, tuple);	\
-		CatalogUpdateIndexes(relation, tuple);	\
-	} while (0);
-
-#define CatalogTupleUpdate(relation, tid, tuple)	\
-	do {											\
-		simple_heap_update(relation, tid, tuple);	\
-		CatalogUpdateIndexes(relation, tuple);		\
-	} while (0);
-
-#define CatalogTupleDelete(relation, tid)		\
-	simple_heap_delete(relation, tid);
-
-#endif							/* PG96 */
-
 /*
  * Insert a new row into a catalog table.
  */
@@ -396,7 +555,7 @@ void
 catalog_insert(Relation rel, HeapTuple tuple)
 {
 	CatalogTupleInsert(rel, tuple);
-	catalog_invalidate_cache(RelationGetRelid(rel), CMD_INSERT);
+	catalog_invalidate_cache_for_tuple(rel, tuple, CMD_INSERT);
 	/* Make changes visible */
 	CommandCounterIncrement();
 }
@@ -413,11 +572,28 @@ catalog_insert_values(Relation rel, TupleDesc tupdesc, Datum *values, bool *null
 	heap_freetuple(tuple);
 }
 
+/*
+ * Insert a new row into a catalog table, using indexes that the caller opened
+ * with CatalogOpenIndexes(). The row is not made visible, so that the caller
+ * can insert several rows and make them visible with a single
+ * CommandCounterIncrement().
+ */
+void
+catalog_insert_values_with_info(Relation rel, CatalogIndexState indstate, TupleDesc tupdesc,
+								Datum *values, bool *nulls)
+{
+	HeapTuple	tuple = heap_form_tuple(tupdesc, values, nulls);
+
+	CatalogTupleInsertWithInfo(rel, tuple, indstate);
+	catalog_invalidate_cache_for_tuple(rel, tuple, CMD_INSERT);
+	heap_freetuple(tuple);
+}
+
 void
 catalog_update_tid(Relation rel, ItemPointer tid, HeapTuple tuple)
 {
 	CatalogTupleUpdate(rel, tid, tuple);
-	catalog_invalidate_cache(RelationGetRelid(rel), CMD_UPDATE);
+	catalog_invalidate_cache_for_tuple(rel, tuple, CMD_UPDATE);
 	/* Make changes visible */
 	CommandCounterIncrement();
 }
@@ -439,7 +615,9 @@ catalog_delete_tid(Relation rel, ItemPointer tid)
 void
 catalog_delete(Relation rel, HeapTuple tuple)
 {
-	catalog_delete_tid(rel, &tuple->t_self);
+	CatalogTupleDelete(rel, &tuple->t_self);
+	catalog_invalidate_cache_for_tuple(rel, tuple, CMD_DELETE);
+	CommandCounterIncrement();
 }
 
 void
@@ -448,6 +626,47 @@ catalog_delete_only(Relation rel, HeapTuple tuple)
 	CatalogTupleDelete(rel, &tuple->t_self);
 }
 
+typedef struct CatalogLookup
+{
+	AttrNumber	attno;
+	int32		value;
+} CatalogLookup;
+
+/*
+ * Check if a change to a catalog table can make cached hypertables stale.
+ */
+static bool
+catalog_table_needs_invalidation(CatalogTable table, CmdType operation)
+{
+	switch (table)
+	{
+		case CHUNK:
+		case CHUNK_CONSTRAINT:
+		case DIMENSION_SLICE:
+			/* New chunks are found in the catalog on cache misses */
+			return operation == CMD_UPDATE || operation == CMD_DELETE;
+		case HYPERTABLE:
+		case DIMENSION:
+		case COMPRESSED_CHUNK:
+		case CHUNK_SIZING:
+		case CONTINUOUS_AGG:
+		case HYPERTABLE_BLOOM_COLUMN:
+		case TABLESPACE:
+			return true;
+		case CHUNK_INDEX:
+		default:
+			return false;
+	}
+}
+
+static void
+catalog_invalidate_all_hypertables(Catalog *catalog)
+{
+	Oid			relid = catalog_get_cache_proxy_id(catalog, CACHE_TYPE_HYPERTABLE);
+
+	CacheInvalidateRelcacheByRelid(relid);
+}
+
 /*
  * Invalidate TimescaleDB catalog caches.
  *
@@ -475,26 +694,150 @@ catalog_invalidate_cache(Oid catalog_relid, CmdType operation)
 {
 	Catalog    *catalog = catalog_get();
 	CatalogTable table = catalog_table_get(catalog, catalog_relid);
-	Oid			relid;
+
+	if (catalog_table_needs_invalidation(table, operation))
+		catalog_invalidate_all_hypertables(catalog);
+}
+
+static bool
+catalog_tuple_get_int32(TupleInfo *ti, void *data)
+{
+	CatalogLookup *lookup = data;
+	bool		isnull;
+	Datum		value = heap_getattr(ti->tuple, lookup->attno, ti->desc, &isnull);
+
+	if (!isnull)
+		lookup->value = DatumGetInt32(value);
+
+	return false;
+}
+
+/*
+ * Look up an integer attribute of the catalog tuple with the given ID.
+ *
+ * Returns zero if there is no such tuple.
+ */
+static int32
+catalog_lookup_by_id(Catalog *catalog, CatalogTable table, int indexid, int32 id, AttrNumber attno)
+{
+	ScanKeyData scankey[1];
+	CatalogLookup lookup = {
+		.attno = attno,
+		.value = 0,
+	};
+	ScannerCtx	scanctx = {
+		.table = catalog_table_get_id(catalog, table),
+		.index = CATALOG_INDEX(catalog, table, indexid),
+		.nkeys = 1,
+		.scankey = scankey,
+		.tuple_found = catalog_tuple_get_int32,
+		.data = &lookup,
+		.lockmode = AccessShareLock,
+		.scandirection = ForwardScanDirection,
+	};
+
+	/* All the ID indexes have the ID as their first and only attribute */
+	ScanKeyInit(&scankey[0], 1, BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(id));
+	scanner_scan(&scanctx);
+
+	return lookup.value;
+}
+
+/*
+ * Get the main table of the hypertable that a catalog tuple belongs to.
+ *
+ * Returns InvalidOid if the hypertable cannot be determined, e.g., because the
+ * tuple is not associated with a single hypertable or the hypertable's table is
+ * already gone.
+ */
+static Oid
+catalog_tuple_get_hypertable_relid(Catalog *catalog, CatalogTable table, HeapTuple tuple)
+{
+	int32		hypertable_id = 0;
 
 	switch (table)
 	{
+		case HYPERTABLE:
+			{
+				Form_hypertable form = (Form_hypertable) GETSTRUCT(tuple);
+				Oid			schema_oid = get_namespace_oid(NameStr(form->schema_name), true);
+
+				if (!OidIsValid(schema_oid))
+					return InvalidOid;
+
+				return get_relname_relid(NameStr(form->table_name), schema_oid);
+			}
+		case DIMENSION:
+			hypertable_id = ((Form_dimension) GETSTRUCT(tuple))->hypertable_id;
+			break;
+		case DIMENSION_SLICE:
+			{
+				int32		dimension_id = ((Form_dimension_slice) GETSTRUCT(tuple))->dimension_id;
+
+				hypertable_id = catalog_lookup_by_id(catalog, DIMENSION, DIMENSION_ID_IDX,
+													 dimension_id, Anum_dimension_hypertable_id);
+				break;
+			}
 		case CHUNK:
+			hypertable_id = ((Form_chunk) GETSTRUCT(tuple))->hypertable_id;
+			break;
 		case CHUNK_CONSTRAINT:
-		case DIMENSION_SLICE:
-			if (operation == CMD_UPDATE || operation == CMD_DELETE)
 			{
-				relid = catalog_get_cache_proxy_id(catalog, CACHE_TYPE_HYPERTABLE);
-				CacheInvalidateRelcacheByRelid(relid);
+				int32		chunk_id = ((Form_chunk_constraint) GETSTRUCT(tuple))->chunk_id;
+
+				hypertable_id = catalog_lookup_by_id(catalog, CHUNK, CHUNK_ID_INDEX,
+													 chunk_id, Anum_chunk_hypertable_id);
+				break;
 			}
+		case COMPRESSED_CHUNK:
+			hypertable_id = ((Form_compressed_chunk) GETSTRUCT(tuple))->hypertable_id;
 			break;
-		case HYPERTABLE:
-		case DIMENSION:
-			relid = catalog_get_cache_proxy_id(catalog, CACHE_TYPE_HYPERTABLE);
-			CacheInvalidateRelcacheByRelid(relid);
+		case CHUNK_SIZING:
+			hypertable_id = ((Form_chunk_sizing) GETSTRUCT(tuple))->hypertable_id;
+			break;
+		case CONTINUOUS_AGG:
+			/* Only the raw hypertable tracks its continuous aggregates */
+			hypertable_id = ((Form_continuous_agg) GETSTRUCT(tuple))->raw_hypertable_id;
+			break;
+		case HYPERTABLE_BLOOM_COLUMN:
+			hypertable_id = ((Form_hypertable_bloom_column) GETSTRUCT(tuple))->hypertable_id;
+			break;
+		case TABLESPACE:
+			hypertable_id = ((Form_tablespace) GETSTRUCT(tuple))->hypertable_id;
 			break;
-		case CHUNK_INDEX:
 		default:
 			break;
 	}
+
+	if (hypertable_id <= 0)
+		return InvalidOid;
+
+	return hypertable_id_to_relid(hypertable_id);
+}
+
+/*
+ * Invalidate the caches affected by a change to a catalog tuple.
+ *
+ * Rather than invalidating the caches of all hypertables, this signals a
+ * relcache invalidation on the main table of the hypertable that the tuple
+ * belongs to. Backends then only evict that hypertable from their caches (see
+ * cache_invalidate.c). If the hypertable cannot be determined, fall back to
+ * invalidating all hypertables.
+ */
+void
+catalog_invalidate_cache_for_tuple(Relation rel, HeapTuple tuple, CmdType operation)
+{
+	Catalog    *catalog = catalog_get();
+	CatalogTable table = catalog_table_get(catalog, RelationGetRelid(rel));
+	Oid			relid;
+
+	if (!catalog_table_needs_invalidation(table, operation))
+		return;
+
+	relid = catalog_tuple_get_hypertable_relid(catalog, table, tuple);
+
+	if (OidIsValid(relid))
+		CacheInvalidateRelcacheByRelid(relid);
+	else
+		catalog_invalidate_all_hypertables(catalog);
 }
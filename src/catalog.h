@@ -6,6 +6,8 @@
 #include <utils/rel.h>
 #include <nodes/nodes.h>
 #include <access/heapam.h>
+#include <catalog/indexing.h>
+#include <utils/timestamp.h>
 /*
  * TimescaleDB catalog.
  *
@@ -30,6 +32,21 @@ typedef enum CatalogTable
 	CHUNK_CONSTRAINT,
 	CHUNK_INDEX,
 	TABLESPACE,
+	BGW_JOB,
+	BGW_JOB_STAT,
+	BGW_POLICY_DROP_CHUNKS,
+	BGW_POLICY_CREATE_CHUNKS_AHEAD,
+	BGW_POLICY_REORDER,
+	COMPRESSED_CHUNK,
+	BGW_POLICY_MOVE_CHUNKS,
+	CHUNK_SIZING,
+	CONTINUOUS_AGG,
+	CONTINUOUS_AGGS_INVALIDATION_LOG,
+	CHUNK_TIME_RANGE,
+	HYPERTABLE_BLOOM_COLUMN,
+	CHUNK_BLOOM_FILTER,
+	BGW_POLICY_COLD_INDEX,
+	HYPERTABLE_DATA_NODE,
 	_MAX_CATALOG_TABLES,
 } CatalogTable;
 
@@ -37,7 +54,7 @@ typedef enum CatalogTable
 #define INVALID_INDEXID -1
 
 #define CATALOG_INDEX(catalog, tableid, indexid) \
-	(indexid == INVALID_INDEXID ? InvalidOid : (catalog)->tables[tableid].index_ids[indexid])
+	(indexid == INVALID_INDEXID ? InvalidOid : catalog_table_get_index_id(catalog, tableid, indexid))
 
 #define CatalogInternalCall1(func, datum1) \
 	OidFunctionCall1(catalog_get_internal_function_id(catalog_get(), func), datum1)
@@ -463,6 +480,585 @@ typedef struct FormData_tablespace_hypertable_id_tablespace_name_idx
 }			FormData_tablespace_hypertable_id_tablespace_name_idx;
 
 
+/************************************
+ *
+ * Background job table definitions
+ *
+ ************************************/
+
+#define BGW_JOB_TABLE_NAME "bgw_job"
+
+enum Anum_bgw_job
+{
+	Anum_bgw_job_id = 1,
+	Anum_bgw_job_job_type,
+	Anum_bgw_job_hypertable_id,
+	Anum_bgw_job_schedule_interval,
+	Anum_bgw_job_max_runtime,
+	Anum_bgw_job_max_retries,
+	Anum_bgw_job_retry_period,
+	_Anum_bgw_job_max,
+};
+
+#define Natts_bgw_job \
+	(_Anum_bgw_job_max - 1)
+
+typedef struct FormData_bgw_job
+{
+	int32		id;
+	NameData	job_type;
+	int32		hypertable_id;
+	Interval	schedule_interval;
+	Interval	max_runtime;
+	int32		max_retries;
+	Interval	retry_period;
+} FormData_bgw_job;
+
+typedef FormData_bgw_job *Form_bgw_job;
+
+enum
+{
+	BGW_JOB_PKEY_IDX = 0,
+	BGW_JOB_HYPERTABLE_ID_JOB_TYPE_IDX,
+	_MAX_BGW_JOB_INDEX,
+};
+
+enum Anum_bgw_job_pkey_idx
+{
+	Anum_bgw_job_pkey_idx_id = 1,
+	_Anum_bgw_job_pkey_idx_max,
+};
+
+enum Anum_bgw_job_hypertable_id_job_type_idx
+{
+	Anum_bgw_job_hypertable_id_job_type_idx_hypertable_id = 1,
+	Anum_bgw_job_hypertable_id_job_type_idx_job_type,
+	_Anum_bgw_job_hypertable_id_job_type_idx_max,
+};
+
+#define BGW_JOB_STAT_TABLE_NAME "bgw_job_stat"
+
+enum Anum_bgw_job_stat
+{
+	Anum_bgw_job_stat_job_id = 1,
+	Anum_bgw_job_stat_last_start,
+	Anum_bgw_job_stat_last_finish,
+	Anum_bgw_job_stat_next_start,
+	Anum_bgw_job_stat_last_run_success,
+	Anum_bgw_job_stat_total_runs,
+	Anum_bgw_job_stat_total_failures,
+	Anum_bgw_job_stat_consecutive_failures,
+	_Anum_bgw_job_stat_max,
+};
+
+#define Natts_bgw_job_stat \
+	(_Anum_bgw_job_stat_max - 1)
+
+typedef struct FormData_bgw_job_stat
+{
+	int32		job_id;
+	TimestampTz last_start;
+	TimestampTz last_finish;
+	TimestampTz next_start;
+	bool		last_run_success;
+	int64		total_runs;
+	int64		total_failures;
+	int32		consecutive_failures;
+} FormData_bgw_job_stat;
+
+typedef FormData_bgw_job_stat *Form_bgw_job_stat;
+
+enum
+{
+	BGW_JOB_STAT_PKEY_IDX = 0,
+	_MAX_BGW_JOB_STAT_INDEX,
+};
+
+enum Anum_bgw_job_stat_pkey_idx
+{
+	Anum_bgw_job_stat_pkey_idx_job_id = 1,
+	_Anum_bgw_job_stat_pkey_idx_max,
+};
+
+#define BGW_POLICY_DROP_CHUNKS_TABLE_NAME "bgw_policy_drop_chunks"
+
+enum Anum_bgw_policy_drop_chunks
+{
+	Anum_bgw_policy_drop_chunks_job_id = 1,
+	Anum_bgw_policy_drop_chunks_older_than,
+	Anum_bgw_policy_drop_chunks_cascade,
+	_Anum_bgw_policy_drop_chunks_max,
+};
+
+#define Natts_bgw_policy_drop_chunks \
+	(_Anum_bgw_policy_drop_chunks_max - 1)
+
+typedef struct FormData_bgw_policy_drop_chunks
+{
+	int32		job_id;
+	Interval	older_than;
+	bool		cascade;
+} FormData_bgw_policy_drop_chunks;
+
+typedef FormData_bgw_policy_drop_chunks *Form_bgw_policy_drop_chunks;
+
+enum
+{
+	BGW_POLICY_DROP_CHUNKS_PKEY_IDX = 0,
+	_MAX_BGW_POLICY_DROP_CHUNKS_INDEX,
+};
+
+enum Anum_bgw_policy_drop_chunks_pkey_idx
+{
+	Anum_bgw_policy_drop_chunks_pkey_idx_job_id = 1,
+	_Anum_bgw_policy_drop_chunks_pkey_idx_max,
+};
+
+#define BGW_POLICY_CREATE_CHUNKS_AHEAD_TABLE_NAME "bgw_policy_create_chunks_ahead"
+
+enum Anum_bgw_policy_create_chunks_ahead
+{
+	Anum_bgw_policy_create_chunks_ahead_job_id = 1,
+	Anum_bgw_policy_create_chunks_ahead_num_intervals,
+	_Anum_bgw_policy_create_chunks_ahead_max,
+};
+
+#define Natts_bgw_policy_create_chunks_ahead \
+	(_Anum_bgw_policy_create_chunks_ahead_max - 1)
+
+typedef struct FormData_bgw_policy_create_chunks_ahead
+{
+	int32		job_id;
+	int32		num_intervals;
+} FormData_bgw_policy_create_chunks_ahead;
+
+typedef FormData_bgw_policy_create_chunks_ahead *Form_bgw_policy_create_chunks_ahead;
+
+enum
+{
+	BGW_POLICY_CREATE_CHUNKS_AHEAD_PKEY_IDX = 0,
+	_MAX_BGW_POLICY_CREATE_CHUNKS_AHEAD_INDEX,
+};
+
+enum Anum_bgw_policy_create_chunks_ahead_pkey_idx
+{
+	Anum_bgw_policy_create_chunks_ahead_pkey_idx_job_id = 1,
+	_Anum_bgw_policy_create_chunks_ahead_pkey_idx_max,
+};
+
+#define BGW_POLICY_REORDER_TABLE_NAME "bgw_policy_reorder"
+
+enum Anum_bgw_policy_reorder
+{
+	Anum_bgw_policy_reorder_job_id = 1,
+	Anum_bgw_policy_reorder_hypertable_index_name,
+	Anum_bgw_policy_reorder_older_than,
+	_Anum_bgw_policy_reorder_max,
+};
+
+#define Natts_bgw_policy_reorder \
+	(_Anum_bgw_policy_reorder_max - 1)
+
+typedef struct FormData_bgw_policy_reorder
+{
+	int32		job_id;
+	NameData	hypertable_index_name;
+	Interval	older_than;
+} FormData_bgw_policy_reorder;
+
+typedef FormData_bgw_policy_reorder *Form_bgw_policy_reorder;
+
+enum
+{
+	BGW_POLICY_REORDER_PKEY_IDX = 0,
+	_MAX_BGW_POLICY_REORDER_INDEX,
+};
+
+enum Anum_bgw_policy_reorder_pkey_idx
+{
+	Anum_bgw_policy_reorder_pkey_idx_job_id = 1,
+	_Anum_bgw_policy_reorder_pkey_idx_max,
+};
+
+#define COMPRESSED_CHUNK_TABLE_NAME "compressed_chunk"
+
+enum Anum_compressed_chunk
+{
+	Anum_compressed_chunk_chunk_id = 1,
+	Anum_compressed_chunk_hypertable_id,
+	Anum_compressed_chunk_schema_name,
+	Anum_compressed_chunk_table_name,
+	Anum_compressed_chunk_num_rows,
+	Anum_compressed_chunk_segment_by,
+	_Anum_compressed_chunk_max,
+};
+
+#define Natts_compressed_chunk \
+	(_Anum_compressed_chunk_max - 1)
+
+/* The last column, segment_by, can be NULL and is not part of the struct */
+typedef struct FormData_compressed_chunk
+{
+	int32		chunk_id;
+	int32		hypertable_id;
+	NameData	schema_name;
+	NameData	table_name;
+	int64		num_rows;
+} FormData_compressed_chunk;
+
+typedef FormData_compressed_chunk *Form_compressed_chunk;
+
+enum
+{
+	COMPRESSED_CHUNK_PKEY_IDX = 0,
+	COMPRESSED_CHUNK_HYPERTABLE_ID_IDX,
+	_MAX_COMPRESSED_CHUNK_INDEX,
+};
+
+enum Anum_compressed_chunk_pkey_idx
+{
+	Anum_compressed_chunk_pkey_idx_chunk_id = 1,
+	_Anum_compressed_chunk_pkey_idx_max,
+};
+
+enum Anum_compressed_chunk_hypertable_id_idx
+{
+	Anum_compressed_chunk_hypertable_id_idx_hypertable_id = 1,
+	_Anum_compressed_chunk_hypertable_id_idx_max,
+};
+
+#define BGW_POLICY_MOVE_CHUNKS_TABLE_NAME "bgw_policy_move_chunks"
+
+enum Anum_bgw_policy_move_chunks
+{
+	Anum_bgw_policy_move_chunks_job_id = 1,
+	Anum_bgw_policy_move_chunks_older_than,
+	Anum_bgw_policy_move_chunks_tablespace_name,
+	Anum_bgw_policy_move_chunks_index_tablespace_name,
+	_Anum_bgw_policy_move_chunks_max,
+};
+
+#define Natts_bgw_policy_move_chunks \
+	(_Anum_bgw_policy_move_chunks_max - 1)
+
+typedef struct FormData_bgw_policy_move_chunks
+{
+	int32		job_id;
+	Interval	older_than;
+	NameData	tablespace_name;
+	NameData	index_tablespace_name;
+} FormData_bgw_policy_move_chunks;
+
+typedef FormData_bgw_policy_move_chunks *Form_bgw_policy_move_chunks;
+
+enum
+{
+	BGW_POLICY_MOVE_CHUNKS_PKEY_IDX = 0,
+	_MAX_BGW_POLICY_MOVE_CHUNKS_INDEX,
+};
+
+enum Anum_bgw_policy_move_chunks_pkey_idx
+{
+	Anum_bgw_policy_move_chunks_pkey_idx_job_id = 1,
+	_Anum_bgw_policy_move_chunks_pkey_idx_max,
+};
+
+#define CHUNK_SIZING_TABLE_NAME "chunk_sizing"
+
+enum Anum_chunk_sizing
+{
+	Anum_chunk_sizing_hypertable_id = 1,
+	Anum_chunk_sizing_target_size,
+	_Anum_chunk_sizing_max,
+};
+
+#define Natts_chunk_sizing \
+	(_Anum_chunk_sizing_max - 1)
+
+typedef struct FormData_chunk_sizing
+{
+	int32		hypertable_id;
+	int64		target_size;
+} FormData_chunk_sizing;
+
+typedef FormData_chunk_sizing *Form_chunk_sizing;
+
+enum
+{
+	CHUNK_SIZING_PKEY_IDX = 0,
+	_MAX_CHUNK_SIZING_INDEX,
+};
+
+enum Anum_chunk_sizing_pkey_idx
+{
+	Anum_chunk_sizing_pkey_idx_hypertable_id = 1,
+	_Anum_chunk_sizing_pkey_idx_max,
+};
+
+#define CONTINUOUS_AGG_TABLE_NAME "continuous_agg"
+
+enum Anum_continuous_agg
+{
+	Anum_continuous_agg_mat_hypertable_id = 1,
+	Anum_continuous_agg_raw_hypertable_id,
+	Anum_continuous_agg_user_view_schema,
+	Anum_continuous_agg_user_view_name,
+	Anum_continuous_agg_partial_view_schema,
+	Anum_continuous_agg_partial_view_name,
+	Anum_continuous_agg_bucket_width,
+	_Anum_continuous_agg_max,
+};
+
+#define Natts_continuous_agg \
+	(_Anum_continuous_agg_max - 1)
+
+typedef struct FormData_continuous_agg
+{
+	int32		mat_hypertable_id;
+	int32		raw_hypertable_id;
+	NameData	user_view_schema;
+	NameData	user_view_name;
+	NameData	partial_view_schema;
+	NameData	partial_view_name;
+	int64		bucket_width;
+} FormData_continuous_agg;
+
+typedef FormData_continuous_agg *Form_continuous_agg;
+
+enum
+{
+	CONTINUOUS_AGG_PKEY_IDX = 0,
+	CONTINUOUS_AGG_USER_VIEW_SCHEMA_USER_VIEW_NAME_IDX,
+	CONTINUOUS_AGG_RAW_HYPERTABLE_ID_IDX,
+	_MAX_CONTINUOUS_AGG_INDEX,
+};
+
+enum Anum_continuous_agg_pkey_idx
+{
+	Anum_continuous_agg_pkey_idx_mat_hypertable_id = 1,
+	_Anum_continuous_agg_pkey_idx_max,
+};
+
+enum Anum_continuous_agg_user_view_schema_user_view_name_idx
+{
+	Anum_continuous_agg_user_view_schema_user_view_name_idx_user_view_schema = 1,
+	Anum_continuous_agg_user_view_schema_user_view_name_idx_user_view_name,
+	_Anum_continuous_agg_user_view_schema_user_view_name_idx_max,
+};
+
+enum Anum_continuous_agg_raw_hypertable_id_idx
+{
+	Anum_continuous_agg_raw_hypertable_id_idx_raw_hypertable_id = 1,
+	_Anum_continuous_agg_raw_hypertable_id_idx_max,
+};
+
+#define CONTINUOUS_AGGS_INVALIDATION_LOG_TABLE_NAME "continuous_aggs_invalidation_log"
+
+enum Anum_continuous_aggs_invalidation_log
+{
+	Anum_continuous_aggs_invalidation_log_hypertable_id = 1,
+	Anum_continuous_aggs_invalidation_log_lowest_modified_value,
+	Anum_continuous_aggs_invalidation_log_greatest_modified_value,
+	_Anum_continuous_aggs_invalidation_log_max,
+};
+
+#define Natts_continuous_aggs_invalidation_log \
+	(_Anum_continuous_aggs_invalidation_log_max - 1)
+
+typedef struct FormData_continuous_aggs_invalidation_log
+{
+	int32		hypertable_id;
+	int64		lowest_modified_value;
+	int64		greatest_modified_value;
+} FormData_continuous_aggs_invalidation_log;
+
+typedef FormData_continuous_aggs_invalidation_log *Form_continuous_aggs_invalidation_log;
+
+enum
+{
+	CONTINUOUS_AGGS_INVALIDATION_LOG_HYPERTABLE_ID_IDX = 0,
+	_MAX_CONTINUOUS_AGGS_INVALIDATION_LOG_INDEX,
+};
+
+enum Anum_continuous_aggs_invalidation_log_hypertable_id_idx
+{
+	Anum_continuous_aggs_invalidation_log_hypertable_id_idx_hypertable_id = 1,
+	_Anum_continuous_aggs_invalidation_log_hypertable_id_idx_max,
+};
+
+#define CHUNK_TIME_RANGE_TABLE_NAME "chunk_time_range"
+
+enum Anum_chunk_time_range
+{
+	Anum_chunk_time_range_chunk_id = 1,
+	Anum_chunk_time_range_min_value,
+	Anum_chunk_time_range_max_value,
+	_Anum_chunk_time_range_max,
+};
+
+#define Natts_chunk_time_range \
+	(_Anum_chunk_time_range_max - 1)
+
+typedef struct FormData_chunk_time_range
+{
+	int32		chunk_id;
+	int64		min_value;
+	int64		max_value;
+} FormData_chunk_time_range;
+
+typedef FormData_chunk_time_range *Form_chunk_time_range;
+
+enum
+{
+	CHUNK_TIME_RANGE_PKEY_IDX = 0,
+	_MAX_CHUNK_TIME_RANGE_INDEX,
+};
+
+enum Anum_chunk_time_range_pkey_idx
+{
+	Anum_chunk_time_range_pkey_idx_chunk_id = 1,
+	_Anum_chunk_time_range_pkey_idx_max,
+};
+
+#define HYPERTABLE_BLOOM_COLUMN_TABLE_NAME "hypertable_bloom_column"
+
+enum Anum_hypertable_bloom_column
+{
+	Anum_hypertable_bloom_column_hypertable_id = 1,
+	Anum_hypertable_bloom_column_column_name,
+	_Anum_hypertable_bloom_column_max,
+};
+
+#define Natts_hypertable_bloom_column \
+	(_Anum_hypertable_bloom_column_max - 1)
+
+typedef struct FormData_hypertable_bloom_column
+{
+	int32		hypertable_id;
+	NameData	column_name;
+} FormData_hypertable_bloom_column;
+
+typedef FormData_hypertable_bloom_column *Form_hypertable_bloom_column;
+
+enum
+{
+	HYPERTABLE_BLOOM_COLUMN_PKEY_IDX = 0,
+	_MAX_HYPERTABLE_BLOOM_COLUMN_INDEX,
+};
+
+enum Anum_hypertable_bloom_column_pkey_idx
+{
+	Anum_hypertable_bloom_column_pkey_idx_hypertable_id = 1,
+	Anum_hypertable_bloom_column_pkey_idx_column_name,
+	_Anum_hypertable_bloom_column_pkey_idx_max,
+};
+
+#define CHUNK_BLOOM_FILTER_TABLE_NAME "chunk_bloom_filter"
+
+enum Anum_chunk_bloom_filter
+{
+	Anum_chunk_bloom_filter_chunk_id = 1,
+	Anum_chunk_bloom_filter_column_name,
+	Anum_chunk_bloom_filter_num_hashes,
+	Anum_chunk_bloom_filter_filter,
+	_Anum_chunk_bloom_filter_max,
+};
+
+#define Natts_chunk_bloom_filter \
+	(_Anum_chunk_bloom_filter_max - 1)
+
+/* The last column, filter, has variable length and is not part of the struct */
+typedef struct FormData_chunk_bloom_filter
+{
+	int32		chunk_id;
+	NameData	column_name;
+	int32		num_hashes;
+} FormData_chunk_bloom_filter;
+
+typedef FormData_chunk_bloom_filter *Form_chunk_bloom_filter;
+
+enum
+{
+	CHUNK_BLOOM_FILTER_PKEY_IDX = 0,
+	_MAX_CHUNK_BLOOM_FILTER_INDEX,
+};
+
+enum Anum_chunk_bloom_filter_pkey_idx
+{
+	Anum_chunk_bloom_filter_pkey_idx_chunk_id = 1,
+	Anum_chunk_bloom_filter_pkey_idx_column_name,
+	_Anum_chunk_bloom_filter_pkey_idx_max,
+};
+
+#define BGW_POLICY_COLD_INDEX_TABLE_NAME "bgw_policy_cold_index"
+
+enum Anum_bgw_policy_cold_index
+{
+	Anum_bgw_policy_cold_index_job_id = 1,
+	Anum_bgw_policy_cold_index_hypertable_index_name,
+	Anum_bgw_policy_cold_index_older_than,
+	Anum_bgw_policy_cold_index_access_method,
+	_Anum_bgw_policy_cold_index_max,
+};
+
+#define Natts_bgw_policy_cold_index \
+	(_Anum_bgw_policy_cold_index_max - 1)
+
+typedef struct FormData_bgw_policy_cold_index
+{
+	int32		job_id;
+	NameData	hypertable_index_name;
+	Interval	older_than;
+	NameData	access_method;
+} FormData_bgw_policy_cold_index;
+
+typedef FormData_bgw_policy_cold_index *Form_bgw_policy_cold_index;
+
+enum
+{
+	BGW_POLICY_COLD_INDEX_PKEY_IDX = 0,
+	_MAX_BGW_POLICY_COLD_INDEX_INDEX,
+};
+
+enum Anum_bgw_policy_cold_index_pkey_idx
+{
+	Anum_bgw_policy_cold_index_pkey_idx_job_id = 1,
+	_Anum_bgw_policy_cold_index_pkey_idx_max,
+};
+
+#define HYPERTABLE_DATA_NODE_TABLE_NAME "hypertable_data_node"
+
+enum Anum_hypertable_data_node
+{
+	Anum_hypertable_data_node_hypertable_id = 1,
+	Anum_hypertable_data_node_node_name,
+	_Anum_hypertable_data_node_max,
+};
+
+#define Natts_hypertable_data_node \
+	(_Anum_hypertable_data_node_max - 1)
+
+typedef struct FormData_hypertable_data_node
+{
+	int32		hypertable_id;
+	NameData	node_name;
+} FormData_hypertable_data_node;
+
+typedef FormData_hypertable_data_node *Form_hypertable_data_node;
+
+enum
+{
+	HYPERTABLE_DATA_NODE_PKEY_IDX = 0,
+	_MAX_HYPERTABLE_DATA_NODE_INDEX,
+};
+
+enum Anum_hypertable_data_node_pkey_idx
+{
+	Anum_hypertable_data_node_pkey_idx_hypertable_id = 1,
+	Anum_hypertable_data_node_pkey_idx_node_name,
+	_Anum_hypertable_data_node_pkey_idx_max,
+};
+
 #define MAX(a, b) \
 	((long)(a) > (long)(b) ? (a) : (b))
 
@@ -473,7 +1069,8 @@ typedef struct FormData_tablespace_hypertable_id_tablespace_name_idx
 				MAX(_MAX_CHUNK_CONSTRAINT_INDEX,		\
 					MAX(_MAX_CHUNK_INDEX_INDEX,			\
 						MAX(_MAX_TABLESPACE_INDEX,		\
-							_MAX_CHUNK_INDEX))))))
+							MAX(_MAX_BGW_JOB_INDEX,		\
+								_MAX_CHUNK_INDEX)))))))
 
 typedef enum CacheType
 {
@@ -487,9 +1084,15 @@ typedef struct Catalog
 	char		database_name[NAMEDATALEN];
 	Oid			database_id;
 	Oid			schema_id;
+	/*
+	 * Table, index, and sequence OIDs are resolved lazily, per table, the
+	 * first time a table is accessed. Use catalog_table_get_id() and
+	 * CATALOG_INDEX() to read them.
+	 */
 	struct
 	{
 		const char *name;
+		bool		resolved;
 		Oid			id;
 		Oid			index_ids[_MAX_TABLE_INDEXES];
 		Oid			serial_relid;
@@ -503,8 +1106,10 @@ typedef struct Catalog
 
 	Oid			owner_uid;
 	Oid			internal_schema_id;
+	/* Internal functions are also resolved on first use */
 	struct
 	{
+		bool		resolved;
 		Oid			function_id;
 	}			functions[_MAX_INTERNAL_FUNCTIONS];
 } Catalog;
@@ -529,6 +1134,7 @@ void		catalog_restore_user(CatalogSecurityContext *sec_ctx);
 
 int64		catalog_table_next_seq_id(Catalog *catalog, CatalogTable table);
 Oid			catalog_table_get_id(Catalog *catalog, CatalogTable table);
+Oid			catalog_table_get_index_id(Catalog *catalog, CatalogTable table, int indexid);
 CatalogTable catalog_table_get(Catalog *catalog, Oid relid);
 const char *catalog_table_name(CatalogTable table);
 
@@ -539,6 +1145,11 @@ void		catalog_update(Relation rel, HeapTuple tuple);
 void		catalog_delete_tid(Relation rel, ItemPointer tid);
 void		catalog_delete(Relation rel, HeapTuple tuple);
 void		catalog_invalidate_cache(Oid catalog_relid, CmdType operation);
+void		catalog_invalidate_cache_for_tuple(Relation rel, HeapTuple tuple, CmdType operation);
+
+/* Insert with opened indexes: do not increment command counter */
+void		catalog_insert_values_with_info(Relation rel, CatalogIndexState indstate, TupleDesc tupdesc,
+											Datum *values, bool *nulls);
 
 /* Delete only: do not increment command counter or invalidate caches */
 void		catalog_delete_only(Relation rel, HeapTuple tuple);
@@ -1,35 +1,66 @@
 #include <postgres.h>
 #include <catalog/namespace.h>
+#include <catalog/dependency.h>
 #include <catalog/pg_trigger.h>
 #include <catalog/indexing.h>
 #include <catalog/pg_inherits.h>
+#include <catalog/pg_constraint.h>
+#include <catalog/pg_index.h>
 #include <commands/trigger.h>
 #include <commands/tablecmds.h>
+#include <commands/defrem.h>
+#include <commands/tablespace.h>
+#include <foreign/foreign.h>
 #include <tcop/tcopprot.h>
+#include <access/genam.h>
+#include <access/heapam.h>
 #include <access/htup.h>
 #include <access/htup_details.h>
 #include <access/xact.h>
 #include <access/reloptions.h>
+#include <access/tupconvert.h>
+#include <executor/executor.h>
 #include <nodes/makefuncs.h>
+#include <utils/acl.h>
 #include <utils/builtins.h>
+#include <utils/fmgroids.h>
 #include <utils/lsyscache.h>
 #include <utils/syscache.h>
 #include <utils/hsearch.h>
+#include <utils/inval.h>
+#include <utils/timestamp.h>
+#include <utils/rel.h>
+#include <utils/snapmgr.h>
+#include <catalog/pg_type.h>
 #include <storage/lmgr.h>
 #include <miscadmin.h>
+#include <portability/instr_time.h>
 
 #include "chunk.h"
+#include "chunk_adaptive.h"
+#include "chunk_bloom_filter.h"
 #include "chunk_index.h"
+#include "chunk_time_range.h"
+#include "compress_chunk.h"
+#include "continuous_agg.h"
 #include "catalog.h"
+#include "data_node.h"
 #include "dimension.h"
 #include "dimension_slice.h"
 #include "dimension_vector.h"
 #include "partitioning.h"
 #include "hypertable.h"
+#include "hypertable_cache.h"
+#include "hypertable_stats.h"
+#include "cache.h"
+#include "errors.h"
+#include "utils.h"
 #include "hypercube.h"
 #include "scanner.h"
 #include "process_utility.h"
 #include "trigger.h"
+#include "timing.h"
+#include "guc.h"
 #include "compat.h"
 
 typedef bool (*on_chunk_func) (ChunkScanCtx *ctx, Chunk *chunk);
@@ -90,7 +121,7 @@ chunk_insert_lock(Chunk *chunk, LOCKMODE lock)
 	Catalog    *catalog = catalog_get();
 	Relation	rel;
 
-	rel = heap_open(catalog->tables[CHUNK].id, lock);
+	rel = heap_open(catalog_table_get_id(catalog, CHUNK), lock);
 	chunk_insert_relation(rel, chunk);
 	heap_close(rel, lock);
 }
@@ -332,16 +363,18 @@ chunk_collision_resolve(Hyperspace *hs, Hypercube *cube, Point *p)
 }
 
 static int
-chunk_add_constraints(Chunk *chunk)
+chunk_add_constraints(Chunk *chunk, bool inheritable)
 {
 	int			num_added;
 
 	num_added = chunk_constraints_add_dimension_constraints(chunk->constraints,
 															chunk->fd.id,
 															chunk->cube);
-	num_added += chunk_constraints_add_inheritable_constraints(chunk->constraints,
-															   chunk->fd.id,
-															   chunk->hypertable_relid);
+
+	if (inheritable)
+		num_added += chunk_constraints_add_inheritable_constraints(chunk->constraints,
+																   chunk->fd.id,
+																   chunk->hypertable_relid);
 
 	return num_added;
 }
@@ -370,7 +403,193 @@ get_reloptions(Oid relid)
 }
 
 /*
- * Create a chunk's table.
+ * Check if a hypertable has dropped columns. Tables that inherit their
+ * columns from such a hypertable do not get the dropped columns, so their
+ * physical layout differs from the hypertable's.
+ */
+static bool
+hypertable_has_dropped_columns(Relation ht_rel)
+{
+	TupleDesc	desc = RelationGetDescr(ht_rel);
+	int			i;
+
+	for (i = 0; i < desc->natts; i++)
+		if (desc->attrs[i]->attisdropped)
+			return true;
+
+	return false;
+}
+
+/*
+ * Mark the columns and CHECK constraints that a table inherits from its
+ * parent as not locally defined, as if the table was created with INHERITS.
+ */
+static void
+chunk_mark_inherited_only(Oid relid)
+{
+	Relation	rel;
+	ScanKeyData scankey;
+	SysScanDesc scan;
+	HeapTuple	tuple;
+
+	rel = heap_open(AttributeRelationId, RowExclusiveLock);
+	ScanKeyInit(&scankey, Anum_pg_attribute_attrelid,
+				BTEqualStrategyNumber, F_OIDEQ, ObjectIdGetDatum(relid));
+	scan = systable_beginscan(rel, AttributeRelidNumIndexId, true, NULL, 1, &scankey);
+
+	while (HeapTupleIsValid(tuple = systable_getnext(scan)))
+	{
+		Form_pg_attribute attr = (Form_pg_attribute) GETSTRUCT(tuple);
+
+		if (attr->attinhcount > 0 && attr->attislocal)
+		{
+			HeapTuple	copy = heap_copytuple(tuple);
+
+			((Form_pg_attribute) GETSTRUCT(copy))->attislocal = false;
+			CatalogTupleUpdate(rel, &copy->t_self, copy);
+			heap_freetuple(copy);
+		}
+	}
+
+	systable_endscan(scan);
+	heap_close(rel, RowExclusiveLock);
+
+	rel = heap_open(ConstraintRelationId, RowExclusiveLock);
+	ScanKeyInit(&scankey, Anum_pg_constraint_conrelid,
+				BTEqualStrategyNumber, F_OIDEQ, ObjectIdGetDatum(relid));
+	scan = systable_beginscan(rel, ConstraintRelidIndexId, true, NULL, 1, &scankey);
+
+	while (HeapTupleIsValid(tuple = systable_getnext(scan)))
+	{
+		Form_pg_constraint con = (Form_pg_constraint) GETSTRUCT(tuple);
+
+		if (con->contype == CONSTRAINT_CHECK && con->coninhcount > 0 && con->conislocal)
+		{
+			HeapTuple	copy = heap_copytuple(tuple);
+
+			((Form_pg_constraint) GETSTRUCT(copy))->conislocal = false;
+			CatalogTupleUpdate(rel, &copy->t_self, copy);
+			heap_freetuple(copy);
+		}
+	}
+
+	systable_endscan(scan);
+	heap_close(rel, RowExclusiveLock);
+
+	CommandCounterIncrement();
+}
+
+/*
+ * Create a chunk's table with the same physical layout as the hypertable.
+ *
+ * A table that is created with INHERITS gets only the live columns of its
+ * parent, so rows routed from a hypertable with dropped columns would have
+ * to be converted to the chunk's rowtype one by one. Instead, the table is
+ * created with a placeholder column in the position of every dropped column
+ * and copies of the hypertable's columns and CHECK constraints. The
+ * placeholders are then dropped and the table is attached to the hypertable,
+ * which is how pg_dump recreates tables with dropped columns in binary
+ * upgrades.
+ */
+static Oid
+chunk_create_table_with_rowtype(CreateStmt *stmt, Relation ht_rel)
+{
+	TupleDesc	desc = RelationGetDescr(ht_rel);
+	TupleConstr *constr = desc->constr;
+	RangeVar   *parent = linitial(stmt->inhRelations);
+	List	   *cmds = NIL;
+	AlterTableCmd *cmd;
+	ObjectAddress objaddr;
+	int			i;
+
+	stmt->inhRelations = NIL;
+	stmt->tableElts = NIL;
+	stmt->constraints = NIL;
+
+	for (i = 0; i < desc->natts; i++)
+	{
+		Form_pg_attribute attr = desc->attrs[i];
+		ColumnDef  *coldef = makeNode(ColumnDef);
+
+		coldef->is_local = true;
+		coldef->location = -1;
+
+		if (attr->attisdropped)
+		{
+			coldef->colname = psprintf("........pg.dropped.%d........", i + 1);
+			coldef->typeName = makeTypeNameFromOid(INT4OID, -1);
+
+			cmd = makeNode(AlterTableCmd);
+			cmd->subtype = AT_DropColumn;
+			cmd->name = coldef->colname;
+			cmd->behavior = DROP_RESTRICT;
+			cmds = lappend(cmds, cmd);
+		}
+		else
+		{
+			coldef->colname = pstrdup(NameStr(attr->attname));
+			coldef->typeName = makeTypeNameFromOid(attr->atttypid, attr->atttypmod);
+			coldef->collOid = attr->attcollation;
+			coldef->is_not_null = attr->attnotnull;
+			coldef->storage = attr->attstorage;
+
+			if (attr->atthasdef && NULL != constr)
+			{
+				int			j;
+
+				for (j = 0; j < constr->num_defval; j++)
+					if (constr->defval[j].adnum == attr->attnum)
+						coldef->cooked_default = stringToNode(constr->defval[j].adbin);
+			}
+		}
+
+		stmt->tableElts = lappend(stmt->tableElts, coldef);
+	}
+
+	for (i = 0; NULL != constr && i < constr->num_check; i++)
+	{
+		ConstrCheck *check = &constr->check[i];
+		Constraint *con;
+
+		if (check->ccnoinherit)
+			continue;
+
+		con = makeNode(Constraint);
+		con->contype = CONSTR_CHECK;
+		con->conname = pstrdup(check->ccname);
+		con->cooked_expr = pstrdup(check->ccbin);
+		con->initially_valid = check->ccvalid;
+		con->skip_validation = true;
+		con->location = -1;
+		stmt->constraints = lappend(stmt->constraints, con);
+	}
+
+	objaddr = DefineRelation(stmt,
+							 RELKIND_RELATION,
+							 ht_rel->rd_rel->relowner,
+							 NULL
+#if PG10
+							 ,NULL
+#endif
+		);
+
+	CommandCounterIncrement();
+
+	cmd = makeNode(AlterTableCmd);
+	cmd->subtype = AT_AddInherit;
+	cmd->def = (Node *) parent;
+	cmds = lappend(cmds, cmd);
+
+	AlterTableInternal(objaddr.objectId, cmds, false);
+	CommandCounterIncrement();
+
+	chunk_mark_inherited_only(objaddr.objectId);
+
+	return objaddr.objectId;
+}
+
+/*
+ * Create a table for a chunk.
  *
  * A chunk inherits from the main hypertable and will have the same owner. Since
  * chunks can be created either in the TimescaleDB internal schema or in a
@@ -389,24 +608,49 @@ get_reloptions(Oid relid)
  * must have permissions to create tables in the associated schema, or else
  * table creation will fail. If the schema doesn't yet exist, the table owner
  * instead needs the proper permissions on the database to create the schema.
+ *
+ * If the hypertable has dropped columns, the chunk is created with the
+ * hypertable's physical layout, so that rows need no conversion when they
+ * are routed to the chunk.
+ *
+ * If a data node is given, the chunk is instead created as a foreign table
+ * that points to the hypertable of the same name on the data node. Every
+ * chunk on a node points to the same remote hypertable, so scans of a foreign
+ * chunk are restricted to the chunk's hypercube by the planner.
  */
 static Oid
-chunk_create_table(Chunk *chunk, Hypertable *ht)
+chunk_create_relation(Chunk *chunk, Hypertable *ht, const char *table_name,
+					  char *tablespacename, List *options, ForeignServer *server)
 {
 	Catalog    *catalog = catalog_get();
 	Relation	rel;
 	ObjectAddress objaddr;
 	int			sec_ctx;
-	CreateStmt	stmt = {
-		.type = T_CreateStmt,
-		.relation = makeRangeVar(NameStr(chunk->fd.schema_name), NameStr(chunk->fd.table_name), 0),
-		.inhRelations = list_make1(makeRangeVar(NameStr(ht->fd.schema_name), NameStr(ht->fd.table_name), 0)),
-		.tablespacename = hypertable_select_tablespace_name(ht, chunk),
-		.options = get_reloptions(ht->main_table_relid),
+	CreateForeignTableStmt stmt = {
+		.base = {
+			.type = T_CreateStmt,
+			.relation = makeRangeVar(NameStr(chunk->fd.schema_name), (char *) table_name, 0),
+			.inhRelations = list_make1(makeRangeVar(NameStr(ht->fd.schema_name), NameStr(ht->fd.table_name), 0)),
+		},
 	};
 	Oid			uid,
 				saved_uid;
 
+	if (NULL == server)
+	{
+		stmt.base.tablespacename = tablespacename;
+		stmt.base.options = options;
+	}
+	else
+	{
+		stmt.base.type = T_CreateForeignTableStmt;
+		stmt.servername = server->servername;
+		stmt.options = list_make2(makeDefElemCompat("schema_name",
+													(Node *) makeString(NameStr(ht->fd.schema_name))),
+								  makeDefElemCompat("table_name",
+													(Node *) makeString(NameStr(ht->fd.table_name))));
+	}
+
 	rel = heap_open(ht->main_table_relid, AccessShareLock);
 
 	/*
@@ -423,14 +667,24 @@ chunk_create_table(Chunk *chunk, Hypertable *ht)
 	if (uid != saved_uid)
 		SetUserIdAndSecContext(uid, sec_ctx | SECURITY_LOCAL_USERID_CHANGE);
 
-	objaddr = DefineRelation(&stmt,
-							 RELKIND_RELATION,
-							 rel->rd_rel->relowner,
-							 NULL
+	if (NULL == server && !rel->rd_rel->relhasoids && hypertable_has_dropped_columns(rel))
+		objaddr.objectId = chunk_create_table_with_rowtype(&stmt.base, rel);
+	else
+		objaddr = DefineRelation(&stmt.base,
+								 NULL == server ? RELKIND_RELATION : RELKIND_FOREIGN_TABLE,
+								 rel->rd_rel->relowner,
+								 NULL
 #if PG10
-							 ,NULL
+								 ,NULL
 #endif
-		);
+			);
+
+	if (NULL != server)
+	{
+		/* Make the new relation visible before adding its foreign options */
+		CommandCounterIncrement();
+		CreateForeignTable(&stmt, objaddr.objectId);
+	}
 
 	if (uid != saved_uid)
 		SetUserIdAndSecContext(saved_uid, sec_ctx);
@@ -440,14 +694,38 @@ chunk_create_table(Chunk *chunk, Hypertable *ht)
 	return objaddr.objectId;
 }
 
+/*
+ * Create a chunk's table, placed in the tablespace picked for the chunk and
+ * with the hypertable's storage options.
+ */
+static Oid
+chunk_create_table(Chunk *chunk, Hypertable *ht, ForeignServer *server)
+{
+	if (NULL != server)
+		return chunk_create_relation(chunk, ht, NameStr(chunk->fd.table_name), NULL, NIL, server);
+
+	return chunk_create_relation(chunk, ht, NameStr(chunk->fd.table_name),
+								 hypertable_select_tablespace_name(ht, chunk),
+								 get_reloptions(ht->main_table_relid), NULL);
+}
+
 static Chunk *
-chunk_create_after_lock(Hypertable *ht, Point *p, const char *schema, const char *prefix)
+chunk_create_after_lock(Hypertable *ht, Point *p, const char *schema, const char *prefix,
+						bool create_indexes)
 {
 	Hyperspace *hs = ht->space;
 	Catalog    *catalog = catalog_get();
 	CatalogSecurityContext sec_ctx;
 	Hypercube  *cube;
 	Chunk	   *chunk;
+	ForeignServer *server;
+	TimingState timing;
+
+	timing_begin(&timing, TIMING_CHUNK_CREATE);
+
+	/* Resize the new chunk according to the size of the preceding ones */
+	if (ht->chunk_target_size > 0)
+		chunk_adaptive_update_interval(ht, p);
 
 	/* Calculate the hypercube for a new chunk that covers the tuple's point */
 	cube = hypercube_calculate_from_point(hs, p);
@@ -473,11 +751,18 @@ chunk_create_after_lock(Hypertable *ht, Point *p, const char *schema, const char
 	/* Insert any new dimension slices */
 	dimension_slice_insert_multi(cube->slices, cube->num_slices);
 
-	/* Add metadata for dimensional and inheritable constraints */
-	chunk_add_constraints(chunk);
+	/* Pick the data node for the chunk, if the hypertable is distributed */
+	server = hypertable_select_data_node(ht, chunk);
+
+	/*
+	 * Add metadata for dimensional and inheritable constraints. Foreign
+	 * tables cannot have unique or foreign key constraints, which are instead
+	 * enforced by the data node's hypertable.
+	 */
+	chunk_add_constraints(chunk, NULL == server);
 
 	/* Create the actual table relation for the chunk */
-	chunk->table_id = chunk_create_table(chunk, ht);
+	chunk->table_id = chunk_create_table(chunk, ht, server);
 
 	if (!OidIsValid(chunk->table_id))
 		elog(ERROR, "Could not create chunk table");
@@ -491,38 +776,123 @@ chunk_create_after_lock(Hypertable *ht, Point *p, const char *schema, const char
 
 	trigger_create_all_on_chunk(ht, chunk);
 
-	chunk_index_create_all(chunk->fd.hypertable_id,
-						   chunk->hypertable_relid,
-						   chunk->fd.id,
-						   chunk->table_id);
+	if (create_indexes)
+		chunk_index_create_all(chunk->fd.hypertable_id,
+							   chunk->hypertable_relid,
+							   chunk->fd.id,
+							   chunk->table_id);
+
+	timing_end(&timing, InvalidOid);
 
 	return chunk;
 }
 
-Chunk *
-chunk_create(Hypertable *ht, Point *p, const char *schema, const char *prefix)
+/*
+ * Log a chunk creation that took longer than
+ * timescaledb.log_min_chunk_create_duration, with a breakdown of where the
+ * time went. The catalog scan and index build times are those spent since
+ * the given start times.
+ */
+static void
+chunk_create_log_duration(Chunk *chunk, bool created, instr_time duration, instr_time lock_wait,
+						  double scan_time_start, double index_time_start)
+{
+	double		msecs = INSTR_TIME_GET_MILLISEC(duration);
+
+	if (guc_log_min_chunk_create_duration < 0 || msecs < guc_log_min_chunk_create_duration)
+		return;
+
+	ereport(LOG,
+			(errmsg("%s chunk \"%s.%s\" took %.3f ms",
+					created ? "creating" : "waiting for concurrently created",
+					NameStr(chunk->fd.schema_name),
+					NameStr(chunk->fd.table_name),
+					msecs),
+			 errdetail("Waited %.3f ms for the hypertable lock, spent %.3f ms in catalog scans and %.3f ms building indexes.",
+					   INSTR_TIME_GET_MILLISEC(lock_wait),
+					   timing_get_total(TIMING_CATALOG_SCAN) - scan_time_start,
+					   timing_get_total(TIMING_CHUNK_INDEX_CREATE) - index_time_start)));
+}
+
+static Chunk *
+chunk_create_internal(Hypertable *ht, Point *p, const char *schema, const char *prefix,
+					  bool create_indexes, bool *created)
 {
 	Chunk	   *chunk;
+	bool		did_create = false;
+	double		scan_time_start = timing_get_total(TIMING_CATALOG_SCAN);
+	double		index_time_start = timing_get_total(TIMING_CHUNK_INDEX_CREATE);
+	instr_time	start,
+				lock_wait,
+				duration;
+
+	/* Include the time waiting for the lock, which is part of the cost */
+	INSTR_TIME_SET_CURRENT(start);
 
 	/*
 	 * Serialize chunk creation around a lock on the "main table" to avoid
 	 * multiple processes trying to create the same chunk. We use a
 	 * ShareUpdateExclusiveLock, which is the weakest lock possible that
 	 * conflicts with itself. The lock needs to be held until transaction end.
+	 *
+	 * The lock only serializes chunk creation within the hypertable, while
+	 * other hypertables are unaffected. Finer-grained locks, e.g., per
+	 * closed-dimension partition, would not let chunks of the same
+	 * hypertable be created in parallel, since PostgreSQL takes the same
+	 * lock on the parent when the chunk table is created as a child of the
+	 * main table.
 	 */
 	LockRelationOid(ht->main_table_relid, ShareUpdateExclusiveLock);
 
+	INSTR_TIME_SET_CURRENT(lock_wait);
+	INSTR_TIME_SUBTRACT(lock_wait, start);
+
 	/* Recheck if someone else created the chunk before we got the table lock */
 	chunk = chunk_find(ht->space, p);
 
 	if (NULL == chunk)
-		chunk = chunk_create_after_lock(ht, p, schema, prefix);
+	{
+		chunk = chunk_create_after_lock(ht, p, schema, prefix, create_indexes);
+		hypertable_stats_add(ht->fd.id, HYPERTABLE_STATS_CHUNKS_CREATED, 1);
+		did_create = true;
+	}
+
+	if (NULL != created)
+		*created = did_create;
 
 	Assert(chunk != NULL);
 
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, start);
+	hypertable_stats_add(ht->fd.id, HYPERTABLE_STATS_CHUNK_CREATE_TIME,
+						 INSTR_TIME_GET_MICROSEC(duration));
+	chunk_create_log_duration(chunk, did_create, duration, lock_wait,
+							  scan_time_start, index_time_start);
+
 	return chunk;
 }
 
+Chunk *
+chunk_create(Hypertable *ht, Point *p, const char *schema, const char *prefix)
+{
+	return chunk_create_internal(ht, p, schema, prefix, true, NULL);
+}
+
+/*
+ * Create a chunk without its (non-constraint) indexes, e.g., to bulk load it
+ * and build the indexes afterwards with chunk_index_create_all().
+ *
+ * Since someone else might have created the chunk while we waited for the
+ * lock, "created" is set to tell whether this call created the chunk. Only in
+ * that case are the indexes missing.
+ */
+Chunk *
+chunk_create_without_indexes(Hypertable *ht, Point *p, const char *schema,
+							 const char *prefix, bool *created)
+{
+	return chunk_create_internal(ht, p, schema, prefix, false, created);
+}
+
 Chunk *
 chunk_create_stub(int32 id, int16 num_constraints)
 {
@@ -564,8 +934,8 @@ chunk_fill_stub(Chunk *chunk_stub, bool tuplock)
 	Catalog    *catalog = catalog_get();
 	int			num_found;
 	ScannerCtx	ctx = {
-		.table = catalog->tables[CHUNK].id,
-		.index = catalog->tables[CHUNK].index_ids[CHUNK_ID_INDEX],
+		.table = catalog_table_get_id(catalog, CHUNK),
+		.index = CATALOG_INDEX(catalog, CHUNK, CHUNK_ID_INDEX),
 		.nkeys = 1,
 		.scankey = scankey,
 		.data = chunk_stub,
@@ -806,6 +1176,8 @@ chunk_find(Hyperspace *hs, Point *p)
 	Chunk	   *chunk;
 	ChunkScanCtx ctx;
 
+	hypertable_stats_add(hs->hypertable_id, HYPERTABLE_STATS_CHUNK_FIND_SCANS, 1);
+
 	/* The scan context will keep the state accumulated during the scan */
 	chunk_scan_ctx_init(&ctx, hs, p);
 
@@ -837,6 +1209,23 @@ chunk_find(Hyperspace *hs, Point *p)
 	return chunk;
 }
 
+/*
+ * Get a chunk given its ID and its hypercube, e.g., as found in a hypertable's
+ * slice index. Having the hypercube saves the dimension slice scans that are
+ * otherwise needed to fill in the chunk.
+ */
+Chunk *
+chunk_get_by_id_with_cube(int32 chunk_id, Hypercube *cube, int16 num_constraints)
+{
+	Chunk	   *chunk = chunk_create_stub(chunk_id, 0);
+
+	chunk->cube = cube;
+	chunk_fill_stub(chunk, false);
+	chunk->constraints = chunk_constraint_scan_by_chunk_id(chunk_id, num_constraints);
+
+	return chunk;
+}
+
 Chunk *
 chunk_copy(Chunk *chunk)
 {
@@ -854,6 +1243,73 @@ chunk_copy(Chunk *chunk)
 	return copy;
 }
 
+/*
+ * Copy a chunk, with its hypercube, slices, and constraints, into a single
+ * allocation in the given memory context, so that it can be freed with one
+ * pfree().
+ *
+ * This is meant for long-lived copies, like those in a hypertable's chunk
+ * cache, where a separate memory context per chunk costs much more memory
+ * than the chunk itself. Since all entries of the same hypertable have
+ * roughly the same size, freed entries are reused from the context's free
+ * lists. The copy must not be modified in ways that reallocate its parts,
+ * e.g., by adding constraints.
+ */
+Chunk *
+chunk_copy_compact(Chunk *chunk, MemoryContext mcxt)
+{
+	int16		num_slices = NULL != chunk->cube ? chunk->cube->num_slices : 0;
+	int16		num_constraints = NULL != chunk->constraints ? chunk->constraints->num_constraints : 0;
+	Size		nbytes = MAXALIGN(sizeof(Chunk));
+	char	   *ptr;
+	Chunk	   *copy;
+	int			i;
+
+	if (NULL != chunk->cube)
+		nbytes += MAXALIGN(HYPERCUBE_SIZE(num_slices)) +
+			num_slices * MAXALIGN(sizeof(DimensionSlice));
+
+	if (NULL != chunk->constraints)
+		nbytes += MAXALIGN(sizeof(ChunkConstraints)) +
+			num_constraints * sizeof(ChunkConstraint);
+
+	ptr = MemoryContextAlloc(mcxt, nbytes);
+	copy = (Chunk *) ptr;
+	memcpy(copy, chunk, sizeof(Chunk));
+	ptr += MAXALIGN(sizeof(Chunk));
+
+	if (NULL != chunk->cube)
+	{
+		copy->cube = (Hypercube *) ptr;
+		copy->cube->capacity = num_slices;
+		copy->cube->num_slices = num_slices;
+		ptr += MAXALIGN(HYPERCUBE_SIZE(num_slices));
+
+		for (i = 0; i < num_slices; i++)
+		{
+			Assert(chunk->cube->slices[i]->storage == NULL);
+			copy->cube->slices[i] = (DimensionSlice *) ptr;
+			memcpy(ptr, chunk->cube->slices[i], sizeof(DimensionSlice));
+			ptr += MAXALIGN(sizeof(DimensionSlice));
+		}
+	}
+
+	if (NULL != chunk->constraints)
+	{
+		copy->constraints = (ChunkConstraints *) ptr;
+		memcpy(copy->constraints, chunk->constraints, sizeof(ChunkConstraints));
+		copy->constraints->capacity = num_constraints;
+		ptr += MAXALIGN(sizeof(ChunkConstraints));
+		copy->constraints->constraints = (ChunkConstraint *) ptr;
+
+		if (num_constraints > 0)
+			memcpy(ptr, chunk->constraints->constraints,
+				   num_constraints * sizeof(ChunkConstraint));
+	}
+
+	return copy;
+}
+
 static int
 chunk_scan_internal(int indexid,
 					ScanKeyData scankey[],
@@ -865,8 +1321,8 @@ chunk_scan_internal(int indexid,
 {
 	Catalog    *catalog = catalog_get();
 	ScannerCtx	ctx = {
-		.table = catalog->tables[CHUNK].id,
-		.index = catalog->tables[CHUNK].index_ids[indexid],
+		.table = catalog_table_get_id(catalog, CHUNK),
+		.index = CATALOG_INDEX(catalog, CHUNK, indexid),
 		.nkeys = nkeys,
 		.data = data,
 		.scankey = scankey,
@@ -971,96 +1427,497 @@ chunk_get_by_id(int32 id, int16 num_constraints, bool fail_if_not_found)
 						   num_constraints, fail_if_not_found);
 }
 
-bool
-chunk_exists(const char *schema_name, const char *table_name)
-{
-	return chunk_get_by_name(schema_name, table_name, 0, false) != NULL;
-}
-
-bool
-chunk_exists_relid(Oid relid)
+typedef struct ChunkLoadCtx
 {
-	return chunk_get_by_relid(relid, 0, false) != NULL;
-}
+	HTAB	   *htab;			/* Chunk ID to ChunkScanEntry */
+	Oid			hypertable_relid;
+	int16		num_constraints;
+	int			num_chunks;
+	int			capacity;
+	Chunk	  **chunks;
+	int32	   *chunk_ids;
+} ChunkLoadCtx;
 
 static bool
-chunk_tuple_delete(TupleInfo *ti, void *data)
+chunk_tuple_load(TupleInfo *ti, void *data)
 {
-	FormData_chunk *form = (FormData_chunk *) GETSTRUCT(ti->tuple);
-	CatalogSecurityContext sec_ctx;
-	ChunkConstraints *ccs = chunk_constraints_alloc(2);
-	int			i;
+	ChunkLoadCtx *ctx = data;
+	Chunk	   *chunk = palloc0(sizeof(Chunk));
+	ChunkScanEntry *entry;
 
-	chunk_constraint_delete_by_chunk_id(form->id, ccs);
-	chunk_index_delete_by_chunk_id(form->id, true);
+	/*
+	 * All chunks have the same parent, so there is no need to look it up for
+	 * each chunk like chunk_fill() does.
+	 */
+	memcpy(&chunk->fd, GETSTRUCT(ti->tuple), sizeof(FormData_chunk));
+	chunk->table_id = get_relname_relid(NameStr(chunk->fd.table_name),
+										get_namespace_oid(NameStr(chunk->fd.schema_name), true));
+	chunk->hypertable_relid = ctx->hypertable_relid;
+	chunk->constraints = chunk_constraints_alloc(ctx->num_constraints);
 
-	/* Check for dimension slices that are orphaned by the chunk deletion */
-	for (i = 0; i < ccs->num_constraints; i++)
-	{
-		ChunkConstraint *cc = &ccs->constraints[i];
+	entry = hash_search(ctx->htab, &chunk->fd.id, HASH_ENTER, NULL);
+	entry->chunk = chunk;
 
-		/*
-		 * Delete the dimension slice if there are no remaining constraints
-		 * referencing it
-		 */
-		if (is_dimension_constraint(cc) &&
-			chunk_constraint_scan_by_dimension_slice_id(cc->fd.dimension_slice_id, NULL) == 0)
-			dimension_slice_delete_by_id(cc->fd.dimension_slice_id, false);
+	if (ctx->num_chunks >= ctx->capacity)
+	{
+		ctx->capacity *= 2;
+		ctx->chunks = repalloc(ctx->chunks, sizeof(Chunk *) * ctx->capacity);
+		ctx->chunk_ids = repalloc(ctx->chunk_ids, sizeof(int32) * ctx->capacity);
 	}
 
-	catalog_become_owner(catalog_get(), &sec_ctx);
-	catalog_delete(ti->scanrel, ti->tuple);
-	catalog_restore_user(&sec_ctx);
+	ctx->chunks[ctx->num_chunks] = chunk;
+	ctx->chunk_ids[ctx->num_chunks] = chunk->fd.id;
+	ctx->num_chunks++;
 
 	return true;
 }
 
-int
-chunk_delete_by_name(const char *schema, const char *table)
+static ChunkConstraints *
+chunk_load_get_constraints(int32 chunk_id, void *data)
 {
-	ScanKeyData scankey[2];
-
-	ScanKeyInit(&scankey[0], Anum_chunk_schema_name_idx_schema_name, BTEqualStrategyNumber,
-				F_NAMEEQ, DirectFunctionCall1(namein, CStringGetDatum(schema)));
-	ScanKeyInit(&scankey[1], Anum_chunk_schema_name_idx_table_name, BTEqualStrategyNumber,
-				F_NAMEEQ, DirectFunctionCall1(namein, CStringGetDatum(table)));
+	ChunkLoadCtx *ctx = data;
+	ChunkScanEntry *entry = hash_search(ctx->htab, &chunk_id, HASH_FIND, NULL);
 
-	return chunk_scan_internal(CHUNK_SCHEMA_NAME_INDEX, scankey, 2,
-							   chunk_tuple_delete, NULL, 0,
-							   RowExclusiveLock);
+	return NULL == entry ? NULL : entry->chunk->constraints;
 }
 
-int
-chunk_delete_by_relid(Oid relid)
+static DimensionSlice *
+chunk_load_find_slice(DimensionVec *slices, int32 dimension_slice_id)
 {
-	if (!OidIsValid(relid))
-		return 0;
+	int			low = 0;
+	int			high = slices->num_slices - 1;
 
-	return chunk_delete_by_name(get_namespace_name(get_rel_namespace(relid)), get_rel_name(relid));
-}
+	/* The slices are ordered by ID */
+	while (low <= high)
+	{
+		int			mid = low + (high - low) / 2;
+		DimensionSlice *slice = slices->slices[mid];
 
-int
-chunk_delete_by_hypertable_id(int32 hypertable_id)
-{
-	ScanKeyData scankey[1];
+		if (slice->fd.id == dimension_slice_id)
+			return slice;
 
-	ScanKeyInit(&scankey[0], Anum_chunk_hypertable_id_idx_hypertable_id, BTEqualStrategyNumber,
-				F_INT4EQ, Int32GetDatum(hypertable_id));
+		if (slice->fd.id < dimension_slice_id)
+			low = mid + 1;
+		else
+			high = mid - 1;
+	}
 
-	return chunk_scan_internal(CHUNK_HYPERTABLE_ID_INDEX, scankey, 1,
-							   chunk_tuple_delete, NULL, 0,
-							   RowExclusiveLock);
+	return NULL;
 }
 
-static bool
-chunk_recreate_constraint(ChunkScanCtx *ctx, Chunk *chunk)
+static int
+chunk_cmp_table_id(const void *left, const void *right)
 {
-	ChunkConstraints *ccs = chunk->constraints;
-	int			i;
+	const Chunk *lchunk = *((const Chunk **) left);
+	const Chunk *rchunk = *((const Chunk **) right);
 
-	chunk_fill_stub(chunk, false);
+	if (lchunk->table_id == rchunk->table_id)
+		return 0;
 
-	for (i = 0; i < ccs->num_constraints; i++)
+	return lchunk->table_id < rchunk->table_id ? -1 : 1;
+}
+
+/*
+ * Get all chunks of a hypertable, including their constraints and hypercubes.
+ *
+ * Getting the chunks one by one takes several catalog scans per chunk. Here,
+ * the chunks, their constraints, and their dimension slices are instead each
+ * fetched with a single index scan.
+ *
+ * Returns a list of chunks ordered by table OID, like the children returned by
+ * find_inheritance_children().
+ */
+List *
+chunk_get_all_by_hypertable_id(int32 hypertable_id, int16 num_constraints)
+{
+	struct HASHCTL hctl = {
+		.keysize = sizeof(int32),
+		.entrysize = sizeof(ChunkScanEntry),
+		.hcxt = CurrentMemoryContext,
+	};
+	ChunkLoadCtx ctx = {
+		.htab = hash_create("chunk-load-context", 20, &hctl, HASH_ELEM | HASH_CONTEXT | HASH_BLOBS),
+		.hypertable_relid = hypertable_id_to_relid(hypertable_id),
+		.num_constraints = num_constraints,
+		.num_chunks = 0,
+		.capacity = 20,
+	};
+	ScanKeyData scankey[1];
+	DimensionVec *slices;
+	int32	   *slice_ids;
+	int			num_slice_ids = 0;
+	List	   *chunks = NIL;
+	int			i;
+
+	ctx.chunks = palloc(sizeof(Chunk *) * ctx.capacity);
+	ctx.chunk_ids = palloc(sizeof(int32) * ctx.capacity);
+
+	ScanKeyInit(&scankey[0], Anum_chunk_hypertable_id_idx_hypertable_id, BTEqualStrategyNumber,
+				F_INT4EQ, Int32GetDatum(hypertable_id));
+
+	chunk_scan_internal(CHUNK_HYPERTABLE_ID_INDEX, scankey, 1,
+						chunk_tuple_load, &ctx, 0, AccessShareLock);
+
+	chunk_constraint_scan_by_chunk_ids(ctx.chunk_ids, ctx.num_chunks,
+									   chunk_load_get_constraints, &ctx);
+
+	for (i = 0; i < ctx.num_chunks; i++)
+		num_slice_ids += ctx.chunks[i]->constraints->num_dimension_constraints;
+
+	slice_ids = palloc(sizeof(int32) * (num_slice_ids + 1));
+	num_slice_ids = 0;
+
+	for (i = 0; i < ctx.num_chunks; i++)
+	{
+		ChunkConstraints *ccs = ctx.chunks[i]->constraints;
+		int			j;
+
+		for (j = 0; j < ccs->num_constraints; j++)
+			if (is_dimension_constraint(&ccs->constraints[j]))
+				slice_ids[num_slice_ids++] = ccs->constraints[j].fd.dimension_slice_id;
+	}
+
+	slices = dimension_slice_scan_by_ids(slice_ids, num_slice_ids);
+
+	for (i = 0; i < ctx.num_chunks; i++)
+	{
+		Chunk	   *chunk = ctx.chunks[i];
+		ChunkConstraints *ccs = chunk->constraints;
+		int			j;
+
+		chunk->cube = hypercube_alloc(ccs->num_dimension_constraints);
+
+		for (j = 0; j < ccs->num_constraints; j++)
+		{
+			ChunkConstraint *cc = &ccs->constraints[j];
+
+			if (is_dimension_constraint(cc))
+			{
+				DimensionSlice *slice = chunk_load_find_slice(slices, cc->fd.dimension_slice_id);
+
+				Assert(slice != NULL);
+				hypercube_add_slice(chunk->cube, dimension_slice_copy(slice));
+			}
+		}
+	}
+
+	qsort(ctx.chunks, ctx.num_chunks, sizeof(Chunk *), chunk_cmp_table_id);
+
+	for (i = 0; i < ctx.num_chunks; i++)
+		chunks = lappend(chunks, ctx.chunks[i]);
+
+	hash_destroy(ctx.htab);
+
+	return chunks;
+}
+
+typedef struct ChunkCollectCtx
+{
+	int			num_dimensions;
+	List	   *chunks;
+} ChunkCollectCtx;
+
+static bool
+chunk_collect_if_complete(ChunkScanCtx *scanctx, Chunk *chunk)
+{
+	ChunkCollectCtx *collect = scanctx->data;
+
+	if (chunk->constraints->num_dimension_constraints != collect->num_dimensions)
+		return false;
+
+	collect->chunks = lappend(collect->chunks, chunk);
+
+	return true;
+}
+
+/*
+ * Find the chunks of a hypertable that have a slice colliding with each of
+ * the given slices. The slices restrict distinct dimensions, while the other
+ * dimensions of the hyperspace are not restricted.
+ *
+ * Unlike chunk_get_all_by_hypertable_id(), only the dimension slices within
+ * the given ranges, and the chunks that have them, are read from the
+ * catalog. The cubes of the returned chunks only hold the slices of the
+ * restricted dimensions.
+ *
+ * Returns a list of chunks ordered by table OID, like the children returned by
+ * find_inheritance_children().
+ */
+List *
+chunk_find_all_colliding(Hyperspace *hs, DimensionSlice **slices, int num_slices)
+{
+	ChunkScanCtx ctx;
+	ChunkCollectCtx collect = {
+		.num_dimensions = num_slices,
+		.chunks = NIL,
+	};
+	Chunk	  **chunks;
+	List	   *result = NIL;
+	ListCell   *lc;
+	int			num_chunks = 0;
+	int			i;
+
+	chunk_scan_ctx_init(&ctx, hs, NULL);
+
+	for (i = 0; i < num_slices; i++)
+	{
+		DimensionVec *vec = dimension_slice_collision_scan(slices[i]->fd.dimension_id,
+														   slices[i]->fd.range_start,
+														   slices[i]->fd.range_end);
+
+		dimension_slice_and_chunk_constraint_join(&ctx, vec);
+	}
+
+	ctx.data = &collect;
+	chunk_scan_ctx_foreach_chunk(&ctx, chunk_collect_if_complete, 0);
+	chunk_scan_ctx_destroy(&ctx);
+
+	chunks = palloc(sizeof(Chunk *) * (list_length(collect.chunks) + 1));
+
+	foreach(lc, collect.chunks)
+		chunks[num_chunks++] = chunk_fill_stub(lfirst(lc), false);
+
+	qsort(chunks, num_chunks, sizeof(Chunk *), chunk_cmp_table_id);
+
+	for (i = 0; i < num_chunks; i++)
+		result = lappend(result, chunks[i]);
+
+	return result;
+}
+
+/*
+ * Check if a hypertable has any chunks, without reading them.
+ */
+bool
+chunk_exists_for_hypertable(int32 hypertable_id)
+{
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_chunk_hypertable_id_idx_hypertable_id, BTEqualStrategyNumber,
+				F_INT4EQ, Int32GetDatum(hypertable_id));
+
+	return chunk_scan_internal(CHUNK_HYPERTABLE_ID_INDEX, scankey, 1,
+							   NULL, NULL, 1, AccessShareLock) > 0;
+}
+
+typedef struct ChunkRelidEntry
+{
+	Oid			relid;
+	Chunk	   *chunk;
+} ChunkRelidEntry;
+
+/*
+ * Get all chunks of a hypertable in a hash table keyed on the chunks' table
+ * OIDs. This is useful to find the chunks among the children of an append
+ * relation with a single batched load.
+ */
+HTAB *
+chunk_relid_htab_create(int32 hypertable_id, int16 num_constraints)
+{
+	struct HASHCTL hctl = {
+		.keysize = sizeof(Oid),
+		.entrysize = sizeof(ChunkRelidEntry),
+		.hcxt = CurrentMemoryContext,
+	};
+	List	   *chunks = chunk_get_all_by_hypertable_id(hypertable_id, num_constraints);
+	HTAB	   *htab;
+	ListCell   *lc;
+
+	htab = hash_create("chunk-relid-htab", list_length(chunks) + 1, &hctl,
+					   HASH_ELEM | HASH_CONTEXT | HASH_BLOBS);
+
+	foreach(lc, chunks)
+	{
+		Chunk	   *chunk = lfirst(lc);
+		ChunkRelidEntry *entry = hash_search(htab, &chunk->table_id, HASH_ENTER, NULL);
+
+		entry->chunk = chunk;
+	}
+
+	return htab;
+}
+
+Chunk *
+chunk_relid_htab_lookup(HTAB *htab, Oid relid)
+{
+	ChunkRelidEntry *entry = hash_search(htab, &relid, HASH_FIND, NULL);
+
+	return NULL == entry ? NULL : entry->chunk;
+}
+
+bool
+chunk_exists(const char *schema_name, const char *table_name)
+{
+	return chunk_get_by_name(schema_name, table_name, 0, false) != NULL;
+}
+
+bool
+chunk_exists_relid(Oid relid)
+{
+	return chunk_get_by_relid(relid, 0, false) != NULL;
+}
+
+static bool
+chunk_tuple_delete(TupleInfo *ti, void *data)
+{
+	FormData_chunk *form = (FormData_chunk *) GETSTRUCT(ti->tuple);
+	CatalogSecurityContext sec_ctx;
+	ChunkConstraints *ccs = chunk_constraints_alloc(2);
+	int			i;
+
+	chunk_constraint_delete_by_chunk_id(form->id, ccs);
+	chunk_index_delete_by_chunk_id(form->id, true);
+	compressed_chunk_delete_by_chunk_id(form->id, true);
+	chunk_time_range_delete_by_chunk_id(form->id);
+	chunk_bloom_filter_delete_by_chunk_id(form->id);
+
+	/* Check for dimension slices that are orphaned by the chunk deletion */
+	for (i = 0; i < ccs->num_constraints; i++)
+	{
+		ChunkConstraint *cc = &ccs->constraints[i];
+
+		/*
+		 * Delete the dimension slice if there are no remaining constraints
+		 * referencing it
+		 */
+		if (is_dimension_constraint(cc) &&
+			chunk_constraint_scan_by_dimension_slice_id(cc->fd.dimension_slice_id, NULL) == 0)
+			dimension_slice_delete_by_id(cc->fd.dimension_slice_id, false);
+	}
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+int
+chunk_delete_by_name(const char *schema, const char *table)
+{
+	ScanKeyData scankey[2];
+
+	ScanKeyInit(&scankey[0], Anum_chunk_schema_name_idx_schema_name, BTEqualStrategyNumber,
+				F_NAMEEQ, DirectFunctionCall1(namein, CStringGetDatum(schema)));
+	ScanKeyInit(&scankey[1], Anum_chunk_schema_name_idx_table_name, BTEqualStrategyNumber,
+				F_NAMEEQ, DirectFunctionCall1(namein, CStringGetDatum(table)));
+
+	return chunk_scan_internal(CHUNK_SCHEMA_NAME_INDEX, scankey, 2,
+							   chunk_tuple_delete, NULL, 0,
+							   RowExclusiveLock);
+}
+
+int
+chunk_delete_by_relid(Oid relid)
+{
+	if (!OidIsValid(relid))
+		return 0;
+
+	return chunk_delete_by_name(get_namespace_name(get_rel_namespace(relid)), get_rel_name(relid));
+}
+
+int
+chunk_delete_by_hypertable_id(int32 hypertable_id)
+{
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_chunk_hypertable_id_idx_hypertable_id, BTEqualStrategyNumber,
+				F_INT4EQ, Int32GetDatum(hypertable_id));
+
+	return chunk_scan_internal(CHUNK_HYPERTABLE_ID_INDEX, scankey, 1,
+							   chunk_tuple_delete, NULL, 0,
+							   RowExclusiveLock);
+}
+
+/* The chunk tables to drop with chunk_drop_all() */
+typedef struct ChunkDropAllCtx
+{
+	ObjectAddresses *objects;
+	int			num_tables;
+} ChunkDropAllCtx;
+
+static bool
+chunk_tuple_delete_all_metadata(TupleInfo *ti, void *data)
+{
+	FormData_chunk *form = (FormData_chunk *) GETSTRUCT(ti->tuple);
+	ChunkDropAllCtx *ctx = data;
+	ObjectAddress tableobj = {
+		.classId = RelationRelationId,
+		.objectId = get_relname_relid(NameStr(form->table_name),
+									  get_namespace_oid(NameStr(form->schema_name), true)),
+	};
+
+	if (OidIsValid(tableobj.objectId))
+	{
+		LockRelationOid(tableobj.objectId, AccessExclusiveLock);
+		add_exact_object_address(&tableobj, ctx->objects);
+		ctx->num_tables++;
+	}
+
+	chunk_constraint_delete_metadata_by_chunk_id(form->id, NULL);
+	compressed_chunk_delete_by_chunk_id(form->id, false);
+	chunk_time_range_delete_by_chunk_id(form->id);
+	chunk_bloom_filter_delete_by_chunk_id(form->id);
+	catalog_delete_only(ti->scanrel, ti->tuple);
+
+	return true;
+}
+
+/*
+ * Drop all chunks of a hypertable, e.g., when it is truncated or dropped.
+ *
+ * Since no chunk remains, the catalog metadata is deleted by hypertable, and
+ * the dimension slices by dimension, instead of chunk by chunk with a check
+ * for orphaned slices and cache invalidations for each. The chunk tables are
+ * then dropped with a single deletion, like in drop_chunks(). The tables are
+ * those of the chunk catalog, since other tables can inherit from the
+ * hypertable too.
+ *
+ * Returns the number of dropped chunk tables.
+ */
+int
+chunk_drop_all(Hypertable *ht, DropBehavior behavior)
+{
+	ChunkDropAllCtx ctx = {
+		.objects = new_object_addresses(),
+		.num_tables = 0,
+	};
+	CatalogSecurityContext sec_ctx;
+	ScanKeyData scankey[1];
+	int			i;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+
+	ScanKeyInit(&scankey[0], Anum_chunk_hypertable_id_idx_hypertable_id, BTEqualStrategyNumber,
+				F_INT4EQ, Int32GetDatum(ht->fd.id));
+
+	chunk_scan_internal(CHUNK_HYPERTABLE_ID_INDEX, scankey, 1,
+						chunk_tuple_delete_all_metadata, &ctx, 0,
+						RowExclusiveLock);
+	chunk_index_delete_by_hypertable_id(ht->fd.id, false);
+
+	for (i = 0; i < ht->space->num_dimensions; i++)
+		dimension_slice_delete_by_dimension_id(ht->space->dimensions[i].fd.id, false);
+
+	catalog_restore_user(&sec_ctx);
+
+	CacheInvalidateRelcacheByRelid(ht->main_table_relid);
+	CommandCounterIncrement();
+
+	performMultipleDeletions(ctx.objects, behavior, 0);
+
+	return ctx.num_tables;
+}
+
+static bool
+chunk_recreate_constraint(ChunkScanCtx *ctx, Chunk *chunk)
+{
+	ChunkConstraints *ccs = chunk->constraints;
+	int			i;
+
+	chunk_fill_stub(chunk, false);
+
+	for (i = 0; i < ccs->num_constraints; i++)
 		chunk_constraint_recreate(&ccs->constraints[i], chunk->table_id);
 
 	return true;
@@ -1086,3 +1943,1292 @@ chunk_recreate_all_constraints_for_dimension(Hyperspace *hs, int32 dimension_id)
 	chunk_scan_ctx_foreach_chunk(&chunkctx, chunk_recreate_constraint, 0);
 	chunk_scan_ctx_destroy(&chunkctx);
 }
+
+/*
+ * Create the chunks for all closed-dimension partitions at the given open
+ * dimension coordinate. The point's open coordinate must already be set.
+ *
+ * Returns the number of chunks that were created.
+ */
+static int
+chunk_create_for_all_partitions(Hypertable *ht, Point *p, int dimindex)
+{
+	Hyperspace *hs = ht->space;
+	Dimension  *dim;
+	int64		interval;
+	int			created = 0;
+	int			i;
+
+	if (dimindex >= hs->num_dimensions)
+	{
+		Chunk	   *chunk = chunk_find(hs, p);
+
+		if (NULL != chunk)
+		{
+			chunk_free(chunk);
+			return 0;
+		}
+
+		chunk = chunk_create(ht, p,
+							 NameStr(ht->fd.associated_schema_name),
+							 NameStr(ht->fd.associated_table_prefix));
+
+		/* The chunk has no rows until inserted into */
+		chunk_time_range_insert_empty(chunk->fd.id);
+		return 1;
+	}
+
+	dim = &hs->dimensions[dimindex];
+	Assert(IS_CLOSED_DIMENSION(dim));
+
+	/* Same slicing as calculate_closed_range_default() */
+	interval = DIMENSION_SLICE_CLOSED_MAX / ((int64) dim->fd.num_slices);
+
+	for (i = 0; i < dim->fd.num_slices; i++)
+	{
+		p->coordinates[dimindex] = interval * i;
+		created += chunk_create_for_all_partitions(ht, p, dimindex + 1);
+	}
+
+	return created;
+}
+
+TS_FUNCTION_INFO_V1(chunk_create_ahead);
+
+/*
+ * Pre-create chunks ahead of the data.
+ *
+ * Makes sure that chunks exist, in every space partition, for the time
+ * interval that covers "from_time" and for the "num_intervals" following
+ * intervals. This way, inserts that reach a new time interval find the chunks
+ * already in place instead of creating tables (and taking the chunk creation
+ * lock) on the insert path. If "from_time" is not given, the current
+ * transaction's start time is used, which requires a time column of a
+ * timestamp or date type.
+ *
+ * Returns the number of chunks that were created.
+ */
+Datum
+chunk_create_ahead(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_GETARG_OID(0);
+	int32		num_intervals = PG_ARGISNULL(1) ? 1 : PG_GETARG_INT32(1);
+	Cache	   *hcache;
+	Hypertable *ht;
+	Dimension  *time_dim;
+	Point	   *p;
+	int64		start;
+	int			created = 0;
+	int32		i;
+
+	hypertable_permissions_check(table_relid, GetUserId());
+
+	if (num_intervals < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid number of intervals: must be zero or greater")));
+
+	hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry(hcache, table_relid);
+
+	if (NULL == ht)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_HYPERTABLE_NOT_EXIST),
+				 errmsg("table \"%s\" is not a hypertable",
+						get_rel_name(table_relid))));
+
+	if (hyperspace_get_num_dimensions_by_type(ht->space, DIMENSION_TYPE_OPEN) != 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("hypertable \"%s\" does not have exactly one time dimension",
+						get_rel_name(table_relid))));
+
+	/* Open dimensions are stored before closed ones */
+	time_dim = &ht->space->dimensions[0];
+	Assert(IS_OPEN_DIMENSION(time_dim));
+
+	if (PG_NARGS() > 2 && !PG_ARGISNULL(2))
+		start = time_value_to_internal(PG_GETARG_DATUM(2),
+									   get_fn_expr_argtype(fcinfo->flinfo, 2));
+	else
+	{
+		switch (time_dim->fd.column_type)
+		{
+			case TIMESTAMPOID:
+			case TIMESTAMPTZOID:
+			case DATEOID:
+				start = time_value_to_internal(TimestampTzGetDatum(GetCurrentTransactionStartTimestamp()),
+											   TIMESTAMPTZOID);
+				break;
+			default:
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("a start time is required for hypertables with an integer time column")));
+				start = 0;		/* keep compiler quiet */
+				break;
+		}
+	}
+
+	p = point_create(ht->space->num_dimensions);
+	p->num_coords = ht->space->num_dimensions;
+
+	for (i = 0; i <= num_intervals; i++)
+	{
+		/* Stop if the next interval would go beyond the end of time */
+		if (i > 0 && DIMENSION_SLICE_MAXVALUE - start < time_dim->fd.interval_length)
+			break;
+
+		if (i > 0)
+			start += time_dim->fd.interval_length;
+
+		p->coordinates[0] = start;
+		created += chunk_create_for_all_partitions(ht, p, 1);
+	}
+
+	pfree(p);
+	cache_release(hcache);
+
+	PG_RETURN_INT32(created);
+}
+
+static bool
+chunk_tuple_delete_metadata(TupleInfo *ti, void *data)
+{
+	catalog_delete_only(ti->scanrel, ti->tuple);
+	return true;
+}
+
+/*
+ * Delete the catalog metadata of a chunk, but not its table, constraints, or
+ * indexes, which are dropped with the table. No caches are invalidated.
+ *
+ * Returns the given list with the IDs of the chunk's dimension slices
+ * added. The slices might be orphaned by the deletion.
+ */
+static List *
+chunk_delete_metadata(Chunk *chunk, List *slice_ids)
+{
+	ChunkConstraints *ccs = chunk_constraints_alloc(2);
+	ScanKeyData scankey[1];
+	int			i;
+
+	chunk_constraint_delete_metadata_by_chunk_id(chunk->fd.id, ccs);
+	chunk_index_delete_by_chunk_id(chunk->fd.id, false);
+	compressed_chunk_delete_by_chunk_id(chunk->fd.id, false);
+	chunk_time_range_delete_by_chunk_id(chunk->fd.id);
+	chunk_bloom_filter_delete_by_chunk_id(chunk->fd.id);
+
+	for (i = 0; i < ccs->num_constraints; i++)
+		if (is_dimension_constraint(&ccs->constraints[i]))
+			slice_ids = list_append_unique_int(slice_ids, ccs->constraints[i].fd.dimension_slice_id);
+
+	ScanKeyInit(&scankey[0], Anum_chunk_idx_id, BTEqualStrategyNumber,
+				F_INT4EQ, Int32GetDatum(chunk->fd.id));
+
+	chunk_scan_internal(CHUNK_ID_INDEX, scankey, 1,
+						chunk_tuple_delete_metadata, NULL, 1,
+						RowExclusiveLock);
+
+	return slice_ids;
+}
+
+/*
+ * Get the chunks of a hypertable whose range in the time dimension ends at or
+ * before the given time, or all chunks if there is no time given.
+ *
+ * The chunks are found through the time dimension's slices, so only the
+ * catalog rows of the matching slices and their chunks are read. The chunks
+ * are ordered by the start of their time range.
+ */
+List *
+chunk_get_all_ending_before(Hypertable *ht, int64 older_than, bool all_times)
+{
+	Dimension  *time_dim = hyperspace_get_open_dimension(ht->space, 0);
+	DimensionVec *slices;
+	List	   *chunks = NIL;
+	int			i;
+
+	if (NULL == time_dim)
+		return NIL;
+
+	if (all_times)
+		slices = dimension_slice_scan_by_dimension(time_dim->fd.id, 0);
+	else
+		slices = dimension_slice_scan_ending_before(time_dim->fd.id, older_than, 0);
+
+	for (i = 0; i < slices->num_slices; i++)
+	{
+		ChunkConstraints *ccs = chunk_constraints_alloc(1);
+		int			j;
+
+		chunk_constraint_scan_by_dimension_slice_id(slices->slices[i]->fd.id, ccs);
+
+		for (j = 0; j < ccs->num_constraints; j++)
+			chunks = lappend(chunks, chunk_get_by_id(ccs->constraints[j].fd.chunk_id, 0, true));
+	}
+
+	return chunks;
+}
+
+TS_FUNCTION_INFO_V1(chunk_drop_chunks);
+
+/*
+ * Drop the chunks older than a time, given in the internal time format, of the
+ * hypertables with the given schema and table name. A NULL argument matches
+ * all values.
+ *
+ * Dropping the chunks one by one with DROP TABLE deletes the metadata,
+ * constraints, and indexes of each chunk one object at a time, with catalog
+ * lookups and cache invalidations for each. Instead, the metadata of all
+ * chunks is deleted in one pass with a single cache invalidation per
+ * hypertable, and the tables are dropped with a single deletion, which also
+ * drops the objects that belong to them. The rows of chunks on data nodes are
+ * deleted from the nodes one chunk at a time, though.
+ */
+Datum
+chunk_drop_chunks(PG_FUNCTION_ARGS)
+{
+	bool		all_times = PG_ARGISNULL(0);
+	int64		older_than = all_times ? 0 : PG_GETARG_INT64(0);
+	Name		table_name = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1);
+	Name		schema_name = PG_ARGISNULL(2) ? NULL : PG_GETARG_NAME(2);
+	bool		cascade = PG_ARGISNULL(3) ? false : PG_GETARG_BOOL(3);
+	bool		truncate_before = PG_ARGISNULL(4) ? false : PG_GETARG_BOOL(4);
+	ObjectAddresses *objects = new_object_addresses();
+	List	   *hypertables;
+	List	   *relations = NIL;
+	List	   *slice_ids = NIL;
+	CatalogSecurityContext sec_ctx;
+	ListCell   *lc;
+
+	if (all_times && NULL == table_name && NULL == schema_name)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("Cannot have all 3 arguments to drop_chunks_older_than be NULL")));
+
+	hypertables = hypertable_get_all_by_name(NULL == schema_name ? NULL : NameStr(*schema_name),
+											 NULL == table_name ? NULL : NameStr(*table_name));
+
+	if (NULL != table_name && NIL == hypertables)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_HYPERTABLE_NOT_EXIST),
+				 errmsg("hypertable %s does not exist", NameStr(*table_name))));
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+
+	foreach(lc, hypertables)
+	{
+		Hypertable *ht = lfirst(lc);
+		List	   *chunks = chunk_get_all_ending_before(ht, older_than, all_times);
+		ListCell   *lc_chunk;
+
+		if (NIL == chunks)
+			continue;
+
+		/*
+		 * With cascade, the continuous aggregates of the hypertable forget
+		 * the dropped data too. Otherwise, they keep their buckets of it.
+		 */
+		if (cascade && all_times)
+			continuous_agg_invalidate_all(ht);
+		else if (cascade && ht->has_continuous_aggs && older_than > PG_INT64_MIN)
+			continuous_agg_invalidation_add(ht->fd.id, PG_INT64_MIN, older_than - 1);
+
+		foreach(lc_chunk, chunks)
+		{
+			Chunk	   *chunk = lfirst(lc_chunk);
+			ObjectAddress tableobj = {
+				.classId = RelationRelationId,
+				.objectId = chunk->table_id,
+			};
+
+			if (OidIsValid(chunk->table_id))
+			{
+				/* Check permissions and lock like DROP TABLE */
+				if (!pg_class_ownercheck(chunk->table_id, sec_ctx.saved_uid))
+					aclcheck_error(ACLCHECK_NOT_OWNER, ACL_KIND_CLASS,
+								   get_rel_name(chunk->table_id));
+
+				LockRelationOid(chunk->table_id, AccessExclusiveLock);
+				add_exact_object_address(&tableobj, objects);
+
+				if (get_rel_relkind(chunk->table_id) == RELKIND_FOREIGN_TABLE)
+				{
+					/* As the user, whose user mapping connects to the node */
+					catalog_restore_user(&sec_ctx);
+					data_node_chunk_delete_rows(chunk->table_id);
+					catalog_become_owner(catalog_get(), &sec_ctx);
+				}
+				else
+					relations = lappend(relations,
+										makeRangeVar(NameStr(chunk->fd.schema_name),
+													 NameStr(chunk->fd.table_name), -1));
+			}
+
+			slice_ids = chunk_delete_metadata(chunk, slice_ids);
+		}
+
+		CacheInvalidateRelcacheByRelid(ht->main_table_relid);
+	}
+
+	/* Make the deleted chunk constraints invisible to the orphan check */
+	CommandCounterIncrement();
+
+	foreach(lc, slice_ids)
+	{
+		int32		slice_id = lfirst_int(lc);
+
+		if (chunk_constraint_scan_by_dimension_slice_id(slice_id, NULL) == 0)
+			dimension_slice_delete_by_id(slice_id, false);
+	}
+
+	catalog_restore_user(&sec_ctx);
+
+	if (truncate_before && NIL != relations)
+	{
+		TruncateStmt *stmt = makeNode(TruncateStmt);
+
+		stmt->relations = relations;
+		stmt->restart_seqs = false;
+		stmt->behavior = cascade ? DROP_CASCADE : DROP_RESTRICT;
+		ExecuteTruncate(stmt);
+	}
+
+	performMultipleDeletions(objects, cascade ? DROP_CASCADE : DROP_RESTRICT, 0);
+
+	PG_RETURN_VOID();
+}
+
+/* A chunk considered for merging, with its slice in the time dimension */
+typedef struct MergeCandidate
+{
+	Chunk	   *chunk;
+	DimensionSlice *time_slice;
+} MergeCandidate;
+
+/*
+ * Compare merge candidates by their slices in all dimensions except time.
+ * Candidates that compare equal are in the same space partition.
+ */
+static int
+merge_candidate_cmp_partition(const MergeCandidate *lc, const MergeCandidate *rc)
+{
+	Hypercube  *lcube = lc->chunk->cube;
+	Hypercube  *rcube = rc->chunk->cube;
+	int			i;
+
+	Assert(lcube->num_slices == rcube->num_slices);
+
+	for (i = 0; i < lcube->num_slices; i++)
+	{
+		if (lcube->slices[i]->fd.dimension_id == lc->time_slice->fd.dimension_id)
+			continue;
+
+		if (lcube->slices[i]->fd.id != rcube->slices[i]->fd.id)
+			return lcube->slices[i]->fd.id < rcube->slices[i]->fd.id ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Order merge candidates by space partition and then by the start of their
+ * time range.
+ */
+static int
+merge_candidate_cmp(const void *left, const void *right)
+{
+	const MergeCandidate *lc = left;
+	const MergeCandidate *rc = right;
+	int			cmp = merge_candidate_cmp_partition(lc, rc);
+
+	if (cmp != 0)
+		return cmp;
+
+	if (lc->time_slice->fd.range_start == rc->time_slice->fd.range_start)
+		return 0;
+
+	return lc->time_slice->fd.range_start < rc->time_slice->fd.range_start ? -1 : 1;
+}
+
+/*
+ * Copy all rows of a chunk into another chunk of the same hypertable and
+ * insert them into the target chunk's indexes. The chunks might have
+ * different physical layouts, e.g., because of dropped columns, so the rows
+ * are converted by column name. The caller must hold a lock on the source
+ * chunk that blocks writes.
+ */
+static void
+chunk_copy_rows(Oid src_relid, Relation dst_rel, EState *estate, TupleTableSlot *slot,
+				BulkInsertState bistate, CommandId cid)
+{
+	ResultRelInfo *result_rel_info = estate->es_result_relation_info;
+	Relation	src_rel = heap_open(src_relid, NoLock);
+	TupleConversionMap *map = convert_tuples_by_name(RelationGetDescr(src_rel),
+													 RelationGetDescr(dst_rel),
+													 gettext_noop("could not convert row type"));
+	Snapshot	snapshot = RegisterSnapshot(GetLatestSnapshot());
+	HeapScanDesc scan = heap_beginscan(src_rel, snapshot, 0, NULL);
+	HeapTuple	src_tuple;
+
+	while ((src_tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		HeapTuple	tuple;
+
+		CHECK_FOR_INTERRUPTS();
+		ResetPerTupleExprContext(estate);
+
+		if (NULL != map)
+			tuple = do_convert_tuple(src_tuple, map);
+		else
+			tuple = heap_copytuple(src_tuple);
+
+		heap_insert(dst_rel, tuple, cid, 0, bistate);
+		ExecStoreTuple(tuple, slot, InvalidBuffer, true);
+
+		if (result_rel_info->ri_NumIndices > 0)
+			list_free(ExecInsertIndexTuples(slot, &tuple->t_self, estate, false, NULL, NIL));
+	}
+
+	heap_endscan(scan);
+	UnregisterSnapshot(snapshot);
+	ExecClearTuple(slot);
+
+	if (NULL != map)
+		free_conversion_map(map);
+
+	heap_close(src_rel, NoLock);
+}
+
+/*
+ * Merge a run of adjacent chunks into the first chunk of the run.
+ *
+ * The first chunk's time constraint is replaced with one for a slice that
+ * spans the whole run, the rows of the other chunks are copied into it, and
+ * the metadata of the other chunks is deleted. The tables of the other chunks
+ * are added to the objects to drop.
+ *
+ * Returns the given list with the IDs of slices that might be orphaned.
+ */
+static List *
+chunk_merge_run(Dimension *time_dim, MergeCandidate *run, int num_chunks,
+				Oid userid, ObjectAddresses *objects, List *slice_ids)
+{
+	Chunk	   *target = run[0].chunk;
+	DimensionSlice *slice = dimension_slice_create(time_dim->fd.id,
+												   run[0].time_slice->fd.range_start,
+												   run[num_chunks - 1].time_slice->fd.range_end);
+	Relation	rel;
+	EState	   *estate;
+	ResultRelInfo *result_rel_info;
+	TupleTableSlot *slot;
+	BulkInsertState bistate;
+	CommandId	cid;
+	int64		min_time,
+				max_time;
+	int			i;
+
+	for (i = 0; i < num_chunks; i++)
+	{
+		/* Check permissions and lock like DROP TABLE */
+		if (!pg_class_ownercheck(run[i].chunk->table_id, userid))
+			aclcheck_error(ACLCHECK_NOT_OWNER, ACL_KIND_CLASS,
+						   get_rel_name(run[i].chunk->table_id));
+
+		LockRelationOid(run[i].chunk->table_id, AccessExclusiveLock);
+	}
+
+	/* Reuse an existing slice with the merged range, e.g., from another partition */
+	dimension_slice_scan_for_existing(slice);
+	dimension_slice_insert(slice);
+
+	chunk_constraint_replace_dimension_slice(target, run[0].time_slice->fd.id, slice->fd.id);
+	slice_ids = list_append_unique_int(slice_ids, run[0].time_slice->fd.id);
+
+	/* The merged chunk gets values that its bloom filters do not cover */
+	chunk_bloom_filter_delete_by_chunk_id(target->fd.id);
+
+	rel = heap_open(target->table_id, NoLock);
+	cid = GetCurrentCommandId(true);
+	estate = CreateExecutorState();
+	result_rel_info = makeNode(ResultRelInfo);
+	InitResultRelInfoCompat(result_rel_info, rel, 1, 0);
+	ExecOpenIndices(result_rel_info, false);
+	estate->es_result_relations = result_rel_info;
+	estate->es_num_result_relations = 1;
+	estate->es_result_relation_info = result_rel_info;
+	slot = ExecInitExtraTupleSlot(estate);
+	ExecSetSlotDescriptor(slot, RelationGetDescr(rel));
+	bistate = GetBulkInsertState();
+
+	for (i = 1; i < num_chunks; i++)
+	{
+		Chunk	   *chunk = run[i].chunk;
+		ObjectAddress tableobj = {
+			.classId = RelationRelationId,
+			.objectId = chunk->table_id,
+		};
+
+		chunk_copy_rows(chunk->table_id, rel, estate, slot, bistate, cid);
+
+		/* The merged chunk's rows span the ranges of all chunks in the run */
+		if (!chunk_time_range_get(chunk->fd.id, &min_time, &max_time))
+			chunk_time_range_invalidate(target->fd.id);
+		else if (min_time <= max_time)
+			chunk_time_range_widen(target->fd.id, min_time, max_time);
+
+		slice_ids = chunk_delete_metadata(chunk, slice_ids);
+		add_exact_object_address(&tableobj, objects);
+	}
+
+	FreeBulkInsertState(bistate);
+	ExecCloseIndices(result_rel_info);
+	FreeExecutorState(estate);
+	CacheInvalidateRelcache(rel);
+	heap_close(rel, NoLock);
+
+	return slice_ids;
+}
+
+/*
+ * Convert a time argument of type "any" to the internal time format of the
+ * time dimension. Integer times are only accepted for integer time columns and
+ * vice versa.
+ */
+static int64
+chunk_time_arg_to_internal(FunctionCallInfo fcinfo, int argno, Dimension *time_dim,
+						   const char *argname)
+{
+	Oid			argtype = get_fn_expr_argtype(fcinfo->flinfo, argno);
+	bool		integer_arg = (argtype == INT2OID || argtype == INT4OID || argtype == INT8OID);
+	bool		integer_col = (time_dim->fd.column_type == INT2OID ||
+							   time_dim->fd.column_type == INT4OID ||
+							   time_dim->fd.column_type == INT8OID);
+
+	if (integer_arg != integer_col)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid type of \"%s\": %s does not match the time column",
+						argname, format_type_be(argtype))));
+
+	return time_value_to_internal(PG_GETARG_DATUM(argno), argtype);
+}
+
+TS_FUNCTION_INFO_V1(chunk_merge_chunks);
+
+/*
+ * Merge adjacent chunks of a hypertable that end before a time into chunks
+ * covering up to a target interval. Chunks are adjacent if their time ranges
+ * meet and they have the same slices in all other dimensions, i.e., they are
+ * in the same space partition. Compressed chunks are not merged.
+ *
+ * This is meant for chunks that are much smaller than they should be, e.g.,
+ * because the chunk time interval was too small when they were created. The
+ * merged chunks are locked and rewritten, so only chunks that no longer
+ * receive inserts should be merged.
+ *
+ * Returns the number of chunks that were merged into other chunks and
+ * dropped.
+ */
+Datum
+chunk_merge_chunks(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_GETARG_OID(0);
+	bool		all_times = PG_ARGISNULL(1);
+	ObjectAddresses *objects = new_object_addresses();
+	List	   *slice_ids = NIL;
+	CatalogSecurityContext sec_ctx;
+	Cache	   *hcache;
+	Hypertable *ht;
+	Dimension  *time_dim;
+	DimensionVec *slices;
+	MergeCandidate *candidates;
+	int			num_candidates = 0;
+	int			capacity;
+	int64		older_than = 0;
+	int64		target_interval;
+	int			num_merged = 0;
+	int			run_start;
+	int			i;
+	ListCell   *lc;
+
+	hypertable_permissions_check(table_relid, GetUserId());
+
+	hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry(hcache, table_relid);
+
+	if (NULL == ht)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_HYPERTABLE_NOT_EXIST),
+				 errmsg("table \"%s\" is not a hypertable",
+						get_rel_name(table_relid))));
+
+	if (hyperspace_get_num_dimensions_by_type(ht->space, DIMENSION_TYPE_OPEN) != 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("hypertable \"%s\" does not have exactly one time dimension",
+						get_rel_name(table_relid))));
+
+	time_dim = hyperspace_get_open_dimension(ht->space, 0);
+
+	if (!all_times)
+		older_than = chunk_time_arg_to_internal(fcinfo, 1, time_dim, "older_than");
+
+	if (PG_ARGISNULL(2))
+		target_interval = time_dim->fd.interval_length;
+	else
+		target_interval = dimension_interval_to_internal(NameStr(time_dim->fd.column_name),
+														 time_dim->fd.column_type,
+														 get_fn_expr_argtype(fcinfo->flinfo, 2),
+														 PG_GETARG_DATUM(2));
+
+	/* Block concurrent chunk creation like inserts that create chunks */
+	LockRelationOid(table_relid, ShareUpdateExclusiveLock);
+
+	if (all_times)
+		slices = dimension_slice_scan_by_dimension(time_dim->fd.id, 0);
+	else
+		slices = dimension_slice_scan_ending_before(time_dim->fd.id, older_than, 0);
+
+	capacity = Max(slices->num_slices, 1);
+	candidates = palloc(sizeof(MergeCandidate) * capacity);
+
+	for (i = 0; i < slices->num_slices; i++)
+	{
+		ChunkConstraints *ccs = chunk_constraints_alloc(1);
+		int			j;
+
+		chunk_constraint_scan_by_dimension_slice_id(slices->slices[i]->fd.id, ccs);
+
+		for (j = 0; j < ccs->num_constraints; j++)
+		{
+			Chunk	   *chunk = chunk_get_by_id(ccs->constraints[j].fd.chunk_id,
+												ht->space->num_dimensions, true);
+
+			if (!OidIsValid(chunk->table_id) ||
+				NULL != compressed_chunk_get_by_chunk_id(chunk->fd.id))
+				continue;
+
+			if (num_candidates >= capacity)
+			{
+				capacity *= 2;
+				candidates = repalloc(candidates, sizeof(MergeCandidate) * capacity);
+			}
+
+			candidates[num_candidates].chunk = chunk;
+			candidates[num_candidates].time_slice =
+				hypercube_get_slice_by_dimension_id(chunk->cube, time_dim->fd.id);
+			num_candidates++;
+		}
+	}
+
+	if (num_candidates > 1)
+		qsort(candidates, num_candidates, sizeof(MergeCandidate), merge_candidate_cmp);
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+
+	/* Find the runs of adjacent chunks that fit in the target interval */
+	run_start = 0;
+
+	for (i = 1; i <= num_candidates; i++)
+	{
+		if (i < num_candidates &&
+			merge_candidate_cmp_partition(&candidates[run_start], &candidates[i]) == 0 &&
+			candidates[i - 1].time_slice->fd.range_end == candidates[i].time_slice->fd.range_start &&
+			candidates[i].time_slice->fd.range_end - candidates[run_start].time_slice->fd.range_start <= target_interval)
+			continue;
+
+		if (i - run_start > 1)
+		{
+			slice_ids = chunk_merge_run(time_dim, &candidates[run_start], i - run_start,
+										sec_ctx.saved_uid, objects, slice_ids);
+			num_merged += i - run_start - 1;
+		}
+
+		run_start = i;
+	}
+
+	if (num_merged > 0)
+	{
+		CacheInvalidateRelcacheByRelid(ht->main_table_relid);
+
+		/* Make the deleted chunk constraints invisible to the orphan check */
+		CommandCounterIncrement();
+
+		foreach(lc, slice_ids)
+		{
+			int32		slice_id = lfirst_int(lc);
+
+			if (chunk_constraint_scan_by_dimension_slice_id(slice_id, NULL) == 0)
+				dimension_slice_delete_by_id(slice_id, false);
+		}
+	}
+
+	catalog_restore_user(&sec_ctx);
+
+	performMultipleDeletions(objects, DROP_RESTRICT, 0);
+	cache_release(hcache);
+
+	PG_RETURN_INT32(num_merged);
+}
+
+/*
+ * Check if a chunk has the same physical layout as its hypertable, so that
+ * rows routed to the chunk need no conversion.
+ */
+static bool
+chunk_rowtype_matches(TupleDesc ht_desc, TupleDesc chunk_desc)
+{
+	int			i;
+
+	if (ht_desc->natts != chunk_desc->natts || ht_desc->tdhasoid != chunk_desc->tdhasoid)
+		return false;
+
+	for (i = 0; i < ht_desc->natts; i++)
+	{
+		Form_pg_attribute ht_attr = ht_desc->attrs[i];
+		Form_pg_attribute chunk_attr = chunk_desc->attrs[i];
+
+		if (ht_attr->attisdropped != chunk_attr->attisdropped)
+			return false;
+
+		if (!ht_attr->attisdropped &&
+			(namestrcmp(&ht_attr->attname, NameStr(chunk_attr->attname)) != 0 ||
+			 ht_attr->atttypid != chunk_attr->atttypid))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Get the name of the index that a table is clustered on, if any.
+ */
+static char *
+chunk_get_clustered_index_name(Relation rel)
+{
+	List	   *indexes = RelationGetIndexList(rel);
+	char	   *name = NULL;
+	ListCell   *lc;
+
+	foreach(lc, indexes)
+	{
+		Oid			indexrelid = lfirst_oid(lc);
+		HeapTuple	tuple = SearchSysCache1(INDEXRELID, ObjectIdGetDatum(indexrelid));
+
+		if (!HeapTupleIsValid(tuple))
+			elog(ERROR, "cache lookup failed for index %u", indexrelid);
+
+		if (((Form_pg_index) GETSTRUCT(tuple))->indisclustered)
+			name = get_rel_name(indexrelid);
+
+		ReleaseSysCache(tuple);
+	}
+
+	list_free(indexes);
+
+	return name;
+}
+
+TS_FUNCTION_INFO_V1(chunk_normalize_rowtype);
+
+/*
+ * Rewrite a chunk with the physical layout of its hypertable.
+ *
+ * Chunks that were created before the first column of their hypertable was
+ * dropped lack the dropped column's position, so every row inserted into
+ * them has to be converted from the hypertable's rowtype. The chunk's rows
+ * are copied into a new table with the hypertable's layout, which then
+ * replaces the chunk's table, keeping the chunk's tablespace and storage
+ * options. The chunk's constraints, indexes and triggers are recreated on
+ * the new table.
+ *
+ * Writes to the chunk are blocked while its rows are copied, and reads while
+ * the tables are swapped.
+ *
+ * Returns true if the chunk was rewritten, or false if it already had the
+ * hypertable's layout.
+ */
+Datum
+chunk_normalize_rowtype(PG_FUNCTION_ARGS)
+{
+	Oid			chunk_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	ObjectAddress tableobj = {
+		.classId = RelationRelationId,
+	};
+	CatalogSecurityContext sec_ctx;
+	Cache	   *hcache;
+	Hypertable *ht;
+	Chunk	   *chunk;
+	Relation	ht_rel;
+	Relation	chunk_rel;
+	Relation	rel;
+	EState	   *estate;
+	ResultRelInfo *result_rel_info;
+	TupleTableSlot *slot;
+	BulkInsertState bistate;
+	char	   *tablespacename = NULL;
+	char	   *clustered_index_name;
+	const char *table_name;
+	Oid			new_relid;
+
+	if (!OidIsValid(chunk_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid chunk")));
+
+	chunk = chunk_get_by_relid(chunk_relid, 0, false);
+
+	if (NULL == chunk)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("\"%s\" is not a chunk", get_rel_name(chunk_relid))));
+
+	hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry_by_id(hcache, chunk->fd.hypertable_id);
+	hypertable_permissions_check(ht->main_table_relid, GetUserId());
+
+	if (get_rel_relkind(chunk_relid) == RELKIND_FOREIGN_TABLE)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot normalize foreign chunk \"%s\"", get_rel_name(chunk_relid))));
+
+	if (NULL != compressed_chunk_get_by_chunk_id(chunk->fd.id))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot normalize compressed chunk \"%s\"", get_rel_name(chunk_relid))));
+
+	/* Block writes, but not reads, while the rows are copied */
+	LockRelationOid(chunk_relid, ExclusiveLock);
+
+	ht_rel = heap_open(ht->main_table_relid, AccessShareLock);
+	chunk_rel = heap_open(chunk_relid, NoLock);
+
+	if (ht_rel->rd_rel->relhasoids ||
+		chunk_rowtype_matches(RelationGetDescr(ht_rel), RelationGetDescr(chunk_rel)))
+	{
+		heap_close(chunk_rel, NoLock);
+		heap_close(ht_rel, AccessShareLock);
+		cache_release(hcache);
+		PG_RETURN_BOOL(false);
+	}
+
+	if (OidIsValid(chunk_rel->rd_rel->reltablespace))
+		tablespacename = get_tablespace_name(chunk_rel->rd_rel->reltablespace);
+
+	clustered_index_name = chunk_get_clustered_index_name(chunk_rel);
+	heap_close(chunk_rel, NoLock);
+	heap_close(ht_rel, AccessShareLock);
+
+	chunk->constraints = chunk_constraint_scan_by_chunk_id(chunk->fd.id, ht->space->num_dimensions);
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+
+	table_name = ChooseRelationName(NameStr(chunk->fd.table_name), NULL, "normalized",
+									get_rel_namespace(chunk_relid));
+	new_relid = chunk_create_relation(chunk, ht, table_name, tablespacename,
+									  get_reloptions(chunk_relid), NULL);
+
+	/* Copy the rows before there are indexes to update */
+	rel = heap_open(new_relid, AccessExclusiveLock);
+	estate = CreateExecutorState();
+	result_rel_info = makeNode(ResultRelInfo);
+	InitResultRelInfoCompat(result_rel_info, rel, 1, 0);
+	estate->es_result_relations = result_rel_info;
+	estate->es_num_result_relations = 1;
+	estate->es_result_relation_info = result_rel_info;
+	slot = ExecInitExtraTupleSlot(estate);
+	ExecSetSlotDescriptor(slot, RelationGetDescr(rel));
+	bistate = GetBulkInsertState();
+
+	chunk_copy_rows(chunk_relid, rel, estate, slot, bistate, GetCurrentCommandId(true));
+
+	FreeBulkInsertState(bistate);
+	FreeExecutorState(estate);
+	heap_close(rel, NoLock);
+
+	/* Swap the tables */
+	LockRelationOid(chunk_relid, AccessExclusiveLock);
+
+	chunk_index_delete_by_chunk_id(chunk->fd.id, false);
+	tableobj.objectId = chunk_relid;
+	performDeletion(&tableobj, DROP_RESTRICT, 0);
+	RenameRelationInternal(new_relid, NameStr(chunk->fd.table_name), true);
+	CommandCounterIncrement();
+
+	chunk->table_id = new_relid;
+	chunk_constraints_create_on_table(chunk->constraints, chunk->table_id, chunk->fd.id,
+									  ht->main_table_relid, ht->fd.id);
+	trigger_create_all_on_chunk(ht, chunk);
+	chunk_index_create_all(ht->fd.id, ht->main_table_relid, chunk->fd.id, chunk->table_id);
+
+	if (NULL != clustered_index_name)
+	{
+		Oid			indexrelid = get_relname_relid(clustered_index_name,
+												   get_rel_namespace(chunk->table_id));
+
+		if (OidIsValid(indexrelid))
+			chunk_index_mark_clustered(chunk->table_id, indexrelid);
+	}
+
+	CacheInvalidateRelcacheByRelid(ht->main_table_relid);
+	catalog_restore_user(&sec_ctx);
+	cache_release(hcache);
+
+	PG_RETURN_BOOL(true);
+}
+
+/*
+ * A chunk that rows are redistributed into, opened for inserting rows of the
+ * hypertable's rowtype.
+ */
+typedef struct RepartitionTarget
+{
+	int32		chunk_id;
+	Relation	rel;
+	ResultRelInfo *result_rel_info;
+	TupleTableSlot *slot;
+	TupleConversionMap *map;	/* hypertable rowtype to chunk rowtype */
+	BulkInsertState bistate;
+	int64		min_time;		/* range of time of the rows moved in */
+	int64		max_time;
+} RepartitionTarget;
+
+/*
+ * Check if a chunk's slices in the closed dimensions differ from the slices
+ * that new chunks get with the current number of partitions.
+ */
+static bool
+chunk_needs_repartitioning(Hyperspace *hs, Chunk *chunk)
+{
+	int			i;
+
+	for (i = 0; i < hs->num_dimensions; i++)
+	{
+		Dimension  *dim = &hs->dimensions[i];
+		DimensionSlice *slice;
+		DimensionSlice *expected;
+
+		if (!IS_CLOSED_DIMENSION(dim))
+			continue;
+
+		slice = hypercube_get_slice_by_dimension_id(chunk->cube, dim->fd.id);
+
+		/* The first slice starts at the minimum value instead of zero */
+		expected = dimension_calculate_default_slice(dim, Max(slice->fd.range_start, 0));
+
+		if (expected->fd.range_start != slice->fd.range_start ||
+			expected->fd.range_end != slice->fd.range_end)
+			return true;
+	}
+
+	return false;
+}
+
+static RepartitionTarget *
+repartition_target_get(List **targets, Chunk *chunk, Relation ht_rel, EState *estate)
+{
+	RepartitionTarget *target;
+	ListCell   *lc;
+
+	foreach(lc, *targets)
+	{
+		target = lfirst(lc);
+
+		if (target->chunk_id == chunk->fd.id)
+			return target;
+	}
+
+	target = palloc(sizeof(RepartitionTarget));
+	target->chunk_id = chunk->fd.id;
+	target->rel = heap_open(chunk->table_id, RowExclusiveLock);
+	target->result_rel_info = makeNode(ResultRelInfo);
+	InitResultRelInfoCompat(target->result_rel_info, target->rel, 1, 0);
+	ExecOpenIndices(target->result_rel_info, false);
+	target->slot = ExecInitExtraTupleSlot(estate);
+	ExecSetSlotDescriptor(target->slot, RelationGetDescr(target->rel));
+	target->map = convert_tuples_by_name(RelationGetDescr(ht_rel),
+										 RelationGetDescr(target->rel),
+										 gettext_noop("could not convert row type"));
+	target->bistate = GetBulkInsertState();
+	target->min_time = DIMENSION_SLICE_MAXVALUE;
+	target->max_time = DIMENSION_SLICE_MINVALUE;
+	*targets = lappend(*targets, target);
+
+	return target;
+}
+
+static void
+repartition_targets_close(List *targets)
+{
+	ListCell   *lc;
+
+	foreach(lc, targets)
+	{
+		RepartitionTarget *target = lfirst(lc);
+
+		if (target->min_time <= target->max_time)
+			chunk_time_range_widen(target->chunk_id, target->min_time, target->max_time);
+
+		ExecClearTuple(target->slot);
+		FreeBulkInsertState(target->bistate);
+		ExecCloseIndices(target->result_rel_info);
+
+		if (NULL != target->map)
+			free_conversion_map(target->map);
+
+		heap_close(target->rel, NoLock);
+	}
+}
+
+/*
+ * Move all rows of a chunk whose metadata has been deleted into the chunks
+ * that the hypertable currently routes them to, creating the chunks as
+ * needed, like an insert would. The rows are inserted at heap level with index
+ * maintenance, without firing triggers, since they are only moved.
+ */
+static void
+chunk_repartition_rows(Hypertable *ht, Relation ht_rel, Oid src_relid, EState *estate,
+					   List **targets, CommandId cid)
+{
+	Relation	src_rel = heap_open(src_relid, NoLock);
+	TupleConversionMap *map = convert_tuples_by_name(RelationGetDescr(src_rel),
+													 RelationGetDescr(ht_rel),
+													 gettext_noop("could not convert row type"));
+	Snapshot	snapshot = RegisterSnapshot(GetLatestSnapshot());
+	HeapScanDesc scan = heap_beginscan(src_rel, snapshot, 0, NULL);
+	MemoryContext oldcontext = CurrentMemoryContext;
+	RepartitionTarget *target = NULL;
+	HeapTuple	src_tuple;
+
+	while ((src_tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		HeapTuple	tuple;
+		Point	   *point;
+		Chunk	   *chunk;
+
+		CHECK_FOR_INTERRUPTS();
+		ResetPerTupleExprContext(estate);
+		MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
+
+		if (NULL != map)
+			tuple = do_convert_tuple(src_tuple, map);
+		else
+			tuple = src_tuple;
+
+		point = hyperspace_calculate_point(ht->space, tuple, RelationGetDescr(ht_rel));
+		chunk = hypertable_get_chunk(ht, point);
+
+		/* Consecutive rows often go to the same chunk */
+		if (NULL == target || target->chunk_id != chunk->fd.id)
+		{
+			MemoryContextSwitchTo(oldcontext);
+			target = repartition_target_get(targets, chunk, ht_rel, estate);
+			MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
+		}
+
+		/* Never insert the tuple in the scanned buffer */
+		if (NULL != target->map)
+			tuple = do_convert_tuple(tuple, target->map);
+		else if (tuple == src_tuple)
+			tuple = heap_copytuple(tuple);
+
+		heap_insert(target->rel, tuple, cid, 0, target->bistate);
+		ExecStoreTuple(tuple, target->slot, InvalidBuffer, false);
+
+		/* Open dimensions come first, so this is the time */
+		target->min_time = Min(target->min_time, point->coordinates[0]);
+		target->max_time = Max(target->max_time, point->coordinates[0]);
+
+		if (target->result_rel_info->ri_NumIndices > 0)
+		{
+			estate->es_result_relation_info = target->result_rel_info;
+			list_free(ExecInsertIndexTuples(target->slot, &tuple->t_self, estate, false, NULL, NIL));
+		}
+
+		ExecClearTuple(target->slot);
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	heap_endscan(scan);
+	UnregisterSnapshot(snapshot);
+
+	if (NULL != map)
+		free_conversion_map(map);
+
+	heap_close(src_rel, NoLock);
+}
+
+TS_FUNCTION_INFO_V1(chunk_repartition_chunks);
+
+/*
+ * Redistribute the rows of existing chunks according to the current number
+ * of partitions in the closed (space) dimensions, e.g., after
+ * set_number_partitions(), which otherwise only affects new chunks.
+ *
+ * Chunks whose closed-dimension slices do not match the current partitioning
+ * have their metadata deleted and their rows routed like inserts into new (or
+ * existing, matching) chunks, which reuse the old chunks' time slices since
+ * the time dimension is aligned. The old chunk tables are then dropped.
+ * Compressed chunks are not repartitioned.
+ *
+ * The repartitioned chunks are locked while their rows are moved, so this is
+ * meant for recent chunks whose inserts can be paused briefly, rather than for
+ * rewriting the whole history of a hypertable.
+ *
+ * Returns the number of chunks that were repartitioned and dropped.
+ */
+Datum
+chunk_repartition_chunks(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_GETARG_OID(0);
+	bool		all_times = PG_ARGISNULL(1);
+	ObjectAddresses *objects = new_object_addresses();
+	List	   *slice_ids = NIL;
+	List	   *groups = NIL;
+	CatalogSecurityContext sec_ctx;
+	Cache	   *hcache;
+	Hypertable *ht;
+	Dimension  *time_dim;
+	DimensionVec *slices;
+	int64		newer_than = 0;
+	int			num_repartitioned = 0;
+	int			i;
+	ListCell   *lc;
+
+	hypertable_permissions_check(table_relid, GetUserId());
+
+	hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry(hcache, table_relid);
+
+	if (NULL == ht)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_HYPERTABLE_NOT_EXIST),
+				 errmsg("table \"%s\" is not a hypertable",
+						get_rel_name(table_relid))));
+
+	if (hyperspace_get_num_dimensions_by_type(ht->space, DIMENSION_TYPE_OPEN) != 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("hypertable \"%s\" does not have exactly one time dimension",
+						get_rel_name(table_relid))));
+
+	if (hyperspace_get_num_dimensions_by_type(ht->space, DIMENSION_TYPE_CLOSED) == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("hypertable \"%s\" does not have a space dimension",
+						get_rel_name(table_relid))));
+
+	time_dim = hyperspace_get_open_dimension(ht->space, 0);
+
+	if (!all_times)
+		newer_than = chunk_time_arg_to_internal(fcinfo, 1, time_dim, "newer_than");
+
+	/* Block concurrent chunk creation like inserts that create chunks */
+	LockRelationOid(table_relid, ShareUpdateExclusiveLock);
+
+	slices = dimension_slice_scan_by_dimension(time_dim->fd.id, 0);
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+
+	/* Delete the metadata of the chunks to repartition, per time slice */
+	for (i = 0; i < slices->num_slices; i++)
+	{
+		ChunkConstraints *ccs = chunk_constraints_alloc(1);
+		List	   *relids = NIL;
+		int			j;
+
+		if (!all_times && slices->slices[i]->fd.range_end <= newer_than)
+			continue;
+
+		chunk_constraint_scan_by_dimension_slice_id(slices->slices[i]->fd.id, ccs);
+
+		for (j = 0; j < ccs->num_constraints; j++)
+		{
+			Chunk	   *chunk = chunk_get_by_id(ccs->constraints[j].fd.chunk_id,
+												ht->space->num_dimensions, true);
+			ObjectAddress tableobj = {
+				.classId = RelationRelationId,
+				.objectId = chunk->table_id,
+			};
+
+			if (!OidIsValid(chunk->table_id) ||
+				NULL != compressed_chunk_get_by_chunk_id(chunk->fd.id) ||
+				!chunk_needs_repartitioning(ht->space, chunk))
+				continue;
+
+			/* Check permissions and lock like DROP TABLE */
+			if (!pg_class_ownercheck(chunk->table_id, sec_ctx.saved_uid))
+				aclcheck_error(ACLCHECK_NOT_OWNER, ACL_KIND_CLASS,
+							   get_rel_name(chunk->table_id));
+
+			LockRelationOid(chunk->table_id, AccessExclusiveLock);
+
+			slice_ids = chunk_delete_metadata(chunk, slice_ids);
+			add_exact_object_address(&tableobj, objects);
+			relids = lappend_oid(relids, chunk->table_id);
+			num_repartitioned++;
+		}
+
+		if (NIL != relids)
+			groups = lappend(groups, relids);
+	}
+
+	catalog_restore_user(&sec_ctx);
+
+	if (num_repartitioned > 0)
+	{
+		Relation	ht_rel;
+		EState	   *estate;
+		CommandId	cid;
+
+		/*
+		 * Get a hypertable cache entry that no longer knows the deleted
+		 * chunks. The old time slices are kept until the end, so that the new
+		 * chunks reuse them.
+		 */
+		CacheInvalidateRelcacheByRelid(ht->main_table_relid);
+		CommandCounterIncrement();
+		ht = hypertable_cache_get_entry(hcache, table_relid);
+
+		ht_rel = heap_open(table_relid, NoLock);
+		estate = CreateExecutorState();
+		cid = GetCurrentCommandId(true);
+
+		/* Rows of a time slice only go to chunks in the same time slice */
+		foreach(lc, groups)
+		{
+			List	   *targets = NIL;
+			ListCell   *lc_relid;
+
+			foreach(lc_relid, lfirst(lc))
+				chunk_repartition_rows(ht, ht_rel, lfirst_oid(lc_relid), estate, &targets, cid);
+
+			repartition_targets_close(targets);
+		}
+
+		ExecResetTupleTable(estate->es_tupleTable, false);
+		FreeExecutorState(estate);
+		heap_close(ht_rel, NoLock);
+
+		/* Make the new chunk constraints visible to the orphan check */
+		CommandCounterIncrement();
+
+		catalog_become_owner(catalog_get(), &sec_ctx);
+
+		foreach(lc, slice_ids)
+		{
+			int32		slice_id = lfirst_int(lc);
+
+			if (chunk_constraint_scan_by_dimension_slice_id(slice_id, NULL) == 0)
+				dimension_slice_delete_by_id(slice_id, false);
+		}
+
+		catalog_restore_user(&sec_ctx);
+	}
+
+	performMultipleDeletions(objects, DROP_RESTRICT, 0);
+	cache_release(hcache);
+
+	PG_RETURN_INT32(num_repartitioned);
+}
@@ -5,6 +5,7 @@
 #include <access/htup.h>
 #include <access/tupdesc.h>
 #include <utils/hsearch.h>
+#include <fmgr.h>
 
 #include "catalog.h"
 #include "chunk_constraint.h"
@@ -63,18 +64,31 @@ typedef struct ChunkScanEntry
 
 extern Chunk *chunk_create_from_tuple(HeapTuple tuple, int16 num_constraints);
 extern Chunk *chunk_create(Hypertable *ht, Point *p, const char *schema, const char *prefix);
+extern Chunk *chunk_create_without_indexes(Hypertable *ht, Point *p, const char *schema, const char *prefix, bool *created);
 extern Chunk *chunk_create_stub(int32 id, int16 num_constraints);
 extern void chunk_free(Chunk *chunk);
 extern Chunk *chunk_find(Hyperspace *hs, Point *p);
+extern Chunk *chunk_get_by_id_with_cube(int32 chunk_id, Hypercube *cube, int16 num_constraints);
 extern Chunk *chunk_copy(Chunk *chunk);
+extern Chunk *chunk_copy_compact(Chunk *chunk, MemoryContext mcxt);
 extern Chunk *chunk_get_by_name(const char *schema_name, const char *table_name, int16 num_constraints, bool fail_if_not_found);
 extern Chunk *chunk_get_by_relid(Oid relid, int16 num_constraints, bool fail_if_not_found);
 extern Chunk *chunk_get_by_id(int32 id, int16 num_constraints, bool fail_if_not_found);
+extern List *chunk_get_all_by_hypertable_id(int32 hypertable_id, int16 num_constraints);
+extern List *chunk_get_all_ending_before(Hypertable *ht, int64 older_than, bool all_times);
+extern List *chunk_find_all_colliding(Hyperspace *hs, DimensionSlice **slices, int num_slices);
+extern bool chunk_exists_for_hypertable(int32 hypertable_id);
+extern HTAB *chunk_relid_htab_create(int32 hypertable_id, int16 num_constraints);
+extern Chunk *chunk_relid_htab_lookup(HTAB *htab, Oid relid);
 extern bool chunk_exists(const char *schema_name, const char *table_name);
 extern bool chunk_exists_relid(Oid relid);
 extern void chunk_recreate_all_constraints_for_dimension(Hyperspace *hs, int32 dimension_id);
 extern int	chunk_delete_by_relid(Oid chunk_oid);
 extern int	chunk_delete_by_hypertable_id(int32 hypertable_id);
 extern int	chunk_delete_by_name(const char *schema, const char *table);
+extern int	chunk_drop_all(Hypertable *ht, DropBehavior behavior);
+
+PGDLLEXPORT Datum chunk_create_ahead(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum chunk_drop_chunks(PG_FUNCTION_ARGS);
 
 #endif							/* TIMESCALEDB_CHUNK_H */
@@ -0,0 +1,462 @@
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <catalog/pg_type.h>
+#include <miscadmin.h>
+#include <storage/bufmgr.h>
+#include <utils/builtins.h>
+#include <utils/lsyscache.h>
+#include <utils/rel.h>
+
+#include "catalog.h"
+#include "chunk.h"
+#include "chunk_adaptive.h"
+#include "chunk_constraint.h"
+#include "compress_chunk.h"
+#include "dimension.h"
+#include "dimension_slice.h"
+#include "dimension_vector.h"
+#include "errors.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "scanner.h"
+#include "compat.h"
+
+/*
+ * Adaptive chunking.
+ *
+ * With a fixed interval, the size of chunks follows the ingest rate: when the
+ * rate goes up, chunks outgrow memory and inserts slow down, and when it goes
+ * down, many small chunks slow down planning. Adaptive chunking instead sizes
+ * the chunks of the first open dimension of a hypertable against a target
+ * size, as given by set_adaptive_chunking().
+ *
+ * Whenever a new chunk is created, the interval of the dimension is
+ * recalculated from the on-disk size (including indexes) of the chunks in the
+ * slices just before the new chunk's point. If the calculated interval
+ * differs enough from the current one, it is stored as the dimension's
+ * interval, and the new slice, like all slices, keeps the range it was
+ * created with. Slices that no longer align with the new interval are cut to
+ * not collide with existing ones, like any other slice.
+ */
+
+/* The number of preceding slices to base the interval on */
+#define ADAPTIVE_NUM_SLICES 3
+
+/* Change the interval at most by this factor at a time, to dampen outliers */
+#define ADAPTIVE_MAX_CHANGE_FACTOR 10.0
+
+/* Keep the interval unless it is off by more than this fraction */
+#define ADAPTIVE_MIN_CHANGE 0.1
+
+/* The fraction of shared_buffers that the chunks of a slice may use */
+#define ADAPTIVE_ESTIMATE_FRACTION 0.25
+
+static int
+chunk_sizing_scan(int32 hypertable_id, tuple_found_func tuple_found, void *data,
+				  LOCKMODE lockmode)
+{
+	Catalog    *catalog = catalog_get();
+	ScanKeyData scankey[1];
+	ScannerCtx	scanctx = {
+		.table = catalog_table_get_id(catalog, CHUNK_SIZING),
+		.index = CATALOG_INDEX(catalog, CHUNK_SIZING, CHUNK_SIZING_PKEY_IDX),
+		.nkeys = 1,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.limit = 1,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+	};
+
+	ScanKeyInit(&scankey[0], Anum_chunk_sizing_pkey_idx_hypertable_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(hypertable_id));
+
+	return scanner_scan(&scanctx);
+}
+
+static bool
+chunk_sizing_tuple_get_target_size(TupleInfo *ti, void *data)
+{
+	int64	   *target_size = data;
+
+	*target_size = ((Form_chunk_sizing) GETSTRUCT(ti->tuple))->target_size;
+
+	return false;
+}
+
+/*
+ * Get the target chunk size of a hypertable, or zero if adaptive chunking is
+ * off.
+ */
+int64
+chunk_sizing_get_target_size(int32 hypertable_id)
+{
+	int64		target_size = 0;
+
+	chunk_sizing_scan(hypertable_id, chunk_sizing_tuple_get_target_size,
+					  &target_size, AccessShareLock);
+
+	return target_size;
+}
+
+static bool
+chunk_sizing_tuple_update(TupleInfo *ti, void *data)
+{
+	int64	   *target_size = data;
+	HeapTuple	tuple = heap_copytuple(ti->tuple);
+	CatalogSecurityContext sec_ctx;
+
+	((Form_chunk_sizing) GETSTRUCT(tuple))->target_size = *target_size;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_update(ti->scanrel, tuple);
+	catalog_restore_user(&sec_ctx);
+
+	heap_freetuple(tuple);
+
+	return false;
+}
+
+static void
+chunk_sizing_insert(int32 hypertable_id, int64 target_size)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	Datum		values[Natts_chunk_sizing];
+	bool		nulls[Natts_chunk_sizing] = {false};
+	CatalogSecurityContext sec_ctx;
+
+	values[Anum_chunk_sizing_hypertable_id - 1] = Int32GetDatum(hypertable_id);
+	values[Anum_chunk_sizing_target_size - 1] = Int64GetDatum(target_size);
+
+	rel = heap_open(catalog_table_get_id(catalog, CHUNK_SIZING), RowExclusiveLock);
+
+	catalog_become_owner(catalog, &sec_ctx);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+
+	heap_close(rel, RowExclusiveLock);
+}
+
+static bool
+chunk_sizing_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return false;
+}
+
+int
+chunk_sizing_delete_by_hypertable_id(int32 hypertable_id)
+{
+	return chunk_sizing_scan(hypertable_id, chunk_sizing_tuple_delete,
+							 NULL, RowExclusiveLock);
+}
+
+/*
+ * Get the on-disk size of a chunk, including its TOAST table and indexes.
+ *
+ * Chunks without any data, e.g., chunks created ahead of time, are of no use
+ * for sizing and have size zero.
+ */
+static int64
+chunk_get_total_size(Oid relid)
+{
+	Relation	rel = relation_open(relid, AccessShareLock);
+	BlockNumber nblocks = RelationGetNumberOfBlocks(rel);
+	List	   *indexes;
+	ListCell   *lc;
+
+	if (nblocks == 0)
+	{
+		relation_close(rel, AccessShareLock);
+		return 0;
+	}
+
+	indexes = RelationGetIndexList(rel);
+
+	if (OidIsValid(rel->rd_rel->reltoastrelid))
+	{
+		Relation	toastrel = relation_open(rel->rd_rel->reltoastrelid, AccessShareLock);
+
+		nblocks += RelationGetNumberOfBlocks(toastrel);
+		relation_close(toastrel, AccessShareLock);
+	}
+
+	foreach(lc, indexes)
+	{
+		Relation	indexrel = relation_open(lfirst_oid(lc), AccessShareLock);
+
+		nblocks += RelationGetNumberOfBlocks(indexrel);
+		relation_close(indexrel, AccessShareLock);
+	}
+
+	list_free(indexes);
+	relation_close(rel, AccessShareLock);
+
+	return (int64) nblocks * BLCKSZ;
+}
+
+/*
+ * Calculate the interval of the first open dimension of a hypertable so that
+ * a new chunk at the given coordinate is about the target size.
+ *
+ * The size of a chunk per unit of the dimension is estimated from the
+ * chunks of up to ADAPTIVE_NUM_SLICES slices that end at or before the
+ * coordinate. With space partitioning, a slice has several chunks, and the
+ * average chunk of a slice counts. Slices that are unbounded, or that have no
+ * data, e.g., because compressed, are skipped.
+ *
+ * Returns the current interval if there are no slices to go by.
+ */
+int64
+chunk_adaptive_calculate_interval(Hypertable *ht, int64 coordinate, int64 target_size)
+{
+	Dimension  *dim = hyperspace_get_open_dimension(ht->space, 0);
+	DimensionVec *slices;
+	double		total_size = 0;
+	double		total_length = 0;
+	double		interval;
+	int			num_slices = 0;
+	int			i;
+
+	Assert(NULL != dim);
+	Assert(target_size > 0);
+
+	slices = dimension_slice_scan_ending_before(dim->fd.id, coordinate, 0);
+
+	for (i = slices->num_slices - 1; i >= 0 && num_slices < ADAPTIVE_NUM_SLICES; i--)
+	{
+		DimensionSlice *slice = slices->slices[i];
+		ChunkConstraints *ccs;
+		int64		slice_size = 0;
+		int			num_chunks = 0;
+		int			j;
+
+		if (slice->fd.range_start == DIMENSION_SLICE_MINVALUE ||
+			slice->fd.range_end == DIMENSION_SLICE_MAXVALUE)
+			continue;
+
+		ccs = chunk_constraints_alloc(1);
+		chunk_constraint_scan_by_dimension_slice_id(slice->fd.id, ccs);
+
+		for (j = 0; j < ccs->num_constraints; j++)
+		{
+			int32		chunk_id = ccs->constraints[j].fd.chunk_id;
+			Chunk	   *chunk;
+			int64		size;
+
+			if (ht->has_compressed_chunks &&
+				NULL != compressed_chunk_get_by_chunk_id(chunk_id))
+				continue;
+
+			chunk = chunk_get_by_id(chunk_id, 0, false);
+
+			if (NULL == chunk)
+				continue;
+
+			size = chunk_get_total_size(chunk->table_id);
+
+			if (size > 0)
+			{
+				slice_size += size;
+				num_chunks++;
+			}
+		}
+
+		if (num_chunks == 0)
+			continue;
+
+		total_size += (double) slice_size / num_chunks;
+		total_length += (double) (slice->fd.range_end - slice->fd.range_start);
+		num_slices++;
+	}
+
+	if (num_slices == 0 || total_size <= 0)
+		return dim->fd.interval_length;
+
+	interval = target_size * (total_length / total_size);
+
+	if (interval > dim->fd.interval_length * ADAPTIVE_MAX_CHANGE_FACTOR)
+		interval = dim->fd.interval_length * ADAPTIVE_MAX_CHANGE_FACTOR;
+	else if (interval < dim->fd.interval_length / ADAPTIVE_MAX_CHANGE_FACTOR)
+		interval = dim->fd.interval_length / ADAPTIVE_MAX_CHANGE_FACTOR;
+
+	if (interval < 1)
+		return 1;
+
+	if (interval >= (double) PG_INT64_MAX)
+		return PG_INT64_MAX;
+
+	return (int64) interval;
+}
+
+/*
+ * Recalculate the interval of the first open dimension before a new chunk is
+ * created for the given point.
+ *
+ * Called with the lock that serializes chunk creation on the hypertable held,
+ * so the update of the dimension does not race with other inserters.
+ */
+void
+chunk_adaptive_update_interval(Hypertable *ht, Point *p)
+{
+	Dimension  *dim = hyperspace_get_open_dimension(ht->space, 0);
+	int64		interval;
+	int64		change;
+
+	if (NULL == dim || ht->chunk_target_size <= 0)
+		return;
+
+	interval = chunk_adaptive_calculate_interval(ht, p->coordinates[0], ht->chunk_target_size);
+	change = interval > dim->fd.interval_length ?
+		interval - dim->fd.interval_length : dim->fd.interval_length - interval;
+
+	if (change < dim->fd.interval_length * ADAPTIVE_MIN_CHANGE)
+		return;
+
+	elog(DEBUG1, "adaptive chunking changes interval of dimension %d from "
+		 INT64_FORMAT " to " INT64_FORMAT,
+		 dim->fd.id, dim->fd.interval_length, interval);
+
+	dimension_set_chunk_interval(dim, interval);
+}
+
+/*
+ * Estimate a target chunk size from the memory available.
+ *
+ * The chunks of the latest slice are the ones written to, so they should
+ * share a fraction of shared_buffers together with their indexes.
+ */
+static int64
+chunk_adaptive_estimate_target_size(Hypertable *ht)
+{
+	int64		chunks_per_slice = 1;
+	int			i;
+
+	for (i = 0; i < ht->space->num_dimensions; i++)
+	{
+		Dimension  *dim = &ht->space->dimensions[i];
+
+		if (IS_CLOSED_DIMENSION(dim))
+			chunks_per_slice *= dim->fd.num_slices;
+	}
+
+	return (int64) (((double) NBuffers * BLCKSZ * ADAPTIVE_ESTIMATE_FRACTION) / chunks_per_slice);
+}
+
+static int64
+chunk_adaptive_parse_target_size(Hypertable *ht, text *target)
+{
+	char	   *str;
+	int64		target_size;
+
+	if (NULL == target)
+		return 0;
+
+	str = text_to_cstring(target);
+
+	if (pg_strcasecmp(str, "off") == 0)
+		return 0;
+
+	if (pg_strcasecmp(str, "estimate") == 0)
+		return chunk_adaptive_estimate_target_size(ht);
+
+	target_size = DatumGetInt64(DirectFunctionCall1(pg_size_bytes, PointerGetDatum(target)));
+
+	if (target_size <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid chunk target size \"%s\"", str),
+				 errhint("The target size must be positive, \"estimate\", or \"off\".")));
+
+	return target_size;
+}
+
+static Hypertable *
+chunk_adaptive_get_hypertable(Cache *hcache, Oid table_relid)
+{
+	Hypertable *ht = hypertable_cache_get_entry(hcache, table_relid);
+
+	if (NULL == ht)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_HYPERTABLE_NOT_EXIST),
+				 errmsg("table \"%s\" is not a hypertable",
+						get_rel_name(table_relid))));
+
+	if (NULL == hyperspace_get_open_dimension(ht->space, 0))
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_DIMENSION_NOT_EXIST),
+				 errmsg("hypertable \"%s\" has no time dimension",
+						get_rel_name(table_relid))));
+
+	return ht;
+}
+
+TS_FUNCTION_INFO_V1(chunk_adaptive_set);
+
+/*
+ * Turn adaptive chunking on or off for a hypertable.
+ *
+ * Returns the target chunk size in bytes, or zero if adaptive chunking is
+ * turned off.
+ */
+Datum
+chunk_adaptive_set(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_GETARG_OID(0);
+	text	   *target = PG_ARGISNULL(1) ? NULL : PG_GETARG_TEXT_PP(1);
+	Cache	   *hcache;
+	Hypertable *ht;
+	int64		target_size;
+
+	hypertable_permissions_check(table_relid, GetUserId());
+
+	hcache = hypertable_cache_pin();
+	ht = chunk_adaptive_get_hypertable(hcache, table_relid);
+	target_size = chunk_adaptive_parse_target_size(ht, target);
+
+	if (target_size == 0)
+		chunk_sizing_delete_by_hypertable_id(ht->fd.id);
+	else if (chunk_sizing_scan(ht->fd.id, chunk_sizing_tuple_update,
+							   &target_size, RowExclusiveLock) == 0)
+		chunk_sizing_insert(ht->fd.id, target_size);
+
+	cache_release(hcache);
+
+	PG_RETURN_INT64(target_size);
+}
+
+TS_FUNCTION_INFO_V1(chunk_adaptive_calculate_chunk_interval);
+
+/*
+ * Expose the interval calculation for testing purposes.
+ */
+Datum
+chunk_adaptive_calculate_chunk_interval(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_GETARG_OID(0);
+	int64		coordinate = PG_GETARG_INT64(1);
+	int64		target_size = PG_GETARG_INT64(2);
+	Cache	   *hcache;
+	Hypertable *ht;
+	int64		interval;
+
+	if (target_size <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid chunk target size: must be positive")));
+
+	hcache = hypertable_cache_pin();
+	ht = chunk_adaptive_get_hypertable(hcache, table_relid);
+	interval = chunk_adaptive_calculate_interval(ht, coordinate, target_size);
+	cache_release(hcache);
+
+	PG_RETURN_INT64(interval);
+}
@@ -0,0 +1,16 @@
+#ifndef TIMESCALEDB_CHUNK_ADAPTIVE_H
+#define TIMESCALEDB_CHUNK_ADAPTIVE_H
+
+#include <postgres.h>
+
+#include "catalog.h"
+
+typedef struct Hypertable Hypertable;
+typedef struct Point Point;
+
+extern int64 chunk_sizing_get_target_size(int32 hypertable_id);
+extern int	chunk_sizing_delete_by_hypertable_id(int32 hypertable_id);
+extern int64 chunk_adaptive_calculate_interval(Hypertable *ht, int64 coordinate, int64 target_size);
+extern void chunk_adaptive_update_interval(Hypertable *ht, Point *p);
+
+#endif							/* TIMESCALEDB_CHUNK_ADAPTIVE_H */
@@ -0,0 +1,755 @@
+#include <postgres.h>
+#include <math.h>
+#include <access/hash.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <commands/vacuum.h>
+#include <miscadmin.h>
+#include <storage/bufmgr.h>
+#include <storage/lmgr.h>
+#include <utils/builtins.h>
+#include <utils/inval.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/rel.h>
+#include <utils/tqual.h>
+#include <utils/typcache.h>
+
+#include "chunk_bloom_filter.h"
+#include "compress_chunk.h"
+#include "errors.h"
+#include "hypertable_cache.h"
+#include "scanner.h"
+#include "compat.h"
+
+/*
+ * Bloom filters of the values of declared columns in each chunk, so that a
+ * lookup of a value, e.g., a request or trace ID, can skip the chunks that
+ * cannot contain it. Space partitioning only helps lookups on the
+ * partitioning column.
+ *
+ * A filter is built from all rows of a chunk, so it is only built once a
+ * chunk no longer takes many writes: when the chunk is reordered, or with
+ * build_bloom_filters(). Values are hashed with the hash function of the
+ * column type's default hash operator class, which is the same for all
+ * types in the operator family, so a value of another type that the
+ * column's equality operator compares to hashes the same.
+ *
+ * A write of rows into a chunk deletes its filters, rather than adding the
+ * rows' values to them. Writes are usually inserts into recent chunks, and
+ * these have no filters. Deletes and updates of other columns leave the
+ * filters alone, since a filter may contain values that are no longer in the
+ * chunk.
+ *
+ * The filters are checked by ConstraintAwareAppend when the executor starts,
+ * like the chunks' time ranges, since plans can be reused after the filters
+ * have changed.
+ */
+
+static inline uint32
+bloom_filter_bit(uint32 hash, uint32 hash2, int i, uint32 num_bits)
+{
+	return (hash + i * hash2) % num_bits;
+}
+
+/*
+ * Check if a filter may contain a value with the given hash. The bits are
+ * found by double hashing, with the second hash derived from the first.
+ */
+bool
+bloom_filter_may_contain(BloomFilter *filter, uint32 hash)
+{
+	uint32		hash2 = DatumGetUInt32(hash_uint32(hash));
+	int			i;
+
+	for (i = 0; i < filter->num_hashes; i++)
+	{
+		uint32		bit = bloom_filter_bit(hash, hash2, i, filter->num_bits);
+
+		if ((filter->bits[bit / BITS_PER_BYTE] & (1 << (bit % BITS_PER_BYTE))) == 0)
+			return false;
+	}
+
+	return true;
+}
+
+static int
+uint32_cmp(const void *a, const void *b)
+{
+	uint32		ua = *((const uint32 *) a);
+	uint32		ub = *((const uint32 *) b);
+
+	return ua < ub ? -1 : (ua > ub ? 1 : 0);
+}
+
+/*
+ * Create a filter of the given hashes. The filter is sized by the number of
+ * distinct hashes, rather than rows, since the declared columns often repeat
+ * values across rows.
+ */
+static bytea *
+bloom_filter_create(uint32 *hashes, int64 num_values, int32 *num_hashes)
+{
+	int64		num_distinct = 0;
+	int64		num_bits;
+	double		bits_per_value;
+	bytea	   *filter;
+	uint8	   *bits;
+	int64		i;
+
+	if (num_values > 0)
+	{
+		qsort(hashes, num_values, sizeof(uint32), uint32_cmp);
+
+		for (i = 0; i < num_values; i++)
+			if (i == 0 || hashes[i] != hashes[num_distinct - 1])
+				hashes[num_distinct++] = hashes[i];
+	}
+
+	num_bits = Max(num_distinct * BLOOM_FILTER_BITS_PER_VALUE, BLOOM_FILTER_MIN_BITS);
+	num_bits = Min(num_bits, (int64) BLOOM_FILTER_MAX_BYTES * BITS_PER_BYTE);
+	num_bits = TYPEALIGN(BITS_PER_BYTE, num_bits);
+
+	/* The number of hashes that minimizes false positives */
+	bits_per_value = (double) num_bits / Max(num_distinct, 1);
+	*num_hashes = (int32) rint(bits_per_value * M_LN2);
+	*num_hashes = Max(Min(*num_hashes, BLOOM_FILTER_MAX_HASHES), 1);
+
+	filter = palloc0(VARHDRSZ + num_bits / BITS_PER_BYTE);
+	SET_VARSIZE(filter, VARHDRSZ + num_bits / BITS_PER_BYTE);
+	bits = (uint8 *) VARDATA(filter);
+
+	for (i = 0; i < num_distinct; i++)
+	{
+		uint32		hash2 = DatumGetUInt32(hash_uint32(hashes[i]));
+		int			j;
+
+		for (j = 0; j < *num_hashes; j++)
+		{
+			uint32		bit = bloom_filter_bit(hashes[i], hash2, j, num_bits);
+
+			bits[bit / BITS_PER_BYTE] |= 1 << (bit % BITS_PER_BYTE);
+		}
+	}
+
+	return filter;
+}
+
+static int
+hypertable_bloom_column_scan(int32 hypertable_id, const char *column_name,
+							 tuple_found_func tuple_found, void *data, LOCKMODE lockmode)
+{
+	Catalog    *catalog = catalog_get();
+	ScanKeyData scankey[2];
+	int			nkeys = 0;
+	ScannerCtx	scanctx = {
+		.table = catalog_table_get_id(catalog, HYPERTABLE_BLOOM_COLUMN),
+		.index = CATALOG_INDEX(catalog, HYPERTABLE_BLOOM_COLUMN, HYPERTABLE_BLOOM_COLUMN_PKEY_IDX),
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+	};
+
+	ScanKeyInit(&scankey[nkeys++], Anum_hypertable_bloom_column_pkey_idx_hypertable_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(hypertable_id));
+
+	if (NULL != column_name)
+		ScanKeyInit(&scankey[nkeys++], Anum_hypertable_bloom_column_pkey_idx_column_name,
+					BTEqualStrategyNumber, F_NAMEEQ,
+					DirectFunctionCall1(namein, CStringGetDatum(column_name)));
+
+	scanctx.nkeys = nkeys;
+
+	return scanner_scan(&scanctx);
+}
+
+static bool
+hypertable_bloom_column_tuple_append(TupleInfo *ti, void *data)
+{
+	List	  **columns = data;
+	Form_hypertable_bloom_column form = (Form_hypertable_bloom_column) GETSTRUCT(ti->tuple);
+
+	*columns = lappend(*columns, pstrdup(NameStr(form->column_name)));
+
+	return true;
+}
+
+/*
+ * Get the names of the columns of a hypertable that chunks keep filters of.
+ */
+List *
+hypertable_bloom_column_get_all(int32 hypertable_id)
+{
+	List	   *columns = NIL;
+
+	hypertable_bloom_column_scan(hypertable_id, NULL, hypertable_bloom_column_tuple_append,
+								 &columns, AccessShareLock);
+
+	return columns;
+}
+
+bool
+hypertable_bloom_column_exists_for_hypertable(int32 hypertable_id)
+{
+	return hypertable_bloom_column_scan(hypertable_id, NULL, NULL, NULL, AccessShareLock) > 0;
+}
+
+static int
+chunk_bloom_filter_scan(int32 chunk_id, const char *column_name,
+						tuple_found_func tuple_found, void *data, LOCKMODE lockmode)
+{
+	Catalog    *catalog = catalog_get();
+	ScanKeyData scankey[2];
+	int			nkeys = 0;
+	ScannerCtx	scanctx = {
+		.table = catalog_table_get_id(catalog, CHUNK_BLOOM_FILTER),
+		.index = CATALOG_INDEX(catalog, CHUNK_BLOOM_FILTER, CHUNK_BLOOM_FILTER_PKEY_IDX),
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+	};
+
+	ScanKeyInit(&scankey[nkeys++], Anum_chunk_bloom_filter_pkey_idx_chunk_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(chunk_id));
+
+	if (NULL != column_name)
+		ScanKeyInit(&scankey[nkeys++], Anum_chunk_bloom_filter_pkey_idx_column_name,
+					BTEqualStrategyNumber, F_NAMEEQ,
+					DirectFunctionCall1(namein, CStringGetDatum(column_name)));
+
+	scanctx.nkeys = nkeys;
+
+	return scanner_scan(&scanctx);
+}
+
+static bool
+chunk_bloom_filter_tuple_append(TupleInfo *ti, void *data)
+{
+	List	  **filters = data;
+	Form_chunk_bloom_filter form = (Form_chunk_bloom_filter) GETSTRUCT(ti->tuple);
+	BloomFilter *filter = palloc(sizeof(BloomFilter));
+	bool		isnull;
+	Datum		bits = heap_getattr(ti->tuple, Anum_chunk_bloom_filter_filter, ti->desc, &isnull);
+	bytea	   *bytes;
+
+	Assert(!isnull);
+	bytes = DatumGetByteaPCopy(bits);
+
+	namecpy(&filter->column_name, &form->column_name);
+	filter->num_hashes = form->num_hashes;
+	filter->num_bits = VARSIZE_ANY_EXHDR(bytes) * BITS_PER_BYTE;
+	filter->bits = (uint8 *) VARDATA_ANY(bytes);
+	*filters = lappend(*filters, filter);
+
+	return true;
+}
+
+/*
+ * Get the filters of a chunk.
+ */
+List *
+chunk_bloom_filter_get_all(int32 chunk_id)
+{
+	List	   *filters = NIL;
+
+	chunk_bloom_filter_scan(chunk_id, NULL, chunk_bloom_filter_tuple_append, &filters,
+							AccessShareLock);
+
+	return filters;
+}
+
+/*
+ * Lock the filters of a chunk until the end of the transaction.
+ *
+ * Concurrent inserts into a chunk would otherwise fail to delete the same
+ * filters. The lock is only taken when there are filters to change, so
+ * concurrent inserts into chunks without filters do not wait on each other.
+ */
+static void
+chunk_bloom_filter_lock(int32 chunk_id)
+{
+	LockDatabaseObject(catalog_table_get_id(catalog_get(), CHUNK_BLOOM_FILTER),
+					   chunk_id, 0, ExclusiveLock);
+}
+
+static bool
+chunk_bloom_filter_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete_only(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+static int
+chunk_bloom_filter_delete(int32 chunk_id, const char *column_name)
+{
+	if (chunk_bloom_filter_scan(chunk_id, column_name, NULL, NULL, AccessShareLock) == 0)
+		return 0;
+
+	chunk_bloom_filter_lock(chunk_id);
+
+	return chunk_bloom_filter_scan(chunk_id, column_name, chunk_bloom_filter_tuple_delete,
+								   NULL, RowExclusiveLock);
+}
+
+/*
+ * Delete the filters of a chunk, e.g., because rows are written to it.
+ */
+int
+chunk_bloom_filter_delete_by_chunk_id(int32 chunk_id)
+{
+	return chunk_bloom_filter_delete(chunk_id, NULL);
+}
+
+void
+chunk_bloom_filter_delete_by_hypertable_id(int32 hypertable_id)
+{
+	List	   *chunks = chunk_get_all_by_hypertable_id(hypertable_id, 0);
+	ListCell   *lc;
+
+	foreach(lc, chunks)
+		chunk_bloom_filter_delete(((Chunk *) lfirst(lc))->fd.id, NULL);
+}
+
+/*
+ * Delete the filters of a column in all chunks of a hypertable, e.g., because
+ * the column's type changed.
+ */
+void
+chunk_bloom_filter_delete_by_column(Hypertable *ht, const char *column_name)
+{
+	List	   *chunks = chunk_get_all_by_hypertable_id(ht->fd.id, 0);
+	ListCell   *lc;
+
+	foreach(lc, chunks)
+		chunk_bloom_filter_delete(((Chunk *) lfirst(lc))->fd.id, column_name);
+}
+
+static bool
+bloom_column_tuple_rename(TupleInfo *ti, void *data)
+{
+	const char *new_name = data;
+	HeapTuple	tuple = heap_copytuple(ti->tuple);
+	CatalogSecurityContext sec_ctx;
+
+	/* The column name is at the same place in both tables */
+	if (RelationGetRelid(ti->scanrel) == catalog_table_get_id(catalog_get(), CHUNK_BLOOM_FILTER))
+		namestrcpy(&((Form_chunk_bloom_filter) GETSTRUCT(tuple))->column_name, new_name);
+	else
+		namestrcpy(&((Form_hypertable_bloom_column) GETSTRUCT(tuple))->column_name, new_name);
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_update(ti->scanrel, tuple);
+	catalog_restore_user(&sec_ctx);
+
+	heap_freetuple(tuple);
+
+	return true;
+}
+
+/*
+ * Follow the rename of a column of a hypertable.
+ */
+void
+chunk_bloom_filter_rename_column(Hypertable *ht, const char *old_name, const char *new_name)
+{
+	List	   *chunks;
+	ListCell   *lc;
+
+	if (hypertable_bloom_column_scan(ht->fd.id, old_name, bloom_column_tuple_rename,
+									 (void *) new_name, RowExclusiveLock) == 0)
+		return;
+
+	chunks = chunk_get_all_by_hypertable_id(ht->fd.id, 0);
+
+	foreach(lc, chunks)
+	{
+		int32		chunk_id = ((Chunk *) lfirst(lc))->fd.id;
+
+		if (chunk_bloom_filter_scan(chunk_id, old_name, NULL, NULL, AccessShareLock) == 0)
+			continue;
+
+		chunk_bloom_filter_lock(chunk_id);
+		chunk_bloom_filter_scan(chunk_id, old_name, bloom_column_tuple_rename,
+								(void *) new_name, RowExclusiveLock);
+	}
+}
+
+static void
+chunk_bloom_filter_insert(int32 chunk_id, const char *column_name, int32 num_hashes,
+						  bytea *filter)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	Datum		values[Natts_chunk_bloom_filter];
+	bool		nulls[Natts_chunk_bloom_filter] = {false};
+	CatalogSecurityContext sec_ctx;
+
+	values[Anum_chunk_bloom_filter_chunk_id - 1] = Int32GetDatum(chunk_id);
+	values[Anum_chunk_bloom_filter_column_name - 1] =
+		DirectFunctionCall1(namein, CStringGetDatum(column_name));
+	values[Anum_chunk_bloom_filter_num_hashes - 1] = Int32GetDatum(num_hashes);
+	values[Anum_chunk_bloom_filter_filter - 1] = PointerGetDatum(filter);
+
+	rel = heap_open(catalog_table_get_id(catalog, CHUNK_BLOOM_FILTER), RowExclusiveLock);
+
+	catalog_become_owner(catalog, &sec_ctx);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+
+	heap_close(rel, RowExclusiveLock);
+}
+
+/* The values of a column in a chunk, as they are collected for its filter */
+typedef struct BloomColumn
+{
+	char	   *name;
+	AttrNumber	attno;
+	Oid			collation;
+	FmgrInfo   *hash_finfo;
+	uint32	   *hashes;
+	int64		num_values;
+	int64		max_values;
+} BloomColumn;
+
+/*
+ * Build the filters of a chunk's declared columns, replacing any it has.
+ * Returns false if the chunk gets no filters, i.e., if its hypertable has no
+ * declared columns, or if the chunk is compressed. The rows of a compressed
+ * chunk are not in the chunk's table, so its filters are kept from before it
+ * was compressed.
+ *
+ * Writes to the chunk are blocked until the end of the transaction.
+ */
+bool
+chunk_bloom_filter_build(Chunk *chunk)
+{
+	List	   *column_names = hypertable_bloom_column_get_all(chunk->fd.hypertable_id);
+	BloomColumn *columns;
+	int			num_columns = 0;
+	Relation	rel;
+	TupleDesc	desc;
+	TransactionId oldest_xmin;
+	TransactionId freeze_limit;
+	MultiXactId multi_cutoff;
+	MemoryContext tuple_mcxt;
+	MemoryContext old;
+	HeapScanDesc scan;
+	HeapTuple	tuple;
+	ListCell   *lc;
+	int			i;
+
+	if (NIL == column_names || NULL != compressed_chunk_get_by_relid(chunk->table_id))
+		return false;
+
+	/* Like CREATE INDEX, block writes but not reads */
+	rel = heap_open(chunk->table_id, ShareLock);
+	desc = RelationGetDescr(rel);
+	columns = palloc0(sizeof(BloomColumn) * list_length(column_names));
+
+	foreach(lc, column_names)
+	{
+		char	   *name = lfirst(lc);
+		AttrNumber	attno = get_attnum(chunk->table_id, name);
+		TypeCacheEntry *tce;
+
+		/* A dropped column has no values to filter on */
+		if (attno == InvalidAttrNumber)
+			continue;
+
+		tce = lookup_type_cache(desc->attrs[AttrNumberGetAttrOffset(attno)]->atttypid,
+								TYPECACHE_HASH_PROC_FINFO);
+
+		if (!OidIsValid(tce->hash_proc))
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_FUNCTION),
+					 errmsg("could not identify a hash function for type %s",
+							format_type_be(tce->type_id))));
+
+		columns[num_columns].name = name;
+		columns[num_columns].attno = attno;
+		columns[num_columns].collation = desc->attrs[AttrNumberGetAttrOffset(attno)]->attcollation;
+		columns[num_columns].hash_finfo = &tce->hash_proc_finfo;
+		columns[num_columns].max_values = 1024;
+		columns[num_columns].hashes = palloc(sizeof(uint32) * columns[num_columns].max_values);
+		num_columns++;
+	}
+
+	vacuum_set_xid_limits(rel, 0, 0, 0, 0, &oldest_xmin, &freeze_limit,
+						  NULL, &multi_cutoff, NULL);
+
+	tuple_mcxt = AllocSetContextCreate(CurrentMemoryContext,
+									   "Bloom filter tuple",
+									   ALLOCSET_DEFAULT_SIZES);
+
+	/*
+	 * The filters cover all rows that any snapshot can still see, like an
+	 * index, since older snapshots may read the chunk after the filters are
+	 * in place.
+	 */
+	scan = heap_beginscan(rel, SnapshotAny, 0, NULL);
+
+	while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		Buffer		buf = scan->rs_cbuf;
+		bool		isdead;
+
+		CHECK_FOR_INTERRUPTS();
+
+		LockBuffer(buf, BUFFER_LOCK_SHARE);
+		isdead = HeapTupleSatisfiesVacuum(tuple, oldest_xmin, buf) == HEAPTUPLE_DEAD;
+		LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+
+		if (isdead)
+			continue;
+
+		old = MemoryContextSwitchTo(tuple_mcxt);
+
+		for (i = 0; i < num_columns; i++)
+		{
+			BloomColumn *column = &columns[i];
+			bool		isnull;
+			Datum		value = heap_getattr(tuple, column->attno, desc, &isnull);
+
+			if (isnull)
+				continue;
+
+			if (column->num_values == column->max_values)
+			{
+				column->max_values *= 2;
+				column->hashes = repalloc_huge(column->hashes,
+											   sizeof(uint32) * column->max_values);
+			}
+
+			column->hashes[column->num_values++] =
+				DatumGetUInt32(FunctionCall1Coll(column->hash_finfo, column->collation, value));
+		}
+
+		MemoryContextSwitchTo(old);
+		MemoryContextReset(tuple_mcxt);
+	}
+
+	heap_endscan(scan);
+	MemoryContextDelete(tuple_mcxt);
+
+	chunk_bloom_filter_lock(chunk->fd.id);
+	chunk_bloom_filter_scan(chunk->fd.id, NULL, chunk_bloom_filter_tuple_delete, NULL,
+							RowExclusiveLock);
+
+	for (i = 0; i < num_columns; i++)
+	{
+		int32		num_hashes;
+		bytea	   *filter = bloom_filter_create(columns[i].hashes, columns[i].num_values,
+												 &num_hashes);
+
+		chunk_bloom_filter_insert(chunk->fd.id, columns[i].name, num_hashes, filter);
+		pfree(columns[i].hashes);
+		pfree(filter);
+	}
+
+	/*
+	 * Make cached plans that write directly to the chunk delete the filters
+	 * again. Such plans delete them at plan time.
+	 */
+	CacheInvalidateRelcacheByRelid(chunk->table_id);
+
+	heap_close(rel, NoLock);
+
+	return true;
+}
+
+static Hypertable *
+bloom_filter_get_hypertable(Cache *hcache, Oid table_relid)
+{
+	Hypertable *ht;
+
+	hypertable_permissions_check(table_relid, GetUserId());
+	ht = hypertable_cache_get_entry(hcache, table_relid);
+
+	if (NULL == ht)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_HYPERTABLE_NOT_EXIST),
+				 errmsg("table \"%s\" is not a hypertable",
+						get_rel_name(table_relid))));
+
+	return ht;
+}
+
+TS_FUNCTION_INFO_V1(chunk_bloom_filter_add_column);
+
+/*
+ * Declare a column of a hypertable to keep filters of. The filters of
+ * existing chunks are built when the chunks are reordered, or with
+ * build_bloom_filters().
+ */
+Datum
+chunk_bloom_filter_add_column(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Name		column_name = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1);
+	bool		if_not_exists = PG_ARGISNULL(2) ? false : PG_GETARG_BOOL(2);
+	Cache	   *hcache;
+	Hypertable *ht;
+	AttrNumber	attno;
+	Oid			typid;
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	Datum		values[Natts_hypertable_bloom_column];
+	bool		nulls[Natts_hypertable_bloom_column] = {false};
+	CatalogSecurityContext sec_ctx;
+
+	if (!OidIsValid(table_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid main_table: cannot be NULL")));
+
+	if (NULL == column_name)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid column_name: cannot be NULL")));
+
+	hcache = hypertable_cache_pin();
+	ht = bloom_filter_get_hypertable(hcache, table_relid);
+	attno = get_attnum(table_relid, NameStr(*column_name));
+
+	if (attno <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_COLUMN),
+				 errmsg("column \"%s\" does not exist", NameStr(*column_name))));
+
+	typid = get_atttype(table_relid, attno);
+
+	if (!OidIsValid(lookup_type_cache(typid, TYPECACHE_HASH_PROC)->hash_proc))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION),
+				 errmsg("could not identify a hash function for type %s",
+						format_type_be(typid))));
+
+	if (hypertable_bloom_column_scan(ht->fd.id, NameStr(*column_name), NULL, NULL,
+									 AccessShareLock) > 0)
+	{
+		if (!if_not_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_DUPLICATE_OBJECT),
+					 errmsg("column \"%s\" already has bloom filters", NameStr(*column_name))));
+
+		ereport(NOTICE,
+				(errmsg("column \"%s\" already has bloom filters, skipping",
+						NameStr(*column_name))));
+		cache_release(hcache);
+		PG_RETURN_VOID();
+	}
+
+	values[Anum_hypertable_bloom_column_hypertable_id - 1] = Int32GetDatum(ht->fd.id);
+	values[Anum_hypertable_bloom_column_column_name - 1] = NameGetDatum(column_name);
+
+	rel = heap_open(catalog_table_get_id(catalog, HYPERTABLE_BLOOM_COLUMN), RowExclusiveLock);
+
+	catalog_become_owner(catalog, &sec_ctx);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+
+	heap_close(rel, RowExclusiveLock);
+	cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
+
+static bool
+hypertable_bloom_column_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+TS_FUNCTION_INFO_V1(chunk_bloom_filter_remove_column);
+
+/*
+ * Stop keeping filters of a column, and delete the filters of all chunks.
+ */
+Datum
+chunk_bloom_filter_remove_column(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Name		column_name = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1);
+	bool		if_exists = PG_ARGISNULL(2) ? false : PG_GETARG_BOOL(2);
+	Cache	   *hcache;
+	Hypertable *ht;
+
+	if (!OidIsValid(table_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid main_table: cannot be NULL")));
+
+	if (NULL == column_name)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid column_name: cannot be NULL")));
+
+	hcache = hypertable_cache_pin();
+	ht = bloom_filter_get_hypertable(hcache, table_relid);
+
+	if (hypertable_bloom_column_scan(ht->fd.id, NameStr(*column_name),
+									 hypertable_bloom_column_tuple_delete, NULL,
+									 RowExclusiveLock) == 0)
+	{
+		if (!if_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_OBJECT),
+					 errmsg("column \"%s\" has no bloom filters", NameStr(*column_name))));
+
+		ereport(NOTICE,
+				(errmsg("column \"%s\" has no bloom filters, skipping",
+						NameStr(*column_name))));
+	}
+	else
+		chunk_bloom_filter_delete_by_column(ht, NameStr(*column_name));
+
+	cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(chunk_bloom_filter_build_sql);
+
+Datum
+chunk_bloom_filter_build_sql(PG_FUNCTION_ARGS)
+{
+	Oid			chunk_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Chunk	   *chunk;
+
+	if (!OidIsValid(chunk_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid chunk: cannot be NULL")));
+
+	chunk = chunk_get_by_relid(chunk_relid, 0, false);
+
+	if (NULL == chunk)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("\"%s\" is not a chunk", get_rel_name(chunk_relid))));
+
+	hypertable_permissions_check(chunk->hypertable_relid, GetUserId());
+
+	if (NULL != compressed_chunk_get_by_relid(chunk_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot build bloom filters of compressed chunk \"%s\"",
+						get_rel_name(chunk_relid))));
+
+	PG_RETURN_BOOL(chunk_bloom_filter_build(chunk));
+}
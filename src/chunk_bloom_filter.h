@@ -0,0 +1,36 @@
+#ifndef TIMESCALEDB_CHUNK_BLOOM_FILTER_H
+#define TIMESCALEDB_CHUNK_BLOOM_FILTER_H
+
+#include <postgres.h>
+#include <nodes/pg_list.h>
+
+#include "catalog.h"
+#include "chunk.h"
+#include "hypertable.h"
+
+/* Sizing of filters: bits per distinct value, and the bounds of the size */
+#define BLOOM_FILTER_BITS_PER_VALUE 10
+#define BLOOM_FILTER_MIN_BITS 64
+#define BLOOM_FILTER_MAX_BYTES (1024 * 1024)
+#define BLOOM_FILTER_MAX_HASHES 7
+
+typedef struct BloomFilter
+{
+	NameData	column_name;
+	int32		num_hashes;
+	uint32		num_bits;
+	uint8	   *bits;
+} BloomFilter;
+
+extern bool bloom_filter_may_contain(BloomFilter *filter, uint32 hash);
+extern List *hypertable_bloom_column_get_all(int32 hypertable_id);
+extern bool hypertable_bloom_column_exists_for_hypertable(int32 hypertable_id);
+extern List *chunk_bloom_filter_get_all(int32 chunk_id);
+extern bool chunk_bloom_filter_build(Chunk *chunk);
+extern int	chunk_bloom_filter_delete_by_chunk_id(int32 chunk_id);
+extern void chunk_bloom_filter_delete_by_hypertable_id(int32 hypertable_id);
+extern void chunk_bloom_filter_rename_column(Hypertable *ht, const char *old_name,
+								 const char *new_name);
+extern void chunk_bloom_filter_delete_by_column(Hypertable *ht, const char *column_name);
+
+#endif							/* TIMESCALEDB_CHUNK_BLOOM_FILTER_H */
@@ -167,25 +167,42 @@ chunk_constraint_insert_relation(Relation rel, ChunkConstraint *cc)
 }
 
 /*
- * Insert multiple chunk constraints into the metadata catalog.
+ * Insert multiple chunk constraints into the metadata catalog. The catalog's
+ * indexes are opened once and the rows are made visible together.
  */
 static void
 chunk_constraints_insert(ChunkConstraints *ccs)
 {
 	Catalog    *catalog = catalog_get();
 	CatalogSecurityContext sec_ctx;
+	CatalogIndexState indstate;
+	TupleDesc	desc;
 	Relation	rel;
 	int			i;
 
-	rel = heap_open(catalog->tables[CHUNK_CONSTRAINT].id, RowExclusiveLock);
+	if (ccs->num_constraints == 0)
+		return;
+
+	rel = heap_open(catalog_table_get_id(catalog, CHUNK_CONSTRAINT), RowExclusiveLock);
+	desc = RelationGetDescr(rel);
+	indstate = CatalogOpenIndexes(rel);
 
 	catalog_become_owner(catalog_get(), &sec_ctx);
 
 	for (i = 0; i < ccs->num_constraints; i++)
-		chunk_constraint_insert_relation(rel, &ccs->constraints[i]);
+	{
+		Datum		values[Natts_chunk_constraint];
+		bool		nulls[Natts_chunk_constraint] = {false};
+
+		chunk_constraint_fill_tuple_values(&ccs->constraints[i], values, nulls);
+		catalog_insert_values_with_info(rel, indstate, desc, values, nulls);
+	}
 
 	catalog_restore_user(&sec_ctx);
+	CatalogCloseIndexes(indstate);
 	heap_close(rel, RowExclusiveLock);
+
+	CommandCounterIncrement();
 }
 
 /*
@@ -198,7 +215,7 @@ chunk_constraint_insert(ChunkConstraint *constraint)
 	CatalogSecurityContext sec_ctx;
 	Relation	rel;
 
-	rel = heap_open(catalog->tables[CHUNK_CONSTRAINT].id, RowExclusiveLock);
+	rel = heap_open(catalog_table_get_id(catalog, CHUNK_CONSTRAINT), RowExclusiveLock);
 
 	catalog_become_owner(catalog_get(), &sec_ctx);
 	chunk_constraint_insert_relation(rel, constraint);
@@ -324,9 +341,22 @@ chunk_constraints_create(ChunkConstraints *ccs,
 						 Oid hypertable_oid,
 						 int32 hypertable_id)
 {
-	int			i;
-
 	chunk_constraints_insert(ccs);
+	chunk_constraints_create_on_table(ccs, chunk_oid, chunk_id, hypertable_oid, hypertable_id);
+}
+
+/*
+ * Create the table constraints of a set of chunk constraints whose metadata
+ * already exists, e.g., when a chunk's table is rewritten.
+ */
+void
+chunk_constraints_create_on_table(ChunkConstraints *ccs,
+								  Oid chunk_oid,
+								  int32 chunk_id,
+								  Oid hypertable_oid,
+								  int32 hypertable_id)
+{
+	int			i;
 
 	for (i = 0; i < ccs->num_constraints; i++)
 		chunk_constraint_create(&ccs->constraints[i],
@@ -367,7 +397,7 @@ chunk_constraint_scan_internal(int indexid,
 {
 	Catalog    *catalog = catalog_get();
 	ScannerCtx	scanctx = {
-		.table = catalog->tables[CHUNK_CONSTRAINT].id,
+		.table = catalog_table_get_id(catalog, CHUNK_CONSTRAINT),
 		.index = CATALOG_INDEX(catalog, CHUNK_CONSTRAINT, indexid),
 		.nkeys = nkeys,
 		.scankey = scankey,
@@ -440,6 +470,61 @@ chunk_constraint_scan_by_chunk_id_constraint_name_internal(int32 chunk_id,
 										  lockmode);
 }
 
+typedef struct ChunkConstraintsLookupCtx
+{
+	chunk_constraints_lookup_func lookup;
+	void	   *data;
+} ChunkConstraintsLookupCtx;
+
+static bool
+chunk_constraint_tuple_found_lookup(TupleInfo *ti, void *data)
+{
+	ChunkConstraintsLookupCtx *ctx = data;
+	bool		isnull;
+	Datum		chunk_id = heap_getattr(ti->tuple, Anum_chunk_constraint_chunk_id, ti->desc, &isnull);
+	ChunkConstraints *ccs = ctx->lookup(DatumGetInt32(chunk_id), ctx->data);
+
+	if (NULL != ccs)
+		chunk_constraints_add_from_tuple(ccs, ti);
+
+	return true;
+}
+
+/*
+ * Scan for the constraints of a set of chunks in a single index scan.
+ *
+ * For each found constraint, the lookup function is called with the
+ * constraint's chunk ID to get the set of constraints to add it to. The lookup
+ * function can return NULL to skip a constraint.
+ *
+ * Returns the number of constraints found.
+ */
+int
+chunk_constraint_scan_by_chunk_ids(int32 *chunk_ids, int num_chunks,
+								   chunk_constraints_lookup_func lookup, void *data)
+{
+	ScanKeyData scankey[1];
+	ChunkConstraintsLookupCtx ctx = {
+		.lookup = lookup,
+		.data = data,
+	};
+
+	if (num_chunks == 0)
+		return 0;
+
+	scanner_scankey_init_int32_array(&scankey[0],
+									 Anum_chunk_constraint_chunk_id_dimension_slice_id_idx_chunk_id,
+									 chunk_ids, num_chunks);
+
+	return chunk_constraint_scan_internal(CHUNK_CONSTRAINT_CHUNK_ID_DIMENSION_SLICE_ID_IDX,
+										  scankey,
+										  1,
+										  chunk_constraint_tuple_found_lookup,
+										  NULL,
+										  &ctx,
+										  AccessShareLock);
+}
+
 /*
  * Scan all the chunk's constraints given its chunk ID.
  *
@@ -556,6 +641,61 @@ chunk_constraint_scan_by_dimension_slice_id(int32 dimension_slice_id, ChunkConst
 									  ccs);
 }
 
+typedef struct DimensionConstraintScanCtx
+{
+	chunk_constraint_dimension_func func;
+	void	   *data;
+} DimensionConstraintScanCtx;
+
+static bool
+dimension_constraint_tuple_found(TupleInfo *ti, void *data)
+{
+	DimensionConstraintScanCtx *ctx = data;
+	bool		isnull;
+	Datum		chunk_id;
+	Datum		dimension_slice_id;
+
+	chunk_id = heap_getattr(ti->tuple, Anum_chunk_constraint_chunk_id, ti->desc, &isnull);
+	Assert(!isnull);
+	dimension_slice_id = heap_getattr(ti->tuple, Anum_chunk_constraint_dimension_slice_id, ti->desc, &isnull);
+	Assert(!isnull);
+
+	ctx->func(DatumGetInt32(chunk_id), DatumGetInt32(dimension_slice_id), ctx->data);
+
+	return true;
+}
+
+/*
+ * Scan all dimension constraints in a single pass over the chunk constraint
+ * table, calling the given function with the chunk ID and dimension slice ID
+ * of each constraint.
+ *
+ * Scanning by dimension slice ID cannot use the leading column of the
+ * (chunk_id, dimension_slice_id) index, so every such scan visits the whole
+ * index. When the constraints of many slices are needed, e.g., to load all
+ * chunks of a hypertable, one sequential scan is much cheaper.
+ */
+int
+chunk_constraint_scan_dimension_constraints(chunk_constraint_dimension_func func, void *data)
+{
+	Catalog    *catalog = catalog_get();
+	DimensionConstraintScanCtx ctx = {
+		.func = func,
+		.data = data,
+	};
+	ScannerCtx	scanctx = {
+		.table = catalog_table_get_id(catalog, CHUNK_CONSTRAINT),
+		.index = InvalidOid,
+		.data = &ctx,
+		.tuple_found = dimension_constraint_tuple_found,
+		.filter = chunk_constraint_for_dimension_slice,
+		.lockmode = AccessShareLock,
+		.scandirection = ForwardScanDirection,
+	};
+
+	return scanner_scan(&scanctx);
+}
+
 static bool
 chunk_constraint_need_on_chunk(Form_pg_constraint conform)
 {
@@ -636,6 +776,10 @@ chunk_constraint_create_on_chunk(Chunk *chunk, Oid constraint_oid)
 	const char *constrname;
 	ChunkConstraint *cc;
 
+	/* Foreign chunks leave constraints to their data node's hypertable */
+	if (get_rel_relkind(chunk->table_id) == RELKIND_FOREIGN_TABLE)
+		return;
+
 	constrname = get_constraint_name(constraint_oid);
 	cc = chunk_constraints_add(chunk->constraints, chunk->fd.id, 0, NULL, constrname);
 
@@ -781,6 +925,32 @@ chunk_constraint_delete_by_chunk_id(int32 chunk_id, ChunkConstraints *ccs)
 													  RowExclusiveLock);
 }
 
+static bool
+chunk_constraint_delete_metadata_tuple(TupleInfo *ti, void *data)
+{
+	chunk_constraint_tuple_found(ti, data);
+	catalog_delete_only(ti->scanrel, ti->tuple);
+
+	return true;
+}
+
+/*
+ * Delete the metadata of all constraints of a chunk, but not the constraints
+ * themselves, which go away with the chunk's table. Unlike
+ * chunk_constraint_delete_by_chunk_id(), this neither looks up the chunk nor
+ * signals cache invalidations, which is up to the caller. Optionally, collect
+ * the deleted constraints.
+ */
+int
+chunk_constraint_delete_metadata_by_chunk_id(int32 chunk_id, ChunkConstraints *ccs)
+{
+	return chunk_constraint_scan_by_chunk_id_internal(chunk_id,
+													  chunk_constraint_delete_metadata_tuple,
+													  NULL,
+													  ccs,
+													  RowExclusiveLock);
+}
+
 int
 chunk_constraint_delete_by_dimension_slice_id(int32 dimension_slice_id)
 {
@@ -806,6 +976,37 @@ chunk_constraint_delete_by_dimension_slice_id(int32 dimension_slice_id)
 										  RowExclusiveLock);
 }
 
+/*
+ * Replace the dimension constraint of a chunk that corresponds to a dimension
+ * slice with one for another slice of the same dimension, e.g., when the
+ * chunk's range is extended. Both the metadata and the CHECK constraint on
+ * the chunk table are replaced. The new slice must already exist.
+ */
+void
+chunk_constraint_replace_dimension_slice(Chunk *chunk, int32 old_slice_id, int32 new_slice_id)
+{
+	ChunkConstraints *ccs;
+	int			i;
+
+	for (i = 0; i < chunk->constraints->num_constraints; i++)
+	{
+		ChunkConstraint *cc = &chunk->constraints->constraints[i];
+
+		if (cc->fd.dimension_slice_id == old_slice_id)
+		{
+			chunk_constraint_delete_by_constraint_name(chunk->fd.id,
+													   NameStr(cc->fd.constraint_name),
+													   true, true);
+			break;
+		}
+	}
+
+	ccs = chunk_constraints_alloc(1);
+	chunk_constraints_add(ccs, chunk->fd.id, new_slice_id, NULL, NULL);
+	chunk_constraints_create(ccs, chunk->table_id, chunk->fd.id,
+							 chunk->hypertable_relid, chunk->fd.hypertable_id);
+}
+
 void
 chunk_constraint_recreate(ChunkConstraint *cc, Oid chunk_oid)
 {
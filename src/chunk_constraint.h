@@ -33,19 +33,27 @@ typedef struct DimensionSlice DimensionSlice;
 typedef struct Hypercube Hypercube;
 typedef struct ChunkScanCtx ChunkScanCtx;
 
+typedef void (*chunk_constraint_dimension_func) (int32 chunk_id, int32 dimension_slice_id, void *data);
+typedef ChunkConstraints *(*chunk_constraints_lookup_func) (int32 chunk_id, void *data);
+
 extern ChunkConstraints *chunk_constraints_alloc(int size_hint);
 extern ChunkConstraints *chunk_constraint_scan_by_chunk_id(int32 chunk_id, Size count_hint);
+extern int	chunk_constraint_scan_by_chunk_ids(int32 *chunk_ids, int num_chunks, chunk_constraints_lookup_func lookup, void *data);
 extern ChunkConstraints *chunk_constraints_copy(ChunkConstraints *constraints);
 extern int	chunk_constraint_scan_by_dimension_slice(DimensionSlice *slice, ChunkScanCtx *ctx);
 extern int	chunk_constraint_scan_by_dimension_slice_id(int32 dimension_slice_id, ChunkConstraints *ccs);
+extern int	chunk_constraint_scan_dimension_constraints(chunk_constraint_dimension_func func, void *data);
 extern int	chunk_constraints_add_dimension_constraints(ChunkConstraints *ccs, int32 chunk_id, Hypercube *cube);
 extern int	chunk_constraints_add_inheritable_constraints(ChunkConstraints *ccs, int32 chunk_id, Oid hypertable_oid);
 extern void chunk_constraints_create(ChunkConstraints *ccs, Oid chunk_oid, int32 chunk_id, Oid hypertable_oid, int32 hypertable_id);
+extern void chunk_constraints_create_on_table(ChunkConstraints *ccs, Oid chunk_oid, int32 chunk_id, Oid hypertable_oid, int32 hypertable_id);
 extern void chunk_constraint_create_on_chunk(Chunk *chunk, Oid constraint_oid);
 extern int	chunk_constraint_delete_by_hypertable_constraint_name(int32 chunk_id, char *hypertable_constraint_name, bool delete_metadata, bool drop_constraint);
 extern int	chunk_constraint_delete_by_chunk_id(int32 chunk_id, ChunkConstraints *ccs);
+extern int	chunk_constraint_delete_metadata_by_chunk_id(int32 chunk_id, ChunkConstraints *ccs);
 extern int	chunk_constraint_delete_by_dimension_slice_id(int32 dimension_slice_id);
 extern int	chunk_constraint_delete_by_constraint_name(int32 chunk_id, const char *constraint_name, bool delete_metadata, bool drop_constraint);
+extern void chunk_constraint_replace_dimension_slice(Chunk *chunk, int32 old_slice_id, int32 new_slice_id);
 extern void chunk_constraint_recreate(ChunkConstraint *cc, Oid chunk_oid);
 extern int	chunk_constraint_rename_hypertable_constraint(int32 chunk_id, const char *oldname, const char *newname);
 
@@ -1,15 +1,29 @@
 #include <postgres.h>
+#include <access/xact.h>
 #include <nodes/extensible.h>
 #include <nodes/makefuncs.h>
 #include <nodes/nodeFuncs.h>
 #include <utils/rel.h>
 #include <catalog/pg_type.h>
+#include <miscadmin.h>
 
 #include "chunk_dispatch.h"
 #include "chunk_insert_state.h"
+#include "chunk_index.h"
+#include "chunk_time_range.h"
+#include "continuous_agg.h"
 #include "subspace_store.h"
 #include "dimension.h"
+#include "hypercube.h"
+#include "hypertable_stats.h"
 #include "guc.h"
+#include "utils.h"
+
+/*
+ * Statistics of the chunk insert state caches of all finished inserts in this
+ * backend.
+ */
+static SubspaceStoreStats chunk_dispatch_stats;
 
 ChunkDispatch *
 chunk_dispatch_create(Hypertable *ht, EState *estate)
@@ -22,7 +36,34 @@ chunk_dispatch_create(Hypertable *ht, EState *estate)
 	cd->on_conflict = ONCONFLICT_NONE;
 	cd->arbiter_indexes = NIL;
 	cd->cmd_type = CMD_INSERT;
+	cd->multi_insert = false;
+	cd->bulk_load = false;
+	cd->flush_buffered = NULL;
+	cd->flush_arg = NULL;
+	cd->defer_index_build = guc_defer_chunk_index_build;
+#if PG10
+	cd->transition_capture = NULL;
+#endif
+	cd->last_cis = NULL;
+	cd->num_tuples = 0;
+	cd->num_lookups = 0;
+	cd->num_last_cis_hits = 0;
+	cd->num_chunks_created = 0;
+	cd->num_tuples_converted = 0;
+	cd->touched_chunks = NULL;
+	cd->open_memory_bytes = 0;
+	cd->lowest_time = PG_INT64_MAX;
+	cd->greatest_time = PG_INT64_MIN;
+
+	if (guc_max_open_chunks_memory < 0)
+		cd->max_open_memory_bytes = (int64) work_mem * 1024;
+	else
+		cd->max_open_memory_bytes = (int64) guc_max_open_chunks_memory * 1024;
+
 	cd->cache = subspace_store_init(ht->space, estate->es_query_cxt, guc_max_open_chunks_per_insert);
+	cd->point = MemoryContextAllocZero(estate->es_query_cxt, POINT_SIZE(ht->space->num_dimensions));
+	cd->point->cardinality = ht->space->num_dimensions;
+	cd->max_column_attno = hyperspace_max_column_attno(ht->space);
 
 	return cd;
 }
@@ -30,39 +71,224 @@ chunk_dispatch_create(Hypertable *ht, EState *estate)
 void
 chunk_dispatch_destroy(ChunkDispatch *cd)
 {
+	SubspaceStoreStats stats;
+
+	subspace_store_get_stats(cd->cache, &stats);
+
+	/* Lookups that hit the last used insert state bypass the store */
+	chunk_dispatch_stats.hits += stats.hits + cd->num_last_cis_hits;
+	chunk_dispatch_stats.misses += stats.misses;
+	chunk_dispatch_stats.evictions += stats.evictions;
+
+	hypertable_stats_add(cd->hypertable->fd.id,
+						 cd->bulk_load ? HYPERTABLE_STATS_ROWS_COPIED : HYPERTABLE_STATS_ROWS_INSERTED,
+						 cd->num_tuples);
+	hypertable_stats_add(cd->hypertable->fd.id, HYPERTABLE_STATS_CACHE_EVICTIONS, stats.evictions);
+
+	/* One log entry per statement covers all the tuples inserted */
+	if (cd->lowest_time <= cd->greatest_time)
+		continuous_agg_invalidation_add(cd->hypertable->fd.id, cd->lowest_time, cd->greatest_time);
+	hypertable_stats_add(cd->hypertable->fd.id, HYPERTABLE_STATS_TUPLES_CONVERTED,
+						 cd->num_tuples_converted);
+
 	subspace_store_free(cd->cache);
 }
 
+/*
+ * Get the accumulated statistics of the chunk insert state caches of all
+ * finished inserts, including COPY, in this backend.
+ */
+void
+chunk_dispatch_get_stats(SubspaceStoreStats *stats)
+{
+	*stats = chunk_dispatch_stats;
+	stats->num_items = 0;
+	stats->max_items = guc_max_open_chunks_per_insert;
+}
+
 static void
 destroy_chunk_insert_state(void *cis)
 {
-	chunk_insert_state_destroy((ChunkInsertState *) cis);
+	ChunkInsertState *state = cis;
+	ChunkDispatch *dispatch = state->dispatch;
+	bool		build_indexes = state->build_indexes;
+	int32		chunk_id = state->chunk_id;
+	Oid			chunk_relid = RelationGetRelid(state->rel);
+
+	/* Make sure no buffered tuples are lost when the state is evicted */
+	if (state->num_buffered_tuples > 0)
+	{
+		Assert(dispatch->flush_buffered != NULL);
+		dispatch->flush_buffered(state, dispatch->flush_arg);
+	}
+
+	if (dispatch->last_cis == state)
+		dispatch->last_cis = NULL;
+
+	dispatch->open_memory_bytes -= state->memory_bytes;
+
+	chunk_insert_state_destroy(state);
+
+	/*
+	 * Build the indexes of a chunk that was loaded without them. This is done
+	 * after all tuples are in the heap, so each index gets a single sorted
+	 * build instead of per-tuple insertions.
+	 */
+	if (build_indexes)
+	{
+		chunk_index_create_all(dispatch->hypertable->fd.id,
+							   dispatch->hypertable->main_table_relid,
+							   chunk_id,
+							   chunk_relid);
+
+		/* Make the indexes visible in case the chunk is reopened */
+		CommandCounterIncrement();
+	}
+}
+
+/*
+ * Calculate the point of the tuple in a slot.
+ *
+ * Only the partitioning columns are fetched from the slot, which avoids forming
+ * a tuple from a virtual slot just to deform it again. The returned point is
+ * owned by the dispatch and only valid until the next call.
+ */
+extern Point *
+chunk_dispatch_calculate_point(ChunkDispatch *dispatch, TupleTableSlot *slot)
+{
+	slot_getsomeattrs(slot, dispatch->max_column_attno);
+
+	return hyperspace_calculate_point_from_values(dispatch->hypertable->space,
+												  slot->tts_values,
+												  slot->tts_isnull,
+												  dispatch->point);
 }
 
 /*
- * Get the chunk insert state for the chunk that matches the given point in the
- * partitioned hyperspace.
+ * Make sure that the time range of a chunk covers a tuple routed to it. The
+ * time dimension is the first open dimension, whose coordinate comes first.
+ */
+static inline void
+chunk_insert_state_add_time(ChunkInsertState *cis, Point *point)
+{
+	if (point->coordinates[0] < cis->min_time || point->coordinates[0] > cis->max_time)
+		chunk_insert_state_widen_time_range(cis, point->coordinates[0]);
+}
+
+/*
+ * Find the cached chunk insert state for the chunk that matches the given
+ * point. Returns NULL if there is no cached insert state. Unlike
+ * chunk_dispatch_get_chunk_insert_state(), this never creates new insert
+ * states and thus never evicts existing ones from the cache.
  */
 extern ChunkInsertState *
-chunk_dispatch_get_chunk_insert_state(ChunkDispatch *dispatch, Point *point)
+chunk_dispatch_find_chunk_insert_state(ChunkDispatch *dispatch, Point *point)
 {
-	ChunkInsertState *cis;
+	ChunkInsertState *cis = dispatch->last_cis;
+
+	dispatch->num_lookups++;
+
+	/*
+	 * Every tuple is looked up here, both for INSERT and COPY, so this is
+	 * where the range of time inserted is tracked. The time dimension is the
+	 * first open dimension, whose coordinate comes first.
+	 */
+	if (dispatch->hypertable->has_continuous_aggs)
+	{
+		dispatch->lowest_time = Min(dispatch->lowest_time, point->coordinates[0]);
+		dispatch->greatest_time = Max(dispatch->greatest_time, point->coordinates[0]);
+	}
+
+	if (NULL != cis && hypercube_contains_point(cis->cube, point))
+	{
+		dispatch->num_last_cis_hits++;
+		chunk_insert_state_add_time(cis, point);
+		return cis;
+	}
 
 	cis = subspace_store_get(dispatch->cache, point);
 
-	if (NULL == cis)
+	if (NULL != cis)
 	{
-		Chunk	   *new_chunk;
+		dispatch->last_cis = cis;
+		chunk_insert_state_add_time(cis, point);
+	}
 
-		new_chunk = hypertable_get_chunk(dispatch->hypertable, point);
+	return cis;
+}
+
+/*
+ * Open an insert state for the chunk that matches the given point, creating
+ * the chunk if it does not exist. The caller has checked that there is no
+ * cached insert state for the point, which might evict other insert states
+ * from the cache.
+ */
+extern ChunkInsertState *
+chunk_dispatch_open_chunk_insert_state(ChunkDispatch *dispatch, Point *point)
+{
+	ChunkInsertState *cis;
+	Chunk	   *new_chunk;
+	MemoryContext old;
+	bool		created;
+	bool		build_indexes;
 
-		if (NULL == new_chunk)
-			elog(ERROR, "No chunk found or created");
+	new_chunk = hypertable_get_chunk_for_insert(dispatch->hypertable, point,
+												dispatch->defer_index_build &&
+												dispatch->on_conflict == ONCONFLICT_NONE,
+												&created, &build_indexes);
 
-		cis = chunk_insert_state_create(new_chunk, dispatch);
-		subspace_store_add(dispatch->cache, new_chunk->cube, cis, destroy_chunk_insert_state);
+	if (NULL == new_chunk)
+		elog(ERROR, "No chunk found or created");
+
+	/* Only chunks created by inserts start out with a known time range */
+	if (created)
+	{
+		dispatch->num_chunks_created++;
+		chunk_time_range_insert_empty(new_chunk->fd.id);
 	}
 
+	old = MemoryContextSwitchTo(dispatch->estate->es_query_cxt);
+	dispatch->touched_chunks = bms_add_member(dispatch->touched_chunks, new_chunk->fd.id);
+	MemoryContextSwitchTo(old);
+
+	cis = chunk_insert_state_create(new_chunk, dispatch);
+	cis->build_indexes = build_indexes;
+	chunk_insert_state_add_time(cis, point);
+
+	/*
+	 * Close the least recently used chunks until the new one fits in the
+	 * memory limit. A chunk's open relation, index info, and constraint
+	 * and conversion state can take tens of kilobytes, so the limit keeps
+	 * as many chunks open as fit in memory, independent of the schema.
+	 */
+	cis->memory_bytes = memory_context_total_space(cis->mctx);
+
+	while (dispatch->max_open_memory_bytes > 0 &&
+		   dispatch->open_memory_bytes + cis->memory_bytes > dispatch->max_open_memory_bytes &&
+		   subspace_store_evict_lru(dispatch->cache))
+		;
+
+	dispatch->open_memory_bytes += cis->memory_bytes;
+	subspace_store_add(dispatch->cache, new_chunk->cube, cis, destroy_chunk_insert_state);
+	dispatch->last_cis = cis;
+
+	return cis;
+}
+
+/*
+ * Get the chunk insert state for the chunk that matches the given point in the
+ * partitioned hyperspace.
+ */
+extern ChunkInsertState *
+chunk_dispatch_get_chunk_insert_state(ChunkDispatch *dispatch, Point *point)
+{
+	ChunkInsertState *cis;
+
+	cis = chunk_dispatch_find_chunk_insert_state(dispatch, point);
+
+	if (NULL == cis)
+		cis = chunk_dispatch_open_chunk_insert_state(dispatch, point);
+
 	Assert(cis != NULL);
 	return cis;
 }
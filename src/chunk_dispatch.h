@@ -4,7 +4,9 @@
 #include <postgres.h>
 #include <nodes/parsenodes.h>
 #include <nodes/execnodes.h>
+#include <commands/trigger.h>
 
+#include "compat.h"
 #include "hypertable_cache.h"
 #include "cache.h"
 #include "subspace_store.h"
@@ -15,6 +17,12 @@
  * separate from any plan and executor nodes, since it is used both for INSERT
  * and COPY.
 */
+typedef struct ChunkInsertState ChunkInsertState;
+typedef struct Point Point;
+
+/* Called to flush tuples buffered on a chunk insert state */
+typedef void (*ChunkInsertStateFlushFunc) (ChunkInsertState *cis, void *arg);
+
 typedef struct ChunkDispatch
 {
 	Hypertable *hypertable;
@@ -30,13 +38,87 @@ typedef struct ChunkDispatch
 	List	   *arbiter_indexes;
 	CmdType		cmd_type;
 
-} ChunkDispatch;
+	/*
+	 * Whether chunk insert states should buffer tuples for multi-inserts. If
+	 * set, the flush function is called on any chunk insert state that has
+	 * buffered tuples before it is destroyed, e.g., when evicted from the
+	 * cache.
+	 */
+	bool		multi_insert;
 
-typedef struct Point Point;
-typedef struct ChunkInsertState ChunkInsertState;
+	/*
+	 * Whether tuples are written with heap_insert()/heap_multi_insert() using
+	 * each chunk insert state's heap insert options, as done by COPY. In that
+	 * case, chunks created in the current transaction skip the FSM (and WAL,
+	 * if possible) and are synced to disk when their insert state is
+	 * destroyed.
+	 */
+	bool		bulk_load;
+	ChunkInsertStateFlushFunc flush_buffered;
+	void	   *flush_arg;
+
+	/*
+	 * Whether chunks created by this dispatch are loaded without indexes. The
+	 * indexes are built when the chunk's insert state is destroyed, i.e., at
+	 * end of statement or when evicted from the cache. Not used with ON
+	 * CONFLICT, which needs the chunk's arbiter indexes.
+	 */
+	bool		defer_index_build;
+
+#if PG10
+
+	/*
+	 * Transition table capture for the hypertable's statement-level triggers,
+	 * or NULL. Tuples inserted into chunks are collected into the
+	 * hypertable's transition tables, converted to the hypertable's rowtype
+	 * if necessary.
+	 */
+	TransitionCaptureState *transition_capture;
+#endif
+
+	/*
+	 * The most recently used chunk insert state. Consecutive tuples often go
+	 * to the same chunk, so check this before looking in the cache.
+	 */
+	ChunkInsertState *last_cis;
+
+	/*
+	 * Memory of the open chunk insert states and its limit (zero for no
+	 * limit). Least recently used states are closed to stay within the limit.
+	 */
+	int64		open_memory_bytes;
+	int64		max_open_memory_bytes;
+
+	/*
+	 * The range of time of the tuples inserted, in internal time units. It is
+	 * logged for the hypertable's continuous aggregates when the dispatch is
+	 * destroyed.
+	 */
+	int64		lowest_time;
+	int64		greatest_time;
+
+	/* Reusable point for routing tuples */
+	Point	   *point;
+	AttrNumber	max_column_attno;
+
+	/*
+	 * Statistics, shown by EXPLAIN ANALYZE and added to the hypertable's
+	 * cumulative statistics when the dispatch is destroyed
+	 */
+	uint64		num_tuples;
+	uint64		num_lookups;
+	uint64		num_last_cis_hits;
+	uint64		num_chunks_created;
+	uint64		num_tuples_converted;
+	Bitmapset  *touched_chunks; /* IDs of the chunks inserted into */
+} ChunkDispatch;
 
 ChunkDispatch *chunk_dispatch_create(Hypertable *ht, EState *estate);
 void		chunk_dispatch_destroy(ChunkDispatch *dispatch);
+void		chunk_dispatch_get_stats(SubspaceStoreStats *stats);
 ChunkInsertState *chunk_dispatch_get_chunk_insert_state(ChunkDispatch *dispatch, Point *p);
+ChunkInsertState *chunk_dispatch_find_chunk_insert_state(ChunkDispatch *dispatch, Point *p);
+ChunkInsertState *chunk_dispatch_open_chunk_insert_state(ChunkDispatch *dispatch, Point *p);
+Point	   *chunk_dispatch_calculate_point(ChunkDispatch *dispatch, TupleTableSlot *slot);
 
 #endif							/* TIMESCALEDB_CHUNK_DISPATCH_H */
@@ -1,19 +1,26 @@
 #include <postgres.h>
+#include <miscadmin.h>
 #include <utils/lsyscache.h>
 #include <utils/rel.h>
 #include <catalog/pg_class.h>
 #include <nodes/extensible.h>
+#include <storage/lock.h>
+#include <nodes/plannodes.h>
+#include <executor/executor.h>
+#include <commands/explain.h>
 
 #include "chunk_dispatch_state.h"
 #include "chunk_dispatch_plan.h"
 #include "chunk_dispatch_info.h"
 #include "chunk_dispatch.h"
 #include "chunk_insert_state.h"
+#include "chunk_maintenance.h"
 #include "chunk.h"
 #include "cache.h"
 #include "hypertable_cache.h"
 #include "dimension.h"
 #include "hypertable.h"
+#include "guc.h"
 
 static void
 chunk_dispatch_begin(CustomScanState *node, EState *estate, int eflags)
@@ -45,6 +52,9 @@ chunk_dispatch_exec(CustomScanState *node)
 	TupleTableSlot *slot;
 	PlanState  *substate = linitial(node->custom_ps);
 
+	if (state->batch_size > 0)
+		return chunk_dispatch_exec_batch(state);
+
 	/* Get the next tuple from the subplan state node */
 	slot = ExecProcNode(substate);
 
@@ -53,19 +63,16 @@ chunk_dispatch_exec(CustomScanState *node)
 		Point	   *point;
 		ChunkInsertState *cis;
 		ChunkDispatch *dispatch = state->dispatch;
-		Hypertable *ht = dispatch->hypertable;
 		HeapTuple	tuple;
-		TupleDesc	tupdesc = slot->tts_tupleDescriptor;
 		EState	   *estate = node->ss.ps.state;
 		MemoryContext old;
 
 		/* Switch to the executor's per-tuple memory context */
 		old = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
 
-		tuple = ExecFetchSlotTuple(slot);
-
 		/* Calculate the tuple's point in the N-dimensional hyperspace */
-		point = hyperspace_calculate_point(ht->space, tuple, tupdesc);
+		point = chunk_dispatch_calculate_point(dispatch, slot);
+		tuple = ExecFetchSlotTuple(slot);
 
 		/* Save the main table's (hypertable's) ResultRelInfo */
 		if (NULL == dispatch->hypertable_result_rel_info)
@@ -99,6 +106,377 @@ chunk_dispatch_exec(CustomScanState *node)
 	return slot;
 }
 
+/*
+ * Check if this backend holds a lock on the hypertable that conflicts with
+ * the ShareUpdateExclusiveLock taken to create chunks, e.g., because it
+ * created a chunk earlier in the transaction. Workers creating chunks would
+ * then only wait for the lock until the transaction ends.
+ */
+static bool
+chunk_dispatch_holds_chunk_create_lock(ChunkDispatch *dispatch)
+{
+	LOCKTAG		tag;
+	LOCKMODE	mode;
+
+	SET_LOCKTAG_RELATION(tag, MyDatabaseId, dispatch->hypertable->main_table_relid);
+
+	for (mode = ShareUpdateExclusiveLock; mode <= AccessExclusiveLock; mode++)
+		if (LockHeldByMe(&tag, mode))
+			return true;
+
+	return false;
+}
+
+/*
+ * Buffer a tuple whose chunk does not exist yet, and have a background worker
+ * create the chunk unless one is already creating it. Returns false if the
+ * chunk exists or no worker could be started, in which case the tuple is
+ * routed as usual.
+ */
+static bool
+chunk_dispatch_async_buffer(ChunkDispatchState *state, Point *point, TupleTableSlot *slot)
+{
+	ChunkDispatch *dispatch = state->dispatch;
+	EState	   *estate = state->cscan_state.ss.ps.state;
+	ChunkCreateAsync *create = NULL;
+	MemoryContext old;
+	ListCell   *lc;
+
+	/* A worker is already creating the chunk */
+	foreach(lc, state->async_creates)
+	{
+		if (chunk_create_async_covers(lfirst(lc), point))
+		{
+			create = lfirst(lc);
+			break;
+		}
+	}
+
+	if (NULL == create)
+	{
+		if (chunk_dispatch_holds_chunk_create_lock(dispatch) ||
+			NULL != hypertable_find_existing_chunk(dispatch->hypertable, point))
+			return false;
+
+		old = MemoryContextSwitchTo(estate->es_query_cxt);
+		create = chunk_create_async_start(dispatch->hypertable, point);
+
+		if (NULL != create)
+			state->async_creates = lappend(state->async_creates, create);
+
+		MemoryContextSwitchTo(old);
+
+		if (NULL == create)
+			return false;
+	}
+
+	tuplestore_puttupleslot(state->async_tuples, slot);
+
+	return true;
+}
+
+/*
+ * Check whether the workers are done creating their chunks. With "block",
+ * wait for each worker until it times out.
+ */
+static bool
+chunk_dispatch_async_done(ChunkDispatchState *state, bool block)
+{
+	ListCell   *lc;
+	bool		done = true;
+
+	foreach(lc, state->async_creates)
+	{
+		if (!chunk_create_async_wait(lfirst(lc), block))
+		{
+			if (!block)
+				return false;
+
+			done = false;
+		}
+	}
+
+	return done;
+}
+
+static void
+chunk_dispatch_async_end_flush(ChunkDispatchState *state)
+{
+	ListCell   *lc;
+
+	foreach(lc, state->async_creates)
+		chunk_create_async_end(lfirst(lc));
+
+	list_free(state->async_creates);
+	state->async_creates = NIL;
+	tuplestore_clear(state->async_tuples);
+	state->async_flushing = false;
+}
+
+/*
+ * Read a batch of tuples from the subplan and group them by chunk.
+ *
+ * Only the first tuple of a batch may need a new chunk insert state. Creating
+ * an insert state might evict other insert states from the cache, including
+ * those referenced by the tuples already in the batch. Therefore, the batch
+ * ends at the first tuple that doesn't map to a cached insert state, and that
+ * tuple is kept as the first tuple of the next batch.
+ *
+ * With asynchronous chunk creation, tuples that need a new chunk are
+ * buffered instead, while the batch carries on with other tuples. The
+ * buffered tuples are read before any further tuples of the subplan once
+ * their chunks exist, and at the latest when the subplan is exhausted.
+ */
+static void
+chunk_dispatch_fill_batch(ChunkDispatchState *state)
+{
+	ChunkDispatch *dispatch = state->dispatch;
+	PlanState  *substate = linitial(state->cscan_state.custom_ps);
+	EState	   *estate = state->cscan_state.ss.ps.state;
+	ChunkInsertState **groups;
+	int		   *group_of;
+	int		   *group_start;
+	int			num_groups = 0;
+	int			i,
+				j;
+	MemoryContext old;
+
+	MemoryContextReset(state->batch_mctx);
+	state->num_batch_tuples = 0;
+	state->next_batch_tuple = 0;
+
+	/* Save the main table's (hypertable's) ResultRelInfo */
+	if (NULL == dispatch->hypertable_result_rel_info)
+		dispatch->hypertable_result_rel_info = estate->es_result_relation_info;
+
+	if (NIL != state->async_creates && !state->async_flushing &&
+		chunk_dispatch_async_done(state, false))
+		state->async_flushing = true;
+
+	old = MemoryContextSwitchTo(state->batch_mctx);
+
+	while (state->num_batch_tuples < state->batch_size)
+	{
+		TupleTableSlot *slot;
+		HeapTuple	tuple;
+		Point	   *point;
+		ChunkInsertState *cis;
+
+		if (!TupIsNull(state->pending_slot))
+			slot = state->pending_slot;
+		else if (state->async_flushing)
+		{
+			if (!tuplestore_gettupleslot(state->async_tuples, true, false, state->async_slot))
+			{
+				chunk_dispatch_async_end_flush(state);
+				continue;
+			}
+
+			slot = state->async_slot;
+		}
+		else if (state->subplan_done)
+		{
+			if (NIL == state->async_creates)
+				break;
+
+			/*
+			 * The chunks that are still missing after the wait are created
+			 * as usual. There is no point in waiting for workers that wait
+			 * for this backend's lock.
+			 */
+			if (!chunk_dispatch_holds_chunk_create_lock(dispatch))
+				chunk_dispatch_async_done(state, true);
+
+			state->async_flushing = true;
+			continue;
+		}
+		else
+		{
+			slot = ExecProcNode(substate);
+
+			if (TupIsNull(slot))
+			{
+				state->subplan_done = true;
+				continue;
+			}
+		}
+
+		/* Calculate the tuple's point in the N-dimensional hyperspace */
+		point = chunk_dispatch_calculate_point(dispatch, slot);
+		tuple = ExecFetchSlotTuple(slot);
+		cis = chunk_dispatch_find_chunk_insert_state(dispatch, point);
+
+		if (NULL == cis)
+		{
+			if (NULL != state->async_tuples && !state->async_flushing &&
+				chunk_dispatch_async_buffer(state, point, slot))
+			{
+				if (slot == state->pending_slot)
+					ExecClearTuple(state->pending_slot);
+				continue;
+			}
+
+			if (state->num_batch_tuples > 0)
+			{
+				if (slot != state->pending_slot)
+					ExecCopySlot(state->pending_slot, slot);
+				break;
+			}
+
+			cis = chunk_dispatch_open_chunk_insert_state(dispatch, point);
+		}
+
+		state->batch_tuples[state->num_batch_tuples] = heap_copytuple(tuple);
+		state->batch_cis[state->num_batch_tuples] = cis;
+		state->num_batch_tuples++;
+
+		if (slot == state->pending_slot)
+			ExecClearTuple(state->pending_slot);
+	}
+
+	/*
+	 * Group the tuples by chunk using a counting sort over the chunk insert
+	 * states, in order of first appearance. This keeps the order of tuples
+	 * within each chunk.
+	 */
+	groups = palloc(sizeof(ChunkInsertState *) * state->num_batch_tuples);
+	group_of = palloc(sizeof(int) * state->num_batch_tuples);
+	group_start = palloc0(sizeof(int) * (state->num_batch_tuples + 1));
+
+	for (i = 0; i < state->num_batch_tuples; i++)
+	{
+		/* Search backwards, since tuples often go to the latest chunk */
+		for (j = num_groups - 1; j >= 0; j--)
+			if (groups[j] == state->batch_cis[i])
+				break;
+
+		if (j < 0)
+		{
+			j = num_groups++;
+			groups[j] = state->batch_cis[i];
+		}
+
+		group_of[i] = j;
+		group_start[j + 1]++;
+	}
+
+	for (j = 0; j < num_groups; j++)
+		group_start[j + 1] += group_start[j];
+
+	for (i = 0; i < state->num_batch_tuples; i++)
+		state->batch_order[group_start[group_of[i]]++] = i;
+
+	MemoryContextSwitchTo(old);
+}
+
+/*
+ * Return the next tuple of the current batch, reading a new batch from the
+ * subplan when the current one is exhausted.
+ */
+static TupleTableSlot *
+chunk_dispatch_exec_batch(ChunkDispatchState *state)
+{
+	EState	   *estate = state->cscan_state.ss.ps.state;
+	TupleTableSlot *slot = state->batch_slot;
+	ChunkInsertState *cis;
+	HeapTuple	tuple;
+	int			idx;
+
+	if (state->next_batch_tuple >= state->num_batch_tuples)
+	{
+		chunk_dispatch_fill_batch(state);
+
+		if (state->num_batch_tuples == 0)
+			return ExecClearTuple(slot);
+	}
+
+	idx = state->batch_order[state->next_batch_tuple++];
+	cis = state->batch_cis[idx];
+	tuple = state->batch_tuples[idx];
+
+	ExecStoreTuple(tuple, slot, InvalidBuffer, false);
+
+	/* Set the result relation in the executor state to the target chunk */
+	estate->es_result_relation_info = cis->result_relation_info;
+
+	/* Update the arbiter indexes of ON CONFLICT DO NOTHING to the chunk's */
+	if (cis->arbiter_indexes != NIL)
+		state->parent->mt_arbiterindexes = cis->arbiter_indexes;
+
+	/* Convert the tuple to the chunk's rowtype, if necessary */
+	chunk_insert_state_convert_tuple(cis, tuple, &slot);
+
+	return slot;
+}
+
+static void
+chunk_dispatch_reset_batch(ChunkDispatchState *state)
+{
+	state->num_batch_tuples = 0;
+	state->next_batch_tuple = 0;
+	state->subplan_done = false;
+
+	if (NULL != state->pending_slot)
+		ExecClearTuple(state->pending_slot);
+
+	if (NULL != state->async_tuples)
+		chunk_dispatch_async_end_flush(state);
+}
+
+/*
+ * Enable batched routing of tuples.
+ *
+ * Batching reorders tuples across chunks, so it is only used when that is not
+ * observable, i.e., the insert has no RETURNING clause and the hypertable has
+ * no row triggers. ON CONFLICT DO NOTHING is fine, since unique indexes
+ * include all partitioning columns, so tuples can only conflict with tuples
+ * in the same chunk, and those keep their order. ON CONFLICT DO UPDATE is
+ * not batched, since its updates can change the partitioning columns of
+ * existing rows.
+ */
+static void
+chunk_dispatch_init_batch(ChunkDispatchState *state, ModifyTableState *parent)
+{
+	ModifyTable *mt = (ModifyTable *) parent->ps.plan;
+	TriggerDesc *trigdesc = parent->resultRelInfo->ri_TrigDesc;
+	EState	   *estate = state->cscan_state.ss.ps.state;
+	PlanState  *substate = linitial(state->cscan_state.custom_ps);
+	TupleDesc	tupdesc = ExecGetResultType(substate);
+
+	if (guc_insert_batch_size <= 0 ||
+		parent->operation != CMD_INSERT ||
+		parent->mt_onconflict == ONCONFLICT_UPDATE ||
+		mt->returningLists != NIL ||
+		(trigdesc != NULL &&
+		 (trigdesc->trig_insert_before_row || trigdesc->trig_insert_after_row)))
+		return;
+
+	state->batch_size = guc_insert_batch_size;
+	state->batch_tuples = palloc(sizeof(HeapTuple) * state->batch_size);
+	state->batch_cis = palloc(sizeof(ChunkInsertState *) * state->batch_size);
+	state->batch_order = palloc(sizeof(int) * state->batch_size);
+	state->batch_mctx = AllocSetContextCreate(estate->es_query_cxt,
+											  "chunk dispatch batch memory context",
+											  ALLOCSET_DEFAULT_SIZES);
+	state->batch_slot = ExecInitExtraTupleSlot(estate);
+	ExecSetSlotDescriptor(state->batch_slot, tupdesc);
+	state->pending_slot = ExecInitExtraTupleSlot(estate);
+	ExecSetSlotDescriptor(state->pending_slot, tupdesc);
+
+	/*
+	 * Buffered tuples are inserted after later tuples of the same chunk,
+	 * which ON CONFLICT DO NOTHING would notice.
+	 */
+	if (guc_async_chunk_create_timeout > 0 && parent->mt_onconflict == ONCONFLICT_NONE)
+	{
+		state->async_tuples = tuplestore_begin_heap(false, false, work_mem);
+		state->async_slot = ExecInitExtraTupleSlot(estate);
+		ExecSetSlotDescriptor(state->async_slot, tupdesc);
+	}
+
+	chunk_dispatch_reset_batch(state);
+}
+
 static void
 chunk_dispatch_end(CustomScanState *node)
 {
@@ -106,6 +484,13 @@ chunk_dispatch_end(CustomScanState *node)
 	PlanState  *substate = linitial(node->custom_ps);
 
 	ExecEndNode(substate);
+
+	if (NULL != state->async_tuples)
+	{
+		chunk_dispatch_async_end_flush(state);
+		tuplestore_end(state->async_tuples);
+	}
+
 	chunk_dispatch_destroy(state->dispatch);
 	cache_release(state->hypertable_cache);
 }
@@ -113,17 +498,45 @@ chunk_dispatch_end(CustomScanState *node)
 static void
 chunk_dispatch_rescan(CustomScanState *node)
 {
+	ChunkDispatchState *state = (ChunkDispatchState *) node;
 	PlanState  *substate = linitial(node->custom_ps);
 
+	if (state->batch_size > 0)
+		chunk_dispatch_reset_batch(state);
+
 	ExecReScan(substate);
 }
 
+static void
+chunk_dispatch_explain(CustomScanState *node, List *ancestors, ExplainState *es)
+{
+	ChunkDispatchState *state = (ChunkDispatchState *) node;
+
+	if (es->analyze)
+	{
+		ChunkDispatch *dispatch = state->dispatch;
+		SubspaceStoreStats stats;
+
+		subspace_store_get_stats(dispatch->cache, &stats);
+
+		ExplainPropertyLong("Chunk Lookups", dispatch->num_lookups, es);
+		ExplainPropertyLong("Last Chunk Hits", dispatch->num_last_cis_hits, es);
+		ExplainPropertyLong("Cache Hits", stats.hits, es);
+		ExplainPropertyLong("Cache Misses", stats.misses, es);
+		ExplainPropertyLong("Cache Evictions", stats.evictions, es);
+		ExplainPropertyInteger("Chunks Touched", bms_num_members(dispatch->touched_chunks), es);
+		ExplainPropertyLong("Chunks Created", dispatch->num_chunks_created, es);
+		ExplainPropertyLong("Tuples Converted", dispatch->num_tuples_converted, es);
+	}
+}
+
 static CustomExecMethods chunk_dispatch_state_methods = {
 	.CustomName = CHUNK_DISPATCH_STATE_NAME,
 	.BeginCustomScan = chunk_dispatch_begin,
 	.EndCustomScan = chunk_dispatch_end,
 	.ExecCustomScan = chunk_dispatch_exec,
 	.ReScanCustomScan = chunk_dispatch_rescan,
+	.ExplainCustomScan = chunk_dispatch_explain,
 };
 
 ChunkDispatchState *
@@ -145,4 +558,8 @@ chunk_dispatch_state_set_parent(ChunkDispatchState *state, ModifyTableState *par
 	state->dispatch->arbiter_indexes = parent->mt_arbiterindexes;
 	state->dispatch->on_conflict = parent->mt_onconflict;
 	state->dispatch->cmd_type = parent->operation;
+#if PG10
+	state->dispatch->transition_capture = parent->mt_transition_capture;
+#endif
+	chunk_dispatch_init_batch(state, parent);
 }
@@ -4,6 +4,7 @@
 #include <postgres.h>
 #include <nodes/execnodes.h>
 #include <nodes/parsenodes.h>
+#include <utils/tuplestore.h>
 
 typedef struct ChunkDispatch ChunkDispatch;
 typedef struct ChunkDispatchInfo ChunkDispatchInfo;
@@ -29,6 +30,35 @@ typedef struct ChunkDispatchState
 	 * for each chunk.
 	 */
 	ChunkDispatch *dispatch;
+
+	/*
+	 * Batch of tuples read ahead from the subplan and grouped by chunk. The
+	 * tuples are returned in batch_order, so that consecutive tuples go to
+	 * the same chunk. Batching is disabled if batch_size is zero.
+	 */
+	int			batch_size;
+	int			num_batch_tuples;
+	int			next_batch_tuple;
+	HeapTuple  *batch_tuples;
+	ChunkInsertState **batch_cis;
+	int		   *batch_order;
+	MemoryContext batch_mctx;
+	TupleTableSlot *batch_slot;
+
+	/* A tuple that was read from the subplan but did not fit in the batch */
+	TupleTableSlot *pending_slot;
+	bool		subplan_done;
+
+	/*
+	 * Tuples whose chunks are being created by background workers, with
+	 * timescaledb.async_chunk_create_timeout. The tuples are routed again
+	 * once all the workers are done, or the wait for them timed out, in
+	 * which case the chunks that are still missing are created as usual.
+	 */
+	List	   *async_creates;	/* ChunkCreateAsync */
+	Tuplestorestate *async_tuples;
+	TupleTableSlot *async_slot;
+	bool		async_flushing;
 } ChunkDispatchState;
 
 #define CHUNK_DISPATCH_STATE_NAME "ChunkDispatchState"
@@ -1,4 +1,5 @@
 #include <postgres.h>
+#include <access/amapi.h>
 #include <catalog/index.h>
 #include <catalog/indexing.h>
 #include <catalog/pg_index.h>
@@ -24,6 +25,7 @@
 #include "catalog.h"
 #include "scanner.h"
 #include "chunk.h"
+#include "timing.h"
 #include "compat.h"
 
 static List *
@@ -226,12 +228,18 @@ chunk_index_select_tablespace(Relation htrel, Relation chunkrel)
 
 /*
  * Create a chunk index based on the configuration of the "parent" index.
+ *
+ * The index is created with the given access method, or, if invalid, with
+ * the method of the template index. An index of another method gets the
+ * default operator classes of that method, and none of the template's
+ * options, which are specific to the template's method.
  */
 static Oid
 chunk_relation_index_create(Relation htrel,
 							Relation template_indexrel,
 							Relation chunkrel,
-							bool isconstraint)
+							bool isconstraint,
+							Oid amoid)
 {
 	Oid			chunk_indexrelid = InvalidOid;
 	const char *indexname;
@@ -241,6 +249,8 @@ chunk_relation_index_create(Relation htrel,
 	Datum		reloptions;
 	Datum		indclass;
 	oidvector  *indclassoid;
+	Oid		   *classoids;
+	int16	   *coloptions = template_indexrel->rd_indoption;
 	List	   *colnames = create_index_colnames(template_indexrel);
 	Oid			tablespace = InvalidOid;
 
@@ -264,6 +274,33 @@ chunk_relation_index_create(Relation htrel,
 							   Anum_pg_index_indclass, &isnull);
 	Assert(!isnull);
 	indclassoid = (oidvector *) DatumGetPointer(indclass);
+	classoids = indclassoid->values;
+
+	if (!OidIsValid(amoid))
+		amoid = template_indexrel->rd_rel->relam;
+
+	if (amoid != template_indexrel->rd_rel->relam)
+	{
+		TupleDesc	idxdesc = RelationGetDescr(template_indexrel);
+		int			i;
+
+		classoids = palloc(sizeof(Oid) * idxdesc->natts);
+		coloptions = palloc0(sizeof(int16) * idxdesc->natts);
+		reloptions = (Datum) 0;
+
+		for (i = 0; i < idxdesc->natts; i++)
+		{
+			Oid			atttype = idxdesc->attrs[i]->atttypid;
+
+			classoids[i] = GetDefaultOpClass(atttype, amoid);
+
+			if (!OidIsValid(classoids[i]))
+				ereport(ERROR,
+						(errcode(ERRCODE_UNDEFINED_OBJECT),
+						 errmsg("data type %s has no default operator class for access method \"%s\"",
+								format_type_be(atttype), get_am_name(amoid))));
+		}
+	}
 
 	indexname = chunk_index_choose_name(get_rel_name(RelationGetRelid(chunkrel)),
 										get_rel_name(RelationGetRelid(template_indexrel)),
@@ -284,11 +321,11 @@ chunk_relation_index_create(Relation htrel,
 									InvalidOid,
 									indexinfo,
 									colnames,
-									template_indexrel->rd_rel->relam,
+									amoid,
 									tablespace,
 									template_indexrel->rd_indcollation,
-									indclassoid->values,
-									template_indexrel->rd_indoption,
+									classoids,
+									coloptions,
 									reloptions,
 									template_indexrel->rd_index->indisprimary,
 									isconstraint,
@@ -306,6 +343,23 @@ chunk_relation_index_create(Relation htrel,
 }
 
 
+static void
+chunk_index_fill_tuple_values(int32 chunk_id,
+							  const char *chunk_index,
+							  int32 hypertable_id,
+							  const char *parent_index,
+							  Datum values[Natts_chunk_index],
+							  bool nulls[Natts_chunk_index])
+{
+	values[Anum_chunk_index_chunk_id - 1] = Int32GetDatum(chunk_id);
+	values[Anum_chunk_index_index_name - 1] =
+		DirectFunctionCall1(namein, CStringGetDatum(chunk_index));
+	values[Anum_chunk_index_hypertable_id - 1] = Int32GetDatum(hypertable_id);
+	values[Anum_chunk_index_hypertable_index_name - 1] =
+		DirectFunctionCall1(namein, CStringGetDatum(parent_index));
+	memset(nulls, 0, sizeof(bool) * Natts_chunk_index);
+}
+
 static bool
 chunk_index_insert_relation(Relation rel,
 							int32 chunk_id,
@@ -315,15 +369,11 @@ chunk_index_insert_relation(Relation rel,
 {
 	TupleDesc	desc = RelationGetDescr(rel);
 	Datum		values[Natts_chunk_index];
-	bool		nulls[Natts_chunk_index] = {false};
+	bool		nulls[Natts_chunk_index];
 	CatalogSecurityContext sec_ctx;
 
-	values[Anum_chunk_index_chunk_id - 1] = Int32GetDatum(chunk_id);
-	values[Anum_chunk_index_index_name - 1] =
-		DirectFunctionCall1(namein, CStringGetDatum(chunk_index));
-	values[Anum_chunk_index_hypertable_id - 1] = Int32GetDatum(hypertable_id);
-	values[Anum_chunk_index_hypertable_index_name - 1] =
-		DirectFunctionCall1(namein, CStringGetDatum(parent_index));
+	chunk_index_fill_tuple_values(chunk_id, chunk_index, hypertable_id, parent_index,
+								  values, nulls);
 
 	catalog_become_owner(catalog_get(), &sec_ctx);
 	catalog_insert_values(rel, desc, values, nulls);
@@ -345,7 +395,7 @@ chunk_index_insert(int32 chunk_id,
 	Relation	rel;
 	bool		result;
 
-	rel = heap_open(catalog->tables[CHUNK_INDEX].id, RowExclusiveLock);
+	rel = heap_open(catalog_table_get_id(catalog, CHUNK_INDEX), RowExclusiveLock);
 	result = chunk_index_insert_relation(rel, chunk_id, chunk_index, hypertable_id, hypertable_index);
 	heap_close(rel, RowExclusiveLock);
 
@@ -367,41 +417,77 @@ chunk_index_create_from_constraint(int32 hypertable_id, Oid hypertable_constrain
 					   get_rel_name(hypertable_indexrelid));
 }
 
+/*
+ * Add the parent-child mappings of a chunk's new indexes to the catalog. The
+ * catalog's indexes are opened once and the rows are made visible together.
+ */
+static void
+chunk_index_insert_multi(int32 chunk_id,
+						 List *chunk_indexes,
+						 int32 hypertable_id,
+						 List *hypertable_indexes)
+{
+	Catalog    *catalog = catalog_get();
+	CatalogSecurityContext sec_ctx;
+	CatalogIndexState indstate;
+	Relation	rel;
+	ListCell   *lc_chunk,
+			   *lc_ht;
+
+	if (chunk_indexes == NIL)
+		return;
+
+	rel = heap_open(catalog_table_get_id(catalog, CHUNK_INDEX), RowExclusiveLock);
+	indstate = CatalogOpenIndexes(rel);
+	catalog_become_owner(catalog, &sec_ctx);
+
+	forboth(lc_chunk, chunk_indexes, lc_ht, hypertable_indexes)
+	{
+		Datum		values[Natts_chunk_index];
+		bool		nulls[Natts_chunk_index];
+
+		chunk_index_fill_tuple_values(chunk_id, lfirst(lc_chunk), hypertable_id,
+									  lfirst(lc_ht), values, nulls);
+		catalog_insert_values_with_info(rel, indstate, RelationGetDescr(rel), values, nulls);
+	}
+
+	catalog_restore_user(&sec_ctx);
+	CatalogCloseIndexes(indstate);
+	heap_close(rel, RowExclusiveLock);
+
+	CommandCounterIncrement();
+}
+
 /*
  * Create a new chunk index as a child of a parent hypertable index.
  *
  * The chunk index is created based on the information from the parent index
  * relation. This function is typically called when a new chunk is created and
  * it should, for each hypertable index, have a corresponding index of its own.
+ *
+ * Returns the new index, or InvalidOid if the index is created by a
+ * constraint. The caller adds the index to the catalog.
  */
-static void
+static Oid
 chunk_index_create(Relation hypertable_rel,
-				   int32 hypertable_id,
 				   Relation hypertable_idxrel,
-				   int32 chunk_id,
 				   Relation chunkrel,
 				   Oid constraint_oid)
 {
-	Oid			chunk_indexrelid;
-
 	if (OidIsValid(constraint_oid))
 	{
 		/*
 		 * If there is an associated constraint then that constraint created
 		 * both the index and the catalog entry for the index
 		 */
-		return;
+		return InvalidOid;
 	}
 
-	chunk_indexrelid = chunk_relation_index_create(hypertable_rel,
-												   hypertable_idxrel,
-												   chunkrel,
-												   false);
-
-	chunk_index_insert(chunk_id,
-					   get_rel_name(chunk_indexrelid),
-					   hypertable_id,
-					   get_rel_name(RelationGetRelid(hypertable_idxrel)));
+	return chunk_relation_index_create(hypertable_rel,
+									   hypertable_idxrel,
+									   chunkrel,
+									   false,
+									   InvalidOid);
 }
 
 /*
@@ -419,7 +505,13 @@ chunk_index_create_from_stmt(IndexStmt *stmt,
 							 Oid hypertable_indexrelid)
 {
 	ObjectAddress idxobj;
-	char	   *hypertable_indexname = get_rel_name(hypertable_indexrelid);
+	char	   *hypertable_indexname;
+
+	/* Foreign chunks are indexed by their data node's hypertable */
+	if (get_rel_relkind(chunkrelid) == RELKIND_FOREIGN_TABLE)
+		return InvalidOid;
+
+	hypertable_indexname = get_rel_name(hypertable_indexrelid);
 
 	if (NULL != stmt->idxname)
 		stmt->idxname = chunk_index_choose_name(get_rel_name(chunkrelid),
@@ -466,7 +558,16 @@ chunk_index_create_all(int32 hypertable_id, Oid hypertable_relid, int32 chunk_id
 	Relation	htrel;
 	Relation	chunkrel;
 	List	   *indexlist;
+	List	   *chunk_indexes = NIL;
+	List	   *hypertable_indexes = NIL;
 	ListCell   *lc;
+	TimingState timing;
+
+	/* Foreign chunks are indexed by their data node's hypertable */
+	if (get_rel_relkind(chunkrelid) == RELKIND_FOREIGN_TABLE)
+		return;
+
+	timing_begin(&timing, TIMING_CHUNK_INDEX_CREATE);
 
 	htrel = relation_open(hypertable_relid, AccessShareLock);
 
@@ -490,19 +591,29 @@ chunk_index_create_all(int32 hypertable_id, Oid hypertable_relid, int32 chunk_id
 	{
 		Oid			hypertable_idxoid = lfirst_oid(lc);
 		Relation	hypertable_idxrel = relation_open(hypertable_idxoid, AccessShareLock);
+		Oid			chunk_idxoid;
+
+		chunk_idxoid = chunk_index_create(htrel,
+										  hypertable_idxrel,
+										  chunkrel,
+										  get_index_constraint(hypertable_idxoid));
 
-		chunk_index_create(htrel,
-						   hypertable_id,
-						   hypertable_idxrel,
-						   chunk_id,
-						   chunkrel,
-						   get_index_constraint(hypertable_idxoid));
+		if (OidIsValid(chunk_idxoid))
+		{
+			chunk_indexes = lappend(chunk_indexes, get_rel_name(chunk_idxoid));
+			hypertable_indexes = lappend(hypertable_indexes,
+										 pstrdup(RelationGetRelationName(hypertable_idxrel)));
+		}
 
 		relation_close(hypertable_idxrel, AccessShareLock);
 	}
 
+	chunk_index_insert_multi(chunk_id, chunk_indexes, hypertable_id, hypertable_indexes);
+
 	relation_close(chunkrel, NoLock);
 	relation_close(htrel, AccessShareLock);
+
+	timing_end(&timing, InvalidOid);
 }
 
 static int
@@ -511,7 +622,7 @@ chunk_index_scan(int indexid, ScanKeyData scankey[], int nkeys,
 {
 	Catalog    *catalog = catalog_get();
 	ScannerCtx	scanCtx = {
-		.table = catalog->tables[CHUNK_INDEX].id,
+		.table = catalog_table_get_id(catalog, CHUNK_INDEX),
 		.index = CATALOG_INDEX(catalog, CHUNK_INDEX, indexid),
 		.nkeys = nkeys,
 		.scankey = scankey,
@@ -752,8 +863,12 @@ chunk_index_get_by_indexrelid(Chunk *chunk, Oid chunk_indexrelid)
 				Anum_chunk_index_chunk_id_index_name_idx_index_name,
 				BTEqualStrategyNumber, F_NAMEEQ, DirectFunctionCall1(namein, CStringGetDatum(indexname)));
 
-	chunk_index_scan(CHUNK_INDEX_CHUNK_ID_INDEX_NAME_IDX,
-					 scankey, 2, chunk_index_tuple_found, NULL, cim, AccessShareLock);
+	if (chunk_index_scan(CHUNK_INDEX_CHUNK_ID_INDEX_NAME_IDX,
+						 scankey, 2, chunk_index_tuple_found, NULL, cim, AccessShareLock) < 1)
+	{
+		pfree(cim);
+		return NULL;
+	}
 
 	return cim;
 }
@@ -783,8 +898,12 @@ chunk_index_get_by_hypertable_indexrelid(Chunk *chunk, Oid hypertable_indexrelid
 				Anum_chunk_index_chunk_id_index_name_idx_chunk_id,
 				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(chunk->fd.id));
 
-	chunk_index_scan(CHUNK_INDEX_CHUNK_ID_INDEX_NAME_IDX,
-					 scankey, 1, chunk_index_tuple_found, chunk_hypertable_index_name_filter, cim, AccessShareLock);
+	if (chunk_index_scan(CHUNK_INDEX_CHUNK_ID_INDEX_NAME_IDX, scankey, 1, chunk_index_tuple_found,
+						 chunk_hypertable_index_name_filter, cim, AccessShareLock) < 1)
+	{
+		pfree(cim);
+		return NULL;
+	}
 
 	return cim;
 }
@@ -925,11 +1044,9 @@ chunk_index_mark_clustered(Oid chunkrelid, Oid indexrelid)
 	heap_close(rel, AccessShareLock);
 }
 
-TS_FUNCTION_INFO_V1(chunk_index_clone);
-Datum
-chunk_index_clone(PG_FUNCTION_ARGS)
+static Oid
+chunk_index_clone_relid(Oid chunk_index_oid, Oid amoid)
 {
-	Oid			chunk_index_oid = PG_GETARG_OID(0);
 	Relation	chunk_index_rel;
 	Relation	hypertable_rel;
 	Relation	chunk_rel;
@@ -943,6 +1060,12 @@ chunk_index_clone(PG_FUNCTION_ARGS)
 	chunk = chunk_get_by_relid(chunk_index_rel->rd_index->indrelid, 0, true);
 	cim = chunk_index_get_by_indexrelid(chunk, chunk_index_oid);
 
+	if (NULL == cim)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("\"%s\" is not the index of a hypertable index",
+						RelationGetRelationName(chunk_index_rel))));
+
 	hypertable_rel = heap_open(cim->hypertableoid, AccessShareLock);
 
 	/* Need ShareLock on the heap relation we are creating indexes on */
@@ -951,7 +1074,8 @@ chunk_index_clone(PG_FUNCTION_ARGS)
 	constraint_oid = get_index_constraint(cim->parent_indexoid);
 
 	new_chunk_indexrelid = chunk_relation_index_create(hypertable_rel, chunk_index_rel,
-													   chunk_rel, OidIsValid(constraint_oid));
+													   chunk_rel, OidIsValid(constraint_oid),
+													   amoid);
 
 	heap_close(chunk_rel, NoLock);
 
@@ -959,17 +1083,13 @@ chunk_index_clone(PG_FUNCTION_ARGS)
 
 	relation_close(chunk_index_rel, AccessShareLock);
 
-	PG_RETURN_OID(new_chunk_indexrelid);
+	return new_chunk_indexrelid;
 }
 
-TS_FUNCTION_INFO_V1(chunk_index_replace);
-Datum
-chunk_index_replace(PG_FUNCTION_ARGS)
+static void
+chunk_index_replace_relid(Oid chunk_index_oid_old, Oid chunk_index_oid_new)
 {
-	Oid			chunk_index_oid_old = PG_GETARG_OID(0);
-	Oid			chunk_index_oid_new = PG_GETARG_OID(1);
 	Relation	index_rel;
-
 	Oid			constraint_oid;
 	char	   *name;
 
@@ -1000,6 +1120,115 @@ chunk_index_replace(PG_FUNCTION_ARGS)
 	}
 
 	RenameRelationInternal(chunk_index_oid_new, name, false);
+}
+
+/*
+ * Rebuild all indexes of a chunk.
+ *
+ * Each index that corresponds to a hypertable index is rebuilt side by side
+ * with the original, like chunk_index_clone() and chunk_index_replace(). The
+ * build only blocks writes to the chunk, while reads are only blocked for
+ * the quick swap at the end. Indexes that back constraints, or that only
+ * exist on the chunk, cannot be swapped and are reindexed in place instead.
+ */
+void
+chunk_index_rebuild_all(Oid chunkrelid)
+{
+	Relation	chunkrel;
+	Chunk	   *chunk;
+	List	   *indexlist;
+	List	   *old_indexes = NIL;
+	List	   *new_indexes = NIL;
+	ListCell   *lc,
+			   *lc_new;
+	char		relpersistence;
+
+	chunkrel = heap_open(chunkrelid, ShareLock);
+	indexlist = RelationGetIndexList(chunkrel);
+	relpersistence = chunkrel->rd_rel->relpersistence;
+	heap_close(chunkrel, NoLock);
+
+	chunk = chunk_get_by_relid(chunkrelid, 0, true);
+
+	foreach(lc, indexlist)
+	{
+		Oid			indexrelid = lfirst_oid(lc);
+
+		if (OidIsValid(get_index_constraint(indexrelid)) ||
+			NULL == chunk_index_get_by_indexrelid(chunk, indexrelid))
+		{
+			reindex_index(indexrelid, false, relpersistence, 0);
+			continue;
+		}
+
+		old_indexes = lappend_oid(old_indexes, indexrelid);
+		new_indexes = lappend_oid(new_indexes, chunk_index_clone_relid(indexrelid, InvalidOid));
+	}
+
+	CommandCounterIncrement();
+
+	forboth(lc, old_indexes, lc_new, new_indexes)
+		chunk_index_replace_relid(lfirst_oid(lc), lfirst_oid(lc_new));
+}
+
+/*
+ * Check that an index can be rebuilt with another index access method.
+ * Indexes that back constraints, unique indexes, and indexes with more
+ * columns than the method supports cannot.
+ */
+void
+chunk_index_check_access_method(Oid indexrelid, Oid amoid)
+{
+	Relation	indexrel = index_open(indexrelid, AccessShareLock);
+	IndexAmRoutine *amroutine = GetIndexAmRoutineByAmIdCompat(amoid);
+
+	if (OidIsValid(get_index_constraint(indexrelid)) ||
+		indexrel->rd_index->indisunique)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot change the access method of unique or constraint index \"%s\"",
+						RelationGetRelationName(indexrel))));
+
+	if (RelationGetNumberOfAttributes(indexrel) > 1 && !amroutine->amcanmulticol)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("access method \"%s\" does not support multicolumn indexes",
+						get_am_name(amoid))));
+
+	index_close(indexrel, AccessShareLock);
+}
+
+/*
+ * Rebuild a chunk index with another index access method, e.g., a B-tree as
+ * a much smaller BRIN index once the chunk is no longer written to. Like
+ * chunk_index_clone() and chunk_index_replace(), the new index is built side
+ * by side with the old one and takes over its name, so the chunk_index
+ * mapping to the hypertable index stays the same. Queries on the hypertable
+ * are planned on the chunks' own indexes, and simply see the new method.
+ */
+void
+chunk_index_set_access_method(Oid chunk_indexrelid, Oid amoid)
+{
+	Oid			new_chunk_indexrelid;
+
+	chunk_index_check_access_method(chunk_indexrelid, amoid);
+	new_chunk_indexrelid = chunk_index_clone_relid(chunk_indexrelid, amoid);
+	CommandCounterIncrement();
+	chunk_index_replace_relid(chunk_indexrelid, new_chunk_indexrelid);
+}
+
+TS_FUNCTION_INFO_V1(chunk_index_clone);
+Datum
+chunk_index_clone(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_OID(chunk_index_clone_relid(PG_GETARG_OID(0), InvalidOid));
+}
+
+TS_FUNCTION_INFO_V1(chunk_index_replace);
+Datum
+chunk_index_replace(PG_FUNCTION_ARGS)
+{
+	chunk_index_replace_relid(PG_GETARG_OID(0), PG_GETARG_OID(1));
 
 	PG_RETURN_VOID();
 }
@@ -30,6 +30,9 @@ extern void chunk_index_create_from_constraint(int32 hypertable_id, Oid hypertab
 extern List *chunk_index_get_mappings(Hypertable *ht, Oid hypertable_indexrelid);
 extern ChunkIndexMapping *chunk_index_get_by_hypertable_indexrelid(Chunk *chunk, Oid hypertable_indexrelid);
 extern void chunk_index_mark_clustered(Oid chunkrelid, Oid indexrelid);
+extern void chunk_index_rebuild_all(Oid chunkrelid);
+extern void chunk_index_check_access_method(Oid indexrelid, Oid amoid);
+extern void chunk_index_set_access_method(Oid chunk_indexrelid, Oid amoid);
 
 /* chunk_index_recreate  is a process akin to reindex
  * except that indexes are created in 2 steps
@@ -4,14 +4,19 @@
 #include <utils/rls.h>
 #include <utils/lsyscache.h>
 #include <utils/guc.h>
+#include <utils/hsearch.h>
+#include <utils/memutils.h>
 #include <nodes/plannodes.h>
 #include <nodes/relation.h>
 #include <access/xact.h>
+#include <access/xlog.h>
+#include <access/heapam.h>
 #include <optimizer/plancat.h>
 #include <optimizer/clauses.h>
 #include <optimizer/planner.h>
 #include <miscadmin.h>
 #include <parser/parsetree.h>
+#include <foreign/fdwapi.h>
 
 #include "errors.h"
 #include "chunk_insert_state.h"
@@ -19,6 +24,11 @@
 #include "chunk_dispatch_state.h"
 #include "compat.h"
 #include "chunk_index.h"
+#include "chunk_bloom_filter.h"
+#include "chunk_time_range.h"
+#include "dimension.h"
+#include "dimension_slice.h"
+#include "hypercube.h"
 
 /*
  * Create a new RangeTblEntry for the chunk in the executor's range table and
@@ -95,11 +105,41 @@ chunk_insert_state_convert_tuple(ChunkInsertState *state,
 {
 	Relation	chunkrel = state->result_relation_info->ri_RelationDesc;
 
+	/* Every routed tuple passes through here */
+	state->dispatch->num_tuples++;
+
+#if PG10
+	if (NULL != state->dispatch->transition_capture)
+	{
+		TransitionCaptureState *tcs = state->dispatch->transition_capture;
+		TriggerDesc *trigdesc = state->result_relation_info->ri_TrigDesc;
+
+		/*
+		 * Capture the tuple in the hypertable's rowtype for its transition
+		 * tables, like PostgreSQL does for tuples routed to partitions.
+		 * BEFORE ROW triggers might change the tuple, so in that case the
+		 * tuple inserted into the chunk is converted back instead.
+		 */
+		if (trigdesc != NULL &&
+			(trigdesc->trig_insert_before_row || trigdesc->trig_insert_instead_row))
+		{
+			tcs->tcs_original_insert_tuple = NULL;
+			tcs->tcs_map = state->transition_map;
+		}
+		else
+		{
+			tcs->tcs_original_insert_tuple = tuple;
+			tcs->tcs_map = NULL;
+		}
+	}
+#endif
+
 	if (NULL == state->tup_conv_map)
 		/* No conversion needed */
 		return tuple;
 
 	tuple = do_convert_tuple(tuple, state->tup_conv_map);
+	state->dispatch->num_tuples_converted++;
 
 	ExecSetSlotDescriptor(state->slot, RelationGetDescr(chunkrel));
 	ExecStoreTuple(tuple, state->slot, InvalidBuffer, true);
@@ -110,16 +150,159 @@ chunk_insert_state_convert_tuple(ChunkInsertState *state,
 	return tuple;
 }
 
-/* Just like ExecPrepareExpr except that it doesn't switch to the query memory context */
-static inline ExprState *
-prepare_constr_expr(Expr *node)
+/*
+ * Session-level cache of the parts of a chunk insert state that can be reused
+ * across statements.
+ *
+ * A chunk insert state only lives as long as the statement that inserts into
+ * the chunk, so each new statement would otherwise plan the chunk's CHECK
+ * constraints and look up its arbiter indexes anew. The cache is keyed on the
+ * chunk's relid and an entry is evicted on relcache invalidation of the chunk,
+ * which happens on any change to the chunk's constraints or indexes.
+ *
+ * Catalog lookups can process invalidations, so cached data is only copied
+ * out of, or into, an entry right after looking it up. Executor state is
+ * always built on a copy.
+ */
+typedef struct ChunkInsertStateCacheEntry
+{
+	Oid			chunk_relid;	/* hash key */
+	MemoryContext mctx;
+	int			num_check;
+	Node	  **check_exprs;	/* planned CHECK constraint expressions */
+	List	   *hypertable_indexes;
+	List	   *chunk_indexes;	/* chunk index for each hypertable index */
+} ChunkInsertStateCacheEntry;
+
+static HTAB *cis_cache = NULL;
+
+static ChunkInsertStateCacheEntry *
+cis_cache_lookup(Oid chunk_relid, bool create)
+{
+	ChunkInsertStateCacheEntry *entry;
+	bool		found;
+
+	if (NULL == cis_cache)
+	{
+		HASHCTL		ctl;
+
+		if (!create)
+			return NULL;
+
+		memset(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(Oid);
+		ctl.entrysize = sizeof(ChunkInsertStateCacheEntry);
+		ctl.hcxt = CacheMemoryContext;
+
+		cis_cache = hash_create("chunk insert state cache", 64, &ctl,
+								HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	entry = hash_search(cis_cache, &chunk_relid, create ? HASH_ENTER : HASH_FIND, &found);
+
+	if (create && !found)
+	{
+		entry->num_check = 0;
+		entry->check_exprs = NULL;
+		entry->hypertable_indexes = NIL;
+		entry->chunk_indexes = NIL;
+		entry->mctx = AllocSetContextCreate(CacheMemoryContext,
+											"chunk insert state cache entry",
+											ALLOCSET_SMALL_SIZES);
+	}
+
+	return entry;
+}
+
+static void
+cis_cache_entry_remove(ChunkInsertStateCacheEntry *entry)
+{
+	MemoryContextDelete(entry->mctx);
+	hash_search(cis_cache, &entry->chunk_relid, HASH_REMOVE, NULL);
+}
+
+/*
+ * Evict a chunk from the chunk insert state cache, or all chunks if the relid
+ * is invalid.
+ */
+void
+chunk_insert_state_cache_invalidate(Oid chunk_relid)
 {
-	ExprState  *result;
+	ChunkInsertStateCacheEntry *entry;
+
+	if (NULL == cis_cache)
+		return;
+
+	if (OidIsValid(chunk_relid))
+	{
+		entry = hash_search(cis_cache, &chunk_relid, HASH_FIND, NULL);
+
+		if (NULL != entry)
+			cis_cache_entry_remove(entry);
+	}
+	else
+	{
+		HASH_SEQ_STATUS status;
+
+		hash_seq_init(&status, cis_cache);
+
+		while ((entry = hash_seq_search(&status)) != NULL)
+			cis_cache_entry_remove(entry);
+	}
+}
+
+/* Plan a CHECK constraint expression like ExecPrepareExpr does */
+static inline Node *
+plan_constr_expr(char *ccbin)
+{
+#if PG10
+	return (Node *) expression_planner(stringToNode(ccbin));
+#elif PG96
+	/* ExecQual wants implicit-AND form */
+	List	   *qual = make_ands_implicit(stringToNode(ccbin));
+
+	return (Node *) expression_planner((Expr *) qual);
+#endif
+}
+
+/*
+ * Get the planned CHECK constraint expressions of a chunk, allocated in the
+ * current memory context.
+ */
+static Node **
+get_constr_exprs(Relation rel)
+{
+	ConstrCheck *check = rel->rd_att->constr->check;
+	int			ncheck = rel->rd_att->constr->num_check;
+	Node	  **exprs = palloc(ncheck * sizeof(Node *));
+	ChunkInsertStateCacheEntry *entry;
+	MemoryContext old;
+	int			i;
+
+	entry = cis_cache_lookup(RelationGetRelid(rel), false);
+
+	if (NULL != entry && NULL != entry->check_exprs && entry->num_check == ncheck)
+	{
+		for (i = 0; i < ncheck; i++)
+			exprs[i] = copyObject(entry->check_exprs[i]);
+
+		return exprs;
+	}
+
+	for (i = 0; i < ncheck; i++)
+		exprs[i] = plan_constr_expr(check[i].ccbin);
+
+	entry = cis_cache_lookup(RelationGetRelid(rel), true);
+	old = MemoryContextSwitchTo(entry->mctx);
+	entry->check_exprs = palloc(ncheck * sizeof(Node *));
+
+	for (i = 0; i < ncheck; i++)
+		entry->check_exprs[i] = copyObject(exprs[i]);
 
-	node = expression_planner(node);
-	result = ExecInitExpr(node, NULL);
+	entry->num_check = ncheck;
+	MemoryContextSwitchTo(old);
 
-	return result;
+	return exprs;
 }
 
 /*
@@ -132,37 +315,27 @@ create_chunk_rri_constraint_expr(ResultRelInfo *rri, Relation rel)
 {
 	int			ncheck,
 				i;
-	ConstrCheck *check;
+	Node	  **exprs;
 
 	Assert(rel->rd_att->constr != NULL &&
 		   rri->ri_ConstraintExprs == NULL);
 
 	ncheck = rel->rd_att->constr->num_check;
-	check = rel->rd_att->constr->check;
+	exprs = get_constr_exprs(rel);
 
 #if PG10
 	rri->ri_ConstraintExprs =
 		(ExprState **) palloc(ncheck * sizeof(ExprState *));
 
 	for (i = 0; i < ncheck; i++)
-	{
-		Expr	   *checkconstr = stringToNode(check[i].ccbin);
-
-		rri->ri_ConstraintExprs[i] =
-			prepare_constr_expr(checkconstr);
-	}
+		rri->ri_ConstraintExprs[i] = ExecInitExpr((Expr *) exprs[i], NULL);
 #elif PG96
 	rri->ri_ConstraintExprs =
 		(List **) palloc(ncheck * sizeof(List *));
 
 	for (i = 0; i < ncheck; i++)
-	{
-		/* ExecQual wants implicit-AND form */
-		List	   *qual = make_ands_implicit(stringToNode(check[i].ccbin));
-
 		rri->ri_ConstraintExprs[i] = (List *)
-			prepare_constr_expr((Expr *) qual);
-	}
+			ExecInitExpr((Expr *) exprs[i], NULL);
 #endif
 }
 
@@ -220,21 +393,116 @@ tuple_conversion_needed(TupleDesc indesc,
 			indesc->tdhasoid != outdesc->tdhasoid);
 }
 
-/* Translate hypertable indexes to chunk indexes in the arbiter clause */
+/*
+ * Translate hypertable indexes to chunk indexes in the arbiter clause.
+ *
+ * The mappings are kept in the chunk insert state cache, so that the catalog
+ * is only scanned the first time a statement with the same arbiter indexes
+ * inserts into the chunk.
+ */
 static void
-chunk_insert_state_set_arbiter_indexes(ChunkInsertState *state, ChunkDispatch *dispatch, Relation chunk_rel)
+chunk_insert_state_set_arbiter_indexes(ChunkInsertState *state, ChunkDispatch *dispatch,
+									   Chunk *chunk)
 {
+	ChunkInsertStateCacheEntry *entry;
+	List	   *missing = NIL;
+	MemoryContext old;
 	ListCell   *lc;
+	ListCell   *lc_ht;
+	ListCell   *lc_chunk;
 
 	state->arbiter_indexes = NIL;
+	entry = cis_cache_lookup(chunk->table_id, false);
+
 	foreach(lc, dispatch->arbiter_indexes)
 	{
 		Oid			hypertable_index = lfirst_oid(lc);
-		Chunk	   *chunk = chunk_get_by_relid(RelationGetRelid(chunk_rel), 0, true);
-		ChunkIndexMapping *cim = chunk_index_get_by_hypertable_indexrelid(chunk, hypertable_index);
+		Oid			chunk_index = InvalidOid;
+
+		if (NULL != entry)
+		{
+			forboth(lc_ht, entry->hypertable_indexes, lc_chunk, entry->chunk_indexes)
+			{
+				if (lfirst_oid(lc_ht) == hypertable_index)
+				{
+					chunk_index = lfirst_oid(lc_chunk);
+					break;
+				}
+			}
+		}
+
+		if (!OidIsValid(chunk_index))
+		{
+			ChunkIndexMapping *cim = chunk_index_get_by_hypertable_indexrelid(chunk, hypertable_index);
+
+			chunk_index = cim->indexoid;
+			missing = lappend_oid(missing, hypertable_index);
+			missing = lappend_oid(missing, chunk_index);
+
+			/* The lookup might have processed invalidations */
+			entry = cis_cache_lookup(chunk->table_id, false);
+		}
+
+		state->arbiter_indexes = lappend_oid(state->arbiter_indexes, chunk_index);
+	}
+
+	if (missing == NIL)
+		return;
+
+	entry = cis_cache_lookup(chunk->table_id, true);
+	old = MemoryContextSwitchTo(entry->mctx);
 
-		state->arbiter_indexes = lappend_oid(state->arbiter_indexes, cim->indexoid);
+	for (lc = list_head(missing); lc != NULL; lc = lnext(lnext(lc)))
+	{
+		entry->hypertable_indexes = lappend_oid(entry->hypertable_indexes, lfirst_oid(lc));
+		entry->chunk_indexes = lappend_oid(entry->chunk_indexes, lfirst_oid(lnext(lc)));
 	}
+
+	MemoryContextSwitchTo(old);
+	list_free(missing);
+}
+
+/*
+ * Start inserting into a foreign chunk on a data node.
+ *
+ * The FDW expects a ModifyTable plan to have been planned for the foreign
+ * table, so plan a plain INSERT into the chunk and hand the FDW's private
+ * state for it to BeginForeignModify(). Tuples are then sent to the data node
+ * with ExecForeignInsert(), which the executor's ExecInsert() calls for
+ * foreign result relations.
+ */
+static void
+chunk_insert_state_begin_foreign_modify(ChunkInsertState *state, ChunkDispatch *dispatch)
+{
+	ResultRelInfo *rri = state->result_relation_info;
+	FdwRoutine *fdwroutine = rri->ri_FdwRoutine;
+	EState	   *estate = dispatch->estate;
+	Query	   *parse = makeNode(Query);
+	PlannerInfo *root = makeNode(PlannerInfo);
+	ModifyTable *plan = makeNode(ModifyTable);
+	List	   *fdw_private = NIL;
+
+	parse->commandType = CMD_INSERT;
+	parse->resultRelation = 1;
+	parse->rtable = list_make1(rt_fetch(rri->ri_RangeTableIndex, estate->es_range_table));
+	root->parse = parse;
+	root->glob = makeNode(PlannerGlobal);
+	root->query_level = 1;
+
+	plan->operation = CMD_INSERT;
+	plan->resultRelations = list_make1_int(parse->resultRelation);
+	plan->onConflictAction = ONCONFLICT_NONE;
+
+	if (fdwroutine->PlanForeignModify != NULL)
+		fdw_private = fdwroutine->PlanForeignModify(root, plan, parse->resultRelation, 0);
+
+	/* The FDW only needs the executor state and the operation */
+	state->fdw_mtstate = makeNode(ModifyTableState);
+	state->fdw_mtstate->ps.state = estate;
+	state->fdw_mtstate->operation = CMD_INSERT;
+
+	if (fdwroutine->BeginForeignModify != NULL)
+		fdwroutine->BeginForeignModify(state->fdw_mtstate, rri, fdw_private, 0, 0);
 }
 
 /*
@@ -255,6 +523,7 @@ chunk_insert_state_create(Chunk *chunk, ChunkDispatch *dispatch)
 													  "chunk insert state memory context",
 													  ALLOCSET_DEFAULT_SIZES);
 	ResultRelInfo *resrelinfo;
+	Dimension  *time_dim = hyperspace_get_open_dimension(dispatch->hypertable->space, 0);
 
 	/* permissions NOT checked here; were checked at hypertable level */
 	if (check_enable_rls(chunk->table_id, InvalidOid, false) == RLS_ENABLED)
@@ -270,9 +539,17 @@ chunk_insert_state_create(Chunk *chunk, ChunkDispatch *dispatch)
 
 	rel = heap_open(chunk->table_id, RowExclusiveLock);
 
-	if (rel->rd_rel->relkind != RELKIND_RELATION)
+	if (rel->rd_rel->relkind != RELKIND_RELATION &&
+		rel->rd_rel->relkind != RELKIND_FOREIGN_TABLE)
 		elog(ERROR, "insert is not on a table");
 
+	/* Foreign chunks have no indexes to arbitrate conflicts with */
+	if (rel->rd_rel->relkind == RELKIND_FOREIGN_TABLE &&
+		dispatch->on_conflict != ONCONFLICT_NONE)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("ON CONFLICT is not supported on hypertables with data nodes")));
+
 	rti = create_chunk_range_table_entry(dispatch, rel);
 
 	MemoryContextSwitchTo(cis_context);
@@ -283,6 +560,27 @@ chunk_insert_state_create(Chunk *chunk, ChunkDispatch *dispatch)
 	state->mctx = cis_context;
 	state->rel = rel;
 	state->result_relation_info = resrelinfo;
+	state->dispatch = dispatch;
+	state->cube = hypercube_copy(chunk->cube);
+	state->chunk_id = chunk->fd.id;
+
+	/*
+	 * A chunk's table is often created in the same transaction that loads
+	 * it, so check per chunk whether writing the FSM and WAL can be skipped.
+	 * This follows the checks PostgreSQL's COPY does on its target table;
+	 * see CopyFrom() for why this is safe. The heap is synced when the state
+	 * is destroyed.
+	 */
+	if (dispatch->bulk_load &&
+		rel->rd_rel->relkind == RELKIND_RELATION &&
+		(rel->rd_createSubid != InvalidSubTransactionId ||
+		 rel->rd_newRelfilenodeSubid != InvalidSubTransactionId))
+	{
+		state->hi_options |= HEAP_INSERT_SKIP_FSM;
+
+		if (!XLogIsNeeded())
+			state->hi_options |= HEAP_INSERT_SKIP_WAL;
+	}
 
 	if (resrelinfo->ri_RelationDesc->rd_rel->relhasindex &&
 		resrelinfo->ri_IndexRelationDescs == NULL)
@@ -296,9 +594,36 @@ chunk_insert_state_create(Chunk *chunk, ChunkDispatch *dispatch)
 			elog(ERROR, "Insert trigger on chunk table not supported");
 	}
 
+	/*
+	 * BEFORE ROW triggers and ON CONFLICT DO UPDATE can write other times
+	 * than the ones the tuples were routed by, so the chunk's time range is
+	 * widened to the whole time slice up front. An unknown range is left
+	 * alone.
+	 */
+	state->time_slice = hypercube_get_slice_by_dimension_id(state->cube, time_dim->fd.id);
+	state->time_slack = Max(time_dim->fd.interval_length / CHUNK_TIME_RANGE_SLACK_FRACTION, 1);
+
+	if (!chunk_time_range_get(chunk->fd.id, &state->min_time, &state->max_time))
+	{
+		state->min_time = DIMENSION_SLICE_MINVALUE;
+		state->max_time = DIMENSION_SLICE_MAXVALUE;
+	}
+	else if (dispatch->on_conflict == ONCONFLICT_UPDATE ||
+			 (resrelinfo->ri_TrigDesc != NULL && resrelinfo->ri_TrigDesc->trig_insert_before_row))
+	{
+		chunk_time_range_widen(chunk->fd.id, state->time_slice->fd.range_start,
+							   state->time_slice->fd.range_end - 1);
+		state->min_time = DIMENSION_SLICE_MINVALUE;
+		state->max_time = DIMENSION_SLICE_MAXVALUE;
+	}
+
+	/* The chunk's bloom filters do not cover the rows about to be written */
+	if (dispatch->hypertable->has_bloom_filters)
+		chunk_bloom_filter_delete_by_chunk_id(chunk->fd.id);
+
 	/* Set the chunk's arbiter indexes for ON CONFLICT statements */
 	if (dispatch->on_conflict != ONCONFLICT_NONE)
-		chunk_insert_state_set_arbiter_indexes(state, dispatch, rel);
+		chunk_insert_state_set_arbiter_indexes(state, dispatch, chunk);
 
 	/* Set tuple conversion map, if tuple needs conversion */
 	parent_rel = heap_open(dispatch->hypertable->main_table_relid, AccessShareLock);
@@ -312,24 +637,97 @@ chunk_insert_state_create(Chunk *chunk, ChunkDispatch *dispatch)
 	if (state->tup_conv_map)
 		state->slot = MakeTupleTableSlot();
 
+#if PG10
+	/* Tuples captured for transition tables are in the hypertable's rowtype */
+	if (state->tup_conv_map && dispatch->transition_capture != NULL)
+		state->transition_map = convert_tuples_by_name(RelationGetDescr(rel),
+													   RelationGetDescr(parent_rel),
+													   gettext_noop("could not convert row type"));
+#endif
+
+	/*
+	 * BEFORE ROW triggers might query the chunk and expect to see previously
+	 * inserted tuples, so only buffer tuples for chunks without them.
+	 * Foreign chunks are written one tuple at a time by the FDW.
+	 */
+	if (dispatch->multi_insert &&
+		resrelinfo->ri_FdwRoutine == NULL &&
+		(resrelinfo->ri_TrigDesc == NULL ||
+		 !resrelinfo->ri_TrigDesc->trig_insert_before_row))
+	{
+		state->buffered_tuples = palloc(sizeof(HeapTuple) * CHUNK_INSERT_STATE_MAX_BUFFERED_TUPLES);
+		state->buffer_slot = MakeSingleTupleTableSlot(RelationGetDescr(rel));
+		state->buffer_mctx = AllocSetContextCreate(cis_context,
+												   "chunk insert state buffer memory context",
+												   ALLOCSET_DEFAULT_SIZES);
+	}
+
 	heap_close(parent_rel, AccessShareLock);
 
+	if (resrelinfo->ri_FdwRoutine != NULL)
+		chunk_insert_state_begin_foreign_modify(state, dispatch);
+
 	MemoryContextSwitchTo(old_mcxt);
 
 	return state;
 }
 
+/*
+ * Widen the chunk's time range in the catalog to include the time of a tuple
+ * that is about to be inserted. The range is widened in place, so it covers
+ * the tuple before anyone, including the current command, can see it.
+ */
+void
+chunk_insert_state_widen_time_range(ChunkInsertState *state, int64 time)
+{
+	int64		range_start = state->time_slice->fd.range_start;
+	int64		range_end = state->time_slice->fd.range_end;
+	bool		empty = state->min_time > state->max_time;
+	int64		min_time = state->min_time;
+	int64		max_time = state->max_time;
+
+	/* The differences are computed unsigned, since they can overflow int64 */
+	if (empty || time < min_time)
+		min_time = (uint64) time - (uint64) range_start > (uint64) state->time_slack ?
+			time - state->time_slack : range_start;
+
+	if (empty || time > max_time)
+		max_time = (uint64) (range_end - 1) - (uint64) time > (uint64) state->time_slack ?
+			time + state->time_slack : range_end - 1;
+
+	chunk_time_range_widen(state->chunk_id, min_time, max_time);
+	state->min_time = min_time;
+	state->max_time = max_time;
+}
+
 extern void
 chunk_insert_state_destroy(ChunkInsertState *state)
 {
 	if (state == NULL)
 		return;
 
+	Assert(state->num_buffered_tuples == 0);
+
+	/*
+	 * If we skipped writing WAL, then we need to sync the heap (but not
+	 * indexes since those use WAL anyway)
+	 */
+	if (state->hi_options & HEAP_INSERT_SKIP_WAL)
+		heap_sync(state->rel);
+
+	if (NULL != state->fdw_mtstate &&
+		state->result_relation_info->ri_FdwRoutine->EndForeignModify != NULL)
+		state->result_relation_info->ri_FdwRoutine->EndForeignModify(state->dispatch->estate,
+																	 state->result_relation_info);
+
 	ExecCloseIndices(state->result_relation_info);
 	heap_close(state->rel, NoLock);
 
 	if (NULL != state->slot)
 		ExecDropSingleTupleTableSlot(state->slot);
 
+	if (NULL != state->buffer_slot)
+		ExecDropSingleTupleTableSlot(state->buffer_slot);
+
 	MemoryContextDelete(state->mctx);
 }
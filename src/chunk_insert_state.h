@@ -4,26 +4,70 @@
 #include <postgres.h>
 #include <funcapi.h>
 #include <access/tupconvert.h>
+#include <nodes/execnodes.h>
 
 #include "hypertable.h"
 #include "chunk.h"
 #include "cache.h"
 #include "chunk_dispatch_state.h"
 
+/*
+ * Maximum number of tuples buffered for multi-insert, across all chunks of an
+ * insert. Same limit as used by PostgreSQL's COPY.
+ */
+#define CHUNK_INSERT_STATE_MAX_BUFFERED_TUPLES 1000
+
+/*
+ * Fraction of the time dimension's interval that a chunk's time range is
+ * widened by beyond the tuple that is outside of it
+ */
+#define CHUNK_TIME_RANGE_SLACK_FRACTION 16
+
+typedef struct ChunkDispatch ChunkDispatch;
+
 typedef struct ChunkInsertState
 {
 	Relation	rel;
 	ResultRelInfo *result_relation_info;
 	List	   *arbiter_indexes;
 	TupleConversionMap *tup_conv_map;
+	TupleConversionMap *transition_map; /* chunk to hypertable rowtype, for
+										 * transition tables */
 	TupleTableSlot *slot;
 	MemoryContext mctx;
-} ChunkInsertState;
+	ChunkDispatch *dispatch;
+	Hypercube  *cube;			/* copy of the chunk's hypercube */
+	int32		chunk_id;
+	bool		build_indexes;	/* chunk was created without its indexes */
+	int			hi_options;		/* options for heap_insert() on the chunk */
+	int64		memory_bytes;	/* memory of the state when created */
+	ModifyTableState *fdw_mtstate;	/* set for foreign chunks on data nodes */
 
-typedef struct ChunkDispatch ChunkDispatch;
+	/*
+	 * The chunk's time range in the catalog, which is widened before tuples
+	 * outside of it are inserted. It is widened by the slack beyond the
+	 * tuple, within the time slice, so that it needs few updates.
+	 */
+	DimensionSlice *time_slice;
+	int64		time_slack;
+	int64		min_time;
+	int64		max_time;
+
+	/*
+	 * Tuples buffered for heap_multi_insert(). Only set up if the dispatch
+	 * allows multi-inserts and the chunk has no BEFORE ROW triggers.
+	 */
+	HeapTuple  *buffered_tuples;
+	int			num_buffered_tuples;
+	Size		buffered_tuples_size;
+	TupleTableSlot *buffer_slot;
+	MemoryContext buffer_mctx;
+} ChunkInsertState;
 
 extern HeapTuple chunk_insert_state_convert_tuple(ChunkInsertState *state, HeapTuple tuple, TupleTableSlot **existing_slot);
 extern ChunkInsertState *chunk_insert_state_create(Chunk *chunk, ChunkDispatch *dispatch);
 extern void chunk_insert_state_destroy(ChunkInsertState *state);
+extern void chunk_insert_state_widen_time_range(ChunkInsertState *state, int64 time);
+extern void chunk_insert_state_cache_invalidate(Oid chunk_relid);
 
 #endif							/* TIMESCALEDB_CHUNK_INSERT_STATE_H */
@@ -0,0 +1,586 @@
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <access/multixact.h>
+#include <access/transam.h>
+#include <access/xact.h>
+#include <catalog/namespace.h>
+#include <catalog/pg_class.h>
+#include <commands/vacuum.h>
+#include <miscadmin.h>
+#include <nodes/makefuncs.h>
+#include <pgstat.h>
+#include <port/atomics.h>
+#include <postmaster/bgworker.h>
+#include <storage/dsm.h>
+#include <storage/ipc.h>
+#include <storage/latch.h>
+#include <storage/lmgr.h>
+#include <utils/lsyscache.h>
+#include <utils/snapmgr.h>
+#include <utils/syscache.h>
+#include <utils/timestamp.h>
+
+#include "bgw_scheduler.h"
+#include "chunk.h"
+#include "chunk_index.h"
+#include "chunk_maintenance.h"
+#include "chunk_time_range.h"
+#include "dimension.h"
+#include "hypercube.h"
+#include "hypertable_cache.h"
+#include "guc.h"
+#include "compat.h"
+
+/*
+ * Chunk-granular VACUUM, ANALYZE and REINDEX of hypertables.
+ *
+ * VACUUM and ANALYZE of a hypertable process each of its chunks in turn. With
+ * timescaledb.vacuum_skip_unchanged_chunks, chunks that have not been
+ * modified since they were last vacuumed or analyzed, according to the
+ * statistics collector, are skipped. This is typically the case for most of
+ * the older chunks of a hypertable.
+ *
+ * REINDEX TABLE of a hypertable normally reindexes all chunks in one
+ * transaction, blocking the whole hypertable until done. With
+ * timescaledb.reindex_transaction_per_chunk, the indexes of each chunk are
+ * instead rebuilt side by side and swapped in, in a transaction per chunk.
+ *
+ * With timescaledb.max_maintenance_workers, the chunks are processed in
+ * parallel by background workers and the backend that runs the command. The
+ * chunks to process are put in a dynamic shared memory segment, from which
+ * each participant takes the next chunk until there are none left. Each chunk
+ * is processed in its own transaction, so parallel processing is only
+ * possible outside a transaction block. Chunks that a worker failed to
+ * process, e.g., because it could not be started or ran into an error, are
+ * processed by the backend once the workers are done, so that any errors are
+ * reported to the user.
+ *
+ * With timescaledb.async_chunk_create_timeout, the same workers also create
+ * the chunks that an INSERT needs, while the insert buffers the tuples for
+ * them and carries on with the other tuples. A worker creates its chunk in a
+ * transaction of its own, so the chunk remains even if the insert is rolled
+ * back, like a chunk created ahead of time.
+ */
+
+typedef enum MaintenanceCommand
+{
+	MAINTENANCE_VACUUM,
+	MAINTENANCE_REINDEX,
+	MAINTENANCE_CREATE_CHUNK,
+} MaintenanceCommand;
+
+typedef struct MaintenanceTask
+{
+	NameData	schema_name;
+	NameData	table_name;
+	bool		done;
+} MaintenanceTask;
+
+typedef struct MaintenanceShared
+{
+	MaintenanceCommand command;
+	int			options;		/* VACOPT_* of a VACUUM statement */
+	int			num_tasks;
+	pg_atomic_uint32 next_task;
+	MaintenanceTask tasks[FLEXIBLE_ARRAY_MEMBER];
+} MaintenanceShared;
+
+#define MAINTENANCE_SHARED_SIZE(num_tasks)								\
+	MAXALIGN(offsetof(MaintenanceShared, tasks) + sizeof(MaintenanceTask) * (num_tasks))
+
+/* The point to create a chunk for, which follows the tasks */
+#define MAINTENANCE_SHARED_POINT(shared)								\
+	((Point *) ((char *) (shared) + MAINTENANCE_SHARED_SIZE((shared)->num_tasks)))
+
+/* A chunk that a worker creates for an insert */
+struct ChunkCreateAsync
+{
+	Hypercube  *cube;			/* the chunk's cube before cutting collisions */
+	dsm_segment *seg;
+	BackgroundWorkerHandle *handle;
+	TimestampTz start_time;
+};
+
+/*
+ * Check whether VACUUM of a relation would scan the whole table to freeze it,
+ * i.e., whether the age of its relfrozenxid or relminmxid exceeds
+ * vacuum_freeze_table_age or vacuum_multixact_freeze_table_age. Such a
+ * VACUUM advances the relation's horizons, so it must not be skipped even if
+ * the relation is unchanged.
+ */
+static bool
+vacuum_needs_freeze(Oid relid)
+{
+	HeapTuple	tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(relid));
+	Form_pg_class form;
+	bool		needs_freeze;
+
+	if (!HeapTupleIsValid(tuple))
+		elog(ERROR, "cache lookup failed for relation %u", relid);
+
+	form = (Form_pg_class) GETSTRUCT(tuple);
+
+	/* Like age() and mxid_age() */
+	needs_freeze =
+		(TransactionIdIsNormal(form->relfrozenxid) &&
+		 (int32) (ReadNewTransactionId() - form->relfrozenxid) > vacuum_freeze_table_age) ||
+		(MultiXactIdIsValid(form->relminmxid) &&
+		 (int32) (ReadNextMultiXactId() - form->relminmxid) > vacuum_multixact_freeze_table_age);
+
+	ReleaseSysCache(tuple);
+
+	return needs_freeze;
+}
+
+/*
+ * Check whether a chunk has no modifications that VACUUM or ANALYZE, as given
+ * by the options, would process. A chunk that has never been vacuumed or
+ * analyzed, or that the statistics collector does not know about, is
+ * considered changed. So is a chunk that VACUUM needs to freeze.
+ */
+bool
+chunk_vacuum_is_unchanged(Oid relid, int options)
+{
+	PgStat_StatTabEntry *tabentry;
+
+	/* Freezing and rewriting do not depend on modifications */
+	if (options & (VACOPT_FULL | VACOPT_FREEZE))
+		return false;
+
+	if ((options & VACOPT_VACUUM) && vacuum_needs_freeze(relid))
+		return false;
+
+	tabentry = pgstat_fetch_stat_tabentry(relid);
+
+	if (NULL == tabentry)
+		return false;
+
+	if ((options & VACOPT_VACUUM) &&
+		(tabentry->n_dead_tuples > 0 ||
+		 (tabentry->vacuum_count == 0 && tabentry->autovac_vacuum_count == 0)))
+		return false;
+
+	if ((options & VACOPT_ANALYZE) &&
+		(tabentry->changes_since_analyze > 0 ||
+		 (tabentry->analyze_count == 0 && tabentry->autovac_analyze_count == 0)))
+		return false;
+
+	return true;
+}
+
+static void
+reindex_task_run(MaintenanceTask *task)
+{
+	Oid			relid;
+
+	relid = get_relname_relid(NameStr(task->table_name),
+							  get_namespace_oid(NameStr(task->schema_name), true));
+
+	/* The chunk was dropped in the meantime */
+	if (OidIsValid(relid))
+		chunk_index_rebuild_all(relid);
+}
+
+/*
+ * Create the chunk for a point of the hypertable that the task names, unless
+ * it exists by now.
+ */
+static void
+create_chunk_task_run(MaintenanceShared *shared, MaintenanceTask *task)
+{
+	Point	   *point = MAINTENANCE_SHARED_POINT(shared);
+	Cache	   *hcache;
+	Hypertable *ht;
+	Oid			relid;
+
+	relid = get_relname_relid(NameStr(task->table_name),
+							  get_namespace_oid(NameStr(task->schema_name), true));
+
+	/* The hypertable was dropped in the meantime */
+	if (!OidIsValid(relid))
+		return;
+
+	LockRelationOid(relid, RowExclusiveLock);
+
+	hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry(hcache, relid);
+
+	if (NULL != ht && ht->space->num_dimensions == point->cardinality)
+	{
+		bool		created;
+		Chunk	   *chunk = hypertable_get_chunk_for_insert(ht, point, false, &created, NULL);
+
+		/* Like a chunk created by the insert itself */
+		if (created)
+			chunk_time_range_insert_empty(chunk->fd.id);
+	}
+
+	cache_release(hcache);
+}
+
+static void
+vacuum_task_run(MaintenanceShared *shared, MaintenanceTask *task)
+{
+	VacuumStmt *stmt = makeNode(VacuumStmt);
+
+	stmt->options = shared->options;
+	stmt->relation = makeRangeVar(NameStr(task->schema_name),
+								  NameStr(task->table_name), -1);
+	ExecVacuum(stmt, true);
+}
+
+/*
+ * Process a chunk in a transaction of its own. Called outside a transaction.
+ */
+static void
+maintenance_task_run(MaintenanceShared *shared, MaintenanceTask *task)
+{
+	StartTransactionCommand();
+	PushActiveSnapshot(GetTransactionSnapshot());
+
+	switch (shared->command)
+	{
+		case MAINTENANCE_VACUUM:
+			vacuum_task_run(shared, task);
+			break;
+		case MAINTENANCE_REINDEX:
+			reindex_task_run(task);
+			break;
+		case MAINTENANCE_CREATE_CHUNK:
+			create_chunk_task_run(shared, task);
+			break;
+	}
+
+	/* VACUUM pops the snapshot when it uses its own transactions */
+	if (ActiveSnapshotSet())
+		PopActiveSnapshot();
+
+	CommitTransactionCommand();
+	task->done = true;
+}
+
+/*
+ * Process the chunks that no other participant has taken yet.
+ */
+static void
+maintenance_tasks_run(MaintenanceShared *shared, bool catch_errors)
+{
+	uint32		i;
+
+	while ((i = pg_atomic_fetch_add_u32(&shared->next_task, 1)) < (uint32) shared->num_tasks)
+	{
+		MaintenanceTask *task = &shared->tasks[i];
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (!catch_errors)
+		{
+			maintenance_task_run(shared, task);
+			continue;
+		}
+
+		PG_TRY();
+		{
+			maintenance_task_run(shared, task);
+		}
+		PG_CATCH();
+		{
+			/* The backend retries the chunk and reports the error */
+			EmitErrorReport();
+			AbortCurrentTransaction();
+			FlushErrorState();
+		}
+		PG_END_TRY();
+	}
+}
+
+static BackgroundWorkerHandle *
+maintenance_worker_start(dsm_segment *seg)
+{
+	BackgroundWorker worker;
+	BackgroundWorkerHandle *handle;
+	BgwMaintenanceWorkerArgs args = {
+		.dboid = MyDatabaseId,
+		.userid = GetUserId(),
+		.dsm_handle = dsm_segment_handle(seg),
+	};
+
+	memset(&worker, 0, sizeof(worker));
+	snprintf(worker.bgw_name, BGW_MAXLEN, "timescaledb maintenance worker for PID %d", MyProcPid);
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS | BGWORKER_BACKEND_DATABASE_CONNECTION;
+	worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+	worker.bgw_restart_time = BGW_NEVER_RESTART;
+	StrNCpy(worker.bgw_library_name, BGW_LIBRARY_NAME, BGW_MAXLEN);
+	StrNCpy(worker.bgw_function_name, BGW_MAINTENANCE_WORKER_MAIN, BGW_MAXLEN);
+	memcpy(worker.bgw_extra, &args, sizeof(args));
+	worker.bgw_notify_pid = MyProcPid;
+
+	if (!RegisterDynamicBackgroundWorker(&worker, &handle))
+		return NULL;
+
+	return handle;
+}
+
+/*
+ * Process the given chunks in transactions of their own, with the help of up
+ * to timescaledb.max_maintenance_workers background workers.
+ *
+ * The current transaction is committed first, and a new one is started at
+ * the end, like VACUUM does.
+ */
+static void
+chunk_maintenance_run(MaintenanceCommand command, int options, List *chunks)
+{
+	int			num_tasks = list_length(chunks);
+	int			num_workers = Min(guc_max_maintenance_workers, num_tasks - 1);
+	Size		size = MAINTENANCE_SHARED_SIZE(num_tasks);
+	BackgroundWorkerHandle **handles = NULL;
+	dsm_segment *seg = NULL;
+	MaintenanceShared *shared;
+	MemoryContext oldcontext = CurrentMemoryContext;
+	ListCell   *lc;
+	int			i = 0;
+
+	if (num_workers > 0)
+	{
+		seg = dsm_create(size, 0);
+
+		/* Keep the segment across the transactions below */
+		dsm_pin_mapping(seg);
+		shared = dsm_segment_address(seg);
+	}
+	else
+		shared = palloc(size);
+
+	shared->command = command;
+	shared->options = options;
+	shared->num_tasks = num_tasks;
+	pg_atomic_init_u32(&shared->next_task, 0);
+
+	foreach(lc, chunks)
+	{
+		Chunk	   *chunk = lfirst(lc);
+		MaintenanceTask *task = &shared->tasks[i++];
+
+		task->schema_name = chunk->fd.schema_name;
+		task->table_name = chunk->fd.table_name;
+		task->done = false;
+	}
+
+	if (num_workers > 0)
+	{
+		handles = palloc0(sizeof(BackgroundWorkerHandle *) * num_workers);
+
+		for (i = 0; i < num_workers; i++)
+			handles[i] = maintenance_worker_start(seg);
+	}
+
+	/* Do not hold back the cleanup of the chunks with our snapshot */
+	if (ActiveSnapshotSet())
+		PopActiveSnapshot();
+
+	CommitTransactionCommand();
+
+	maintenance_tasks_run(shared, false);
+
+	for (i = 0; i < num_workers; i++)
+		if (NULL != handles[i])
+			WaitForBackgroundWorkerShutdown(handles[i]);
+
+	/* Retry chunks that a worker failed to process */
+	for (i = 0; i < num_tasks; i++)
+		if (!shared->tasks[i].done)
+			maintenance_task_run(shared, &shared->tasks[i]);
+
+	if (NULL != seg)
+	{
+		pfree(handles);
+		dsm_detach(seg);
+	}
+	else
+		pfree(shared);
+
+	StartTransactionCommand();
+
+	/* Like VACUUM, this relies on the caller's memory surviving the commits */
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * Vacuum or analyze the given chunks in parallel with background workers.
+ *
+ * Returns false, without processing any chunks, if parallel processing is
+ * off or not possible for the statement, in which case the caller should
+ * process the chunks itself. Otherwise, the chunks are processed in
+ * transactions of their own.
+ */
+bool
+chunk_vacuum_parallel(VacuumStmt *stmt, bool is_toplevel, List *chunks)
+{
+	if (Min(guc_max_maintenance_workers, list_length(chunks) - 1) <= 0 ||
+		NIL != stmt->va_cols)
+		return false;
+
+	/* VACUUM errors out in a transaction block, ANALYZE runs in it */
+	if (stmt->options & VACOPT_VACUUM)
+		PreventTransactionChain(is_toplevel, "VACUUM");
+	else if (IsInTransactionChain(is_toplevel))
+		return false;
+
+	chunk_maintenance_run(MAINTENANCE_VACUUM, stmt->options, chunks);
+
+	return true;
+}
+
+/*
+ * Rebuild the indexes of the given chunks in a transaction per chunk,
+ * possibly in parallel with background workers.
+ *
+ * Returns false, without processing any chunks, if this is not enabled or
+ * not possible in a transaction block, in which case the caller should
+ * reindex the chunks itself.
+ */
+bool
+chunk_reindex_transaction_per_chunk(bool is_toplevel, List *chunks)
+{
+	if (!guc_reindex_transaction_per_chunk || IsInTransactionChain(is_toplevel))
+		return false;
+
+	chunk_maintenance_run(MAINTENANCE_REINDEX, 0, chunks);
+
+	return true;
+}
+
+/*
+ * Have a worker create the chunk for a point of a hypertable.
+ *
+ * Returns NULL if no worker could be started, in which case the caller should
+ * create the chunk itself.
+ */
+ChunkCreateAsync *
+chunk_create_async_start(Hypertable *ht, Point *point)
+{
+	ChunkCreateAsync *create = palloc0(sizeof(ChunkCreateAsync));
+	MaintenanceShared *shared;
+
+	create->seg = dsm_create(MAINTENANCE_SHARED_SIZE(1) + POINT_SIZE(point->cardinality), 0);
+	shared = dsm_segment_address(create->seg);
+	shared->command = MAINTENANCE_CREATE_CHUNK;
+	shared->options = 0;
+	shared->num_tasks = 1;
+	pg_atomic_init_u32(&shared->next_task, 0);
+	shared->tasks[0].schema_name = ht->fd.schema_name;
+	shared->tasks[0].table_name = ht->fd.table_name;
+	shared->tasks[0].done = false;
+	memcpy(MAINTENANCE_SHARED_POINT(shared), point, POINT_SIZE(point->cardinality));
+
+	create->handle = maintenance_worker_start(create->seg);
+
+	if (NULL == create->handle)
+	{
+		dsm_detach(create->seg);
+		pfree(create);
+		return NULL;
+	}
+
+	create->cube = hypercube_calculate_from_point(ht->space, point);
+	create->start_time = GetCurrentTimestamp();
+
+	return create;
+}
+
+/*
+ * Check whether the chunk being created might cover a point. The chunk can
+ * end up smaller than its cube if it collides with other chunks.
+ */
+bool
+chunk_create_async_covers(ChunkCreateAsync *create, Point *point)
+{
+	return hypercube_contains_point(create->cube, point);
+}
+
+/*
+ * Check whether the worker is done, which it also is if it failed. With
+ * "block", wait for the worker until timescaledb.async_chunk_create_timeout
+ * has passed since it was started.
+ */
+bool
+chunk_create_async_wait(ChunkCreateAsync *create, bool block)
+{
+	for (;;)
+	{
+		BgwHandleStatus status;
+		pid_t		pid;
+		long		secs;
+		int			usecs;
+		long		timeout_ms;
+		int			rc;
+
+		status = GetBackgroundWorkerPid(create->handle, &pid);
+
+		if (status == BGWH_STOPPED || status == BGWH_POSTMASTER_DIED)
+			return true;
+
+		if (!block)
+			return false;
+
+		TimestampDifference(GetCurrentTimestamp(),
+							TimestampTzPlusMilliseconds(create->start_time,
+														guc_async_chunk_create_timeout),
+							&secs, &usecs);
+		timeout_ms = secs * 1000 + usecs / 1000;
+
+		if (timeout_ms <= 0)
+			return false;
+
+		/* The postmaster sets our latch when the worker stops */
+		rc = WaitLatchCompat(MyLatch,
+							 WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+							 timeout_ms);
+		ResetLatch(MyLatch);
+
+		if (rc & WL_POSTMASTER_DEATH)
+			proc_exit(1);
+
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
+/*
+ * Stop tracking a chunk creation. A worker that is still running finishes on
+ * its own, while one that has not started yet finds the segment gone and
+ * does nothing.
+ */
+void
+chunk_create_async_end(ChunkCreateAsync *create)
+{
+	dsm_detach(create->seg);
+	pfree(create->handle);
+	pfree(create);
+}
+
+/*
+ * Entry point of a maintenance worker. Called by the loader in a worker that
+ * is connected to the database as the user that runs the command, and not in
+ * a transaction.
+ */
+TS_FUNCTION_INFO_V1(bgw_maintenance_worker_main);
+
+Datum
+bgw_maintenance_worker_main(PG_FUNCTION_ARGS)
+{
+	BgwMaintenanceWorkerArgs args;
+	dsm_segment *seg;
+
+	memcpy(&args, MyBgworkerEntry->bgw_extra, sizeof(args));
+	seg = dsm_attach((dsm_handle) args.dsm_handle);
+
+	/* The backend is already done */
+	if (NULL == seg)
+		PG_RETURN_VOID();
+
+	maintenance_tasks_run(dsm_segment_address(seg), true);
+	dsm_detach(seg);
+
+	PG_RETURN_VOID();
+}
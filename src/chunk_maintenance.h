@@ -0,0 +1,20 @@
+#ifndef TIMESCALEDB_CHUNK_MAINTENANCE_H
+#define TIMESCALEDB_CHUNK_MAINTENANCE_H
+
+#include <postgres.h>
+#include <nodes/parsenodes.h>
+#include <nodes/pg_list.h>
+
+typedef struct Hypertable Hypertable;
+typedef struct Point Point;
+typedef struct ChunkCreateAsync ChunkCreateAsync;
+
+extern bool chunk_vacuum_is_unchanged(Oid relid, int options);
+extern bool chunk_vacuum_parallel(VacuumStmt *stmt, bool is_toplevel, List *chunks);
+extern bool chunk_reindex_transaction_per_chunk(bool is_toplevel, List *chunks);
+extern ChunkCreateAsync *chunk_create_async_start(Hypertable *ht, Point *point);
+extern bool chunk_create_async_covers(ChunkCreateAsync *create, Point *point);
+extern bool chunk_create_async_wait(ChunkCreateAsync *create, bool block);
+extern void chunk_create_async_end(ChunkCreateAsync *create);
+
+#endif							/* TIMESCALEDB_CHUNK_MAINTENANCE_H */
@@ -0,0 +1,206 @@
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <storage/lmgr.h>
+#include <utils/rel.h>
+
+#include "chunk_time_range.h"
+#include "chunk.h"
+#include "dimension_slice.h"
+#include "scanner.h"
+
+/*
+ * The actual range of time of the rows in a chunk, kept in the
+ * chunk_time_range catalog table. Unlike the chunk's time slice, which is
+ * fixed, the range starts out empty when an insert creates the chunk and is
+ * widened before a tuple outside of it is inserted, so that it covers the
+ * tuple before anyone can see it. It is widened by some slack beyond the
+ * tuple, so that an insert of increasing times needs few updates. It is never
+ * narrowed, since deleting rows would require rescanning the chunk, so it is
+ * always a superset of the times of the rows in the chunk.
+ *
+ * The range is widened in place, without a new tuple version. Otherwise,
+ * concurrent inserts into the same chunk would block on each other's update
+ * of the range until commit. In-place updates are not rolled back, but a
+ * range widened by an aborted insert is still a superset. Concurrent
+ * widenings are serialized with a lock on the chunk's range.
+ *
+ * Rows that are written other than by inserting into the hypertable, e.g.,
+ * directly into the chunk, or updates of the time column, make the range
+ * unknown by widening it to all of time. Chunks created before ranges were
+ * kept, or by other means than an insert, have no range at all, which also
+ * means it is unknown.
+ *
+ * The range cannot exclude chunks at plan time, since plans can be reused
+ * after the range has been widened. It is used by ConstraintAwareAppend when
+ * the executor starts.
+ */
+
+static int
+chunk_time_range_scan(int32 chunk_id, tuple_found_func tuple_found, void *data,
+					  LOCKMODE lockmode)
+{
+	Catalog    *catalog = catalog_get();
+	ScanKeyData scankey[1];
+	ScannerCtx	scanctx = {
+		.table = catalog_table_get_id(catalog, CHUNK_TIME_RANGE),
+		.index = CATALOG_INDEX(catalog, CHUNK_TIME_RANGE, CHUNK_TIME_RANGE_PKEY_IDX),
+		.nkeys = 1,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.limit = 1,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+	};
+
+	ScanKeyInit(&scankey[0], Anum_chunk_time_range_pkey_idx_chunk_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(chunk_id));
+
+	return scanner_scan(&scanctx);
+}
+
+/*
+ * Start keeping the range of a new chunk, which has no rows yet.
+ */
+void
+chunk_time_range_insert_empty(int32 chunk_id)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	Datum		values[Natts_chunk_time_range];
+	bool		nulls[Natts_chunk_time_range] = {false};
+	CatalogSecurityContext sec_ctx;
+
+	values[Anum_chunk_time_range_chunk_id - 1] = Int32GetDatum(chunk_id);
+	values[Anum_chunk_time_range_min_value - 1] = Int64GetDatum(DIMENSION_SLICE_MAXVALUE);
+	values[Anum_chunk_time_range_max_value - 1] = Int64GetDatum(DIMENSION_SLICE_MINVALUE);
+
+	rel = heap_open(catalog_table_get_id(catalog, CHUNK_TIME_RANGE), RowExclusiveLock);
+
+	catalog_become_owner(catalog, &sec_ctx);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+
+	heap_close(rel, RowExclusiveLock);
+}
+
+static bool
+chunk_time_range_tuple_found(TupleInfo *ti, void *data)
+{
+	FormData_chunk_time_range *form = data;
+
+	memcpy(form, GETSTRUCT(ti->tuple), sizeof(FormData_chunk_time_range));
+
+	return false;
+}
+
+/*
+ * Get the range of time of a chunk's rows. Returns false if the range is not
+ * known. An empty chunk has a range with min_value > max_value.
+ */
+bool
+chunk_time_range_get(int32 chunk_id, int64 *min_value, int64 *max_value)
+{
+	FormData_chunk_time_range form;
+
+	if (chunk_time_range_scan(chunk_id, chunk_time_range_tuple_found, &form,
+							  AccessShareLock) == 0)
+		return false;
+
+	if (form.min_value == DIMENSION_SLICE_MINVALUE &&
+		form.max_value == DIMENSION_SLICE_MAXVALUE)
+		return false;
+
+	*min_value = form.min_value;
+	*max_value = form.max_value;
+
+	return true;
+}
+
+static bool
+chunk_time_range_tuple_widen(TupleInfo *ti, void *data)
+{
+	FormData_chunk_time_range *widen = data;
+	Form_chunk_time_range form = (Form_chunk_time_range) GETSTRUCT(ti->tuple);
+	HeapTuple	new_tuple;
+	Form_chunk_time_range new_form;
+
+	if (form->min_value <= widen->min_value && form->max_value >= widen->max_value)
+		return false;
+
+	new_tuple = heap_copytuple(ti->tuple);
+	new_form = (Form_chunk_time_range) GETSTRUCT(new_tuple);
+	new_form->min_value = Min(form->min_value, widen->min_value);
+	new_form->max_value = Max(form->max_value, widen->max_value);
+
+	heap_inplace_update(ti->scanrel, new_tuple);
+	heap_freetuple(new_tuple);
+
+	return false;
+}
+
+/*
+ * Widen the range of a chunk to include the given range. Does nothing if the
+ * chunk has no range.
+ */
+void
+chunk_time_range_widen(int32 chunk_id, int64 min_value, int64 max_value)
+{
+	Oid			catalog_relid = catalog_table_get_id(catalog_get(), CHUNK_TIME_RANGE);
+	FormData_chunk_time_range widen = {
+		.chunk_id = chunk_id,
+		.min_value = min_value,
+		.max_value = max_value,
+	};
+
+	Assert(min_value <= max_value);
+
+	/*
+	 * The tuple is read and written under the lock, so that no concurrent
+	 * widening is lost. The lock is held only for the update, since in-place
+	 * updates are not transactional anyway.
+	 */
+	LockDatabaseObject(catalog_relid, chunk_id, 0, ExclusiveLock);
+	chunk_time_range_scan(chunk_id, chunk_time_range_tuple_widen, &widen, RowExclusiveLock);
+	UnlockDatabaseObject(catalog_relid, chunk_id, 0, ExclusiveLock);
+}
+
+/*
+ * Make the range of a chunk unknown, e.g., because rows were written
+ * directly into the chunk.
+ */
+void
+chunk_time_range_invalidate(int32 chunk_id)
+{
+	chunk_time_range_widen(chunk_id, DIMENSION_SLICE_MINVALUE, DIMENSION_SLICE_MAXVALUE);
+}
+
+void
+chunk_time_range_invalidate_by_hypertable_id(int32 hypertable_id)
+{
+	List	   *chunks = chunk_get_all_by_hypertable_id(hypertable_id, 0);
+	ListCell   *lc;
+
+	foreach(lc, chunks)
+		chunk_time_range_invalidate(((Chunk *) lfirst(lc))->fd.id);
+}
+
+static bool
+chunk_time_range_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete_only(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return false;
+}
+
+int
+chunk_time_range_delete_by_chunk_id(int32 chunk_id)
+{
+	return chunk_time_range_scan(chunk_id, chunk_time_range_tuple_delete, NULL,
+								 RowExclusiveLock);
+}
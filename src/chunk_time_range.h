@@ -0,0 +1,15 @@
+#ifndef TIMESCALEDB_CHUNK_TIME_RANGE_H
+#define TIMESCALEDB_CHUNK_TIME_RANGE_H
+
+#include <postgres.h>
+
+#include "catalog.h"
+
+extern void chunk_time_range_insert_empty(int32 chunk_id);
+extern bool chunk_time_range_get(int32 chunk_id, int64 *min_value, int64 *max_value);
+extern void chunk_time_range_widen(int32 chunk_id, int64 min_value, int64 max_value);
+extern void chunk_time_range_invalidate(int32 chunk_id);
+extern void chunk_time_range_invalidate_by_hypertable_id(int32 hypertable_id);
+extern int	chunk_time_range_delete_by_chunk_id(int32 chunk_id);
+
+#endif							/* TIMESCALEDB_CHUNK_TIME_RANGE_H */
@@ -6,10 +6,10 @@
 
 #if PG10
 
-#define ExecARInsertTriggersCompat(estate, result_rel_info, tuple, recheck_indexes) \
-	ExecARInsertTriggers(estate, result_rel_info, tuple, recheck_indexes, NULL)
-#define ExecASInsertTriggersCompat(estate, result_rel_info) \
-	ExecASInsertTriggers(estate, result_rel_info, NULL)
+#define ExecARInsertTriggersCompat(estate, result_rel_info, tuple, recheck_indexes, transition_capture) \
+	ExecARInsertTriggers(estate, result_rel_info, tuple, recheck_indexes, transition_capture)
+#define ExecASInsertTriggersCompat(estate, result_rel_info, transition_capture) \
+	ExecASInsertTriggers(estate, result_rel_info, transition_capture)
 #define InitResultRelInfoCompat(result_rel_info, result_rel_desc, result_rel_index, instrument_options) \
 	InitResultRelInfo(result_rel_info, result_rel_desc, result_rel_index, NULL, instrument_options)
 #define CheckValidResultRelCompat(relinfo, operation)	\
@@ -18,12 +18,33 @@
 	ParseFuncOrColumn(pstate, funcname, fargs, (pstate)->p_last_srf, fn, location)
 #define make_op_compat(pstate, opname, ltree, rtree, location)	\
 	make_op(pstate, opname, ltree, rtree, (pstate)->p_last_srf, location)
+#define MemoryContextCountCompat(context, totals) \
+	(context)->methods->stats(context, NULL, NULL, totals)
+#define create_append_path_compat(rel, subpaths, required_outer, parallel_workers) \
+	create_append_path(rel, subpaths, required_outer, parallel_workers, NIL)
+#define create_merge_append_path_compat(root, rel, subpaths, pathkeys, required_outer) \
+	create_merge_append_path(root, rel, subpaths, pathkeys, required_outer, NIL)
+#define get_cheapest_path_for_pathkeys_compat(paths, pathkeys, required_outer, cost_criterion) \
+	get_cheapest_path_for_pathkeys(paths, pathkeys, required_outer, cost_criterion, false)
+#define WaitLatchCompat(latch, wakeEvents, timeout) \
+	WaitLatch(latch, wakeEvents, timeout, PG_WAIT_EXTENSION)
+#define tuplesort_getheaptuple_compat(state, forward, should_free) \
+	(*(should_free) = false, tuplesort_getheaptuple(state, forward))
+#define tuplesort_gettupleslot_compat(state, forward, slot) \
+	tuplesort_gettupleslot(state, forward, true, slot, NULL)
+#define GetIndexAmRoutineByAmIdCompat(amoid) \
+	GetIndexAmRoutineByAmId(amoid, false)
+#define makeDefElemCompat(name, arg) \
+	makeDefElem(name, arg, -1)
+#define ExecEvalExprCompat(state, econtext, isnull) \
+	ExecEvalExpr(state, econtext, isnull)
 
 #elif PG96
 
-#define ExecARInsertTriggersCompat(estate, result_rel_info, tuple, recheck_indexes) \
+/* PG96 has no transition tables, so the capture state is ignored */
+#define ExecARInsertTriggersCompat(estate, result_rel_info, tuple, recheck_indexes, transition_capture) \
 	ExecARInsertTriggers(estate, result_rel_info, tuple, recheck_indexes)
-#define ExecASInsertTriggersCompat(estate, result_rel_info) \
+#define ExecASInsertTriggersCompat(estate, result_rel_info, transition_capture) \
 	ExecASInsertTriggers(estate, result_rel_info)
 #define InitResultRelInfoCompat(result_rel_info, result_rel_desc, result_rel_index, instrument_options) \
 	InitResultRelInfo(result_rel_info, result_rel_desc, result_rel_index, instrument_options)
@@ -33,6 +54,48 @@
 	ParseFuncOrColumn(pstate, funcname, fargs, fn, location)
 #define make_op_compat(pstate, opname, ltree, rtree, location)	\
 	make_op(pstate, opname, ltree, rtree, location)
+#define MemoryContextCountCompat(context, totals) \
+	(context)->methods->stats(context, 0, false, totals)
+#define create_append_path_compat(rel, subpaths, required_outer, parallel_workers) \
+	create_append_path(rel, subpaths, required_outer, parallel_workers)
+#define create_merge_append_path_compat(root, rel, subpaths, pathkeys, required_outer) \
+	create_merge_append_path(root, rel, subpaths, pathkeys, required_outer)
+#define get_cheapest_path_for_pathkeys_compat(paths, pathkeys, required_outer, cost_criterion) \
+	get_cheapest_path_for_pathkeys(paths, pathkeys, required_outer, cost_criterion)
+#define WaitLatchCompat(latch, wakeEvents, timeout) \
+	WaitLatch(latch, wakeEvents, timeout)
+#define tuplesort_getheaptuple_compat(state, forward, should_free) \
+	tuplesort_getheaptuple(state, forward, should_free)
+#define tuplesort_gettupleslot_compat(state, forward, slot) \
+	tuplesort_gettupleslot(state, forward, slot, NULL)
+#define GetIndexAmRoutineByAmIdCompat(amoid) \
+	GetIndexAmRoutineByAmId(amoid)
+#define makeDefElemCompat(name, arg) \
+	makeDefElem(name, arg)
+#define ExecEvalExprCompat(state, econtext, isnull) \
+	ExecEvalExpr(state, econtext, isnull, NULL)
+
+/* Catalog tuple functions that PG10 has. Requires catalog/indexing.h */
+#define CatalogTupleInsert(relation, tuple)		\
+	do {										\
+		simple_heap_insert(relation, tuple);	\
+		CatalogUpdateIndexes(relation, tuple);	\
+	} while (0);
+
+#define CatalogTupleUpdate(relation, tid, tuple)	\
+	do {											\
+		simple_heap_update(relation, tid, tuple);	\
+		CatalogUpdateIndexes(relation, tuple);		\
+	} while (0);
+
+#define CatalogTupleDelete(relation, tid)		\
+	simple_heap_delete(relation, tid);
+
+#define CatalogTupleInsertWithInfo(relation, tuple, indstate)	\
+	do {												\
+		simple_heap_insert(relation, tuple);			\
+		CatalogIndexInsert(indstate, tuple);			\
+	} while (0);
 
 #else
 
@@ -0,0 +1,936 @@
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <access/multixact.h>
+#include <access/sysattr.h>
+#include <access/tuptoaster.h>
+#include <access/xact.h>
+#include <catalog/dependency.h>
+#include <catalog/heap.h>
+#include <catalog/index.h>
+#include <catalog/namespace.h>
+#include <catalog/pg_type.h>
+#include <catalog/toasting.h>
+#include <commands/tablecmds.h>
+#include <commands/tablespace.h>
+#include <executor/executor.h>
+#include <miscadmin.h>
+#include <nodes/makefuncs.h>
+#include <parser/parse_oper.h>
+#include <pgstat.h>
+#include <storage/lmgr.h>
+#include <storage/predicate.h>
+#include <utils/builtins.h>
+#include <utils/datum.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/rel.h>
+#include <utils/relcache.h>
+#include <utils/snapmgr.h>
+#include <utils/tuplesort.h>
+
+#include "catalog.h"
+#include "chunk.h"
+#include "compress_chunk.h"
+#include "compression.h"
+#include "dimension.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "scanner.h"
+#include "compat.h"
+
+/*
+ * Compressed chunks.
+ *
+ * Compressing a chunk moves its rows into a compressed table in the internal
+ * schema. The compressed table has a row for each batch of up to
+ * COMPRESSION_MAX_BATCH_ROWS rows of the chunk, in time order, and a column
+ * for each column of the chunk that holds the batch's values of the column,
+ * compressed by compression_compress(). If the chunk is compressed with a
+ * 'segment_by' column, the rows of a batch have the same value of that
+ * column, which is stored as is instead. A column with the number of rows
+ * completes a batch.
+ *
+ * The chunk table is left empty, but keeps its constraints, so chunk
+ * exclusion works as before. Queries on the hypertable scan compressed
+ * chunks with a DecompressChunk node (see decompress_scan.c), which also
+ * returns the rows that were inserted into the chunk after it was compressed.
+ *
+ * Rows are compressed and decompressed while the chunk is locked against
+ * writes, but not reads. The lock is upgraded to an ACCESS EXCLUSIVE lock
+ * only to empty the chunk, or to drop the compressed table, at the end.
+ */
+
+static int
+compressed_chunk_scan(int indexid, ScanKeyData *scankey, tuple_found_func tuple_found,
+					  void *data, int limit, LOCKMODE lockmode)
+{
+	Catalog    *catalog = catalog_get();
+	ScannerCtx	scanctx = {
+		.table = catalog_table_get_id(catalog, COMPRESSED_CHUNK),
+		.index = CATALOG_INDEX(catalog, COMPRESSED_CHUNK, indexid),
+		.nkeys = 1,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.limit = limit,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+	};
+
+	return scanner_scan(&scanctx);
+}
+
+static bool
+compressed_chunk_tuple_found(TupleInfo *ti, void *data)
+{
+	CompressedChunk **cc = data;
+	bool		isnull;
+	Datum		segment_by = heap_getattr(ti->tuple, Anum_compressed_chunk_segment_by, ti->desc, &isnull);
+	Oid			namespace_oid;
+
+	*cc = palloc0(sizeof(CompressedChunk));
+	memcpy(&(*cc)->fd, GETSTRUCT(ti->tuple), sizeof(FormData_compressed_chunk));
+	(*cc)->has_segment_by = !isnull;
+
+	if (!isnull)
+		namecpy(&(*cc)->segment_by, DatumGetName(segment_by));
+
+	namespace_oid = get_namespace_oid(NameStr((*cc)->fd.schema_name), true);
+
+	if (OidIsValid(namespace_oid))
+		(*cc)->compressed_relid = get_relname_relid(NameStr((*cc)->fd.table_name), namespace_oid);
+
+	return false;
+}
+
+CompressedChunk *
+compressed_chunk_get_by_chunk_id(int32 chunk_id)
+{
+	CompressedChunk *cc = NULL;
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_compressed_chunk_pkey_idx_chunk_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(chunk_id));
+
+	compressed_chunk_scan(COMPRESSED_CHUNK_PKEY_IDX, scankey,
+						  compressed_chunk_tuple_found, &cc, 1, AccessShareLock);
+
+	return cc;
+}
+
+/*
+ * Get the compressed chunk of a chunk table, or NULL if the table is not a
+ * compressed chunk.
+ */
+CompressedChunk *
+compressed_chunk_get_by_relid(Oid chunk_relid)
+{
+	Chunk	   *chunk = chunk_get_by_relid(chunk_relid, 0, false);
+
+	if (NULL == chunk)
+		return NULL;
+
+	return compressed_chunk_get_by_chunk_id(chunk->fd.id);
+}
+
+bool
+compressed_chunk_exists_for_hypertable(int32 hypertable_id)
+{
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_compressed_chunk_hypertable_id_idx_hypertable_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(hypertable_id));
+
+	return compressed_chunk_scan(COMPRESSED_CHUNK_HYPERTABLE_ID_IDX, scankey,
+								 NULL, NULL, 1, AccessShareLock) > 0;
+}
+
+static bool
+compressed_chunk_tuple_delete(TupleInfo *ti, void *data)
+{
+	bool	   *invalidate_cache = data;
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+
+	if (*invalidate_cache)
+		catalog_delete(ti->scanrel, ti->tuple);
+	else
+		catalog_delete_only(ti->scanrel, ti->tuple);
+
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+/*
+ * Delete the catalog row of a compressed chunk. The compressed table is
+ * dropped with the chunk table, which it depends on.
+ */
+int
+compressed_chunk_delete_by_chunk_id(int32 chunk_id, bool invalidate_cache)
+{
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_compressed_chunk_pkey_idx_chunk_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(chunk_id));
+
+	return compressed_chunk_scan(COMPRESSED_CHUNK_PKEY_IDX, scankey,
+								 compressed_chunk_tuple_delete, &invalidate_cache,
+								 0, RowExclusiveLock);
+}
+
+static void
+compressed_chunk_insert(Chunk *chunk, Relation compressed_rel, int64 num_rows, Name segment_by)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	Datum		values[Natts_compressed_chunk];
+	bool		nulls[Natts_compressed_chunk] = {false};
+	NameData	schema_name,
+				table_name;
+	CatalogSecurityContext sec_ctx;
+
+	namestrcpy(&schema_name, get_namespace_name(RelationGetNamespace(compressed_rel)));
+	namestrcpy(&table_name, RelationGetRelationName(compressed_rel));
+
+	values[Anum_compressed_chunk_chunk_id - 1] = Int32GetDatum(chunk->fd.id);
+	values[Anum_compressed_chunk_hypertable_id - 1] = Int32GetDatum(chunk->fd.hypertable_id);
+	values[Anum_compressed_chunk_schema_name - 1] = NameGetDatum(&schema_name);
+	values[Anum_compressed_chunk_table_name - 1] = NameGetDatum(&table_name);
+	values[Anum_compressed_chunk_num_rows - 1] = Int64GetDatum(num_rows);
+
+	if (NULL != segment_by)
+		values[Anum_compressed_chunk_segment_by - 1] = NameGetDatum(segment_by);
+	else
+		nulls[Anum_compressed_chunk_segment_by - 1] = true;
+
+	rel = heap_open(catalog_table_get_id(catalog, COMPRESSED_CHUNK), RowExclusiveLock);
+
+	catalog_become_owner(catalog, &sec_ctx);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+
+	heap_close(rel, RowExclusiveLock);
+}
+
+/*
+ * Set up reading the batches of a compressed table. The attnos are those of
+ * the chunk columns to decompress, offset by FirstLowInvalidHeapAttributeNumber
+ * as by pull_varattnos(). A whole-row reference decompresses all columns.
+ */
+CompressedBatch *
+compressed_batch_create(Relation chunk_rel, Relation compressed_rel, Bitmapset *attnos)
+{
+	CompressedBatch *batch = palloc0(sizeof(CompressedBatch));
+	TupleDesc	desc = RelationGetDescr(chunk_rel);
+	bool		all_columns = bms_is_member(0 - FirstLowInvalidHeapAttributeNumber, attnos);
+	Oid			compressed_relid = RelationGetRelid(compressed_rel);
+	int			i;
+
+	batch->chunk_desc = desc;
+	batch->compressed_desc = RelationGetDescr(compressed_rel);
+	batch->compressed_attnos = palloc0(desc->natts * sizeof(AttrNumber));
+	batch->is_segment_by = palloc0(desc->natts * sizeof(bool));
+	batch->values = palloc0(desc->natts * sizeof(Datum *));
+	batch->nulls = palloc0(desc->natts * sizeof(bool *));
+	batch->compressed_values = palloc(batch->compressed_desc->natts * sizeof(Datum));
+	batch->compressed_nulls = palloc(batch->compressed_desc->natts * sizeof(bool));
+	batch->count_attno = get_attnum(compressed_relid, COMPRESSION_COUNT_COLUMN);
+	batch->mcxt = AllocSetContextCreate(CurrentMemoryContext,
+										"Compressed batch",
+										ALLOCSET_DEFAULT_SIZES);
+
+	if (batch->count_attno == InvalidAttrNumber)
+		elog(ERROR, "compressed table \"%s\" has no row counts",
+			 RelationGetRelationName(compressed_rel));
+
+	for (i = 0; i < desc->natts; i++)
+	{
+		Form_pg_attribute attr = desc->attrs[i];
+		Form_pg_attribute compressed_attr;
+		AttrNumber	attno;
+
+		if (attr->attisdropped ||
+			!(all_columns || bms_is_member(attr->attnum - FirstLowInvalidHeapAttributeNumber, attnos)))
+			continue;
+
+		attno = get_attnum(compressed_relid, NameStr(attr->attname));
+
+		if (attno == InvalidAttrNumber)
+			elog(ERROR, "compressed table \"%s\" has no column \"%s\"",
+				 RelationGetRelationName(compressed_rel), NameStr(attr->attname));
+
+		/*
+		 * Columns of compressed data are bytea columns stored externally, and
+		 * the segment_by column is stored as in the chunk
+		 */
+		compressed_attr = batch->compressed_desc->attrs[AttrNumberGetAttrOffset(attno)];
+		batch->compressed_attnos[i] = attno;
+		batch->is_segment_by[i] = !(compressed_attr->atttypid == BYTEAOID &&
+									compressed_attr->attstorage == 'e');
+	}
+
+	return batch;
+}
+
+/*
+ * Decompress the batch in a row of the compressed table. The values are
+ * valid until the next batch is loaded.
+ */
+void
+compressed_batch_load(CompressedBatch *batch, HeapTuple compressed_tuple)
+{
+	TupleDesc	desc = batch->chunk_desc;
+	MemoryContext old;
+	int			i;
+
+	MemoryContextReset(batch->mcxt);
+	old = MemoryContextSwitchTo(batch->mcxt);
+
+	heap_deform_tuple(compressed_tuple, batch->compressed_desc,
+					  batch->compressed_values, batch->compressed_nulls);
+
+	if (batch->compressed_nulls[AttrNumberGetAttrOffset(batch->count_attno)])
+		elog(ERROR, "compressed batch has no row count");
+
+	batch->num_rows = DatumGetInt32(batch->compressed_values[AttrNumberGetAttrOffset(batch->count_attno)]);
+	batch->next_row = 0;
+
+	for (i = 0; i < desc->natts; i++)
+	{
+		Form_pg_attribute attr = desc->attrs[i];
+		int			offset;
+		bool		isnull;
+		Datum		value;
+
+		if (batch->compressed_attnos[i] == InvalidAttrNumber)
+			continue;
+
+		offset = AttrNumberGetAttrOffset(batch->compressed_attnos[i]);
+		isnull = batch->compressed_nulls[offset];
+		value = batch->compressed_values[offset];
+
+		batch->values[i] = palloc(batch->num_rows * sizeof(Datum));
+		batch->nulls[i] = palloc(batch->num_rows * sizeof(bool));
+
+		if (batch->is_segment_by[i])
+		{
+			int			j;
+
+			/* The value is in the compressed tuple, so it needs a copy */
+			if (!isnull)
+				value = datumCopy(value, attr->attbyval, attr->attlen);
+
+			for (j = 0; j < batch->num_rows; j++)
+			{
+				batch->values[i][j] = value;
+				batch->nulls[i][j] = isnull;
+			}
+		}
+		else if (isnull)
+			elog(ERROR, "compressed batch has no data for column \"%s\"", NameStr(attr->attname));
+		else
+			compression_decompress((bytea *) PG_DETOAST_DATUM(value), attr->atttypid,
+								   batch->values[i], batch->nulls[i], batch->num_rows);
+	}
+
+	MemoryContextSwitchTo(old);
+}
+
+/*
+ * Get the next row of the current batch. Returns false if there are no more
+ * rows in the batch.
+ */
+bool
+compressed_batch_next(CompressedBatch *batch, Datum *values, bool *nulls)
+{
+	int			row = batch->next_row;
+	int			i;
+
+	if (row >= batch->num_rows)
+		return false;
+
+	for (i = 0; i < batch->chunk_desc->natts; i++)
+	{
+		if (batch->compressed_attnos[i] == InvalidAttrNumber)
+		{
+			values[i] = (Datum) 0;
+			nulls[i] = true;
+		}
+		else
+		{
+			values[i] = batch->values[i][row];
+			nulls[i] = batch->nulls[i][row];
+		}
+	}
+
+	batch->next_row++;
+
+	return true;
+}
+
+static ColumnDef *
+compressed_column_def(const char *name, Oid typid, int32 typmod, Oid collid, char storage)
+{
+	ColumnDef  *col = makeNode(ColumnDef);
+
+	col->colname = pstrdup(name);
+	col->typeName = makeTypeNameFromOid(typid, typmod);
+	col->is_local = true;
+	col->storage = storage;
+	col->collOid = collid;
+	col->location = -1;
+
+	return col;
+}
+
+/*
+ * Create the compressed table of a chunk, in the chunk's tablespace and with
+ * the chunk's owner. The table depends on the chunk, so that it is dropped
+ * with the chunk.
+ *
+ * The columns of compressed data are already compressed, so they are stored
+ * out of line, but not compressed again, when they do not fit into a page.
+ */
+static Oid
+compressed_table_create(Chunk *chunk, Relation chunk_rel, AttrNumber segment_by_attno)
+{
+	TupleDesc	desc = RelationGetDescr(chunk_rel);
+	char		name[NAMEDATALEN];
+	CreateStmt *stmt = makeNode(CreateStmt);
+	ObjectAddress tableobj;
+	ObjectAddress chunkobj = {
+		.classId = RelationRelationId,
+		.objectId = RelationGetRelid(chunk_rel),
+	};
+	CatalogSecurityContext sec_ctx;
+	int			i;
+
+	snprintf(name, NAMEDATALEN, "_compressed_chunk_%d", chunk->fd.id);
+	stmt->relation = makeRangeVar(INTERNAL_SCHEMA_NAME, pstrdup(name), -1);
+	stmt->oncommit = ONCOMMIT_NOOP;
+
+	if (OidIsValid(chunk_rel->rd_rel->reltablespace))
+		stmt->tablespacename = get_tablespace_name(chunk_rel->rd_rel->reltablespace);
+
+	for (i = 0; i < desc->natts; i++)
+	{
+		Form_pg_attribute attr = desc->attrs[i];
+		ColumnDef  *col;
+
+		if (attr->attisdropped)
+			continue;
+
+		if (attr->attnum == segment_by_attno)
+			col = compressed_column_def(NameStr(attr->attname), attr->atttypid,
+										attr->atttypmod, attr->attcollation, 0);
+		else
+			col = compressed_column_def(NameStr(attr->attname), BYTEAOID, -1,
+										InvalidOid, 'e');
+
+		stmt->tableElts = lappend(stmt->tableElts, col);
+	}
+
+	stmt->tableElts = lappend(stmt->tableElts,
+							  compressed_column_def(COMPRESSION_COUNT_COLUMN, INT4OID, -1,
+													InvalidOid, 0));
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+
+	tableobj = DefineRelation(stmt,
+							  RELKIND_RELATION,
+							  chunk_rel->rd_rel->relowner,
+							  NULL
+#if PG10
+							  ,NULL
+#endif
+		);
+
+	CommandCounterIncrement();
+	NewRelationCreateToastTable(tableobj.objectId, (Datum) 0);
+
+	catalog_restore_user(&sec_ctx);
+
+	recordDependencyOn(&tableobj, &chunkobj, DEPENDENCY_INTERNAL);
+	CommandCounterIncrement();
+
+	return tableobj.objectId;
+}
+
+/*
+ * Accumulates the rows of a batch until it is full or the segment changes.
+ */
+typedef struct CompressBatchState
+{
+	TupleDesc	chunk_desc;
+	TupleDesc	compressed_desc;
+	AttrNumber *compressed_attnos;
+	AttrNumber	segment_by_attno;
+	AttrNumber	count_attno;
+	int			num_rows;
+	Datum	  **values;
+	bool	  **nulls;
+	MemoryContext mcxt;
+} CompressBatchState;
+
+static bool
+batch_is_new_segment(CompressBatchState *state, Datum *values, bool *nulls)
+{
+	int			offset;
+	Form_pg_attribute attr;
+
+	if (state->segment_by_attno == InvalidAttrNumber)
+		return false;
+
+	offset = AttrNumberGetAttrOffset(state->segment_by_attno);
+	attr = state->chunk_desc->attrs[offset];
+
+	if (nulls[offset] || state->nulls[offset][0])
+		return nulls[offset] != state->nulls[offset][0];
+
+	return !datumIsEqual(values[offset], state->values[offset][0], attr->attbyval, attr->attlen);
+}
+
+static void
+batch_flush(CompressBatchState *state, Relation compressed_rel, BulkInsertState bistate)
+{
+	TupleDesc	desc = state->chunk_desc;
+	Datum	   *values;
+	bool	   *nulls;
+	MemoryContext old;
+	HeapTuple	tuple;
+	int			i;
+
+	if (state->num_rows == 0)
+		return;
+
+	old = MemoryContextSwitchTo(state->mcxt);
+	values = palloc0(state->compressed_desc->natts * sizeof(Datum));
+	nulls = palloc0(state->compressed_desc->natts * sizeof(bool));
+
+	for (i = 0; i < desc->natts; i++)
+	{
+		Form_pg_attribute attr = desc->attrs[i];
+		int			offset;
+
+		if (attr->attisdropped)
+			continue;
+
+		offset = AttrNumberGetAttrOffset(state->compressed_attnos[i]);
+
+		if (attr->attnum == state->segment_by_attno)
+		{
+			values[offset] = state->values[i][0];
+			nulls[offset] = state->nulls[i][0];
+		}
+		else
+			values[offset] = PointerGetDatum(compression_compress(attr->atttypid,
+																  state->values[i],
+																  state->nulls[i],
+																  state->num_rows));
+	}
+
+	values[AttrNumberGetAttrOffset(state->count_attno)] = Int32GetDatum(state->num_rows);
+
+	tuple = heap_form_tuple(state->compressed_desc, values, nulls);
+	heap_insert(compressed_rel, tuple, GetCurrentCommandId(true), 0, bistate);
+
+	MemoryContextSwitchTo(old);
+	MemoryContextReset(state->mcxt);
+	state->num_rows = 0;
+}
+
+static void
+batch_add_row(CompressBatchState *state, Datum *values, bool *nulls)
+{
+	TupleDesc	desc = state->chunk_desc;
+	MemoryContext old = MemoryContextSwitchTo(state->mcxt);
+	int			i;
+
+	for (i = 0; i < desc->natts; i++)
+	{
+		Form_pg_attribute attr = desc->attrs[i];
+
+		if (attr->attisdropped)
+			continue;
+
+		state->nulls[i][state->num_rows] = nulls[i];
+		state->values[i][state->num_rows] =
+			nulls[i] ? (Datum) 0 : datumCopy(values[i], attr->attbyval, attr->attlen);
+	}
+
+	state->num_rows++;
+	MemoryContextSwitchTo(old);
+}
+
+static void
+sort_key_init(TupleDesc desc, AttrNumber attno, AttrNumber *sort_attno, Oid *sort_op,
+			  Oid *collation, bool *nulls_first)
+{
+	Form_pg_attribute attr = desc->attrs[AttrNumberGetAttrOffset(attno)];
+
+	get_sort_group_operators(attr->atttypid, true, false, false, sort_op, NULL, NULL, NULL);
+	*sort_attno = attno;
+	*collation = attr->attcollation;
+	*nulls_first = false;
+}
+
+/*
+ * Compress the rows of the chunk into batches of the compressed table, in
+ * order of the segment_by column, if any, and time. Returns the number of
+ * rows.
+ *
+ * The rows are read with a new snapshot, taken after the chunk was locked
+ * against writes, so that no committed rows are missed.
+ */
+static int64
+compress_rows(Relation chunk_rel, Relation compressed_rel, AttrNumber time_attno,
+			  AttrNumber segment_by_attno)
+{
+	TupleDesc	desc = RelationGetDescr(chunk_rel);
+	Oid			compressed_relid = RelationGetRelid(compressed_rel);
+	CompressBatchState state = {
+		.chunk_desc = desc,
+		.compressed_desc = RelationGetDescr(compressed_rel),
+		.segment_by_attno = segment_by_attno,
+		.count_attno = get_attnum(compressed_relid, COMPRESSION_COUNT_COLUMN),
+	};
+	AttrNumber	sort_attnos[2];
+	Oid			sort_ops[2];
+	Oid			collations[2];
+	bool		nulls_first[2];
+	int			nkeys = 0;
+	TupleTableSlot *slot = MakeSingleTupleTableSlot(desc);
+	BulkInsertState bistate = GetBulkInsertState();
+	Snapshot	snapshot;
+	Tuplesortstate *sort;
+	HeapScanDesc scan;
+	HeapTuple	tuple;
+	int64		num_rows = 0;
+	int			i;
+
+	state.compressed_attnos = palloc0(desc->natts * sizeof(AttrNumber));
+	state.values = palloc0(desc->natts * sizeof(Datum *));
+	state.nulls = palloc0(desc->natts * sizeof(bool *));
+
+	for (i = 0; i < desc->natts; i++)
+	{
+		if (desc->attrs[i]->attisdropped)
+			continue;
+
+		state.compressed_attnos[i] = get_attnum(compressed_relid, NameStr(desc->attrs[i]->attname));
+		state.values[i] = palloc(COMPRESSION_MAX_BATCH_ROWS * sizeof(Datum));
+		state.nulls[i] = palloc(COMPRESSION_MAX_BATCH_ROWS * sizeof(bool));
+	}
+
+	state.mcxt = AllocSetContextCreate(CurrentMemoryContext,
+									   "Compress batch",
+									   ALLOCSET_DEFAULT_SIZES);
+
+	if (segment_by_attno != InvalidAttrNumber)
+	{
+		sort_key_init(desc, segment_by_attno, &sort_attnos[nkeys], &sort_ops[nkeys],
+					  &collations[nkeys], &nulls_first[nkeys]);
+		nkeys++;
+	}
+
+	if (time_attno != segment_by_attno)
+	{
+		sort_key_init(desc, time_attno, &sort_attnos[nkeys], &sort_ops[nkeys],
+					  &collations[nkeys], &nulls_first[nkeys]);
+		nkeys++;
+	}
+
+	sort = tuplesort_begin_heap(desc, nkeys, sort_attnos, sort_ops, collations,
+								nulls_first, maintenance_work_mem, false);
+
+	snapshot = RegisterSnapshot(GetLatestSnapshot());
+	scan = heap_beginscan(chunk_rel, snapshot, 0, NULL);
+
+	while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		CHECK_FOR_INTERRUPTS();
+		ExecStoreTuple(tuple, slot, InvalidBuffer, false);
+		tuplesort_puttupleslot(sort, slot);
+	}
+
+	heap_endscan(scan);
+	UnregisterSnapshot(snapshot);
+
+	tuplesort_performsort(sort);
+
+	while (tuplesort_gettupleslot_compat(sort, true, slot))
+	{
+		CHECK_FOR_INTERRUPTS();
+		slot_getallattrs(slot);
+
+		if (state.num_rows == COMPRESSION_MAX_BATCH_ROWS ||
+			(state.num_rows > 0 && batch_is_new_segment(&state, slot->tts_values, slot->tts_isnull)))
+			batch_flush(&state, compressed_rel, bistate);
+
+		batch_add_row(&state, slot->tts_values, slot->tts_isnull);
+		num_rows++;
+	}
+
+	batch_flush(&state, compressed_rel, bistate);
+
+	tuplesort_end(sort);
+	ExecDropSingleTupleTableSlot(slot);
+	FreeBulkInsertState(bistate);
+	MemoryContextDelete(state.mcxt);
+
+	return num_rows;
+}
+
+/*
+ * Empty the chunk, like TRUNCATE, by giving it, its TOAST table, and its
+ * indexes new, empty storage. The chunk must be locked with an ACCESS
+ * EXCLUSIVE lock.
+ */
+static void
+chunk_truncate_storage(Relation rel)
+{
+	MultiXactId minmulti = GetOldestMultiXactId();
+	Oid			toast_relid = rel->rd_rel->reltoastrelid;
+
+	CheckTableNotInUse(rel, "compress_chunk");
+	CheckTableForSerializableConflictIn(rel);
+	RelationSetNewRelfilenode(rel, rel->rd_rel->relpersistence, RecentXmin, minmulti);
+
+	if (rel->rd_rel->relpersistence == RELPERSISTENCE_UNLOGGED)
+		heap_create_init_fork(rel);
+
+	if (OidIsValid(toast_relid))
+	{
+		Relation	toast_rel = heap_open(toast_relid, AccessExclusiveLock);
+
+		RelationSetNewRelfilenode(toast_rel, toast_rel->rd_rel->relpersistence,
+								  RecentXmin, minmulti);
+
+		if (toast_rel->rd_rel->relpersistence == RELPERSISTENCE_UNLOGGED)
+			heap_create_init_fork(toast_rel);
+
+		heap_close(toast_rel, NoLock);
+	}
+
+	reindex_relation(RelationGetRelid(rel), REINDEX_REL_PROCESS_TOAST, 0);
+	pgstat_count_truncate(rel);
+}
+
+static Chunk *
+compression_get_chunk(Oid chunk_relid)
+{
+	Chunk	   *chunk = chunk_get_by_relid(chunk_relid, 0, false);
+
+	if (NULL == chunk)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("\"%s\" is not a chunk", get_rel_name(chunk_relid))));
+
+	hypertable_permissions_check(chunk->hypertable_relid, GetUserId());
+
+	return chunk;
+}
+
+/*
+ * Compress a chunk, optionally into batches that share the value of the
+ * segment_by column.
+ */
+void
+compress_chunk(Oid chunk_relid, Name segment_by)
+{
+	Chunk	   *chunk = compression_get_chunk(chunk_relid);
+	Cache	   *hcache;
+	Hypertable *ht;
+	Dimension  *time_dim;
+	Relation	chunk_rel;
+	Relation	compressed_rel;
+	AttrNumber	time_attno;
+	AttrNumber	segment_by_attno = InvalidAttrNumber;
+	int64		num_rows;
+
+	if (NULL != compressed_chunk_get_by_chunk_id(chunk->fd.id))
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("chunk \"%s\" is already compressed", get_rel_name(chunk_relid))));
+
+	hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry(hcache, chunk->hypertable_relid);
+	time_dim = hyperspace_get_open_dimension(ht->space, 0);
+
+	if (NULL == time_dim)
+		elog(ERROR, "hypertable \"%s\" has no time dimension", get_rel_name(chunk->hypertable_relid));
+
+	/* Block writes to the chunk, but not reads */
+	chunk_rel = heap_open(chunk_relid, ExclusiveLock);
+	time_attno = get_attnum(chunk_relid, NameStr(time_dim->fd.column_name));
+
+	if (NULL != segment_by)
+	{
+		segment_by_attno = get_attnum(chunk_relid, NameStr(*segment_by));
+
+		if (segment_by_attno <= 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_COLUMN),
+					 errmsg("column \"%s\" does not exist in chunk \"%s\"",
+							NameStr(*segment_by), get_rel_name(chunk_relid))));
+	}
+
+	if (get_attnum(chunk_relid, COMPRESSION_COUNT_COLUMN) != InvalidAttrNumber)
+		ereport(ERROR,
+				(errcode(ERRCODE_DUPLICATE_COLUMN),
+				 errmsg("cannot compress chunk \"%s\" with a column named \"%s\"",
+						get_rel_name(chunk_relid), COMPRESSION_COUNT_COLUMN)));
+
+	compressed_rel = heap_open(compressed_table_create(chunk, chunk_rel, segment_by_attno),
+							   AccessExclusiveLock);
+	num_rows = compress_rows(chunk_rel, compressed_rel, time_attno, segment_by_attno);
+
+	/* Readers are only blocked while the chunk is emptied */
+	LockRelationOid(chunk_relid, AccessExclusiveLock);
+	chunk_truncate_storage(chunk_rel);
+
+	compressed_chunk_insert(chunk, compressed_rel, num_rows, segment_by);
+
+	heap_close(compressed_rel, NoLock);
+	heap_close(chunk_rel, NoLock);
+	cache_release(hcache);
+}
+
+/*
+ * Move the rows of a compressed chunk back into the chunk, updating the
+ * chunk's indexes, and drop the compressed table.
+ */
+void
+decompress_chunk(Oid chunk_relid)
+{
+	Chunk	   *chunk = compression_get_chunk(chunk_relid);
+	CompressedChunk *cc = compressed_chunk_get_by_chunk_id(chunk->fd.id);
+	ObjectAddress compressedobj = {
+		.classId = RelationRelationId,
+	};
+	Relation	chunk_rel;
+	Relation	compressed_rel;
+	TupleDesc	desc;
+	CompressedBatch *batch;
+	EState	   *estate;
+	ResultRelInfo *result_rel_info;
+	TupleTableSlot *slot;
+	BulkInsertState bistate;
+	CommandId	cid = GetCurrentCommandId(true);
+	Datum	   *values;
+	bool	   *nulls;
+	Snapshot	snapshot;
+	HeapScanDesc scan;
+	HeapTuple	compressed_tuple;
+
+	if (NULL == cc)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("chunk \"%s\" is not compressed", get_rel_name(chunk_relid))));
+
+	if (!OidIsValid(cc->compressed_relid))
+		elog(ERROR, "compressed table \"%s.%s\" of chunk \"%s\" does not exist",
+			 NameStr(cc->fd.schema_name), NameStr(cc->fd.table_name), get_rel_name(chunk_relid));
+
+	/* Block writes to the chunk, but not reads */
+	chunk_rel = heap_open(chunk_relid, ExclusiveLock);
+	compressed_rel = heap_open(cc->compressed_relid, AccessShareLock);
+	desc = RelationGetDescr(chunk_rel);
+	values = palloc(desc->natts * sizeof(Datum));
+	nulls = palloc(desc->natts * sizeof(bool));
+	batch = compressed_batch_create(chunk_rel, compressed_rel,
+									bms_make_singleton(0 - FirstLowInvalidHeapAttributeNumber));
+
+	estate = CreateExecutorState();
+	result_rel_info = makeNode(ResultRelInfo);
+	InitResultRelInfoCompat(result_rel_info, chunk_rel, 1, 0);
+	ExecOpenIndices(result_rel_info, false);
+	estate->es_result_relations = result_rel_info;
+	estate->es_num_result_relations = 1;
+	estate->es_result_relation_info = result_rel_info;
+	slot = ExecInitExtraTupleSlot(estate);
+	ExecSetSlotDescriptor(slot, desc);
+	bistate = GetBulkInsertState();
+
+	snapshot = RegisterSnapshot(GetLatestSnapshot());
+	scan = heap_beginscan(compressed_rel, snapshot, 0, NULL);
+
+	while ((compressed_tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		compressed_batch_load(batch, compressed_tuple);
+
+		while (compressed_batch_next(batch, values, nulls))
+		{
+			HeapTuple	tuple = heap_form_tuple(desc, values, nulls);
+
+			CHECK_FOR_INTERRUPTS();
+			ResetPerTupleExprContext(estate);
+			heap_insert(chunk_rel, tuple, cid, 0, bistate);
+			ExecStoreTuple(tuple, slot, InvalidBuffer, true);
+
+			if (result_rel_info->ri_NumIndices > 0)
+				list_free(ExecInsertIndexTuples(slot, &tuple->t_self, estate, false, NULL, NIL));
+		}
+	}
+
+	heap_endscan(scan);
+	UnregisterSnapshot(snapshot);
+
+	ExecClearTuple(slot);
+	FreeBulkInsertState(bistate);
+	ExecCloseIndices(result_rel_info);
+	FreeExecutorState(estate);
+	heap_close(compressed_rel, NoLock);
+
+	/* Readers are only blocked while the compressed table is dropped */
+	LockRelationOid(chunk_relid, AccessExclusiveLock);
+	compressed_chunk_delete_by_chunk_id(chunk->fd.id, true);
+
+	/* The compressed table can only be dropped on its own without its dependency */
+	deleteDependencyRecordsForClass(RelationRelationId, cc->compressed_relid,
+									RelationRelationId, DEPENDENCY_INTERNAL);
+	CommandCounterIncrement();
+	compressedobj.objectId = cc->compressed_relid;
+	performDeletion(&compressedobj, DROP_RESTRICT, PERFORM_DELETION_INTERNAL);
+
+	CacheInvalidateRelcache(chunk_rel);
+	heap_close(chunk_rel, NoLock);
+}
+
+TS_FUNCTION_INFO_V1(compress_chunk_sql);
+
+Datum
+compress_chunk_sql(PG_FUNCTION_ARGS)
+{
+	Oid			chunk_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Name		segment_by = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1);
+
+	if (!OidIsValid(chunk_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid chunk: cannot be NULL")));
+
+	compress_chunk(chunk_relid, segment_by);
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(decompress_chunk_sql);
+
+Datum
+decompress_chunk_sql(PG_FUNCTION_ARGS)
+{
+	Oid			chunk_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+
+	if (!OidIsValid(chunk_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid chunk: cannot be NULL")));
+
+	decompress_chunk(chunk_relid);
+
+	PG_RETURN_VOID();
+}
@@ -0,0 +1,57 @@
+#ifndef TIMESCALEDB_COMPRESS_CHUNK_H
+#define TIMESCALEDB_COMPRESS_CHUNK_H
+
+#include <postgres.h>
+#include <access/htup.h>
+#include <nodes/bitmapset.h>
+#include <utils/rel.h>
+
+#include "catalog.h"
+
+/* The column of a compressed table that holds the number of rows of a batch */
+#define COMPRESSION_COUNT_COLUMN "_ts_meta_count"
+
+typedef struct CompressedChunk
+{
+	FormData_compressed_chunk fd;
+	bool		has_segment_by;
+	NameData	segment_by;
+	Oid			compressed_relid;
+} CompressedChunk;
+
+/*
+ * Reads the rows of the batches of a compressed table. Only the chunk's
+ * columns that are asked for are decompressed, the others are NULL.
+ */
+typedef struct CompressedBatch
+{
+	TupleDesc	chunk_desc;
+	TupleDesc	compressed_desc;
+	AttrNumber *compressed_attnos;	/* By chunk column, zero for columns
+									 * that are not decompressed */
+	bool	   *is_segment_by;
+	AttrNumber	count_attno;
+
+	/* The current batch */
+	int			num_rows;
+	int			next_row;
+	Datum	  **values;
+	bool	  **nulls;
+	Datum	   *compressed_values;
+	bool	   *compressed_nulls;
+	MemoryContext mcxt;
+} CompressedBatch;
+
+extern CompressedChunk *compressed_chunk_get_by_chunk_id(int32 chunk_id);
+extern CompressedChunk *compressed_chunk_get_by_relid(Oid chunk_relid);
+extern bool compressed_chunk_exists_for_hypertable(int32 hypertable_id);
+extern int	compressed_chunk_delete_by_chunk_id(int32 chunk_id, bool invalidate_cache);
+
+extern CompressedBatch *compressed_batch_create(Relation chunk_rel, Relation compressed_rel, Bitmapset *attnos);
+extern void compressed_batch_load(CompressedBatch *batch, HeapTuple compressed_tuple);
+extern bool compressed_batch_next(CompressedBatch *batch, Datum *values, bool *nulls);
+
+extern void compress_chunk(Oid chunk_relid, Name segment_by);
+extern void decompress_chunk(Oid chunk_relid);
+
+#endif							/* TIMESCALEDB_COMPRESS_CHUNK_H */
@@ -0,0 +1,995 @@
+#include <postgres.h>
+#include <access/hash.h>
+#include <access/tupmacs.h>
+#include <catalog/pg_type.h>
+#include <lib/stringinfo.h>
+#include <utils/builtins.h>
+#include <utils/lsyscache.h>
+
+#include "compression.h"
+#include "compat.h"
+
+/*
+ * Compression of a column of a batch of rows.
+ *
+ * The values of a column are compressed together into a single bytea, with
+ * an encoding that depends on the column's type:
+ *
+ * - Integers, dates, and timestamps are encoded as the differences between
+ *	 consecutive deltas ("delta of delta"). Times of regular measurements
+ *	 have constant deltas, so the differences are mostly zero, and runs of
+ *	 zeros are stored as a single count.
+ *
+ * - Floats are XORed with the previous value, as in Facebook's Gorilla. The
+ *	 XOR of similar values has long runs of leading and trailing zero bits,
+ *	 so only the meaningful bits in between are stored.
+ *
+ * - Other types are dictionary encoded, with runs of the same dictionary
+ *	 entry stored once, which suits columns of few distinct values. Columns
+ *	 of many distinct values are stored as a plain array of values instead.
+ *
+ * All encodings are lossless. NULLs are stored in a bitmap and the encodings
+ * only see the non-NULL values. Values are stored in their in-memory
+ * representation, like in a heap tuple, so compressed data is not portable
+ * between architectures either.
+ *
+ * The compressed data starts with this header, followed by the NULL bitmap,
+ * if there are NULLs, and the encoded values. The data is not aligned, so it
+ * is read and written byte by byte.
+ */
+typedef struct CompressedColumnHeader
+{
+	char		vl_len_[4];
+	uint8		algorithm;
+	uint8		has_nulls;
+	uint8		num_values[4];
+} CompressedColumnHeader;
+
+#define COMPRESSED_COLUMN_HEADER_SIZE sizeof(CompressedColumnHeader)
+
+/* Dictionary encode only if at most half of the values are distinct */
+#define DICTIONARY_MAX_FRACTION 2
+
+typedef struct DataReader
+{
+	const uint8 *data;
+	const uint8 *end;
+} DataReader;
+
+static void
+corrupt_data_error(void)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_DATA_CORRUPTED),
+			 errmsg("compressed data is corrupt")));
+}
+
+static void
+append_varint(StringInfo buf, uint64 value)
+{
+	do
+	{
+		uint8		byte = value & 0x7F;
+
+		value >>= 7;
+
+		if (value != 0)
+			byte |= 0x80;
+
+		appendStringInfoChar(buf, (char) byte);
+	} while (value != 0);
+}
+
+static uint64
+read_varint(DataReader *reader)
+{
+	uint64		value = 0;
+	int			shift = 0;
+	uint8		byte;
+
+	do
+	{
+		if (reader->data >= reader->end || shift > 63)
+			corrupt_data_error();
+
+		byte = *reader->data++;
+		value |= ((uint64) (byte & 0x7F)) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+
+	return value;
+}
+
+static inline uint64
+zigzag_encode(uint64 value)
+{
+	return (value << 1) ^ (uint64) (((int64) value) >> 63);
+}
+
+static inline uint64
+zigzag_decode(uint64 value)
+{
+	return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+static const uint8 *
+read_bytes(DataReader *reader, Size len)
+{
+	const uint8 *data = reader->data;
+
+	if (len > (Size) (reader->end - reader->data))
+		corrupt_data_error();
+
+	reader->data += len;
+
+	return data;
+}
+
+/*
+ * Bit streams for the Gorilla encoding. Bits are written most significant
+ * first. At most 32 bits are added to the buffered bits at a time, and whole
+ * bytes are flushed right away, so the buffer never holds more than 39 bits.
+ */
+typedef struct BitWriter
+{
+	StringInfo	buf;
+	uint64		bits;
+	int			num_bits;
+} BitWriter;
+
+static void
+bit_writer_append(BitWriter *writer, uint64 value, int num_bits)
+{
+	Assert(num_bits > 0 && num_bits <= 64);
+
+	if (num_bits > 32)
+	{
+		bit_writer_append(writer, value >> 32, num_bits - 32);
+		bit_writer_append(writer, value & UINT64CONST(0xFFFFFFFF), 32);
+		return;
+	}
+
+	value &= (UINT64CONST(1) << num_bits) - 1;
+	writer->bits = (writer->bits << num_bits) | value;
+	writer->num_bits += num_bits;
+
+	while (writer->num_bits >= 8)
+	{
+		writer->num_bits -= 8;
+		appendStringInfoChar(writer->buf, (char) (writer->bits >> writer->num_bits));
+	}
+
+	writer->bits &= (UINT64CONST(1) << writer->num_bits) - 1;
+}
+
+static void
+bit_writer_flush(BitWriter *writer)
+{
+	if (writer->num_bits > 0)
+		appendStringInfoChar(writer->buf, (char) (writer->bits << (8 - writer->num_bits)));
+
+	writer->bits = 0;
+	writer->num_bits = 0;
+}
+
+typedef struct BitReader
+{
+	DataReader *reader;
+	uint64		bits;
+	int			num_bits;
+} BitReader;
+
+static uint64
+bit_reader_read(BitReader *reader, int num_bits)
+{
+	Assert(num_bits > 0 && num_bits <= 64);
+
+	if (num_bits > 32)
+	{
+		uint64		high = bit_reader_read(reader, num_bits - 32);
+
+		return (high << 32) | bit_reader_read(reader, 32);
+	}
+
+	while (reader->num_bits < num_bits)
+	{
+		reader->bits = (reader->bits << 8) | *read_bytes(reader->reader, 1);
+		reader->num_bits += 8;
+	}
+
+	reader->num_bits -= num_bits;
+
+	return (reader->bits >> reader->num_bits) & ((UINT64CONST(1) << num_bits) - 1);
+}
+
+static int
+leading_zeros(uint64 value)
+{
+	int			n = 0;
+
+	if (value == 0)
+		return 64;
+
+	if ((value & UINT64CONST(0xFFFFFFFF00000000)) == 0)
+	{
+		n += 32;
+		value <<= 32;
+	}
+	if ((value & UINT64CONST(0xFFFF000000000000)) == 0)
+	{
+		n += 16;
+		value <<= 16;
+	}
+	if ((value & UINT64CONST(0xFF00000000000000)) == 0)
+	{
+		n += 8;
+		value <<= 8;
+	}
+	if ((value & UINT64CONST(0xF000000000000000)) == 0)
+	{
+		n += 4;
+		value <<= 4;
+	}
+	if ((value & UINT64CONST(0xC000000000000000)) == 0)
+	{
+		n += 2;
+		value <<= 2;
+	}
+	if ((value & UINT64CONST(0x8000000000000000)) == 0)
+		n += 1;
+
+	return n;
+}
+
+static int
+trailing_zeros(uint64 value)
+{
+	int			n = 0;
+
+	if (value == 0)
+		return 64;
+
+	if ((value & UINT64CONST(0xFFFFFFFF)) == 0)
+	{
+		n += 32;
+		value >>= 32;
+	}
+	if ((value & UINT64CONST(0xFFFF)) == 0)
+	{
+		n += 16;
+		value >>= 16;
+	}
+	if ((value & UINT64CONST(0xFF)) == 0)
+	{
+		n += 8;
+		value >>= 8;
+	}
+	if ((value & UINT64CONST(0xF)) == 0)
+	{
+		n += 4;
+		value >>= 4;
+	}
+	if ((value & UINT64CONST(0x3)) == 0)
+	{
+		n += 2;
+		value >>= 2;
+	}
+	if ((value & UINT64CONST(0x1)) == 0)
+		n += 1;
+
+	return n;
+}
+
+/*
+ * Integer-like types that are delta-of-delta encoded. Their values are
+ * handled as unsigned 64-bit integers, so that the arithmetic on deltas wraps
+ * around instead of overflowing and decoding reverses it exactly.
+ */
+static uint64
+integer_datum_get_uint64(Datum value, Oid typid)
+{
+	switch (typid)
+	{
+		case INT2OID:
+			return (uint64) (int64) DatumGetInt16(value);
+		case INT4OID:
+		case DATEOID:
+			return (uint64) (int64) DatumGetInt32(value);
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return (uint64) DatumGetInt64(value);
+		default:
+			elog(ERROR, "unexpected type %u for delta-of-delta encoding", typid);
+			pg_unreachable();
+	}
+}
+
+static Datum
+integer_uint64_get_datum(uint64 value, Oid typid)
+{
+	switch (typid)
+	{
+		case INT2OID:
+			return Int16GetDatum((int16) value);
+		case INT4OID:
+		case DATEOID:
+			return Int32GetDatum((int32) value);
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return Int64GetDatum((int64) value);
+		default:
+			elog(ERROR, "unexpected type %u for delta-of-delta encoding", typid);
+			pg_unreachable();
+	}
+}
+
+/*
+ * Encode the values as the first value followed by the differences between
+ * consecutive deltas. Each difference is preceded by the number of zero
+ * differences before it and a trailing run of zeros is stored as a count
+ * only.
+ */
+static void
+deltadelta_encode(StringInfo buf, Oid typid, Datum *values, int num_values)
+{
+	uint64		prev;
+	uint64		prev_delta = 0;
+	uint64		zero_run = 0;
+	int			i;
+
+	if (num_values == 0)
+		return;
+
+	prev = integer_datum_get_uint64(values[0], typid);
+	append_varint(buf, zigzag_encode(prev));
+
+	for (i = 1; i < num_values; i++)
+	{
+		uint64		value = integer_datum_get_uint64(values[i], typid);
+		uint64		delta = value - prev;
+		uint64		delta_of_delta = delta - prev_delta;
+
+		if (delta_of_delta == 0)
+			zero_run++;
+		else
+		{
+			append_varint(buf, zero_run);
+			append_varint(buf, zigzag_encode(delta_of_delta));
+			zero_run = 0;
+		}
+
+		prev = value;
+		prev_delta = delta;
+	}
+
+	if (zero_run > 0)
+		append_varint(buf, zero_run);
+}
+
+static void
+deltadelta_decode(DataReader *reader, Oid typid, Datum *values, int num_values)
+{
+	uint64		value;
+	uint64		delta = 0;
+	int			i = 0;
+
+	if (num_values == 0)
+		return;
+
+	value = zigzag_decode(read_varint(reader));
+	values[i++] = integer_uint64_get_datum(value, typid);
+
+	while (i < num_values)
+	{
+		uint64		zero_run = read_varint(reader);
+
+		if (zero_run > (uint64) (num_values - i))
+			corrupt_data_error();
+
+		while (zero_run-- > 0)
+		{
+			value += delta;
+			values[i++] = integer_uint64_get_datum(value, typid);
+		}
+
+		if (i < num_values)
+		{
+			delta += zigzag_decode(read_varint(reader));
+			value += delta;
+			values[i++] = integer_uint64_get_datum(value, typid);
+		}
+	}
+}
+
+static uint64
+float_datum_get_uint64(Datum value, Oid typid)
+{
+	union
+	{
+		float8		f;
+		uint64		u;
+	}			bits;
+
+	bits.f = (typid == FLOAT4OID) ? (float8) DatumGetFloat4(value) : DatumGetFloat8(value);
+
+	return bits.u;
+}
+
+static Datum
+float_uint64_get_datum(uint64 value, Oid typid)
+{
+	union
+	{
+		float8		f;
+		uint64		u;
+	}			bits;
+
+	bits.u = value;
+
+	return (typid == FLOAT4OID) ? Float4GetDatum((float4) bits.f) : Float8GetDatum(bits.f);
+}
+
+/*
+ * Encode the values with the XOR encoding of Gorilla. A value that is equal to
+ * the previous one takes a single bit. Otherwise, the meaningful bits of the
+ * XOR with the previous value are stored, either in the window of meaningful
+ * bits of the previous XOR, if they fit, or with a new window. Float4 values
+ * are encoded as float8, which represents them exactly.
+ */
+static void
+gorilla_encode(StringInfo buf, Oid typid, Datum *values, int num_values)
+{
+	BitWriter	writer = {
+		.buf = buf,
+	};
+	uint64		prev;
+	int			prev_leading = -1;
+	int			prev_trailing = 0;
+	int			i;
+
+	if (num_values == 0)
+		return;
+
+	prev = float_datum_get_uint64(values[0], typid);
+	bit_writer_append(&writer, prev, 64);
+
+	for (i = 1; i < num_values; i++)
+	{
+		uint64		value = float_datum_get_uint64(values[i], typid);
+		uint64		xor = value ^ prev;
+
+		if (xor == 0)
+			bit_writer_append(&writer, 0, 1);
+		else
+		{
+			int			leading = Min(leading_zeros(xor), 31);
+			int			trailing = trailing_zeros(xor);
+
+			bit_writer_append(&writer, 1, 1);
+
+			if (prev_leading >= 0 && leading >= prev_leading && trailing >= prev_trailing)
+			{
+				bit_writer_append(&writer, 0, 1);
+				bit_writer_append(&writer, xor >> prev_trailing, 64 - prev_leading - prev_trailing);
+			}
+			else
+			{
+				int			meaningful = 64 - leading - trailing;
+
+				bit_writer_append(&writer, 1, 1);
+				bit_writer_append(&writer, leading, 5);
+				bit_writer_append(&writer, meaningful - 1, 6);
+				bit_writer_append(&writer, xor >> trailing, meaningful);
+				prev_leading = leading;
+				prev_trailing = trailing;
+			}
+		}
+
+		prev = value;
+	}
+
+	bit_writer_flush(&writer);
+}
+
+static void
+gorilla_decode(DataReader *data, Oid typid, Datum *values, int num_values)
+{
+	BitReader	reader = {
+		.reader = data,
+	};
+	uint64		value;
+	int			leading = -1;
+	int			trailing = 0;
+	int			i;
+
+	if (num_values == 0)
+		return;
+
+	value = bit_reader_read(&reader, 64);
+	values[0] = float_uint64_get_datum(value, typid);
+
+	for (i = 1; i < num_values; i++)
+	{
+		if (bit_reader_read(&reader, 1) == 1)
+		{
+			int			meaningful;
+
+			if (bit_reader_read(&reader, 1) == 1)
+			{
+				leading = bit_reader_read(&reader, 5);
+				meaningful = bit_reader_read(&reader, 6) + 1;
+				trailing = 64 - leading - meaningful;
+
+				if (trailing < 0)
+					corrupt_data_error();
+			}
+			else
+			{
+				if (leading < 0)
+					corrupt_data_error();
+
+				meaningful = 64 - leading - trailing;
+			}
+
+			value ^= bit_reader_read(&reader, meaningful) << trailing;
+		}
+
+		values[i] = float_uint64_get_datum(value, typid);
+	}
+}
+
+/*
+ * Serialization of values of any type, for the dictionary and array
+ * encodings. Varlena values are stored detoasted, with their length but
+ * without their header.
+ */
+typedef struct TypeInfo
+{
+	int16		typlen;
+	bool		typbyval;
+} TypeInfo;
+
+static void
+datum_serialize(StringInfo buf, Datum value, TypeInfo *type)
+{
+	if (type->typbyval)
+	{
+		union
+		{
+			Datum		datum;
+			char		bytes[sizeof(Datum)];
+		}			storage;
+
+		store_att_byval(storage.bytes, value, type->typlen);
+		appendBinaryStringInfo(buf, storage.bytes, type->typlen);
+	}
+	else if (type->typlen > 0)
+		appendBinaryStringInfo(buf, DatumGetPointer(value), type->typlen);
+	else if (type->typlen == -1)
+	{
+		struct varlena *detoasted = PG_DETOAST_DATUM_PACKED(value);
+		Size		len = VARSIZE_ANY_EXHDR(detoasted);
+
+		append_varint(buf, len);
+		appendBinaryStringInfo(buf, VARDATA_ANY(detoasted), len);
+
+		if (detoasted != (struct varlena *) DatumGetPointer(value))
+			pfree(detoasted);
+	}
+	else
+	{
+		char	   *str = DatumGetCString(value);
+		Size		len = strlen(str);
+
+		append_varint(buf, len);
+		appendBinaryStringInfo(buf, str, len);
+	}
+}
+
+static Datum
+datum_deserialize(DataReader *reader, TypeInfo *type)
+{
+	if (type->typbyval)
+	{
+		union
+		{
+			Datum		datum;
+			char		bytes[sizeof(Datum)];
+		}			storage;
+
+		memcpy(storage.bytes, read_bytes(reader, type->typlen), type->typlen);
+		return fetch_att(storage.bytes, true, type->typlen);
+	}
+	else if (type->typlen > 0)
+	{
+		char	   *value = palloc(type->typlen);
+
+		memcpy(value, read_bytes(reader, type->typlen), type->typlen);
+		return PointerGetDatum(value);
+	}
+	else if (type->typlen == -1)
+	{
+		Size		len = read_varint(reader);
+		struct varlena *value = palloc(VARHDRSZ + len);
+
+		SET_VARSIZE(value, VARHDRSZ + len);
+		memcpy(VARDATA(value), read_bytes(reader, len), len);
+		return PointerGetDatum(value);
+	}
+	else
+	{
+		Size		len = read_varint(reader);
+		char	   *value = palloc(len + 1);
+
+		memcpy(value, read_bytes(reader, len), len);
+		value[len] = '\0';
+		return CStringGetDatum(value);
+	}
+}
+
+/*
+ * Build the dictionary of the distinct values, comparing their serialized
+ * forms. Returns false, without a dictionary, if there are too many distinct
+ * values for dictionary encoding to pay off. Otherwise, the serialized
+ * dictionary entries are in 'entries' and the dictionary entry of each value
+ * in 'codes'.
+ */
+static bool
+dictionary_build(Datum *values, int num_values, TypeInfo *type,
+				 StringInfo serialized, StringInfo entries, int *num_entries, uint32 *codes)
+{
+	int		   *offsets = palloc((num_values + 1) * sizeof(int));
+	int			table_size = 2;
+	int		   *table;
+	int		   *entry_values;
+	int			i;
+
+	while (table_size < 2 * num_values)
+		table_size *= 2;
+
+	table = palloc(table_size * sizeof(int));
+	memset(table, -1, table_size * sizeof(int));
+	entry_values = palloc(num_values * sizeof(int));
+	*num_entries = 0;
+
+	for (i = 0; i < num_values; i++)
+	{
+		offsets[i] = serialized->len;
+		datum_serialize(serialized, values[i], type);
+	}
+	offsets[num_values] = serialized->len;
+
+	for (i = 0; i < num_values; i++)
+	{
+		const char *value = serialized->data + offsets[i];
+		int			len = offsets[i + 1] - offsets[i];
+		uint32		slot = DatumGetUInt32(hash_any((const unsigned char *) value, len)) & (table_size - 1);
+
+		for (;;)
+		{
+			int			entry = table[slot];
+
+			if (entry < 0)
+			{
+				entry = (*num_entries)++;
+				entry_values[entry] = i;
+				table[slot] = entry;
+				appendBinaryStringInfo(entries, value, len);
+				codes[i] = entry;
+				break;
+			}
+			else
+			{
+				int			other = entry_values[entry];
+
+				if (len == offsets[other + 1] - offsets[other] &&
+					memcmp(value, serialized->data + offsets[other], len) == 0)
+				{
+					codes[i] = entry;
+					break;
+				}
+			}
+
+			slot = (slot + 1) & (table_size - 1);
+		}
+
+		if (*num_entries > num_values / DICTIONARY_MAX_FRACTION)
+			return false;
+	}
+
+	return true;
+}
+
+static CompressionAlgorithm
+dictionary_encode(StringInfo buf, Datum *values, int num_values, TypeInfo *type)
+{
+	StringInfoData serialized;
+	StringInfoData entries;
+	uint32	   *codes = palloc(num_values * sizeof(uint32));
+	int			num_entries;
+	int			i;
+
+	initStringInfo(&serialized);
+	initStringInfo(&entries);
+
+	if (!dictionary_build(values, num_values, type, &serialized, &entries, &num_entries, codes))
+	{
+		/*
+		 * Too many distinct values, so store the values as they are. The
+		 * serialized values are in the array format already.
+		 */
+		appendBinaryStringInfo(buf, serialized.data, serialized.len);
+		return COMPRESSION_ALGORITHM_ARRAY;
+	}
+
+	append_varint(buf, num_entries);
+	appendBinaryStringInfo(buf, entries.data, entries.len);
+
+	/* The codes are stored as runs of (run length, code) */
+	for (i = 0; i < num_values;)
+	{
+		int			run = 1;
+
+		while (i + run < num_values && codes[i + run] == codes[i])
+			run++;
+
+		append_varint(buf, run);
+		append_varint(buf, codes[i]);
+		i += run;
+	}
+
+	return COMPRESSION_ALGORITHM_DICTIONARY;
+}
+
+static void
+dictionary_decode(DataReader *reader, Datum *values, int num_values, TypeInfo *type)
+{
+	uint64		num_entries = read_varint(reader);
+	Datum	   *entries;
+	uint64		i;
+	int			j = 0;
+
+	if (num_entries > (uint64) num_values)
+		corrupt_data_error();
+
+	entries = palloc(num_entries * sizeof(Datum));
+
+	for (i = 0; i < num_entries; i++)
+		entries[i] = datum_deserialize(reader, type);
+
+	while (j < num_values)
+	{
+		uint64		run = read_varint(reader);
+		uint64		code = read_varint(reader);
+
+		if (run > (uint64) (num_values - j) || code >= num_entries)
+			corrupt_data_error();
+
+		/* Byref values are shared between the rows of a run */
+		while (run-- > 0)
+			values[j++] = entries[code];
+	}
+}
+
+static void
+array_decode(DataReader *reader, Datum *values, int num_values, TypeInfo *type)
+{
+	int			i;
+
+	for (i = 0; i < num_values; i++)
+		values[i] = datum_deserialize(reader, type);
+}
+
+static CompressionAlgorithm
+compression_algorithm_for_type(Oid typid)
+{
+	switch (typid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case DATEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return COMPRESSION_ALGORITHM_DELTADELTA;
+		case FLOAT4OID:
+		case FLOAT8OID:
+			return COMPRESSION_ALGORITHM_GORILLA;
+		default:
+			return COMPRESSION_ALGORITHM_DICTIONARY;
+	}
+}
+
+/*
+ * Compress the values of a column. Returns the compressed data, which is
+ * allocated in the current memory context.
+ */
+bytea *
+compression_compress(Oid typid, Datum *values, bool *nulls, int num_values)
+{
+	Oid			basetypid = getBaseType(typid);
+	CompressionAlgorithm algorithm = compression_algorithm_for_type(basetypid);
+	CompressedColumnHeader header = {
+		.has_nulls = false,
+	};
+	StringInfoData buf;
+	Datum	   *nonnull = palloc(num_values * sizeof(Datum));
+	int			num_nonnull = 0;
+	int			i;
+
+	memcpy(header.num_values, &num_values, sizeof(int32));
+
+	for (i = 0; i < num_values; i++)
+	{
+		if (nulls[i])
+			header.has_nulls = true;
+		else
+			nonnull[num_nonnull++] = values[i];
+	}
+
+	initStringInfo(&buf);
+	appendBinaryStringInfo(&buf, (char *) &header, COMPRESSED_COLUMN_HEADER_SIZE);
+
+	if (header.has_nulls)
+	{
+		int			bitmap_len = (num_values + 7) / 8;
+		int			offset = buf.len;
+
+		for (i = 0; i < bitmap_len; i++)
+			appendStringInfoChar(&buf, 0);
+
+		for (i = 0; i < num_values; i++)
+			if (nulls[i])
+				buf.data[offset + i / 8] |= (1 << (i % 8));
+	}
+
+	switch (algorithm)
+	{
+		case COMPRESSION_ALGORITHM_DELTADELTA:
+			deltadelta_encode(&buf, basetypid, nonnull, num_nonnull);
+			break;
+		case COMPRESSION_ALGORITHM_GORILLA:
+			gorilla_encode(&buf, basetypid, nonnull, num_nonnull);
+			break;
+		default:
+			{
+				TypeInfo	type;
+
+				get_typlenbyval(typid, &type.typlen, &type.typbyval);
+
+				if (num_nonnull > 0)
+					algorithm = dictionary_encode(&buf, nonnull, num_nonnull, &type);
+				break;
+			}
+	}
+
+	((CompressedColumnHeader *) buf.data)->algorithm = algorithm;
+	SET_VARSIZE(buf.data, buf.len);
+	pfree(nonnull);
+
+	return (bytea *) buf.data;
+}
+
+static CompressedColumnHeader *
+compressed_column_header(bytea *compressed)
+{
+	if (VARSIZE(compressed) < COMPRESSED_COLUMN_HEADER_SIZE)
+		corrupt_data_error();
+
+	return (CompressedColumnHeader *) compressed;
+}
+
+CompressionAlgorithm
+compression_get_algorithm(bytea *compressed)
+{
+	return compressed_column_header(compressed)->algorithm;
+}
+
+/*
+ * Decompress a column that was compressed with compression_compress(). The
+ * compressed data must be detoasted and the number of values must be the
+ * number that were compressed. Values of byref types are allocated in the
+ * current memory context.
+ */
+void
+compression_decompress(bytea *compressed, Oid typid, Datum *values, bool *nulls, int num_values)
+{
+	Oid			basetypid = getBaseType(typid);
+	CompressedColumnHeader *header = compressed_column_header(compressed);
+	DataReader	reader = {
+		.data = (uint8 *) compressed + COMPRESSED_COLUMN_HEADER_SIZE,
+		.end = (uint8 *) compressed + VARSIZE(compressed),
+	};
+	Datum	   *nonnull = values;
+	int			num_nonnull = num_values;
+	int32		stored_num_values;
+	TypeInfo	type;
+	int			i;
+
+	memcpy(&stored_num_values, header->num_values, sizeof(int32));
+
+	if (stored_num_values != num_values)
+		corrupt_data_error();
+
+	memset(nulls, 0, num_values * sizeof(bool));
+
+	if (header->has_nulls)
+	{
+		const uint8 *bitmap = read_bytes(&reader, (num_values + 7) / 8);
+
+		num_nonnull = 0;
+
+		for (i = 0; i < num_values; i++)
+		{
+			nulls[i] = (bitmap[i / 8] & (1 << (i % 8))) != 0;
+
+			if (!nulls[i])
+				num_nonnull++;
+		}
+
+		nonnull = palloc(num_nonnull * sizeof(Datum));
+	}
+
+	switch (num_nonnull > 0 ? header->algorithm : 0)
+	{
+		case 0:
+			/* Only NULLs, so there are no encoded values */
+			break;
+		case COMPRESSION_ALGORITHM_DELTADELTA:
+			if (compression_algorithm_for_type(basetypid) != COMPRESSION_ALGORITHM_DELTADELTA)
+				corrupt_data_error();
+			deltadelta_decode(&reader, basetypid, nonnull, num_nonnull);
+			break;
+		case COMPRESSION_ALGORITHM_GORILLA:
+			if (compression_algorithm_for_type(basetypid) != COMPRESSION_ALGORITHM_GORILLA)
+				corrupt_data_error();
+			gorilla_decode(&reader, basetypid, nonnull, num_nonnull);
+			break;
+		case COMPRESSION_ALGORITHM_DICTIONARY:
+			get_typlenbyval(typid, &type.typlen, &type.typbyval);
+			dictionary_decode(&reader, nonnull, num_nonnull, &type);
+			break;
+		case COMPRESSION_ALGORITHM_ARRAY:
+			get_typlenbyval(typid, &type.typlen, &type.typbyval);
+			array_decode(&reader, nonnull, num_nonnull, &type);
+			break;
+		default:
+			corrupt_data_error();
+	}
+
+	if (header->has_nulls)
+	{
+		int			j = 0;
+
+		for (i = 0; i < num_values; i++)
+			values[i] = nulls[i] ? (Datum) 0 : nonnull[j++];
+
+		pfree(nonnull);
+	}
+}
+
+static const char *compression_algorithm_names[] = {
+	[COMPRESSION_ALGORITHM_ARRAY] = "array",
+	[COMPRESSION_ALGORITHM_DICTIONARY] = "dictionary",
+	[COMPRESSION_ALGORITHM_DELTADELTA] = "deltadelta",
+	[COMPRESSION_ALGORITHM_GORILLA] = "gorilla",
+};
+
+TS_FUNCTION_INFO_V1(compression_algorithm_name);
+
+/*
+ * Get the name of the encoding of a compressed column.
+ */
+Datum
+compression_algorithm_name(PG_FUNCTION_ARGS)
+{
+	bytea	   *compressed = PG_GETARG_BYTEA_P(0);
+	CompressionAlgorithm algorithm = compression_get_algorithm(compressed);
+
+	if (algorithm < COMPRESSION_ALGORITHM_ARRAY || algorithm > COMPRESSION_ALGORITHM_GORILLA)
+		corrupt_data_error();
+
+	PG_RETURN_TEXT_P(cstring_to_text(compression_algorithm_names[algorithm]));
+}
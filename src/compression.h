@@ -0,0 +1,21 @@
+#ifndef TIMESCALEDB_COMPRESSION_H
+#define TIMESCALEDB_COMPRESSION_H
+
+#include <postgres.h>
+
+/* The maximum number of rows that are compressed together in a batch */
+#define COMPRESSION_MAX_BATCH_ROWS 1000
+
+typedef enum CompressionAlgorithm
+{
+	COMPRESSION_ALGORITHM_ARRAY = 1,
+	COMPRESSION_ALGORITHM_DICTIONARY,
+	COMPRESSION_ALGORITHM_DELTADELTA,
+	COMPRESSION_ALGORITHM_GORILLA,
+} CompressionAlgorithm;
+
+extern bytea *compression_compress(Oid typid, Datum *values, bool *nulls, int num_values);
+extern void compression_decompress(bytea *compressed, Oid typid, Datum *values, bool *nulls, int num_values);
+extern CompressionAlgorithm compression_get_algorithm(bytea *compressed);
+
+#endif							/* TIMESCALEDB_COMPRESSION_H */
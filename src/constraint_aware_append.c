@@ -1,18 +1,38 @@
 #include <postgres.h>
+#include <access/parallel.h>
 #include <nodes/extensible.h>
 #include <nodes/plannodes.h>
+#include <nodes/makefuncs.h>
 #include <parser/parsetree.h>
 #include <optimizer/plancat.h>
 #include <optimizer/clauses.h>
+#include <optimizer/cost.h>
 #include <optimizer/prep.h>
+#include <optimizer/pathnode.h>
+#include <optimizer/subselect.h>
 #include <executor/executor.h>
+#include <executor/nodeSubplan.h>
+#include <access/hash.h>
 #include <catalog/pg_class.h>
+#include <catalog/pg_type.h>
+#include <port/atomics.h>
+#include <storage/bufmgr.h>
+#include <storage/shm_toc.h>
+#include <utils/array.h>
 #include <utils/memutils.h>
 #include <utils/lsyscache.h>
+#include <utils/typcache.h>
 #include <commands/explain.h>
 
 #include "constraint_aware_append.h"
 #include "hypertable.h"
+#include "hypertable_cache.h"
+#include "hypertable_restrict_info.h"
+#include "chunk.h"
+#include "chunk_bloom_filter.h"
+#include "chunk_time_range.h"
+#include "guc.h"
+#include "plan_join_exclusion.h"
 #include "compat.h"
 
 /*
@@ -67,6 +87,477 @@ excluded_by_constraint(RangeTblEntry *rte, AppendRelInfo *appinfo, List *restric
 	return relation_excluded_by_constraints(&root, &rel, rte);
 }
 
+/*
+ * Restrictions on the hypertable's dimensions, which exclude children by
+ * comparing them with the children's dimension ranges. This is much cheaper
+ * than refuting the restriction clauses with each child's constraints, which
+ * have to be fetched and turned into expressions first.
+ */
+typedef struct DimensionExclusion
+{
+	Cache	   *hcache;
+	HypertableRestrictInfo *hri;
+	bool		complete;		/* all clauses are dimension restrictions */
+	HTAB	   *time_ranges;	/* chunk time ranges read so far */
+	List	   *bloom_probes;	/* values looked up in columns with filters */
+	HTAB	   *bloom_filters;	/* chunk bloom filters read so far */
+	MemoryContext mcxt;			/* for what is read, across executions */
+} DimensionExclusion;
+
+/*
+ * The actual range of time of a chunk's rows, read from the catalog at most
+ * once per execution, since runtime exclusion can check a chunk many times.
+ */
+typedef struct ChunkTimeRangeEntry
+{
+	int32		chunk_id;
+	bool		known;
+	int64		min_value;
+	int64		max_value;
+} ChunkTimeRangeEntry;
+
+static HTAB *
+chunk_time_range_htab_create(void)
+{
+	HASHCTL		ctl = {
+		.keysize = sizeof(int32),
+		.entrysize = sizeof(ChunkTimeRangeEntry),
+		.hcxt = CurrentMemoryContext,
+	};
+
+	return hash_create("ConstraintAwareAppend chunk time ranges", 32, &ctl,
+					   HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+}
+
+/*
+ * The bloom filters of a chunk, read from the catalog at most once per
+ * execution, like the time ranges.
+ */
+typedef struct ChunkBloomFilterEntry
+{
+	int32		chunk_id;
+	List	   *filters;
+} ChunkBloomFilterEntry;
+
+static HTAB *
+chunk_bloom_filter_htab_create(void)
+{
+	HASHCTL		ctl = {
+		.keysize = sizeof(int32),
+		.entrysize = sizeof(ChunkBloomFilterEntry),
+		.hcxt = CurrentMemoryContext,
+	};
+
+	return hash_create("ConstraintAwareAppend chunk bloom filters", 32, &ctl,
+					   HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+}
+
+/*
+ * The hashes of the values that a restriction looks up in a column with
+ * bloom filters. Chunks whose filter contains none of them are excluded.
+ */
+typedef struct BloomProbe
+{
+	char	   *column_name;
+	uint32	   *hashes;
+	int			num_hashes;
+} BloomProbe;
+
+static Node *
+strip_relabel(Node *node)
+{
+	while (IsA(node, RelabelType))
+		node = (Node *) ((RelabelType *) node)->arg;
+
+	return node;
+}
+
+/*
+ * Create a probe from a clause of the form "column = value" or "column = ANY
+ * (array)" on a column with bloom filters. The operator must be in the hash
+ * operator family of the column's type, so that the values hash like the
+ * column's values did when the filters were built.
+ */
+static BloomProbe *
+bloom_probe_create(Oid hypertable_relid, Index parent_relid, List *columns, Expr *clause)
+{
+	BloomProbe *probe;
+	TypeCacheEntry *tce;
+	Oid			opno;
+	Node	   *left;
+	Node	   *right;
+	Var		   *var;
+	Const	   *c;
+	Oid			valtype;
+	Datum	   *values;
+	bool	   *nulls = NULL;
+	int			num_values;
+	char	   *column_name;
+	FmgrInfo	finfo;
+	ListCell   *lc;
+	int			i;
+
+	if (IsA(clause, OpExpr) && list_length(((OpExpr *) clause)->args) == 2)
+	{
+		OpExpr	   *op = (OpExpr *) clause;
+
+		opno = op->opno;
+		left = strip_relabel(linitial(op->args));
+		right = strip_relabel(lsecond(op->args));
+
+		if (IsA(right, Var))
+		{
+			Node	   *tmp = left;
+
+			left = right;
+			right = tmp;
+		}
+	}
+	else if (IsA(clause, ScalarArrayOpExpr) && ((ScalarArrayOpExpr *) clause)->useOr)
+	{
+		ScalarArrayOpExpr *saop = (ScalarArrayOpExpr *) clause;
+
+		opno = saop->opno;
+		left = strip_relabel(linitial(saop->args));
+		right = lsecond(saop->args);
+	}
+	else
+		return NULL;
+
+	if (!IsA(left, Var) || !IsA(right, Const))
+		return NULL;
+
+	var = (Var *) left;
+	c = (Const *) right;
+
+	if (var->varno != parent_relid || var->varlevelsup != 0 || var->varattno <= 0 ||
+		c->constisnull)
+		return NULL;
+
+	column_name = get_attname(hypertable_relid, var->varattno);
+
+	if (NULL == column_name)
+		return NULL;
+
+	foreach(lc, columns)
+		if (strcmp(lfirst(lc), column_name) == 0)
+			break;
+
+	if (NULL == lc)
+		return NULL;
+
+	tce = lookup_type_cache(var->vartype, TYPECACHE_HASH_OPFAMILY | TYPECACHE_HASH_PROC);
+
+	if (!OidIsValid(tce->hash_opf) || !op_in_opfamily(opno, tce->hash_opf))
+		return NULL;
+
+	if (IsA(clause, ScalarArrayOpExpr))
+	{
+		ArrayType  *arr = DatumGetArrayTypeP(c->constvalue);
+		int16		elemlen;
+		bool		elembyval;
+		char		elemalign;
+
+		valtype = ARR_ELEMTYPE(arr);
+		get_typlenbyvalalign(valtype, &elemlen, &elembyval, &elemalign);
+		deconstruct_array(arr, valtype, elemlen, elembyval, elemalign,
+						  &values, &nulls, &num_values);
+	}
+	else
+	{
+		valtype = c->consttype;
+		values = &c->constvalue;
+		num_values = 1;
+	}
+
+	/* Values of other types in the family hash with their own function */
+	if (valtype == var->vartype)
+		fmgr_info(tce->hash_proc, &finfo);
+	else
+	{
+		Oid			hash_proc = get_opfamily_proc(tce->hash_opf, valtype, valtype, HASHPROC);
+
+		if (!OidIsValid(hash_proc))
+			return NULL;
+
+		fmgr_info(hash_proc, &finfo);
+	}
+
+	probe = palloc(sizeof(BloomProbe));
+	probe->column_name = column_name;
+	probe->hashes = palloc(sizeof(uint32) * Max(num_values, 1));
+	probe->num_hashes = 0;
+
+	for (i = 0; i < num_values; i++)
+	{
+		/* A NULL element never equals the column */
+		if (NULL != nulls && nulls[i])
+			continue;
+
+		probe->hashes[probe->num_hashes++] =
+			DatumGetUInt32(FunctionCall1Coll(&finfo, var->varcollid, values[i]));
+	}
+
+	return probe;
+}
+
+static void
+dimension_exclusion_begin(DimensionExclusion *de, ConstraintAwareAppendState *state,
+						  List *restrictinfos)
+{
+	Hypertable *ht;
+	ListCell   *lc;
+
+	de->hcache = hypertable_cache_pin();
+	de->hri = NULL;
+	de->complete = false;
+	de->time_ranges = state->chunk_time_ranges;
+	de->bloom_probes = NIL;
+	de->bloom_filters = state->chunk_bloom_filters;
+	de->mcxt = state->csstate.ss.ps.state->es_query_cxt;
+
+	ht = hypertable_cache_get_entry(de->hcache, state->hypertable_relid);
+
+	if (ht != NULL)
+	{
+		de->hri = hypertable_restrict_info_create(ht, state->parent_relid);
+		de->complete = hypertable_restrict_info_add_qual(de->hri, (Node *) restrictinfos);
+	}
+
+	if (ht != NULL && ht->has_bloom_filters)
+	{
+		List	   *columns = hypertable_bloom_column_get_all(ht->fd.id);
+
+		foreach(lc, restrictinfos)
+		{
+			BloomProbe *probe = bloom_probe_create(state->hypertable_relid, state->parent_relid,
+												   columns, ((RestrictInfo *) lfirst(lc))->clause);
+
+			if (NULL != probe)
+				de->bloom_probes = lappend(de->bloom_probes, probe);
+		}
+	}
+}
+
+static void
+dimension_exclusion_end(DimensionExclusion *de)
+{
+	cache_release(de->hcache);
+}
+
+/*
+ * Check the restrictions on time against the actual range of time of a
+ * chunk's rows, which can be much narrower than the chunk's time slice.
+ */
+static bool
+dimension_exclusion_matches_time_range(DimensionExclusion *de, int32 chunk_id)
+{
+	ChunkTimeRangeEntry *entry;
+	bool		found;
+
+	entry = hash_search(de->time_ranges, &chunk_id, HASH_ENTER, &found);
+
+	if (!found)
+		entry->known = chunk_time_range_get(chunk_id, &entry->min_value, &entry->max_value);
+
+	return !entry->known ||
+		hypertable_restrict_info_matches_time_range(de->hri, entry->min_value, entry->max_value);
+}
+
+/*
+ * Check the values looked up in columns with bloom filters against a chunk's
+ * filters. A chunk without a filter for a column may contain any value.
+ */
+static bool
+dimension_exclusion_matches_bloom_filters(DimensionExclusion *de, int32 chunk_id)
+{
+	ChunkBloomFilterEntry *entry;
+	bool		found;
+	ListCell   *lc;
+
+	if (de->bloom_probes == NIL)
+		return true;
+
+	entry = hash_search(de->bloom_filters, &chunk_id, HASH_ENTER, &found);
+
+	if (!found)
+	{
+		MemoryContext old = MemoryContextSwitchTo(de->mcxt);
+
+		entry->filters = chunk_bloom_filter_get_all(chunk_id);
+		MemoryContextSwitchTo(old);
+	}
+
+	foreach(lc, de->bloom_probes)
+	{
+		BloomProbe *probe = lfirst(lc);
+		BloomFilter *filter = NULL;
+		ListCell   *lc_filter;
+		int			i;
+
+		foreach(lc_filter, entry->filters)
+		{
+			if (strcmp(NameStr(((BloomFilter *) lfirst(lc_filter))->column_name),
+					   probe->column_name) == 0)
+			{
+				filter = lfirst(lc_filter);
+				break;
+			}
+		}
+
+		if (NULL == filter)
+			continue;
+
+		for (i = 0; i < probe->num_hashes; i++)
+			if (bloom_filter_may_contain(filter, probe->hashes[i]))
+				break;
+
+		if (i == probe->num_hashes)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Check if a child can be excluded. Children that are chunks are first
+ * checked against the dimension restrictions, the chunk's actual range of
+ * time, and the chunk's bloom filters. The generic, and more expensive, constraint-based exclusion only
+ * runs if there are clauses that are not dimension restrictions, or if the
+ * child is not a chunk.
+ */
+static bool
+child_excluded(DimensionExclusion *de, RangeTblEntry *rte, AppendRelInfo *appinfo,
+			   Hypercube *cube, int32 chunk_id, List *restrictinfos)
+{
+	if (de->hri != NULL && cube != NULL)
+	{
+		if (!hypertable_restrict_info_matches_cube(de->hri, cube))
+			return true;
+
+		if (!dimension_exclusion_matches_time_range(de, chunk_id))
+			return true;
+
+		if (!dimension_exclusion_matches_bloom_filters(de, chunk_id))
+			return true;
+
+		if (de->complete)
+			return false;
+	}
+
+	return excluded_by_constraint(rte, appinfo, restrictinfos);
+}
+
+static Const *
+make_int8_const(int64 value)
+{
+	return makeConst(INT8OID, -1, InvalidOid, sizeof(int64),
+					 Int64GetDatum(value), false, FLOAT8PASSBYVAL);
+}
+
+/*
+ * The dimension ranges of a chunk are passed from the planner to the executor
+ * as a flat list of constants: the chunk ID followed by (dimension ID, range
+ * start, range end) for each slice.
+ */
+static List *
+chunk_ranges_to_list(Chunk *chunk)
+{
+	Hypercube  *cube = chunk->cube;
+	List	   *ranges = list_make1(make_int8_const(chunk->fd.id));
+	int			i;
+
+	for (i = 0; i < cube->num_slices; i++)
+	{
+		DimensionSlice *slice = cube->slices[i];
+
+		ranges = lappend(ranges, make_int8_const(slice->fd.dimension_id));
+		ranges = lappend(ranges, make_int8_const(slice->fd.range_start));
+		ranges = lappend(ranges, make_int8_const(slice->fd.range_end));
+	}
+
+	return ranges;
+}
+
+static Hypercube *
+chunk_ranges_from_list(List *ranges, int32 *chunk_id)
+{
+	Hypercube  *cube = hypercube_alloc(list_length(ranges) / 3);
+	ListCell   *lc = lnext(list_head(ranges));
+
+	*chunk_id = DatumGetInt64(((Const *) linitial(ranges))->constvalue);
+
+	while (lc != NULL)
+	{
+		int32		dimension_id = DatumGetInt64(((Const *) lfirst(lc))->constvalue);
+		int64		range_start = DatumGetInt64(((Const *) lfirst(lnext(lc)))->constvalue);
+		int64		range_end = DatumGetInt64(((Const *) lfirst(lnext(lnext(lc))))->constvalue);
+
+		hypercube_add_slice(cube, dimension_slice_create(dimension_id, range_start, range_end));
+		lc = lnext(lnext(lnext(lc)));
+	}
+
+	return cube;
+}
+
+/*
+ * The restriction clauses and AppendRelInfos are passed as plain expressions
+ * and constants, too. Parallel workers receive the plan as a string, and
+ * PostgreSQL cannot read RestrictInfo and AppendRelInfo nodes back.
+ */
+static List *
+restrictinfos_to_list(List *restrictinfos)
+{
+	List	   *clauses = NIL;
+	ListCell   *lc;
+
+	foreach(lc, restrictinfos)
+		clauses = lappend(clauses, ((RestrictInfo *) lfirst(lc))->clause);
+
+	return clauses;
+}
+
+static List *
+restrictinfos_from_list(List *clauses)
+{
+	List	   *restrictinfos = NIL;
+	ListCell   *lc;
+
+	foreach(lc, clauses)
+	{
+		RestrictInfo *rinfo = makeNode(RestrictInfo);
+
+		rinfo->clause = lfirst(lc);
+		restrictinfos = lappend(restrictinfos, rinfo);
+	}
+
+	return restrictinfos;
+}
+
+static List *
+appinfo_to_list(AppendRelInfo *appinfo)
+{
+	return lappend(list_make4(make_int8_const(appinfo->parent_relid),
+							  make_int8_const(appinfo->child_relid),
+							  make_int8_const(appinfo->parent_reltype),
+							  make_int8_const(appinfo->child_reltype)),
+				   appinfo->translated_vars);
+}
+
+static AppendRelInfo *
+appinfo_from_list(List *list)
+{
+	AppendRelInfo *appinfo = makeNode(AppendRelInfo);
+
+	appinfo->parent_relid = DatumGetInt64(((Const *) linitial(list))->constvalue);
+	appinfo->child_relid = DatumGetInt64(((Const *) lsecond(list))->constvalue);
+	appinfo->parent_reltype = DatumGetInt64(((Const *) lthird(list))->constvalue);
+	appinfo->child_reltype = DatumGetInt64(((Const *) lfourth(list))->constvalue);
+	appinfo->translated_vars = list_nth(list, 4);
+
+	return appinfo;
+}
+
 /*
  * Convert restriction clauses to constants expressions (i.e., if there are
  * mutable functions, they need to be evaluated to constants).  For instance,
@@ -77,9 +568,12 @@ excluded_by_constraint(RangeTblEntry *rte, AppendRelInfo *appinfo, List *restric
  * becomes
  *
  * ...WHERE time > '2017-06-02 11:26:43.935712+02'
+ *
+ * External parameters (e.g., those of a generic prepared statement) are
+ * replaced by their values when given.
  */
 static List *
-constify_restrictinfos(List *restrictinfos)
+constify_restrictinfos(List *restrictinfos, ParamListInfo params)
 {
 	List	   *newinfos = NIL;
 	ListCell   *lc;
@@ -87,7 +581,7 @@ constify_restrictinfos(List *restrictinfos)
 		.resultRelation = InvalidOid,
 	};
 	PlannerGlobal glob = {
-		.boundParams = NULL,
+		.boundParams = params,
 	};
 	PlannerInfo root = {
 		.glob = &glob,
@@ -107,10 +601,163 @@ constify_restrictinfos(List *restrictinfos)
 	return newinfos;
 }
 
+static bool
+contain_exec_param_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Param))
+		return ((Param *) node)->paramkind == PARAM_EXEC;
+
+	return expression_tree_walker(node, contain_exec_param_walker, context);
+}
+
+/*
+ * Replace executor parameters with their current values. These are, e.g., the
+ * values of the outer side of a nested loop join or the results of initplans,
+ * which are only known at execution time and change across rescans.
+ */
+static Node *
+replace_exec_params_mutator(Node *node, ExprContext *econtext)
+{
+	if (node == NULL)
+		return NULL;
+
+	if (IsA(node, Param) && ((Param *) node)->paramkind == PARAM_EXEC)
+	{
+		Param	   *param = (Param *) node;
+		ParamExecData *prm = &econtext->ecxt_param_exec_vals[param->paramid];
+		int16		typlen;
+		bool		typbyval;
+
+		/* Evaluate the initplan that computes the parameter, if necessary */
+		if (prm->execPlan != NULL)
+			ExecSetParamPlan(prm->execPlan, econtext);
+
+		get_typlenbyval(param->paramtype, &typlen, &typbyval);
+
+		return (Node *) makeConst(param->paramtype,
+								  param->paramtypmod,
+								  param->paramcollid,
+								  (int) typlen,
+								  prm->value,
+								  prm->isnull,
+								  typbyval);
+	}
+
+	return expression_tree_mutator(node, replace_exec_params_mutator, (void *) econtext);
+}
+
+/*
+ * The shared state of a parallel scan: the next child to claim, as an index
+ * into the children that remain after exclusion. All processes exclude the
+ * same children, so the index means the same child in every process.
+ */
+typedef struct ConstraintAwareAppendShared
+{
+	pg_atomic_uint32 next_child;
+} ConstraintAwareAppendShared;
+
+/* Add the time since start to the time spent excluding children */
+static void
+ca_append_add_time(ConstraintAwareAppendState *state, instr_time start)
+{
+	instr_time	end;
+
+	INSTR_TIME_SET_CURRENT(end);
+	INSTR_TIME_ACCUM_DIFF(state->exclusion_time, end, start);
+}
+
+/*
+ * Set the children that the Append (or MergeAppend) node below us will
+ * scan. Only the array of child states is swapped; the children themselves
+ * are all initialized in ca_append_begin().
+ */
+static void
+ca_append_set_children(ConstraintAwareAppendState *state, PlanState **children, int num_children)
+{
+	PlanState  *ps = linitial(state->csstate.custom_ps);
+
+	switch (nodeTag(ps))
+	{
+		case T_AppendState:
+			((AppendState *) ps)->appendplans = children;
+			((AppendState *) ps)->as_nplans = num_children;
+			break;
+		case T_MergeAppendState:
+			((MergeAppendState *) ps)->mergeplans = children;
+			((MergeAppendState *) ps)->ms_nplans = num_children;
+			break;
+		default:
+			elog(ERROR, "invalid plan state %d", nodeTag(ps));
+	}
+
+	state->num_active_children = num_children;
+}
+
+/*
+ * Re-evaluate the exclusion of the children with the current values of the
+ * executor parameters and only scan the ones that remain.
+ */
+static void
+ca_append_runtime_exclusion(ConstraintAwareAppendState *state)
+{
+	CustomScanState *node = &state->csstate;
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	List	   *restrictinfos = NIL;
+	DimensionExclusion de;
+	MemoryContext old;
+	ListCell   *lc;
+	instr_time	start;
+	int			num_active = 0;
+	int			i;
+
+	if (state->track_time)
+		INSTR_TIME_SET_CURRENT(start);
+
+	MemoryContextReset(state->exclusion_mcxt);
+	old = MemoryContextSwitchTo(state->exclusion_mcxt);
+
+	foreach(lc, state->restrictinfos)
+	{
+		RestrictInfo *rinfo = makeNode(RestrictInfo);
+
+		rinfo->clause = (Expr *) replace_exec_params_mutator((Node *) ((RestrictInfo *) lfirst(lc))->clause,
+															 econtext);
+		restrictinfos = lappend(restrictinfos, rinfo);
+	}
+
+	restrictinfos = constify_restrictinfos(restrictinfos, node->ss.ps.state->es_param_list_info);
+	dimension_exclusion_begin(&de, state, restrictinfos);
+
+	for (i = 0; i < state->num_children; i++)
+	{
+		if (state->child_appinfos[i] == NULL ||
+			!child_excluded(&de, state->child_rtes[i], state->child_appinfos[i],
+							state->child_cubes[i], state->child_chunk_ids[i], restrictinfos))
+			state->active_children[num_active++] = state->children[i];
+	}
+
+	dimension_exclusion_end(&de);
+	MemoryContextSwitchTo(old);
+
+	ca_append_set_children(state, state->active_children, num_active);
+	state->num_runtime_excluded += state->num_children - num_active;
+
+	if (state->track_time)
+		ca_append_add_time(state, start);
+}
+
 /*
  * Initialize the scan state and prune any subplans from the Append node below
- * us in the plan tree. Pruning happens by evaluating the subplan's table
- * constraints against a folded version of the restriction clauses in the query.
+ * us in the plan tree. Pruning happens by comparing the dimension ranges of
+ * chunks with, or by evaluating the subplan's table constraints against, a
+ * folded version of the restriction clauses in the query.
+ *
+ * Clauses that reference executor parameters cannot be folded here. For those,
+ * the remaining subplans are pruned again on every rescan, once the
+ * parameters have values.
  */
 static void
 ca_append_begin(CustomScanState *node, EState *estate, int eflags)
@@ -118,12 +765,45 @@ ca_append_begin(CustomScanState *node, EState *estate, int eflags)
 	ConstraintAwareAppendState *state = (ConstraintAwareAppendState *) node;
 	CustomScan *cscan = (CustomScan *) node->ss.ps.plan;
 	Plan	   *subplan = copyObject(state->subplan);
-	List	   *append_rel_info = lsecond(cscan->custom_private);
-	List	   *restrictinfos = constify_restrictinfos(lthird(cscan->custom_private));
+	List	   *append_rel_info = NIL;
+	List	   *clauses = restrictinfos_from_list(lthird(cscan->custom_private));
+	List	   *restrictinfos;
+	List	   *child_ranges = lfourth(cscan->custom_private);
 	List	  **appendplans,
-			   *old_appendplans;
+			   *old_appendplans,
+			   *rtes = NIL,
+			   *appinfos = NIL,
+			   *cubes = NIL,
+			   *chunk_ids = NIL;
 	ListCell   *lc_plan,
-			   *lc_info;
+			   *lc_info,
+			   *lc_rte,
+			   *lc_ranges;
+	DimensionExclusion de;
+	PlanState  *ps;
+	instr_time	start;
+	int			i;
+
+	state->track_time = (estate->es_instrument & INSTRUMENT_TIMER) != 0;
+
+	if (state->track_time)
+		INSTR_TIME_SET_CURRENT(start);
+
+	if (list_length(cscan->custom_private) > 5)
+		state->num_plan_excluded = DatumGetInt64(((Const *) list_nth(cscan->custom_private, 5))->constvalue);
+
+	/*
+	 * The initplans that compute the bounds from join clauses only run in the
+	 * leader, so their parameters have no values in parallel workers
+	 */
+	if (!IsParallelWorker())
+		clauses = list_concat(clauses,
+							  restrictinfos_from_list(list_nth(cscan->custom_private, 4)));
+
+	restrictinfos = constify_restrictinfos(clauses, estate->es_param_list_info);
+
+	foreach(lc_info, lsecond(cscan->custom_private))
+		append_rel_info = lappend(append_rel_info, appinfo_from_list(lfirst(lc_info)));
 
 	switch (nodeTag(subplan))
 	{
@@ -155,49 +835,261 @@ ca_append_begin(CustomScanState *node, EState *estate, int eflags)
 			 */
 			return;
 		default:
-			elog(ERROR, "Invalid plan %d", nodeTag(subplan));
+			elog(ERROR, "Invalid plan %d", nodeTag(subplan));
+	}
+
+	state->hypertable_relid = linitial_oid(linitial(cscan->custom_private));
+
+	if (append_rel_info != NIL)
+		state->parent_relid = ((AppendRelInfo *) linitial(append_rel_info))->parent_relid;
+
+	state->chunk_time_ranges = chunk_time_range_htab_create();
+	state->chunk_bloom_filters = chunk_bloom_filter_htab_create();
+	dimension_exclusion_begin(&de, state, restrictinfos);
+
+	forthree(lc_plan, old_appendplans, lc_info, append_rel_info, lc_ranges, child_ranges)
+	{
+		Scan	   *scan = lfirst(lc_plan);
+		AppendRelInfo *appinfo = lfirst(lc_info);
+		RangeTblEntry *rte = NULL;
+		Hypercube  *cube = NULL;
+		int32		chunk_id = 0;
+
+		switch (nodeTag(scan))
+		{
+			case T_SeqScan:
+			case T_SampleScan:
+			case T_IndexScan:
+			case T_IndexOnlyScan:
+			case T_BitmapIndexScan:
+			case T_BitmapHeapScan:
+			case T_TidScan:
+			case T_SubqueryScan:
+			case T_FunctionScan:
+			case T_ValuesScan:
+			case T_CteScan:
+			case T_WorkTableScan:
+			case T_ForeignScan:
+			case T_CustomScan:
+
+				/*
+				 * If this is a base rel (chunk), check if it can be excluded
+				 * from the scan. Otherwise, fall through.
+				 */
+				rte = rt_fetch(scan->scanrelid, estate->es_range_table);
+
+				if (rte->rtekind != RTE_RELATION ||
+					rte->relkind != RELKIND_RELATION ||
+					rte->inh)
+					rte = NULL;
+				else
+				{
+					if (lfirst(lc_ranges) != NIL)
+						cube = chunk_ranges_from_list(lfirst(lc_ranges), &chunk_id);
+
+					if (child_excluded(&de, rte, appinfo, cube, chunk_id, restrictinfos))
+						break;
+				}
+			default:
+				*appendplans = lappend(*appendplans, scan);
+				rtes = lappend(rtes, rte);
+				appinfos = lappend(appinfos, rte == NULL ? NULL : appinfo);
+				cubes = lappend(cubes, cube);
+				chunk_ids = lappend_int(chunk_ids, chunk_id);
+		}
+	}
+
+	dimension_exclusion_end(&de);
+
+	state->num_append_subplans = list_length(*appendplans);
+	state->num_startup_excluded = list_length(old_appendplans) - state->num_append_subplans;
+
+	if (state->track_time)
+		ca_append_add_time(state, start);
+
+	if (state->num_append_subplans == 0)
+		return;
+
+	ps = ExecInitNode(subplan, estate, eflags);
+	node->custom_ps = list_make1(ps);
+
+	switch (nodeTag(ps))
+	{
+		case T_AppendState:
+			state->children = ((AppendState *) ps)->appendplans;
+			break;
+		case T_MergeAppendState:
+			state->children = ((MergeAppendState *) ps)->mergeplans;
+			break;
+		default:
+			elog(ERROR, "invalid plan state %d", nodeTag(ps));
+	}
+
+	state->num_children = state->num_active_children = state->num_append_subplans;
+
+	/*
+	 * The children of an Append node are scanned one after the other, so the
+	 * next one can be read ahead. A MergeAppend node reads all of its
+	 * children from the start.
+	 */
+	if (IsA(ps, AppendState) && target_prefetch_pages > 0)
+		state->prefetch_blocks = guc_chunk_prefetch_blocks;
+
+	foreach(lc_info, clauses)
+	{
+		RestrictInfo *rinfo = lfirst(lc_info);
+
+		if (contain_exec_param_walker((Node *) rinfo->clause, NULL))
+		{
+			state->runtime_exclusion = true;
+			break;
+		}
+	}
+
+	if (!state->runtime_exclusion)
+		return;
+
+	/*
+	 * Keep what is needed to exclude the remaining children again once the
+	 * executor parameters are known. This first happens on the first rescan
+	 * or, failing that, when the first tuple is requested.
+	 */
+	state->runtime_pending = true;
+	state->restrictinfos = clauses;
+	state->active_children = palloc(sizeof(PlanState *) * state->num_children);
+	state->child_rtes = palloc(sizeof(RangeTblEntry *) * state->num_children);
+	state->child_appinfos = palloc(sizeof(AppendRelInfo *) * state->num_children);
+	state->child_cubes = palloc(sizeof(Hypercube *) * state->num_children);
+	state->child_chunk_ids = palloc(sizeof(int32) * state->num_children);
+	state->exclusion_mcxt = AllocSetContextCreate(CurrentMemoryContext,
+												  "ConstraintAwareAppend exclusion",
+												  ALLOCSET_DEFAULT_SIZES);
+	i = 0;
+
+	forthree(lc_rte, rtes, lc_info, appinfos, lc_ranges, cubes)
+	{
+		state->child_rtes[i] = lfirst(lc_rte);
+		state->child_appinfos[i] = lfirst(lc_info);
+		state->child_cubes[i] = lfirst(lc_ranges);
+		i++;
+	}
+
+	i = 0;
+
+	foreach(lc_ranges, chunk_ids)
+		state->child_chunk_ids[i++] = lfirst_int(lc_ranges);
+}
+
+/*
+ * Hint the operating system to read the blocks of a relation that a scan in
+ * the given direction reads first.
+ */
+static void
+prefetch_relation_blocks(Relation rel, int num_blocks, ScanDirection direction)
+{
+	BlockNumber nblocks = RelationGetNumberOfBlocks(rel);
+	BlockNumber start = 0;
+	BlockNumber end = Min(nblocks, (BlockNumber) num_blocks);
+	BlockNumber blkno;
+
+	if (ScanDirectionIsBackward(direction))
+	{
+		start = nblocks - end;
+		end = nblocks;
+	}
+
+	for (blkno = start; blkno < end; blkno++)
+		PrefetchBuffer(rel, MAIN_FORKNUM, blkno);
+}
+
+/*
+ * Prefetch the first blocks that the scan of a child reads. Sequential and
+ * bitmap heap scans start at the beginning of the heap. Index scans start at
+ * either end of the index, depending on the direction, and the heap of
+ * chunks that are filled in time order is read in about the same order.
+ * Other children are not prefetched.
+ */
+static void
+ca_append_prefetch_child(PlanState *ps, int num_blocks)
+{
+	switch (nodeTag(ps))
+	{
+		case T_SeqScanState:
+		case T_BitmapHeapScanState:
+			prefetch_relation_blocks(((ScanState *) ps)->ss_currentRelation, num_blocks,
+									 ForwardScanDirection);
+			break;
+		case T_IndexScanState:
+			{
+				IndexScanState *iss = (IndexScanState *) ps;
+				ScanDirection direction = ((IndexScan *) ps->plan)->indexorderdir;
+
+				prefetch_relation_blocks(iss->iss_RelationDesc, num_blocks, direction);
+				prefetch_relation_blocks(iss->ss.ss_currentRelation, num_blocks, direction);
+				break;
+			}
+		case T_IndexOnlyScanState:
+			{
+				IndexOnlyScanState *ioss = (IndexOnlyScanState *) ps;
+
+				prefetch_relation_blocks(ioss->ioss_RelationDesc, num_blocks,
+										 ((IndexOnlyScan *) ps->plan)->indexorderdir);
+				break;
+			}
+		default:
+			break;
 	}
+}
 
-	forboth(lc_plan, old_appendplans, lc_info, append_rel_info)
-	{
-		Scan	   *scan = lfirst(lc_plan);
-		AppendRelInfo *appinfo = lfirst(lc_info);
-		RangeTblEntry *rte = rt_fetch(scan->scanrelid, estate->es_range_table);
+/*
+ * Prefetch the child that the Append node below us scans after the current
+ * one, so that its first reads do not stall the scan at the chunk boundary.
+ * Each child is prefetched once per scan, when the scan of the preceding
+ * child starts.
+ */
+static void
+ca_append_prefetch(ConstraintAwareAppendState *state)
+{
+	AppendState *astate = linitial(state->csstate.custom_ps);
+	int			next = astate->as_whichplan + 1;
 
-		switch (nodeTag(scan))
+	if (next <= state->prefetched_child || next >= astate->as_nplans)
+		return;
+
+	state->prefetched_child = next;
+	ca_append_prefetch_child(astate->appendplans[next], state->prefetch_blocks);
+}
+
+/*
+ * Get the next tuple of a parallel scan. Instead of running the Append node
+ * below us, each process runs the child it has claimed until it is
+ * exhausted, and then claims the next child that no process has claimed yet.
+ */
+static TupleTableSlot *
+ca_append_exec_parallel(ConstraintAwareAppendState *state)
+{
+	PlanState **children = state->runtime_exclusion ? state->active_children : state->children;
+	TupleTableSlot *subslot;
+
+	while (true)
+	{
+		if (state->current_child < 0)
 		{
-			case T_SeqScan:
-			case T_SampleScan:
-			case T_IndexScan:
-			case T_IndexOnlyScan:
-			case T_BitmapIndexScan:
-			case T_BitmapHeapScan:
-			case T_TidScan:
-			case T_SubqueryScan:
-			case T_FunctionScan:
-			case T_ValuesScan:
-			case T_CteScan:
-			case T_WorkTableScan:
-			case T_ForeignScan:
-			case T_CustomScan:
+			uint32		next = pg_atomic_fetch_add_u32(&state->pstate->next_child, 1);
 
-				/*
-				 * If this is a base rel (chunk), check if it can be excluded
-				 * from the scan. Otherwise, fall through.
-				 */
-				if (rte->rtekind == RTE_RELATION &&
-					rte->relkind == RELKIND_RELATION &&
-					!rte->inh &&
-					excluded_by_constraint(rte, appinfo, restrictinfos))
-					break;
-			default:
-				*appendplans = lappend(*appendplans, scan);
+			if (next >= (uint32) state->num_active_children)
+				return NULL;
+
+			state->current_child = next;
 		}
-	}
 
-	state->num_append_subplans = list_length(*appendplans);
-	if (state->num_append_subplans > 0)
-		node->custom_ps = list_make1(ExecInitNode(subplan, estate, eflags));
+		subslot = ExecProcNode(children[state->current_child]);
+
+		if (!TupIsNull(subslot))
+			return subslot;
+
+		state->current_child = -1;
+	}
 }
 
 static TupleTableSlot *
@@ -218,6 +1110,16 @@ ca_append_exec(CustomScanState *node)
 	if (state->num_append_subplans == 0)
 		return NULL;
 
+	if (state->runtime_pending)
+	{
+		ca_append_runtime_exclusion(state);
+		state->runtime_pending = false;
+	}
+
+	/* All remaining subplans might have been pruned at run time */
+	if (state->num_active_children == 0)
+		return NULL;
+
 #if PG96
 	if (node->ss.ps.ps_TupFromTlist)
 	{
@@ -234,7 +1136,15 @@ ca_append_exec(CustomScanState *node)
 
 	while (true)
 	{
-		subslot = ExecProcNode(linitial(node->custom_ps));
+		if (state->pstate != NULL)
+			subslot = ca_append_exec_parallel(state);
+		else
+		{
+			subslot = ExecProcNode(linitial(node->custom_ps));
+
+			if (state->prefetch_blocks > 0)
+				ca_append_prefetch(state);
+		}
 
 		if (TupIsNull(subslot))
 			return NULL;
@@ -261,21 +1171,58 @@ ca_append_exec(CustomScanState *node)
 static void
 ca_append_end(CustomScanState *node)
 {
+	ConstraintAwareAppendState *state = (ConstraintAwareAppendState *) node;
+
 	if (node->custom_ps != NIL)
 	{
+		/* Make sure all children are shut down, not only the active ones */
+		if (state->runtime_exclusion)
+			ca_append_set_children(state, state->children, state->num_children);
+
 		ExecEndNode(linitial(node->custom_ps));
 	}
+
+	if (state->exclusion_mcxt != NULL)
+		MemoryContextDelete(state->exclusion_mcxt);
 }
 
 static void
 ca_append_rescan(CustomScanState *node)
 {
+	ConstraintAwareAppendState *state = (ConstraintAwareAppendState *) node;
+
 #if PG96
 	node->ss.ps.ps_TupFromTlist = false;
+
+	/*
+	 * PostgreSQL 9.6 has no callback to reinitialize the shared state. Like
+	 * parallel sequential scans in 9.6, the leader resets it on rescan, when
+	 * the workers have already been shut down.
+	 */
+	if (state->pstate != NULL)
+		pg_atomic_write_u32(&state->pstate->next_child, 0);
 #endif
+	state->current_child = -1;
+	state->prefetched_child = 0;
+
 	if (node->custom_ps != NIL)
 	{
-		ExecReScan(linitial(node->custom_ps));
+		PlanState  *ps = linitial(node->custom_ps);
+
+		/*
+		 * Exclude before rescanning the Append node below so that only the
+		 * children that remain are rescanned.
+		 */
+		if (state->runtime_exclusion)
+		{
+			ca_append_runtime_exclusion(state);
+			state->runtime_pending = false;
+		}
+
+		if (node->ss.ps.chgParam != NULL)
+			UpdateChangedParamSet(ps, node->ss.ps.chgParam);
+
+		ExecReScan(ps);
 	}
 }
 
@@ -288,10 +1235,62 @@ ca_append_explain(CustomScanState *node,
 	ConstraintAwareAppendState *state = (ConstraintAwareAppendState *) node;
 	Oid			relid = linitial_oid(linitial(cscan->custom_private));
 
+	/* Explain all children, including those excluded at run time */
+	if (state->runtime_exclusion)
+		ca_append_set_children(state, state->children, state->num_children);
+
 	ExplainPropertyText("Hypertable", get_rel_name(relid), es);
 	ExplainPropertyInteger("Chunks left after exclusion", state->num_append_subplans, es);
+
+	/*
+	 * Chunks excluded at run time are counted on every rescan. Chunks that
+	 * the planner excluded through their dimension slices, before adding them
+	 * to the query, are not counted at all.
+	 */
+	if (es->analyze)
+	{
+		ExplainPropertyInteger("Chunks excluded during planning", state->num_plan_excluded, es);
+		ExplainPropertyInteger("Chunks excluded during startup", state->num_startup_excluded, es);
+		ExplainPropertyLong("Chunks excluded during runtime", state->num_runtime_excluded, es);
+
+		if (es->timing)
+			ExplainPropertyFloat("Exclusion time", INSTR_TIME_GET_MILLISEC(state->exclusion_time), 3, es);
+	}
+}
+
+static Size
+ca_append_estimate_dsm(CustomScanState *node, ParallelContext *pcxt)
+{
+	return sizeof(ConstraintAwareAppendShared);
+}
+
+static void
+ca_append_initialize_dsm(CustomScanState *node, ParallelContext *pcxt, void *coordinate)
+{
+	ConstraintAwareAppendState *state = (ConstraintAwareAppendState *) node;
+	ConstraintAwareAppendShared *shared = coordinate;
+
+	pg_atomic_init_u32(&shared->next_child, 0);
+	state->pstate = shared;
 }
 
+#if PG10
+static void
+ca_append_reinitialize_dsm(CustomScanState *node, ParallelContext *pcxt, void *coordinate)
+{
+	ConstraintAwareAppendShared *shared = coordinate;
+
+	pg_atomic_write_u32(&shared->next_child, 0);
+}
+#endif
+
+static void
+ca_append_initialize_worker(CustomScanState *node, shm_toc *toc, void *coordinate)
+{
+	ConstraintAwareAppendState *state = (ConstraintAwareAppendState *) node;
+
+	state->pstate = coordinate;
+}
 
 static CustomExecMethods constraint_aware_append_state_methods = {
 	.BeginCustomScan = ca_append_begin,
@@ -299,6 +1298,12 @@ static CustomExecMethods constraint_aware_append_state_methods = {
 	.EndCustomScan = ca_append_end,
 	.ReScanCustomScan = ca_append_rescan,
 	.ExplainCustomScan = ca_append_explain,
+	.EstimateDSMCustomScan = ca_append_estimate_dsm,
+	.InitializeDSMCustomScan = ca_append_initialize_dsm,
+#if PG10
+	.ReInitializeDSMCustomScan = ca_append_reinitialize_dsm,
+#endif
+	.InitializeWorkerCustomScan = ca_append_initialize_worker,
 };
 
 static Node *
@@ -311,6 +1316,7 @@ constraint_aware_append_state_create(CustomScan *cscan)
 												   T_CustomScanState);
 	state->csstate.methods = &constraint_aware_append_state_methods;
 	state->subplan = &append->plan;
+	state->current_child = -1;
 
 	return (Node *) state;
 }
@@ -320,6 +1326,144 @@ static CustomScanMethods constraint_aware_append_plan_methods = {
 	.CreateCustomScanState = constraint_aware_append_state_create,
 };
 
+/*
+ * Replace Vars that reference outer relations with nestloop parameters, like
+ * the planner does for the quals of a parameterized scan. The planner does not
+ * process custom_private, so the clauses we exclude on at run time need to be
+ * fixed up here.
+ */
+static Node *
+replace_nestloop_params_mutator(Node *node, PlannerInfo *root)
+{
+	if (node == NULL)
+		return NULL;
+
+	if (IsA(node, Var))
+	{
+		Var		   *var = (Var *) node;
+		Param	   *param;
+		NestLoopParam *nlp;
+		ListCell   *lc;
+
+		if (!bms_is_member(var->varno, root->curOuterRels))
+			return node;
+
+		param = assign_nestloop_param_var(root, var);
+
+		foreach(lc, root->curOuterParams)
+		{
+			nlp = lfirst(lc);
+
+			if (nlp->paramno == param->paramid)
+				return (Node *) param;
+		}
+
+		nlp = makeNode(NestLoopParam);
+		nlp->paramno = param->paramid;
+		nlp->paramval = var;
+		root->curOuterParams = lappend(root->curOuterParams, nlp);
+
+		return (Node *) param;
+	}
+
+	/*
+	 * PlaceHolderVars are left as is. Clauses that contain them cannot be used
+	 * for exclusion.
+	 */
+	if (IsA(node, PlaceHolderVar))
+		return node;
+
+	return expression_tree_mutator(node, replace_nestloop_params_mutator, (void *) root);
+}
+
+static List *
+replace_nestloop_params(PlannerInfo *root, List *restrictinfos)
+{
+	List	   *newinfos = NIL;
+	ListCell   *lc;
+
+	foreach(lc, restrictinfos)
+	{
+		RestrictInfo *old = lfirst(lc);
+		RestrictInfo *rinfo = makeNode(RestrictInfo);
+
+		rinfo->clause = (Expr *) replace_nestloop_params_mutator((Node *) old->clause, root);
+		newinfos = lappend(newinfos, rinfo);
+	}
+
+	return newinfos;
+}
+
+/*
+ * Get the AppendRelInfos of the Append's children, in the order of its
+ * subpaths (and subplans). The append_rel_list of the planner can also hold
+ * children of other append relations in the query.
+ */
+static List *
+get_child_appinfos(PlannerInfo *root, Path *subpath)
+{
+	List	   *subpaths;
+	List	   *appinfos = NIL;
+	ListCell   *lc;
+
+	switch (nodeTag(subpath))
+	{
+		case T_AppendPath:
+			subpaths = ((AppendPath *) subpath)->subpaths;
+			break;
+		case T_MergeAppendPath:
+			subpaths = ((MergeAppendPath *) subpath)->subpaths;
+			break;
+		default:
+			elog(ERROR, "Invalid node type %u", nodeTag(subpath));
+			return NIL;
+	}
+
+	foreach(lc, subpaths)
+	{
+		Path	   *childpath = lfirst(lc);
+
+		appinfos = lappend(appinfos, find_childrel_appendrelinfo(root, childpath->parent));
+	}
+
+	return appinfos;
+}
+
+/*
+ * Get the dimension ranges of the children that are chunks, in the order of
+ * the children.
+ */
+static List *
+get_child_ranges(PlannerInfo *root, Oid hypertable_relid, List *appinfos)
+{
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = hypertable_cache_get_entry(hcache, hypertable_relid);
+	List	   *ranges = NIL;
+	HTAB	   *htab = NULL;
+	ListCell   *lc;
+
+	if (NULL != ht)
+		htab = chunk_relid_htab_create(ht->fd.id, ht->space->num_dimensions);
+
+	foreach(lc, appinfos)
+	{
+		AppendRelInfo *appinfo = lfirst(lc);
+		Chunk	   *chunk = NULL;
+
+		if (NULL != htab)
+			chunk = chunk_relid_htab_lookup(htab, planner_rt_fetch(appinfo->child_relid, root)->relid);
+
+		ranges = lappend(ranges, NULL == chunk ? NIL : chunk_ranges_to_list(chunk));
+	}
+
+	if (NULL != htab)
+		hash_destroy(htab);
+
+	cache_release(hcache);
+
+	return ranges;
+}
+
 static Plan *
 constraint_aware_append_plan_create(PlannerInfo *root,
 									RelOptInfo *rel,
@@ -331,13 +1475,70 @@ constraint_aware_append_plan_create(PlannerInfo *root,
 	CustomScan *cscan = makeNode(CustomScan);
 	Plan	   *subplan = linitial(custom_plans);
 	RangeTblEntry *rte = planner_rt_fetch(rel->relid, root);
+	List	   *appinfos = get_child_appinfos(root, linitial(path->custom_paths));
+	List	   *appinfo_lists = NIL;
+	List	   *join_bounds = NIL;
+	ListCell   *lc;
+	int			num_children = 0;
+
+	/*
+	 * A parameterized path also enforces the join clauses of the outer
+	 * relations, which can exclude chunks on each rescan
+	 */
+	if (path->path.param_info != NULL)
+		clauses = replace_nestloop_params(root, clauses);
+	else
+		clauses = list_copy(clauses);
+
+	foreach(lc, appinfos)
+		appinfo_lists = lappend(appinfo_lists, appinfo_to_list(lfirst(lc)));
+
+	/*
+	 * Children that are not in the Append were excluded by the planner. The
+	 * main table is not counted, whether it is in the Append or not.
+	 */
+	foreach(lc, root->append_rel_list)
+	{
+		AppendRelInfo *appinfo = lfirst(lc);
+
+		if (appinfo->parent_relid == rel->relid &&
+			planner_rt_fetch(appinfo->child_relid, root)->relid != rte->relid)
+			num_children++;
+	}
+
+	foreach(lc, appinfos)
+	{
+		AppendRelInfo *appinfo = lfirst(lc);
+
+		if (planner_rt_fetch(appinfo->child_relid, root)->relid == rte->relid)
+			num_children++;
+	}
+
+	/*
+	 * Bounds from join clauses are computed by initplans. The processes of a
+	 * parallel scan must exclude the same children, so they cannot use them.
+	 */
+	if (guc_runtime_join_exclusion && !path->path.parallel_aware)
+	{
+		Cache	   *hcache = hypertable_cache_pin();
+		Hypertable *ht = hypertable_cache_get_entry(hcache, rte->relid);
+
+		if (NULL != ht)
+			join_bounds = plan_join_exclusion_clauses(root, rel, ht, &path->path);
+
+		cache_release(hcache);
+	}
 
 	cscan->scan.scanrelid = 0;	/* Not a real relation we are scanning */
 	cscan->scan.plan.targetlist = tlist;	/* Target list we expect as output */
 	cscan->custom_plans = custom_plans;
-	cscan->custom_private = list_make3(list_make1_oid(rte->relid),
-									   list_copy(root->append_rel_list),
-									   list_copy(clauses));
+	cscan->custom_private = lappend(list_make4(list_make1_oid(rte->relid),
+											   appinfo_lists,
+											   restrictinfos_to_list(clauses),
+											   get_child_ranges(root, rte->relid, appinfos)),
+									join_bounds);
+	cscan->custom_private = lappend(cscan->custom_private,
+									make_int8_const(num_children - list_length(appinfos)));
 	cscan->custom_scan_tlist = subplan->targetlist; /* Target list of tuples
 													 * we expect as input */
 	cscan->flags = path->flags;
@@ -366,12 +1567,10 @@ remove_parent_subpath(PlannerInfo *root, List *subpaths, Oid parent_relid)
 	return subpaths;
 }
 
-Path *
-constraint_aware_append_path_create(PlannerInfo *root, Hypertable *ht, Path *subpath)
+static ConstraintAwareAppendPath *
+ca_append_path_alloc(Path *subpath)
 {
 	ConstraintAwareAppendPath *path;
-	AppendRelInfo *appinfo;
-	Oid			relid;
 
 	path = (ConstraintAwareAppendPath *) newNode(sizeof(ConstraintAwareAppendPath), T_CustomPath);
 	path->cpath.path.pathtype = T_CustomScan;
@@ -395,10 +1594,24 @@ constraint_aware_append_path_create(PlannerInfo *root, Hypertable *ht, Path *sub
 	path->cpath.custom_paths = list_make1(subpath);
 	path->cpath.methods = &constraint_aware_append_path_methods;
 
+	return path;
+}
+
+Path *
+constraint_aware_append_path_create(PlannerInfo *root, Hypertable *ht, Path *subpath)
+{
+	ConstraintAwareAppendPath *path = ca_append_path_alloc(subpath);
+	AppendRelInfo *appinfo;
+	Oid			relid;
+
 	/*
 	 * Remove the main table from the append_rel_list and Append's subpaths
-	 * since it cannot contain any tuples
+	 * since it cannot contain any tuples, unless it still holds the data of
+	 * a deferred migration
 	 */
+	if (hypertable_has_deferred_data(ht))
+		return &path->cpath.path;
+
 	switch (nodeTag(subpath))
 	{
 		case T_AppendPath:
@@ -428,3 +1641,89 @@ constraint_aware_append_path_create(PlannerInfo *root, Hypertable *ht, Path *sub
 
 	return &path->cpath.path;
 }
+
+/*
+ * Same as get_parallel_divisor() in costsize.c: the leader also runs the
+ * plan, but less so the more workers there are to read tuples from.
+ */
+static double
+parallel_divisor(int parallel_workers)
+{
+	double		divisor = parallel_workers;
+	double		leader_contribution = 1.0 - (0.3 * parallel_workers);
+
+	if (leader_contribution > 0)
+		divisor += leader_contribution;
+
+	return divisor;
+}
+
+/*
+ * Create a partial path that distributes the chunks of a hypertable among the
+ * processes of a parallel query.
+ *
+ * A parallel Append of partial scans has every process take part in the scan
+ * of every chunk. That is costly for many small chunks, since each partial
+ * scan has its own startup. Instead, the processes claim whole chunks, after
+ * exclusion, and scan each with its cheapest regular path. Returns NULL if a
+ * chunk cannot be scanned in a parallel query.
+ */
+Path *
+constraint_aware_append_parallel_path_create(PlannerInfo *root, Hypertable *ht, RelOptInfo *rel)
+{
+	ConstraintAwareAppendPath *path;
+	AppendPath *append;
+	List	   *subpaths = NIL;
+	ListCell   *lc;
+	int			parallel_workers;
+	double		divisor;
+	bool		has_deferred_data = hypertable_has_deferred_data(ht);
+
+	foreach(lc, root->append_rel_list)
+	{
+		AppendRelInfo *appinfo = lfirst(lc);
+		RelOptInfo *childrel;
+		Path	   *childpath;
+
+		if (appinfo->parent_relid != rel->relid)
+			continue;
+
+		childrel = root->simple_rel_array[appinfo->child_relid];
+
+		/* The main table only holds the tuples of a deferred migration */
+		if (IS_DUMMY_REL(childrel) ||
+			(root->simple_rte_array[appinfo->child_relid]->relid == ht->main_table_relid &&
+			 !has_deferred_data))
+			continue;
+
+		childpath = childrel->cheapest_total_path;
+
+		if (NULL == childpath || !childpath->parallel_safe || childpath->param_info != NULL)
+			return NULL;
+
+		subpaths = lappend(subpaths, childpath);
+	}
+
+	/* Distributing a single chunk gains nothing */
+	if (list_length(subpaths) < 2)
+		return NULL;
+
+	/* Like a parallel Append, use more workers for more chunks */
+	parallel_workers = Min(fls(list_length(subpaths)), max_parallel_workers_per_gather);
+
+	if (parallel_workers < 1)
+		return NULL;
+
+	append = create_append_path_compat(rel, subpaths, NULL, 0);
+	path = ca_append_path_alloc(&append->path);
+	divisor = parallel_divisor(parallel_workers);
+
+	path->cpath.path.parallel_aware = true;
+	path->cpath.path.parallel_safe = true;
+	path->cpath.path.parallel_workers = parallel_workers;
+	path->cpath.path.rows = clamp_row_est(append->path.rows / divisor);
+	path->cpath.path.total_cost = append->path.startup_cost +
+		(append->path.total_cost - append->path.startup_cost) / divisor;
+
+	return &path->cpath.path;
+}
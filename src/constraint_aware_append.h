@@ -4,6 +4,7 @@
 #include <postgres.h>
 #include <nodes/relation.h>
 #include <nodes/extensible.h>
+#include <portability/instr_time.h>
 
 typedef struct ConstraintAwareAppendPath
 {
@@ -15,11 +16,56 @@ typedef struct ConstraintAwareAppendState
 	CustomScanState csstate;
 	Plan	   *subplan;
 	Size		num_append_subplans;
+
+	/* Exclusion statistics, shown by EXPLAIN ANALYZE */
+	int			num_plan_excluded;
+	int			num_startup_excluded;
+	int64		num_runtime_excluded;
+	bool		track_time;
+	instr_time	exclusion_time;
+
+	/*
+	 * State for run-time exclusion. If the restriction clauses reference
+	 * executor parameters (e.g., the outer side of a nested loop), the set of
+	 * children to scan is re-evaluated whenever the parameters change.
+	 */
+	bool		runtime_exclusion;
+	bool		runtime_pending;
+	List	   *restrictinfos;
+	int			num_children;
+	int			num_active_children;
+	PlanState **children;
+	PlanState **active_children;
+	RangeTblEntry **child_rtes;
+	AppendRelInfo **child_appinfos;
+	struct Hypercube **child_cubes;
+	int32	   *child_chunk_ids;
+	struct HTAB *chunk_time_ranges;
+	struct HTAB *chunk_bloom_filters;
+	Oid			hypertable_relid;
+	Index		parent_relid;
+	MemoryContext exclusion_mcxt;
+
+	/*
+	 * State for parallel scans. The processes of a parallel query claim
+	 * whole children from a counter in shared memory, so that each child is
+	 * scanned by only one process.
+	 */
+	struct ConstraintAwareAppendShared *pstate;
+	int			current_child;
+
+	/*
+	 * Read-ahead of the next child of the Append node below us, as the
+	 * number of blocks to prefetch, and the last child that was prefetched.
+	 */
+	int			prefetch_blocks;
+	int			prefetched_child;
 } ConstraintAwareAppendState;
 
 typedef struct Hypertable Hypertable;
 
 Path	   *constraint_aware_append_path_create(PlannerInfo *root, Hypertable *ht, Path *subpath);
+Path	   *constraint_aware_append_parallel_path_create(PlannerInfo *root, Hypertable *ht, RelOptInfo *rel);
 
 
 #endif							/* TIMESCALEDB_CONSTRAINT_AWARE_APPEND_H */
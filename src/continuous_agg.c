@@ -0,0 +1,736 @@
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <access/xact.h>
+#include <catalog/pg_class.h>
+#include <commands/trigger.h>
+#include <funcapi.h>
+#include <miscadmin.h>
+#include <optimizer/clauses.h>
+#include <optimizer/tlist.h>
+#include <parser/parsetree.h>
+#include <rewrite/rewriteHandler.h>
+#include <storage/lmgr.h>
+#include <utils/builtins.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/rel.h>
+
+#include "continuous_agg.h"
+#include "catalog.h"
+#include "chunk.h"
+#include "dimension.h"
+#include "errors.h"
+#include "hypercube.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "scanner.h"
+#include "utils.h"
+#include "compat.h"
+
+/*
+ * Continuous aggregates.
+ *
+ * A continuous aggregate materializes a view that aggregates a hypertable (the
+ * raw hypertable) by time_bucket() into another hypertable (the
+ * materialization hypertable). The view is set up by
+ * create_continuous_aggregate() to read the materialization, while the
+ * original query lives on as the partial view.
+ *
+ * Inserts into the raw hypertable log the range of time they modified in the
+ * invalidation log. This is done once per statement by the ChunkDispatch,
+ * which sees the time of every tuple anyway, so tracking adds no per-tuple
+ * catalog work. Updates and deletes are tracked by a row trigger instead,
+ * which widens a range in memory that is logged once per transaction.
+ * Truncating the hypertable logs all of time, and writes directly to a chunk,
+ * or dropping chunks with cascade, log the chunks' time slices.
+ * refresh_continuous_aggregate() recomputes only the buckets that overlap the
+ * logged ranges, replacing them in the materialization. Since whole buckets
+ * are recomputed from the raw data, the materialization stores the final
+ * aggregates, and any aggregate can be used, not only mergeable ones.
+ *
+ * The functions here are the parts that need to write the catalog or look into
+ * the view's query. Creating and refreshing the materialization is done in
+ * SQL (see ddl_api.sql).
+ */
+
+static int
+continuous_agg_scan(int indexid, ScanKeyData *scankey, int nkeys,
+					tuple_found_func tuple_found, void *data, LOCKMODE lockmode)
+{
+	Catalog    *catalog = catalog_get();
+	ScannerCtx	scanctx = {
+		.table = catalog_table_get_id(catalog, CONTINUOUS_AGG),
+		.index = CATALOG_INDEX(catalog, CONTINUOUS_AGG, indexid),
+		.nkeys = nkeys,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+	};
+
+	return scanner_scan(&scanctx);
+}
+
+static int
+continuous_agg_scan_by_raw_hypertable_id(int32 raw_hypertable_id, tuple_found_func tuple_found,
+										 void *data, LOCKMODE lockmode)
+{
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_continuous_agg_raw_hypertable_id_idx_raw_hypertable_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(raw_hypertable_id));
+
+	return continuous_agg_scan(CONTINUOUS_AGG_RAW_HYPERTABLE_ID_IDX, scankey, 1,
+							   tuple_found, data, lockmode);
+}
+
+static int
+continuous_agg_scan_by_mat_hypertable_id(int32 mat_hypertable_id, tuple_found_func tuple_found,
+										 void *data, LOCKMODE lockmode)
+{
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_continuous_agg_pkey_idx_mat_hypertable_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(mat_hypertable_id));
+
+	return continuous_agg_scan(CONTINUOUS_AGG_PKEY_IDX, scankey, 1,
+							   tuple_found, data, lockmode);
+}
+
+/*
+ * Check if a hypertable is the raw hypertable of any continuous aggregate,
+ * i.e., if modifications of the hypertable need to be logged.
+ */
+bool
+continuous_agg_exists_for_raw_hypertable(int32 raw_hypertable_id)
+{
+	return continuous_agg_scan_by_raw_hypertable_id(raw_hypertable_id, NULL, NULL,
+													AccessShareLock) > 0;
+}
+
+static int
+invalidation_log_scan(int32 hypertable_id, tuple_found_func tuple_found, void *data,
+					  LOCKMODE lockmode)
+{
+	Catalog    *catalog = catalog_get();
+	ScanKeyData scankey[1];
+	ScannerCtx	scanctx = {
+		.table = catalog_table_get_id(catalog, CONTINUOUS_AGGS_INVALIDATION_LOG),
+		.index = CATALOG_INDEX(catalog, CONTINUOUS_AGGS_INVALIDATION_LOG,
+							   CONTINUOUS_AGGS_INVALIDATION_LOG_HYPERTABLE_ID_IDX),
+		.nkeys = 1,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+	};
+
+	ScanKeyInit(&scankey[0], Anum_continuous_aggs_invalidation_log_hypertable_id_idx_hypertable_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(hypertable_id));
+
+	return scanner_scan(&scanctx);
+}
+
+/*
+ * Log that the range of time [lowest, greatest], in internal time units, of a
+ * hypertable was modified.
+ */
+void
+continuous_agg_invalidation_add(int32 hypertable_id, int64 lowest, int64 greatest)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	Datum		values[Natts_continuous_aggs_invalidation_log];
+	bool		nulls[Natts_continuous_aggs_invalidation_log] = {false};
+	CatalogSecurityContext sec_ctx;
+
+	Assert(lowest <= greatest);
+
+	values[Anum_continuous_aggs_invalidation_log_hypertable_id - 1] = Int32GetDatum(hypertable_id);
+	values[Anum_continuous_aggs_invalidation_log_lowest_modified_value - 1] = Int64GetDatum(lowest);
+	values[Anum_continuous_aggs_invalidation_log_greatest_modified_value - 1] = Int64GetDatum(greatest);
+
+	rel = heap_open(catalog_table_get_id(catalog, CONTINUOUS_AGGS_INVALIDATION_LOG), RowExclusiveLock);
+
+	catalog_become_owner(catalog, &sec_ctx);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+
+	heap_close(rel, RowExclusiveLock);
+}
+
+/*
+ * Ranges modified by updates and deletes in the current transaction, per
+ * hypertable. The row trigger only widens these in memory, so that a
+ * statement writes one log entry per hypertable rather than one per row. They
+ * are logged before the transaction commits, or earlier when a continuous
+ * aggregate is refreshed in the same transaction.
+ */
+typedef struct PendingInvalidation
+{
+	int32		hypertable_id;
+	int64		lowest;
+	int64		greatest;
+} PendingInvalidation;
+
+static List *pending_invalidations = NIL;
+
+static void
+pending_invalidation_add(int32 hypertable_id, int64 lowest, int64 greatest)
+{
+	PendingInvalidation *pending;
+	MemoryContext old;
+	ListCell   *lc;
+
+	foreach(lc, pending_invalidations)
+	{
+		pending = lfirst(lc);
+
+		if (pending->hypertable_id == hypertable_id)
+		{
+			pending->lowest = Min(pending->lowest, lowest);
+			pending->greatest = Max(pending->greatest, greatest);
+			return;
+		}
+	}
+
+	old = MemoryContextSwitchTo(TopTransactionContext);
+	pending = palloc(sizeof(PendingInvalidation));
+	pending->hypertable_id = hypertable_id;
+	pending->lowest = lowest;
+	pending->greatest = greatest;
+	pending_invalidations = lappend(pending_invalidations, pending);
+	MemoryContextSwitchTo(old);
+}
+
+static void
+pending_invalidations_flush(void)
+{
+	List	   *pending = pending_invalidations;
+	ListCell   *lc;
+
+	/* Reset first, so that nothing is logged twice if logging fails */
+	pending_invalidations = NIL;
+
+	foreach(lc, pending)
+	{
+		PendingInvalidation *inval = lfirst(lc);
+
+		continuous_agg_invalidation_add(inval->hypertable_id, inval->lowest, inval->greatest);
+	}
+}
+
+static void
+continuous_agg_xact_end(XactEvent event, void *arg)
+{
+	switch (event)
+	{
+		case XACT_EVENT_PRE_COMMIT:
+		case XACT_EVENT_PRE_PREPARE:
+			pending_invalidations_flush();
+			break;
+		default:
+			/* The list was allocated in the transaction's memory */
+			pending_invalidations = NIL;
+			break;
+	}
+}
+
+/*
+ * Log that all of a hypertable was modified, e.g., when it is truncated.
+ */
+void
+continuous_agg_invalidate_all(Hypertable *ht)
+{
+	if (ht->has_continuous_aggs)
+		continuous_agg_invalidation_add(ht->fd.id, PG_INT64_MIN, PG_INT64_MAX);
+}
+
+/*
+ * Log the time slice of a chunk that is written to directly, rather than
+ * through its hypertable. Such writes can have any time that the chunk's
+ * constraints allow.
+ */
+void
+continuous_agg_invalidate_chunk(Hypertable *ht, int32 chunk_id)
+{
+	Dimension  *dim;
+	Chunk	   *chunk;
+	DimensionSlice *slice;
+
+	if (!ht->has_continuous_aggs)
+		return;
+
+	dim = hyperspace_get_open_dimension(ht->space, 0);
+	chunk = chunk_get_by_id(chunk_id, ht->space->num_dimensions, true);
+	slice = hypercube_get_slice_by_dimension_id(chunk->cube, dim->fd.id);
+
+	/* An open-ended slice stays open-ended, see refresh_continuous_aggregate() */
+	continuous_agg_invalidation_add(ht->fd.id, slice->fd.range_start,
+									slice->fd.range_end == DIMENSION_SLICE_MAXVALUE ?
+									PG_INT64_MAX : slice->fd.range_end - 1);
+}
+
+typedef struct InvalidationRange
+{
+	int64		lowest;
+	int64		greatest;
+} InvalidationRange;
+
+#define INVALIDATION_RANGE_EMPTY(range) \
+	((range)->lowest > (range)->greatest)
+
+/* Remove logged ranges, merging them into a single range */
+static bool
+invalidation_log_tuple_take(TupleInfo *ti, void *data)
+{
+	InvalidationRange *range = data;
+	Form_continuous_aggs_invalidation_log form =
+	(Form_continuous_aggs_invalidation_log) GETSTRUCT(ti->tuple);
+	CatalogSecurityContext sec_ctx;
+
+	range->lowest = Min(range->lowest, form->lowest_modified_value);
+	range->greatest = Max(range->greatest, form->greatest_modified_value);
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete_only(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+static void
+invalidation_log_take(int32 hypertable_id, InvalidationRange *range)
+{
+	range->lowest = PG_INT64_MAX;
+	range->greatest = PG_INT64_MIN;
+
+	invalidation_log_scan(hypertable_id, invalidation_log_tuple_take, range, RowExclusiveLock);
+	CommandCounterIncrement();
+}
+
+/* Copy a range logged for the raw hypertable to one of its continuous aggregates */
+static bool
+continuous_agg_tuple_add_invalidation(TupleInfo *ti, void *data)
+{
+	InvalidationRange *range = data;
+	Form_continuous_agg form = (Form_continuous_agg) GETSTRUCT(ti->tuple);
+
+	continuous_agg_invalidation_add(form->mat_hypertable_id, range->lowest, range->greatest);
+
+	return true;
+}
+
+static bool
+continuous_agg_tuple_get_raw_hypertable_id(TupleInfo *ti, void *data)
+{
+	*((int32 *) data) = ((Form_continuous_agg) GETSTRUCT(ti->tuple))->raw_hypertable_id;
+
+	return false;
+}
+
+TS_FUNCTION_INFO_V1(continuous_agg_take_invalidation);
+
+/*
+ * Take the range of time of the raw hypertable that was modified since a
+ * continuous aggregate was last refreshed, removing it from the log. Returns
+ * NULLs if nothing was modified.
+ *
+ * Ranges logged for the raw hypertable are first copied to all of its
+ * continuous aggregates, so that refreshing one continuous aggregate does not
+ * lose the modifications for the others. Concurrent refreshes of the
+ * continuous aggregates of a raw hypertable are serialized with a
+ * self-conflicting lock on the raw hypertable that still allows inserts.
+ */
+Datum
+continuous_agg_take_invalidation(PG_FUNCTION_ARGS)
+{
+	int32		mat_hypertable_id = PG_GETARG_INT32(0);
+	int32		raw_hypertable_id = 0;
+	InvalidationRange range;
+	TupleDesc	tupdesc;
+	Datum		values[2];
+	bool		nulls[2] = {false};
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "Function returning record called in context that cannot accept type record");
+
+	continuous_agg_scan_by_mat_hypertable_id(mat_hypertable_id,
+											 continuous_agg_tuple_get_raw_hypertable_id,
+											 &raw_hypertable_id, AccessShareLock);
+
+	if (raw_hypertable_id <= 0)
+		elog(ERROR, "no continuous aggregate for hypertable %d", mat_hypertable_id);
+
+	LockRelationOid(hypertable_id_to_relid(raw_hypertable_id), ShareUpdateExclusiveLock);
+
+	/* Include the updates and deletes of this transaction */
+	pending_invalidations_flush();
+	CommandCounterIncrement();
+
+	invalidation_log_take(raw_hypertable_id, &range);
+
+	if (!INVALIDATION_RANGE_EMPTY(&range))
+		continuous_agg_scan_by_raw_hypertable_id(raw_hypertable_id,
+												 continuous_agg_tuple_add_invalidation,
+												 &range, AccessShareLock);
+
+	invalidation_log_take(mat_hypertable_id, &range);
+
+	if (INVALIDATION_RANGE_EMPTY(&range))
+		nulls[0] = nulls[1] = true;
+	else
+	{
+		values[0] = Int64GetDatum(range.lowest);
+		values[1] = Int64GetDatum(range.greatest);
+	}
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(BlessTupleDesc(tupdesc), values, nulls)));
+}
+
+/*
+ * The time_bucket() grouping of a continuous aggregate's query.
+ */
+typedef struct ContinuousAggBucket
+{
+	Hypertable *raw_hypertable;
+	char	   *bucket_column;
+	int64		bucket_width;
+} ContinuousAggBucket;
+
+static void
+continuous_agg_view_error(Oid view_relid, const char *detail)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("view \"%s\" cannot be a continuous aggregate", get_rel_name(view_relid)),
+			 errdetail("%s", detail)));
+}
+
+/*
+ * Check that a view can be materialized incrementally and get its
+ * time_bucket() grouping. The view must aggregate a single hypertable, grouped
+ * by a time_bucket() with a constant width on the hypertable's time column.
+ * The buckets are recomputed independently of each other, so nothing in the
+ * query may depend on other buckets or on when the query runs.
+ */
+static void
+continuous_agg_view_get_bucket(Oid view_relid, Cache *hcache, ContinuousAggBucket *bucket)
+{
+	Relation	rel = relation_open(view_relid, AccessShareLock);
+	Query	   *query;
+	RangeTblRef *rtr;
+	RangeTblEntry *rte;
+	Dimension  *time_dim;
+	ListCell   *lc;
+
+	if (rel->rd_rel->relkind != RELKIND_VIEW)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("\"%s\" is not a view", RelationGetRelationName(rel))));
+
+	query = copyObject(get_view_query(rel));
+	relation_close(rel, NoLock);
+
+	if (!query->hasAggs || query->groupClause == NIL)
+		continuous_agg_view_error(view_relid, "The view must aggregate with GROUP BY.");
+
+	if (query->hasWindowFuncs || query->hasSubLinks || query->hasTargetSRFs ||
+		query->cteList != NIL || query->setOperations != NULL ||
+		query->groupingSets != NIL || query->distinctClause != NIL ||
+		query->sortClause != NIL || query->limitCount != NULL || query->limitOffset != NULL)
+		continuous_agg_view_error(view_relid, "Window functions, subqueries, set-returning "
+								  "functions, CTEs, set operations, grouping sets, DISTINCT, "
+								  "ORDER BY, and LIMIT are not supported.");
+
+	if (contain_mutable_functions((Node *) query))
+		continuous_agg_view_error(view_relid, "Only immutable functions are supported.");
+
+	if (list_length(query->jointree->fromlist) != 1 ||
+		!IsA(linitial(query->jointree->fromlist), RangeTblRef))
+		continuous_agg_view_error(view_relid, "The view must select from a single hypertable.");
+
+	rtr = linitial(query->jointree->fromlist);
+	rte = rt_fetch(rtr->rtindex, query->rtable);
+
+	bucket->raw_hypertable = NULL;
+
+	if (rte->rtekind == RTE_RELATION && rte->inh)
+		bucket->raw_hypertable = hypertable_cache_get_entry(hcache, rte->relid);
+
+	if (NULL == bucket->raw_hypertable)
+		continuous_agg_view_error(view_relid, "The view must select from a single hypertable.");
+
+	time_dim = hyperspace_get_open_dimension(bucket->raw_hypertable->space, 0);
+	bucket->bucket_column = NULL;
+
+	foreach(lc, query->targetList)
+	{
+		TargetEntry *tle = lfirst(lc);
+		Var		   *var;
+		int64		width;
+
+		if (tle->resjunk || tle->ressortgroupref == 0 ||
+			NULL == get_sortgroupref_clause_noerr(tle->ressortgroupref, query->groupClause))
+			continue;
+
+		/* A width like 10 on a bigint column is still a cast in the view */
+		var = time_bucket_get_var(eval_const_expressions(NULL, (Node *) tle->expr), &width);
+
+		if (NULL == var ||
+			var->varno != rtr->rtindex ||
+			var->varlevelsup != 0 ||
+			var->varattno != time_dim->column_attno)
+			continue;
+
+		if (NULL != bucket->bucket_column)
+			continuous_agg_view_error(view_relid, "The view must group by a single time_bucket().");
+
+		bucket->bucket_column = tle->resname;
+		bucket->bucket_width = width;
+	}
+
+	if (NULL == bucket->bucket_column)
+		continuous_agg_view_error(view_relid,
+								  psprintf("The view must group by, and select, a time_bucket() "
+										   "with a constant width on the column \"%s\".",
+										   NameStr(time_dim->fd.column_name)));
+}
+
+TS_FUNCTION_INFO_V1(continuous_agg_view_bucket);
+
+/*
+ * Get the raw hypertable, bucket column and bucket width of a view that is to
+ * become a continuous aggregate. Fails if the view cannot be one.
+ */
+Datum
+continuous_agg_view_bucket(PG_FUNCTION_ARGS)
+{
+	Oid			view_relid = PG_GETARG_OID(0);
+	Cache	   *hcache = hypertable_cache_pin();
+	ContinuousAggBucket bucket;
+	TupleDesc	tupdesc;
+	Datum		values[3];
+	bool		nulls[3] = {false};
+	NameData	bucket_column;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "Function returning record called in context that cannot accept type record");
+
+	continuous_agg_view_get_bucket(view_relid, hcache, &bucket);
+
+	namestrcpy(&bucket_column, bucket.bucket_column);
+	values[0] = Int32GetDatum(bucket.raw_hypertable->fd.id);
+	values[1] = NameGetDatum(&bucket_column);
+	values[2] = Int64GetDatum(bucket.bucket_width);
+
+	cache_release(hcache);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(BlessTupleDesc(tupdesc), values, nulls)));
+}
+
+TS_FUNCTION_INFO_V1(continuous_agg_register);
+
+/*
+ * Register a continuous aggregate in the catalog, once its partial view and
+ * materialization hypertable exist. Inserts into the raw hypertable are logged
+ * from then on.
+ */
+Datum
+continuous_agg_register(PG_FUNCTION_ARGS)
+{
+	Oid			user_view_relid = PG_GETARG_OID(0);
+	Oid			partial_view_relid = PG_GETARG_OID(1);
+	Oid			mat_relid = PG_GETARG_OID(2);
+	Catalog    *catalog = catalog_get();
+	Cache	   *hcache = hypertable_cache_pin();
+	ContinuousAggBucket bucket;
+	Hypertable *mat_ht;
+	Relation	rel;
+	Datum		values[Natts_continuous_agg];
+	bool		nulls[Natts_continuous_agg] = {false};
+	NameData	user_view_schema,
+				user_view_name,
+				partial_view_schema,
+				partial_view_name;
+	CatalogSecurityContext sec_ctx;
+
+	continuous_agg_view_get_bucket(partial_view_relid, hcache, &bucket);
+	hypertable_permissions_check(bucket.raw_hypertable->main_table_relid, GetUserId());
+
+	mat_ht = hypertable_cache_get_entry(hcache, mat_relid);
+
+	if (NULL == mat_ht)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_HYPERTABLE_NOT_EXIST),
+				 errmsg("table \"%s\" is not a hypertable", get_rel_name(mat_relid))));
+
+	namestrcpy(&user_view_schema, get_namespace_name(get_rel_namespace(user_view_relid)));
+	namestrcpy(&user_view_name, get_rel_name(user_view_relid));
+	namestrcpy(&partial_view_schema, get_namespace_name(get_rel_namespace(partial_view_relid)));
+	namestrcpy(&partial_view_name, get_rel_name(partial_view_relid));
+
+	values[Anum_continuous_agg_mat_hypertable_id - 1] = Int32GetDatum(mat_ht->fd.id);
+	values[Anum_continuous_agg_raw_hypertable_id - 1] = Int32GetDatum(bucket.raw_hypertable->fd.id);
+	values[Anum_continuous_agg_user_view_schema - 1] = NameGetDatum(&user_view_schema);
+	values[Anum_continuous_agg_user_view_name - 1] = NameGetDatum(&user_view_name);
+	values[Anum_continuous_agg_partial_view_schema - 1] = NameGetDatum(&partial_view_schema);
+	values[Anum_continuous_agg_partial_view_name - 1] = NameGetDatum(&partial_view_name);
+	values[Anum_continuous_agg_bucket_width - 1] = Int64GetDatum(bucket.bucket_width);
+
+	cache_release(hcache);
+
+	rel = heap_open(catalog_table_get_id(catalog, CONTINUOUS_AGG), RowExclusiveLock);
+
+	catalog_become_owner(catalog, &sec_ctx);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+
+	heap_close(rel, RowExclusiveLock);
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(continuous_agg_invalidation_trigger);
+
+/*
+ * Row trigger that tracks the time of updated and deleted rows of a raw
+ * hypertable, to be logged before the transaction commits. Inserts are logged
+ * by the ChunkDispatch instead. The trigger's argument is the ID of the
+ * hypertable. Like other triggers on a hypertable, it is also created on the
+ * chunks, where it actually fires.
+ */
+Datum
+continuous_agg_invalidation_trigger(PG_FUNCTION_ARGS)
+{
+	TriggerData *trigdata = (TriggerData *) fcinfo->context;
+	Cache	   *hcache;
+	Hypertable *ht;
+	Dimension  *time_dim;
+	TupleDesc	tupdesc;
+	AttrNumber	attno;
+	int32		hypertable_id;
+	HeapTuple	tuples[2];
+	int			num_tuples = 1;
+	int64		lowest = PG_INT64_MAX;
+	int64		greatest = PG_INT64_MIN;
+	int			i;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		elog(ERROR, "continuous_agg_invalidation_trigger: not called by trigger manager");
+
+	if (!TRIGGER_FIRED_FOR_ROW(trigdata->tg_event) ||
+		!TRIGGER_FIRED_AFTER(trigdata->tg_event) ||
+		trigdata->tg_trigger->tgnargs != 1)
+		elog(ERROR, "continuous_agg_invalidation_trigger: must be fired after row with the hypertable ID");
+
+	hypertable_id = pg_atoi(trigdata->tg_trigger->tgargs[0], sizeof(int32), '\0');
+
+	tuples[0] = trigdata->tg_trigtuple;
+
+	if (TRIGGER_FIRED_BY_UPDATE(trigdata->tg_event))
+		tuples[num_tuples++] = trigdata->tg_newtuple;
+
+	hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry_by_id(hcache, hypertable_id);
+
+	if (NULL == ht)
+	{
+		cache_release(hcache);
+		return PointerGetDatum(NULL);
+	}
+
+	/* The chunk's attribute numbers can differ from the hypertable's */
+	time_dim = hyperspace_get_open_dimension(ht->space, 0);
+	tupdesc = RelationGetDescr(trigdata->tg_relation);
+	attno = get_attnum(RelationGetRelid(trigdata->tg_relation), NameStr(time_dim->fd.column_name));
+
+	for (i = 0; i < num_tuples; i++)
+	{
+		bool		isnull;
+		Datum		value = heap_getattr(tuples[i], attno, tupdesc, &isnull);
+		int64		time;
+
+		if (isnull)
+			continue;
+
+		time = time_value_to_internal(value, time_dim->fd.column_type);
+		lowest = Min(lowest, time);
+		greatest = Max(greatest, time);
+	}
+
+	cache_release(hcache);
+
+	if (lowest <= greatest)
+		pending_invalidation_add(hypertable_id, lowest, greatest);
+
+	return PointerGetDatum(NULL);
+}
+
+static bool
+continuous_agg_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+static bool
+invalidation_log_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete_only(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+/*
+ * Delete the continuous aggregates that a dropped hypertable is the raw or
+ * materialization hypertable of, and the hypertable's logged invalidations.
+ * Dropping a raw hypertable leaves the materializations of its continuous
+ * aggregates in place as regular hypertables.
+ */
+void
+continuous_agg_delete_by_hypertable_id(int32 hypertable_id)
+{
+	ListCell   *lc;
+
+	foreach(lc, pending_invalidations)
+	{
+		PendingInvalidation *pending = lfirst(lc);
+
+		if (pending->hypertable_id == hypertable_id)
+		{
+			pending_invalidations = list_delete_ptr(pending_invalidations, pending);
+			break;
+		}
+	}
+
+	continuous_agg_scan_by_mat_hypertable_id(hypertable_id, continuous_agg_tuple_delete,
+											 NULL, RowExclusiveLock);
+	continuous_agg_scan_by_raw_hypertable_id(hypertable_id, continuous_agg_tuple_delete,
+											 NULL, RowExclusiveLock);
+	invalidation_log_scan(hypertable_id, invalidation_log_tuple_delete, NULL, RowExclusiveLock);
+	CommandCounterIncrement();
+}
+
+void
+_continuous_agg_init(void)
+{
+	RegisterXactCallback(continuous_agg_xact_end, NULL);
+}
+
+void
+_continuous_agg_fini(void)
+{
+	UnregisterXactCallback(continuous_agg_xact_end, NULL);
+}
@@ -0,0 +1,15 @@
+#ifndef TIMESCALEDB_CONTINUOUS_AGG_H
+#define TIMESCALEDB_CONTINUOUS_AGG_H
+
+#include <postgres.h>
+
+#include "catalog.h"
+#include "hypertable.h"
+
+extern bool continuous_agg_exists_for_raw_hypertable(int32 raw_hypertable_id);
+extern void continuous_agg_invalidation_add(int32 hypertable_id, int64 lowest, int64 greatest);
+extern void continuous_agg_invalidate_all(Hypertable *ht);
+extern void continuous_agg_invalidate_chunk(Hypertable *ht, int32 chunk_id);
+extern void continuous_agg_delete_by_hypertable_id(int32 hypertable_id);
+
+#endif							/* TIMESCALEDB_CONTINUOUS_AGG_H */
@@ -14,8 +14,12 @@
 #include <commands/trigger.h>
 #include <commands/tablecmds.h>
 #include <executor/executor.h>
+#include <foreign/fdwapi.h>
 #include <miscadmin.h>
 #include <nodes/makefuncs.h>
+#include <optimizer/clauses.h>
+#include <optimizer/planner.h>
+#include <rewrite/rewriteHandler.h>
 #include <storage/bufmgr.h>
 #include <utils/builtins.h>
 #include <utils/guc.h>
@@ -39,10 +43,23 @@
  * regular PostgreSQL source code for the COPY command (command/copy.c), albeit
  * with minor modifications.
  *
+ * COPY runs in a single backend. Parallel workers cannot insert tuples (writes
+ * are prohibited in parallel mode) and separate background workers would run
+ * in their own transactions, so they can neither see chunks created by the
+ * leader nor be rolled back with it. Loads that need more than one core
+ * should instead run several COPY commands concurrently, e.g., one per input
+ * file or time range, in separate sessions.
+ *
  */
 
 typedef struct CopyChunkState CopyChunkState;
 
+#if PG10
+#define copy_transition_capture(ccstate) ((ccstate)->dispatch->transition_capture)
+#elif PG96
+#define copy_transition_capture(ccstate) NULL
+#endif
+
 typedef bool (*CopyFromFunc) (CopyChunkState *ccstate, ExprContext *econtext,
 							  Datum *values, bool *nulls, Oid *tuple_oid);
 
@@ -58,8 +75,64 @@ typedef struct CopyChunkState
 		HeapScanDesc scandesc;
 		void	   *data;
 	}			fromctx;
+	CommandId	mycid;
+	BulkInsertState bistate;
+	Oid			bistate_relid;
+	/* Chunk insert states that have buffered tuples */
+	List	   *buffered_chunks;
+	int			num_buffered_tuples;
+	Size		buffered_tuples_size;
 } CopyChunkState;
 
+/*
+ * Flush all buffered tuples when the total size reaches this many bytes. Same
+ * as the limit in PostgreSQL's COPY. The limit on the number of tuples is
+ * CHUNK_INSERT_STATE_MAX_BUFFERED_TUPLES.
+ */
+#define COPY_MAX_BUFFERED_BYTES 65535
+
+static void copy_chunk_state_flush_chunk(CopyChunkState *ccstate, ChunkInsertState *cis);
+
+static void
+copy_flush_buffered_chunk(ChunkInsertState *cis, void *arg)
+{
+	copy_chunk_state_flush_chunk((CopyChunkState *) arg, cis);
+}
+
+/*
+ * Check if any column of the relation has a volatile default expression.
+ *
+ * A volatile default might, e.g., query the table being inserted into, so it
+ * must see all previously copied rows and tuples cannot be buffered. Unlike
+ * PostgreSQL's COPY, we do not know which columns are in the COPY column list,
+ * so all defaults are checked.
+ */
+static bool
+relation_has_volatile_defaults(Relation rel)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	int			i;
+
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		Expr	   *defexpr;
+
+		if (tupdesc->attrs[i]->attisdropped)
+			continue;
+
+		defexpr = (Expr *) build_column_default(rel, i + 1);
+
+		if (NULL == defexpr)
+			continue;
+
+		defexpr = expression_planner(defexpr);
+
+		if (contain_volatile_functions_not_nextval((Node *) defexpr))
+			return true;
+	}
+
+	return false;
+}
 
 static CopyChunkState *
 copy_chunk_state_create(Hypertable *ht, Relation rel, CopyFromFunc from_func, void *fromctx)
@@ -73,6 +146,28 @@ copy_chunk_state_create(Hypertable *ht, Relation rel, CopyFromFunc from_func, vo
 	ccstate->dispatch = chunk_dispatch_create(ht, estate);
 	ccstate->fromctx.data = fromctx;
 	ccstate->next_copy_from = from_func;
+	ccstate->mycid = GetCurrentCommandId(true);
+	ccstate->bistate = NULL;
+	ccstate->bistate_relid = InvalidOid;
+	ccstate->buffered_chunks = NIL;
+	ccstate->num_buffered_tuples = 0;
+	ccstate->buffered_tuples_size = 0;
+
+	/*
+	 * Buffer tuples per chunk and write them with heap_multi_insert(), unless
+	 * default expressions might depend on previously inserted rows.
+	 */
+	ccstate->dispatch->multi_insert = !relation_has_volatile_defaults(rel);
+
+	/*
+	 * Whether writing WAL and the FSM can be skipped is decided per chunk,
+	 * since tuples are never inserted into the hypertable's root table and
+	 * chunks are often created in the same transaction that loads them. See
+	 * chunk_insert_state_create().
+	 */
+	ccstate->dispatch->bulk_load = true;
+	ccstate->dispatch->flush_buffered = copy_flush_buffered_chunk;
+	ccstate->dispatch->flush_arg = ccstate;
 
 	return ccstate;
 }
@@ -84,6 +179,156 @@ copy_chunk_state_destroy(CopyChunkState *ccstate)
 	FreeExecutorState(ccstate->estate);
 }
 
+/*
+ * Make the bulk insert state target the given chunk.
+ *
+ * The buffer pinned by the bulk insert state belongs to the relation last
+ * inserted into, so it must be released when switching chunks.
+ */
+static inline void
+copy_chunk_state_set_bistate_relation(CopyChunkState *ccstate, Relation rel)
+{
+	BulkInsertState bistate = ccstate->bistate;
+
+	if (ccstate->bistate_relid == RelationGetRelid(rel))
+		return;
+
+	if (bistate->current_buf != InvalidBuffer)
+		ReleaseBuffer(bistate->current_buf);
+
+	bistate->current_buf = InvalidBuffer;
+	ccstate->bistate_relid = RelationGetRelid(rel);
+}
+
+/*
+ * Write the tuples buffered for a chunk using heap_multi_insert().
+ *
+ * Index entries and AFTER ROW triggers are processed for each tuple once the
+ * batch is in the heap, similar to CopyFromInsertBatch() in PostgreSQL's
+ * COPY. Note that errors raised here (e.g., unique violations) will report the
+ * line number of the most recently read row.
+ */
+static void
+copy_chunk_state_flush_chunk(CopyChunkState *ccstate, ChunkInsertState *cis)
+{
+	EState	   *estate = ccstate->estate;
+	ResultRelInfo *resultRelInfo = cis->result_relation_info;
+	ResultRelInfo *saved_resultRelInfo = estate->es_result_relation_info;
+	MemoryContext oldcontext;
+	int			i;
+
+	if (cis->num_buffered_tuples == 0)
+		return;
+
+	/* Index insertion uses the result relation set in the executor state */
+	estate->es_result_relation_info = resultRelInfo;
+
+	copy_chunk_state_set_bistate_relation(ccstate, cis->rel);
+
+	oldcontext = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
+	heap_multi_insert(cis->rel,
+					  cis->buffered_tuples,
+					  cis->num_buffered_tuples,
+					  ccstate->mycid,
+					  cis->hi_options,
+					  ccstate->bistate);
+	MemoryContextSwitchTo(oldcontext);
+
+#if PG10
+
+	/*
+	 * The tuples routed to the chunk are gone, so tuples captured for
+	 * transition tables are converted back from the chunk's rowtype
+	 */
+	if (ccstate->dispatch->transition_capture != NULL)
+	{
+		ccstate->dispatch->transition_capture->tcs_original_insert_tuple = NULL;
+		ccstate->dispatch->transition_capture->tcs_map = cis->transition_map;
+	}
+#endif
+
+	if (resultRelInfo->ri_NumIndices > 0 ||
+		(resultRelInfo->ri_TrigDesc != NULL &&
+		 resultRelInfo->ri_TrigDesc->trig_insert_after_row) ||
+		copy_transition_capture(ccstate) != NULL)
+	{
+		for (i = 0; i < cis->num_buffered_tuples; i++)
+		{
+			HeapTuple	tuple = cis->buffered_tuples[i];
+			List	   *recheckIndexes = NIL;
+
+			if (resultRelInfo->ri_NumIndices > 0)
+			{
+				ExecStoreTuple(tuple, cis->buffer_slot, InvalidBuffer, false);
+				recheckIndexes = ExecInsertIndexTuples(cis->buffer_slot, &(tuple->t_self),
+													   estate, false, NULL,
+													   NIL);
+			}
+
+			/* AFTER ROW INSERT Triggers */
+			ExecARInsertTriggersCompat(estate, resultRelInfo, tuple, recheckIndexes,
+									   copy_transition_capture(ccstate));
+
+			list_free(recheckIndexes);
+		}
+
+		ExecClearTuple(cis->buffer_slot);
+	}
+
+	ccstate->num_buffered_tuples -= cis->num_buffered_tuples;
+	ccstate->buffered_tuples_size -= cis->buffered_tuples_size;
+	ccstate->buffered_chunks = list_delete_ptr(ccstate->buffered_chunks, cis);
+	cis->num_buffered_tuples = 0;
+	cis->buffered_tuples_size = 0;
+	MemoryContextReset(cis->buffer_mctx);
+
+	estate->es_result_relation_info = saved_resultRelInfo;
+}
+
+/*
+ * Flush the buffered tuples of all chunks.
+ */
+static void
+copy_chunk_state_flush_all(CopyChunkState *ccstate)
+{
+	while (ccstate->buffered_chunks != NIL)
+		copy_chunk_state_flush_chunk(ccstate, linitial(ccstate->buffered_chunks));
+
+	Assert(ccstate->num_buffered_tuples == 0);
+	Assert(ccstate->buffered_tuples_size == 0);
+}
+
+/*
+ * Add a tuple to a chunk's multi-insert buffer.
+ *
+ * Limits are on the total number of buffered tuples across all chunks, so
+ * that memory use does not grow with the number of open chunks. Must be
+ * called in a memory context that outlives the buffer (not the per-tuple
+ * context).
+ */
+static void
+copy_chunk_state_buffer_tuple(CopyChunkState *ccstate, ChunkInsertState *cis, HeapTuple tuple)
+{
+	MemoryContext oldcontext;
+
+	Assert(cis->buffered_tuples != NULL);
+
+	if (cis->num_buffered_tuples == 0)
+		ccstate->buffered_chunks = lappend(ccstate->buffered_chunks, cis);
+
+	oldcontext = MemoryContextSwitchTo(cis->buffer_mctx);
+	cis->buffered_tuples[cis->num_buffered_tuples++] = heap_copytuple(tuple);
+	MemoryContextSwitchTo(oldcontext);
+
+	cis->buffered_tuples_size += tuple->t_len;
+	ccstate->num_buffered_tuples++;
+	ccstate->buffered_tuples_size += tuple->t_len;
+
+	if (ccstate->num_buffered_tuples >= CHUNK_INSERT_STATE_MAX_BUFFERED_TUPLES ||
+		ccstate->buffered_tuples_size >= COPY_MAX_BUFFERED_BYTES)
+		copy_chunk_state_flush_all(ccstate);
+}
+
 static bool
 next_copy_from(CopyChunkState *ccstate, ExprContext *econtext,
 			   Datum *values, bool *nulls, Oid *tuple_oid)
@@ -107,13 +352,10 @@ timescaledb_CopyFrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht)
 	ExprContext *econtext;
 	TupleTableSlot *myslot;
 	MemoryContext oldcontext = CurrentMemoryContext;
-	ChunkInsertState *prev_cis = NULL;
 
 	ErrorContextCallback errcallback;
-	CommandId	mycid = GetCurrentCommandId(true);
-	int			hi_options = 0; /* start with default heap_insert options */
-	BulkInsertState bistate;
 	uint64		processed = 0;
+	Point	   *point;
 
 	if (ccstate->rel->rd_rel->relkind != RELKIND_RELATION)
 	{
@@ -146,50 +388,6 @@ timescaledb_CopyFrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht)
 
 	tupDesc = RelationGetDescr(ccstate->rel);
 
-	/*----------
-	 * Check to see if we can avoid writing WAL
-	 *
-	 * If archive logging/streaming is not enabled *and* either
-	 *	- table was created in same transaction as this COPY
-	 *	- data is being written to relfilenode created in this transaction
-	 * then we can skip writing WAL.  It's safe because if the transaction
-	 * doesn't commit, we'll discard the table (or the new relfilenode file).
-	 * If it does commit, we'll have done the heap_sync at the bottom of this
-	 * routine first.
-	 *
-	 * As mentioned in comments in utils/rel.h, the in-same-transaction test
-	 * is not always set correctly, since in rare cases rd_newRelfilenodeSubid
-	 * can be cleared before the end of the transaction. The exact case is
-	 * when a relation sets a new relfilenode twice in same transaction, yet
-	 * the second one fails in an aborted subtransaction, e.g.
-	 *
-	 * BEGIN;
-	 * TRUNCATE t;
-	 * SAVEPOINT save;
-	 * TRUNCATE t;
-	 * ROLLBACK TO save;
-	 * COPY ...
-	 *
-	 * Also, if the target file is new-in-transaction, we assume that checking
-	 * FSM for free space is a waste of time, even if we must use WAL because
-	 * of archiving.  This could possibly be wrong, but it's unlikely.
-	 *
-	 * The comments for heap_insert and RelationGetBufferForTuple specify that
-	 * skipping WAL logging is only safe if we ensure that our tuples do not
-	 * go into pages containing tuples from any other transactions --- but this
-	 * must be the case if we have a new table or new relfilenode, so we need
-	 * no additional work to enforce that.
-	 *----------
-	 */
-	/* createSubid is creation check, newRelfilenodeSubid is truncation check */
-	if (ccstate->rel->rd_createSubid != InvalidSubTransactionId ||
-		ccstate->rel->rd_newRelfilenodeSubid != InvalidSubTransactionId)
-	{
-		hi_options |= HEAP_INSERT_SKIP_FSM;
-		if (!XLogIsNeeded())
-			hi_options |= HEAP_INSERT_SKIP_WAL;
-	}
-
 	/*
 	 * We need a ResultRelInfo so we can use the regular executor's
 	 * index-entry-making machinery.  (There used to be a huge amount of code
@@ -218,6 +416,18 @@ timescaledb_CopyFrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht)
 	/* Prepare to catch AFTER triggers. */
 	AfterTriggerBeginQuery();
 
+#if PG10
+
+	/*
+	 * If there are any statement-level triggers with transition tables on the
+	 * hypertable, collect the tuples inserted into all chunks for them.
+	 */
+	ccstate->dispatch->transition_capture =
+		MakeTransitionCaptureState(ccstate->rel->trigdesc,
+								   RelationGetRelid(ccstate->rel),
+								   CMD_INSERT);
+#endif
+
 	/*
 	 * Check BEFORE STATEMENT insertion triggers. It's debatable whether we
 	 * should do this for COPY, since it's not really an "INSERT" statement as
@@ -229,7 +439,10 @@ timescaledb_CopyFrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht)
 	values = (Datum *) palloc(tupDesc->natts * sizeof(Datum));
 	nulls = (bool *) palloc(tupDesc->natts * sizeof(bool));
 
-	bistate = GetBulkInsertState();
+	/* The point is recalculated for each row, so allocate it only once */
+	point = point_create(ht->space->num_dimensions);
+
+	ccstate->bistate = GetBulkInsertState();
 	econtext = GetPerTupleExprContext(estate);
 
 	/* Set up callback to identify error line number */
@@ -243,7 +456,6 @@ timescaledb_CopyFrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht)
 		TupleTableSlot *slot;
 		bool		skip_tuple;
 		Oid			loaded_oid = InvalidOid;
-		Point	   *point;
 		ChunkDispatch *dispatch = ccstate->dispatch;
 		ChunkInsertState *cis;
 
@@ -264,8 +476,11 @@ timescaledb_CopyFrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht)
 		if (loaded_oid != InvalidOid)
 			HeapTupleSetOid(tuple, loaded_oid);
 
-		/* Calculate the tuple's point in the N-dimensional hyperspace */
-		point = hyperspace_calculate_point(ht->space, tuple, tupDesc);
+		/*
+		 * Calculate the tuple's point in the N-dimensional hyperspace. Read
+		 * the values parsed from the input instead of deforming the tuple.
+		 */
+		hyperspace_calculate_point_from_values(ht->space, values, nulls, point);
 
 		/* Save the main table's (hypertable's) ResultRelInfo */
 		if (NULL == dispatch->hypertable_result_rel_info)
@@ -276,14 +491,6 @@ timescaledb_CopyFrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht)
 
 		Assert(cis != NULL);
 
-		if (cis != prev_cis)
-		{
-			/* Different chunk so must release BulkInsertState */
-			if (bistate->current_buf != InvalidBuffer)
-				ReleaseBuffer(bistate->current_buf);
-			bistate->current_buf = InvalidBuffer;
-		}
-
 		/* Triggers and stuff need to be invoked in query context. */
 		MemoryContextSwitchTo(oldcontext);
 
@@ -302,7 +509,6 @@ timescaledb_CopyFrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht)
 		saved_resultRelInfo = resultRelInfo;
 		resultRelInfo = cis->result_relation_info;
 		estate->es_result_relation_info = resultRelInfo;
-		prev_cis = cis;
 
 		/*
 		 * Constraints might reference the tableoid column, so initialize
@@ -330,12 +536,41 @@ timescaledb_CopyFrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht)
 			if (ccstate->rel->rd_att->constr)
 				ExecConstraints(resultRelInfo, slot, estate);
 
+			if (cis->buffered_tuples != NULL)
+			{
+				/* Buffer the tuple and insert it with the chunk's batch */
+				copy_chunk_state_buffer_tuple(ccstate, cis, tuple);
+			}
+			else if (resultRelInfo->ri_FdwRoutine != NULL)
+			{
+				/* Send the tuple to the foreign chunk's data node */
+				slot = resultRelInfo->ri_FdwRoutine->ExecForeignInsert(estate,
+																	   resultRelInfo,
+																	   slot,
+																	   NULL);
+
+				if (slot == NULL)
+					skip_tuple = true;
+				else
+				{
+					/* FDW might have changed tuple */
+					tuple = ExecMaterializeSlot(slot);
+					tuple->t_tableOid = RelationGetRelid(resultRelInfo->ri_RelationDesc);
+
+					/* AFTER ROW INSERT Triggers */
+					ExecARInsertTriggersCompat(estate, resultRelInfo, tuple, NIL,
+											   copy_transition_capture(ccstate));
+				}
+			}
+			else
 			{
 				List	   *recheckIndexes = NIL;
 
+				copy_chunk_state_set_bistate_relation(ccstate, resultRelInfo->ri_RelationDesc);
+
 				/* OK, store the tuple and create index entries for it */
-				heap_insert(resultRelInfo->ri_RelationDesc, tuple, mycid,
-							hi_options, bistate);
+				heap_insert(resultRelInfo->ri_RelationDesc, tuple, ccstate->mycid,
+							cis->hi_options, ccstate->bistate);
 
 				if (resultRelInfo->ri_NumIndices > 0)
 					recheckIndexes = ExecInsertIndexTuples(slot, &(tuple->t_self),
@@ -343,7 +578,8 @@ timescaledb_CopyFrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht)
 														   NIL);
 
 				/* AFTER ROW INSERT Triggers */
-				ExecARInsertTriggersCompat(estate, resultRelInfo, tuple, recheckIndexes);
+				ExecARInsertTriggersCompat(estate, resultRelInfo, tuple, recheckIndexes,
+										   copy_transition_capture(ccstate));
 
 				list_free(recheckIndexes);
 			}
@@ -353,19 +589,28 @@ timescaledb_CopyFrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht)
 			 * this is the same definition used by execMain.c for counting
 			 * tuples inserted by an INSERT command.
 			 */
-			processed++;
+			if (!skip_tuple)
+				processed++;
+		}
 
-			if (saved_resultRelInfo)
-			{
-				resultRelInfo = saved_resultRelInfo;
-				estate->es_result_relation_info = resultRelInfo;
-			}
+		/*
+		 * Restore the hypertable's result relation also for tuples skipped by
+		 * a BEFORE ROW trigger, since AFTER STATEMENT triggers and the
+		 * transition tables belong to the hypertable
+		 */
+		if (saved_resultRelInfo)
+		{
+			resultRelInfo = saved_resultRelInfo;
+			estate->es_result_relation_info = resultRelInfo;
 		}
 	}
+	/* Flush any remaining buffered tuples */
+	copy_chunk_state_flush_all(ccstate);
+
 	/* Done, clean up */
 	error_context_stack = errcallback.previous;
 
-	FreeBulkInsertState(bistate);
+	FreeBulkInsertState(ccstate->bistate);
 
 	MemoryContextSwitchTo(oldcontext);
 
@@ -373,7 +618,7 @@ timescaledb_CopyFrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht)
 	 * if (cstate->copy_dest == COPY_OLD_FE) pq_endmsgread();
 	 */
 	/* Execute AFTER STATEMENT insertion triggers */
-	ExecASInsertTriggersCompat(estate, resultRelInfo);
+	ExecASInsertTriggersCompat(estate, resultRelInfo, copy_transition_capture(ccstate));
 
 	/* Handle queued AFTER triggers */
 	AfterTriggerEndQuery(estate);
@@ -411,13 +656,6 @@ timescaledb_CopyFrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht)
 
 	copy_chunk_state_destroy(ccstate);
 
-	/*
-	 * If we skipped writing WAL, then we need to sync the heap (but not
-	 * indexes since those use WAL anyway)
-	 */
-	if (hi_options & HEAP_INSERT_SKIP_WAL)
-		heap_sync(ccstate->rel);
-
 	return processed;
 }
 
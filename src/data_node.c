@@ -0,0 +1,386 @@
+#include <postgres.h>
+#include <fmgr.h>
+#include <funcapi.h>
+#include <access/htup_details.h>
+#include <access/xact.h>
+#include <catalog/pg_class.h>
+#include <catalog/pg_inherits_fn.h>
+#include <executor/spi.h>
+#include <foreign/foreign.h>
+#include <utils/acl.h>
+#include <utils/builtins.h>
+#include <utils/fmgroids.h>
+#include <utils/lsyscache.h>
+#include <miscadmin.h>
+
+#include "data_node.h"
+#include "chunk.h"
+#include "hypertable_cache.h"
+#include "errors.h"
+#include "scanner.h"
+#include "compat.h"
+
+/*
+ * Data nodes of distributed hypertables.
+ *
+ * A data node is a postgres_fdw foreign server that has a hypertable of the
+ * same name and definition as the local one. Once data nodes are attached to
+ * a hypertable, its new chunks are created as foreign tables on the data
+ * nodes, picked by the same round-robin over slices that is used for
+ * tablespaces. Rows are then inserted into, and scanned from, the data
+ * node's hypertable, which takes care of its own chunks and indexes. Before a
+ * chunk is dropped, its rows are deleted from the data node's hypertable.
+ *
+ * Queries are not distributed beyond that: aggregates are computed locally
+ * from the rows of each chunk.
+ */
+
+static int
+data_node_scan_internal(int32 hypertable_id, const char *node_name,
+						tuple_found_func tuple_found, void *data, LOCKMODE lockmode)
+{
+	Catalog    *catalog = catalog_get();
+	ScanKeyData scankey[2];
+	int			nkeys = 0;
+	ScannerCtx	scanctx = {
+		.table = catalog_table_get_id(catalog, HYPERTABLE_DATA_NODE),
+		.index = CATALOG_INDEX(catalog, HYPERTABLE_DATA_NODE, HYPERTABLE_DATA_NODE_PKEY_IDX),
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+	};
+
+	ScanKeyInit(&scankey[nkeys++],
+				Anum_hypertable_data_node_pkey_idx_hypertable_id,
+				BTEqualStrategyNumber, F_INT4EQ,
+				Int32GetDatum(hypertable_id));
+
+	if (NULL != node_name)
+		ScanKeyInit(&scankey[nkeys++],
+					Anum_hypertable_data_node_pkey_idx_node_name,
+					BTEqualStrategyNumber, F_NAMEEQ,
+					DirectFunctionCall1(namein, CStringGetDatum(node_name)));
+
+	scanctx.nkeys = nkeys;
+
+	return scanner_scan(&scanctx);
+}
+
+static bool
+data_node_tuple_found(TupleInfo *ti, void *data)
+{
+	List	  **nodes = data;
+	Form_hypertable_data_node form = (Form_hypertable_data_node) GETSTRUCT(ti->tuple);
+
+	*nodes = lappend(*nodes, pstrdup(NameStr(form->node_name)));
+
+	return true;
+}
+
+/*
+ * Get the names of the data nodes attached to a hypertable, in the order that
+ * chunks are assigned to them.
+ */
+List *
+data_node_scan(int32 hypertable_id)
+{
+	List	   *nodes = NIL;
+
+	data_node_scan_internal(hypertable_id, NULL, data_node_tuple_found, &nodes,
+							AccessShareLock);
+
+	return nodes;
+}
+
+static bool
+data_node_is_attached(int32 hypertable_id, const char *node_name)
+{
+	return data_node_scan_internal(hypertable_id, node_name, NULL, NULL,
+								   AccessShareLock) > 0;
+}
+
+static void
+data_node_insert(int32 hypertable_id, const char *node_name)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	Datum		values[Natts_hypertable_data_node];
+	bool		nulls[Natts_hypertable_data_node] = {false};
+	CatalogSecurityContext sec_ctx;
+
+	values[Anum_hypertable_data_node_hypertable_id - 1] = Int32GetDatum(hypertable_id);
+	values[Anum_hypertable_data_node_node_name - 1] =
+		DirectFunctionCall1(namein, CStringGetDatum(node_name));
+
+	rel = heap_open(catalog_table_get_id(catalog, HYPERTABLE_DATA_NODE), RowExclusiveLock);
+
+	catalog_become_owner(catalog, &sec_ctx);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+
+	heap_close(rel, RowExclusiveLock);
+}
+
+static bool
+data_node_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete_only(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+static int
+data_node_delete(int32 hypertable_id, const char *node_name)
+{
+	int			num_deleted;
+
+	num_deleted = data_node_scan_internal(hypertable_id, node_name,
+										  data_node_tuple_delete, NULL,
+										  RowExclusiveLock);
+
+	if (num_deleted > 0)
+		CommandCounterIncrement();
+
+	return num_deleted;
+}
+
+int
+data_node_delete_by_hypertable_id(int32 hypertable_id)
+{
+	return data_node_delete(hypertable_id, NULL);
+}
+
+/*
+ * Delete the rows of a chunk from its data node, before the chunk is dropped.
+ * Otherwise, they would remain in the data node's hypertable and show up
+ * again in any later chunk for the same range.
+ *
+ * The rows are deleted through the chunk's foreign table, whose scans are
+ * restricted to the chunk's hypercube, so postgres_fdw sends a DELETE with
+ * the chunk's dimension constraints to the data node. Does nothing for a
+ * chunk that is not on a data node.
+ */
+void
+data_node_chunk_delete_rows(Oid chunk_relid)
+{
+	StringInfoData command;
+
+	if (get_rel_relkind(chunk_relid) != RELKIND_FOREIGN_TABLE ||
+		NULL == chunk_get_by_relid(chunk_relid, 0, false))
+		return;
+
+	initStringInfo(&command);
+	appendStringInfo(&command, "DELETE FROM %s",
+					 quote_qualified_identifier(get_namespace_name(get_rel_namespace(chunk_relid)),
+												get_rel_name(chunk_relid)));
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "could not connect to SPI");
+
+	if (SPI_execute(command.data, false, 0) != SPI_OK_DELETE)
+		elog(ERROR, "could not delete the rows of chunk \"%s\" on its data node",
+			 get_rel_name(chunk_relid));
+
+	SPI_finish();
+}
+
+/*
+ * Delete the rows of all chunks of a hypertable from their data nodes, before
+ * the hypertable is dropped.
+ */
+void
+data_node_hypertable_delete_rows(Hypertable *ht)
+{
+	ListCell   *lc;
+
+	foreach(lc, find_inheritance_children(ht->main_table_relid, NoLock))
+		data_node_chunk_delete_rows(lfirst_oid(lc));
+}
+
+static Hypertable *
+data_node_get_hypertable(Cache *hcache, Oid hypertable_oid)
+{
+	Hypertable *ht = hypertable_cache_get_entry(hcache, hypertable_oid);
+
+	if (NULL == ht)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_HYPERTABLE_NOT_EXIST),
+				 errmsg("table \"%s\" is not a hypertable",
+						get_rel_name(hypertable_oid))));
+
+	return ht;
+}
+
+TS_FUNCTION_INFO_V1(data_node_attach);
+
+Datum
+data_node_attach(PG_FUNCTION_ARGS)
+{
+	Name		node_name = PG_ARGISNULL(0) ? NULL : PG_GETARG_NAME(0);
+	Oid			hypertable_oid = PG_ARGISNULL(1) ? InvalidOid : PG_GETARG_OID(1);
+	bool		if_not_attached = PG_ARGISNULL(2) ? false : PG_GETARG_BOOL(2);
+	ForeignServer *server;
+	ForeignDataWrapper *fdw;
+	Cache	   *hcache;
+	Hypertable *ht;
+	Oid			ownerid;
+	AclResult	aclresult;
+
+	if (NULL == node_name)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid data node name")));
+
+	if (!OidIsValid(hypertable_oid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid hypertable")));
+
+	server = GetForeignServerByName(NameStr(*node_name), true);
+
+	if (NULL == server)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("server \"%s\" does not exist", NameStr(*node_name)),
+				 errhint("The data node needs to be created as a foreign server"
+						 " before attaching it to a hypertable.")));
+
+	fdw = GetForeignDataWrapper(server->fdwid);
+
+	if (strcmp(fdw->fdwname, DATA_NODE_FDW_NAME) != 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("server \"%s\" does not use the foreign-data wrapper \"%s\"",
+						NameStr(*node_name), DATA_NODE_FDW_NAME)));
+
+	ownerid = hypertable_permissions_check(hypertable_oid, GetUserId());
+
+	/*
+	 * Chunks are created as the table owner, so the owner rather than the
+	 * current user needs to be able to use the server.
+	 */
+	aclresult = pg_foreign_server_aclcheck(server->serverid, ownerid, ACL_USAGE);
+
+	if (aclresult != ACLCHECK_OK)
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("permission denied for server \"%s\" by table owner \"%s\"",
+						NameStr(*node_name), GetUserNameFromId(ownerid, true))));
+
+	hcache = hypertable_cache_pin();
+	ht = data_node_get_hypertable(hcache, hypertable_oid);
+
+	if (!data_node_is_attached(ht->fd.id, NameStr(*node_name)))
+		data_node_insert(ht->fd.id, NameStr(*node_name));
+	else if (if_not_attached)
+		ereport(NOTICE,
+				(errcode(ERRCODE_IO_DATA_NODE_ALREADY_ATTACHED),
+				 errmsg("data node \"%s\" is already attached to hypertable \"%s\", skipping",
+						NameStr(*node_name), get_rel_name(hypertable_oid))));
+	else
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_DATA_NODE_ALREADY_ATTACHED),
+				 errmsg("data node \"%s\" is already attached to hypertable \"%s\"",
+						NameStr(*node_name), get_rel_name(hypertable_oid))));
+
+	cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Detaching a data node only stops new chunks from being created on it. The
+ * existing chunks on the node remain foreign tables that point to it.
+ */
+TS_FUNCTION_INFO_V1(data_node_detach);
+
+Datum
+data_node_detach(PG_FUNCTION_ARGS)
+{
+	Name		node_name = PG_ARGISNULL(0) ? NULL : PG_GETARG_NAME(0);
+	Oid			hypertable_oid = PG_ARGISNULL(1) ? InvalidOid : PG_GETARG_OID(1);
+	bool		if_attached = PG_ARGISNULL(2) ? false : PG_GETARG_BOOL(2);
+	Cache	   *hcache;
+	Hypertable *ht;
+	int			ret = 0;
+
+	if (NULL == node_name)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid data node name")));
+
+	if (!OidIsValid(hypertable_oid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid hypertable")));
+
+	hypertable_permissions_check(hypertable_oid, GetUserId());
+
+	hcache = hypertable_cache_pin();
+	ht = data_node_get_hypertable(hcache, hypertable_oid);
+
+	if (data_node_is_attached(ht->fd.id, NameStr(*node_name)))
+		ret = data_node_delete(ht->fd.id, NameStr(*node_name));
+	else if (if_attached)
+		ereport(NOTICE,
+				(errcode(ERRCODE_IO_DATA_NODE_NOT_ATTACHED),
+				 errmsg("data node \"%s\" is not attached to hypertable \"%s\", skipping",
+						NameStr(*node_name), get_rel_name(hypertable_oid))));
+	else
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_DATA_NODE_NOT_ATTACHED),
+				 errmsg("data node \"%s\" is not attached to hypertable \"%s\"",
+						NameStr(*node_name), get_rel_name(hypertable_oid))));
+
+	cache_release(hcache);
+
+	PG_RETURN_INT32(ret);
+}
+
+TS_FUNCTION_INFO_V1(data_node_show);
+
+Datum
+data_node_show(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	List	   *nodes;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		Oid			hypertable_oid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+		MemoryContext oldcontext;
+		Cache	   *hcache;
+		Hypertable *ht;
+
+		if (!OidIsValid(hypertable_oid))
+			elog(ERROR, "invalid argument");
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		hcache = hypertable_cache_pin();
+		ht = data_node_get_hypertable(hcache, hypertable_oid);
+		funcctx->user_fctx = data_node_scan(ht->fd.id);
+		cache_release(hcache);
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	nodes = funcctx->user_fctx;
+
+	if (funcctx->call_cntr < (uint64) list_length(nodes))
+	{
+		const char *node_name = list_nth(nodes, funcctx->call_cntr);
+
+		SRF_RETURN_NEXT(funcctx, DirectFunctionCall1(namein, CStringGetDatum(node_name)));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
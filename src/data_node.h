@@ -0,0 +1,18 @@
+#ifndef TIMESCALEDB_DATA_NODE_H
+#define TIMESCALEDB_DATA_NODE_H
+
+#include <postgres.h>
+#include <nodes/pg_list.h>
+
+#include "catalog.h"
+#include "hypertable.h"
+
+/* The foreign-data wrapper that data nodes must use */
+#define DATA_NODE_FDW_NAME "postgres_fdw"
+
+extern List *data_node_scan(int32 hypertable_id);
+extern int	data_node_delete_by_hypertable_id(int32 hypertable_id);
+extern void data_node_chunk_delete_rows(Oid chunk_relid);
+extern void data_node_hypertable_delete_rows(Hypertable *ht);
+
+#endif							/* TIMESCALEDB_DATA_NODE_H */
@@ -0,0 +1,356 @@
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/sysattr.h>
+#include <executor/executor.h>
+#include <nodes/extensible.h>
+#include <nodes/makefuncs.h>
+#include <nodes/plannodes.h>
+#include <optimizer/clauses.h>
+#include <optimizer/pathnode.h>
+#include <optimizer/plancat.h>
+#include <optimizer/prep.h>
+#include <optimizer/restrictinfo.h>
+#include <optimizer/var.h>
+#include <parser/parsetree.h>
+#include <utils/lsyscache.h>
+#include <utils/rel.h>
+#include <commands/explain.h>
+
+#include "compat-msvc-enter.h"
+#include <optimizer/cost.h>
+#include "compat-msvc-exit.h"
+
+#include "chunk.h"
+#include "compress_chunk.h"
+#include "decompress_scan.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "compat.h"
+
+/*
+ * DecompressChunk scans a compressed chunk of a hypertable.
+ *
+ * The node returns the rows of the batches in the chunk's compressed table,
+ * decompressing only the columns that the query needs, and then the rows that
+ * were inserted into the chunk table after it was compressed. The rows are
+ * filtered by the scan's quals like those of a sequential scan.
+ *
+ * Rows of compressed batches cannot be locked, updated or deleted, since they
+ * have no tuple of their own. Such queries fail when they are planned.
+ */
+
+static TupleTableSlot *
+decompress_chunk_next(ScanState *node)
+{
+	DecompressChunkState *state = (DecompressChunkState *) node;
+	TupleTableSlot *slot = node->ss_ScanTupleSlot;
+	HeapTuple	tuple;
+
+	while (!state->compressed_done)
+	{
+		ExecClearTuple(slot);
+
+		if (state->batch_loaded &&
+			compressed_batch_next(state->batch, slot->tts_values, slot->tts_isnull))
+			return ExecStoreVirtualTuple(slot);
+
+		tuple = heap_getnext(state->compressed_scan, ForwardScanDirection);
+
+		if (NULL == tuple)
+		{
+			state->compressed_done = true;
+			break;
+		}
+
+		compressed_batch_load(state->batch, tuple);
+		state->batch_loaded = true;
+	}
+
+	tuple = heap_getnext(state->chunk_scan, ForwardScanDirection);
+
+	if (NULL == tuple)
+		return ExecClearTuple(slot);
+
+	return ExecStoreTuple(tuple, slot, state->chunk_scan->rs_cbuf, false);
+}
+
+static bool
+decompress_chunk_recheck(ScanState *node, TupleTableSlot *slot)
+{
+	return true;
+}
+
+static void
+decompress_chunk_begin(CustomScanState *node, EState *estate, int eflags)
+{
+	DecompressChunkState *state = (DecompressChunkState *) node;
+	CustomScan *cscan = (CustomScan *) node->ss.ps.plan;
+	Oid			compressed_relid = linitial_oid(linitial(cscan->custom_private));
+	Bitmapset  *attnos = NULL;
+	ListCell   *lc;
+
+	foreach(lc, lsecond(cscan->custom_private))
+		attnos = bms_add_member(attnos, lfirst_int(lc));
+
+	state->compressed_rel = heap_open(compressed_relid, AccessShareLock);
+	state->batch = compressed_batch_create(node->ss.ss_currentRelation,
+										   state->compressed_rel,
+										   attnos);
+	state->compressed_scan = heap_beginscan(state->compressed_rel, estate->es_snapshot, 0, NULL);
+	state->chunk_scan = heap_beginscan(node->ss.ss_currentRelation, estate->es_snapshot, 0, NULL);
+}
+
+static TupleTableSlot *
+decompress_chunk_exec(CustomScanState *node)
+{
+	return ExecScan(&node->ss,
+					(ExecScanAccessMtd) decompress_chunk_next,
+					(ExecScanRecheckMtd) decompress_chunk_recheck);
+}
+
+static void
+decompress_chunk_end(CustomScanState *node)
+{
+	DecompressChunkState *state = (DecompressChunkState *) node;
+
+	ExecClearTuple(node->ss.ss_ScanTupleSlot);
+	heap_endscan(state->chunk_scan);
+	heap_endscan(state->compressed_scan);
+	heap_close(state->compressed_rel, NoLock);
+}
+
+static void
+decompress_chunk_rescan(CustomScanState *node)
+{
+	DecompressChunkState *state = (DecompressChunkState *) node;
+
+	heap_rescan(state->compressed_scan, NULL);
+	heap_rescan(state->chunk_scan, NULL);
+	state->batch_loaded = false;
+	state->compressed_done = false;
+
+	ExecScanReScan(&node->ss);
+}
+
+static void
+decompress_chunk_explain(CustomScanState *node,
+						 List *ancestors,
+						 ExplainState *es)
+{
+	DecompressChunkState *state = (DecompressChunkState *) node;
+
+	ExplainPropertyText("Compressed Table", RelationGetRelationName(state->compressed_rel), es);
+}
+
+static CustomExecMethods decompress_chunk_state_methods = {
+	.BeginCustomScan = decompress_chunk_begin,
+	.ExecCustomScan = decompress_chunk_exec,
+	.EndCustomScan = decompress_chunk_end,
+	.ReScanCustomScan = decompress_chunk_rescan,
+	.ExplainCustomScan = decompress_chunk_explain,
+};
+
+static Node *
+decompress_chunk_state_create(CustomScan *cscan)
+{
+	DecompressChunkState *state;
+
+	state = (DecompressChunkState *) newNode(sizeof(DecompressChunkState), T_CustomScanState);
+	state->csstate.methods = &decompress_chunk_state_methods;
+
+	return (Node *) state;
+}
+
+static CustomScanMethods decompress_chunk_plan_methods = {
+	.CustomName = "DecompressChunk",
+	.CreateCustomScanState = decompress_chunk_state_create,
+};
+
+/*
+ * The columns that the scan needs, offset by
+ * FirstLowInvalidHeapAttributeNumber. The planner might give the scan a
+ * target list with all columns of the chunk, so the columns are those of the
+ * relation's target list and the scan's quals.
+ */
+static Bitmapset *
+decompress_chunk_needed_attnos(RelOptInfo *rel, List *clauses)
+{
+	Bitmapset  *attnos = NULL;
+
+	pull_varattnos((Node *) rel->reltarget->exprs, rel->relid, &attnos);
+	pull_varattnos((Node *) clauses, rel->relid, &attnos);
+
+	return attnos;
+}
+
+static Plan *
+decompress_chunk_plan_create(PlannerInfo *root,
+							 RelOptInfo *rel,
+							 struct CustomPath *path,
+							 List *tlist,
+							 List *clauses,
+							 List *custom_plans)
+{
+	CustomScan *cscan = makeNode(CustomScan);
+	Oid			compressed_relid = linitial_oid(path->custom_private);
+	Bitmapset  *attnos;
+	List	   *attno_list = NIL;
+	int			attno = -1;
+
+	clauses = extract_actual_clauses(clauses, false);
+	attnos = decompress_chunk_needed_attnos(rel, clauses);
+
+	while ((attno = bms_next_member(attnos, attno)) >= 0)
+		attno_list = lappend_int(attno_list, attno);
+
+	cscan->scan.scanrelid = rel->relid;
+	cscan->scan.plan.targetlist = tlist;
+	cscan->scan.plan.qual = clauses;
+	cscan->custom_private = list_make2(list_make1_oid(compressed_relid), attno_list);
+	cscan->flags = path->flags;
+	cscan->methods = &decompress_chunk_plan_methods;
+
+	return &cscan->scan.plan;
+}
+
+static CustomPathMethods decompress_chunk_path_methods = {
+	.CustomName = "DecompressChunk",
+	.PlanCustomPath = decompress_chunk_plan_create,
+};
+
+/*
+ * Replace the paths of a compressed chunk with a DecompressChunk path.
+ *
+ * The chunk table only has the rows inserted after compression, so the
+ * estimated compressed rows are added to the estimates of the chunk and of
+ * the hypertable.
+ */
+static void
+decompress_chunk_add_path(PlannerInfo *root, RelOptInfo *rel, AppendRelInfo *appinfo,
+						  CompressedChunk *cc)
+{
+	DecompressChunkPath *path;
+	RelOptInfo *parent = root->simple_rel_array[appinfo->parent_relid];
+	Selectivity selectivity = clauselist_selectivity(root, rel->baserestrictinfo, 0, JOIN_INNER, NULL);
+	double		compressed_rows = clamp_row_est(cc->fd.num_rows * selectivity);
+	double		rows = compressed_rows + rel->rows;
+	Cost		cpu_per_row = cpu_tuple_cost + rel->baserestrictcost.per_tuple;
+
+	if (NULL != parent)
+		parent->rows += compressed_rows;
+
+	path = (DecompressChunkPath *) newNode(sizeof(DecompressChunkPath), T_CustomPath);
+	path->cpath.path.pathtype = T_CustomScan;
+	path->cpath.path.parent = rel;
+	path->cpath.path.pathtarget = rel->reltarget;
+	path->cpath.path.param_info = get_baserel_parampathinfo(root, rel, rel->lateral_relids);
+	path->cpath.path.parallel_aware = false;
+	path->cpath.path.parallel_safe = false;
+	path->cpath.path.rows = rows;
+
+	/* Decompressing a row costs an operator evaluation per column */
+	path->cpath.path.startup_cost = rel->baserestrictcost.startup;
+	path->cpath.path.total_cost = path->cpath.path.startup_cost +
+		seq_page_cost * rel->pages +
+		cpu_per_row * rel->tuples +
+		(cpu_per_row + cpu_operator_cost * list_length(rel->reltarget->exprs)) * cc->fd.num_rows;
+
+	path->cpath.flags = 0;
+	path->cpath.custom_private = list_make1_oid(cc->compressed_relid);
+	path->cpath.methods = &decompress_chunk_path_methods;
+
+	rel->rows = rows;
+	rel->pathlist = NIL;
+	rel->partial_pathlist = NIL;
+	add_path(rel, &path->cpath.path);
+}
+
+static AppendRelInfo *
+get_appinfo(PlannerInfo *root, Index child_relid)
+{
+	ListCell   *lc;
+
+	foreach(lc, root->append_rel_list)
+	{
+		AppendRelInfo *appinfo = lfirst(lc);
+
+		if (appinfo->child_relid == child_relid)
+			return appinfo;
+	}
+
+	return NULL;
+}
+
+/*
+ * Plan the scan of a chunk of a hypertable, or of a chunk that is the result
+ * relation of an UPDATE or DELETE on a hypertable, if the chunk is
+ * compressed.
+ */
+void
+decompress_chunk_set_rel_pathlist(PlannerInfo *root, RelOptInfo *rel, Index rti, RangeTblEntry *rte)
+{
+	AppendRelInfo *appinfo = get_appinfo(root, rti);
+	Cache	   *hcache;
+	Hypertable *ht;
+	Chunk	   *chunk;
+	CompressedChunk *cc;
+	PlanRowMark *rowmark;
+	Bitmapset  *attnos;
+	int			first_attno;
+
+	if (NULL == appinfo)
+		return;
+
+	hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry(hcache, appinfo->parent_reloid);
+
+	if (NULL == ht || !ht->has_compressed_chunks || rte->relid == ht->main_table_relid)
+	{
+		cache_release(hcache);
+		return;
+	}
+
+	cache_release(hcache);
+
+	chunk = chunk_get_by_relid(rte->relid, 0, false);
+
+	if (NULL == chunk)
+		return;
+
+	cc = compressed_chunk_get_by_chunk_id(chunk->fd.id);
+
+	if (NULL == cc)
+		return;
+
+	if (rti == root->parse->resultRelation)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot update or delete rows of compressed chunk \"%s\"",
+						get_rel_name(rte->relid)),
+				 errhint("Decompress the chunk with decompress_chunk() first.")));
+
+	rowmark = get_plan_rowmark(root->rowMarks, rti);
+
+	if (NULL != rowmark && rowmark->markType != ROW_MARK_COPY)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot lock rows of compressed chunk \"%s\"",
+						get_rel_name(rte->relid)),
+				 errhint("Decompress the chunk with decompress_chunk() first.")));
+
+	attnos = decompress_chunk_needed_attnos(rel, extract_actual_clauses(rel->baserestrictinfo, false));
+
+	first_attno = bms_next_member(attnos, -1);
+
+	if (first_attno >= 0 && first_attno < 0 - FirstLowInvalidHeapAttributeNumber)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot select system columns of compressed chunk \"%s\"",
+						get_rel_name(rte->relid))));
+
+	if (!OidIsValid(cc->compressed_relid))
+		elog(ERROR, "compressed table \"%s.%s\" of chunk \"%s\" does not exist",
+			 NameStr(cc->fd.schema_name), NameStr(cc->fd.table_name), get_rel_name(rte->relid));
+
+	decompress_chunk_add_path(root, rel, appinfo, cc);
+}
@@ -0,0 +1,29 @@
+#ifndef TIMESCALEDB_DECOMPRESS_SCAN_H
+#define TIMESCALEDB_DECOMPRESS_SCAN_H
+
+#include <postgres.h>
+#include <access/relscan.h>
+#include <nodes/extensible.h>
+#include <nodes/relation.h>
+
+typedef struct CompressedBatch CompressedBatch;
+
+typedef struct DecompressChunkPath
+{
+	CustomPath	cpath;
+} DecompressChunkPath;
+
+typedef struct DecompressChunkState
+{
+	CustomScanState csstate;
+	Relation	compressed_rel;
+	CompressedBatch *batch;
+	HeapScanDesc compressed_scan;
+	HeapScanDesc chunk_scan;
+	bool		batch_loaded;
+	bool		compressed_done;
+} DecompressChunkState;
+
+extern void decompress_chunk_set_rel_pathlist(PlannerInfo *root, RelOptInfo *rel, Index rti, RangeTblEntry *rte);
+
+#endif							/* TIMESCALEDB_DECOMPRESS_SCAN_H */
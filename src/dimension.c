@@ -84,7 +84,7 @@ hyperspace_get_dimension(Hyperspace *hs, DimensionType type, Index n)
 	return NULL;
 }
 
-static int
+int
 hyperspace_get_num_dimensions_by_type(Hyperspace *hs, DimensionType type)
 {
 	int			i;
@@ -145,8 +145,13 @@ dimension_fill_in_from_tuple(Dimension *d, TupleInfo *ti, Oid main_table_relid)
 												   main_table_relid);
 	}
 	else
+	{
 		d->fd.interval_length = DatumGetInt64(values[Anum_dimension_interval_length - 1]);
 
+		/* Resolve the conversion of the column's values once, not per row */
+		d->time_to_internal = time_value_to_internal_func(d->fd.column_type);
+	}
+
 	d->column_attno = get_attnum(main_table_relid, NameStr(d->fd.column_name));
 }
 
@@ -319,8 +324,8 @@ dimension_scan_internal(ScanKeyData *scankey,
 {
 	Catalog    *catalog = catalog_get();
 	ScannerCtx	scanctx = {
-		.table = catalog->tables[DIMENSION].id,
-		.index = catalog->tables[DIMENSION].index_ids[DIMENSION_HYPERTABLE_ID_IDX],
+		.table = catalog_table_get_id(catalog, DIMENSION),
+		.index = CATALOG_INDEX(catalog, DIMENSION, DIMENSION_HYPERTABLE_ID_IDX),
 		.nkeys = nkeys,
 		.limit = limit,
 		.scankey = scankey,
@@ -364,8 +369,8 @@ dimension_scan_update(int32 dimension_id, tuple_found_func tuple_found, void *da
 	Catalog    *catalog = catalog_get();
 	ScanKeyData scankey[1];
 	ScannerCtx	scanctx = {
-		.table = catalog->tables[DIMENSION].id,
-		.index = catalog->tables[DIMENSION].index_ids[DIMENSION_ID_IDX],
+		.table = catalog_table_get_id(catalog, DIMENSION),
+		.index = CATALOG_INDEX(catalog, DIMENSION, DIMENSION_ID_IDX),
 		.nkeys = 1,
 		.limit = 1,
 		.scankey = scankey,
@@ -501,7 +506,7 @@ dimension_insert(int32 hypertable_id,
 	Catalog    *catalog = catalog_get();
 	Relation	rel;
 
-	rel = heap_open(catalog->tables[DIMENSION].id, RowExclusiveLock);
+	rel = heap_open(catalog_table_get_id(catalog, DIMENSION), RowExclusiveLock);
 	dimension_insert_relation(rel, hypertable_id, colname, coltype, num_slices, partitioning_func, interval_length);
 	heap_close(rel, RowExclusiveLock);
 }
@@ -522,7 +527,7 @@ dimension_set_name(Dimension *dim, const char *newname)
 	return dimension_scan_update(dim->fd.id, dimension_tuple_update, dim, RowExclusiveLock);
 }
 
-static Point *
+Point *
 point_create(int16 num_dimensions)
 {
 	Point	   *p = palloc0(POINT_SIZE(num_dimensions));
@@ -533,6 +538,30 @@ point_create(int16 num_dimensions)
 	return p;
 }
 
+static inline int64
+dimension_calculate_coordinate(Dimension *d, Datum datum, bool isnull)
+{
+	if (IS_OPEN_DIMENSION(d))
+	{
+		if (isnull)
+			ereport(ERROR,
+					(errcode(ERRCODE_NOT_NULL_VIOLATION),
+					 errmsg("null value in column \"%s\" violates not-null constraint",
+							NameStr(d->fd.column_name)),
+					 errhint("Columns used for time partitioning can not be NULL")));
+
+		if (NULL != d->time_to_internal)
+			return d->time_to_internal(datum);
+
+		return time_value_to_internal(datum, d->fd.column_type);
+	}
+
+	if (isnull)
+		return 0;
+
+	return partitioning_func_apply(d->partitioning, datum);
+}
+
 Point *
 hyperspace_calculate_point(Hyperspace *hs, HeapTuple tuple, TupleDesc tupdesc)
 {
@@ -542,46 +571,64 @@ hyperspace_calculate_point(Hyperspace *hs, HeapTuple tuple, TupleDesc tupdesc)
 	for (i = 0; i < hs->num_dimensions; i++)
 	{
 		Dimension  *d = &hs->dimensions[i];
+		Datum		datum;
+		bool		isnull;
 
-		if (IS_OPEN_DIMENSION(d))
-		{
-			Datum		datum;
-			bool		isnull;
+		datum = heap_getattr(tuple, d->column_attno, tupdesc, &isnull);
+		p->coordinates[p->num_coords++] = dimension_calculate_coordinate(d, datum, isnull);
+	}
 
-			datum = heap_getattr(tuple, d->column_attno, tupdesc, &isnull);
+	return p;
+}
 
-			if (isnull)
-				ereport(ERROR,
-						(errcode(ERRCODE_NOT_NULL_VIOLATION),
-						 errmsg("null value in column \"%s\" violates not-null constraint",
-								NameStr(d->fd.column_name)),
-						 errhint("Columns used for time partitioning can not be NULL")));
+/*
+ * Calculate a point from a row that is already deformed into values and
+ * nulls arrays indexed by attribute number (minus one), e.g., the row parsed
+ * by COPY or the contents of a virtual tuple table slot. This avoids forming
+ * and then deforming a tuple just to read the partitioning columns.
+ *
+ * If a point is given, it is reused instead of allocating a new one.
+ */
+Point *
+hyperspace_calculate_point_from_values(Hyperspace *hs, Datum *values, bool *nulls, Point *p)
+{
+	int			i;
 
-			p->coordinates[p->num_coords++] = time_value_to_internal(datum, d->fd.column_type);
-		}
-		else
-		{
-			p->coordinates[p->num_coords++] =
-				partitioning_func_apply_tuple(d->partitioning, tuple, tupdesc);
-		}
+	if (NULL == p)
+		p = point_create(hs->num_dimensions);
+
+	Assert(p->cardinality == hs->num_dimensions);
+	p->num_coords = 0;
+
+	for (i = 0; i < hs->num_dimensions; i++)
+	{
+		Dimension  *d = &hs->dimensions[i];
+		AttrNumber	attno = d->column_attno;
+
+		p->coordinates[p->num_coords++] =
+			dimension_calculate_coordinate(d, values[AttrNumberGetAttrOffset(attno)],
+										   nulls[AttrNumberGetAttrOffset(attno)]);
 	}
 
 	return p;
 }
 
-static inline int64
-interval_to_usec(Interval *interval)
+/*
+ * Get the highest attribute number of any partitioning column, i.e., the
+ * number of attributes that need to be deformed to calculate a point.
+ */
+AttrNumber
+hyperspace_max_column_attno(Hyperspace *hs)
 {
-	return (interval->month * DAYS_PER_MONTH * USECS_PER_DAY)
-		+ (interval->day * USECS_PER_DAY)
-		+ interval->time;
-}
+	AttrNumber	max_attno = InvalidAttrNumber;
+	int			i;
 
-#define IS_INTEGER_TYPE(type)							\
-	(type == INT2OID || type == INT4OID || type == INT8OID)
+	for (i = 0; i < hs->num_dimensions; i++)
+		if (hs->dimensions[i].column_attno > max_attno)
+			max_attno = hs->dimensions[i].column_attno;
 
-#define IS_TIMESTAMP_TYPE(type)									\
-	(type == TIMESTAMPOID || type == TIMESTAMPTZOID || type == DATEOID)
+	return max_attno;
+}
 
 #define IS_VALID_OPEN_DIM_TYPE(type)					\
 	(IS_INTEGER_TYPE(type) || IS_TIMESTAMP_TYPE(type))
@@ -610,7 +657,7 @@ get_validated_integer_interval(Oid coltype, int64 value)
 	return value;
 }
 
-static int64
+int64
 dimension_interval_to_internal(const char *colname, Oid coltype, Oid valuetype, Datum value)
 {
 	int64		interval;
@@ -764,6 +811,20 @@ dimension_update(FunctionCallInfo fcinfo,
 	cache_release(hcache);
 }
 
+/*
+ * Set the interval of an open dimension, e.g., as calculated by adaptive
+ * chunking. Existing slices keep their ranges.
+ */
+void
+dimension_set_chunk_interval(Dimension *dim, int64 interval)
+{
+	Assert(IS_OPEN_DIMENSION(dim));
+	Assert(interval > 0);
+
+	dim->fd.interval_length = interval;
+	dimension_scan_update(dim->fd.id, dimension_tuple_update, dim, RowExclusiveLock);
+}
+
 TS_FUNCTION_INFO_V1(dimension_set_num_slices);
 
 Datum
@@ -6,6 +6,7 @@
 #include <access/htup_details.h>
 
 #include "catalog.h"
+#include "utils.h"
 
 typedef struct PartitioningInfo PartitioningInfo;
 typedef struct DimensionSlice DimensionSlice;
@@ -25,9 +26,17 @@ typedef struct Dimension
 	AttrNumber	column_attno;
 	Oid			main_table_relid;
 	PartitioningInfo *partitioning;
+	TimeValueToInternalFunc time_to_internal;	/* for the column type of an
+												 * open dimension */
 } Dimension;
 
 
+#define IS_INTEGER_TYPE(type)							\
+	(type == INT2OID || type == INT4OID || type == INT8OID)
+
+#define IS_TIMESTAMP_TYPE(type)									\
+	(type == TIMESTAMPOID || type == TIMESTAMPTZOID || type == DATEOID)
+
 #define IS_OPEN_DIMENSION(d)					\
 	((d)->type == DIMENSION_TYPE_OPEN)
 
@@ -96,13 +105,19 @@ typedef struct DimensionInfo
 
 extern Hyperspace *dimension_scan(int32 hypertable_id, Oid main_table_relid, int16 num_dimension);
 extern DimensionSlice *dimension_calculate_default_slice(Dimension *dim, int64 value);
+extern Point *point_create(int16 num_dimensions);
 extern Point *hyperspace_calculate_point(Hyperspace *h, HeapTuple tuple, TupleDesc tupdesc);
+extern Point *hyperspace_calculate_point_from_values(Hyperspace *hs, Datum *values, bool *nulls, Point *p);
+extern AttrNumber hyperspace_max_column_attno(Hyperspace *hs);
+extern int	hyperspace_get_num_dimensions_by_type(Hyperspace *hs, DimensionType type);
 extern Dimension *hyperspace_get_dimension_by_id(Hyperspace *hs, int32 id);
 extern Dimension *hyperspace_get_dimension(Hyperspace *hs, DimensionType type, Index n);
 extern Dimension *hyperspace_get_dimension_by_name(Hyperspace *hs, DimensionType type, const char *name);
 extern DimensionVec *dimension_get_slices(Dimension *dim);
 extern int	dimension_set_type(Dimension *dim, Oid newtype);
 extern int	dimension_set_name(Dimension *dim, const char *newname);
+extern void dimension_set_chunk_interval(Dimension *dim, int64 interval);
+extern int64 dimension_interval_to_internal(const char *colname, Oid coltype, Oid valuetype, Datum value);
 extern int	dimension_delete_by_hypertable_id(int32 hypertable_id, bool delete_slices);
 extern void dimension_validate_info(DimensionInfo *info);
 extern void dimension_add_from_info(DimensionInfo *info);
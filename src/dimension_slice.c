@@ -117,8 +117,8 @@ dimension_slice_scan_limit_internal(int indexid,
 {
 	Catalog    *catalog = catalog_get();
 	ScannerCtx	scanCtx = {
-		.table = catalog->tables[DIMENSION_SLICE].id,
-		.index = catalog->tables[DIMENSION_SLICE].index_ids[indexid],
+		.table = catalog_table_get_id(catalog, DIMENSION_SLICE),
+		.index = CATALOG_INDEX(catalog, DIMENSION_SLICE, indexid),
 		.nkeys = nkeys,
 		.scankey = scankey,
 		.data = scandata,
@@ -195,6 +195,36 @@ dimension_slice_collision_scan_limit(int32 dimension_id, int64 range_start, int6
 	return dimension_vec_sort(&slices);
 }
 
+/*
+ * Scan for slices that end at or before the given coordinate, i.e., slices
+ * that only cover values less than the coordinate.
+ *
+ * Returns a dimension vector of the slices.
+ */
+DimensionVec *
+dimension_slice_scan_ending_before(int32 dimension_id, int64 range_end, int limit)
+{
+	ScanKeyData scankey[3];
+	DimensionVec *slices = dimension_vec_create(limit > 0 ? limit : DIMENSION_VEC_DEFAULT_SIZE);
+
+	ScanKeyInit(&scankey[0], Anum_dimension_slice_dimension_id_range_start_range_end_idx_dimension_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(dimension_id));
+	ScanKeyInit(&scankey[1], Anum_dimension_slice_dimension_id_range_start_range_end_idx_range_start,
+				BTLessStrategyNumber, F_INT8LT, Int64GetDatum(range_end));
+	ScanKeyInit(&scankey[2], Anum_dimension_slice_dimension_id_range_start_range_end_idx_range_end,
+				BTLessEqualStrategyNumber, F_INT8LE, Int64GetDatum(range_end));
+
+	dimension_slice_scan_limit_internal(DIMENSION_SLICE_DIMENSION_ID_RANGE_START_RANGE_END_IDX,
+										scankey,
+										3,
+										dimension_vec_tuple_found,
+										&slices,
+										limit,
+										AccessShareLock);
+
+	return dimension_vec_sort(&slices);
+}
+
 DimensionVec *
 dimension_slice_scan_by_dimension(int32 dimension_id, int limit)
 {
@@ -336,6 +366,34 @@ dimension_slice_scan_by_id(int32 dimension_slice_id)
 	return slice;
 }
 
+/*
+ * Scan for the dimension slices with the given IDs in a single index scan.
+ *
+ * Returns the found slices ordered by ID.
+ */
+DimensionVec *
+dimension_slice_scan_by_ids(int32 *dimension_slice_ids, int num_ids)
+{
+	DimensionVec *slices = dimension_vec_create(num_ids > 0 ? num_ids : DIMENSION_VEC_DEFAULT_SIZE);
+	ScanKeyData scankey[1];
+
+	if (num_ids == 0)
+		return slices;
+
+	scanner_scankey_init_int32_array(&scankey[0], Anum_dimension_slice_id_idx_id,
+									 dimension_slice_ids, num_ids);
+
+	dimension_slice_scan_limit_internal(DIMENSION_SLICE_ID_IDX,
+										scankey,
+										1,
+										dimension_vec_tuple_found,
+										&slices,
+										0,
+										AccessShareLock);
+
+	return slices;
+}
+
 DimensionSlice *
 dimension_slice_copy(const DimensionSlice *original)
 {
@@ -430,18 +488,16 @@ dimension_slice_free(DimensionSlice *slice)
 }
 
 static bool
-dimension_slice_insert_relation(Relation rel, DimensionSlice *slice)
+dimension_slice_insert_relation(Relation rel, CatalogIndexState indstate, DimensionSlice *slice)
 {
 	TupleDesc	desc = RelationGetDescr(rel);
 	Datum		values[Natts_dimension_slice];
 	bool		nulls[Natts_dimension_slice] = {false};
-	CatalogSecurityContext sec_ctx;
 
 	if (slice->fd.id > 0)
 		/* Slice already exists in table */
 		return false;
 
-	catalog_become_owner(catalog_get(), &sec_ctx);
 	memset(values, 0, sizeof(values));
 	slice->fd.id = catalog_table_next_seq_id(catalog_get(), DIMENSION_SLICE);
 	values[Anum_dimension_slice_id - 1] = Int32GetDatum(slice->fd.id);
@@ -449,26 +505,39 @@ dimension_slice_insert_relation(Relation rel, DimensionSlice *slice)
 	values[Anum_dimension_slice_range_start - 1] = Int64GetDatum(slice->fd.range_start);
 	values[Anum_dimension_slice_range_end - 1] = Int64GetDatum(slice->fd.range_end);
 
-	catalog_insert_values(rel, desc, values, nulls);
-	catalog_restore_user(&sec_ctx);
+	catalog_insert_values_with_info(rel, indstate, desc, values, nulls);
 
 	return true;
 }
 
 /*
  * Insert slices into the catalog.
+ *
+ * The catalog table and its indexes are opened once for all slices, and the
+ * new slices are made visible together.
  */
 void
 dimension_slice_insert_multi(DimensionSlice **slices, Size num_slices)
 {
 	Catalog    *catalog = catalog_get();
+	CatalogSecurityContext sec_ctx;
+	CatalogIndexState indstate;
 	Relation	rel;
 	Size		i;
+	bool		inserted = false;
 
-	rel = heap_open(catalog->tables[DIMENSION_SLICE].id, RowExclusiveLock);
+	rel = heap_open(catalog_table_get_id(catalog, DIMENSION_SLICE), RowExclusiveLock);
+	indstate = CatalogOpenIndexes(rel);
+	catalog_become_owner(catalog, &sec_ctx);
 
 	for (i = 0; i < num_slices; i++)
-		dimension_slice_insert_relation(rel, slices[i]);
+		if (dimension_slice_insert_relation(rel, indstate, slices[i]))
+			inserted = true;
 
+	catalog_restore_user(&sec_ctx);
+	CatalogCloseIndexes(indstate);
 	heap_close(rel, RowExclusiveLock);
+
+	if (inserted)
+		CommandCounterIncrement();
 }
@@ -29,6 +29,8 @@ extern DimensionVec *dimension_slice_collision_scan_limit(int32 dimension_id, in
 extern Hypercube *dimension_slice_point_scan(Hyperspace *space, int64 point[]);
 extern DimensionSlice *dimension_slice_scan_for_existing(DimensionSlice *slice);
 extern DimensionSlice *dimension_slice_scan_by_id(int32 dimension_slice_id);
+extern DimensionVec *dimension_slice_scan_by_ids(int32 *dimension_slice_ids, int num_ids);
+extern DimensionVec *dimension_slice_scan_ending_before(int32 dimension_id, int64 range_end, int limit);
 extern DimensionVec *dimension_slice_scan_by_dimension(int32 dimension_id, int limit);
 extern int	dimension_slice_delete_by_dimension_id(int32 dimension_id, bool delete_constraints);
 extern int	dimension_slice_delete_by_id(int32 dimension_slice_id, bool delete_constraints);
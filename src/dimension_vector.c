@@ -18,6 +18,23 @@ cmp_coordinate_and_slice(const void *left, const void *right)
 	return dimension_slice_cmp_coordinate(slice, coord);
 }
 
+#if defined(USE_ASSERT_CHECKING)
+static inline bool
+dimension_vec_is_sorted(DimensionVec *vec)
+{
+	int			i;
+
+	if (vec->num_slices < 2)
+		return true;
+
+	for (i = 1; i < vec->num_slices; i++)
+		if (cmp_slices(&vec->slices[i - 1], &vec->slices[i]) > 0)
+			return false;
+
+	return true;
+}
+#endif
+
 static DimensionVec *
 dimension_vec_expand(DimensionVec *vec, int32 new_capacity)
 {
@@ -34,6 +51,17 @@ dimension_vec_expand(DimensionVec *vec, int32 new_capacity)
 	return vec;
 }
 
+/*
+ * Grow the vector geometrically, so that adding N slices one at a time
+ * requires only O(log N) reallocations.
+ */
+static inline DimensionVec *
+dimension_vec_grow(DimensionVec *vec)
+{
+	return dimension_vec_expand(vec, vec->capacity < DIMENSION_VEC_DEFAULT_SIZE ?
+								DIMENSION_VEC_DEFAULT_SIZE : vec->capacity * 2);
+}
+
 DimensionVec *
 dimension_vec_create(int32 initial_num_slices)
 {
@@ -64,20 +92,59 @@ dimension_vec_add_slice(DimensionVec **vecptr, DimensionSlice *slice)
 	Assert(vec->num_slices == 0 || vec->slices[0]->fd.dimension_id == slice->fd.dimension_id);
 
 	if (vec->num_slices + 1 > vec->capacity)
-		*vecptr = vec = dimension_vec_expand(vec, vec->capacity + 10);
+		*vecptr = vec = dimension_vec_grow(vec);
 
 	vec->slices[vec->num_slices++] = slice;
 
 	return vec;
 }
 
+/*
+ * Find the index at which a slice should be inserted to keep the vector
+ * sorted. Equal slices are inserted after existing ones.
+ */
+static int32
+dimension_vec_insert_position(DimensionVec *vec, const DimensionSlice *slice)
+{
+	int32		low = 0;
+	int32		high = vec->num_slices;
+
+	while (low < high)
+	{
+		int32		mid = low + (high - low) / 2;
+
+		if (dimension_slice_cmp(vec->slices[mid], slice) <= 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+/*
+ * Add a slice to an already sorted vector, keeping it sorted.
+ */
 DimensionVec *
 dimension_vec_add_slice_sort(DimensionVec **vecptr, DimensionSlice *slice)
 {
-	DimensionVec *vec;
+	DimensionVec *vec = *vecptr;
+	int32		pos;
+
+	Assert(vec->num_slices == 0 || vec->slices[0]->fd.dimension_id == slice->fd.dimension_id);
+	Assert(dimension_vec_is_sorted(vec));
+
+	if (vec->num_slices + 1 > vec->capacity)
+		*vecptr = vec = dimension_vec_grow(vec);
+
+	pos = dimension_vec_insert_position(vec, slice);
+
+	memmove(vec->slices + pos + 1, vec->slices + pos,
+			sizeof(DimensionSlice *) * (vec->num_slices - pos));
+	vec->slices[pos] = slice;
+	vec->num_slices++;
 
-	*vecptr = vec = dimension_vec_add_slice(vecptr, slice);
-	return dimension_vec_sort(vecptr);
+	return vec;
 }
 
 void
@@ -86,27 +153,10 @@ dimension_vec_remove_slice(DimensionVec **vecptr, int32 index)
 	DimensionVec *vec = *vecptr;
 
 	dimension_slice_free(vec->slices[index]);
-	memcpy(vec->slices + index, vec->slices + (index + 1), sizeof(DimensionSlice *) * (vec->num_slices - index - 1));
+	memmove(vec->slices + index, vec->slices + (index + 1), sizeof(DimensionSlice *) * (vec->num_slices - index - 1));
 	vec->num_slices--;
 }
 
-#if defined(USE_ASSERT_CHECKING)
-static inline bool
-dimension_vec_is_sorted(DimensionVec *vec)
-{
-	int			i;
-
-	if (vec->num_slices < 2)
-		return true;
-
-	for (i = 1; i < vec->num_slices; i++)
-		if (cmp_slices(&vec->slices[i - 1], &vec->slices[i]) > 0)
-			return false;
-
-	return true;
-}
-#endif
-
 DimensionSlice *
 dimension_vec_find_slice(DimensionVec *vec, int64 coordinate)
 {
@@ -138,6 +188,29 @@ dimension_vec_find_slice_index(DimensionVec *vec, int32 dimension_slice_id)
 	return -1;
 }
 
+/*
+ * Find the index of the slice that encloses the given coordinate. Returns -1
+ * if there is no such slice.
+ */
+int
+dimension_vec_find_slice_index_by_coordinate(DimensionVec *vec, int64 coordinate)
+{
+	DimensionSlice **res;
+
+	if (vec->num_slices == 0)
+		return -1;
+
+	Assert(dimension_vec_is_sorted(vec));
+
+	res = bsearch(&coordinate, vec->slices, vec->num_slices,
+				  sizeof(DimensionSlice *), cmp_coordinate_and_slice);
+
+	if (res == NULL)
+		return -1;
+
+	return res - vec->slices;
+}
+
 DimensionSlice *
 dimension_vec_get(DimensionVec *vec, int32 index)
 {
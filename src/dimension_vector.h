@@ -29,6 +29,7 @@ extern DimensionVec *dimension_vec_add_slice(DimensionVec **vecptr, DimensionSli
 extern void dimension_vec_remove_slice(DimensionVec **vecptr, int32 index);
 extern DimensionSlice *dimension_vec_find_slice(DimensionVec *vec, int64 coordinate);
 extern int	dimension_vec_find_slice_index(DimensionVec *vec, int32 dimension_slice_id);
+extern int	dimension_vec_find_slice_index_by_coordinate(DimensionVec *vec, int64 coordinate);
 extern DimensionSlice *dimension_vec_get(DimensionVec *vec, int32 index);
 extern void dimension_vec_free(DimensionVec *vec);
 
@@ -30,6 +30,8 @@
 #define ERRCODE_IO_TABLESPACE_ALREADY_ATTACHED MAKE_SQLSTATE('I','O','1','4','0')
 #define ERRCODE_IO_TABLESPACE_NOT_ATTACHED MAKE_SQLSTATE('I','O','1','5','0')
 #define ERRCODE_IO_DUPLICATE_DIMENSION MAKE_SQLSTATE('I','O','1','6','0')
+#define ERRCODE_IO_DATA_NODE_ALREADY_ATTACHED MAKE_SQLSTATE('I','O','1','7','0')
+#define ERRCODE_IO_DATA_NODE_NOT_ATTACHED MAKE_SQLSTATE('I','O','1','8','0')
 
 /*
 --IO500 - GROUP: internal error
@@ -245,8 +245,10 @@ event_trigger_dropped_objects(void)
 									  make_event_trigger_drop_index(lsecond(addrnames),
 																	linitial(addrnames)));
 				}
-				else if (strcmp(objtype, "table") == 0)
+				else if (strcmp(objtype, "table") == 0 ||
+						 strcmp(objtype, "foreign table") == 0)
 				{
+					/* Chunks on data nodes are foreign tables */
 					List	   *addrnames = extract_addrnames(DatumGetArrayTypeP(values[10]));
 
 					objects = lappend(objects,
@@ -0,0 +1,817 @@
+#include <postgres.h>
+#include <math.h>
+#include <catalog/pg_type.h>
+#include <executor/executor.h>
+#include <nodes/extensible.h>
+#include <nodes/nodeFuncs.h>
+#include <nodes/plannodes.h>
+#include <optimizer/pathnode.h>
+#include <optimizer/paths.h>
+#include <optimizer/tlist.h>
+#include <optimizer/var.h>
+#include <utils/datum.h>
+#include <utils/date.h>
+#include <utils/lsyscache.h>
+#include <utils/timestamp.h>
+
+#include "compat-msvc-enter.h"
+#include <optimizer/cost.h>
+#include "compat-msvc-exit.h"
+
+#include "gapfill.h"
+#include "utils.h"
+#include "compat.h"
+
+/*
+ * Gap filling.
+ *
+ * For a query like
+ *
+ *	SELECT time_bucket_gapfill('1 hour', time, start, finish), device,
+ *		   avg(temp), locf(last(temp, time))
+ *	FROM metrics GROUP BY 1, 2;
+ *
+ * a GapFill node is added above the aggregation. It reads the aggregated
+ * groups ordered by the other grouping columns and then the bucket, and adds
+ * a tuple for every bucket between start and finish that a group is missing.
+ * The added tuples have the bucket and the values of the group's grouping
+ * columns. A column that is wrapped in locf() gets the value of the previous
+ * tuple of the group, and one that is wrapped in interpolate() gets the
+ * linear interpolation between the previous and the next tuple of the group.
+ * All other columns are NULL.
+ *
+ * Since the input is ordered, the node only needs the values of the previous
+ * tuple of the group and the next tuple of the input, so gap filling takes a
+ * single pass in constant memory.
+ */
+
+static Datum
+gapfill_bucket(PGFunction bucket_func, FunctionCallInfo fcinfo)
+{
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(1))
+		PG_RETURN_NULL();
+
+	/* The width and the time are also the first arguments of time_bucket() */
+	return bucket_func(fcinfo);
+}
+
+TS_FUNCTION_INFO_V1(gapfill_timestamp_bucket);
+
+Datum
+gapfill_timestamp_bucket(PG_FUNCTION_ARGS)
+{
+	return gapfill_bucket(timestamp_bucket, fcinfo);
+}
+
+TS_FUNCTION_INFO_V1(gapfill_timestamptz_bucket);
+
+Datum
+gapfill_timestamptz_bucket(PG_FUNCTION_ARGS)
+{
+	return gapfill_bucket(timestamptz_bucket, fcinfo);
+}
+
+TS_FUNCTION_INFO_V1(gapfill_date_bucket);
+
+Datum
+gapfill_date_bucket(PG_FUNCTION_ARGS)
+{
+	return gapfill_bucket(date_bucket, fcinfo);
+}
+
+TS_FUNCTION_INFO_V1(gapfill_int16_bucket);
+
+Datum
+gapfill_int16_bucket(PG_FUNCTION_ARGS)
+{
+	return gapfill_bucket(int16_bucket, fcinfo);
+}
+
+TS_FUNCTION_INFO_V1(gapfill_int32_bucket);
+
+Datum
+gapfill_int32_bucket(PG_FUNCTION_ARGS)
+{
+	return gapfill_bucket(int32_bucket, fcinfo);
+}
+
+TS_FUNCTION_INFO_V1(gapfill_int64_bucket);
+
+Datum
+gapfill_int64_bucket(PG_FUNCTION_ARGS)
+{
+	return gapfill_bucket(int64_bucket, fcinfo);
+}
+
+/*
+ * locf() and interpolate() only mark columns for the GapFill node, and return
+ * their argument.
+ */
+TS_FUNCTION_INFO_V1(gapfill_marker);
+
+Datum
+gapfill_marker(PG_FUNCTION_ARGS)
+{
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+}
+
+static bool
+is_func_named(Node *node, const char *name)
+{
+	char	   *func_name;
+
+	if (NULL == node || !IsA(node, FuncExpr))
+		return false;
+
+	func_name = get_func_name(((FuncExpr *) node)->funcid);
+
+	return NULL != func_name && strncmp(func_name, name, NAMEDATALEN) == 0;
+}
+
+/*
+ * Times are bucketed in their own units: microseconds for timestamps, days
+ * for dates, and the integer value for integer time.
+ */
+static int64
+gapfill_time_to_internal(Datum value, Oid type)
+{
+	switch (type)
+	{
+		case INT2OID:
+			return DatumGetInt16(value);
+		case INT4OID:
+			return DatumGetInt32(value);
+		case INT8OID:
+			return DatumGetInt64(value);
+		case DATEOID:
+			return DatumGetDateADT(value);
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return DatumGetTimestamp(value);
+		default:
+			elog(ERROR, "unsupported time type %u for gap filling", type);
+			pg_unreachable();
+	}
+}
+
+static Datum
+gapfill_internal_to_time(int64 value, Oid type)
+{
+	switch (type)
+	{
+		case INT2OID:
+			return Int16GetDatum((int16) value);
+		case INT4OID:
+			return Int32GetDatum((int32) value);
+		case INT8OID:
+			return Int64GetDatum(value);
+		case DATEOID:
+			return DateADTGetDatum((DateADT) value);
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return TimestampGetDatum(value);
+		default:
+			elog(ERROR, "unsupported time type %u for gap filling", type);
+			pg_unreachable();
+	}
+}
+
+static bool
+gapfill_time_is_finite(Datum value, Oid type)
+{
+	switch (type)
+	{
+		case DATEOID:
+			return !DATE_NOT_FINITE(DatumGetDateADT(value));
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return !TIMESTAMP_NOT_FINITE(DatumGetTimestamp(value));
+		default:
+			return true;
+	}
+}
+
+/* The bucket after a time, which saturates instead of overflowing */
+static inline int64
+gapfill_bucket_after(int64 time, int64 width)
+{
+	if (time > PG_INT64_MAX - width)
+		return PG_INT64_MAX;
+
+	return time + width;
+}
+
+static Datum
+gapfill_interpolate(Oid type, int64 x0, Datum y0, int64 x1, Datum y1, int64 x)
+{
+	double		fraction = (double) (x - x0) / (double) (x1 - x0);
+
+#define INTERPOLATE(y0, y1) ((y0) + fraction * ((y1) - (y0)))
+
+	switch (type)
+	{
+		case INT2OID:
+			return Int16GetDatum((int16) rint(INTERPOLATE(DatumGetInt16(y0), DatumGetInt16(y1))));
+		case INT4OID:
+			return Int32GetDatum((int32) rint(INTERPOLATE(DatumGetInt32(y0), DatumGetInt32(y1))));
+		case INT8OID:
+			return Int64GetDatum((int64) rint(INTERPOLATE((double) DatumGetInt64(y0),
+														  (double) DatumGetInt64(y1))));
+		case FLOAT4OID:
+			return Float4GetDatum((float4) INTERPOLATE(DatumGetFloat4(y0), DatumGetFloat4(y1)));
+		case FLOAT8OID:
+			return Float8GetDatum(INTERPOLATE(DatumGetFloat8(y0), DatumGetFloat8(y1)));
+		default:
+			elog(ERROR, "unsupported type %u for interpolation", type);
+			pg_unreachable();
+	}
+
+#undef INTERPOLATE
+}
+
+static void
+gapfill_clear_value(GapFillState *state, int i)
+{
+	if (!state->typbyvals[i] && !state->prev_isnull[i])
+		pfree(DatumGetPointer(state->prev_values[i]));
+
+	state->prev_values[i] = (Datum) 0;
+	state->prev_isnull[i] = true;
+}
+
+/* Copy a value of a tuple of the child, which is gone after the next tuple */
+static void
+gapfill_save_value(GapFillState *state, TupleTableSlot *slot, int i)
+{
+	MemoryContext oldcontext;
+	Datum		value;
+	bool		isnull;
+
+	gapfill_clear_value(state, i);
+	value = slot_getattr(slot, i + 1, &isnull);
+
+	if (isnull)
+		return;
+
+	oldcontext = MemoryContextSwitchTo(state->csstate.ss.ps.state->es_query_cxt);
+	state->prev_values[i] = datumCopy(value, state->typbyvals[i], state->typlens[i]);
+	state->prev_isnull[i] = false;
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * Start filling the gaps of a new group. The slot is NULL for the single
+ * group of a query without grouping columns that has no input at all.
+ */
+static void
+gapfill_start_group(GapFillState *state, TupleTableSlot *slot)
+{
+	int			i;
+
+	for (i = 0; i < state->ncolumns; i++)
+	{
+		if (state->column_types[i] == GAPFILL_COLUMN_GROUP && NULL != slot)
+			gapfill_save_value(state, slot, i);
+		else
+			gapfill_clear_value(state, i);
+	}
+
+	state->next_bucket = state->start;
+	state->have_prev = false;
+	state->group_open = true;
+}
+
+static bool
+gapfill_same_group(GapFillState *state, TupleTableSlot *slot)
+{
+	int			i;
+
+	for (i = 0; i < state->ncolumns; i++)
+	{
+		Datum		value;
+		bool		isnull;
+
+		if (state->column_types[i] != GAPFILL_COLUMN_GROUP)
+			continue;
+
+		value = slot_getattr(slot, i + 1, &isnull);
+
+		if (isnull != state->prev_isnull[i])
+			return false;
+
+		if (!isnull &&
+			!DatumGetBool(FunctionCall2Coll(&state->eq_funcs[i], state->collations[i],
+											state->prev_values[i], value)))
+			return false;
+	}
+
+	return true;
+}
+
+static TupleTableSlot *
+gapfill_project(GapFillState *state, TupleTableSlot *slot)
+{
+	ProjectionInfo *projinfo = state->csstate.ss.ps.ps_ProjInfo;
+
+	if (NULL == projinfo)
+		return slot;
+
+	state->csstate.ss.ps.ps_ExprContext->ecxt_scantuple = slot;
+
+#if PG10
+	return ExecProject(projinfo);
+#elif PG96
+	return ExecProject(projinfo, NULL);
+#endif
+}
+
+/*
+ * Make the tuple of the next missing bucket of the group. The pending tuple
+ * of the child is the next tuple of the group if has_next is set.
+ */
+static TupleTableSlot *
+gapfill_gap_tuple(GapFillState *state, bool has_next, int64 next_time)
+{
+	TupleTableSlot *slot = state->csstate.ss.ss_ScanTupleSlot;
+	ExprContext *econtext = state->csstate.ss.ps.ps_ExprContext;
+	TupleDesc	tupdesc = slot->tts_tupleDescriptor;
+	MemoryContext oldcontext;
+	int64		time = state->next_bucket;
+	int			i;
+
+	ExecClearTuple(slot);
+	oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	for (i = 0; i < state->ncolumns; i++)
+	{
+		slot->tts_values[i] = (Datum) 0;
+		slot->tts_isnull[i] = true;
+
+		switch (state->column_types[i])
+		{
+			case GAPFILL_COLUMN_TIME:
+				slot->tts_values[i] = gapfill_internal_to_time(time, state->time_type);
+				slot->tts_isnull[i] = false;
+				break;
+			case GAPFILL_COLUMN_GROUP:
+			case GAPFILL_COLUMN_LOCF:
+				slot->tts_values[i] = state->prev_values[i];
+				slot->tts_isnull[i] = state->prev_isnull[i];
+				break;
+			case GAPFILL_COLUMN_INTERPOLATE:
+				if (state->have_prev && has_next && !state->prev_isnull[i])
+				{
+					Datum		next_value;
+					bool		next_isnull;
+
+					next_value = slot_getattr(state->pending, i + 1, &next_isnull);
+
+					if (!next_isnull)
+					{
+						slot->tts_values[i] = gapfill_interpolate(tupdesc->attrs[i]->atttypid,
+																  state->prev_time,
+																  state->prev_values[i],
+																  next_time, next_value,
+																  time);
+						slot->tts_isnull[i] = false;
+					}
+				}
+				break;
+			case GAPFILL_COLUMN_NULL:
+				break;
+		}
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+	ExecStoreVirtualTuple(slot);
+
+	state->next_bucket = gapfill_bucket_after(time, state->width);
+
+	return gapfill_project(state, slot);
+}
+
+/*
+ * Evaluate the width, start and finish of the buckets. They may depend on
+ * parameters, so this is done again on a rescan.
+ */
+static void
+gapfill_init_range(GapFillState *state)
+{
+	static const char *const arg_names[] = {"bucket_width", "start", "finish"};
+	ExprContext *econtext = state->csstate.ss.ps.ps_ExprContext;
+	Datum		args[3];
+	Datum		first;
+	bool		isnull;
+	ListCell   *lc;
+	int			i = 0;
+
+	foreach(lc, state->range_exprs)
+	{
+		args[i] = ExecEvalExprCompat(lfirst(lc), econtext, &isnull);
+
+		if (isnull)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("invalid time_bucket_gapfill argument: %s cannot be NULL",
+							arg_names[i])));
+		i++;
+	}
+
+	if (!gapfill_time_is_finite(args[1], state->time_type) ||
+		!gapfill_time_is_finite(args[2], state->time_type))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid time_bucket_gapfill argument: start and finish must be finite")));
+
+	/* The first bucket is the one that start is in */
+	first = OidFunctionCall4(state->funcid, args[0], args[1], args[1], args[2]);
+
+	switch (state->time_type)
+	{
+		case DATEOID:
+			state->width = interval_to_usec(DatumGetIntervalP(args[0])) / USECS_PER_DAY;
+			break;
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			state->width = interval_to_usec(DatumGetIntervalP(args[0]));
+			break;
+		default:
+			state->width = gapfill_time_to_internal(args[0], state->time_type);
+			break;
+	}
+
+	if (state->width <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid time_bucket_gapfill argument: bucket_width must be greater than 0")));
+
+	state->start = gapfill_time_to_internal(first, state->time_type);
+	state->finish = gapfill_time_to_internal(args[2], state->time_type);
+}
+
+static void
+gapfill_reset(GapFillState *state)
+{
+	int			i;
+
+	for (i = 0; i < state->ncolumns; i++)
+		gapfill_clear_value(state, i);
+
+	state->pending = NULL;
+	state->group_open = false;
+	state->had_input = false;
+	state->input_done = false;
+	state->have_prev = false;
+}
+
+static void
+gapfill_begin(CustomScanState *node, EState *estate, int eflags)
+{
+	GapFillState *state = (GapFillState *) node;
+	CustomScan *cscan = (CustomScan *) node->ss.ps.plan;
+	List	   *column_types = lsecond(cscan->custom_private);
+	List	   *eq_ops = lthird(cscan->custom_private);
+	ListCell   *lc;
+	int			i = 0;
+
+	state->child = ExecInitNode(linitial(cscan->custom_plans), estate, eflags);
+	node->custom_ps = list_make1(state->child);
+
+	state->funcid = linitial_oid(linitial(cscan->custom_private));
+	state->ncolumns = list_length(cscan->custom_scan_tlist);
+	state->column_types = palloc(sizeof(GapFillColumnType) * state->ncolumns);
+	state->eq_funcs = palloc0(sizeof(FmgrInfo) * state->ncolumns);
+	state->collations = palloc(sizeof(Oid) * state->ncolumns);
+	state->typlens = palloc(sizeof(int16) * state->ncolumns);
+	state->typbyvals = palloc(sizeof(bool) * state->ncolumns);
+	state->prev_values = palloc0(sizeof(Datum) * state->ncolumns);
+	state->prev_isnull = palloc(sizeof(bool) * state->ncolumns);
+
+	foreach(lc, cscan->custom_scan_tlist)
+	{
+		TargetEntry *tle = lfirst(lc);
+		Oid			type = exprType((Node *) tle->expr);
+
+		state->column_types[i] = list_nth_int(column_types, i);
+		state->collations[i] = exprCollation((Node *) tle->expr);
+		state->prev_isnull[i] = true;
+		get_typlenbyval(type, &state->typlens[i], &state->typbyvals[i]);
+
+		switch (state->column_types[i])
+		{
+			case GAPFILL_COLUMN_TIME:
+				state->time_col = tle->resno;
+				state->time_type = type;
+				break;
+			case GAPFILL_COLUMN_GROUP:
+				fmgr_info(get_opcode(list_nth_oid(eq_ops, i)), &state->eq_funcs[i]);
+				state->has_group_columns = true;
+				break;
+			default:
+				break;
+		}
+		i++;
+	}
+
+	if (state->time_col == InvalidAttrNumber)
+		elog(ERROR, "time column not found in the target list of GapFill");
+
+	foreach(lc, cscan->custom_exprs)
+		state->range_exprs = lappend(state->range_exprs,
+									 ExecInitExpr(lfirst(lc), &node->ss.ps));
+
+	if (eflags & EXEC_FLAG_EXPLAIN_ONLY)
+		return;
+
+	gapfill_init_range(state);
+	gapfill_reset(state);
+}
+
+static TupleTableSlot *
+gapfill_exec(CustomScanState *node)
+{
+	GapFillState *state = (GapFillState *) node;
+	TupleTableSlot *slot;
+	Datum		value;
+	bool		isnull;
+	int64		time = 0;
+	int			i;
+
+	ResetExprContext(node->ss.ps.ps_ExprContext);
+
+	if (NULL == state->pending && !state->input_done)
+	{
+		slot = ExecProcNode(state->child);
+
+		if (TupIsNull(slot))
+			state->input_done = true;
+		else
+			state->pending = slot;
+	}
+
+	if (state->input_done)
+	{
+		/* Without grouping columns, the buckets are filled even without input */
+		if (!state->group_open && !state->had_input && !state->has_group_columns)
+			gapfill_start_group(state, NULL);
+
+		if (state->group_open && state->next_bucket < state->finish)
+			return gapfill_gap_tuple(state, false, 0);
+
+		return NULL;
+	}
+
+	if (!state->group_open)
+		gapfill_start_group(state, state->pending);
+	else if (!gapfill_same_group(state, state->pending))
+	{
+		/* Fill the end of the previous group first */
+		if (state->next_bucket < state->finish)
+			return gapfill_gap_tuple(state, false, 0);
+
+		gapfill_start_group(state, state->pending);
+	}
+
+	value = slot_getattr(state->pending, state->time_col, &isnull);
+
+	if (!isnull)
+		time = gapfill_time_to_internal(value, state->time_type);
+
+	/* A NULL bucket sorts last, so it ends the buckets of the group */
+	if (state->next_bucket < state->finish && (isnull || state->next_bucket < time))
+		return gapfill_gap_tuple(state, !isnull, time);
+
+	if (!isnull)
+	{
+		if (time >= state->next_bucket)
+			state->next_bucket = gapfill_bucket_after(time, state->width);
+
+		state->prev_time = time;
+		state->have_prev = true;
+	}
+
+	slot = state->pending;
+	state->pending = NULL;
+	state->had_input = true;
+
+	for (i = 0; i < state->ncolumns; i++)
+		if (state->column_types[i] == GAPFILL_COLUMN_LOCF ||
+			state->column_types[i] == GAPFILL_COLUMN_INTERPOLATE)
+			gapfill_save_value(state, slot, i);
+
+	return gapfill_project(state, slot);
+}
+
+static void
+gapfill_end(CustomScanState *node)
+{
+	ExecEndNode(linitial(node->custom_ps));
+}
+
+static void
+gapfill_rescan(CustomScanState *node)
+{
+	GapFillState *state = (GapFillState *) node;
+
+	if (NULL != node->ss.ps.chgParam)
+		UpdateChangedParamSet(state->child, node->ss.ps.chgParam);
+
+	ExecReScan(state->child);
+	gapfill_reset(state);
+	gapfill_init_range(state);
+}
+
+static CustomExecMethods gapfill_state_methods = {
+	.CustomName = "GapFillState",
+	.BeginCustomScan = gapfill_begin,
+	.ExecCustomScan = gapfill_exec,
+	.EndCustomScan = gapfill_end,
+	.ReScanCustomScan = gapfill_rescan,
+};
+
+static Node *
+gapfill_state_create(CustomScan *cscan)
+{
+	GapFillState *state;
+
+	state = (GapFillState *) newNode(sizeof(GapFillState), T_CustomScanState);
+	state->csstate.methods = &gapfill_state_methods;
+
+	return (Node *) state;
+}
+
+static CustomScanMethods gapfill_plan_methods = {
+	.CustomName = "GapFill",
+	.CreateCustomScanState = gapfill_state_create,
+};
+
+/*
+ * Find out how the GapFill node sets each column of the tuples it adds: the
+ * bucket, the grouping columns, the columns wrapped in locf() or
+ * interpolate(), and NULL for the rest.
+ */
+static Plan *
+gapfill_plan_create(PlannerInfo *root,
+					RelOptInfo *rel,
+					CustomPath *path,
+					List *tlist,
+					List *clauses,
+					List *custom_plans)
+{
+	CustomScan *cscan = makeNode(CustomScan);
+	Plan	   *subplan = linitial(custom_plans);
+	FuncExpr   *func = linitial(path->custom_private);
+	List	   *column_types = NIL;
+	List	   *eq_ops = NIL;
+	ListCell   *lc;
+
+	foreach(lc, subplan->targetlist)
+	{
+		TargetEntry *tle = lfirst(lc);
+		GapFillColumnType type = GAPFILL_COLUMN_NULL;
+		Oid			eq_op = InvalidOid;
+		SortGroupClause *sgc = NULL;
+
+		if (tle->ressortgroupref != 0)
+			sgc = get_sortgroupref_clause_noerr(tle->ressortgroupref, root->parse->groupClause);
+
+		if (equal(tle->expr, func))
+			type = GAPFILL_COLUMN_TIME;
+		else if (NULL != sgc)
+		{
+			type = GAPFILL_COLUMN_GROUP;
+			eq_op = sgc->eqop;
+		}
+		else if (is_func_named((Node *) tle->expr, "locf"))
+			type = GAPFILL_COLUMN_LOCF;
+		else if (is_func_named((Node *) tle->expr, "interpolate"))
+			type = GAPFILL_COLUMN_INTERPOLATE;
+
+		column_types = lappend_int(column_types, type);
+		eq_ops = lappend_oid(eq_ops, eq_op);
+	}
+
+	cscan->scan.scanrelid = 0;
+	cscan->scan.plan.targetlist = tlist;
+	cscan->custom_plans = custom_plans;
+	cscan->custom_scan_tlist = subplan->targetlist;
+	cscan->custom_exprs = list_make3(linitial(func->args), lthird(func->args),
+									 lfourth(func->args));
+	cscan->custom_private = list_make3(list_make1_oid(func->funcid), column_types, eq_ops);
+	cscan->flags = path->flags;
+	cscan->methods = &gapfill_plan_methods;
+
+	return &cscan->scan.plan;
+}
+
+static CustomPathMethods gapfill_path_methods = {
+	.CustomName = "GapFill",
+	.PlanCustomPath = gapfill_plan_create,
+};
+
+/*
+ * The number of buckets is not known until the start and finish are
+ * evaluated, so the path is only costed for the tuples of the input.
+ */
+static Path *
+gapfill_path_create(PlannerInfo *root, RelOptInfo *rel, Path *subpath, List *pathkeys,
+					FuncExpr *func)
+{
+	CustomPath *path = (CustomPath *) newNode(sizeof(CustomPath), T_CustomPath);
+
+	path->path.pathtype = T_CustomScan;
+	path->path.parent = rel;
+	path->path.pathtarget = subpath->pathtarget;
+	path->path.param_info = NULL;
+	path->path.parallel_aware = false;
+	path->path.parallel_safe = subpath->parallel_safe;
+	path->path.pathkeys = pathkeys;
+	path->path.rows = subpath->rows;
+	path->path.startup_cost = subpath->startup_cost;
+	path->path.total_cost = subpath->total_cost + subpath->rows * cpu_tuple_cost;
+	path->flags = 0;
+	path->custom_paths = list_make1(subpath);
+	path->custom_private = list_make1(func);
+	path->methods = &gapfill_path_methods;
+
+	return &path->path;
+}
+
+/*
+ * Put a GapFill node on top of the paths of a grouping by
+ * time_bucket_gapfill(). The grouping is sorted by the other grouping
+ * columns, and then by the bucket.
+ *
+ * Must be called from the create_upper_paths hook for the grouping stage,
+ * after all other grouping paths are added.
+ */
+void
+gapfill_add_paths(PlannerInfo *root, RelOptInfo *output_rel)
+{
+	Query	   *parse = root->parse;
+	SortGroupClause *gapfill_clause = NULL;
+	FuncExpr   *func = NULL;
+	List	   *sortclauses = NIL;
+	List	   *pathkeys;
+	ListCell   *lc;
+
+	foreach(lc, parse->groupClause)
+	{
+		SortGroupClause *sgc = lfirst(lc);
+		Node	   *expr = get_sortgroupclause_expr(sgc, parse->targetList);
+
+		if (!is_func_named(expr, "time_bucket_gapfill"))
+		{
+			sortclauses = lappend(sortclauses, sgc);
+			continue;
+		}
+
+		if (NULL != gapfill_clause)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("multiple time_bucket_gapfill calls not allowed")));
+
+		gapfill_clause = sgc;
+		func = (FuncExpr *) expr;
+	}
+
+	if (NULL == gapfill_clause)
+		return;
+
+	if (parse->groupingSets != NIL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("time_bucket_gapfill not supported with grouping sets")));
+
+	if (contain_var_clause(linitial(func->args)) ||
+		contain_var_clause(lthird(func->args)) ||
+		contain_var_clause(lfourth(func->args)))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("invalid time_bucket_gapfill argument: bucket_width, start and finish must not reference columns")));
+
+	sortclauses = lappend(sortclauses, gapfill_clause);
+
+	if (!grouping_is_sortable(sortclauses))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("time_bucket_gapfill requires sortable grouping columns")));
+
+	pathkeys = make_pathkeys_for_sortclauses(root, sortclauses, parse->targetList);
+
+	/* Every grouping needs gap filling, so the paths are replaced */
+	foreach(lc, output_rel->pathlist)
+	{
+		Path	   *subpath = lfirst(lc);
+
+		if (!pathkeys_contained_in(pathkeys, subpath->pathkeys))
+			subpath = (Path *) create_sort_path(root, output_rel, subpath, pathkeys, -1.0);
+
+		lfirst(lc) = gapfill_path_create(root, output_rel, subpath, pathkeys, func);
+	}
+
+	output_rel->partial_pathlist = NIL;
+}
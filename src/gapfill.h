@@ -0,0 +1,53 @@
+#ifndef TIMESCALEDB_GAPFILL_H
+#define TIMESCALEDB_GAPFILL_H
+
+#include <postgres.h>
+#include <fmgr.h>
+#include <nodes/execnodes.h>
+#include <nodes/extensible.h>
+#include <nodes/relation.h>
+
+/* How the GapFill node sets a column of the tuples that it adds */
+typedef enum GapFillColumnType
+{
+	GAPFILL_COLUMN_NULL,
+	GAPFILL_COLUMN_TIME,
+	GAPFILL_COLUMN_GROUP,
+	GAPFILL_COLUMN_LOCF,
+	GAPFILL_COLUMN_INTERPOLATE,
+} GapFillColumnType;
+
+typedef struct GapFillState
+{
+	CustomScanState csstate;
+	PlanState  *child;
+	Oid			funcid;			/* the time_bucket_gapfill() function */
+	List	   *range_exprs;	/* width, start and finish */
+	int			ncolumns;
+	GapFillColumnType *column_types;
+	FmgrInfo   *eq_funcs;		/* equality of the group columns */
+	Oid		   *collations;
+	int16	   *typlens;
+	bool	   *typbyvals;
+	bool		has_group_columns;
+	AttrNumber	time_col;
+	Oid			time_type;
+	/* Buckets in the internal units of the time type */
+	int64		width;
+	int64		start;
+	int64		finish;			/* exclusive */
+	int64		next_bucket;
+	bool		group_open;
+	bool		had_input;
+	bool		input_done;
+	TupleTableSlot *pending;	/* tuple of the child that is not returned yet */
+	/* Values of the group, and of the last tuple of the group */
+	Datum	   *prev_values;
+	bool	   *prev_isnull;
+	int64		prev_time;
+	bool		have_prev;
+} GapFillState;
+
+extern void gapfill_add_paths(PlannerInfo *root, RelOptInfo *output_rel);
+
+#endif							/* TIMESCALEDB_GAPFILL_H */
@@ -1,6 +1,7 @@
 #include <postgres.h>
 #include <utils/guc.h>
 #include <miscadmin.h>
+#include <postmaster/postmaster.h>
 
 #include "guc.h"
 #include "hypertable_cache.h"
@@ -9,11 +10,37 @@ bool		guc_disable_optimizations = false;
 bool		guc_optimize_non_hypertables = false;
 bool		guc_restoring = false;
 bool		guc_constraint_aware_append = true;
-int			guc_max_open_chunks_per_insert = 10;
+bool		guc_plan_chunk_exclusion = true;
+bool		guc_ordered_append = true;
+bool		guc_chunk_aggregation = false;
+bool		guc_skip_scan = true;
+bool		guc_bookend_optimization = true;
+bool		guc_chunk_row_estimation = true;
+bool		guc_runtime_join_exclusion = true;
+int			guc_chunk_prefetch_blocks = 32;
+int			guc_max_open_chunks_per_insert = 0;
+int			guc_max_open_chunks_memory = -1;
 int			guc_max_cached_chunks_per_hypertable = 10;
+int			guc_hypertable_cache_memory_limit = 0;
+int			guc_insert_batch_size = 1000;
+bool		guc_defer_chunk_index_build = false;
+int			guc_max_concurrent_jobs = 4;
+bool		guc_vacuum_skip_unchanged_chunks = false;
+bool		guc_incremental_analyze = false;
+bool		guc_reindex_transaction_per_chunk = false;
+int			guc_max_maintenance_workers = 0;
+int			guc_log_min_chunk_create_duration = -1;
+int			guc_tablespace_placement = TABLESPACE_PLACEMENT_STICKY;
+int			guc_async_chunk_create_timeout = 0;
+
+static const struct config_enum_entry tablespace_placement_options[] = {
+	{"sticky", TABLESPACE_PLACEMENT_STICKY, false},
+	{"spread", TABLESPACE_PLACEMENT_SPREAD, false},
+	{NULL, 0, false}
+};
 
 static void
-assign_max_cached_chunks_per_hypertable_hook(int newval, void *extra)
+assign_hypertable_cache_setting_hook(int newval, void *extra)
 {
 	/* invalidate the hypertable cache to reset */
 	hypertable_cache_invalidate_callback();
@@ -63,14 +90,105 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable("timescaledb.plan_chunk_exclusion", "Enable plan-time chunk exclusion",
+							 "Exclude chunks based on their dimension slices before expanding hypertables "
+							 "in a query, instead of expanding all chunks and relying on constraint exclusion",
+							 &guc_plan_chunk_exclusion,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.ordered_append", "Enable ordered append scans",
+							 "Scan chunks in time order with a plain Append, instead of merging all "
+							 "chunks, for queries that order by time and have a LIMIT, or group by time",
+							 &guc_ordered_append,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.chunk_aggregation", "Enable chunk-wise aggregation",
+							 "Consider aggregating each chunk of a hypertable with a partial aggregate "
+							 "and combining the results above the Append of the chunks",
+							 &guc_chunk_aggregation,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.skip_scan", "Enable skip scans for DISTINCT",
+							 "Consider scanning only the first row of each distinct value in "
+							 "the chunks' indexes, for queries with a DISTINCT or DISTINCT ON "
+							 "on a single column",
+							 &guc_skip_scan,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.bookend_optimization", "Enable index-driven first() and last()",
+							 "Compute first() and last() on the time column from the first or last "
+							 "row in an index scan of the chunks, instead of aggregating all rows",
+							 &guc_bookend_optimization,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.chunk_row_estimation", "Enable row estimation from chunk time ranges",
+							 "Estimate the rows of chunks that have no statistics from the fraction "
+							 "of their time range that the query's restrictions cover",
+							 &guc_chunk_row_estimation,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.runtime_join_exclusion", "Enable run-time chunk exclusion on join clauses",
+							 "Exclude chunks at execution time with bounds on the time dimension "
+							 "computed from the relations that a hypertable is joined with",
+							 &guc_runtime_join_exclusion,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("timescaledb.chunk_prefetch_blocks",
+							"Blocks to prefetch of the next chunk in a scan",
+							"While a chunk is scanned, hint the operating system to read this "
+							"many of the first blocks of the next chunk. Only done if "
+							"effective_io_concurrency is non-zero. Zero disables prefetching",
+							&guc_chunk_prefetch_blocks,
+							32,
+							0,
+							INT_MAX / 2,
+							PGC_USERSET,
+							GUC_UNIT_BLOCKS,
+							NULL,
+							NULL,
+							NULL);
+
 	DefineCustomIntVariable("timescaledb.max_open_chunks_per_insert",
 							"Maximum open chunks per insert",
-							"Maximum number of open chunk tables per insert",
+							"Maximum number of open chunk tables per insert, in addition to "
+							"timescaledb.max_open_chunks_memory. Zero means no limit",
 							&guc_max_open_chunks_per_insert,
-							work_mem * 1024L / 512L,	/* Assume each chunk
-														 * takes up 512 bytes
-														 * (work_mem is in
-														 * kbytes) */
+							0,
 							0,
 							65536,
 							PGC_USERSET,
@@ -79,6 +197,21 @@ _guc_init(void)
 							NULL,
 							NULL);
 
+	DefineCustomIntVariable("timescaledb.max_open_chunks_memory",
+							"Maximum memory of open chunks per insert",
+							"Memory that the open chunk tables of an insert, with their indexes, "
+							"constraints and tuple conversion state, may use before the least "
+							"recently used chunks are closed. -1 uses work_mem, zero means no limit",
+							&guc_max_open_chunks_memory,
+							-1,
+							-1,
+							MAX_KILOBYTES,
+							PGC_USERSET,
+							GUC_UNIT_KB,
+							NULL,
+							NULL,
+							NULL);
+
 	DefineCustomIntVariable("timescaledb.max_cached_chunks_per_hypertable",
 							"Maximum cached chunks",
 							"Maximum number of chunks stored in the cache",
@@ -89,7 +222,160 @@ _guc_init(void)
 							PGC_USERSET,
 							0,
 							NULL,
-							assign_max_cached_chunks_per_hypertable_hook,
+							assign_hypertable_cache_setting_hook,
+							NULL);
+
+	DefineCustomIntVariable("timescaledb.hypertable_cache_memory_limit",
+							"Maximum memory of the hypertable cache",
+							"Memory that the cached hypertables of a backend, including their "
+							"chunk caches, may use before the least recently used hypertables "
+							"are evicted. Zero means no limit",
+							&guc_hypertable_cache_memory_limit,
+							0,
+							0,
+							MAX_KILOBYTES,
+							PGC_USERSET,
+							GUC_UNIT_KB,
+							NULL,
+							assign_hypertable_cache_setting_hook,
+							NULL);
+
+	DefineCustomIntVariable("timescaledb.insert_batch_size",
+							"Maximum number of tuples to route per batch on insert",
+							"Number of tuples an INSERT reads ahead and groups by chunk before "
+							"inserting them. Zero disables batching",
+							&guc_insert_batch_size,
+							1000,
+							0,
+							65536,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable("timescaledb.defer_chunk_index_build",
+							 "Build indexes of new chunks after loading them",
+							 "Chunks created by an INSERT or COPY are loaded without indexes, which "
+							 "are instead built in bulk when the chunk is closed at end of statement",
+							 &guc_defer_chunk_index_build,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("timescaledb.max_concurrent_jobs",
+							"Maximum number of concurrently running background jobs",
+							"Maximum number of job workers that the job scheduler of a database "
+							"runs at the same time. Jobs that are due wait for a free slot",
+							&guc_max_concurrent_jobs,
+							4,
+							1,
+							MAX_BACKENDS,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable("timescaledb.vacuum_skip_unchanged_chunks",
+							 "Skip unchanged chunks in VACUUM and ANALYZE",
+							 "VACUUM and ANALYZE of a hypertable skip chunks that have not been "
+							 "modified since they were last vacuumed or analyzed",
+							 &guc_vacuum_skip_unchanged_chunks,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.incremental_analyze",
+							 "Merge chunk statistics into hypertable statistics",
+							 "ANALYZE of a hypertable skips chunks that have not been modified "
+							 "since they were last analyzed and merges the statistics of all "
+							 "chunks into the statistics of the hypertable",
+							 &guc_incremental_analyze,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.reindex_transaction_per_chunk",
+							 "Reindex each chunk in a transaction of its own",
+							 "REINDEX TABLE of a hypertable outside a transaction block rebuilds "
+							 "the indexes of each chunk side by side and commits per chunk",
+							 &guc_reindex_transaction_per_chunk,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("timescaledb.max_maintenance_workers",
+							"Maximum number of background workers for VACUUM, ANALYZE and REINDEX",
+							"Maximum number of background workers that process the chunks of a "
+							"hypertable in parallel with the VACUUM, ANALYZE or per-chunk REINDEX "
+							"of it. Zero disables parallel processing",
+							&guc_max_maintenance_workers,
+							0,
+							0,
+							MAX_BACKENDS,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("timescaledb.log_min_chunk_create_duration",
+							"Log chunk creations that take at least this long",
+							"Chunk creations, including waiting for a concurrent creation, that "
+							"take at least this many milliseconds are logged with a breakdown of "
+							"the time. -1 disables logging",
+							&guc_log_min_chunk_create_duration,
+							-1,
+							-1,
+							INT_MAX,
+							PGC_SUSET,
+							GUC_UNIT_MS,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomEnumVariable("timescaledb.tablespace_placement",
+							 "How new chunks are placed on attached tablespaces",
+							 "With \"sticky\", the chunks of a space partition always go to the "
+							 "same tablespace. With \"spread\", the chunks of a time slice, which "
+							 "are written concurrently, go to the tablespaces with the fewest "
+							 "chunks of the slice relative to their free space",
+							 &guc_tablespace_placement,
+							 TABLESPACE_PLACEMENT_STICKY,
+							 tablespace_placement_options,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("timescaledb.async_chunk_create_timeout",
+							"Create the chunks for batched inserts in background workers",
+							"An INSERT that needs a new chunk has a background worker create it "
+							"and carries on with the tuples of other chunks. The insert waits "
+							"for the worker this many milliseconds at most before creating the "
+							"chunk itself. Zero disables asynchronous chunk creation",
+							&guc_async_chunk_create_timeout,
+							0,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_UNIT_MS,
+							NULL,
+							NULL,
 							NULL);
 }
 
@@ -5,9 +5,37 @@
 extern bool guc_disable_optimizations;
 extern bool guc_optimize_non_hypertables;
 extern bool guc_constraint_aware_append;
+extern bool guc_plan_chunk_exclusion;
+extern bool guc_ordered_append;
+extern bool guc_chunk_aggregation;
+extern bool guc_skip_scan;
+extern bool guc_bookend_optimization;
+extern bool guc_chunk_row_estimation;
+extern bool guc_runtime_join_exclusion;
+extern int	guc_chunk_prefetch_blocks;
 extern bool guc_restoring;
 extern int	guc_max_open_chunks_per_insert;
+extern int	guc_max_open_chunks_memory;
 extern int	guc_max_cached_chunks_per_hypertable;
+extern int	guc_hypertable_cache_memory_limit;
+extern int	guc_insert_batch_size;
+extern bool guc_defer_chunk_index_build;
+extern int	guc_max_concurrent_jobs;
+extern bool guc_vacuum_skip_unchanged_chunks;
+extern bool guc_incremental_analyze;
+extern bool guc_reindex_transaction_per_chunk;
+extern int	guc_max_maintenance_workers;
+extern int	guc_log_min_chunk_create_duration;
+
+/* How new chunks are placed on the tablespaces attached to a hypertable */
+typedef enum TablespacePlacement
+{
+	TABLESPACE_PLACEMENT_STICKY,
+	TABLESPACE_PLACEMENT_SPREAD,
+} TablespacePlacement;
+
+extern int	guc_tablespace_placement;
+extern int	guc_async_chunk_create_timeout;
 
 void		_guc_init(void);
 void		_guc_fini(void);
@@ -1,15 +1,11 @@
 #include <postgres.h>
+#include <math.h>
 #include <catalog/pg_type.h>
 #include <utils/builtins.h>
 #include <utils/array.h>
-#include "nodes/makefuncs.h"
-#include "utils/lsyscache.h"
-#include <netinet/in.h>
 
 #include "compat.h"
 
-#define HIST_LEN(state) ((VARSIZE(state) - VARHDRSZ ) / sizeof(Datum))
-
 /* aggregate histogram:
  *	 histogram(state, val, min, max, nbuckets) returns the histogram array with nbuckets
  *
@@ -29,21 +25,100 @@ TS_FUNCTION_INFO_V1(hist_serializefunc);
 TS_FUNCTION_INFO_V1(hist_deserializefunc);
 TS_FUNCTION_INFO_V1(hist_finalfunc);
 
+/*
+ * The aggregate state: the histogram's range, which is given with every row
+ * but must be the same for all rows of a group, and the counts of its
+ * buckets. The counts are a contiguous array, so the state is serialized by
+ * copying it as a whole.
+ */
+typedef struct Histogram
+{
+	int32		nbuckets;		/* buckets within the range, excluding the two
+								 * buckets outside of it */
+	double		min;
+	double		max;
+	int64		counts[FLEXIBLE_ARRAY_MEMBER];	/* nbuckets + 2 counts */
+} Histogram;
+
+#define HISTOGRAM_SIZE(nbuckets) \
+	(offsetof(Histogram, counts) + sizeof(int64) * ((nbuckets) + 2))
+
+/*
+ * Check the range of a histogram, with the same errors as width_bucket(),
+ * which computed the buckets before.
+ */
+static void
+histogram_check_range(double min, double max, int32 nbuckets)
+{
+	if (nbuckets <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_ARGUMENT_FOR_WIDTH_BUCKET_FUNCTION),
+				 errmsg("count must be greater than zero")));
+
+	if (isnan(min) || isnan(max))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_ARGUMENT_FOR_WIDTH_BUCKET_FUNCTION),
+				 errmsg("operand, lower bound, and upper bound cannot be NaN")));
+
+	if (isinf(min) || isinf(max))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_ARGUMENT_FOR_WIDTH_BUCKET_FUNCTION),
+				 errmsg("lower and upper bounds must be finite")));
+
+	if (min == max)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_ARGUMENT_FOR_WIDTH_BUCKET_FUNCTION),
+				 errmsg("lower bound cannot equal upper bound")));
+
+	if (min > max)
+	{
+		/* cannot generate a histogram with incompatible bounds */
+		elog(ERROR, "lower bound cannot exceed upper bound");
+	}
+}
+
+static Histogram *
+histogram_create(MemoryContext aggcontext, double min, double max, int32 nbuckets)
+{
+	Histogram  *hist;
+
+	histogram_check_range(min, max, nbuckets);
+
+	hist = MemoryContextAllocZero(aggcontext, HISTOGRAM_SIZE(nbuckets));
+	hist->nbuckets = nbuckets;
+	hist->min = min;
+	hist->max = max;
+
+	return hist;
+}
+
+/*
+ * Get the bucket of a value, like width_bucket() does: bucket 0 holds the
+ * values below the range, bucket nbuckets + 1 the values at or above its
+ * upper bound.
+ */
+static inline int32
+histogram_bucket(Histogram *hist, double val)
+{
+	if (val < hist->min)
+		return 0;
+
+	if (val >= hist->max)
+		return hist->nbuckets + 1;
+
+	return (int32) (((double) hist->nbuckets * (val - hist->min) / (hist->max - hist->min)) + 1);
+}
+
 /* histogram(state, val, min, max, nbuckets) */
 Datum
 hist_sfunc(PG_FUNCTION_ARGS)
 {
 	MemoryContext aggcontext;
-	bytea	   *state = (PG_ARGISNULL(0) ? NULL : PG_GETARG_BYTEA_P(0));
-	Datum	   *hist;
-	Datum		val_datum = PG_GETARG_DATUM(1);
-	Datum		min_datum = PG_GETARG_DATUM(2);
-	Datum		max_datum = PG_GETARG_DATUM(3);
-	Datum		nbuckets_datum = PG_GETARG_DATUM(4);
-	double		min = DatumGetFloat8(min_datum);
-	double		max = DatumGetFloat8(max_datum);
-	int			nbuckets = DatumGetInt32(nbuckets_datum);
-	int32		bucket = DatumGetInt32(DirectFunctionCall4(width_bucket_float8, val_datum, min_datum, max_datum, nbuckets_datum));
+	Histogram  *hist = (PG_ARGISNULL(0) ? NULL : (Histogram *) PG_GETARG_POINTER(0));
+	double		val;
+	double		min;
+	double		max;
+	int32		nbuckets;
 
 	if (!AggCheckCallContext(fcinfo, &aggcontext))
 	{
@@ -51,40 +126,37 @@ hist_sfunc(PG_FUNCTION_ARGS)
 		elog(ERROR, "hist_sfunc called in non-aggregate context");
 	}
 
-	if (min > max)
-	{
-		/* cannot generate a histogram with incompatible bounds */
-		elog(ERROR, "lower bound cannot exceed upper bound");
-	}
+	if (PG_ARGISNULL(2) || PG_ARGISNULL(3) || PG_ARGISNULL(4))
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+				 errmsg("histogram bounds and bucket count cannot be NULL")));
 
-	if (state == NULL)
-	{
-		/* Allocate memory to a new histogram state array */
-		Size		arrsize = sizeof(Datum) * (nbuckets + 2);
+	min = PG_GETARG_FLOAT8(2);
+	max = PG_GETARG_FLOAT8(3);
+	nbuckets = PG_GETARG_INT32(4);
 
-		state = MemoryContextAllocZero(aggcontext, VARHDRSZ + arrsize);
-		SET_VARSIZE(state, VARHDRSZ + arrsize);
-	}
+	/* The range is checked once, when the group's state is created */
+	if (hist == NULL)
+		hist = histogram_create(aggcontext, min, max, nbuckets);
+	else if (hist->min != min || hist->max != max || hist->nbuckets != nbuckets)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("histogram bounds and bucket count must be the same for all rows")));
 
-	/* Increment the proper histogram bucket */
-	hist = (Datum *) VARDATA(state);
-	hist[bucket] = Int32GetDatum(DatumGetInt32(hist[bucket]) + 1);
+	/* NULL values are not counted, like in other aggregates */
+	if (PG_ARGISNULL(1))
+		PG_RETURN_POINTER(hist);
 
-	PG_RETURN_BYTEA_P(state);
-}
+	val = PG_GETARG_FLOAT8(1);
 
-/* Make a copy of the bytea state */
-static inline bytea *
-copy_state(MemoryContext aggcontext, bytea *state)
-{
-	bytea	   *copy;
-	Size		arrsize = VARSIZE(state) - VARHDRSZ;
+	if (isnan(val))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_ARGUMENT_FOR_WIDTH_BUCKET_FUNCTION),
+				 errmsg("operand, lower bound, and upper bound cannot be NaN")));
 
-	copy = MemoryContextAllocZero(aggcontext, VARHDRSZ + arrsize);
-	SET_VARSIZE(copy, VARHDRSZ + arrsize);
-	memcpy(copy, state, VARHDRSZ + arrsize);
+	hist->counts[histogram_bucket(hist, val)]++;
 
-	return copy;
+	PG_RETURN_POINTER(hist);
 }
 
 /* hist_combinefunc(internal, internal) => internal */
@@ -92,10 +164,9 @@ Datum
 hist_combinefunc(PG_FUNCTION_ARGS)
 {
 	MemoryContext aggcontext;
-
-	bytea	   *state1 = (PG_ARGISNULL(0) ? NULL : PG_GETARG_BYTEA_P(0));
-	bytea	   *state2 = (PG_ARGISNULL(1) ? NULL : PG_GETARG_BYTEA_P(1));
-	bytea	   *result;
+	Histogram  *state1 = (PG_ARGISNULL(0) ? NULL : (Histogram *) PG_GETARG_POINTER(0));
+	Histogram  *state2 = (PG_ARGISNULL(1) ? NULL : (Histogram *) PG_GETARG_POINTER(1));
+	int32		i;
 
 	if (!AggCheckCallContext(fcinfo, &aggcontext))
 	{
@@ -104,51 +175,52 @@ hist_combinefunc(PG_FUNCTION_ARGS)
 	}
 
 	if (state2 == NULL)
-	{
-		result = copy_state(aggcontext, state1);
-	}
+		PG_RETURN_POINTER(state1);
 
-	else if (state1 == NULL)
+	if (state1 == NULL)
 	{
-		result = copy_state(aggcontext, state2);
-	}
+		/* The second state is not ours to keep, so copy it */
+		Histogram  *copy = MemoryContextAlloc(aggcontext, HISTOGRAM_SIZE(state2->nbuckets));
 
-	else
-	{
-		Size		i;
-		Datum	   *hist,
-				   *hist_other;
+		memcpy(copy, state2, HISTOGRAM_SIZE(state2->nbuckets));
+		PG_RETURN_POINTER(copy);
+	}
 
-		result = copy_state(aggcontext, state1);
-		hist = (Datum *) VARDATA(result);
-		hist_other = (Datum *) VARDATA(state2);
+	if (state1->min != state2->min ||
+		state1->max != state2->max ||
+		state1->nbuckets != state2->nbuckets)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("histogram bounds and bucket count must be the same for all rows")));
 
-		/* Combine values from state1 and state2 when both states are non-null */
-		for (i = 0; i < HIST_LEN(state1); i++)
-			hist[i] = Int32GetDatum(DatumGetInt32(hist[i]) + DatumGetInt32(hist_other[i]));
-	}
+	for (i = 0; i < state1->nbuckets + 2; i++)
+		state1->counts[i] += state2->counts[i];
 
-	PG_RETURN_BYTEA_P(result);
+	PG_RETURN_POINTER(state1);
 }
 
-/* hist_serializefunc(internal) => bytea */
+/*
+ * hist_serializefunc(internal) => bytea
+ *
+ * Serialized states are only exchanged between the processes of a parallel
+ * query, so the state is copied as is, in the server's byte order.
+ */
 Datum
 hist_serializefunc(PG_FUNCTION_ARGS)
 {
-	bytea	   *state;
-	Datum	   *hist;
-	Size		i;
+	Histogram  *hist;
+	Size		size;
+	bytea	   *result;
 
 	Assert(!PG_ARGISNULL(0));
-	state = PG_GETARG_BYTEA_P(0);
-	hist = (Datum *) VARDATA(state);
+	hist = (Histogram *) PG_GETARG_POINTER(0);
+	size = HISTOGRAM_SIZE(hist->nbuckets);
 
-	for (i = 0; i < HIST_LEN(state); i++)
-	{
-		hist[i] = Int32GetDatum(htonl(DatumGetInt32(hist[i])));
-	}
+	result = palloc(VARHDRSZ + size);
+	SET_VARSIZE(result, VARHDRSZ + size);
+	memcpy(VARDATA(result), hist, size);
 
-	PG_RETURN_BYTEA_P(state);
+	PG_RETURN_BYTEA_P(result);
 }
 
 /* hist_deserializefunc(bytea, internal) => internal */
@@ -156,29 +228,37 @@ Datum
 hist_deserializefunc(PG_FUNCTION_ARGS)
 {
 	bytea	   *state;
-	Datum	   *hist;
-	Size		i;
+	Histogram  *hist;
+	Size		size;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
 
 	Assert(!PG_ARGISNULL(0));
 	state = PG_GETARG_BYTEA_P(0);
-	hist = (Datum *) VARDATA(state);
+	size = VARSIZE(state) - VARHDRSZ;
 
-	for (i = 0; i < HIST_LEN(state); i++)
-	{
-		hist[i] = Int32GetDatum(ntohl(DatumGetInt32(hist[i])));
-	}
+	if (size < offsetof(Histogram, counts))
+		elog(ERROR, "invalid histogram state");
+
+	hist = palloc(size);
+	memcpy(hist, VARDATA(state), size);
 
-	PG_RETURN_BYTEA_P(state);
+	if (hist->nbuckets <= 0 || size != HISTOGRAM_SIZE(hist->nbuckets))
+		elog(ERROR, "invalid histogram state");
+
+	PG_RETURN_POINTER(hist);
 }
 
 /* hist_funalfunc(internal, val REAL, MIN REAL, MAX REAL, nbuckets INTEGER) => INTEGER[] */
 Datum
 hist_finalfunc(PG_FUNCTION_ARGS)
 {
-	bytea	   *state;
-	Datum	   *hist;
+	Histogram  *hist;
+	Datum	   *counts;
 	int			dims[1];
 	int			lbs[1];
+	int32		i;
 
 	if (!AggCheckCallContext(fcinfo, NULL))
 	{
@@ -189,11 +269,21 @@ hist_finalfunc(PG_FUNCTION_ARGS)
 	if (PG_ARGISNULL(0))
 		PG_RETURN_NULL();
 
-	state = PG_GETARG_BYTEA_P(0);
-	hist = (Datum *) VARDATA(state);
+	hist = (Histogram *) PG_GETARG_POINTER(0);
+	counts = palloc(sizeof(Datum) * (hist->nbuckets + 2));
+
+	for (i = 0; i < hist->nbuckets + 2; i++)
+	{
+		if (hist->counts[i] > PG_INT32_MAX)
+			ereport(ERROR,
+					(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+					 errmsg("histogram bucket count out of range")));
+
+		counts[i] = Int32GetDatum((int32) hist->counts[i]);
+	}
 
-	dims[0] = HIST_LEN(state);
+	dims[0] = hist->nbuckets + 2;
 	lbs[0] = 1;
 
-	PG_RETURN_ARRAYTYPE_P(construct_md_array(hist, NULL, 1, dims, lbs, INT4OID, 4, true, 'i'));
+	PG_RETURN_ARRAYTYPE_P(construct_md_array(counts, NULL, 1, dims, lbs, INT4OID, 4, true, 'i'));
 }
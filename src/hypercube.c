@@ -67,6 +67,26 @@ hypercube_copy(Hypercube *hc)
 	return copy;
 }
 
+/*
+ * Check if the hypercube encloses the given point.
+ *
+ * The hypercube's slices must be in dimension order, i.e., aligned with the
+ * point's coordinates.
+ */
+bool
+hypercube_contains_point(Hypercube *hc, Point *p)
+{
+	int			i;
+
+	Assert(hc->num_slices == p->cardinality);
+
+	for (i = 0; i < hc->num_slices; i++)
+		if (dimension_slice_cmp_coordinate(hc->slices[i], p->coordinates[i]) != 0)
+			return false;
+
+	return true;
+}
+
 static int
 cmp_slices_by_dimension_id(const void *left, const void *right)
 {
@@ -30,6 +30,7 @@ extern Hypercube *hypercube_calculate_from_point(Hyperspace *hs, Point *p);
 extern bool hypercubes_collide(Hypercube *cube1, Hypercube *cube2);
 extern DimensionSlice *hypercube_get_slice_by_dimension_id(Hypercube *hc, int32 dimension_id);
 extern Hypercube *hypercube_copy(Hypercube *hc);
+extern bool hypercube_contains_point(Hypercube *hc, Point *p);
 extern void hypercube_slice_sort(Hypercube *hc);
 
 #endif							/* TIMESCALEDB_HYPERCUBE_H */
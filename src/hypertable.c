@@ -14,12 +14,21 @@
 #include <commands/tablespace.h>
 #include <commands/dbcommands.h>
 #include <commands/schemacmds.h>
+#include <commands/tablecmds.h>
+#include <nodes/makefuncs.h>
+#include <storage/bufmgr.h>
 #include <storage/lmgr.h>
 #include <miscadmin.h>
 
 #include "hypertable.h"
+#include "bgw_job.h"
 #include "dimension.h"
 #include "chunk.h"
+#include "chunk_adaptive.h"
+#include "chunk_bloom_filter.h"
+#include "compress_chunk.h"
+#include "continuous_agg.h"
+#include "data_node.h"
 #include "compat.h"
 #include "subspace_store.h"
 #include "hypertable_cache.h"
@@ -29,6 +38,7 @@
 #include "dimension_slice.h"
 #include "dimension_vector.h"
 #include "hypercube.h"
+#include "slice_index.h"
 #include "indexing.h"
 #include "guc.h"
 #include "errors.h"
@@ -87,6 +97,11 @@ hypertable_from_tuple(HeapTuple tuple)
 	h->main_table_relid = get_relname_relid(NameStr(h->fd.table_name), namespace_oid);
 	h->space = dimension_scan(h->fd.id, h->main_table_relid, h->fd.num_dimensions);
 	h->chunk_cache = subspace_store_init(h->space, CurrentMemoryContext, guc_max_cached_chunks_per_hypertable);
+	h->has_compressed_chunks = compressed_chunk_exists_for_hypertable(h->fd.id);
+	h->chunk_target_size = chunk_sizing_get_target_size(h->fd.id);
+	h->has_continuous_aggs = continuous_agg_exists_for_raw_hypertable(h->fd.id);
+	h->has_bloom_filters = hypertable_bloom_column_exists_for_hypertable(h->fd.id);
+	h->tablespaces = tablespace_scan(h->fd.id);
 
 	return h;
 }
@@ -111,8 +126,8 @@ hypertable_id_to_relid(int32 hypertable_id)
 	Oid			relid = InvalidOid;
 	ScanKeyData scankey[1];
 	ScannerCtx	scanctx = {
-		.table = catalog->tables[HYPERTABLE].id,
-		.index = catalog->tables[HYPERTABLE].index_ids[HYPERTABLE_ID_INDEX],
+		.table = catalog_table_get_id(catalog, HYPERTABLE),
+		.index = CATALOG_INDEX(catalog, HYPERTABLE, HYPERTABLE_ID_INDEX),
 		.nkeys = 1,
 		.scankey = scankey,
 		.tuple_found = hypertable_tuple_get_relid,
@@ -131,16 +146,15 @@ hypertable_id_to_relid(int32 hypertable_id)
 	return relid;
 }
 
-typedef struct ChunkCacheEntry
-{
-	MemoryContext mcxt;
-	Chunk	   *chunk;
-} ChunkCacheEntry;
-
+/*
+ * Chunks in the chunk cache are compact copies that are freed with a single
+ * pfree(). They all live in the chunk cache's memory context, which is deleted
+ * with the hypertable's cache entry on invalidation.
+ */
 static void
-chunk_cache_entry_free(void *cce)
+chunk_cache_entry_free(void *chunk)
 {
-	MemoryContextDelete(((ChunkCacheEntry *) cce)->mcxt);
+	pfree(chunk);
 }
 
 static int
@@ -155,7 +169,7 @@ hypertable_scan_limit_internal(ScanKeyData *scankey,
 {
 	Catalog    *catalog = catalog_get();
 	ScannerCtx	scanctx = {
-		.table = catalog->tables[HYPERTABLE].id,
+		.table = catalog_table_get_id(catalog, HYPERTABLE),
 		.index = CATALOG_INDEX(catalog, HYPERTABLE, indexid),
 		.nkeys = num_scankeys,
 		.scankey = scankey,
@@ -270,8 +284,12 @@ hypertable_tuple_delete(TupleInfo *ti, void *data)
 	int			hypertable_id = heap_getattr(ti->tuple, Anum_hypertable_id, ti->desc, &isnull);
 
 	tablespace_delete(hypertable_id, NULL);
+	data_node_delete_by_hypertable_id(hypertable_id);
 	chunk_delete_by_hypertable_id(hypertable_id);
 	dimension_delete_by_hypertable_id(hypertable_id, true);
+	bgw_job_delete_by_hypertable_id(hypertable_id);
+	chunk_sizing_delete_by_hypertable_id(hypertable_id);
+	continuous_agg_delete_by_hypertable_id(hypertable_id);
 
 	catalog_become_owner(catalog_get(), &sec_ctx);
 	catalog_delete(ti->scanrel, ti->tuple);
@@ -510,7 +528,7 @@ hypertable_insert(Name schema_name,
 	Catalog    *catalog = catalog_get();
 	Relation	rel;
 
-	rel = heap_open(catalog->tables[HYPERTABLE].id, RowExclusiveLock);
+	rel = heap_open(catalog_table_get_id(catalog, HYPERTABLE), RowExclusiveLock);
 	hypertable_insert_relation(rel,
 							   schema_name,
 							   table_name,
@@ -544,6 +562,62 @@ hypertable_get_by_name(char *schema, char *name)
 	return ht;
 }
 
+static bool
+hypertable_tuple_append(TupleInfo *ti, void *data)
+{
+	List	  **hypertables = data;
+
+	*hypertables = lappend(*hypertables, hypertable_from_tuple(ti->tuple));
+	return true;
+}
+
+/*
+ * Get all hypertables with the given schema and table name, where a NULL name
+ * matches any name.
+ */
+List *
+hypertable_get_all_by_name(const char *schema, const char *table)
+{
+	ScanKeyData scankey[2];
+	NameData	schema_name,
+				table_name;
+	List	   *hypertables = NIL;
+	int			nkeys = 0;
+
+	if (NULL != schema && NULL != table)
+	{
+		hypertable_scan(schema, table, hypertable_tuple_append, &hypertables,
+						AccessShareLock, false);
+		return hypertables;
+	}
+
+	/* Without both names, the name index cannot be used */
+	if (NULL != schema)
+	{
+		namestrcpy(&schema_name, schema);
+		ScanKeyInit(&scankey[nkeys++], Anum_hypertable_schema_name,
+					BTEqualStrategyNumber, F_NAMEEQ, NameGetDatum(&schema_name));
+	}
+
+	if (NULL != table)
+	{
+		namestrcpy(&table_name, table);
+		ScanKeyInit(&scankey[nkeys++], Anum_hypertable_table_name,
+					BTEqualStrategyNumber, F_NAMEEQ, NameGetDatum(&table_name));
+	}
+
+	hypertable_scan_limit_internal(scankey,
+								   nkeys,
+								   INVALID_INDEXID,
+								   hypertable_tuple_append,
+								   &hypertables,
+								   0,
+								   AccessShareLock,
+								   false);
+
+	return hypertables;
+}
+
 Hypertable *
 hypertable_get_by_id(int32 hypertable_id)
 {
@@ -565,15 +639,51 @@ hypertable_get_by_id(int32 hypertable_id)
 	return ht;
 }
 
-Chunk *
-hypertable_get_chunk(Hypertable *h, Point *point)
+/*
+ * Find the chunk that encloses a point.
+ *
+ * The hypertable's slice index is tried first, which avoids scanning the
+ * catalog for the slices and constraints of chunks. The index does not know
+ * about chunks created by other backends after it was built, so the catalog is
+ * scanned when the index has no matching chunk.
+ */
+static Chunk *
+hypertable_find_chunk(Hypertable *h, Point *point)
 {
-	ChunkCacheEntry *cce = subspace_store_get(h->chunk_cache, point);
+	Hypercube  *cube;
+	Chunk	   *chunk;
+	int32		chunk_id;
+
+	if (NULL == h->slice_index)
+		h->slice_index = slice_index_create(h->space, subspace_store_mcxt(h->chunk_cache));
 
-	if (NULL == cce)
+	chunk_id = slice_index_find_chunk(h->slice_index, point, &cube);
+
+	if (chunk_id > 0)
+		return chunk_get_by_id_with_cube(chunk_id, cube, h->space->num_dimensions);
+
+	chunk = chunk_find(h->space, point);
+
+	if (NULL != chunk)
+		slice_index_add_chunk(h->slice_index, chunk->fd.id, chunk->cube);
+
+	return chunk;
+}
+
+static Chunk *
+hypertable_get_chunk_internal(Hypertable *h, Point *point, bool defer_indexes,
+							  bool *created, bool *created_without_indexes)
+{
+	Chunk	   *cached = subspace_store_get(h->chunk_cache, point);
+
+	if (NULL != created)
+		*created = false;
+
+	if (NULL != created_without_indexes)
+		*created_without_indexes = false;
+
+	if (NULL == cached)
 	{
-		MemoryContext old_mcxt,
-					chunk_mcxt;
 		Chunk	   *chunk;
 
 		/*
@@ -581,45 +691,78 @@ hypertable_get_chunk(Hypertable *h, Point *point)
 		 * allocates a lot of transient data. We don't want this allocated on
 		 * the cache's memory context.
 		 */
-		chunk = chunk_find(h->space, point);
+		chunk = hypertable_find_chunk(h, point);
 
 		if (NULL == chunk)
-			chunk = chunk_create(h, point,
-								 NameStr(h->fd.associated_schema_name),
-								 NameStr(h->fd.associated_table_prefix));
+		{
+			if (defer_indexes)
+				chunk = chunk_create_without_indexes(h, point,
+													 NameStr(h->fd.associated_schema_name),
+													 NameStr(h->fd.associated_table_prefix),
+													 created_without_indexes);
+			else
+				chunk = chunk_create(h, point,
+									 NameStr(h->fd.associated_schema_name),
+									 NameStr(h->fd.associated_table_prefix));
+
+			slice_index_add_chunk(h->slice_index, chunk->fd.id, chunk->cube);
+
+			if (NULL != created)
+				*created = true;
+		}
 
 		Assert(chunk != NULL);
 
-		chunk_mcxt = AllocSetContextCreate(subspace_store_mcxt(h->chunk_cache),
-										   "chunk cache memory context",
-										   ALLOCSET_SMALL_SIZES);
+		/* Make a copy which lives in the chunk cache's memory context */
+		cached = chunk_copy_compact(chunk, subspace_store_mcxt(h->chunk_cache));
+		subspace_store_add(h->chunk_cache, cached->cube, cached, chunk_cache_entry_free);
+		hypertable_cache_update_memory(h);
+	}
 
-		old_mcxt = MemoryContextSwitchTo(chunk_mcxt);
+	Assert(NULL != cached);
 
-		cce = palloc(sizeof(ChunkCacheEntry));
-		cce->mcxt = chunk_mcxt;
+	return cached;
+}
 
-		/* Make a copy which lives in the chunk cache's memory context */
-		chunk = cce->chunk = chunk_copy(chunk);
+Chunk *
+hypertable_get_chunk(Hypertable *h, Point *point)
+{
+	return hypertable_get_chunk_internal(h, point, false, NULL, NULL);
+}
 
-		subspace_store_add(h->chunk_cache, chunk->cube, cce, chunk_cache_entry_free);
-		MemoryContextSwitchTo(old_mcxt);
-	}
+/*
+ * Like hypertable_get_chunk(), but return NULL instead of creating the chunk
+ * when there is none.
+ */
+Chunk *
+hypertable_find_existing_chunk(Hypertable *h, Point *point)
+{
+	Chunk	   *cached = subspace_store_get(h->chunk_cache, point);
 
-	Assert(NULL != cce);
-	Assert(NULL != cce->chunk);
-	Assert(MemoryContextContains(cce->mcxt, cce));
-	Assert(MemoryContextContains(cce->mcxt, cce->chunk));
+	if (NULL != cached)
+		return cached;
 
-	return cce->chunk;
+	return hypertable_find_chunk(h, point);
+}
+
+/*
+ * Like hypertable_get_chunk(), but also tell whether the chunk was created.
+ * With "defer_indexes", a new chunk is created without its indexes. The caller
+ * is responsible for creating the indexes (once the chunk is loaded) when
+ * "created_without_indexes" is set on return.
+ */
+Chunk *
+hypertable_get_chunk_for_insert(Hypertable *h, Point *point, bool defer_indexes,
+								bool *created, bool *created_without_indexes)
+{
+	return hypertable_get_chunk_internal(h, point, defer_indexes, created,
+										 created_without_indexes);
 }
 
 bool
 hypertable_has_tablespace(Hypertable *ht, Oid tspc_oid)
 {
-	Tablespaces *tspcs = tablespace_scan(ht->fd.id);
-
-	return tablespaces_contain(tspcs, tspc_oid);
+	return tablespaces_contain(ht->tablespaces, tspc_oid);
 }
 
 /*
@@ -632,18 +775,18 @@ hypertable_has_tablespace(Hypertable *ht, Oid tspc_oid)
  * chunks in the same closed (space) dimension. This ensures chunks in the same
  * "space" partition will live on the same disk.
  */
-Tablespace *
-hypertable_select_tablespace(Hypertable *ht, Chunk *chunk)
+/*
+ * Get the index of a chunk's slice in the dimension that is used to spread
+ * chunks over tablespaces and data nodes.
+ */
+static int
+hypertable_chunk_placement_index(Hypertable *ht, Chunk *chunk)
 {
 	Dimension  *dim;
 	DimensionVec *vec;
 	DimensionSlice *slice;
-	Tablespaces *tspcs = tablespace_scan(ht->fd.id);
 	int			i = 0;
 
-	if (NULL == tspcs || tspcs->num_tablespaces == 0)
-		return NULL;
-
 	dim = hyperspace_get_closed_dimension(ht->space, 0);
 
 	if (NULL == dim)
@@ -667,8 +810,121 @@ hypertable_select_tablespace(Hypertable *ht, Chunk *chunk)
 
 	Assert(i >= 0);
 
+	return i;
+}
+
+/*
+ * Select a tablespace for a chunk so that the chunks of its time slice, which
+ * are the ones written to concurrently, are spread over the tablespaces.
+ *
+ * Each tablespace is weighted by the free space of its file system, and the
+ * chunk goes to the tablespace with the fewest chunks in the time slice
+ * relative to its weight. Ties go to the sticky choice, so tablespaces on the
+ * same file system are picked like with sticky placement as long as that does
+ * not pile up chunks of the time slice.
+ */
+static int
+hypertable_select_tablespace_spread(Hypertable *ht, Chunk *chunk, int sticky)
+{
+	Tablespaces *tspcs = ht->tablespaces;
+	Dimension  *time_dim = hyperspace_get_open_dimension(ht->space, 0);
+	DimensionSlice *slice = NULL;
+	int		   *num_chunks = palloc0(sizeof(int) * tspcs->num_tablespaces);
+	double	   *weights = palloc(sizeof(double) * tspcs->num_tablespaces);
+	bool		weighted = true;
+	int			best = sticky;
+	int			i;
+
+	if (NULL != time_dim)
+		slice = hypercube_get_slice_by_dimension_id(chunk->cube, time_dim->fd.id);
+
+	if (NULL != slice)
+	{
+		ChunkConstraints *ccs = chunk_constraints_alloc(1);
+
+		chunk_constraint_scan_by_dimension_slice_id(slice->fd.id, ccs);
+
+		for (i = 0; i < ccs->num_constraints; i++)
+		{
+			Chunk	   *other = chunk_get_by_id(ccs->constraints[i].fd.chunk_id, 0, false);
+			Oid			tspc_oid;
+			int			j;
+
+			/* The new chunk has no table yet */
+			if (NULL == other || !OidIsValid(other->table_id))
+				continue;
+
+			tspc_oid = get_rel_tablespace(other->table_id);
+
+			if (!OidIsValid(tspc_oid))
+				tspc_oid = MyDatabaseTableSpace;
+
+			for (j = 0; j < tspcs->num_tablespaces; j++)
+				if (tspcs->tablespaces[j].tablespace_oid == tspc_oid)
+					num_chunks[j]++;
+		}
+	}
+
+	for (i = 0; i < tspcs->num_tablespaces; i++)
+	{
+		int64		free_space = tablespace_get_free_space(tspcs->tablespaces[i].tablespace_oid);
+
+		weights[i] = (double) free_space;
+
+		if (free_space <= 0)
+			weighted = false;
+	}
+
+	/* Without the free space of every tablespace, only the chunks count */
+	if (!weighted)
+		for (i = 0; i < tspcs->num_tablespaces; i++)
+			weights[i] = 1.0;
+
+	for (i = 0; i < tspcs->num_tablespaces; i++)
+	{
+		if ((num_chunks[i] + 1) / weights[i] < (num_chunks[best] + 1) / weights[best])
+			best = i;
+	}
+
+	return best;
+}
+
+Tablespace *
+hypertable_select_tablespace(Hypertable *ht, Chunk *chunk)
+{
+	Tablespaces *tspcs = ht->tablespaces;
+	int			i;
+
+	if (NULL == tspcs || tspcs->num_tablespaces == 0)
+		return NULL;
+
 	/* Use the index of the slice to find the tablespace */
-	return &tspcs->tablespaces[i % tspcs->num_tablespaces];
+	i = hypertable_chunk_placement_index(ht, chunk) % tspcs->num_tablespaces;
+
+	if (guc_tablespace_placement == TABLESPACE_PLACEMENT_SPREAD && tspcs->num_tablespaces > 1)
+		i = hypertable_select_tablespace_spread(ht, chunk, i);
+
+	return &tspcs->tablespaces[i];
+}
+
+/*
+ * Select the data node to create a chunk on, or NULL if the hypertable is
+ * not distributed. Like tablespaces, data nodes are assigned round-robin
+ * over the slices of a dimension, so that the chunks of a space partition
+ * end up on the same node.
+ */
+ForeignServer *
+hypertable_select_data_node(Hypertable *ht, Chunk *chunk)
+{
+	List	   *nodes = data_node_scan(ht->fd.id);
+	int			i;
+
+	if (nodes == NIL)
+		return NULL;
+
+	i = hypertable_chunk_placement_index(ht, chunk);
+
+	return GetForeignServerByName(list_nth(nodes, i % list_length(nodes)), false);
 }
 
 char *
@@ -688,7 +944,7 @@ hypertable_select_tablespace_name(Hypertable *ht, Chunk *chunk)
 Tablespace *
 hypertable_get_tablespace_at_offset_from(Hypertable *ht, Oid tablespace_oid, int16 offset)
 {
-	Tablespaces *tspcs = tablespace_scan(ht->fd.id);
+	Tablespaces *tspcs = ht->tablespaces;
 	int			i = 0;
 
 	if (NULL == tspcs || tspcs->num_tablespaces == 0)
@@ -814,6 +1070,68 @@ hypertable_has_tuples(Oid table_relid, LOCKMODE lockmode)
 	return false;
 }
 
+/*
+ * Check whether the main table of a hypertable may hold rows. Rows are only
+ * left there by create_hypertable(..., defer_migration => true), until they
+ * are moved to chunks, so plans that leave out the main table must check
+ * this first. An empty main table has no blocks, which is cheap to check.
+ * The blocks of moved rows count until move_data_to_chunks() truncates the
+ * emptied table, or VACUUM truncates them, which errs on the safe side.
+ */
+bool
+hypertable_has_deferred_data(Hypertable *ht)
+{
+	Relation	rel = heap_open(ht->main_table_relid, NoLock);
+	bool		has_data = RelationGetNumberOfBlocks(rel) > 0;
+
+	heap_close(rel, NoLock);
+
+	return has_data;
+}
+
+TS_FUNCTION_INFO_V1(hypertable_truncate_if_empty);
+
+/*
+ * Truncate the main table of a hypertable that has no rows left, e.g., once
+ * move_data_to_chunks() has moved them all, so that
+ * hypertable_has_deferred_data() no longer counts the blocks of the moved
+ * rows. Waiting for the lock would block all queries on the hypertable, so
+ * the table is only truncated if the lock is available right away. The rows
+ * are checked after the lock is taken, with the latest snapshot.
+ *
+ * Returns true if the main table was truncated.
+ */
+Datum
+hypertable_truncate_if_empty(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_GETARG_OID(0);
+	TruncateStmt *stmt;
+	RangeVar   *rv;
+
+	hypertable_permissions_check(table_relid, GetUserId());
+
+	if (!ConditionalLockRelationOid(table_relid, AccessExclusiveLock) ||
+		table_has_tuples(table_relid, GetLatestSnapshot(), NoLock))
+		PG_RETURN_BOOL(false);
+
+	rv = makeRangeVar(get_namespace_name(get_rel_namespace(table_relid)),
+					  get_rel_name(table_relid), -1);
+#if PG10
+	rv->inh = false;
+#elif PG96
+	rv->inhOpt = INH_NO;
+#endif
+
+	/* Not through ProcessUtility, which rejects TRUNCATE ONLY of hypertables */
+	stmt = makeNode(TruncateStmt);
+	stmt->relations = list_make1(rv);
+	stmt->restart_seqs = false;
+	stmt->behavior = DROP_RESTRICT;
+	ExecuteTruncate(stmt);
+
+	PG_RETURN_BOOL(true);
+}
+
 static void
 hypertable_create_schema(const char *schema_name)
 {
@@ -848,6 +1166,8 @@ TS_FUNCTION_INFO_V1(hypertable_create);
  * create_default_indexes  BOOLEAN = TRUE
  * if_not_exists           BOOLEAN = FALSE
  * partitioning_func       REGPROC = NULL
+ * migrate_data            BOOLEAN = FALSE
+ * defer_migration         BOOLEAN = FALSE
  */
 Datum
 hypertable_create(PG_FUNCTION_ARGS)
@@ -858,6 +1178,7 @@ hypertable_create(PG_FUNCTION_ARGS)
 	bool		create_default_indexes = PG_ARGISNULL(7) ? false : PG_GETARG_BOOL(7);
 	bool		if_not_exists = PG_ARGISNULL(8) ? false : PG_GETARG_BOOL(8);
 	bool		migrate_data = PG_ARGISNULL(10) ? false : PG_GETARG_BOOL(10);
+	bool		defer_migration = PG_ARGISNULL(11) ? false : PG_GETARG_BOOL(11);
 	DimensionInfo time_dim_info = {
 		.table_relid = table_relid,
 		.colname = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1),
@@ -889,6 +1210,12 @@ hypertable_create(PG_FUNCTION_ARGS)
 	 */
 	LockRelationOid(table_relid, ShareRowExclusiveLock);
 
+	if (migrate_data && defer_migration)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("cannot both migrate and defer migration of data"),
+				 errhint("Set either 'migrate_data' or 'defer_migration' to true, but not both.")));
+
 	if (is_hypertable(table_relid))
 	{
 		if (if_not_exists)
@@ -932,7 +1259,7 @@ hypertable_create(PG_FUNCTION_ARGS)
 
 	table_has_data = table_has_tuples(table_relid, GetActiveSnapshot(), NoLock);
 
-	if (!migrate_data && table_has_data)
+	if (!migrate_data && !defer_migration && table_has_data)
 		ereport(ERROR,
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 				 errmsg("table \"%s\" is not empty", get_rel_name(table_relid)),
@@ -962,13 +1289,13 @@ hypertable_create(PG_FUNCTION_ARGS)
 		hypertable_create_schema(NameStr(*associated_schema_name));
 
 	/*
-	 * Hypertables do not support transition tables in triggers, so if the
-	 * table already has such triggers we bail out
+	 * Hypertables do not support transition tables in row-level triggers, so
+	 * if the table already has such triggers we bail out
 	 */
-	if (relation_has_transition_table_trigger(table_relid))
+	if (relation_has_row_transition_table_trigger(table_relid))
 		ereport(ERROR,
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-				 errmsg("hypertables do not support transition tables in triggers")));
+				 errmsg("hypertables do not support transition tables in row-level triggers")));
 
 	/* Validate that the dimensions are OK */
 	dimension_validate_info(&time_dim_info);
@@ -1017,8 +1344,18 @@ hypertable_create(PG_FUNCTION_ARGS)
 		tablespace_attach_internal(&tspc_name, table_relid, false);
 	}
 
-	/* Migrate data from the main table to chunks */
-	if (table_has_data)
+	/*
+	 * Migrate data from the main table to chunks, unless deferred. Deferred
+	 * data stays in the main table until it is moved with
+	 * move_data_to_chunks(), and the planner keeps the main table in plans
+	 * as long as it might hold rows, see hypertable_has_deferred_data().
+	 */
+	if (table_has_data && defer_migration)
+		ereport(NOTICE,
+				(errmsg("data in table \"%s\" has not been migrated to chunks",
+						get_rel_name(table_relid)),
+				 errhint("Call move_data_to_chunks() until it returns zero to migrate the data.")));
+	else if (table_has_data)
 	{
 		ereport(NOTICE,
 				(errmsg("migrating data to chunks"),
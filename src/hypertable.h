@@ -3,6 +3,7 @@
 
 #include <postgres.h>
 #include <nodes/primnodes.h>
+#include <foreign/foreign.h>
 
 #include "catalog.h"
 #include "dimension.h"
@@ -10,6 +11,7 @@
 #include "scanner.h"
 
 typedef struct SubspaceStore SubspaceStore;
+typedef struct SliceIndex SliceIndex;
 typedef struct Chunk Chunk;
 typedef struct HeapTupleData *HeapTuple;
 
@@ -19,12 +21,19 @@ typedef struct Hypertable
 	Oid			main_table_relid;
 	Hyperspace *space;
 	SubspaceStore *chunk_cache;
+	SliceIndex *slice_index;	/* built on first chunk lookup */
+	bool		has_compressed_chunks;
+	int64		chunk_target_size;	/* zero if adaptive chunking is off */
+	bool		has_continuous_aggs;	/* whether modifications are logged */
+	bool		has_bloom_filters;	/* whether chunks keep bloom filters */
+	Tablespaces *tablespaces;	/* attached tablespaces */
 } Hypertable;
 
 
 extern Oid	rel_get_owner(Oid relid);
 extern Hypertable *hypertable_get_by_id(int32 hypertable_id);
 extern Hypertable *hypertable_get_by_name(char *schema, char *name);
+extern List *hypertable_get_all_by_name(const char *schema, const char *table);
 extern bool hypertable_has_privs_of(Oid hypertable_oid, Oid userid);
 extern Oid	hypertable_permissions_check(Oid hypertable_oid, Oid userid);
 extern Hypertable *hypertable_from_tuple(HeapTuple tuple);
@@ -40,12 +49,17 @@ extern int	hypertable_delete_by_name(const char *schema_name, const char *table_
 extern int	hypertable_reset_associated_schema_name(const char *associated_schema);
 extern Oid	hypertable_id_to_relid(int32 hypertable_id);
 extern Chunk *hypertable_get_chunk(Hypertable *h, Point *point);
+extern Chunk *hypertable_find_existing_chunk(Hypertable *h, Point *point);
+extern Chunk *hypertable_get_chunk_for_insert(Hypertable *h, Point *point, bool defer_indexes,
+								bool *created, bool *created_without_indexes);
 extern Oid	hypertable_relid(RangeVar *rv);
 extern bool is_hypertable(Oid relid);
 extern bool hypertable_has_tablespace(Hypertable *ht, Oid tspc_oid);
 extern Tablespace *hypertable_select_tablespace(Hypertable *ht, Chunk *chunk);
 extern char *hypertable_select_tablespace_name(Hypertable *ht, Chunk *chunk);
+extern ForeignServer *hypertable_select_data_node(Hypertable *ht, Chunk *chunk);
 extern Tablespace *hypertable_get_tablespace_at_offset_from(Hypertable *ht, Oid tablespace_oid, int16 offset);
 extern bool hypertable_has_tuples(Oid table_relid, LOCKMODE lockmode);
+extern bool hypertable_has_deferred_data(Hypertable *ht);
 
 #endif							/* TIMESCALEDB_HYPERTABLE_H */
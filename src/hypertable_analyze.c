@@ -0,0 +1,547 @@
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <catalog/indexing.h>
+#include <catalog/pg_class.h>
+#include <catalog/pg_inherits_fn.h>
+#include <catalog/pg_statistic.h>
+#include <catalog/pg_type.h>
+#include <commands/vacuum.h>
+#include <parser/parse_oper.h>
+#include <utils/array.h>
+#include <utils/inval.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/rel.h>
+#include <utils/sortsupport.h>
+#include <utils/syscache.h>
+
+#include "hypertable_analyze.h"
+#include "dimension.h"
+#include "compat.h"
+
+/*
+ * Hypertable statistics merged from the statistics of the chunks.
+ *
+ * ANALYZE of a hypertable analyzes each of its chunks, but not the
+ * hypertable itself, so the planner has no statistics for the hypertable as
+ * an inheritance parent, e.g., for the number of groups of a GROUP BY or the
+ * selectivity of a join. Sampling the whole hypertable for them would make
+ * every ANALYZE read all chunks, including those that have not changed.
+ *
+ * Instead, the statistics of the chunks are merged into the hypertable's
+ * inherited statistics in pg_statistic, which the planner uses for the
+ * hypertable as an append relation parent:
+ *
+ * - The null fraction and width are averages weighted by the chunks' rows.
+ *
+ * - The MCVs of the chunks are added up by value. Rows of a value in chunks
+ *	 where it is not an MCV are not counted, so the frequencies are lower
+ *	 bounds.
+ *
+ * - The histogram bounds of the chunks, and the MCVs that do not make it into
+ *	 the merged MCV list, are sorted by value and weighted by the rows that
+ *	 they stand for. The merged histogram picks the values at equal steps of
+ *	 the cumulative weight.
+ *
+ * - The number of distinct values of a column for which all chunks have a
+ *	 number that grows with the rows is the sum over the chunks, which is
+ *	 also used for the open ("time") dimension, since its values do not
+ *	 repeat across chunks. Other columns likely repeat their values across
+ *	 chunks, so the largest number of any chunk, or of the merged MCVs, is
+ *	 used.
+ */
+
+typedef struct StatsValue
+{
+	Datum		value;
+	double		rows;			/* Rows of the value, or of the histogram
+								 * bucket that it bounds */
+	int			position;		/* Position in value order, to break ties */
+} StatsValue;
+
+typedef struct StatsValues
+{
+	StatsValue *values;
+	int			num_values;
+	int			max_values;
+} StatsValues;
+
+typedef struct ColumnStats
+{
+	Form_pg_attribute attr;
+	int16		typlen;
+	bool		typbyval;
+	char		typalign;
+	Oid			eq_opr;
+	Oid			lt_opr;
+	SortSupportData ssup;
+	double		rows;
+	double		null_rows;
+	double		width_rows;		/* Width times non-null rows */
+	double		distinct_sum;
+	double		distinct_max;
+	bool		distinct_scales;	/* The numbers of distinct values of all
+									 * chunks grow with their rows */
+	StatsValues mcvs;
+	StatsValues bounds;
+} ColumnStats;
+
+static void
+stats_values_add(StatsValues *sv, Datum value, double rows)
+{
+	if (sv->num_values >= sv->max_values)
+	{
+		sv->max_values = Max(sv->max_values * 2, 64);
+		sv->values = sv->values == NULL ?
+			palloc(sizeof(StatsValue) * sv->max_values) :
+			repalloc(sv->values, sizeof(StatsValue) * sv->max_values);
+	}
+
+	sv->values[sv->num_values].value = value;
+	sv->values[sv->num_values].rows = rows;
+	sv->num_values++;
+}
+
+static int
+stats_value_cmp_value(const void *a, const void *b, void *arg)
+{
+	return ApplySortComparator(((const StatsValue *) a)->value, false,
+							   ((const StatsValue *) b)->value, false,
+							   (SortSupport) arg);
+}
+
+/* Most rows first, and in value order for equal rows */
+static int
+stats_value_cmp_rows(const void *a, const void *b)
+{
+	const StatsValue *sa = a;
+	const StatsValue *sb = b;
+
+	if (sa->rows != sb->rows)
+		return sa->rows > sb->rows ? -1 : 1;
+
+	return sa->position - sb->position;
+}
+
+static double
+chunk_get_reltuples(Oid chunk_relid)
+{
+	HeapTuple	tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(chunk_relid));
+	double		reltuples;
+
+	if (!HeapTupleIsValid(tuple))
+		return 0;
+
+	reltuples = ((Form_pg_class) GETSTRUCT(tuple))->reltuples;
+	ReleaseSysCache(tuple);
+
+	return reltuples;
+}
+
+static ArrayType *
+stats_slot_get_array(HeapTuple tuple, AttrNumber attno)
+{
+	bool		isnull;
+	Datum		datum = SysCacheGetAttr(STATRELATTINH, tuple, attno, &isnull);
+
+	if (isnull)
+		return NULL;
+
+	/* Copy the array, so that its values outlive the syscache entry */
+	return DatumGetArrayTypePCopy(datum);
+}
+
+/*
+ * Add the statistics of a column of a chunk. Chunks that have not been
+ * analyzed, or that do not have the column, are left out.
+ */
+static void
+column_stats_add_chunk(ColumnStats *cs, Oid chunk_relid)
+{
+	AttrNumber	attno = get_attnum(chunk_relid, NameStr(cs->attr->attname));
+	double		rows = chunk_get_reltuples(chunk_relid);
+	double		nonnull_rows;
+	double		mcv_rows = 0;
+	ArrayType  *histogram = NULL;
+	Form_pg_statistic form;
+	HeapTuple	tuple;
+	int			i;
+
+	if (attno == InvalidAttrNumber || rows <= 0)
+		return;
+
+	tuple = SearchSysCache3(STATRELATTINH,
+							ObjectIdGetDatum(chunk_relid),
+							Int16GetDatum(attno),
+							BoolGetDatum(false));
+
+	if (!HeapTupleIsValid(tuple))
+		return;
+
+	form = (Form_pg_statistic) GETSTRUCT(tuple);
+	nonnull_rows = rows * (1.0 - form->stanullfrac);
+
+	cs->rows += rows;
+	cs->null_rows += rows * form->stanullfrac;
+	cs->width_rows += form->stawidth * nonnull_rows;
+
+	if (form->stadistinct < 0)
+	{
+		cs->distinct_sum += -form->stadistinct * rows;
+		cs->distinct_max = Max(cs->distinct_max, -form->stadistinct * rows);
+	}
+	else
+	{
+		cs->distinct_sum += form->stadistinct;
+		cs->distinct_max = Max(cs->distinct_max, form->stadistinct);
+		cs->distinct_scales = false;
+	}
+
+	for (i = 0; i < STATISTIC_NUM_SLOTS; i++)
+	{
+		int16		kind = (&form->stakind1)[i];
+		Oid			op = (&form->staop1)[i];
+
+		if (kind == STATISTIC_KIND_MCV && op == cs->eq_opr)
+		{
+			ArrayType  *values = stats_slot_get_array(tuple, Anum_pg_statistic_stavalues1 + i);
+			ArrayType  *numbers = stats_slot_get_array(tuple, Anum_pg_statistic_stanumbers1 + i);
+			Datum	   *mcvs;
+			float4	   *freqs;
+			int			num_mcvs;
+			int			j;
+
+			if (NULL == values || NULL == numbers)
+				continue;
+
+			deconstruct_array(values, cs->attr->atttypid, cs->typlen, cs->typbyval,
+							  cs->typalign, &mcvs, NULL, &num_mcvs);
+			freqs = (float4 *) ARR_DATA_PTR(numbers);
+
+			for (j = 0; j < num_mcvs && j < ARR_DIMS(numbers)[0]; j++)
+			{
+				stats_values_add(&cs->mcvs, mcvs[j], freqs[j] * rows);
+				mcv_rows += freqs[j] * rows;
+			}
+		}
+		else if (kind == STATISTIC_KIND_HISTOGRAM && op == cs->lt_opr)
+			histogram = stats_slot_get_array(tuple, Anum_pg_statistic_stavalues1 + i);
+	}
+
+	/* The histogram covers the rows that are not MCVs */
+	if (NULL != histogram)
+	{
+		Datum	   *bounds;
+		int			num_bounds;
+		double		bound_rows;
+
+		deconstruct_array(histogram, cs->attr->atttypid, cs->typlen, cs->typbyval,
+						  cs->typalign, &bounds, NULL, &num_bounds);
+		bound_rows = Max(nonnull_rows - mcv_rows, 0) / num_bounds;
+
+		for (i = 0; i < num_bounds; i++)
+			stats_values_add(&cs->bounds, bounds[i], bound_rows);
+	}
+
+	ReleaseSysCache(tuple);
+}
+
+/*
+ * Add up the rows of equal MCVs of different chunks. Returns the number of
+ * distinct MCVs, which are sorted by value.
+ */
+static int
+column_stats_combine_mcvs(ColumnStats *cs)
+{
+	StatsValues *sv = &cs->mcvs;
+	int			num_distinct = 0;
+	int			i;
+
+	if (sv->num_values == 0)
+		return 0;
+
+	qsort_arg(sv->values, sv->num_values, sizeof(StatsValue),
+			  stats_value_cmp_value, &cs->ssup);
+
+	for (i = 0; i < sv->num_values; i++)
+	{
+		if (num_distinct > 0 &&
+			stats_value_cmp_value(&sv->values[num_distinct - 1], &sv->values[i], &cs->ssup) == 0)
+			sv->values[num_distinct - 1].rows += sv->values[i].rows;
+		else
+		{
+			sv->values[num_distinct] = sv->values[i];
+			sv->values[num_distinct].position = num_distinct;
+			num_distinct++;
+		}
+	}
+
+	sv->num_values = num_distinct;
+
+	return num_distinct;
+}
+
+static Datum
+stats_build_values_array(ColumnStats *cs, Datum *values, int num_values)
+{
+	return PointerGetDatum(construct_array(values, num_values, cs->attr->atttypid,
+										   cs->typlen, cs->typbyval, cs->typalign));
+}
+
+/*
+ * Pick the histogram bounds at equal steps of the cumulative rows of the
+ * values sorted by value.
+ */
+static int
+column_stats_build_histogram(ColumnStats *cs, int target, Datum *bounds)
+{
+	StatsValues *sv = &cs->bounds;
+	int			num_bounds = Min(target + 1, sv->num_values);
+	double		total_rows = 0;
+	double		cumulative_rows;
+	int			num_picked = 0;
+	int			i,
+				j;
+
+	if (num_bounds < 2)
+		return 0;
+
+	qsort_arg(sv->values, sv->num_values, sizeof(StatsValue),
+			  stats_value_cmp_value, &cs->ssup);
+
+	for (i = 0; i < sv->num_values; i++)
+		total_rows += sv->values[i].rows;
+
+	j = 0;
+	cumulative_rows = sv->values[0].rows;
+
+	for (i = 0; i < num_bounds; i++)
+	{
+		double		target_rows = total_rows * i / (num_bounds - 1);
+
+		while (j < sv->num_values - 1 && cumulative_rows < target_rows)
+			cumulative_rows += sv->values[++j].rows;
+
+		/* Bounds must be distinct */
+		if (num_picked == 0 ||
+			ApplySortComparator(bounds[num_picked - 1], false,
+								sv->values[j].value, false, &cs->ssup) != 0)
+			bounds[num_picked++] = sv->values[j].value;
+	}
+
+	return num_picked < 2 ? 0 : num_picked;
+}
+
+static void
+hypertable_statistic_update(Oid relid, AttrNumber attno, Datum *values, bool *nulls)
+{
+	Relation	rel = heap_open(StatisticRelationId, RowExclusiveLock);
+	HeapTuple	oldtuple;
+	HeapTuple	tuple;
+
+	oldtuple = SearchSysCache3(STATRELATTINH,
+							   ObjectIdGetDatum(relid),
+							   Int16GetDatum(attno),
+							   BoolGetDatum(true));
+
+	if (HeapTupleIsValid(oldtuple))
+	{
+		bool		replaces[Natts_pg_statistic];
+
+		memset(replaces, true, sizeof(replaces));
+		tuple = heap_modify_tuple(oldtuple, RelationGetDescr(rel), values, nulls, replaces);
+		ReleaseSysCache(oldtuple);
+		CatalogTupleUpdate(rel, &tuple->t_self, tuple);
+	}
+	else
+	{
+		tuple = heap_form_tuple(RelationGetDescr(rel), values, nulls);
+		CatalogTupleInsert(rel, tuple);
+	}
+
+	heap_freetuple(tuple);
+	heap_close(rel, RowExclusiveLock);
+}
+
+/*
+ * Merge the chunks' statistics of a column and store them as the
+ * hypertable's inherited statistics.
+ */
+static void
+column_stats_merge(Hypertable *ht, Form_pg_attribute attr, List *chunk_relids)
+{
+	Dimension  *time_dim = hyperspace_get_open_dimension(ht->space, 0);
+	int			target = attr->attstattarget < 0 ? default_statistics_target : attr->attstattarget;
+	ColumnStats cs = {
+		.attr = attr,
+		.distinct_scales = true,
+	};
+	Datum		values[Natts_pg_statistic];
+	bool		nulls[Natts_pg_statistic];
+	double		nonnull_rows;
+	double		distinct;
+	int			num_mcvs;
+	int			num_bounds;
+	int			slot = 0;
+	Datum	   *datums;
+	ListCell   *lc;
+	int			i;
+
+	get_typlenbyvalalign(attr->atttypid, &cs.typlen, &cs.typbyval, &cs.typalign);
+	get_sort_group_operators(attr->atttypid, false, false, false,
+							 &cs.lt_opr, &cs.eq_opr, NULL, NULL);
+
+	/* Without a sort order, only the scalar statistics can be merged */
+	if (OidIsValid(cs.lt_opr))
+	{
+		cs.ssup.ssup_cxt = CurrentMemoryContext;
+		cs.ssup.ssup_collation = attr->attcollation;
+		cs.ssup.ssup_nulls_first = false;
+		PrepareSortSupportFromOrderingOp(cs.lt_opr, &cs.ssup);
+	}
+	else
+		cs.eq_opr = InvalidOid;
+
+	foreach(lc, chunk_relids)
+		column_stats_add_chunk(&cs, lfirst_oid(lc));
+
+	if (cs.rows <= 0)
+		return;
+
+	nonnull_rows = cs.rows - cs.null_rows;
+	num_mcvs = column_stats_combine_mcvs(&cs);
+
+	if (cs.distinct_scales ||
+		(NULL != time_dim && time_dim->column_attno == attr->attnum))
+		distinct = cs.distinct_sum;
+	else
+		distinct = Max(cs.distinct_max, num_mcvs);
+
+	distinct = Min(distinct, nonnull_rows);
+
+	memset(nulls, false, sizeof(nulls));
+	values[Anum_pg_statistic_starelid - 1] = ObjectIdGetDatum(ht->main_table_relid);
+	values[Anum_pg_statistic_staattnum - 1] = Int16GetDatum(attr->attnum);
+	values[Anum_pg_statistic_stainherit - 1] = BoolGetDatum(true);
+	values[Anum_pg_statistic_stanullfrac - 1] = Float4GetDatum(cs.null_rows / cs.rows);
+	values[Anum_pg_statistic_stawidth - 1] =
+		Int32GetDatum(nonnull_rows > 0 ? (int32) (cs.width_rows / nonnull_rows) : 0);
+
+	/* Like ANALYZE, store numbers that grow with the rows as a fraction */
+	if (cs.distinct_scales || distinct > 0.1 * cs.rows)
+		values[Anum_pg_statistic_stadistinct - 1] = Float4GetDatum(-(distinct / cs.rows));
+	else
+		values[Anum_pg_statistic_stadistinct - 1] = Float4GetDatum(distinct);
+
+	for (i = 0; i < STATISTIC_NUM_SLOTS; i++)
+	{
+		values[Anum_pg_statistic_stakind1 - 1 + i] = Int16GetDatum(0);
+		values[Anum_pg_statistic_staop1 - 1 + i] = ObjectIdGetDatum(InvalidOid);
+		nulls[Anum_pg_statistic_stanumbers1 - 1 + i] = true;
+		nulls[Anum_pg_statistic_stavalues1 - 1 + i] = true;
+	}
+
+	/* The most common values of all chunks, the rest go to the histogram */
+	if (num_mcvs > 0)
+	{
+		int			num_kept = Min(num_mcvs, target);
+		Datum	   *freqs = palloc(sizeof(Datum) * num_kept);
+
+		qsort(cs.mcvs.values, num_mcvs, sizeof(StatsValue), stats_value_cmp_rows);
+		datums = palloc(sizeof(Datum) * num_kept);
+
+		for (i = 0; i < num_kept; i++)
+		{
+			datums[i] = cs.mcvs.values[i].value;
+			freqs[i] = Float4GetDatum(cs.mcvs.values[i].rows / cs.rows);
+		}
+
+		for (i = num_kept; i < num_mcvs; i++)
+			stats_values_add(&cs.bounds, cs.mcvs.values[i].value, cs.mcvs.values[i].rows);
+
+		values[Anum_pg_statistic_stakind1 - 1 + slot] = Int16GetDatum(STATISTIC_KIND_MCV);
+		values[Anum_pg_statistic_staop1 - 1 + slot] = ObjectIdGetDatum(cs.eq_opr);
+		values[Anum_pg_statistic_stanumbers1 - 1 + slot] =
+			PointerGetDatum(construct_array(freqs, num_kept, FLOAT4OID, sizeof(float4),
+											FLOAT4PASSBYVAL, 'i'));
+		nulls[Anum_pg_statistic_stanumbers1 - 1 + slot] = false;
+		values[Anum_pg_statistic_stavalues1 - 1 + slot] = stats_build_values_array(&cs, datums, num_kept);
+		nulls[Anum_pg_statistic_stavalues1 - 1 + slot] = false;
+		slot++;
+	}
+
+	if (OidIsValid(cs.lt_opr))
+	{
+		datums = palloc(sizeof(Datum) * (target + 1));
+		num_bounds = column_stats_build_histogram(&cs, target, datums);
+
+		if (num_bounds > 0)
+		{
+			values[Anum_pg_statistic_stakind1 - 1 + slot] = Int16GetDatum(STATISTIC_KIND_HISTOGRAM);
+			values[Anum_pg_statistic_staop1 - 1 + slot] = ObjectIdGetDatum(cs.lt_opr);
+			values[Anum_pg_statistic_stavalues1 - 1 + slot] = stats_build_values_array(&cs, datums, num_bounds);
+			nulls[Anum_pg_statistic_stavalues1 - 1 + slot] = false;
+			slot++;
+		}
+	}
+
+	hypertable_statistic_update(ht->main_table_relid, attr->attnum, values, nulls);
+}
+
+static bool
+column_is_listed(List *columns, const char *name)
+{
+	ListCell   *lc;
+
+	foreach(lc, columns)
+	{
+		if (strcmp(strVal(lfirst(lc)), name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Merge the statistics of all chunks of a hypertable into the hypertable's
+ * statistics, for the given columns or all columns if NIL. The chunks are
+ * not analyzed here, so only the chunks that changed need to be analyzed
+ * before.
+ */
+void
+hypertable_analyze_merge_chunk_stats(Hypertable *ht, List *columns)
+{
+	MemoryContext merge_mcxt = AllocSetContextCreate(CurrentMemoryContext,
+													 "Hypertable statistics merge",
+													 ALLOCSET_DEFAULT_SIZES);
+	MemoryContext old = MemoryContextSwitchTo(merge_mcxt);
+	Relation	rel;
+	TupleDesc	tupdesc;
+	List	   *chunk_relids;
+	int			i;
+
+	/* The same lock as ANALYZE takes */
+	rel = heap_open(ht->main_table_relid, ShareUpdateExclusiveLock);
+	tupdesc = RelationGetDescr(rel);
+	chunk_relids = find_inheritance_children(ht->main_table_relid, NoLock);
+
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = tupdesc->attrs[i];
+
+		if (attr->attisdropped || attr->attstattarget == 0)
+			continue;
+
+		if (columns != NIL && !column_is_listed(columns, NameStr(attr->attname)))
+			continue;
+
+		column_stats_merge(ht, attr, chunk_relids);
+	}
+
+	/* Make cached plans use the new statistics */
+	CacheInvalidateRelcache(rel);
+	heap_close(rel, NoLock);
+
+	MemoryContextSwitchTo(old);
+	MemoryContextDelete(merge_mcxt);
+}
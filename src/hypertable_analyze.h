@@ -0,0 +1,11 @@
+#ifndef TIMESCALEDB_HYPERTABLE_ANALYZE_H
+#define TIMESCALEDB_HYPERTABLE_ANALYZE_H
+
+#include <postgres.h>
+#include <nodes/pg_list.h>
+
+#include "hypertable.h"
+
+extern void hypertable_analyze_merge_chunk_stats(Hypertable *ht, List *columns);
+
+#endif							/* TIMESCALEDB_HYPERTABLE_ANALYZE_H */
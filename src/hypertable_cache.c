@@ -3,6 +3,9 @@
 #include <utils/catcache.h>
 #include <utils/lsyscache.h>
 #include <utils/builtins.h>
+#include <access/htup_details.h>
+#include <funcapi.h>
+#include <lib/ilist.h>
 
 #include "hypertable_cache.h"
 #include "hypertable.h"
@@ -12,6 +15,12 @@
 #include "scanner.h"
 #include "dimension.h"
 #include "tablespace.h"
+#include "subspace_store.h"
+#include "chunk.h"
+#include "chunk_dispatch.h"
+#include "timing.h"
+#include "guc.h"
+#include "compat.h"
 
 static void *hypertable_cache_create_entry(Cache *cache, CacheQuery *query);
 
@@ -33,8 +42,28 @@ typedef struct
 {
 	Oid			relid;
 	Hypertable *hypertable;
+	MemoryContext mcxt;			/* Holds the hypertable, NULL for negative
+								 * entries */
+	dlist_node	lru_node;		/* Position in the LRU list, for positive
+								 * entries only */
+	int64		memory_bytes;	/* Memory of mcxt when last measured */
 } HypertableNameCacheEntry;
 
+/*
+ * The hypertable cache keeps its positive entries in LRU order and tracks
+ * their memory, so that the least recently used hypertables can be evicted
+ * when the cache exceeds timescaledb.hypertable_cache_memory_limit.
+ *
+ * The memory of an entry only grows when its chunk cache gets a new chunk,
+ * so the entry is measured when it is created and on chunk cache misses,
+ * instead of on every lookup.
+ */
+typedef struct HypertableCache
+{
+	Cache		cache;
+	dlist_head	lru;			/* Most recently used first */
+	int64		memory_bytes;	/* Sum of memory_bytes of all entries */
+} HypertableCache;
 
 static Cache *
 hypertable_cache_create()
@@ -43,7 +72,8 @@ hypertable_cache_create()
 											  "Hypertable cache",
 											  ALLOCSET_DEFAULT_SIZES);
 
-	Cache	   *cache = MemoryContextAlloc(ctx, sizeof(Cache));
+	HypertableCache *hcache = MemoryContextAllocZero(ctx, sizeof(HypertableCache));
+	Cache	   *cache = &hcache->cache;
 	Cache		template =
 	{
 		.hctl =
@@ -60,6 +90,7 @@ hypertable_cache_create()
 	};
 
 	*cache = template;
+	dlist_init(&hcache->lru);
 
 	cache_init(cache);
 
@@ -68,6 +99,61 @@ hypertable_cache_create()
 
 static Cache *hypertable_cache_current = NULL;
 
+/*
+ * Memory contexts of entries that were evicted from the current cache while it
+ * was pinned. Pinned hypertables might still be in use, so the contexts are
+ * freed once the cache is no longer pinned.
+ */
+static List *hypertable_cache_evicted = NIL;
+
+static void hypertable_cache_remove_entry(Cache *cache, HypertableNameCacheEntry *entry);
+
+static int64
+hypertable_cache_memory_limit(void)
+{
+	return (int64) guc_hypertable_cache_memory_limit * 1024;
+}
+
+/* Measure the memory of an entry and update the total of the cache */
+static void
+hypertable_cache_entry_account(HypertableCache *hcache, HypertableNameCacheEntry *entry)
+{
+	int64		memory_bytes = memory_context_total_space(entry->mcxt);
+
+	hcache->memory_bytes += memory_bytes - entry->memory_bytes;
+	entry->memory_bytes = memory_bytes;
+}
+
+/*
+ * Evict the least recently used hypertables until the cache is within its
+ * memory limit. The given entry, which is in use, is never evicted, even if
+ * it alone exceeds the limit.
+ */
+static void
+hypertable_cache_enforce_memory_limit(HypertableCache *hcache, HypertableNameCacheEntry *keep)
+{
+	int64		limit = hypertable_cache_memory_limit();
+
+	/*
+	 * Entries of an older, invalidated cache might be in use without the
+	 * cache counting as pinned, so only the current cache is trimmed. Older
+	 * caches are freed when their last pin is released.
+	 */
+	if (limit <= 0 || &hcache->cache != hypertable_cache_current)
+		return;
+
+	while (hcache->memory_bytes > limit && !dlist_is_empty(&hcache->lru))
+	{
+		HypertableNameCacheEntry *victim =
+		dlist_container(HypertableNameCacheEntry, lru_node, dlist_tail_node(&hcache->lru));
+
+		if (victim == keep)
+			break;
+
+		hypertable_cache_remove_entry(&hcache->cache, victim);
+	}
+}
+
 static bool
 hypertable_tuple_found(TupleInfo *ti, void *data)
 {
@@ -82,7 +168,11 @@ hypertable_cache_create_entry(Cache *cache, CacheQuery *query)
 {
 	HypertableCacheQuery *hq = (HypertableCacheQuery *) query;
 	HypertableNameCacheEntry *cache_entry = query->result;
+	MemoryContext old;
 	int			number_found;
+	TimingState timing;
+
+	timing_begin(&timing, TIMING_HYPERTABLE_CACHE_REBUILD);
 
 	if (NULL == hq->schema)
 		hq->schema = get_namespace_name(get_rel_namespace(hq->relid));
@@ -90,6 +180,15 @@ hypertable_cache_create_entry(Cache *cache, CacheQuery *query)
 	if (NULL == hq->table)
 		hq->table = get_rel_name(hq->relid);
 
+	/*
+	 * Each hypertable gets its own memory context so that it can be freed
+	 * when the hypertable alone is invalidated.
+	 */
+	cache_entry->mcxt = AllocSetContextCreate(cache_memory_ctx(cache),
+											  "Hypertable cache entry",
+											  ALLOCSET_SMALL_SIZES);
+	old = MemoryContextSwitchTo(cache_entry->mcxt);
+
 	number_found = hypertable_scan(hq->schema,
 								   hq->table,
 								   hypertable_tuple_found,
@@ -97,30 +196,218 @@ hypertable_cache_create_entry(Cache *cache, CacheQuery *query)
 								   AccessShareLock,
 								   false);
 
+	MemoryContextSwitchTo(old);
+
 	switch (number_found)
 	{
 		case 0:
 			/* Negative cache entry: table is not a hypertable */
 			cache_entry->hypertable = NULL;
+			MemoryContextDelete(cache_entry->mcxt);
+			cache_entry->mcxt = NULL;
 			break;
 		case 1:
 			Assert(strncmp(cache_entry->hypertable->fd.schema_name.data, hq->schema, NAMEDATALEN) == 0);
 			Assert(strncmp(cache_entry->hypertable->fd.table_name.data, hq->table, NAMEDATALEN) == 0);
+			cache_entry->memory_bytes = 0;
+			dlist_push_head(&((HypertableCache *) cache)->lru, &cache_entry->lru_node);
+			hypertable_cache_entry_account((HypertableCache *) cache, cache_entry);
+			hypertable_cache_enforce_memory_limit((HypertableCache *) cache, cache_entry);
 			break;
 		default:
 			elog(ERROR, "Got an unexpected number of records: %d", number_found);
 			break;
 	}
 
+	timing_end(&timing, InvalidOid);
+
 	return query->result;
 }
 
+/*
+ * Whether relations are hypertables or chunks.
+ *
+ * The planner and utility hooks run for every statement, including those of
+ * OLTP workloads that never touch a hypertable. Such statements can skip the
+ * hypertable cache, and the walks over their trees, if none of their
+ * relations is relevant to us. The relevance of a relation is remembered
+ * until its relcache entry is invalidated. That happens for a table that is
+ * made a hypertable, since inserting a hypertable invalidates its main
+ * table, while chunks are always new tables.
+ */
+typedef struct RelevanceEntry
+{
+	Oid			relid;
+	bool		relevant;
+} RelevanceEntry;
+
+static HTAB *relevance_htab = NULL;
+
+static void
+relevance_htab_create(void)
+{
+	HASHCTL		ctl = {
+		.keysize = sizeof(Oid),
+		.entrysize = sizeof(RelevanceEntry),
+		.hcxt = CacheMemoryContext,
+	};
+
+	relevance_htab = hash_create("Hypertable relevance", 64, &ctl,
+								 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+}
+
+/*
+ * Check if a relation is a hypertable or a chunk, using the catalog only the
+ * first time a relation is checked.
+ */
+bool
+hypertable_cache_relid_is_relevant(Oid relid)
+{
+	RelevanceEntry *entry;
+	bool		relevant;
+
+	if (!OidIsValid(relid))
+		return false;
+
+	if (NULL != relevance_htab)
+	{
+		entry = hash_search(relevance_htab, &relid, HASH_FIND, NULL);
+
+		if (NULL != entry)
+			return entry->relevant;
+	}
+
+	/* The scans can accept invalidations that reset the table */
+	relevant = is_hypertable(relid) || chunk_exists_relid(relid);
+
+	if (NULL == relevance_htab)
+		relevance_htab_create();
+
+	entry = hash_search(relevance_htab, &relid, HASH_ENTER, NULL);
+	entry->relevant = relevant;
+
+	return relevant;
+}
+
 void
 hypertable_cache_invalidate_callback(void)
 {
 	CACHE1_elog(WARNING, "DESTROY hypertable_cache");
 	cache_invalidate(hypertable_cache_current);
 	hypertable_cache_current = hypertable_cache_create();
+
+	/* Evicted entries are freed along with the old cache */
+	hypertable_cache_evicted = NIL;
+
+	if (NULL != relevance_htab)
+	{
+		hash_destroy(relevance_htab);
+		relevance_htab = NULL;
+	}
+}
+
+static bool
+hypertable_cache_is_pinned(Cache *cache)
+{
+	return cache->refcount > 1;
+}
+
+static void
+hypertable_cache_free_evicted(void)
+{
+	ListCell   *lc;
+
+	foreach(lc, hypertable_cache_evicted)
+		MemoryContextDelete(lfirst(lc));
+
+	list_free(hypertable_cache_evicted);
+	hypertable_cache_evicted = NIL;
+}
+
+/*
+ * Remove an entry from the hypertable cache and free its memory, unless the
+ * cache is pinned.
+ */
+static void
+hypertable_cache_remove_entry(Cache *cache, HypertableNameCacheEntry *entry)
+{
+	MemoryContext mcxt = entry->mcxt;
+	Oid			relid = entry->relid;
+
+	if (NULL != mcxt)
+	{
+		HypertableCache *hcache = (HypertableCache *) cache;
+
+		dlist_delete(&entry->lru_node);
+		hcache->memory_bytes -= entry->memory_bytes;
+	}
+
+	cache_remove(cache, &relid);
+
+	if (NULL == mcxt)
+		return;
+
+	if (hypertable_cache_is_pinned(cache))
+	{
+		MemoryContext old = cache_switch_to_memory_context(cache);
+
+		hypertable_cache_evicted = lappend(hypertable_cache_evicted, mcxt);
+		MemoryContextSwitchTo(old);
+	}
+	else
+		MemoryContextDelete(mcxt);
+}
+
+/*
+ * Evict a single table from the hypertable cache.
+ *
+ * This is called when the relcache entry of a table is invalidated, which we
+ * signal for a hypertable's main table whenever its metadata changes. Other
+ * hypertables stay cached.
+ */
+void
+hypertable_cache_invalidate_entry(Oid relid)
+{
+	Cache	   *cache = hypertable_cache_current;
+	HypertableNameCacheEntry *entry;
+
+	if (NULL != relevance_htab)
+		hash_search(relevance_htab, &relid, HASH_REMOVE, NULL);
+
+	if (NULL == cache)
+		return;
+
+	entry = hash_search(cache->htab, &relid, HASH_FIND, NULL);
+
+	if (NULL == entry)
+		return;
+
+	CACHE1_elog(WARNING, "EVICT hypertable_cache entry");
+
+	hypertable_cache_remove_entry(cache, entry);
+}
+
+/*
+ * Update the memory of a hypertable's cache entry after its chunk cache has
+ * grown, and evict other hypertables if the cache is over its memory limit.
+ */
+void
+hypertable_cache_update_memory(Hypertable *ht)
+{
+	Cache	   *cache = hypertable_cache_current;
+	HypertableNameCacheEntry *entry;
+
+	if (NULL == cache || hypertable_cache_memory_limit() <= 0)
+		return;
+
+	entry = hash_search(cache->htab, &ht->main_table_relid, HASH_FIND, NULL);
+
+	/* The hypertable might be from an older cache or already evicted */
+	if (NULL == entry || entry->hypertable != ht)
+		return;
+
+	hypertable_cache_entry_account((HypertableCache *) cache, entry);
+	hypertable_cache_enforce_memory_limit((HypertableCache *) cache, entry);
 }
 
 /* Get hypertable cache entry. If the entry is not in the cache, add it. */
@@ -155,12 +442,19 @@ hypertable_cache_get_entry_with_table(Cache *cache, Oid relid, const char *schem
 	};
 	HypertableNameCacheEntry *entry = cache_fetch(cache, &query.q);
 
+	if (NULL != entry->hypertable)
+		dlist_move_head(&((HypertableCache *) cache)->lru, &entry->lru_node);
+
 	return entry->hypertable;
 }
 
 extern Cache *
 hypertable_cache_pin()
 {
+	if (hypertable_cache_evicted != NIL &&
+		!hypertable_cache_is_pinned(hypertable_cache_current))
+		hypertable_cache_free_evicted();
+
 	return cache_pin(hypertable_cache_current);
 }
 
@@ -176,3 +470,175 @@ _hypertable_cache_fini(void)
 {
 	cache_invalidate(hypertable_cache_current);
 }
+
+typedef struct CacheStatsRow
+{
+	const char *cache_name;
+	Oid			hypertable_relid;
+	int64		num_entries;
+	int32		max_entries;	/* Zero for no limit, -1 for unknown */
+	uint64		hits;
+	uint64		misses;
+	uint64		evictions;
+	int64		memory_bytes;	/* -1 for unknown */
+	int64		max_memory_bytes;	/* -1 for no limit */
+} CacheStatsRow;
+
+enum Anum_cache_stats
+{
+	Anum_cache_stats_cache_name = 1,
+	Anum_cache_stats_hypertable,
+	Anum_cache_stats_num_entries,
+	Anum_cache_stats_max_entries,
+	Anum_cache_stats_hits,
+	Anum_cache_stats_misses,
+	Anum_cache_stats_evictions,
+	Anum_cache_stats_memory_bytes,
+	Anum_cache_stats_max_memory_bytes,
+	_Anum_cache_stats_max,
+};
+
+#define Natts_cache_stats \
+	(_Anum_cache_stats_max - 1)
+
+static CacheStatsRow *
+cache_stats_add_row(List **rows, const char *cache_name, Oid hypertable_relid)
+{
+	CacheStatsRow *row = palloc0(sizeof(CacheStatsRow));
+
+	row->cache_name = cache_name;
+	row->hypertable_relid = hypertable_relid;
+	row->max_entries = -1;
+	row->memory_bytes = -1;
+	row->max_memory_bytes = -1;
+	*rows = lappend(*rows, row);
+
+	return row;
+}
+
+static void
+cache_stats_add_subspace_store_row(List **rows, const char *cache_name, Oid hypertable_relid,
+								   SubspaceStoreStats *stats, int64 memory_bytes)
+{
+	CacheStatsRow *row = cache_stats_add_row(rows, cache_name, hypertable_relid);
+
+	row->num_entries = stats->num_items;
+	row->max_entries = stats->max_items;
+	row->hits = stats->hits;
+	row->misses = stats->misses;
+	row->evictions = stats->evictions;
+	row->memory_bytes = memory_bytes;
+}
+
+/*
+ * Collect the statistics of this backend's caches. There is one row for the
+ * hypertable cache, one for each cached hypertable's chunk cache, and one for
+ * the chunk insert state caches of all finished inserts.
+ */
+static List *
+cache_stats_collect(void)
+{
+	Cache	   *cache = hypertable_cache_current;
+	CacheStatsRow *row;
+	HASH_SEQ_STATUS status;
+	HypertableNameCacheEntry *entry;
+	SubspaceStoreStats stats;
+	List	   *rows = NIL;
+
+	row = cache_stats_add_row(&rows, "hypertable_cache", InvalidOid);
+	row->num_entries = cache->stats.numelements;
+	row->max_entries = 0;
+	row->hits = cache->stats.hits;
+	row->misses = cache->stats.misses;
+	row->evictions = cache->stats.evictions;
+	row->memory_bytes = memory_context_total_space(cache_memory_ctx(cache));
+
+	if (hypertable_cache_memory_limit() > 0)
+		row->max_memory_bytes = hypertable_cache_memory_limit();
+
+	hash_seq_init(&status, cache->htab);
+
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		if (NULL == entry->hypertable)
+			continue;
+
+		subspace_store_get_stats(entry->hypertable->chunk_cache, &stats);
+		cache_stats_add_subspace_store_row(&rows, "chunk_cache",
+										   entry->hypertable->main_table_relid,
+										   &stats,
+										   memory_context_total_space(entry->mcxt));
+	}
+
+	chunk_dispatch_get_stats(&stats);
+	cache_stats_add_subspace_store_row(&rows, "chunk_dispatch", InvalidOid, &stats, -1);
+
+	return rows;
+}
+
+static HeapTuple
+cache_stats_row_to_tuple(CacheStatsRow *row, TupleDesc tupdesc)
+{
+	Datum		values[Natts_cache_stats];
+	bool		nulls[Natts_cache_stats] = {false};
+
+	values[Anum_cache_stats_cache_name - 1] = CStringGetTextDatum(row->cache_name);
+	values[Anum_cache_stats_hypertable - 1] = ObjectIdGetDatum(row->hypertable_relid);
+	nulls[Anum_cache_stats_hypertable - 1] = !OidIsValid(row->hypertable_relid);
+	values[Anum_cache_stats_num_entries - 1] = Int64GetDatum(row->num_entries);
+	values[Anum_cache_stats_max_entries - 1] = Int32GetDatum(row->max_entries);
+	nulls[Anum_cache_stats_max_entries - 1] = row->max_entries < 0;
+	values[Anum_cache_stats_hits - 1] = Int64GetDatum((int64) row->hits);
+	values[Anum_cache_stats_misses - 1] = Int64GetDatum((int64) row->misses);
+	values[Anum_cache_stats_evictions - 1] = Int64GetDatum((int64) row->evictions);
+	values[Anum_cache_stats_memory_bytes - 1] = Int64GetDatum(row->memory_bytes);
+	nulls[Anum_cache_stats_memory_bytes - 1] = row->memory_bytes < 0;
+	values[Anum_cache_stats_max_memory_bytes - 1] = Int64GetDatum(row->max_memory_bytes);
+	nulls[Anum_cache_stats_max_memory_bytes - 1] = row->max_memory_bytes < 0;
+
+	return heap_form_tuple(tupdesc, values, nulls);
+}
+
+TS_FUNCTION_INFO_V1(cache_stats);
+
+/*
+ * Show the statistics of this backend's metadata caches.
+ *
+ * The statistics are those of the current backend only. Hypertable cache
+ * statistics restart when the whole cache is invalidated.
+ */
+Datum
+cache_stats(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	List	   *rows;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			elog(ERROR, "Function returning record called in context that cannot accept type record");
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+		funcctx->user_fctx = cache_stats_collect();
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	rows = funcctx->user_fctx;
+
+	if (funcctx->call_cntr < (uint64) list_length(rows))
+	{
+		CacheStatsRow *row = list_nth(rows, funcctx->call_cntr);
+		HeapTuple	tuple = cache_stats_row_to_tuple(row, funcctx->tuple_desc);
+
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
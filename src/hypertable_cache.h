@@ -10,7 +10,10 @@ extern Hypertable *hypertable_cache_get_entry_rv(Cache *cache, RangeVar *rv);
 extern Hypertable *hypertable_cache_get_entry_with_table(Cache *cache, Oid relid, const char *schema, const char *table);
 extern Hypertable *hypertable_cache_get_entry_by_id(Cache *cache, int32 hypertable_id);
 
+extern bool hypertable_cache_relid_is_relevant(Oid relid);
 extern void hypertable_cache_invalidate_callback(void);
+extern void hypertable_cache_invalidate_entry(Oid relid);
+extern void hypertable_cache_update_memory(Hypertable *ht);
 
 extern Cache *hypertable_cache_pin(void);
 
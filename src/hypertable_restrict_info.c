@@ -0,0 +1,862 @@
+#include <postgres.h>
+#include <access/stratnum.h>
+#include <access/xact.h>
+#include <catalog/pg_type.h>
+#include <nodes/relation.h>
+#include <optimizer/clauses.h>
+#include <utils/array.h>
+#include <utils/date.h>
+#include <utils/fmgroids.h>
+#include <utils/lsyscache.h>
+#include <utils/timestamp.h>
+#include <utils/typcache.h>
+
+#include "hypertable_restrict_info.h"
+#include "dimension.h"
+#include "dimension_slice.h"
+#include "chunk.h"
+#include "partitioning.h"
+#include "utils.h"
+#include "compat.h"
+
+/*
+ * Restrictions on the dimensions of a hypertable. They are used to exclude
+ * chunks by comparing the restricted ranges with the chunks' dimension
+ * slices, both when expanding a hypertable at plan time and in
+ * ConstraintAwareAppend at execution time.
+ */
+
+/*
+ * The range of coordinates in a dimension that matching tuples can have. Both
+ * bounds are inclusive. An IN list, i.e., "column = ANY (array)", further
+ * restricts the coordinates to a set of values, which is NULL when there is
+ * no such restriction.
+ */
+typedef struct DimensionRestrictInfo
+{
+	Dimension  *dimension;
+	AttrNumber	attno;
+	int64		lower_bound;
+	int64		upper_bound;
+	int			num_values;
+	int64	   *values;
+} DimensionRestrictInfo;
+
+struct HypertableRestrictInfo
+{
+	Index		relid;
+	int			num_dimensions;
+	DimensionRestrictInfo dimensions[FLEXIBLE_ARRAY_MEMBER];
+};
+
+HypertableRestrictInfo *
+hypertable_restrict_info_create(Hypertable *ht, Index relid)
+{
+	Hyperspace *hs = ht->space;
+	HypertableRestrictInfo *hri;
+	int			i;
+
+	hri = palloc(sizeof(HypertableRestrictInfo) +
+				 sizeof(DimensionRestrictInfo) * hs->num_dimensions);
+	hri->relid = relid;
+	hri->num_dimensions = hs->num_dimensions;
+
+	for (i = 0; i < hs->num_dimensions; i++)
+	{
+		hri->dimensions[i].dimension = &hs->dimensions[i];
+		hri->dimensions[i].attno = hs->dimensions[i].column_attno;
+		hri->dimensions[i].lower_bound = DIMENSION_SLICE_MINVALUE;
+		hri->dimensions[i].upper_bound = DIMENSION_SLICE_MAXVALUE;
+		hri->dimensions[i].num_values = 0;
+		hri->dimensions[i].values = NULL;
+	}
+
+	return hri;
+}
+
+/*
+ * Create the restrictions for an inheritance child of the hypertable, e.g., a
+ * chunk that is planned as the result relation of an UPDATE or DELETE. The
+ * child's quals refer to the chunk's columns, whose attribute numbers can
+ * differ from the hypertable's after columns have been dropped.
+ */
+HypertableRestrictInfo *
+hypertable_restrict_info_create_for_child(Hypertable *ht, AppendRelInfo *appinfo)
+{
+	HypertableRestrictInfo *hri = hypertable_restrict_info_create(ht, appinfo->child_relid);
+	int			i;
+
+	for (i = 0; i < hri->num_dimensions; i++)
+	{
+		Var		   *var = list_nth(appinfo->translated_vars, hri->dimensions[i].attno - 1);
+
+		Assert(NULL != var && IsA(var, Var));
+		hri->dimensions[i].attno = var->varattno;
+	}
+
+	return hri;
+}
+
+static DimensionRestrictInfo *
+hypertable_restrict_info_get(HypertableRestrictInfo *hri, AttrNumber attno)
+{
+	int			i;
+
+	for (i = 0; i < hri->num_dimensions; i++)
+		if (hri->dimensions[i].attno == attno)
+			return &hri->dimensions[i];
+
+	return NULL;
+}
+
+static inline bool
+is_integer_type(Oid type)
+{
+	return type == INT2OID || type == INT4OID || type == INT8OID;
+}
+
+/*
+ * Convert a constant to the internal time of an open dimension.
+ *
+ * Only constants of the column's own type are converted, since the
+ * conversion between other time types depends on the session time zone. The
+ * integer types can be mixed, as is common for integer time columns compared
+ * with int4 literals. Infinite values have no internal time.
+ */
+static bool
+open_dimension_coordinate(Dimension *dim, Datum value, Oid type, int64 *coordinate)
+{
+	Oid			coltype = dim->fd.column_type;
+
+	if (type != coltype &&
+		!(is_integer_type(type) && is_integer_type(coltype)))
+		return false;
+
+	switch (type)
+	{
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			if (TIMESTAMP_NOT_FINITE(DatumGetTimestamp(value)))
+				return false;
+			break;
+		case DATEOID:
+			if (DATE_NOT_FINITE(DatumGetDateADT(value)))
+				return false;
+			break;
+		default:
+			break;
+	}
+
+	*coordinate = time_value_to_internal(value, type);
+
+	return true;
+}
+
+/*
+ * Convert a constant to the coordinate of a tuple with that value in the
+ * dimension. For a closed dimension, this is the value of the partitioning
+ * function, which only preserves equality and is only defined for values of
+ * the column's type.
+ */
+static bool
+dimension_coordinate(Dimension *dim, StrategyNumber strategy, Datum value, Oid type, int64 *coordinate)
+{
+	if (IS_CLOSED_DIMENSION(dim))
+	{
+		if (strategy != BTEqualStrategyNumber ||
+			type != dim->fd.column_type ||
+			NULL == dim->partitioning)
+			return false;
+
+		*coordinate = partitioning_func_apply(dim->partitioning, value);
+		return true;
+	}
+
+	return open_dimension_coordinate(dim, value, type, coordinate);
+}
+
+static void
+dimension_restrict_info_add(DimensionRestrictInfo *dri, StrategyNumber strategy, int64 coordinate)
+{
+	switch (strategy)
+	{
+		case BTLessStrategyNumber:
+			if (coordinate == DIMENSION_SLICE_MINVALUE)
+			{
+				/* Nothing is less than the minimum value */
+				dri->upper_bound = DIMENSION_SLICE_MINVALUE;
+				dri->lower_bound = DIMENSION_SLICE_MAXVALUE;
+			}
+			else if (coordinate - 1 < dri->upper_bound)
+				dri->upper_bound = coordinate - 1;
+			break;
+		case BTLessEqualStrategyNumber:
+			if (coordinate < dri->upper_bound)
+				dri->upper_bound = coordinate;
+			break;
+		case BTEqualStrategyNumber:
+			if (coordinate > dri->lower_bound)
+				dri->lower_bound = coordinate;
+			if (coordinate < dri->upper_bound)
+				dri->upper_bound = coordinate;
+			break;
+		case BTGreaterEqualStrategyNumber:
+			if (coordinate > dri->lower_bound)
+				dri->lower_bound = coordinate;
+			break;
+		case BTGreaterStrategyNumber:
+			if (coordinate == DIMENSION_SLICE_MAXVALUE)
+			{
+				/* Nothing is greater than the maximum value */
+				dri->upper_bound = DIMENSION_SLICE_MINVALUE;
+				dri->lower_bound = DIMENSION_SLICE_MAXVALUE;
+			}
+			else if (coordinate + 1 > dri->lower_bound)
+				dri->lower_bound = coordinate + 1;
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+ * Add a restriction of the form "time_bucket(width, column) op constant" on an
+ * open dimension. A value is always less than the width away from its bucket.
+ * Timestamps and dates are bucketed downwards, so their buckets are never
+ * greater than the values, while integers are truncated toward zero, so
+ * negative values are bucketed upwards.
+ */
+static void
+dimension_restrict_info_add_bucket(DimensionRestrictInfo *dri, StrategyNumber strategy,
+								   int64 coordinate, int64 width)
+{
+	bool		bucketed_down = !is_integer_type(dri->dimension->fd.column_type);
+
+	switch (strategy)
+	{
+		case BTGreaterStrategyNumber:
+		case BTGreaterEqualStrategyNumber:
+		case BTEqualStrategyNumber:
+			if (bucketed_down)
+				dimension_restrict_info_add(dri,
+											strategy == BTGreaterStrategyNumber ?
+											BTGreaterStrategyNumber : BTGreaterEqualStrategyNumber,
+											coordinate);
+			else if (coordinate > PG_INT64_MIN + width)
+				dimension_restrict_info_add(dri, BTGreaterStrategyNumber, coordinate - width);
+
+			if (strategy != BTEqualStrategyNumber)
+				break;
+			/* FALLTHROUGH */
+		case BTLessStrategyNumber:
+		case BTLessEqualStrategyNumber:
+			if (coordinate < PG_INT64_MAX - width)
+				dimension_restrict_info_add(dri, BTLessStrategyNumber, coordinate + width);
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+ * Restrict a dimension to a set of values. If the dimension is already
+ * restricted to a set, only the values in both sets remain.
+ */
+static void
+dimension_restrict_info_add_values(DimensionRestrictInfo *dri, int64 *values, int num_values)
+{
+	int			i,
+				j,
+				n = 0;
+
+	if (NULL == dri->values)
+	{
+		dri->values = values;
+		dri->num_values = num_values;
+		return;
+	}
+
+	for (i = 0; i < dri->num_values; i++)
+		for (j = 0; j < num_values; j++)
+			if (dri->values[i] == values[j])
+			{
+				dri->values[n++] = dri->values[i];
+				break;
+			}
+
+	dri->num_values = n;
+}
+
+static StrategyNumber
+strategy_commute(StrategyNumber strategy)
+{
+	switch (strategy)
+	{
+		case BTLessStrategyNumber:
+			return BTGreaterStrategyNumber;
+		case BTLessEqualStrategyNumber:
+			return BTGreaterEqualStrategyNumber;
+		case BTGreaterEqualStrategyNumber:
+			return BTLessEqualStrategyNumber;
+		case BTGreaterStrategyNumber:
+			return BTLessStrategyNumber;
+		default:
+			return strategy;
+	}
+}
+
+/*
+ * Get a lower bound for the value of an expression that is the transaction
+ * time, i.e., now() or CURRENT_TIMESTAMP, with any number of constant
+ * intervals added or subtracted. Such expressions are stable, so the planner
+ * does not fold them into constants.
+ *
+ * Adding days or months depends on the session time zone, which can be
+ * different when a plan is reused. Time zone offsets, and the clamping of
+ * month arithmetic to the end of the month, shift the result by less than
+ * three days, so the bound is lowered by that much.
+ */
+static bool
+transaction_time_lower_bound(Node *expr, TimestampTz *value)
+{
+	if (IsA(expr, FuncExpr) && ((FuncExpr *) expr)->funcid == F_NOW)
+	{
+		*value = GetCurrentTransactionStartTimestamp();
+		return true;
+	}
+
+#if PG10
+	if (IsA(expr, SQLValueFunction) &&
+		((SQLValueFunction *) expr)->op == SVFOP_CURRENT_TIMESTAMP)
+	{
+		*value = GetCurrentTransactionStartTimestamp();
+		return true;
+	}
+#endif
+
+	if (IsA(expr, OpExpr) && list_length(((OpExpr *) expr)->args) == 2)
+	{
+		OpExpr	   *op = (OpExpr *) expr;
+		Const	   *interval = lsecond(op->args);
+		Oid			opcode = get_opcode(op->opno);
+		Interval   *span;
+		TimestampTz base;
+
+		if ((opcode != F_TIMESTAMPTZ_PL_INTERVAL && opcode != F_TIMESTAMPTZ_MI_INTERVAL) ||
+			!IsA(interval, Const) ||
+			interval->constisnull ||
+			!transaction_time_lower_bound(linitial(op->args), &base))
+			return false;
+
+		span = DatumGetIntervalP(interval->constvalue);
+		*value = DatumGetTimestampTz(OidFunctionCall2(opcode,
+													  TimestampTzGetDatum(base),
+													  interval->constvalue));
+
+		if (span->month != 0 || span->day != 0)
+			*value -= 3 * USECS_PER_DAY;
+
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * Get the column of an operand of a restriction. Besides a plain column, this
+ * can be a time_bucket() with a constant width on the column, whose width is
+ * returned in bucket_width. Otherwise, bucket_width is set to zero.
+ */
+static Var *
+restriction_operand_get_var(Node *node, int64 *bucket_width)
+{
+	*bucket_width = 0;
+
+	if (IsA(node, Var))
+		return (Var *) node;
+
+	return time_bucket_get_var(node, bucket_width);
+}
+
+/*
+ * Add a restriction of the form "column op constant", or "constant op
+ * column", on a dimension column. Other clauses are ignored, which is always
+ * safe since ignoring a clause can only keep more chunks.
+ *
+ * The column can also be bucketed by time_bucket(), as in the queries of
+ * continuous aggregates and other rollups, e.g., "time_bucket('5 min', time)
+ * >= '2017-01-01'". The bucket's restriction is widened into a restriction on
+ * the column itself.
+ *
+ * A lower bound can also be relative to the transaction time, e.g., "time >
+ * now() - interval '1 hour'". The transaction time only increases, so in a
+ * later transaction the bound can only exclude more chunks, and excluding
+ * on it is also safe for a plan that is reused. Upper bounds relative to the
+ * transaction time are left to ConstraintAwareAppend at execution time.
+ */
+static bool
+hypertable_restrict_info_add_opexpr(HypertableRestrictInfo *hri, OpExpr *op)
+{
+	Node	   *left = linitial(op->args);
+	Node	   *right = lsecond(op->args);
+	DimensionRestrictInfo *dri;
+	Dimension  *dim;
+	TypeCacheEntry *tce;
+	StrategyNumber strategy;
+	bool		commuted = false;
+	bool		transaction_time = false;
+	Var		   *var;
+	Node	   *other;
+	Datum		value;
+	Oid			type;
+	int64		coordinate;
+	int64		bucket_width;
+
+	var = restriction_operand_get_var(left, &bucket_width);
+
+	if (NULL != var)
+		other = right;
+	else
+	{
+		var = restriction_operand_get_var(right, &bucket_width);
+
+		if (NULL == var)
+			return false;
+
+		other = left;
+		commuted = true;
+	}
+
+	if (var->varno != hri->relid || var->varlevelsup != 0)
+		return false;
+
+	if (IsA(other, Const))
+	{
+		if (((Const *) other)->constisnull)
+			return false;
+
+		value = ((Const *) other)->constvalue;
+		type = ((Const *) other)->consttype;
+	}
+	else
+	{
+		TimestampTz ts;
+
+		if (!transaction_time_lower_bound(other, &ts))
+			return false;
+
+		value = TimestampTzGetDatum(ts);
+		type = TIMESTAMPTZOID;
+		transaction_time = true;
+	}
+
+	dri = hypertable_restrict_info_get(hri, var->varattno);
+
+	if (NULL == dri)
+		return false;
+
+	dim = dri->dimension;
+	tce = lookup_type_cache(dim->fd.column_type, TYPECACHE_BTREE_OPFAMILY);
+
+	if (!OidIsValid(tce->btree_opf))
+		return false;
+
+	strategy = get_op_opfamily_strategy(op->opno, tce->btree_opf);
+
+	if (strategy == InvalidStrategy)
+		return false;
+
+	if (commuted)
+		strategy = strategy_commute(strategy);
+
+	if (transaction_time &&
+		strategy != BTGreaterStrategyNumber &&
+		strategy != BTGreaterEqualStrategyNumber)
+		return false;
+
+	if (bucket_width > 0 && IS_CLOSED_DIMENSION(dim))
+		return false;
+
+	if (!dimension_coordinate(dim, strategy, value, type, &coordinate))
+		return false;
+
+	if (bucket_width > 0)
+		dimension_restrict_info_add_bucket(dri, strategy, coordinate, bucket_width);
+	else
+		dimension_restrict_info_add(dri, strategy, coordinate);
+
+	return true;
+}
+
+/*
+ * Add a restriction of the form "column = ANY (array)", which is what an IN
+ * list on a dimension column becomes. The coordinates of the array elements
+ * restrict the dimension to a set of values. For a closed dimension, this
+ * means the chunks of the partitions that the values hash to.
+ */
+static bool
+hypertable_restrict_info_add_scalar_array_opexpr(HypertableRestrictInfo *hri, ScalarArrayOpExpr *saop)
+{
+	Node	   *left = linitial(saop->args);
+	Node	   *right = lsecond(saop->args);
+	DimensionRestrictInfo *dri;
+	Dimension  *dim;
+	TypeCacheEntry *tce;
+	Var		   *var;
+	Const	   *c;
+	ArrayType  *arr;
+	Oid			elemtype;
+	int16		elemlen;
+	bool		elembyval;
+	char		elemalign;
+	Datum	   *elems;
+	bool	   *nulls;
+	int			num_elems;
+	int64	   *values;
+	int			num_values = 0;
+	int			i;
+
+	if (!saop->useOr || !IsA(left, Var) || !IsA(right, Const))
+		return false;
+
+	var = (Var *) left;
+	c = (Const *) right;
+
+	if (var->varno != hri->relid || var->varlevelsup != 0 || c->constisnull)
+		return false;
+
+	dri = hypertable_restrict_info_get(hri, var->varattno);
+
+	if (NULL == dri)
+		return false;
+
+	dim = dri->dimension;
+	tce = lookup_type_cache(dim->fd.column_type, TYPECACHE_BTREE_OPFAMILY);
+
+	if (!OidIsValid(tce->btree_opf) ||
+		get_op_opfamily_strategy(saop->opno, tce->btree_opf) != BTEqualStrategyNumber)
+		return false;
+
+	arr = DatumGetArrayTypeP(c->constvalue);
+	elemtype = ARR_ELEMTYPE(arr);
+	get_typlenbyvalalign(elemtype, &elemlen, &elembyval, &elemalign);
+	deconstruct_array(arr, elemtype, elemlen, elembyval, elemalign,
+					  &elems, &nulls, &num_elems);
+
+	values = palloc(sizeof(int64) * (num_elems + 1));
+
+	for (i = 0; i < num_elems; i++)
+	{
+		/* A NULL element never equals the column */
+		if (nulls[i])
+			continue;
+
+		if (!dimension_coordinate(dim, BTEqualStrategyNumber, elems[i], elemtype,
+								  &values[num_values]))
+			return false;
+
+		num_values++;
+	}
+
+	dimension_restrict_info_add_values(dri, values, num_values);
+
+	return true;
+}
+
+/*
+ * Add the restrictions of a qual, which can be a list or AND of clauses.
+ * Returns true only if all of its clauses were used, i.e., the restrictions
+ * capture the qual completely.
+ */
+bool
+hypertable_restrict_info_add_qual(HypertableRestrictInfo *hri, Node *qual)
+{
+	ListCell   *lc;
+	bool		used = true;
+
+	if (NULL == qual)
+		return true;
+
+	if (IsA(qual, List))
+	{
+		foreach(lc, (List *) qual)
+			used = hypertable_restrict_info_add_qual(hri, lfirst(lc)) && used;
+	}
+	else if (and_clause(qual))
+	{
+		foreach(lc, ((BoolExpr *) qual)->args)
+			used = hypertable_restrict_info_add_qual(hri, lfirst(lc)) && used;
+	}
+	else if (IsA(qual, RestrictInfo))
+		used = hypertable_restrict_info_add_qual(hri, (Node *) ((RestrictInfo *) qual)->clause);
+	else if (IsA(qual, OpExpr) && list_length(((OpExpr *) qual)->args) == 2)
+		used = hypertable_restrict_info_add_opexpr(hri, (OpExpr *) qual);
+	else if (IsA(qual, ScalarArrayOpExpr))
+		used = hypertable_restrict_info_add_scalar_array_opexpr(hri, (ScalarArrayOpExpr *) qual);
+	else
+		used = false;
+
+	return used;
+}
+
+/*
+ * Collect restrictions from the join tree.
+ *
+ * The relation's baserestrictinfo is not yet built when the RelOptInfo is
+ * created, so we read the preprocessed quals of the join tree instead. Only
+ * WHERE clauses and the quals of inner joins are used: a tuple that fails
+ * them cannot be part of the result. The quals of outer joins are skipped,
+ * since they do not remove tuples from the outer side.
+ */
+void
+hypertable_restrict_info_add_jointree(HypertableRestrictInfo *hri, Node *jtnode)
+{
+	ListCell   *lc;
+
+	if (NULL == jtnode)
+		return;
+
+	if (IsA(jtnode, FromExpr))
+	{
+		FromExpr   *f = (FromExpr *) jtnode;
+
+		hypertable_restrict_info_add_qual(hri, f->quals);
+
+		foreach(lc, f->fromlist)
+			hypertable_restrict_info_add_jointree(hri, lfirst(lc));
+	}
+	else if (IsA(jtnode, JoinExpr))
+	{
+		JoinExpr   *j = (JoinExpr *) jtnode;
+
+		if (j->jointype == JOIN_INNER)
+			hypertable_restrict_info_add_qual(hri, j->quals);
+
+		hypertable_restrict_info_add_jointree(hri, j->larg);
+		hypertable_restrict_info_add_jointree(hri, j->rarg);
+	}
+}
+
+/*
+ * Check if a restricted set of values has a value within the restricted range
+ * and, if there is a slice, within the slice.
+ */
+static bool
+dimension_restrict_info_values_match(DimensionRestrictInfo *dri, DimensionSlice *slice)
+{
+	int			i;
+
+	for (i = 0; i < dri->num_values; i++)
+	{
+		int64		value = dri->values[i];
+
+		if (value < dri->lower_bound || value > dri->upper_bound)
+			continue;
+
+		if (NULL == slice ||
+			(value >= slice->fd.range_start && value < slice->fd.range_end))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Check if a chunk, given by its hypercube, can hold tuples that match the
+ * restrictions. Dimension slices are half-open ranges, while the restricted
+ * ranges are closed.
+ */
+bool
+hypertable_restrict_info_matches_cube(HypertableRestrictInfo *hri, Hypercube *cube)
+{
+	int			i;
+
+	for (i = 0; i < hri->num_dimensions; i++)
+	{
+		DimensionRestrictInfo *dri = &hri->dimensions[i];
+		DimensionSlice *slice;
+
+		if (dri->lower_bound > dri->upper_bound)
+			return false;
+
+		slice = hypercube_get_slice_by_dimension_id(cube, dri->dimension->fd.id);
+
+		if (NULL != dri->values && !dimension_restrict_info_values_match(dri, slice))
+			return false;
+
+		if (NULL == slice)
+			continue;
+
+		if (slice->fd.range_start > dri->upper_bound ||
+			slice->fd.range_end <= dri->lower_bound)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Check if the rows of a chunk, given by the actual range of time they have,
+ * can match the restrictions on the time dimension. Both bounds of the range
+ * are inclusive, and an empty range has min_value > max_value.
+ */
+bool
+hypertable_restrict_info_matches_time_range(HypertableRestrictInfo *hri, int64 min_value,
+											int64 max_value)
+{
+	DimensionRestrictInfo *dri = NULL;
+	int			i;
+
+	if (min_value > max_value)
+		return false;
+
+	for (i = 0; i < hri->num_dimensions; i++)
+	{
+		if (IS_OPEN_DIMENSION(hri->dimensions[i].dimension))
+		{
+			dri = &hri->dimensions[i];
+			break;
+		}
+	}
+
+	if (NULL == dri)
+		return true;
+
+	if (NULL != dri->values)
+	{
+		for (i = 0; i < dri->num_values; i++)
+		{
+			int64		value = dri->values[i];
+
+			if (value >= Max(min_value, dri->lower_bound) &&
+				value <= Min(max_value, dri->upper_bound))
+				return true;
+		}
+
+		return false;
+	}
+
+	return min_value <= dri->upper_bound && max_value >= dri->lower_bound;
+}
+
+/*
+ * Estimate the fraction of a dimension slice that the restrictions on the
+ * slice's dimension cover, assuming that the tuples' coordinates are spread
+ * evenly over the slice. Returns 1.0 if the dimension is not restricted.
+ */
+double
+hypertable_restrict_info_slice_fraction(HypertableRestrictInfo *hri, DimensionSlice *slice)
+{
+	DimensionRestrictInfo *dri = NULL;
+	double		width = (double) slice->fd.range_end - (double) slice->fd.range_start;
+	double		lower;
+	double		upper;
+	int			i;
+
+	for (i = 0; i < hri->num_dimensions; i++)
+		if (hri->dimensions[i].dimension->fd.id == slice->fd.dimension_id)
+			dri = &hri->dimensions[i];
+
+	if (NULL == dri || width <= 0)
+		return 1.0;
+
+	if (dri->lower_bound > dri->upper_bound)
+		return 0.0;
+
+	/* Each value of an IN list covers a single coordinate */
+	if (NULL != dri->values)
+	{
+		int			num_values = 0;
+
+		for (i = 0; i < dri->num_values; i++)
+			if (dri->values[i] >= Max(dri->lower_bound, slice->fd.range_start) &&
+				dri->values[i] <= dri->upper_bound &&
+				dri->values[i] < slice->fd.range_end)
+				num_values++;
+
+		return Min(num_values / width, 1.0);
+	}
+
+	/* Slices are half-open ranges, while the restricted range is closed */
+	lower = Max((double) dri->lower_bound, (double) slice->fd.range_start);
+	upper = Min((double) dri->upper_bound + 1, (double) slice->fd.range_end);
+
+	if (upper <= lower)
+		return 0.0;
+
+	return (upper - lower) / width;
+}
+
+/*
+ * Get the chunks that can hold tuples matching the restrictions.
+ *
+ * The chunks are resolved from the catalog alone, so their tables are neither
+ * opened nor locked. If any dimension is restricted, only the dimension slices
+ * in the restricted ranges, and the chunks that have them, are read.
+ * Otherwise, all chunks of the hypertable are read in a single batch.
+ *
+ * Returns the matching chunks ordered by table OID.
+ */
+List *
+hypertable_restrict_info_get_chunks(HypertableRestrictInfo *hri, Hypertable *ht)
+{
+	DimensionSlice **slices = palloc(sizeof(DimensionSlice *) * hri->num_dimensions);
+	int			num_slices = 0;
+	List	   *chunks;
+	List	   *matching = NIL;
+	ListCell   *lc;
+	int			i;
+
+	for (i = 0; i < hri->num_dimensions; i++)
+	{
+		DimensionRestrictInfo *dri = &hri->dimensions[i];
+		int64		lower = dri->lower_bound;
+		int64		upper = dri->upper_bound;
+
+		/* Narrow the range to the values of an IN list */
+		if (NULL != dri->values)
+		{
+			int64		min = DIMENSION_SLICE_MAXVALUE;
+			int64		max = DIMENSION_SLICE_MINVALUE;
+			int			j;
+
+			for (j = 0; j < dri->num_values; j++)
+			{
+				if (dri->values[j] < lower || dri->values[j] > upper)
+					continue;
+
+				min = Min(min, dri->values[j]);
+				max = Max(max, dri->values[j]);
+			}
+
+			lower = min;
+			upper = max;
+		}
+
+		/* Contradicting restrictions match no chunks */
+		if (lower > upper)
+			return NIL;
+
+		if (lower == DIMENSION_SLICE_MINVALUE && upper == DIMENSION_SLICE_MAXVALUE)
+			continue;
+
+		/* Slices are half-open ranges, while the restricted range is closed */
+		slices[num_slices++] = dimension_slice_create(dri->dimension->fd.id, lower,
+													  upper == DIMENSION_SLICE_MAXVALUE ? upper : upper + 1);
+	}
+
+	if (num_slices == 0)
+		chunks = chunk_get_all_by_hypertable_id(ht->fd.id, ht->space->num_dimensions);
+	else
+		chunks = chunk_find_all_colliding(ht->space, slices, num_slices);
+
+	foreach(lc, chunks)
+	{
+		Chunk	   *chunk = lfirst(lc);
+
+		if (hypertable_restrict_info_matches_cube(hri, chunk->cube))
+			matching = lappend(matching, chunk);
+	}
+
+	return matching;
+}
@@ -0,0 +1,28 @@
+#ifndef TIMESCALEDB_HYPERTABLE_RESTRICT_INFO_H
+#define TIMESCALEDB_HYPERTABLE_RESTRICT_INFO_H
+
+#include <postgres.h>
+#include <nodes/primnodes.h>
+#include <nodes/relation.h>
+
+#include "hypertable.h"
+#include "hypercube.h"
+
+/*
+ * The restrictions of a query on the dimensions of a hypertable, collected
+ * from the quals that compare a dimension column with a constant or, like IN
+ * lists, with an array of constants.
+ */
+typedef struct HypertableRestrictInfo HypertableRestrictInfo;
+
+extern HypertableRestrictInfo *hypertable_restrict_info_create(Hypertable *ht, Index relid);
+extern HypertableRestrictInfo *hypertable_restrict_info_create_for_child(Hypertable *ht, AppendRelInfo *appinfo);
+extern bool hypertable_restrict_info_add_qual(HypertableRestrictInfo *hri, Node *qual);
+extern void hypertable_restrict_info_add_jointree(HypertableRestrictInfo *hri, Node *jtnode);
+extern bool hypertable_restrict_info_matches_cube(HypertableRestrictInfo *hri, Hypercube *cube);
+extern bool hypertable_restrict_info_matches_time_range(HypertableRestrictInfo *hri, int64 min_value,
+											int64 max_value);
+extern double hypertable_restrict_info_slice_fraction(HypertableRestrictInfo *hri, DimensionSlice *slice);
+extern List *hypertable_restrict_info_get_chunks(HypertableRestrictInfo *hri, Hypertable *ht);
+
+#endif							/* TIMESCALEDB_HYPERTABLE_RESTRICT_INFO_H */
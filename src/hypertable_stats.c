@@ -0,0 +1,331 @@
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <fmgr.h>
+#include <funcapi.h>
+#include <miscadmin.h>
+#include <utils/builtins.h>
+#include <utils/hsearch.h>
+#include <utils/memutils.h>
+#include <utils/syscache.h>
+
+#include "hypertable_stats.h"
+#include "compat.h"
+
+/*
+ * Cumulative ingest and chunk-lifecycle statistics per hypertable, shown by
+ * the timescaledb_information.hypertable_stats view.
+ *
+ * Unlike cache_stats(), which shows the current backend only, these
+ * statistics are kept in shared memory and summed over all backends. Each
+ * hypertable gets an entry on first use. The entries are searched under an
+ * exclusive lock, but each backend remembers the entries of the hypertables
+ * it has used, so that updating a counter is a single atomic add. Entries are
+ * freed by hypertable_stats_reset(), which bumps the generation to make the
+ * backends forget their remembered entries, and, when all entries are taken,
+ * if their database has been dropped.
+ *
+ * The statistics are only available when the loader is preloaded, since that
+ * is the only way to get shared memory. Otherwise, nothing is counted.
+ */
+
+typedef struct HypertableStatsLocalEntry
+{
+	int32		hypertable_id;
+	HypertableStatsEntry *entry;
+} HypertableStatsLocalEntry;
+
+static HypertableStatsShared *stats_shared = NULL;
+static bool stats_attached = false;
+static HTAB *stats_local = NULL;
+static uint32 stats_local_generation = 0;
+
+static HypertableStatsShared *
+stats_shared_get(void)
+{
+	HypertableStatsShared *shared;
+
+	if (stats_attached)
+		return stats_shared;
+
+	shared = *find_rendezvous_variable(HYPERTABLE_STATS_RENDEZVOUS);
+
+	/* Ignore the statistics of a loader with a different layout */
+	if (NULL != shared && shared->layout_version == HYPERTABLE_STATS_LAYOUT_VERSION)
+		stats_shared = shared;
+
+	stats_attached = true;
+
+	return stats_shared;
+}
+
+static void
+stats_local_reset(uint32 generation)
+{
+	HASHCTL		ctl = {
+		.keysize = sizeof(int32),
+		.entrysize = sizeof(HypertableStatsLocalEntry),
+		.hcxt = TopMemoryContext,
+	};
+
+	if (NULL != stats_local)
+		hash_destroy(stats_local);
+
+	stats_local = hash_create("Hypertable stats entries", 32, &ctl,
+							  HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	stats_local_generation = generation;
+}
+
+/*
+ * Find or assign the shared entry of a hypertable in the current
+ * database. Returns NULL if all entries are taken.
+ */
+static HypertableStatsEntry *
+stats_entry_assign(HypertableStatsShared *shared, int32 hypertable_id)
+{
+	HypertableStatsEntry *entry = NULL;
+	int			i,
+				j;
+
+	LWLockAcquire(shared->lock, LW_EXCLUSIVE);
+
+	for (i = 0; i < shared->num_entries; i++)
+	{
+		HypertableStatsEntry *cur = &shared->entries[i];
+
+		if (cur->dboid == MyDatabaseId && cur->hypertable_id == hypertable_id)
+		{
+			entry = cur;
+			break;
+		}
+
+		if (NULL == entry && !OidIsValid(cur->dboid))
+			entry = cur;
+	}
+
+	if (NULL != entry && !OidIsValid(entry->dboid))
+	{
+		for (j = 0; j < _HYPERTABLE_STATS_NUM_COUNTERS; j++)
+			pg_atomic_write_u64(&entry->counters[j], 0);
+
+		entry->hypertable_id = hypertable_id;
+		entry->dboid = MyDatabaseId;
+	}
+
+	LWLockRelease(shared->lock);
+
+	return entry;
+}
+
+/*
+ * Free the entries of databases that no longer exist. Returns true if any
+ * entries were freed.
+ */
+static bool
+stats_entries_free_dropped(HypertableStatsShared *shared)
+{
+	Oid		   *dropped = palloc(sizeof(Oid) * shared->num_entries);
+	int			num_dropped = 0;
+	bool		freed = false;
+	int			i,
+				j;
+
+	/* Check the catalog without holding the lock */
+	for (i = 0; i < shared->num_entries; i++)
+	{
+		Oid			dboid = shared->entries[i].dboid;
+
+		if (OidIsValid(dboid) && dboid != MyDatabaseId &&
+			!SearchSysCacheExists1(DATABASEOID, ObjectIdGetDatum(dboid)))
+			dropped[num_dropped++] = dboid;
+	}
+
+	LWLockAcquire(shared->lock, LW_EXCLUSIVE);
+
+	for (i = 0; i < shared->num_entries; i++)
+		for (j = 0; j < num_dropped; j++)
+			if (shared->entries[i].dboid == dropped[j])
+			{
+				shared->entries[i].dboid = InvalidOid;
+				freed = true;
+				break;
+			}
+
+	LWLockRelease(shared->lock);
+	pfree(dropped);
+
+	return freed;
+}
+
+static HypertableStatsEntry *
+stats_entry_get(int32 hypertable_id)
+{
+	HypertableStatsShared *shared = stats_shared_get();
+	HypertableStatsLocalEntry *local;
+	uint32		generation;
+	bool		found;
+
+	if (NULL == shared)
+		return NULL;
+
+	generation = pg_atomic_read_u32(&shared->generation);
+
+	if (NULL == stats_local || generation != stats_local_generation)
+		stats_local_reset(generation);
+
+	local = hash_search(stats_local, &hypertable_id, HASH_ENTER, &found);
+
+	/* Remember a full table too, so that it is not searched on every call */
+	if (!found)
+	{
+		local->entry = stats_entry_assign(shared, hypertable_id);
+
+		if (NULL == local->entry && stats_entries_free_dropped(shared))
+			local->entry = stats_entry_assign(shared, hypertable_id);
+	}
+
+	return local->entry;
+}
+
+void
+hypertable_stats_add(int32 hypertable_id, HypertableStatsCounter counter, uint64 value)
+{
+	HypertableStatsEntry *entry;
+
+	if (value == 0)
+		return;
+
+	entry = stats_entry_get(hypertable_id);
+
+	if (NULL != entry)
+		pg_atomic_fetch_add_u64(&entry->counters[counter], value);
+}
+
+enum Anum_hypertable_stats
+{
+	Anum_hypertable_stats_hypertable_id = 1,
+	Anum_hypertable_stats_rows_inserted,
+	Anum_hypertable_stats_rows_copied,
+	Anum_hypertable_stats_chunks_created,
+	Anum_hypertable_stats_chunk_create_time,
+	Anum_hypertable_stats_chunk_find_scans,
+	Anum_hypertable_stats_cache_evictions,
+	Anum_hypertable_stats_tuples_converted,
+	_Anum_hypertable_stats_max,
+};
+
+#define Natts_hypertable_stats \
+	(_Anum_hypertable_stats_max - 1)
+
+static HeapTuple
+hypertable_stats_entry_to_tuple(HypertableStatsEntry *entry, TupleDesc tupdesc)
+{
+	Datum		values[Natts_hypertable_stats];
+	bool		nulls[Natts_hypertable_stats] = {false};
+	uint64		counters[_HYPERTABLE_STATS_NUM_COUNTERS];
+	int			i;
+
+	for (i = 0; i < _HYPERTABLE_STATS_NUM_COUNTERS; i++)
+		counters[i] = pg_atomic_read_u64(&entry->counters[i]);
+
+	values[Anum_hypertable_stats_hypertable_id - 1] = Int32GetDatum(entry->hypertable_id);
+	values[Anum_hypertable_stats_rows_inserted - 1] =
+		Int64GetDatum((int64) counters[HYPERTABLE_STATS_ROWS_INSERTED]);
+	values[Anum_hypertable_stats_rows_copied - 1] =
+		Int64GetDatum((int64) counters[HYPERTABLE_STATS_ROWS_COPIED]);
+	values[Anum_hypertable_stats_chunks_created - 1] =
+		Int64GetDatum((int64) counters[HYPERTABLE_STATS_CHUNKS_CREATED]);
+	values[Anum_hypertable_stats_chunk_create_time - 1] =
+		Float8GetDatum(counters[HYPERTABLE_STATS_CHUNK_CREATE_TIME] / 1000.0);
+	values[Anum_hypertable_stats_chunk_find_scans - 1] =
+		Int64GetDatum((int64) counters[HYPERTABLE_STATS_CHUNK_FIND_SCANS]);
+	values[Anum_hypertable_stats_cache_evictions - 1] =
+		Int64GetDatum((int64) counters[HYPERTABLE_STATS_CACHE_EVICTIONS]);
+	values[Anum_hypertable_stats_tuples_converted - 1] =
+		Int64GetDatum((int64) counters[HYPERTABLE_STATS_TUPLES_CONVERTED]);
+
+	return heap_form_tuple(tupdesc, values, nulls);
+}
+
+TS_FUNCTION_INFO_V1(hypertable_stats);
+
+/*
+ * Show the cumulative statistics of the hypertables in the current database.
+ *
+ * Returns no rows if the statistics are not available.
+ */
+Datum
+hypertable_stats(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	HypertableStatsShared *shared = stats_shared_get();
+	int			i;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			elog(ERROR, "Function returning record called in context that cannot accept type record");
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+
+	if (NULL == shared)
+		SRF_RETURN_DONE(funcctx);
+
+	/*
+	 * The position of the next entry to check is kept in call_cntr. Entries
+	 * assigned or reset while scanning may or may not be seen, like for
+	 * PostgreSQL's own statistics.
+	 */
+	for (i = funcctx->call_cntr; i < shared->num_entries; i++)
+	{
+		HypertableStatsEntry *entry = &shared->entries[i];
+
+		if (entry->dboid == MyDatabaseId)
+		{
+			HeapTuple	tuple = hypertable_stats_entry_to_tuple(entry, funcctx->tuple_desc);
+
+			/* SRF_RETURN_NEXT increments call_cntr past this entry */
+			funcctx->call_cntr = i;
+			SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+		}
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+TS_FUNCTION_INFO_V1(hypertable_stats_reset);
+
+/*
+ * Reset the statistics of all hypertables in the current database. This also
+ * frees the entries of dropped hypertables.
+ */
+Datum
+hypertable_stats_reset(PG_FUNCTION_ARGS)
+{
+	HypertableStatsShared *shared = stats_shared_get();
+	int			i;
+
+	if (NULL == shared)
+		PG_RETURN_VOID();
+
+	LWLockAcquire(shared->lock, LW_EXCLUSIVE);
+
+	for (i = 0; i < shared->num_entries; i++)
+		if (shared->entries[i].dboid == MyDatabaseId)
+			shared->entries[i].dboid = InvalidOid;
+
+	pg_atomic_fetch_add_u32(&shared->generation, 1);
+
+	LWLockRelease(shared->lock);
+
+	PG_RETURN_VOID();
+}
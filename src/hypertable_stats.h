@@ -0,0 +1,52 @@
+#ifndef TIMESCALEDB_HYPERTABLE_STATS_H
+#define TIMESCALEDB_HYPERTABLE_STATS_H
+
+#include <postgres.h>
+#include <port/atomics.h>
+#include <storage/lwlock.h>
+
+/*
+ * Cumulative per-hypertable statistics in shared memory.
+ *
+ * The shared memory is set up by the loader, since only a preloaded library
+ * can request it, and handed to the versioned extension library through a
+ * rendezvous variable. The layout is therefore shared by all versions of the
+ * extension that the loader might load, and any change to it must bump the
+ * layout version, so that a mismatching library ignores the statistics.
+ */
+#define HYPERTABLE_STATS_SHMEM_NAME "timescaledb_hypertable_stats"
+#define HYPERTABLE_STATS_RENDEZVOUS "timescaledb_hypertable_stats"
+#define HYPERTABLE_STATS_LAYOUT_VERSION 1
+
+typedef enum HypertableStatsCounter
+{
+	HYPERTABLE_STATS_ROWS_INSERTED = 0,
+	HYPERTABLE_STATS_ROWS_COPIED,
+	HYPERTABLE_STATS_CHUNKS_CREATED,
+	HYPERTABLE_STATS_CHUNK_CREATE_TIME, /* microseconds */
+	HYPERTABLE_STATS_CHUNK_FIND_SCANS,
+	HYPERTABLE_STATS_CACHE_EVICTIONS,
+	HYPERTABLE_STATS_TUPLES_CONVERTED,
+	_HYPERTABLE_STATS_NUM_COUNTERS,
+} HypertableStatsCounter;
+
+/* An entry is free if its database is invalid */
+typedef struct HypertableStatsEntry
+{
+	Oid			dboid;
+	int32		hypertable_id;
+	pg_atomic_uint64 counters[_HYPERTABLE_STATS_NUM_COUNTERS];
+} HypertableStatsEntry;
+
+typedef struct HypertableStatsShared
+{
+	uint32		layout_version;
+	LWLock	   *lock;			/* protects the assignment of entries */
+	pg_atomic_uint32 generation;	/* bumped when entries are reset */
+	int			num_entries;
+	HypertableStatsEntry entries[FLEXIBLE_ARRAY_MEMBER];
+} HypertableStatsShared;
+
+extern void hypertable_stats_add(int32 hypertable_id, HypertableStatsCounter counter, uint64 value);
+
+#endif							/* TIMESCALEDB_HYPERTABLE_STATS_H */
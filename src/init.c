@@ -39,6 +39,9 @@ extern void _event_trigger_fini(void);
 extern void _parse_analyze_init(void);
 extern void _parse_analyze_fini(void);
 
+extern void _continuous_agg_init(void);
+extern void _continuous_agg_fini(void);
+
 extern void PGDLLEXPORT _PG_init(void);
 extern void PGDLLEXPORT _PG_fini(void);
 
@@ -59,6 +62,7 @@ _PG_init(void)
 	_event_trigger_init();
 	_process_utility_init();
 	_parse_analyze_init();
+	_continuous_agg_init();
 	_guc_init();
 }
 
@@ -70,6 +74,7 @@ _PG_fini(void)
 	 * document any exceptions.
 	 */
 	_guc_fini();
+	_continuous_agg_fini();
 	_parse_analyze_fini();
 	_process_utility_fini();
 	_event_trigger_fini();
@@ -0,0 +1,387 @@
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <access/xact.h>
+#include <catalog/pg_database.h>
+#include <miscadmin.h>
+#include <pgstat.h>
+#include <postmaster/bgworker.h>
+#include <storage/ipc.h>
+#include <storage/latch.h>
+#include <storage/lwlock.h>
+#include <storage/proc.h>
+#include <storage/shmem.h>
+#include <utils/acl.h>
+#include <utils/guc.h>
+#include <utils/memutils.h>
+#include <utils/snapmgr.h>
+
+#include "../bgw_scheduler.h"
+#include "bgw_launcher.h"
+
+#define PG96 ((PG_VERSION_NUM >= 90600) && (PG_VERSION_NUM < 100000))
+#define PG10 ((PG_VERSION_NUM >= 100000) && (PG_VERSION_NUM < 110000))
+
+/*
+ * The launcher of the job schedulers.
+ *
+ * The launcher is a background worker of the loader library that is started
+ * with the postmaster. It polls the list of databases and starts a job
+ * scheduler for each database that accepts connections. A scheduler exits
+ * right away in databases that do not have the extension, and the launcher
+ * starts it again on a later poll, so that the scheduler of a database that
+ * gets the extension, or an updated version of it, starts within a couple of
+ * polls.
+ *
+ * Schedulers register themselves in shared memory so that a backend can stop
+ * the scheduler of a database when a command needs the database to have no
+ * other connections, e.g., DROP DATABASE.
+ */
+
+#define GUC_JOB_SCHEDULER_NAME "timescaledb.job_scheduler"
+#define LAUNCHER_POLL_MS 60000
+#define LAUNCHER_RESTART_SECS 60
+#define REGISTRY_TRANCHE_NAME "timescaledb_bgw_schedulers"
+
+typedef struct SchedulerSlot
+{
+	Oid			dboid;
+	pid_t		pid;
+} SchedulerSlot;
+
+typedef struct SchedulerRegistry
+{
+	LWLock	   *lock;
+	int			num_slots;
+	SchedulerSlot slots[FLEXIBLE_ARRAY_MEMBER];
+} SchedulerRegistry;
+
+/* A scheduler started by the launcher */
+typedef struct DatabaseScheduler
+{
+	Oid			dboid;
+	BackgroundWorkerHandle *handle;
+} DatabaseScheduler;
+
+static bool guc_job_scheduler = true;
+static SchedulerRegistry *registry = NULL;
+static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
+static volatile sig_atomic_t got_sigterm = false;
+
+static Size
+registry_size(void)
+{
+	return add_size(offsetof(SchedulerRegistry, slots),
+					mul_size(max_worker_processes, sizeof(SchedulerSlot)));
+}
+
+static void
+registry_shmem_startup(void)
+{
+	bool		found;
+
+	if (prev_shmem_startup_hook != NULL)
+		prev_shmem_startup_hook();
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	registry = ShmemInitStruct("timescaledb scheduler registry", registry_size(), &found);
+
+	if (!found)
+	{
+		memset(registry, 0, registry_size());
+		registry->lock = &(GetNamedLWLockTranche(REGISTRY_TRANCHE_NAME))->lock;
+		registry->num_slots = max_worker_processes;
+	}
+
+	LWLockRelease(AddinShmemInitLock);
+}
+
+static void
+registry_unregister(int code, Datum arg)
+{
+	int			slot = DatumGetInt32(arg);
+
+	LWLockAcquire(registry->lock, LW_EXCLUSIVE);
+	registry->slots[slot].dboid = InvalidOid;
+	registry->slots[slot].pid = 0;
+	LWLockRelease(registry->lock);
+}
+
+/*
+ * Register the current process as the scheduler of a database.
+ */
+void
+bgw_launcher_register_scheduler(Oid dboid)
+{
+	int			i;
+
+	if (NULL == registry)
+		return;
+
+	LWLockAcquire(registry->lock, LW_EXCLUSIVE);
+
+	for (i = 0; i < registry->num_slots; i++)
+	{
+		if (registry->slots[i].pid == 0)
+		{
+			registry->slots[i].dboid = dboid;
+			registry->slots[i].pid = MyProcPid;
+			break;
+		}
+	}
+
+	LWLockRelease(registry->lock);
+
+	if (i < registry->num_slots)
+		before_shmem_exit(registry_unregister, Int32GetDatum(i));
+}
+
+/*
+ * Ask the scheduler of a database to exit, if the current user owns the
+ * database. The scheduler's job workers exit with it.
+ */
+void
+bgw_launcher_stop_scheduler(Oid dboid)
+{
+	int			i;
+
+	if (NULL == registry || !OidIsValid(dboid) ||
+		!pg_database_ownercheck(dboid, GetUserId()))
+		return;
+
+	LWLockAcquire(registry->lock, LW_SHARED);
+
+	for (i = 0; i < registry->num_slots; i++)
+		if (registry->slots[i].pid != 0 && registry->slots[i].dboid == dboid)
+			kill(registry->slots[i].pid, SIGTERM);
+
+	LWLockRelease(registry->lock);
+}
+
+static void
+launcher_sigterm(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	got_sigterm = true;
+	SetLatch(MyLatch);
+
+	errno = save_errno;
+}
+
+/*
+ * Get the OIDs of the databases that accept connections and are not
+ * templates.
+ */
+static List *
+launcher_get_databases(MemoryContext mctx)
+{
+	List	   *dboids = NIL;
+	Relation	rel;
+	HeapScanDesc scan;
+	HeapTuple	tuple;
+
+	StartTransactionCommand();
+	(void) GetTransactionSnapshot();
+
+	rel = heap_open(DatabaseRelationId, AccessShareLock);
+	scan = heap_beginscan_catalog(rel, 0, NULL);
+
+	while (HeapTupleIsValid(tuple = heap_getnext(scan, ForwardScanDirection)))
+	{
+		Form_pg_database db = (Form_pg_database) GETSTRUCT(tuple);
+		MemoryContext old;
+
+		if (!db->datallowconn || db->datistemplate)
+			continue;
+
+		old = MemoryContextSwitchTo(mctx);
+		dboids = lappend_oid(dboids, HeapTupleGetOid(tuple));
+		MemoryContextSwitchTo(old);
+	}
+
+	heap_endscan(scan);
+	heap_close(rel, AccessShareLock);
+
+	CommitTransactionCommand();
+
+	return dboids;
+}
+
+static DatabaseScheduler *
+launcher_start_scheduler(Oid dboid)
+{
+	BackgroundWorker worker;
+	BackgroundWorkerHandle *handle;
+	DatabaseScheduler *scheduler;
+
+	memset(&worker, 0, sizeof(worker));
+	snprintf(worker.bgw_name, BGW_MAXLEN, "timescaledb job scheduler");
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS | BGWORKER_BACKEND_DATABASE_CONNECTION;
+	worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+	worker.bgw_restart_time = BGW_NEVER_RESTART;
+	StrNCpy(worker.bgw_library_name, BGW_LIBRARY_NAME, BGW_MAXLEN);
+	StrNCpy(worker.bgw_function_name, BGW_SCHEDULER_MAIN, BGW_MAXLEN);
+	worker.bgw_main_arg = ObjectIdGetDatum(dboid);
+	worker.bgw_notify_pid = MyProcPid;
+
+	if (!RegisterDynamicBackgroundWorker(&worker, &handle))
+	{
+		ereport(WARNING,
+				(errcode(ERRCODE_CONFIGURATION_LIMIT_EXCEEDED),
+				 errmsg("could not start the job scheduler of database %u", dboid),
+				 errhint("Consider increasing max_worker_processes.")));
+		return NULL;
+	}
+
+	scheduler = palloc(sizeof(DatabaseScheduler));
+	scheduler->dboid = dboid;
+	scheduler->handle = handle;
+
+	return scheduler;
+}
+
+/*
+ * Forget the schedulers that have exited and start schedulers for the
+ * databases that do not have one. A database whose scheduler exited since
+ * the last poll gets a new scheduler on the next poll.
+ */
+static List *
+launcher_poll(List *schedulers, MemoryContext mctx)
+{
+	List	   *dboids = launcher_get_databases(mctx);
+	List	   *active = NIL;
+	List	   *exited = NIL;
+	ListCell   *lc;
+	MemoryContext old = MemoryContextSwitchTo(mctx);
+
+	foreach(lc, schedulers)
+	{
+		DatabaseScheduler *scheduler = lfirst(lc);
+		pid_t		pid;
+
+		if (GetBackgroundWorkerPid(scheduler->handle, &pid) == BGWH_STOPPED)
+		{
+			exited = lappend_oid(exited, scheduler->dboid);
+			pfree(scheduler->handle);
+			pfree(scheduler);
+		}
+		else
+			active = lappend(active, scheduler);
+	}
+
+	list_free(schedulers);
+	schedulers = active;
+
+	foreach(lc, dboids)
+	{
+		Oid			dboid = lfirst_oid(lc);
+		DatabaseScheduler *scheduler;
+		ListCell   *lc_sched;
+		bool		has_scheduler = list_member_oid(exited, dboid);
+
+		foreach(lc_sched, schedulers)
+			if (((DatabaseScheduler *) lfirst(lc_sched))->dboid == dboid)
+				has_scheduler = true;
+
+		if (has_scheduler)
+			continue;
+
+		scheduler = launcher_start_scheduler(dboid);
+
+		if (NULL != scheduler)
+			schedulers = lappend(schedulers, scheduler);
+	}
+
+	list_free(exited);
+	list_free(dboids);
+	MemoryContextSwitchTo(old);
+
+	return schedulers;
+}
+
+void
+ts_bgw_launcher_main(Datum main_arg)
+{
+	MemoryContext mctx;
+	List	   *schedulers = NIL;
+
+	pqsignal(SIGTERM, launcher_sigterm);
+	BackgroundWorkerUnblockSignals();
+
+	/* Connect to the shared catalogs only */
+	BackgroundWorkerInitializeConnection(NULL, NULL);
+
+	mctx = AllocSetContextCreate(TopMemoryContext,
+								 "Job scheduler launcher",
+								 ALLOCSET_DEFAULT_SIZES);
+
+	while (!got_sigterm)
+	{
+		int			rc;
+
+		schedulers = launcher_poll(schedulers, mctx);
+
+#if PG10
+		rc = WaitLatch(MyLatch, WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+					   LAUNCHER_POLL_MS, PG_WAIT_EXTENSION);
+#elif PG96
+		rc = WaitLatch(MyLatch, WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+					   LAUNCHER_POLL_MS);
+#endif
+		ResetLatch(MyLatch);
+
+		if (rc & WL_POSTMASTER_DEATH)
+			proc_exit(1);
+	}
+
+	proc_exit(0);
+}
+
+/*
+ * Set up the launcher. Must be called while the loader is preloaded, since
+ * that is the only time that shared memory can be requested and static
+ * background workers can be registered.
+ */
+void
+bgw_launcher_init(void)
+{
+	BackgroundWorker worker;
+
+	DefineCustomBoolVariable(GUC_JOB_SCHEDULER_NAME, "Enable the background job scheduler",
+							 "Run background jobs, such as retention policies, in each database "
+							 "that has the extension",
+							 &guc_job_scheduler,
+							 true,
+							 PGC_POSTMASTER,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	if (!guc_job_scheduler)
+		return;
+
+	RequestAddinShmemSpace(registry_size());
+	RequestNamedLWLockTranche(REGISTRY_TRANCHE_NAME, 1);
+
+	prev_shmem_startup_hook = shmem_startup_hook;
+	shmem_startup_hook = registry_shmem_startup;
+
+	memset(&worker, 0, sizeof(worker));
+	snprintf(worker.bgw_name, BGW_MAXLEN, "timescaledb job scheduler launcher");
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS | BGWORKER_BACKEND_DATABASE_CONNECTION;
+	worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+	worker.bgw_restart_time = LAUNCHER_RESTART_SECS;
+	StrNCpy(worker.bgw_library_name, BGW_LIBRARY_NAME, BGW_MAXLEN);
+	StrNCpy(worker.bgw_function_name, BGW_LAUNCHER_MAIN, BGW_MAXLEN);
+	RegisterBackgroundWorker(&worker);
+}
+
+void
+bgw_launcher_fini(void)
+{
+	if (registry_shmem_startup == shmem_startup_hook)
+		shmem_startup_hook = prev_shmem_startup_hook;
+}
@@ -0,0 +1,13 @@
+#ifndef TIMESCALEDB_BGW_LAUNCHER_H
+#define TIMESCALEDB_BGW_LAUNCHER_H
+
+#include <postgres.h>
+
+extern void bgw_launcher_init(void);
+extern void bgw_launcher_fini(void);
+extern void bgw_launcher_register_scheduler(Oid dboid);
+extern void bgw_launcher_stop_scheduler(Oid dboid);
+
+extern PGDLLEXPORT void ts_bgw_launcher_main(Datum main_arg);
+
+#endif							/* TIMESCALEDB_BGW_LAUNCHER_H */
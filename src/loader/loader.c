@@ -9,6 +9,15 @@
 #include <utils/guc.h>
 #include <utils/inval.h>
 #include <nodes/print.h>
+#include <commands/dbcommands.h>
+#include <commands/defrem.h>
+#include <postmaster/bgworker.h>
+#include <storage/ipc.h>
+#include <tcop/tcopprot.h>
+
+#include "../bgw_scheduler.h"
+#include "bgw_launcher.h"
+#include "stats_shmem.h"
 
 #define EXTENSION_NAME "timescaledb"
 
@@ -190,9 +199,57 @@ load_utility_cmd(Node *utility_stmt)
 	}
 }
 
+/*
+ * Get the database that a utility statement needs to have no other
+ * connections, or InvalidOid.
+ */
+static Oid
+utility_cmd_exclusive_database(Node *utility_stmt)
+{
+	ListCell   *lc;
+
+	switch (nodeTag(utility_stmt))
+	{
+		case T_DropdbStmt:
+			return get_database_oid(((DropdbStmt *) utility_stmt)->dbname, true);
+		case T_RenameStmt:
+			if (((RenameStmt *) utility_stmt)->renameType == OBJECT_DATABASE)
+				return get_database_oid(((RenameStmt *) utility_stmt)->subname, true);
+			return InvalidOid;
+		case T_CreatedbStmt:
+			foreach(lc, ((CreatedbStmt *) utility_stmt)->options)
+			{
+				DefElem    *option = lfirst(lc);
+
+				if (strcmp(option->defname, "template") == 0 && option->arg != NULL)
+					return get_database_oid(defGetString(option), true);
+			}
+			return InvalidOid;
+		case T_AlterDatabaseStmt:
+			foreach(lc, ((AlterDatabaseStmt *) utility_stmt)->options)
+			{
+				DefElem    *option = lfirst(lc);
+
+				if (strcmp(option->defname, "tablespace") == 0)
+					return get_database_oid(((AlterDatabaseStmt *) utility_stmt)->dbname, true);
+			}
+			return InvalidOid;
+		default:
+			return InvalidOid;
+	}
+}
+
 static void
 post_analyze_hook(ParseState *pstate, Query *query)
 {
+	/*
+	 * The job scheduler is connected to its database, which blocks commands
+	 * that need the database to have no other connections. Stop it, and the
+	 * launcher starts it again later if the database still exists.
+	 */
+	if (query->commandType == CMD_UTILITY)
+		bgw_launcher_stop_scheduler(utility_cmd_exclusive_database(query->utilityStmt));
+
 	if (!guc_disable_load &&
 		(query->commandType != CMD_UTILITY || load_utility_cmd(query->utilityStmt)))
 		extension_check();
@@ -226,6 +283,11 @@ _PG_init(void)
 	{
 		extension_load_without_preload();
 	}
+	else
+	{
+		bgw_launcher_init();
+		stats_shmem_init();
+	}
 	extension_mark_loader_present();
 
 	elog(INFO, "timescaledb loaded");
@@ -260,6 +322,8 @@ void
 _PG_fini(void)
 {
 	post_parse_analyze_hook = prev_post_parse_analyze_hook;
+	bgw_launcher_fini();
+	stats_shmem_fini();
 	/* No way to unregister relcache callback */
 }
 
@@ -348,3 +412,108 @@ call_extension_post_parse_analyze_hook(ParseState *pstate,
 		extension_post_parse_analyze_hook(pstate, query);
 	}
 }
+
+/*
+ * Load the versioned library of the extension in the current database and
+ * look up one of its functions. Returns NULL if the extension is not
+ * installed or its version does not have the function.
+ */
+static PGFunction
+load_versioned_function(const char *funcname)
+{
+	PGFunction	func = NULL;
+
+	StartTransactionCommand();
+
+	if (!guc_disable_load && extension_current_state() == EXTENSION_STATE_CREATED)
+	{
+		char		soname[MAX_SO_NAME_LEN];
+
+		do_load();
+		snprintf(soname, MAX_SO_NAME_LEN, "%s-%s", EXTENSION_NAME, soversion);
+		func = load_external_function(soname, (char *) funcname, false, NULL);
+	}
+
+	CommitTransactionCommand();
+
+	return func;
+}
+
+/*
+ * Entry point of the job scheduler of a database, which is started by the
+ * launcher.
+ */
+PGDLLEXPORT void ts_bgw_scheduler_main(Datum main_arg);
+
+void
+ts_bgw_scheduler_main(Datum main_arg)
+{
+	Oid			dboid = DatumGetObjectId(main_arg);
+	PGFunction	scheduler_main;
+
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+	BackgroundWorkerInitializeConnectionByOid(dboid, InvalidOid);
+
+	bgw_launcher_register_scheduler(dboid);
+
+	scheduler_main = load_versioned_function("bgw_scheduler_main");
+
+	if (NULL != scheduler_main)
+		DirectFunctionCall1(scheduler_main, ObjectIdGetDatum(dboid));
+
+	proc_exit(0);
+}
+
+/*
+ * Entry point of a job worker, which is started by the job scheduler. The
+ * worker's database is passed in the extra data.
+ */
+PGDLLEXPORT void ts_bgw_job_worker_main(Datum main_arg);
+
+void
+ts_bgw_job_worker_main(Datum main_arg)
+{
+	Oid			dboid;
+	PGFunction	job_worker_main;
+
+	memcpy(&dboid, MyBgworkerEntry->bgw_extra, sizeof(Oid));
+
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+	BackgroundWorkerInitializeConnectionByOid(dboid, InvalidOid);
+
+	job_worker_main = load_versioned_function("bgw_job_worker_main");
+
+	if (NULL != job_worker_main)
+		DirectFunctionCall1(job_worker_main, main_arg);
+
+	proc_exit(0);
+}
+
+/*
+ * Entry point of a worker that vacuums or reindexes chunks for a backend. The worker
+ * connects as the user of the backend, which are both passed in the extra
+ * data.
+ */
+PGDLLEXPORT void ts_bgw_maintenance_worker_main(Datum main_arg);
+
+void
+ts_bgw_maintenance_worker_main(Datum main_arg)
+{
+	BgwMaintenanceWorkerArgs args;
+	PGFunction	maintenance_worker_main;
+
+	memcpy(&args, MyBgworkerEntry->bgw_extra, sizeof(args));
+
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+	BackgroundWorkerInitializeConnectionByOid(args.dboid, args.userid);
+
+	maintenance_worker_main = load_versioned_function("bgw_maintenance_worker_main");
+
+	if (NULL != maintenance_worker_main)
+		DirectFunctionCall1(maintenance_worker_main, main_arg);
+
+	proc_exit(0);
+}
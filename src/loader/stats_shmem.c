@@ -0,0 +1,101 @@
+#include <postgres.h>
+#include <fmgr.h>
+#include <miscadmin.h>
+#include <storage/ipc.h>
+#include <storage/lwlock.h>
+#include <storage/shmem.h>
+#include <utils/guc.h>
+
+#include "../hypertable_stats.h"
+#include "stats_shmem.h"
+
+/*
+ * Shared memory for the per-hypertable statistics of the extension. See
+ * hypertable_stats.h.
+ *
+ * The statistics have a fixed number of entries, one per hypertable, that
+ * are assigned to hypertables on first use and kept until the statistics of
+ * the database are reset or the server restarts.
+ */
+
+#define GUC_MAX_HYPERTABLE_STATS_NAME "timescaledb.max_hypertable_stats"
+
+static int	guc_max_hypertable_stats = 1000;
+static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
+
+static Size
+stats_shmem_size(void)
+{
+	return add_size(offsetof(HypertableStatsShared, entries),
+					mul_size(guc_max_hypertable_stats, sizeof(HypertableStatsEntry)));
+}
+
+static void
+stats_shmem_startup(void)
+{
+	HypertableStatsShared *shared;
+	bool		found;
+	int			i,
+				j;
+
+	if (prev_shmem_startup_hook != NULL)
+		prev_shmem_startup_hook();
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	shared = ShmemInitStruct(HYPERTABLE_STATS_SHMEM_NAME, stats_shmem_size(), &found);
+
+	if (!found)
+	{
+		memset(shared, 0, stats_shmem_size());
+		shared->layout_version = HYPERTABLE_STATS_LAYOUT_VERSION;
+		shared->lock = &(GetNamedLWLockTranche(HYPERTABLE_STATS_SHMEM_NAME))->lock;
+		shared->num_entries = guc_max_hypertable_stats;
+		pg_atomic_init_u32(&shared->generation, 0);
+
+		for (i = 0; i < shared->num_entries; i++)
+			for (j = 0; j < _HYPERTABLE_STATS_NUM_COUNTERS; j++)
+				pg_atomic_init_u64(&shared->entries[i].counters[j], 0);
+	}
+
+	LWLockRelease(AddinShmemInitLock);
+
+	*find_rendezvous_variable(HYPERTABLE_STATS_RENDEZVOUS) = shared;
+}
+
+/*
+ * Request the shared memory. Must be called while the loader is preloaded.
+ */
+void
+stats_shmem_init(void)
+{
+	DefineCustomIntVariable(GUC_MAX_HYPERTABLE_STATS_NAME,
+							"Maximum number of hypertables to keep statistics for",
+							"Statistics are kept for this many hypertables across all databases. "
+							"Zero disables the statistics",
+							&guc_max_hypertable_stats,
+							1000,
+							0,
+							65536,
+							PGC_POSTMASTER,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	if (guc_max_hypertable_stats <= 0)
+		return;
+
+	RequestAddinShmemSpace(stats_shmem_size());
+	RequestNamedLWLockTranche(HYPERTABLE_STATS_SHMEM_NAME, 1);
+
+	prev_shmem_startup_hook = shmem_startup_hook;
+	shmem_startup_hook = stats_shmem_startup;
+}
+
+void
+stats_shmem_fini(void)
+{
+	if (stats_shmem_startup == shmem_startup_hook)
+		shmem_startup_hook = prev_shmem_startup_hook;
+}
@@ -0,0 +1,9 @@
+#ifndef TIMESCALEDB_STATS_SHMEM_H
+#define TIMESCALEDB_STATS_SHMEM_H
+
+#include <postgres.h>
+
+extern void stats_shmem_init(void);
+extern void stats_shmem_fini(void);
+
+#endif							/* TIMESCALEDB_STATS_SHMEM_H */
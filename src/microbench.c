@@ -0,0 +1,440 @@
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <fmgr.h>
+#include <funcapi.h>
+#include <portability/instr_time.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/typcache.h>
+
+#include "cache.h"
+#include "dimension.h"
+#include "dimension_slice.h"
+#include "dimension_vector.h"
+#include "errors.h"
+#include "hypercube.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "partitioning.h"
+#include "subspace_store.h"
+#include "compat.h"
+
+/*
+ * Microbenchmarks of data structures and functions on the insert path.
+ *
+ * Each function runs a tight loop over one primitive and returns the average
+ * time per operation in nanoseconds, so that changes to these primitives can
+ * be evaluated without a full ingest run. The functions are only built in
+ * debug builds and are declared by the tests that use them, e.g.:
+ *
+ * CREATE FUNCTION bench_dimension_vec_find_slice(num_slices INTEGER, iterations INTEGER)
+ * RETURNS FLOAT8 AS :MODULE_PATHNAME, 'bench_dimension_vec_find_slice' LANGUAGE C VOLATILE;
+ *
+ * Functions that take a hypertable use its dimensions. Those that take a row
+ * of a hypertable use the row's values as input.
+ */
+
+/* A cheap pseudo-random sequence, so that the loops measure the primitive */
+static inline uint32
+bench_next_random(uint32 *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static double
+bench_ns_per_op(instr_time start, int64 num_ops)
+{
+	instr_time	duration;
+
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, start);
+
+	if (num_ops <= 0)
+		return 0;
+
+	return INSTR_TIME_GET_DOUBLE(duration) * 1e9 / num_ops;
+}
+
+static void
+bench_check_positive(const char *name, int32 value)
+{
+	if (value <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("%s must be greater than zero", name)));
+}
+
+static Hypertable *
+bench_get_hypertable(Cache *hcache, Oid relid)
+{
+	Hypertable *ht = hypertable_cache_get_entry(hcache, relid);
+
+	if (NULL == ht)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_HYPERTABLE_NOT_EXIST),
+				 errmsg("table \"%s\" is not a hypertable", get_rel_name(relid))));
+
+	return ht;
+}
+
+/*
+ * Get the hypertable and heap tuple of a row passed as a composite argument.
+ */
+static Hypertable *
+bench_get_row(FunctionCallInfo fcinfo, Cache *hcache, HeapTupleData *tuple, TupleDesc *tupdesc)
+{
+	Oid			argtype = get_fn_expr_argtype(fcinfo->flinfo, 0);
+	Oid			relid = OidIsValid(argtype) ? get_typ_typrelid(argtype) : InvalidOid;
+	HeapTupleHeader td;
+
+	if (!OidIsValid(relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("argument must be a row of a hypertable")));
+
+	td = PG_GETARG_HEAPTUPLEHEADER(0);
+
+	tuple->t_len = HeapTupleHeaderGetDatumLength(td);
+	ItemPointerSetInvalid(&tuple->t_self);
+	tuple->t_tableOid = InvalidOid;
+	tuple->t_data = td;
+
+	*tupdesc = lookup_rowtype_tupdesc(HeapTupleHeaderGetTypeId(td),
+									  HeapTupleHeaderGetTypMod(td));
+
+	return bench_get_hypertable(hcache, relid);
+}
+
+/*
+ * Calculate the point of the i:th chunk in a grid of chunks that covers all
+ * closed dimension partitions before moving to the next time interval.
+ */
+static void
+bench_grid_point(Hyperspace *hs, int32 i, Point *p)
+{
+	int			d;
+
+	p->num_coords = hs->num_dimensions;
+
+	for (d = hs->num_dimensions - 1; d >= 0; d--)
+	{
+		Dimension  *dim = &hs->dimensions[d];
+
+		if (dim->type == DIMENSION_TYPE_CLOSED)
+		{
+			p->coordinates[d] = (i % dim->fd.num_slices) *
+				(DIMENSION_SLICE_CLOSED_MAX / dim->fd.num_slices);
+			i /= dim->fd.num_slices;
+		}
+	}
+
+	for (d = 0; d < hs->num_dimensions; d++)
+	{
+		Dimension  *dim = &hs->dimensions[d];
+
+		if (dim->type == DIMENSION_TYPE_OPEN)
+		{
+			p->coordinates[d] = i * dim->fd.interval_length;
+			i = 0;
+		}
+	}
+}
+
+static Hypercube *
+bench_grid_cube(Hyperspace *hs, Point *p)
+{
+	Hypercube  *cube = hypercube_alloc(hs->num_dimensions);
+	int			d;
+
+	for (d = 0; d < hs->num_dimensions; d++)
+		hypercube_add_slice(cube, dimension_calculate_default_slice(&hs->dimensions[d],
+																	p->coordinates[d]));
+
+	return cube;
+}
+
+static SubspaceStore *
+bench_subspace_store_fill(Hyperspace *hs, int32 num_chunks, int16 max_items, instr_time *start)
+{
+	SubspaceStore *store = subspace_store_init(hs, CurrentMemoryContext, max_items);
+	Hypercube **cubes = palloc(sizeof(Hypercube *) * num_chunks);
+	Point	   *p = point_create(hs->num_dimensions);
+	int32		i;
+
+	/* Calculate the cubes up front to only time the store */
+	for (i = 0; i < num_chunks; i++)
+	{
+		bench_grid_point(hs, i, p);
+		cubes[i] = bench_grid_cube(hs, p);
+	}
+
+	INSTR_TIME_SET_CURRENT(*start);
+
+	for (i = 0; i < num_chunks; i++)
+		subspace_store_add(store, cubes[i], cubes[i], NULL);
+
+	return store;
+}
+
+TS_FUNCTION_INFO_V1(bench_subspace_store_add);
+
+/*
+ * Add a grid of chunks to a subspace store with the given hypertable's
+ * dimensions. A store smaller than the number of chunks evicts entries.
+ */
+Datum
+bench_subspace_store_add(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	int32		num_chunks = PG_GETARG_INT32(1);
+	int32		max_items = PG_GETARG_INT32(2);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = bench_get_hypertable(hcache, relid);
+	SubspaceStore *store;
+	instr_time	start;
+	double		ns;
+
+	bench_check_positive("num_chunks", num_chunks);
+
+	if (max_items < 0 || max_items > PG_INT16_MAX)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("max_items must be between 0 and %d", PG_INT16_MAX)));
+
+	store = bench_subspace_store_fill(ht->space, num_chunks, max_items, &start);
+	ns = bench_ns_per_op(start, num_chunks);
+
+	subspace_store_free(store);
+	cache_release(hcache);
+
+	PG_RETURN_FLOAT8(ns);
+}
+
+TS_FUNCTION_INFO_V1(bench_subspace_store_get);
+
+/*
+ * Look up random points in a subspace store that holds a grid of chunks with
+ * the given hypertable's dimensions.
+ */
+Datum
+bench_subspace_store_get(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	int32		num_chunks = PG_GETARG_INT32(1);
+	int32		iterations = PG_GETARG_INT32(2);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = bench_get_hypertable(hcache, relid);
+	SubspaceStore *store;
+	Point	  **points;
+	uint32		rand_state = 1;
+	instr_time	start;
+	int32		i;
+	int64		num_found = 0;
+	double		ns;
+
+	bench_check_positive("num_chunks", num_chunks);
+	bench_check_positive("iterations", iterations);
+
+	store = bench_subspace_store_fill(ht->space, num_chunks, 0, &start);
+	points = palloc(sizeof(Point *) * num_chunks);
+
+	for (i = 0; i < num_chunks; i++)
+	{
+		points[i] = point_create(ht->space->num_dimensions);
+		bench_grid_point(ht->space, i, points[i]);
+	}
+
+	INSTR_TIME_SET_CURRENT(start);
+
+	for (i = 0; i < iterations; i++)
+		if (NULL != subspace_store_get(store, points[bench_next_random(&rand_state) % num_chunks]))
+			num_found++;
+
+	ns = bench_ns_per_op(start, iterations);
+
+	if (num_found != iterations)
+		elog(ERROR, "subspace store found " INT64_FORMAT " of %d points", num_found, iterations);
+
+	subspace_store_free(store);
+	cache_release(hcache);
+
+	PG_RETURN_FLOAT8(ns);
+}
+
+TS_FUNCTION_INFO_V1(bench_dimension_vec_find_slice);
+
+/*
+ * Find random coordinates in a dimension vector of adjacent slices.
+ */
+Datum
+bench_dimension_vec_find_slice(PG_FUNCTION_ARGS)
+{
+	int32		num_slices = PG_GETARG_INT32(0);
+	int32		iterations = PG_GETARG_INT32(1);
+	DimensionVec *vec = dimension_vec_create(num_slices);
+	int64		interval = 1000;
+	uint32		rand_state = 1;
+	instr_time	start;
+	int32		i;
+	int64		num_found = 0;
+	double		ns;
+
+	bench_check_positive("num_slices", num_slices);
+	bench_check_positive("iterations", iterations);
+
+	for (i = 0; i < num_slices; i++)
+		vec = dimension_vec_add_slice(&vec, dimension_slice_create(1, i * interval, (i + 1) * interval));
+
+	dimension_vec_sort(&vec);
+
+	INSTR_TIME_SET_CURRENT(start);
+
+	for (i = 0; i < iterations; i++)
+	{
+		int64		coordinate = (int64) (bench_next_random(&rand_state) % num_slices) * interval;
+
+		if (NULL != dimension_vec_find_slice(vec, coordinate))
+			num_found++;
+	}
+
+	ns = bench_ns_per_op(start, iterations);
+
+	if (num_found != iterations)
+		elog(ERROR, "dimension vector found " INT64_FORMAT " of %d coordinates", num_found, iterations);
+
+	dimension_vec_free(vec);
+
+	PG_RETURN_FLOAT8(ns);
+}
+
+TS_FUNCTION_INFO_V1(bench_calculate_point);
+
+/*
+ * Calculate the point of a row of a hypertable, either from the heap tuple,
+ * as done for COPY, or from deformed values, as done for INSERT.
+ */
+Datum
+bench_calculate_point(PG_FUNCTION_ARGS)
+{
+	int32		iterations = PG_GETARG_INT32(1);
+	bool		from_values = PG_GETARG_BOOL(2);
+	Cache	   *hcache = hypertable_cache_pin();
+	HeapTupleData tuple;
+	TupleDesc	tupdesc;
+	Hypertable *ht = bench_get_row(fcinfo, hcache, &tuple, &tupdesc);
+	Datum	   *values = palloc(sizeof(Datum) * tupdesc->natts);
+	bool	   *nulls = palloc(sizeof(bool) * tupdesc->natts);
+	Point	   *p = point_create(ht->space->num_dimensions);
+	MemoryContext loop_mcxt,
+				old;
+	instr_time	start;
+	int32		i;
+	double		ns;
+
+	bench_check_positive("iterations", iterations);
+
+	heap_deform_tuple(&tuple, tupdesc, values, nulls);
+
+	/* Partitioning functions and the heap tuple path allocate memory */
+	loop_mcxt = AllocSetContextCreate(CurrentMemoryContext,
+									  "Benchmark loop",
+									  ALLOCSET_DEFAULT_SIZES);
+	old = MemoryContextSwitchTo(loop_mcxt);
+
+	INSTR_TIME_SET_CURRENT(start);
+
+	for (i = 0; i < iterations; i++)
+	{
+		if (from_values)
+			hyperspace_calculate_point_from_values(ht->space, values, nulls, p);
+		else
+			hyperspace_calculate_point(ht->space, &tuple, tupdesc);
+
+		MemoryContextReset(loop_mcxt);
+	}
+
+	ns = bench_ns_per_op(start, iterations);
+
+	MemoryContextSwitchTo(old);
+	MemoryContextDelete(loop_mcxt);
+	ReleaseTupleDesc(tupdesc);
+	cache_release(hcache);
+
+	PG_RETURN_FLOAT8(ns);
+}
+
+TS_FUNCTION_INFO_V1(bench_partitioning_func);
+
+/*
+ * Apply the partitioning functions of a hypertable's closed dimensions to the
+ * values of a row. The time is per row, i.e., for all closed dimensions.
+ */
+Datum
+bench_partitioning_func(PG_FUNCTION_ARGS)
+{
+	int32		iterations = PG_GETARG_INT32(1);
+	Cache	   *hcache = hypertable_cache_pin();
+	HeapTupleData tuple;
+	TupleDesc	tupdesc;
+	Hypertable *ht = bench_get_row(fcinfo, hcache, &tuple, &tupdesc);
+	Hyperspace *hs = ht->space;
+	Datum	   *values = palloc(sizeof(Datum) * tupdesc->natts);
+	bool	   *nulls = palloc(sizeof(bool) * tupdesc->natts);
+	MemoryContext loop_mcxt,
+				old;
+	instr_time	start;
+	int32		i;
+	int			d;
+	double		ns;
+
+	bench_check_positive("iterations", iterations);
+
+	if (hyperspace_get_num_dimensions_by_type(hs, DIMENSION_TYPE_CLOSED) == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("hypertable \"%s\" has no space dimension",
+						get_rel_name(ht->main_table_relid))));
+
+	heap_deform_tuple(&tuple, tupdesc, values, nulls);
+
+	for (d = 0; d < hs->num_dimensions; d++)
+		if (hs->dimensions[d].type == DIMENSION_TYPE_CLOSED &&
+			nulls[AttrNumberGetAttrOffset(hs->dimensions[d].column_attno)])
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("row has NULL partitioning column \"%s\"",
+							NameStr(hs->dimensions[d].fd.column_name))));
+
+	loop_mcxt = AllocSetContextCreate(CurrentMemoryContext,
+									  "Benchmark loop",
+									  ALLOCSET_DEFAULT_SIZES);
+	old = MemoryContextSwitchTo(loop_mcxt);
+
+	INSTR_TIME_SET_CURRENT(start);
+
+	for (i = 0; i < iterations; i++)
+	{
+		for (d = 0; d < hs->num_dimensions; d++)
+		{
+			Dimension  *dim = &hs->dimensions[d];
+
+			if (dim->type == DIMENSION_TYPE_CLOSED)
+				partitioning_func_apply(dim->partitioning,
+										values[AttrNumberGetAttrOffset(dim->column_attno)]);
+		}
+
+		MemoryContextReset(loop_mcxt);
+	}
+
+	ns = bench_ns_per_op(start, iterations);
+
+	MemoryContextSwitchTo(old);
+	MemoryContextDelete(loop_mcxt);
+	ReleaseTupleDesc(tupdesc);
+	cache_release(hcache);
+
+	PG_RETURN_FLOAT8(ns);
+}
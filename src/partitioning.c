@@ -13,6 +13,8 @@
 #include <utils/acl.h>
 #include <utils/rangetypes.h>
 #include <utils/memutils.h>
+#include <utils/int8.h>
+#include <utils/uuid.h>
 #include <catalog/namespace.h>
 #include <catalog/pg_type.h>
 #include <access/hash.h>
@@ -133,6 +135,178 @@ find_text_coercion_func(Oid type)
 
 #define TYPECACHE_HASH_FLAGS (TYPECACHE_HASH_PROC | TYPECACHE_HASH_PROC_FINFO)
 
+/* Only positive numbers */
+#define PARTITION_HASH_RESULT(hash)				\
+	((int32) (DatumGetUInt32(hash) & 0x7fffffff))
+
+/*
+ * Partitioning kernels for get_partition_hash(). These need to produce the
+ * same value as the type's hash function, i.e., hashint2(), hashint4(),
+ * hashint8(), hashtext(), and uuid_hash().
+ */
+static int32
+partition_hash_int2(Datum value)
+{
+	return PARTITION_HASH_RESULT(hash_uint32((int32) DatumGetInt16(value)));
+}
+
+static int32
+partition_hash_int4(Datum value)
+{
+	return PARTITION_HASH_RESULT(hash_uint32(DatumGetInt32(value)));
+}
+
+static int32
+partition_hash_int8(Datum value)
+{
+	int64		val = DatumGetInt64(value);
+	uint32		lohalf = (uint32) val;
+	uint32		hihalf = (uint32) (val >> 32);
+
+	/* Same as hashint8(), so that values compatible with int4 hash the same */
+	lohalf ^= (val >= 0) ? hihalf : ~hihalf;
+
+	return PARTITION_HASH_RESULT(hash_uint32(lohalf));
+}
+
+static inline int32
+partition_hash_bytes(const char *data, int len)
+{
+	return PARTITION_HASH_RESULT(hash_any((const unsigned char *) data, len));
+}
+
+static int32
+partition_hash_text(Datum value)
+{
+	text	   *data = DatumGetTextPP(value);
+	int32		res = partition_hash_bytes(VARDATA_ANY(data), VARSIZE_ANY_EXHDR(data));
+
+	if ((Pointer) data != DatumGetPointer(value))
+		pfree(data);
+
+	return res;
+}
+
+static int32
+partition_hash_uuid(Datum value)
+{
+	pg_uuid_t  *uuid = DatumGetUUIDP(value);
+
+	return partition_hash_bytes((const char *) uuid->data, UUID_LEN);
+}
+
+/*
+ * Partitioning kernels for the legacy get_partition_for_key(), which hashes
+ * the value's text representation. The text is formatted into a buffer on the
+ * stack instead of calling the type's output function.
+ */
+static int32
+partition_for_key_int2(Datum value)
+{
+	char		buf[MAXINT8LEN + 1];
+
+	pg_itoa(DatumGetInt16(value), buf);
+
+	return partition_hash_bytes(buf, strlen(buf));
+}
+
+static int32
+partition_for_key_int4(Datum value)
+{
+	char		buf[MAXINT8LEN + 1];
+
+	pg_ltoa(DatumGetInt32(value), buf);
+
+	return partition_hash_bytes(buf, strlen(buf));
+}
+
+static int32
+partition_for_key_int8(Datum value)
+{
+	char		buf[MAXINT8LEN + 1];
+
+	pg_lltoa(DatumGetInt64(value), buf);
+
+	return partition_hash_bytes(buf, strlen(buf));
+}
+
+static int32
+partition_for_key_uuid(Datum value)
+{
+	static const char hex_chars[] = "0123456789abcdef";
+	pg_uuid_t  *uuid = DatumGetUUIDP(value);
+	char		buf[2 * UUID_LEN + 4];
+	char	   *p = buf;
+	int			i;
+
+	/* Same format as uuid_out() */
+	for (i = 0; i < UUID_LEN; i++)
+	{
+		if (i == 4 || i == 6 || i == 8 || i == 10)
+			*p++ = '-';
+
+		*p++ = hex_chars[uuid->data[i] >> 4];
+		*p++ = hex_chars[uuid->data[i] & 0x0F];
+	}
+
+	return partition_hash_bytes(buf, p - buf);
+}
+
+/*
+ * Get a specialized kernel for one of our own partitioning functions, given
+ * the type of the partitioning column. Returns NULL if there is none, in
+ * which case the function is called through the function manager.
+ */
+static PartitioningFuncKernel
+partitioning_func_get_kernel(PartitioningFunc *pf, Oid columntype)
+{
+	if (strncmp(pf->schema, DEFAULT_PARTITIONING_FUNC_SCHEMA, NAMEDATALEN) != 0)
+		return NULL;
+
+	if (strncmp(pf->name, DEFAULT_PARTITIONING_FUNC_NAME, NAMEDATALEN) == 0)
+	{
+		switch (columntype)
+		{
+			case INT2OID:
+				return partition_hash_int2;
+			case INT4OID:
+				return partition_hash_int4;
+			case INT8OID:
+				return partition_hash_int8;
+			case TEXTOID:
+			case VARCHAROID:
+				return partition_hash_text;
+			case UUIDOID:
+				return partition_hash_uuid;
+			default:
+				return NULL;
+		}
+	}
+
+	if (strncmp(pf->name, LEGACY_PARTITIONING_FUNC_NAME, NAMEDATALEN) == 0)
+	{
+		switch (columntype)
+		{
+			case INT2OID:
+				return partition_for_key_int2;
+			case INT4OID:
+				return partition_for_key_int4;
+			case INT8OID:
+				return partition_for_key_int8;
+			case TEXTOID:
+			case VARCHAROID:
+				/* varchar converts to text without changing the data */
+				return partition_hash_text;
+			case UUIDOID:
+				return partition_for_key_uuid;
+			default:
+				return NULL;
+		}
+	}
+
+	return NULL;
+}
+
 PartitioningInfo *
 partitioning_info_create(const char *schema,
 						 const char *partfunc,
@@ -166,6 +340,7 @@ partitioning_info_create(const char *schema,
 		elog(ERROR, "could not find hash function for type %u", columntype);
 
 	partitioning_func_set_func_fmgr(&pinfo->partfunc);
+	pinfo->partfunc.kernel = partitioning_func_get_kernel(&pinfo->partfunc, columntype);
 
 	/*
 	 * Prepare a function expression for this function. The partition hash
@@ -186,6 +361,9 @@ partitioning_info_create(const char *schema,
 
 	fmgr_info_set_expr((Node *) expr, &pinfo->partfunc.func_fmgr);
 
+	InitFunctionCallInfoData(pinfo->partfunc.fcinfo, &pinfo->partfunc.func_fmgr,
+							 1, InvalidOid, NULL, NULL);
+
 	return pinfo;
 }
 
@@ -197,7 +375,23 @@ partitioning_info_create(const char *schema,
 int32
 partitioning_func_apply(PartitioningInfo *pinfo, Datum value)
 {
-	return DatumGetInt32(FunctionCall1(&pinfo->partfunc.func_fmgr, value));
+	FunctionCallInfo fcinfo = &pinfo->partfunc.fcinfo;
+	Datum		result;
+
+	if (NULL != pinfo->partfunc.kernel)
+		return pinfo->partfunc.kernel(value);
+
+	fcinfo->arg[0] = value;
+	fcinfo->argnull[0] = false;
+	fcinfo->isnull = false;
+
+	result = FunctionCallInvoke(fcinfo);
+
+	/* Same check as FunctionCall1() */
+	if (fcinfo->isnull)
+		elog(ERROR, "function %u returned NULL", fcinfo->flinfo->fn_oid);
+
+	return DatumGetInt32(result);
 }
 
 int32
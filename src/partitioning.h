@@ -16,6 +16,14 @@
 
 #define DEFAULT_PARTITIONING_FUNC_SCHEMA INTERNAL_SCHEMA_NAME
 #define DEFAULT_PARTITIONING_FUNC_NAME "get_partition_hash"
+#define LEGACY_PARTITIONING_FUNC_NAME "get_partition_for_key"
+
+/*
+ * A partitioning function specialized for a built-in column type. Computes the
+ * same value as the partitioning function, but without going through the
+ * function manager.
+ */
+typedef int32 (*PartitioningFuncKernel) (Datum value);
 
 typedef struct PartitioningFunc
 {
@@ -27,6 +35,15 @@ typedef struct PartitioningFunc
 	 * partitioning column's text representation.
 	 */
 	FmgrInfo	func_fmgr;
+
+	/*
+	 * Call info for the function, set up once and reused for each value
+	 * instead of being initialized per call
+	 */
+	FunctionCallInfoData fcinfo;
+
+	/* Specialized version of the function, if any, for the column type */
+	PartitioningFuncKernel kernel;
 } PartitioningFunc;
 
 
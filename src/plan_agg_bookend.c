@@ -0,0 +1,435 @@
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <access/sysattr.h>
+#include <catalog/pg_aggregate.h>
+#include <catalog/pg_am.h>
+#include <catalog/pg_class.h>
+#include <catalog/pg_index.h>
+#include <catalog/pg_type.h>
+#include <nodes/makefuncs.h>
+#include <nodes/nodeFuncs.h>
+#include <optimizer/clauses.h>
+#include <optimizer/var.h>
+#include <parser/parse_oper.h>
+#include <parser/parsetree.h>
+#include <rewrite/rewriteManip.h>
+#include <utils/lsyscache.h>
+#include <utils/rel.h>
+#include <utils/relcache.h>
+#include <utils/syscache.h>
+
+#include "plan_agg_bookend.h"
+#include "hypertable_cache.h"
+#include "dimension.h"
+#include "catalog.h"
+
+/*
+ * Index-driven first() and last().
+ *
+ * For a query like
+ *
+ *	SELECT last(temp, time) FROM hypertable WHERE device = 7;
+ *
+ * the aggregate only depends on the row with the latest time, but the
+ * planner has no way to know that, so every matching row is aggregated.
+ * Like PostgreSQL's optimization of min() and max(), we rewrite the query so
+ * that the aggregate reads from a subquery that returns only that row:
+ *
+ *	SELECT last(temp, time) FROM
+ *		(SELECT temp, time FROM hypertable WHERE device = 7
+ *		 ORDER BY time DESC LIMIT 1) hypertable;
+ *
+ * The subquery is planned as an ordered scan of the chunks, newest chunk
+ * first, that stops after the first matching row, see plan_ordered_append.c.
+ *
+ * The rewrite applies to ungrouped queries over a single hypertable whose
+ * aggregates are all first(), or all last(), ordered by the hypertable's time
+ * column, and only if there is an index on the time column to scan. The time
+ * column is never NULL, so a NULL comparison element, which makes the result
+ * NULL, cannot be missed by reading a single row.
+ */
+
+typedef enum BookendKind
+{
+	BOOKEND_NONE,
+	BOOKEND_FIRST,
+	BOOKEND_LAST,
+} BookendKind;
+
+typedef struct BookendContext
+{
+	Index		relid;
+	AttrNumber	time_attno;
+	BookendKind kind;
+	bool		valid;
+} BookendContext;
+
+/*
+ * Get the kind of a bookend aggregate by its transition function, which
+ * identifies our first() and last() regardless of the schema they were
+ * created in.
+ */
+static BookendKind
+bookend_kind(Oid aggfnoid)
+{
+	HeapTuple	tuple;
+	Oid			transfn;
+	char	   *name;
+	BookendKind kind = BOOKEND_NONE;
+
+	tuple = SearchSysCache1(AGGFNOID, ObjectIdGetDatum(aggfnoid));
+
+	if (!HeapTupleIsValid(tuple))
+		return BOOKEND_NONE;
+
+	transfn = ((Form_pg_aggregate) GETSTRUCT(tuple))->aggtransfn;
+	ReleaseSysCache(tuple);
+
+	if (get_func_namespace(transfn) != catalog_get()->internal_schema_id)
+		return BOOKEND_NONE;
+
+	name = get_func_name(transfn);
+
+	if (strcmp(name, "first_sfunc") == 0)
+		kind = BOOKEND_FIRST;
+	else if (strcmp(name, "last_sfunc") == 0)
+		kind = BOOKEND_LAST;
+
+	pfree(name);
+
+	return kind;
+}
+
+/*
+ * Check that all aggregates are bookends of the same kind on the time column.
+ */
+static bool
+bookend_aggregates_walker(Node *node, BookendContext *ctx)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Aggref))
+	{
+		Aggref	   *aggref = (Aggref *) node;
+		BookendKind kind;
+		TargetEntry *value;
+		TargetEntry *cmp;
+
+		if (aggref->agglevelsup != 0 ||
+			aggref->aggfilter != NULL ||
+			aggref->aggorder != NIL ||
+			aggref->aggdistinct != NIL ||
+			aggref->aggkind != AGGKIND_NORMAL ||
+			list_length(aggref->args) != 2)
+		{
+			ctx->valid = false;
+			return true;
+		}
+
+		kind = bookend_kind(aggref->aggfnoid);
+
+		if (kind == BOOKEND_NONE || (ctx->kind != BOOKEND_NONE && ctx->kind != kind))
+		{
+			ctx->valid = false;
+			return true;
+		}
+
+		ctx->kind = kind;
+		value = linitial(aggref->args);
+		cmp = lsecond(aggref->args);
+
+		/* The value is computed for a single row only */
+		if (contain_volatile_functions((Node *) value->expr) ||
+			!IsA(cmp->expr, Var) ||
+			((Var *) cmp->expr)->varno != ctx->relid ||
+			((Var *) cmp->expr)->varlevelsup != 0 ||
+			((Var *) cmp->expr)->varattno != ctx->time_attno)
+		{
+			ctx->valid = false;
+			return true;
+		}
+
+		return false;
+	}
+
+	return expression_tree_walker(node, bookend_aggregates_walker, ctx);
+}
+
+/*
+ * Check for a plain btree index whose leading column is the time column.
+ * Chunks get the indexes of their hypertable.
+ */
+static bool
+has_time_index(Hypertable *ht, AttrNumber time_attno)
+{
+	Relation	rel = heap_open(ht->main_table_relid, AccessShareLock);
+	List	   *indexes = RelationGetIndexList(rel);
+	bool		found = false;
+	ListCell   *lc;
+
+	heap_close(rel, AccessShareLock);
+
+	foreach(lc, indexes)
+	{
+		Oid			indexoid = lfirst_oid(lc);
+		HeapTuple	tuple;
+		Form_pg_index index;
+		bool		plain;
+
+		tuple = SearchSysCache1(INDEXRELID, ObjectIdGetDatum(indexoid));
+
+		if (!HeapTupleIsValid(tuple))
+			continue;
+
+		index = (Form_pg_index) GETSTRUCT(tuple);
+		plain = index->indnatts >= 1 &&
+			index->indkey.values[0] == time_attno &&
+			heap_attisnull(tuple, Anum_pg_index_indpred);
+		ReleaseSysCache(tuple);
+
+		if (!plain)
+			continue;
+
+		tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(indexoid));
+
+		if (!HeapTupleIsValid(tuple))
+			continue;
+
+		found = ((Form_pg_class) GETSTRUCT(tuple))->relam == BTREE_AM_OID;
+		ReleaseSysCache(tuple);
+
+		if (found)
+			break;
+	}
+
+	list_free(indexes);
+
+	return found;
+}
+
+/*
+ * Replace the hypertable's columns in the aggregates by the columns of the
+ * subquery.
+ */
+typedef struct SubqueryColumnsContext
+{
+	Index		relid;
+	List	   *attnos;
+} SubqueryColumnsContext;
+
+static Node *
+subquery_columns_mutator(Node *node, SubqueryColumnsContext *ctx)
+{
+	if (node == NULL)
+		return NULL;
+
+	if (IsA(node, Var) &&
+		((Var *) node)->varno == ctx->relid &&
+		((Var *) node)->varlevelsup == 0)
+	{
+		Var		   *var = copyObject(node);
+		ListCell   *lc;
+		AttrNumber	resno = 1;
+
+		foreach(lc, ctx->attnos)
+		{
+			if (lfirst_int(lc) == var->varattno)
+				break;
+			resno++;
+		}
+
+		Assert(lc != NULL);
+		var->varattno = resno;
+		var->varoattno = resno;
+
+		return (Node *) var;
+	}
+
+	return expression_tree_mutator(node, subquery_columns_mutator, ctx);
+}
+
+/*
+ * Rewrite a query to aggregate only the first or last row of its hypertable,
+ * if it qualifies.
+ */
+static void
+bookend_rewrite_query(Query *query, Cache *hcache)
+{
+	RangeTblRef *rtr;
+	RangeTblEntry *rte;
+	RangeTblEntry *subrte;
+	Hypertable *ht;
+	Dimension  *dim;
+	BookendContext ctx;
+	SubqueryColumnsContext colctx;
+	Query	   *subquery;
+	Bitmapset  *attnos = NULL;
+	List	   *colnames = NIL;
+	SortGroupClause *sortcl;
+	Oid			ltopr,
+				eqopr,
+				gtopr;
+	bool		hashable;
+	ListCell   *lc;
+	int			i = -1;
+
+	if (query->commandType != CMD_SELECT ||
+		query->utilityStmt != NULL ||
+		!query->hasAggs ||
+		query->hasWindowFuncs ||
+		query->hasTargetSRFs ||
+		query->hasSubLinks ||
+		query->hasForUpdate ||
+		query->groupClause != NIL ||
+		query->groupingSets != NIL ||
+		query->cteList != NIL ||
+		query->setOperations != NULL ||
+		query->rowMarks != NIL ||
+		list_length(query->rtable) != 1 ||
+		list_length(query->jointree->fromlist) != 1 ||
+		!IsA(linitial(query->jointree->fromlist), RangeTblRef))
+		return;
+
+	rtr = linitial(query->jointree->fromlist);
+	rte = rt_fetch(rtr->rtindex, query->rtable);
+
+	if (rte->rtekind != RTE_RELATION ||
+		!rte->inh ||
+		rte->relkind != RELKIND_RELATION ||
+		rte->tablesample != NULL ||
+		rte->securityQuals != NIL)
+		return;
+
+	ht = hypertable_cache_get_entry(hcache, rte->relid);
+
+	if (ht == NULL)
+		return;
+
+	dim = hyperspace_get_open_dimension(ht->space, 0);
+
+	if (dim == NULL)
+		return;
+
+	ctx.relid = rtr->rtindex;
+	ctx.time_attno = dim->column_attno;
+	ctx.kind = BOOKEND_NONE;
+	ctx.valid = true;
+
+	bookend_aggregates_walker((Node *) query->targetList, &ctx);
+
+	if (ctx.valid)
+		bookend_aggregates_walker(query->havingQual, &ctx);
+
+	if (!ctx.valid || ctx.kind == BOOKEND_NONE)
+		return;
+
+	/* The columns the aggregates read, which the subquery returns */
+	pull_varattnos((Node *) query->targetList, rtr->rtindex, &attnos);
+	pull_varattnos(query->havingQual, rtr->rtindex, &attnos);
+
+	colctx.relid = rtr->rtindex;
+	colctx.attnos = NIL;
+
+	while ((i = bms_next_member(attnos, i)) >= 0)
+	{
+		AttrNumber	attno = i + FirstLowInvalidHeapAttributeNumber;
+
+		/* Whole-row and system columns are not worth the trouble */
+		if (attno <= 0)
+			return;
+
+		colctx.attnos = lappend_int(colctx.attnos, attno);
+	}
+
+	if (!has_time_index(ht, dim->column_attno))
+		return;
+
+	get_sort_group_operators(dim->fd.column_type, true, true, true,
+							 &ltopr, &eqopr, &gtopr, &hashable);
+
+	subquery = makeNode(Query);
+	subquery->commandType = CMD_SELECT;
+	subquery->querySource = QSRC_ORIGINAL;
+	subquery->canSetTag = true;
+	subquery->rtable = query->rtable;
+	subquery->jointree = query->jointree;
+
+	foreach(lc, colctx.attnos)
+	{
+		AttrNumber	attno = lfirst_int(lc);
+		char	   *colname = strVal(list_nth(rte->eref->colnames, attno - 1));
+		Oid			vartype;
+		int32		vartypmod;
+		Oid			varcollid;
+		TargetEntry *tle;
+
+		get_atttypetypmodcoll(rte->relid, attno, &vartype, &vartypmod, &varcollid);
+		tle = makeTargetEntry((Expr *) makeVar(rtr->rtindex, attno, vartype, vartypmod, varcollid, 0),
+							  list_length(subquery->targetList) + 1,
+							  pstrdup(colname),
+							  false);
+
+		if (attno == dim->column_attno)
+			tle->ressortgroupref = 1;
+
+		subquery->targetList = lappend(subquery->targetList, tle);
+		colnames = lappend(colnames, makeString(pstrdup(colname)));
+	}
+
+	sortcl = makeNode(SortGroupClause);
+	sortcl->tleSortGroupRef = 1;
+	sortcl->eqop = eqopr;
+	sortcl->sortop = ctx.kind == BOOKEND_LAST ? gtopr : ltopr;
+	sortcl->nulls_first = ctx.kind == BOOKEND_LAST;
+	sortcl->hashable = hashable;
+	subquery->sortClause = list_make1(sortcl);
+	subquery->limitCount = (Node *) makeConst(INT8OID, -1, InvalidOid, sizeof(int64),
+											  Int64GetDatum(1), false, FLOAT8PASSBYVAL);
+
+	/* The quals moved one level down, below any outer references */
+	IncrementVarSublevelsUp((Node *) subquery->jointree, 1, 1);
+
+	subrte = makeNode(RangeTblEntry);
+	subrte->rtekind = RTE_SUBQUERY;
+	subrte->subquery = subquery;
+	subrte->eref = makeAlias(rte->eref->aliasname, colnames);
+	subrte->inFromCl = true;
+
+	rtr = makeNode(RangeTblRef);
+	rtr->rtindex = 1;
+
+	query->rtable = list_make1(subrte);
+	query->jointree = makeFromExpr(list_make1(rtr), NULL);
+	query->targetList = (List *) subquery_columns_mutator((Node *) query->targetList, &colctx);
+	query->havingQual = subquery_columns_mutator(query->havingQual, &colctx);
+}
+
+static bool
+bookend_rewrite_walker(Node *node, Cache *hcache)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Query))
+	{
+		Query	   *query = (Query *) node;
+
+		bookend_rewrite_query(query, hcache);
+
+		return query_tree_walker(query, bookend_rewrite_walker, hcache, 0);
+	}
+
+	return expression_tree_walker(node, bookend_rewrite_walker, hcache);
+}
+
+/*
+ * Rewrite first() and last() aggregates in a query, including its subqueries,
+ * to read only a single row. Must be called before the standard planner.
+ */
+void
+plan_agg_bookend_rewrite(Query *parse, Cache *hcache)
+{
+	bookend_rewrite_walker((Node *) parse, hcache);
+}
@@ -0,0 +1,11 @@
+#ifndef TIMESCALEDB_PLAN_AGG_BOOKEND_H
+#define TIMESCALEDB_PLAN_AGG_BOOKEND_H
+
+#include <postgres.h>
+#include <nodes/parsenodes.h>
+
+#include "cache.h"
+
+extern void plan_agg_bookend_rewrite(Query *parse, Cache *hcache);
+
+#endif							/* TIMESCALEDB_PLAN_AGG_BOOKEND_H */
@@ -0,0 +1,315 @@
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <executor/nodeAgg.h>
+#include <nodes/relation.h>
+#include <optimizer/clauses.h>
+#include <optimizer/cost.h>
+#include <optimizer/pathnode.h>
+#include <optimizer/planner.h>
+#include <optimizer/prep.h>
+#include <optimizer/tlist.h>
+#include <optimizer/var.h>
+#include <utils/selfuncs.h>
+
+#include "plan_chunk_aggregate.h"
+#include "compat.h"
+
+/*
+ * Chunk-wise aggregation.
+ *
+ * For a query like
+ *
+ *	SELECT time_bucket('1 hour', time), device, avg(temp)
+ *	FROM hypertable GROUP BY 1, 2;
+ *
+ * the standard planner aggregates over an Append of the chunks, so every
+ * tuple of every chunk flows through the Append into a single aggregate.
+ * Instead, we can aggregate each chunk on its own with a partial aggregate
+ * and combine the partial results above the Append, the same way a parallel
+ * aggregate combines the results of its workers. Each chunk can then use the
+ * grouping strategy that suits it, e.g., a sorted aggregate over an index of
+ * the chunk, while a hash table only has to hold the groups of one chunk.
+ *
+ * This requires all aggregates to have combine functions, and serialization
+ * functions if their state is internal, as histogram(), first() and last()
+ * do.
+ */
+
+/*
+ * Build the target list of the partial aggregates from the final target list
+ * of the grouping, like make_partial_grouping_target() in PostgreSQL's
+ * planner: the grouping columns, and the aggregates and plain columns that
+ * the final target list and the HAVING clause need.
+ */
+static PathTarget *
+make_partial_grouping_target(PlannerInfo *root, PathTarget *grouping_target)
+{
+	Query	   *parse = root->parse;
+	PathTarget *partial_target = create_empty_pathtarget();
+	List	   *non_group_cols = NIL;
+	List	   *non_group_exprs;
+	ListCell   *lc;
+	int			i = 0;
+
+	foreach(lc, grouping_target->exprs)
+	{
+		Expr	   *expr = lfirst(lc);
+		Index		sgref = get_pathtarget_sortgroupref(grouping_target, i);
+
+		if (sgref && parse->groupClause &&
+			get_sortgroupref_clause_noerr(sgref, parse->groupClause) != NULL)
+			add_column_to_pathtarget(partial_target, expr, sgref);
+		else
+			non_group_cols = lappend(non_group_cols, expr);
+
+		i++;
+	}
+
+	if (parse->havingQual)
+		non_group_cols = lappend(non_group_cols, parse->havingQual);
+
+	non_group_exprs = pull_var_clause((Node *) non_group_cols,
+									  PVC_INCLUDE_AGGREGATES |
+									  PVC_RECURSE_WINDOWFUNCS |
+									  PVC_INCLUDE_PLACEHOLDERS);
+
+	add_new_columns_to_pathtarget(partial_target, non_group_exprs);
+
+	/* The partial aggregates return serialized transition states */
+	foreach(lc, partial_target->exprs)
+	{
+		Aggref	   *aggref = lfirst(lc);
+
+		if (IsA(aggref, Aggref))
+		{
+			Aggref	   *newaggref = makeNode(Aggref);
+
+			memcpy(newaggref, aggref, sizeof(Aggref));
+			mark_partial_aggref(newaggref, AGGSPLIT_INITIAL_SERIAL);
+			lfirst(lc) = newaggref;
+		}
+	}
+
+	return set_pathtarget_cost_width(root, partial_target);
+}
+
+/*
+ * Express a target of the hypertable in terms of a chunk's columns.
+ */
+static PathTarget *
+translate_target(PlannerInfo *root, PathTarget *target, AppendRelInfo *appinfo)
+{
+	PathTarget *chunk_target = copy_pathtarget(target);
+
+	chunk_target->exprs = (List *) adjust_appendrel_attrs(root, (Node *) target->exprs, appinfo);
+
+	return chunk_target;
+}
+
+static AggClauseCosts *
+get_agg_costs(PlannerInfo *root, PathTarget *target, AggSplit aggsplit)
+{
+	AggClauseCosts *costs = palloc0(sizeof(AggClauseCosts));
+
+	get_agg_clause_costs(root, (Node *) target->exprs, aggsplit, costs);
+
+	if (root->parse->havingQual)
+		get_agg_clause_costs(root, root->parse->havingQual, aggsplit, costs);
+
+	return costs;
+}
+
+/*
+ * Check whether the hash table of a hashed aggregate fits in work_mem, like
+ * PostgreSQL does before it considers hashing.
+ */
+static bool
+hash_table_fits(Path *input, AggClauseCosts *costs, double num_groups)
+{
+	Size		entry_size = MAXALIGN(input->pathtarget->width) +
+	MAXALIGN(SizeofMinimalTupleHeader) +
+	costs->transitionSpace +
+	hash_agg_entry_size(costs->numAggs);
+
+	return entry_size * num_groups < work_mem * 1024L;
+}
+
+/*
+ * Create the partial aggregate of a chunk. Hashes the chunk's cheapest path,
+ * or aggregates a path that is already sorted on the grouping columns,
+ * whichever is cheaper. Returns NULL if neither applies.
+ *
+ * Sorting a chunk's path to aggregate it is not an option: the grouping
+ * pathkeys refer to the hypertable's columns, which a Sort of a chunk cannot
+ * resolve.
+ */
+static Path *
+create_chunk_agg_path(PlannerInfo *root, RelOptInfo *chunkrel, PathTarget *input_target,
+					  PathTarget *partial_target, AggClauseCosts *costs, double num_groups)
+{
+	List	   *group_clause = root->parse->groupClause;
+	Path	   *input = create_projection_path(root, chunkrel, chunkrel->cheapest_total_path,
+											   input_target);
+	Path	   *best = NULL;
+	Path	   *sorted;
+
+	if (group_clause == NIL)
+		return (Path *) create_agg_path(root, chunkrel, input, partial_target, AGG_PLAIN,
+										AGGSPLIT_INITIAL_SERIAL, NIL, NIL, costs, 1);
+
+	if (grouping_is_hashable(group_clause) && hash_table_fits(input, costs, num_groups))
+		best = (Path *) create_agg_path(root, chunkrel, input, partial_target, AGG_HASHED,
+										AGGSPLIT_INITIAL_SERIAL, group_clause, NIL,
+										costs, num_groups);
+
+	sorted = get_cheapest_path_for_pathkeys_compat(chunkrel->pathlist, root->group_pathkeys,
+												   NULL, TOTAL_COST);
+
+	if (NULL != sorted)
+	{
+		Path	   *path;
+
+		input = create_projection_path(root, chunkrel, sorted, input_target);
+		path = (Path *) create_agg_path(root, chunkrel, input, partial_target, AGG_SORTED,
+										AGGSPLIT_INITIAL_SERIAL, group_clause, NIL,
+										costs, num_groups);
+
+		if (NULL == best || path->total_cost < best->total_cost)
+			best = path;
+	}
+
+	return best;
+}
+
+/*
+ * Add paths that aggregate each chunk of a hypertable and combine the partial
+ * aggregates above an Append of the chunks.
+ *
+ * Must be called from the create_upper_paths hook for the grouping stage,
+ * when the input relation is the hypertable's append relation.
+ */
+void
+plan_chunk_aggregate_add_paths(PlannerInfo *root, RelOptInfo *input_rel,
+							   RelOptInfo *output_rel, Hypertable *ht)
+{
+	Query	   *parse = root->parse;
+	PathTarget *grouping_target = root->upper_targets[UPPERREL_GROUP_AGG];
+	PathTarget *input_target;
+	PathTarget *partial_target;
+	AggClauseCosts agg_costs;
+	AggClauseCosts *partial_costs;
+	AggClauseCosts *final_costs;
+	List	   *group_exprs = NIL;
+	List	   *subpaths = NIL;
+	double		num_groups = 1;
+	AppendPath *append;
+	bool		has_deferred_data;
+	ListCell   *lc;
+
+	if (parse->groupingSets != NIL ||
+		NULL == grouping_target ||
+		NULL == input_rel->cheapest_total_path)
+		return;
+
+	MemSet(&agg_costs, 0, sizeof(AggClauseCosts));
+	get_agg_clause_costs(root, (Node *) grouping_target->exprs, AGGSPLIT_SIMPLE, &agg_costs);
+
+	if (parse->havingQual)
+		get_agg_clause_costs(root, parse->havingQual, AGGSPLIT_SIMPLE, &agg_costs);
+
+	if (agg_costs.hasNonPartial || agg_costs.hasNonSerial)
+		return;
+
+	/* The scan target with the grouping columns, as computed by the planner */
+	input_target = input_rel->cheapest_total_path->pathtarget;
+	partial_target = make_partial_grouping_target(root, grouping_target);
+	partial_costs = get_agg_costs(root, partial_target, AGGSPLIT_INITIAL_SERIAL);
+	final_costs = get_agg_costs(root, grouping_target, AGGSPLIT_FINAL_DESERIAL);
+
+	if (parse->groupClause != NIL)
+		group_exprs = get_sortgrouplist_exprs(parse->groupClause, parse->targetList);
+
+	has_deferred_data = hypertable_has_deferred_data(ht);
+
+	foreach(lc, root->append_rel_list)
+	{
+		AppendRelInfo *appinfo = lfirst(lc);
+		RelOptInfo *chunkrel;
+		double		chunk_groups = 1;
+		Path	   *path;
+
+		if (appinfo->parent_relid != input_rel->relid)
+			continue;
+
+		chunkrel = root->simple_rel_array[appinfo->child_relid];
+
+		/*
+		 * The main table only holds the tuples of a deferred migration, in
+		 * which case it is aggregated like any chunk
+		 */
+		if (IS_DUMMY_REL(chunkrel) ||
+			(root->simple_rte_array[appinfo->child_relid]->relid == ht->main_table_relid &&
+			 !has_deferred_data))
+			continue;
+
+		if (NULL == chunkrel->cheapest_total_path)
+			return;
+
+		if (group_exprs != NIL)
+			chunk_groups = estimate_num_groups(root,
+											   (List *) adjust_appendrel_attrs(root, (Node *) group_exprs, appinfo),
+											   chunkrel->rows,
+											   NULL);
+
+		path = create_chunk_agg_path(root, chunkrel,
+									 translate_target(root, input_target, appinfo),
+									 translate_target(root, partial_target, appinfo),
+									 partial_costs, chunk_groups);
+
+		/* Every chunk must be aggregated on its own */
+		if (NULL == path)
+			return;
+
+		subpaths = lappend(subpaths, path);
+	}
+
+	if (subpaths == NIL)
+		return;
+
+	append = create_append_path_compat(output_rel, subpaths, NULL, 0);
+	append->path.pathtarget = partial_target;
+
+	if (parse->groupClause == NIL)
+	{
+		add_path(output_rel, (Path *) create_agg_path(root, output_rel, &append->path,
+													  grouping_target, AGG_PLAIN,
+													  AGGSPLIT_FINAL_DESERIAL, NIL,
+													  (List *) parse->havingQual,
+													  final_costs, 1));
+		return;
+	}
+
+	num_groups = estimate_num_groups(root, group_exprs, input_rel->rows, NULL);
+
+	if (grouping_is_hashable(parse->groupClause) &&
+		hash_table_fits(&append->path, final_costs, num_groups))
+		add_path(output_rel, (Path *) create_agg_path(root, output_rel, &append->path,
+													  grouping_target, AGG_HASHED,
+													  AGGSPLIT_FINAL_DESERIAL,
+													  parse->groupClause,
+													  (List *) parse->havingQual,
+													  final_costs, num_groups));
+
+	if (grouping_is_sortable(parse->groupClause))
+	{
+		Path	   *sorted = (Path *) create_sort_path(root, output_rel, &append->path,
+													   root->group_pathkeys, -1.0);
+
+		add_path(output_rel, (Path *) create_agg_path(root, output_rel, sorted,
+													  grouping_target, AGG_SORTED,
+													  AGGSPLIT_FINAL_DESERIAL,
+													  parse->groupClause,
+													  (List *) parse->havingQual,
+													  final_costs, num_groups));
+	}
+}
@@ -0,0 +1,12 @@
+#ifndef TIMESCALEDB_PLAN_CHUNK_AGGREGATE_H
+#define TIMESCALEDB_PLAN_CHUNK_AGGREGATE_H
+
+#include <postgres.h>
+#include <nodes/relation.h>
+
+#include "hypertable.h"
+
+extern void plan_chunk_aggregate_add_paths(PlannerInfo *root, RelOptInfo *input_rel,
+							   RelOptInfo *output_rel, Hypertable *ht);
+
+#endif							/* TIMESCALEDB_PLAN_CHUNK_AGGREGATE_H */
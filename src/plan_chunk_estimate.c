@@ -0,0 +1,155 @@
+#include <postgres.h>
+#include <access/sysattr.h>
+#include <nodes/relation.h>
+#include <optimizer/cost.h>
+#include <optimizer/pathnode.h>
+#include <optimizer/var.h>
+#include <parser/parsetree.h>
+#include <utils/syscache.h>
+
+#include "plan_chunk_estimate.h"
+#include "chunk.h"
+#include "dimension.h"
+#include "hypercube.h"
+#include "hypertable_restrict_info.h"
+#include "compat.h"
+
+/*
+ * Row estimates for chunks without statistics.
+ *
+ * A chunk that has not been analyzed yet, typically the newest one that is
+ * still being written to, has no statistics on its time column. PostgreSQL
+ * then falls back to default selectivities for the query's time range, e.g.,
+ * 0.5% for "time > x AND time < y", no matter how much of the chunk the range
+ * covers. Since the newest chunk is what most queries read, the estimates of
+ * whole join trees can be off by orders of magnitude.
+ *
+ * A chunk's time range is known from its dimension slice, though. Assuming
+ * that the chunk's tuples are spread evenly over its time range, the
+ * selectivity of the restrictions on time is the fraction of the chunk's time
+ * range that they cover.
+ */
+
+static bool
+chunk_has_statistics(Oid relid, AttrNumber attno)
+{
+	return SearchSysCacheExists3(STATRELATTINH,
+								 ObjectIdGetDatum(relid),
+								 Int16GetDatum(attno),
+								 BoolGetDatum(false));
+}
+
+/*
+ * Check whether a restriction only refers to the given column of a relation.
+ */
+static bool
+clause_is_on_column(RestrictInfo *rinfo, Index relid, AttrNumber attno)
+{
+	Bitmapset  *attnos = NULL;
+	int			attnum;
+
+	pull_varattnos((Node *) rinfo->clause, relid, &attnos);
+
+	if (bms_get_singleton_member(attnos, &attnum))
+		return attnum + FirstLowInvalidHeapAttributeNumber == attno;
+
+	return false;
+}
+
+/*
+ * Estimate the rows of a chunk from the fraction of its time range that the
+ * restrictions cover. Returns the new estimate, or -1 if the chunk's own
+ * estimate should be kept.
+ */
+static double
+estimate_chunk_rows(PlannerInfo *root, RelOptInfo *chunkrel, AppendRelInfo *appinfo,
+					Hypertable *ht, Dimension *dim)
+{
+	RangeTblEntry *rte = planner_rt_fetch(chunkrel->relid, root);
+	HypertableRestrictInfo *hri;
+	Var		   *var = list_nth(appinfo->translated_vars, dim->column_attno - 1);
+	Chunk	   *chunk;
+	DimensionSlice *slice;
+	List	   *other_clauses = NIL;
+	bool		restricted = false;
+	ListCell   *lc;
+
+	if (NULL == var || !IsA(var, Var) || chunk_has_statistics(rte->relid, var->varattno))
+		return -1;
+
+	hri = hypertable_restrict_info_create_for_child(ht, appinfo);
+
+	foreach(lc, chunkrel->baserestrictinfo)
+	{
+		RestrictInfo *rinfo = lfirst(lc);
+
+		if (clause_is_on_column(rinfo, chunkrel->relid, var->varattno) &&
+			hypertable_restrict_info_add_qual(hri, (Node *) rinfo))
+			restricted = true;
+		else
+			other_clauses = lappend(other_clauses, rinfo);
+	}
+
+	if (!restricted)
+		return -1;
+
+	chunk = chunk_get_by_relid(rte->relid, ht->space->num_dimensions, false);
+
+	if (NULL == chunk)
+		return -1;
+
+	slice = hypercube_get_slice_by_dimension_id(chunk->cube, dim->fd.id);
+
+	if (NULL == slice)
+		return -1;
+
+	return clamp_row_est(chunkrel->tuples *
+						 hypertable_restrict_info_slice_fraction(hri, slice) *
+						 clauselist_selectivity(root, other_clauses, chunkrel->relid,
+												JOIN_INNER, NULL));
+}
+
+/*
+ * Replace the row estimates of a hypertable's chunks that have no statistics
+ * on the time column, and adjust the estimate of the hypertable accordingly.
+ *
+ * Must be called from the set_rel_pathlist hook for the hypertable's main
+ * table, which is the first child of the append relation. The sizes of all
+ * children are estimated by then, but the other children have no paths yet,
+ * so their paths are built with the new estimates.
+ */
+void
+plan_chunk_estimate_rows(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht)
+{
+	Dimension  *dim = hyperspace_get_open_dimension(ht->space, 0);
+	AppendRelInfo *main_appinfo = find_childrel_appendrelinfo(root, rel);
+	RelOptInfo *parent = root->simple_rel_array[main_appinfo->parent_relid];
+	ListCell   *lc;
+
+	if (NULL == dim)
+		return;
+
+	foreach(lc, root->append_rel_list)
+	{
+		AppendRelInfo *appinfo = lfirst(lc);
+		RelOptInfo *chunkrel;
+		double		rows;
+
+		if (appinfo->parent_relid != main_appinfo->parent_relid ||
+			appinfo->child_relid == rel->relid)
+			continue;
+
+		chunkrel = root->simple_rel_array[appinfo->child_relid];
+
+		if (NULL == chunkrel || IS_DUMMY_REL(chunkrel))
+			continue;
+
+		rows = estimate_chunk_rows(root, chunkrel, appinfo, ht, dim);
+
+		if (rows < 0)
+			continue;
+
+		parent->rows = clamp_row_est(parent->rows + rows - chunkrel->rows);
+		chunkrel->rows = rows;
+	}
+}
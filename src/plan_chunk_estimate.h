@@ -0,0 +1,11 @@
+#ifndef TIMESCALEDB_PLAN_CHUNK_ESTIMATE_H
+#define TIMESCALEDB_PLAN_CHUNK_ESTIMATE_H
+
+#include <postgres.h>
+#include <nodes/relation.h>
+
+#include "hypertable.h"
+
+extern void plan_chunk_estimate_rows(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht);
+
+#endif							/* TIMESCALEDB_PLAN_CHUNK_ESTIMATE_H */
@@ -0,0 +1,368 @@
+#include <postgres.h>
+#include <access/heapam.h>
+#include <catalog/pg_class.h>
+#include <nodes/makefuncs.h>
+#include <nodes/nodeFuncs.h>
+#include <optimizer/pathnode.h>
+#include <parser/parsetree.h>
+#include <storage/lmgr.h>
+#include <utils/rel.h>
+#include <utils/syscache.h>
+
+#include "plan_expand_hypertable.h"
+#include "hypertable_cache.h"
+#include "hypertable_restrict_info.h"
+#include "chunk.h"
+#include "compat.h"
+
+/*
+ * Plan-time chunk exclusion.
+ *
+ * PostgreSQL expands a hypertable into its chunks the same way it expands
+ * any inheritance parent: expand_inherited_tables() locks and opens every
+ * chunk, and constraint exclusion then tries to refute the query's
+ * restrictions against each chunk's CHECK constraints. Both steps are linear
+ * in the number of chunks, even when the query only touches a few of them.
+ *
+ * Instead, we mark hypertables in the query as not inherited before the
+ * standard planner runs, so that PostgreSQL leaves them alone. When the
+ * planner later builds the hypertable's RelOptInfo, we look up the chunks
+ * whose dimension slices match the query's restrictions in the catalog, and
+ * expand the hypertable into only those chunks. Only matching chunks are
+ * locked and opened, and only the slices in the restricted ranges are read.
+ * The expansion mimics expand_inherited_rtentry(), so the rest of the planner
+ * sees a regular append relation. Standard constraint exclusion still runs on
+ * the remaining chunks.
+ */
+
+/*
+ * Marker for range table entries we expand ourselves. The CTE name is unused
+ * for relation RTEs, so it is free to carry the marker.
+ */
+#define TS_CTE_EXPAND "ts_expand"
+
+static bool
+mark_hypertables_walker(Node *node, Cache *hcache)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Query))
+	{
+		Query	   *query = (Query *) node;
+		ListCell   *lc;
+		Index		rti = 0;
+
+		/*
+		 * UPDATE and DELETE expand their target through inheritance_planner()
+		 * and add row marks for the other relations, so leave those queries
+		 * to the standard planner. Their result chunks are excluded by
+		 * plan_expand_hypertable_exclude_result_chunk() instead.
+		 */
+		if (query->commandType == CMD_UPDATE || query->commandType == CMD_DELETE)
+			return false;
+
+		foreach(lc, query->rtable)
+		{
+			RangeTblEntry *rte = lfirst(lc);
+
+			rti++;
+
+			if (rte->rtekind != RTE_RELATION ||
+				!rte->inh ||
+				rte->relkind != RELKIND_RELATION ||
+				rte->securityQuals != NIL ||
+				get_parse_rowmark(query, rti) != NULL)
+				continue;
+
+			if (hypertable_cache_get_entry(hcache, rte->relid) == NULL)
+				continue;
+
+			rte->inh = false;
+			rte->ctename = TS_CTE_EXPAND;
+		}
+
+		return query_tree_walker(query, mark_hypertables_walker, hcache, 0);
+	}
+
+	return expression_tree_walker(node, mark_hypertables_walker, hcache);
+}
+
+/*
+ * Mark all hypertables in a query, including its subqueries, for expansion
+ * by plan_expand_hypertable_chunks(). Must be called before the standard
+ * planner.
+ */
+void
+plan_expand_hypertable_mark(Query *parse, Cache *hcache)
+{
+	mark_hypertables_walker((Node *) parse, hcache);
+}
+
+bool
+plan_expand_hypertable_is_marked(RangeTblEntry *rte)
+{
+	return rte->rtekind == RTE_RELATION &&
+		rte->ctename != NULL &&
+		strcmp(rte->ctename, TS_CTE_EXPAND) == 0;
+}
+
+/*
+ * Build the translation list of a chunk's columns, like
+ * make_inh_translation_list() does for inheritance children. Chunks normally
+ * have the same columns as the hypertable, but the attribute numbers can
+ * differ after columns have been dropped.
+ */
+static List *
+make_chunk_translation_list(Relation oldrelation, Relation newrelation, Index newvarno)
+{
+	TupleDesc	old_tupdesc = RelationGetDescr(oldrelation);
+	TupleDesc	new_tupdesc = RelationGetDescr(newrelation);
+	List	   *vars = NIL;
+	int			old_attno;
+
+	for (old_attno = 0; old_attno < old_tupdesc->natts; old_attno++)
+	{
+		Form_pg_attribute att = old_tupdesc->attrs[old_attno];
+		Form_pg_attribute newatt = NULL;
+		int			new_attno;
+
+		if (att->attisdropped)
+		{
+			/* Just put NULL into this list entry */
+			vars = lappend(vars, NULL);
+			continue;
+		}
+
+		/* Check the same position first, since columns usually line up */
+		if (old_attno < new_tupdesc->natts)
+		{
+			newatt = new_tupdesc->attrs[old_attno];
+
+			if (newatt->attisdropped ||
+				strcmp(NameStr(att->attname), NameStr(newatt->attname)) != 0)
+				newatt = NULL;
+		}
+
+		if (NULL != newatt)
+			new_attno = old_attno;
+		else
+		{
+			for (new_attno = 0; new_attno < new_tupdesc->natts; new_attno++)
+			{
+				newatt = new_tupdesc->attrs[new_attno];
+
+				if (!newatt->attisdropped &&
+					strcmp(NameStr(att->attname), NameStr(newatt->attname)) == 0)
+					break;
+			}
+
+			if (new_attno >= new_tupdesc->natts)
+				elog(ERROR, "could not find inherited attribute \"%s\" of relation \"%s\"",
+					 NameStr(att->attname), RelationGetRelationName(newrelation));
+		}
+
+		if (att->atttypid != newatt->atttypid || att->atttypmod != newatt->atttypmod)
+			elog(ERROR, "attribute \"%s\" of relation \"%s\" does not match parent's type",
+				 NameStr(att->attname), RelationGetRelationName(newrelation));
+
+		if (att->attcollation != newatt->attcollation)
+			elog(ERROR, "attribute \"%s\" of relation \"%s\" does not match parent's collation",
+				 NameStr(att->attname), RelationGetRelationName(newrelation));
+
+		vars = lappend(vars, makeVar(newvarno,
+									 (AttrNumber) (new_attno + 1),
+									 att->atttypid,
+									 att->atttypmod,
+									 att->attcollation,
+									 0));
+	}
+
+	return vars;
+}
+
+/*
+ * Expand a marked hypertable into the chunks that match the query's
+ * restrictions.
+ *
+ * Called from the get_relation_info hook while the planner builds the
+ * hypertable's RelOptInfo. Like expand_inherited_rtentry(), the hypertable's
+ * main table is included as the first child, and the chunks follow in OID
+ * order. If the hypertable has no chunks at all, it is left as a plain
+ * relation.
+ */
+void
+plan_expand_hypertable_chunks(Hypertable *ht, PlannerInfo *root, RelOptInfo *rel)
+{
+	Query	   *parse = root->parse;
+	RangeTblEntry *rte = planner_rt_fetch(rel->relid, root);
+	Oid			parent_oid = rte->relid;
+	HypertableRestrictInfo *hri;
+	List	   *chunks;
+	List	   *inh_oids;
+	List	   *appinfos = NIL;
+	Relation	oldrelation;
+	ListCell   *lc;
+	int			new_size;
+
+	Assert(plan_expand_hypertable_is_marked(rte));
+
+	/* Clear the marker before the children copy the entry */
+	rte->ctename = NULL;
+
+	hri = hypertable_restrict_info_create(ht, rel->relid);
+	hypertable_restrict_info_add_jointree(hri, (Node *) parse->jointree);
+
+	chunks = hypertable_restrict_info_get_chunks(hri, ht);
+
+	if (chunks == NIL && !chunk_exists_for_hypertable(ht->fd.id))
+		return;
+
+	inh_oids = list_make1_oid(parent_oid);
+
+	foreach(lc, chunks)
+	{
+		Chunk	   *chunk = lfirst(lc);
+
+		if (!OidIsValid(chunk->table_id))
+			continue;
+
+		/*
+		 * Lock the chunk and make sure it still exists, like
+		 * find_all_inheritors() does for inheritance children.
+		 */
+		LockRelationOid(chunk->table_id, AccessShareLock);
+
+		if (!SearchSysCacheExists1(RELOID, ObjectIdGetDatum(chunk->table_id)))
+		{
+			UnlockRelationOid(chunk->table_id, AccessShareLock);
+			continue;
+		}
+
+		inh_oids = lappend_oid(inh_oids, chunk->table_id);
+	}
+
+	/* Make room for the children in the planner's relation arrays */
+	new_size = list_length(parse->rtable) + list_length(inh_oids) + 1;
+	root->simple_rel_array = repalloc(root->simple_rel_array,
+									  sizeof(RelOptInfo *) * new_size);
+	root->simple_rte_array = repalloc(root->simple_rte_array,
+									  sizeof(RangeTblEntry *) * new_size);
+	MemSet(root->simple_rel_array + root->simple_rel_array_size, 0,
+		   sizeof(RelOptInfo *) * (new_size - root->simple_rel_array_size));
+	MemSet(root->simple_rte_array + root->simple_rel_array_size, 0,
+		   sizeof(RangeTblEntry *) * (new_size - root->simple_rel_array_size));
+	root->simple_rel_array_size = new_size;
+
+	oldrelation = heap_open(parent_oid, NoLock);
+
+	foreach(lc, inh_oids)
+	{
+		Oid			child_oid = lfirst_oid(lc);
+		Relation	newrelation;
+		RangeTblEntry *childrte;
+		Index		child_rtindex;
+		AppendRelInfo *appinfo;
+
+		if (child_oid == parent_oid)
+			newrelation = oldrelation;
+		else
+			newrelation = heap_open(child_oid, NoLock);
+
+		childrte = copyObject(rte);
+		childrte->relid = child_oid;
+		childrte->relkind = newrelation->rd_rel->relkind;
+		childrte->inh = false;
+		childrte->requiredPerms = 0;
+		childrte->securityQuals = NIL;
+		parse->rtable = lappend(parse->rtable, childrte);
+		child_rtindex = list_length(parse->rtable);
+		root->simple_rte_array[child_rtindex] = childrte;
+
+		appinfo = makeNode(AppendRelInfo);
+		appinfo->parent_relid = rel->relid;
+		appinfo->child_relid = child_rtindex;
+		appinfo->parent_reltype = oldrelation->rd_rel->reltype;
+		appinfo->child_reltype = newrelation->rd_rel->reltype;
+		appinfo->translated_vars = make_chunk_translation_list(oldrelation, newrelation,
+															   child_rtindex);
+		appinfo->parent_reloid = parent_oid;
+		appinfos = lappend(appinfos, appinfo);
+
+		if (newrelation != oldrelation)
+			heap_close(newrelation, NoLock);
+	}
+
+	heap_close(oldrelation, NoLock);
+
+	/*
+	 * The list might be shared with a copied PlannerInfo, e.g., when planning
+	 * MIN/MAX aggregates, so do not append to it in place.
+	 */
+	root->append_rel_list = list_concat(list_copy(root->append_rel_list), appinfos);
+
+	/*
+	 * The hypertable is now an append relation parent. The planner builds the
+	 * children's RelOptInfos after this hook returns. Reset what
+	 * get_relation_info() filled in for a plain relation, since the parent
+	 * is only scanned as its own child.
+	 */
+	rte->inh = true;
+	rel->indexlist = NIL;
+	rel->pages = 0;
+	rel->tuples = 0;
+	rel->allvisfrac = 0;
+}
+
+/*
+ * Exclude a chunk that is planned as the result relation of an UPDATE or
+ * DELETE on its hypertable, if it cannot hold tuples matching the query's
+ * restrictions.
+ *
+ * PostgreSQL plans UPDATE and DELETE on an inheritance parent in
+ * inheritance_planner(), which expands the parent into all of its children
+ * and plans the query once for each child as the result relation. We cannot
+ * expand the hypertable ourselves there, but we can prove a chunk empty
+ * before any paths are built for it. The chunk is then left out of the
+ * ModifyTable, the same way as a child that is excluded by constraint
+ * exclusion, which cannot refute restrictions on space dimensions or
+ * relative to now().
+ *
+ * Called from the get_relation_info hook. Returns true if the chunk was
+ * excluded.
+ */
+bool
+plan_expand_hypertable_exclude_result_chunk(Hypertable *ht, PlannerInfo *root,
+											RelOptInfo *rel, AppendRelInfo *appinfo)
+{
+	RangeTblEntry *rte = planner_rt_fetch(rel->relid, root);
+	HypertableRestrictInfo *hri;
+	Chunk	   *chunk;
+
+	/* The main table is planned as a child too */
+	if (rte->relid == ht->main_table_relid)
+		return false;
+
+	chunk = chunk_get_by_relid(rte->relid, ht->space->num_dimensions, false);
+
+	if (NULL == chunk)
+		return false;
+
+	hri = hypertable_restrict_info_create_for_child(ht, appinfo);
+	hypertable_restrict_info_add_jointree(hri, (Node *) root->parse->jointree);
+
+	if (hypertable_restrict_info_matches_cube(hri, chunk->cube))
+		return false;
+
+	/*
+	 * Mark the chunk as proven empty, like set_dummy_rel_pathlist() does.
+	 * set_rel_pathlist() then builds no paths for it.
+	 */
+	rel->rows = 0;
+	rel->pathlist = NIL;
+	rel->partial_pathlist = NIL;
+	add_path(rel, (Path *) create_append_path_compat(rel, NIL, NULL, 0));
+	set_cheapest(rel);
+
+	return true;
+}
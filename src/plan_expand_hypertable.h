@@ -0,0 +1,17 @@
+#ifndef TIMESCALEDB_PLAN_EXPAND_HYPERTABLE_H
+#define TIMESCALEDB_PLAN_EXPAND_HYPERTABLE_H
+
+#include <postgres.h>
+#include <nodes/parsenodes.h>
+#include <nodes/relation.h>
+
+#include "cache.h"
+#include "hypertable.h"
+
+extern void plan_expand_hypertable_mark(Query *parse, Cache *hcache);
+extern bool plan_expand_hypertable_is_marked(RangeTblEntry *rte);
+extern void plan_expand_hypertable_chunks(Hypertable *ht, PlannerInfo *root, RelOptInfo *rel);
+extern bool plan_expand_hypertable_exclude_result_chunk(Hypertable *ht, PlannerInfo *root,
+											RelOptInfo *rel, AppendRelInfo *appinfo);
+
+#endif							/* TIMESCALEDB_PLAN_EXPAND_HYPERTABLE_H */
@@ -0,0 +1,403 @@
+#include <postgres.h>
+#include <access/stratnum.h>
+#include <catalog/pg_aggregate.h>
+#include <catalog/pg_type.h>
+#include <nodes/makefuncs.h>
+#include <nodes/nodeFuncs.h>
+#include <nodes/relation.h>
+#include <optimizer/clauses.h>
+#include <optimizer/pathnode.h>
+#include <optimizer/planmain.h>
+#include <optimizer/planner.h>
+#include <optimizer/subselect.h>
+#include <optimizer/var.h>
+#include <parser/parse_func.h>
+#include <parser/parsetree.h>
+#include <rewrite/rewriteManip.h>
+#include <utils/lsyscache.h>
+
+#include "plan_join_exclusion.h"
+#include "dimension.h"
+
+/*
+ * Chunk exclusion on join clauses.
+ *
+ * A join clause like "h.time BETWEEN o.start AND o.stop" excludes no chunks
+ * at planning time, and at run time only if the hypertable is the
+ * parameterized inner side of a nested loop. Otherwise, e.g., in a hash join
+ * or with the hypertable on the outer side, all chunks are scanned, even if
+ * the other relation only covers a short time range.
+ *
+ * If a query has only inner joins, every output row satisfies all join
+ * clauses, so only hypertable rows within the range of the other relation's
+ * join keys can join. The clauses above imply
+ * "h.time >= (SELECT min(start) FROM o)" and
+ * "h.time <= (SELECT max(stop) FROM o)", with o's restrictions applied. Such
+ * bounds are computed by initplans and handed to ConstraintAwareAppend as
+ * additional exclusion clauses, which prune the chunks outside of the bounds
+ * before they are scanned.
+ */
+
+typedef struct JoinBound
+{
+	Var		   *var;			/* the hypertable's time column */
+	Expr	   *expr;			/* the join key of the other relation */
+	Index		relid;			/* the other relation */
+	Oid			opno;			/* operator of "var OP bound" */
+	bool		use_max;		/* bound by max(expr), otherwise min(expr) */
+} JoinBound;
+
+static bool
+is_time_var(Node *node, Index relid, AttrNumber attno)
+{
+	Var		   *var = (Var *) node;
+
+	return IsA(node, Var) &&
+		var->varno == relid &&
+		var->varattno == attno &&
+		var->varlevelsup == 0;
+}
+
+static bool
+contain_nonlocal_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Param))
+		return ((Param *) node)->paramkind == PARAM_EXEC;
+
+	if (IsA(node, Var))
+		return ((Var *) node)->varlevelsup > 0;
+
+	if (IsA(node, PlaceHolderVar) ||
+		IsA(node, SubPlan) ||
+		IsA(node, AlternativeSubPlan) ||
+		IsA(node, Aggref) ||
+		IsA(node, WindowFunc))
+		return true;
+
+	return expression_tree_walker(node, contain_nonlocal_walker, context);
+}
+
+/*
+ * An expression can be computed in a separate subquery if it only references
+ * the relation it is computed on and gives the same result every time.
+ */
+static bool
+expr_is_bound_safe(Expr *expr)
+{
+	return !contain_volatile_functions((Node *) expr) &&
+		!contain_nonlocal_walker((Node *) expr, NULL);
+}
+
+/*
+ * Check that the rows of a relation in a subquery are the same as in the
+ * query, i.e., a plain table with restrictions that only reference itself.
+ */
+static bool
+bound_relation_is_valid(PlannerInfo *root, int relid, Index ht_relid)
+{
+	RelOptInfo *rel;
+	RangeTblEntry *rte;
+	ListCell   *lc;
+
+	if (relid == ht_relid || relid >= root->simple_rel_array_size)
+		return false;
+
+	rel = root->simple_rel_array[relid];
+	rte = root->simple_rte_array[relid];
+
+	if (NULL == rel ||
+		rel->reloptkind != RELOPT_BASEREL ||
+		IS_DUMMY_REL(rel) ||
+		rte->rtekind != RTE_RELATION ||
+		rte->lateral ||
+		rte->tablesample != NULL ||
+		rte->securityQuals != NIL)
+		return false;
+
+	foreach(lc, rel->baserestrictinfo)
+	{
+		RestrictInfo *rinfo = lfirst(lc);
+
+		if (!expr_is_bound_safe(rinfo->clause))
+			return false;
+	}
+
+	return true;
+}
+
+static JoinBound *
+join_bound_create(Var *var, Expr *expr, int relid, Oid opno, bool use_max)
+{
+	JoinBound  *bound = palloc(sizeof(JoinBound));
+
+	bound->var = var;
+	bound->expr = expr;
+	bound->relid = relid;
+	bound->opno = opno;
+	bound->use_max = use_max;
+
+	return bound;
+}
+
+/*
+ * Get the bounds implied by a join clause "time OP expr" (or its commuted
+ * form), where expr only references one other relation.
+ */
+static List *
+join_clause_bounds(PlannerInfo *root, Index ht_relid, AttrNumber attno,
+				   RestrictInfo *rinfo, Relids required_outer)
+{
+	OpExpr	   *op = (OpExpr *) rinfo->clause;
+	Node	   *var;
+	Node	   *expr;
+	Oid			opno;
+	int			relid;
+	ListCell   *lc;
+
+	if (!IsA(op, OpExpr) || list_length(op->args) != 2)
+		return NIL;
+
+	var = linitial(op->args);
+	expr = lsecond(op->args);
+	opno = op->opno;
+
+	if (!is_time_var(var, ht_relid, attno))
+	{
+		if (!is_time_var(expr, ht_relid, attno))
+			return NIL;
+
+		var = lsecond(op->args);
+		expr = linitial(op->args);
+		opno = get_commutator(opno);
+
+		if (!OidIsValid(opno))
+			return NIL;
+	}
+
+	if (!bms_get_singleton_member(pull_varnos(expr), &relid) ||
+		bms_is_member(relid, required_outer) ||
+		!bound_relation_is_valid(root, relid, ht_relid) ||
+		!expr_is_bound_safe((Expr *) expr))
+		return NIL;
+
+	foreach(lc, get_op_btree_interpretation(opno))
+	{
+		OpBtreeInterpretation *interp = lfirst(lc);
+
+		switch (interp->strategy)
+		{
+			case BTLessStrategyNumber:
+			case BTLessEqualStrategyNumber:
+				return list_make1(join_bound_create((Var *) var, (Expr *) expr, relid, opno, true));
+			case BTGreaterStrategyNumber:
+			case BTGreaterEqualStrategyNumber:
+				return list_make1(join_bound_create((Var *) var, (Expr *) expr, relid, opno, false));
+			default:
+				break;
+		}
+	}
+
+	return NIL;
+}
+
+/*
+ * Get the bounds implied by an equivalence class that equates the time column
+ * with an expression of another relation. Equality join clauses are not in
+ * the relation's joininfo, but only in such classes.
+ */
+static List *
+equivalence_class_bounds(PlannerInfo *root, Index ht_relid, AttrNumber attno,
+						 EquivalenceClass *ec, Relids required_outer)
+{
+	Var		   *var = NULL;
+	EquivalenceMember *other = NULL;
+	int			relid = 0;
+	ListCell   *lc;
+
+	if (ec->ec_has_const ||
+		ec->ec_has_volatile ||
+		ec->ec_below_outer_join ||
+		!bms_is_member(ht_relid, ec->ec_relids))
+		return NIL;
+
+	foreach(lc, ec->ec_members)
+	{
+		EquivalenceMember *em = lfirst(lc);
+
+		if (em->em_is_child || em->em_is_const)
+			continue;
+
+		if (is_time_var((Node *) em->em_expr, ht_relid, attno))
+			var = (Var *) em->em_expr;
+		else if (NULL == other &&
+				 bms_get_singleton_member(em->em_relids, &relid) &&
+				 !bms_is_member(relid, required_outer) &&
+				 bound_relation_is_valid(root, relid, ht_relid) &&
+				 expr_is_bound_safe(em->em_expr))
+			other = em;
+	}
+
+	if (NULL == var || NULL == other)
+		return NIL;
+
+	foreach(lc, ec->ec_opfamilies)
+	{
+		Oid			opfamily = lfirst_oid(lc);
+		Oid			lefttype = exprType((Node *) var);
+		Oid			righttype = exprType((Node *) other->em_expr);
+		Oid			ge_opno = get_opfamily_member(opfamily, lefttype, righttype,
+												  BTGreaterEqualStrategyNumber);
+		Oid			le_opno = get_opfamily_member(opfamily, lefttype, righttype,
+												  BTLessEqualStrategyNumber);
+
+		if (OidIsValid(ge_opno) && OidIsValid(le_opno))
+			return list_make2(join_bound_create(var, other->em_expr, relid, ge_opno, false),
+							  join_bound_create(var, other->em_expr, relid, le_opno, true));
+	}
+
+	return NIL;
+}
+
+/*
+ * Get the bounds on the time dimension of a hypertable that the join clauses
+ * of a query imply. Clauses with the relations a path is parameterized by
+ * already exclude chunks on each rescan, so they are left out.
+ */
+static List *
+get_join_bounds(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht, Relids required_outer)
+{
+	Dimension  *dim = hyperspace_get_open_dimension(ht->space, 0);
+	List	   *bounds = NIL;
+	ListCell   *lc;
+
+	/* Outer, semi, and anti joins do not remove every row that fails a clause */
+	if (NULL == dim || root->join_info_list != NIL)
+		return NIL;
+
+	foreach(lc, rel->joininfo)
+		bounds = list_concat(bounds, join_clause_bounds(root, rel->relid, dim->column_attno,
+														lfirst(lc), required_outer));
+
+	foreach(lc, root->eq_classes)
+		bounds = list_concat(bounds, equivalence_class_bounds(root, rel->relid, dim->column_attno,
+															  lfirst(lc), required_outer));
+
+	return bounds;
+}
+
+/*
+ * Plan the initplan "SELECT min(expr) FROM other WHERE <other's restrictions>"
+ * (or max) that computes a bound. Returns the parameter that holds the bound,
+ * or NULL if computing the bound is at least as expensive as the scan it is
+ * supposed to make cheaper.
+ */
+static Param *
+plan_join_bound(PlannerInfo *root, JoinBound *bound, Cost max_cost)
+{
+	RelOptInfo *rel = find_base_rel(root, bound->relid);
+	Query	   *query = makeNode(Query);
+	RangeTblRef *rtr = makeNode(RangeTblRef);
+	Aggref	   *aggref = makeNode(Aggref);
+	Expr	   *expr = copyObject(bound->expr);
+	Oid			argtype = exprType((Node *) expr);
+	List	   *quals = NIL;
+	PlannerInfo *subroot;
+	RelOptInfo *final_rel;
+	Param	   *param;
+	Plan	   *plan;
+	Oid			aggfnoid;
+	ListCell   *lc;
+
+	aggfnoid = LookupFuncName(list_make2(makeString("pg_catalog"),
+										 makeString(bound->use_max ? "max" : "min")),
+							  1, &argtype, true);
+
+	if (!OidIsValid(aggfnoid))
+		return NULL;
+
+	foreach(lc, rel->baserestrictinfo)
+		quals = lappend(quals, copyObject(((RestrictInfo *) lfirst(lc))->clause));
+
+	/* The other relation is the only one in the subquery */
+	ChangeVarNodes((Node *) expr, bound->relid, 1, 0);
+	ChangeVarNodes((Node *) quals, bound->relid, 1, 0);
+	rtr->rtindex = 1;
+
+	aggref->aggfnoid = aggfnoid;
+	aggref->aggtype = get_func_rettype(aggfnoid);
+	aggref->aggcollid = exprCollation((Node *) expr);
+	aggref->inputcollid = exprCollation((Node *) expr);
+	aggref->aggtranstype = InvalidOid;	/* set by the planner */
+	aggref->aggargtypes = list_make1_oid(argtype);
+	aggref->args = list_make1(makeTargetEntry(expr, 1, NULL, false));
+	aggref->aggkind = AGGKIND_NORMAL;
+	aggref->aggsplit = AGGSPLIT_SIMPLE;
+	aggref->location = -1;
+
+	query->commandType = CMD_SELECT;
+	query->canSetTag = true;
+	query->hasAggs = true;
+	query->rtable = list_make1(copyObject(planner_rt_fetch(bound->relid, root)));
+	query->jointree = makeFromExpr(list_make1(rtr),
+								   quals == NIL ? NULL : (Node *) make_ands_explicit(quals));
+	query->targetList = list_make1(makeTargetEntry((Expr *) aggref, 1, "bound", false));
+
+	subroot = subquery_planner(root->glob, query, root, false, 0.0);
+	final_rel = fetch_upper_rel(subroot, UPPERREL_FINAL, NULL);
+
+	if (final_rel->cheapest_total_path->total_cost >= max_cost)
+		return NULL;
+
+	plan = create_plan(subroot, final_rel->cheapest_total_path);
+	param = SS_make_initplan_output_param(root, aggref->aggtype, -1, aggref->aggcollid);
+	SS_make_initplan_from_plan(root, subroot, plan, param);
+
+	return param;
+}
+
+/*
+ * Check if the join clauses of a query imply bounds on the time dimension of
+ * a hypertable that can exclude chunks of the given path at run time.
+ */
+bool
+plan_join_exclusion_applicable(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht, Path *path)
+{
+	return get_join_bounds(root, rel, ht, PATH_REQ_OUTER(path)) != NIL;
+}
+
+/*
+ * Create the initplans that compute the bounds on the time dimension of a
+ * hypertable implied by the join clauses of a query. Returns the clauses
+ * "time OP $n" that the bounds imply, in terms of the hypertable's main
+ * table.
+ *
+ * The bounds are only worth computing if that is cheaper than scanning the
+ * chunks of the path.
+ */
+List *
+plan_join_exclusion_clauses(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht, Path *path)
+{
+	List	   *clauses = NIL;
+	ListCell   *lc;
+
+	foreach(lc, get_join_bounds(root, rel, ht, PATH_REQ_OUTER(path)))
+	{
+		JoinBound  *bound = lfirst(lc);
+		Param	   *param = plan_join_bound(root, bound, path->total_cost);
+		Expr	   *clause;
+
+		if (NULL == param)
+			continue;
+
+		clause = make_opclause(bound->opno, BOOLOID, false,
+							   (Expr *) copyObject(bound->var), (Expr *) param,
+							   InvalidOid, bound->var->varcollid);
+		fix_opfuncids((Node *) clause);
+		clauses = lappend(clauses, clause);
+	}
+
+	return clauses;
+}
@@ -0,0 +1,12 @@
+#ifndef TIMESCALEDB_PLAN_JOIN_EXCLUSION_H
+#define TIMESCALEDB_PLAN_JOIN_EXCLUSION_H
+
+#include <postgres.h>
+#include <nodes/relation.h>
+
+#include "hypertable.h"
+
+extern bool plan_join_exclusion_applicable(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht, Path *path);
+extern List *plan_join_exclusion_clauses(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht, Path *path);
+
+#endif							/* TIMESCALEDB_PLAN_JOIN_EXCLUSION_H */
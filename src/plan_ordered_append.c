@@ -0,0 +1,259 @@
+#include <postgres.h>
+#include <access/stratnum.h>
+#include <nodes/relation.h>
+#include <optimizer/pathnode.h>
+#include <optimizer/paths.h>
+#include <utils/typcache.h>
+
+#include "plan_ordered_append.h"
+#include "chunk.h"
+#include "dimension.h"
+#include "dimension_slice.h"
+#include "hypercube.h"
+#include "sort_transform.h"
+#include "compat.h"
+
+/*
+ * Ordered append of chunks.
+ *
+ * For a query like
+ *
+ *	SELECT * FROM hypertable ORDER BY time DESC LIMIT 10;
+ *
+ * the standard planner merges the ordered scans of all chunks with a
+ * MergeAppend. A MergeAppend has to fetch the first tuple of every child
+ * before it can return anything, so each chunk is touched even though the
+ * LIMIT is satisfied by the latest chunk alone.
+ *
+ * Chunks do not overlap in time, unless they are in different partitions of
+ * another dimension. Scanning the chunks in the order of their time slices
+ * with a plain Append therefore returns the tuples in time order, and the
+ * Append stops after the first chunks once the LIMIT is reached. Chunks whose
+ * time slices overlap are merged with a MergeAppend below the Append.
+ *
+ * The same applies to a query like
+ *
+ *	SELECT time_bucket('1 hour', time) AS hour, avg(temp)
+ *	FROM hypertable GROUP BY hour;
+ *
+ * where the ordered Append, via the sort transform of time_bucket(), lets
+ * the planner aggregate the groups one after another with a GroupAggregate,
+ * without a Sort or a hash table over the whole time range.
+ */
+
+typedef struct OrderedChild
+{
+	Path	   *path;
+	DimensionSlice *slice;
+	int			index;
+} OrderedChild;
+
+static int
+ordered_child_cmp(const void *left, const void *right)
+{
+	const OrderedChild *l = *((const OrderedChild **) left);
+	const OrderedChild *r = *((const OrderedChild **) right);
+
+	if (l->slice->fd.range_start < r->slice->fd.range_start)
+		return -1;
+	if (l->slice->fd.range_start > r->slice->fd.range_start)
+		return 1;
+
+	/* Keep chunks in the same time slice in append relation order */
+	return l->index - r->index;
+}
+
+/*
+ * Check whether a pathkey orders on the hypertable's time dimension, either
+ * on the column itself or on an expression that sort_transform.c knows to
+ * preserve the column's order, e.g., time_bucket() or date_trunc(). Sets
+ * "direct" to indicate the former.
+ */
+static bool
+pathkey_is_time_dimension(PathKey *pk, Dimension *dim, Index relid, bool *direct)
+{
+	TypeCacheEntry *tce = lookup_type_cache(dim->fd.column_type, TYPECACHE_BTREE_OPFAMILY);
+	ListCell   *lc;
+
+	if (pk->pk_opfamily != tce->btree_opf ||
+		(pk->pk_strategy != BTLessStrategyNumber &&
+		 pk->pk_strategy != BTGreaterStrategyNumber))
+		return false;
+
+	foreach(lc, pk->pk_eclass->ec_members)
+	{
+		EquivalenceMember *em = lfirst(lc);
+		Expr	   *expr = em->em_expr;
+		bool		transformed = false;
+
+		if (em->em_is_child)
+			continue;
+
+		while (!IsA(expr, Var))
+		{
+			Expr	   *new_expr = sort_transform_expr(expr);
+
+			if (new_expr == expr)
+				break;
+
+			expr = new_expr;
+			transformed = true;
+		}
+
+		if (IsA(expr, Var) &&
+			((Var *) expr)->varno == relid &&
+			((Var *) expr)->varlevelsup == 0 &&
+			((Var *) expr)->varattno == dim->column_attno)
+		{
+			*direct = !transformed;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Add an Append path that scans the chunks of a hypertable in time order.
+ *
+ * Applies to queries that have a LIMIT or a GROUP BY, and whose leading sort
+ * key is the hypertable's time dimension. For a GROUP BY, the query pathkeys
+ * are those of the grouping. Must be called from the set_rel_pathlist hook
+ * for the hypertable's append relation, after the children's paths are set.
+ */
+void
+plan_ordered_append_add_path(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht)
+{
+	Dimension  *dim = hyperspace_get_open_dimension(ht->space, 0);
+	List	   *pathkeys = root->query_pathkeys;
+	PathKey    *pk;
+	bool		direct;
+	HTAB	   *chunk_htab;
+	OrderedChild **children;
+	int			num_children = 0;
+	List	   *subpaths = NIL;
+	List	   *group = NIL;
+	int64		group_end = 0;
+	AppendPath *append;
+	ListCell   *lc;
+	int			i;
+
+	if (NULL == dim ||
+		(NULL == root->parse->limitCount &&
+		 (NIL == root->parse->groupClause || NIL != root->parse->groupingSets)) ||
+		NIL == pathkeys ||
+		!bms_is_empty(rel->lateral_relids))
+		return;
+
+	pk = linitial(pathkeys);
+
+	if (!pathkey_is_time_dimension(pk, dim, rel->relid, &direct))
+		return;
+
+	/*
+	 * The chunks are only ordered on the leading key, so any further keys
+	 * must come from the chunks' own ordered paths. Chunks in the same time
+	 * slice are merged on all keys. A transformed key can be equal for
+	 * different times, so it cannot be followed by further keys.
+	 */
+	if (!direct && list_length(pathkeys) > 1)
+		return;
+
+	/*
+	 * The rows of a deferred migration in the main table can have any time,
+	 * so they would have to be merged with every chunk. Leave that to the
+	 * standard MergeAppend.
+	 */
+	if (hypertable_has_deferred_data(ht))
+		return;
+
+	chunk_htab = chunk_relid_htab_create(ht->fd.id, ht->space->num_dimensions);
+	children = palloc(sizeof(OrderedChild *) * list_length(root->append_rel_list));
+
+	foreach(lc, root->append_rel_list)
+	{
+		AppendRelInfo *appinfo = lfirst(lc);
+		RelOptInfo *childrel;
+		RangeTblEntry *childrte;
+		Chunk	   *chunk;
+		OrderedChild *child;
+		Path	   *path;
+
+		if (appinfo->parent_relid != rel->relid)
+			continue;
+
+		childrel = root->simple_rel_array[appinfo->child_relid];
+		childrte = root->simple_rte_array[appinfo->child_relid];
+
+		/* The main table holds no tuples, as checked above */
+		if (childrte->relid == ht->main_table_relid || IS_DUMMY_REL(childrel))
+			continue;
+
+		chunk = chunk_relid_htab_lookup(chunk_htab, childrte->relid);
+
+		/* Not a chunk we know about, so the time order is unknown */
+		if (NULL == chunk)
+			return;
+
+		path = get_cheapest_path_for_pathkeys_compat(childrel->pathlist, pathkeys,
+													 NULL, TOTAL_COST);
+
+		/*
+		 * Sorting every chunk up front would defeat the purpose, so require
+		 * an ordered scan, e.g., on an index on time
+		 */
+		if (NULL == path)
+			return;
+
+		child = palloc(sizeof(OrderedChild));
+		child->path = path;
+		child->slice = hypercube_get_slice_by_dimension_id(chunk->cube, dim->fd.id);
+		child->index = num_children;
+
+		if (NULL == child->slice)
+			return;
+
+		children[num_children++] = child;
+	}
+
+	if (num_children == 0)
+		return;
+
+	qsort(children, num_children, sizeof(OrderedChild *), ordered_child_cmp);
+
+	/*
+	 * Group the chunks whose time slices overlap. Each group becomes one
+	 * child of the Append, merged if it has more than one chunk.
+	 */
+	for (i = 0; i <= num_children; i++)
+	{
+		if (group != NIL &&
+			(i == num_children || children[i]->slice->fd.range_start >= group_end))
+		{
+			Path	   *path = linitial(group);
+
+			if (list_length(group) > 1)
+				path = (Path *) create_merge_append_path_compat(root, rel, group,
+																pathkeys, NULL);
+
+			if (pk->pk_strategy == BTGreaterStrategyNumber)
+				subpaths = lcons(path, subpaths);
+			else
+				subpaths = lappend(subpaths, path);
+
+			group = NIL;
+		}
+
+		if (i == num_children)
+			break;
+
+		if (group == NIL || children[i]->slice->fd.range_end > group_end)
+			group_end = children[i]->slice->fd.range_end;
+
+		group = lappend(group, children[i]->path);
+	}
+
+	append = create_append_path_compat(rel, subpaths, NULL, 0);
+	append->path.pathkeys = pathkeys;
+	add_path(rel, &append->path);
+}
@@ -0,0 +1,11 @@
+#ifndef TIMESCALEDB_PLAN_ORDERED_APPEND_H
+#define TIMESCALEDB_PLAN_ORDERED_APPEND_H
+
+#include <postgres.h>
+#include <nodes/relation.h>
+
+#include "hypertable.h"
+
+extern void plan_ordered_append_add_path(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht);
+
+#endif							/* TIMESCALEDB_PLAN_ORDERED_APPEND_H */
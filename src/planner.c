@@ -1,12 +1,22 @@
 #include <postgres.h>
 #include <nodes/plannodes.h>
+#include <nodes/nodeFuncs.h>
 #include <parser/parsetree.h>
 #include <optimizer/clauses.h>
 #include <optimizer/planner.h>
 #include <optimizer/pathnode.h>
 #include <optimizer/paths.h>
+#include <optimizer/plancat.h>
+#include <optimizer/var.h>
+#include <optimizer/restrictinfo.h>
+#include <rewrite/rewriteManip.h>
+#include <foreign/fdwapi.h>
+#include <utils/rel.h>
+#include <access/heapam.h>
+#include <access/sysattr.h>
 #include <catalog/namespace.h>
 #include <utils/guc.h>
+#include <utils/lsyscache.h>
 #include <miscadmin.h>
 
 #include "compat-msvc-enter.h"
@@ -14,20 +24,38 @@
 #include "compat-msvc-exit.h"
 
 #include "hypertable_cache.h"
+#include "chunk.h"
+#include "chunk_bloom_filter.h"
+#include "chunk_time_range.h"
+#include "continuous_agg.h"
+#include "hypercube.h"
 #include "extension.h"
 #include "utils.h"
 #include "guc.h"
 #include "dimension.h"
+#include "gapfill.h"
 #include "chunk_dispatch_plan.h"
 #include "planner_utils.h"
 #include "hypertable_insert.h"
 #include "constraint_aware_append.h"
+#include "decompress_scan.h"
+#include "plan_agg_bookend.h"
+#include "plan_expand_hypertable.h"
+#include "plan_ordered_append.h"
+#include "plan_chunk_aggregate.h"
+#include "plan_chunk_estimate.h"
+#include "plan_join_exclusion.h"
+#include "process_utility.h"
+#include "skip_scan.h"
+#include "sort_transform.h"
 
 void		_planner_init(void);
 void		_planner_fini(void);
 
 static planner_hook_type prev_planner_hook;
 static set_rel_pathlist_hook_type prev_set_rel_pathlist_hook;
+static get_relation_info_hook_type prev_get_relation_info_hook;
+static create_upper_paths_hook_type prev_create_upper_paths_hook;
 
 typedef struct ModifyTableWalkerCtx
 {
@@ -143,10 +171,270 @@ modifytable_plan_walker(Plan **planptr, void *pctx)
 }
 
 
+static inline bool
+should_expand_hypertables(void)
+{
+	return !guc_disable_optimizations &&
+		guc_plan_chunk_exclusion &&
+		constraint_exclusion != CONSTRAINT_EXCLUSION_OFF;
+}
+
+/*
+ * Check if an UPDATE assigns the given column.
+ */
+static bool
+query_assigns_column(Query *parse, AttrNumber attno)
+{
+	ListCell   *lc;
+
+	foreach(lc, parse->targetList)
+	{
+		TargetEntry *tle = lfirst(lc);
+
+		if (!tle->resjunk && tle->resno == attno)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Check if a relation has BEFORE UPDATE row triggers, which can change the
+ * values of any column of the updated rows.
+ */
+static bool
+relation_has_before_update_row_trigger(Oid relid)
+{
+	Relation	rel = heap_open(relid, AccessShareLock);
+	bool		has_trigger = rel->trigdesc != NULL && rel->trigdesc->trig_update_before_row;
+
+	heap_close(rel, AccessShareLock);
+
+	return has_trigger;
+}
+
+/*
+ * Check if a query writes values of a column with bloom filters, i.e., if it
+ * inserts rows or updates such a column of the given table. Updates of a
+ * table with BEFORE UPDATE row triggers can write any column.
+ */
+static bool
+query_writes_bloom_column(Query *parse, Oid relid, Hypertable *ht)
+{
+	List	   *columns;
+	ListCell   *lc;
+
+	if (!ht->has_bloom_filters)
+		return false;
+
+	if (parse->commandType == CMD_INSERT ||
+		relation_has_before_update_row_trigger(relid))
+		return true;
+
+	columns = hypertable_bloom_column_get_all(ht->fd.id);
+
+	foreach(lc, columns)
+	{
+		AttrNumber	attno = get_attnum(relid, lfirst(lc));
+
+		if (attno != InvalidAttrNumber && query_assigns_column(parse, attno))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Widen the time range of a chunk that has BEFORE UPDATE row triggers to its
+ * whole time slice, like inserts do for BEFORE INSERT row triggers, since
+ * the triggers can write any time that the chunk's constraints allow.
+ */
+static void
+widen_chunk_time_range_to_slice(Chunk *chunk, Dimension *dim)
+{
+	DimensionSlice *slice = hypercube_get_slice_by_dimension_id(chunk->cube, dim->fd.id);
+
+	chunk_time_range_widen(chunk->fd.id, slice->fd.range_start, slice->fd.range_end - 1);
+}
+
+/*
+ * Make the time ranges of chunks unknown if the query can write rows into
+ * them with times that inserts into the hypertable did not account for,
+ * i.e., when inserting directly into a chunk or updating the time column.
+ * Updates of chunks with BEFORE UPDATE row triggers, which come from the
+ * hypertable, widen the ranges to the chunks' time slices instead.
+ * Likewise, delete the bloom filters of chunks that the query can write
+ * values into that the filters do not cover. This happens at plan time,
+ * since plans can run many times but the ranges are never narrowed again.
+ * Plans that write to a chunk are invalidated when its filters are built.
+ *
+ * Inserts directly into a chunk also log the chunk's time slice for the
+ * continuous aggregates of its hypertable. Unlike the time ranges, a logged
+ * range is used up by a refresh, so such plans must not be reused by later
+ * transactions. Returns true in that case.
+ */
+static bool
+invalidate_chunk_metadata(Query *parse, Cache *hcache)
+{
+	ListCell   *lc;
+	bool		transient = false;
+
+	foreach(lc, parse->cteList)
+	{
+		CommonTableExpr *cte = lfirst(lc);
+
+		if (IsA(cte->ctequery, Query) &&
+			invalidate_chunk_metadata((Query *) cte->ctequery, hcache))
+			transient = true;
+	}
+
+	if ((parse->commandType == CMD_INSERT || parse->commandType == CMD_UPDATE) &&
+		parse->resultRelation > 0)
+	{
+		RangeTblEntry *rte = rt_fetch(parse->resultRelation, parse->rtable);
+		Hypertable *ht = hypertable_cache_get_entry(hcache, rte->relid);
+		Dimension  *dim;
+		Chunk	   *chunk;
+
+		if (ht != NULL)
+		{
+			dim = hyperspace_get_open_dimension(ht->space, 0);
+
+			if (parse->commandType == CMD_UPDATE &&
+				query_assigns_column(parse, dim->column_attno))
+				chunk_time_range_invalidate_by_hypertable_id(ht->fd.id);
+			else if (parse->commandType == CMD_UPDATE &&
+					 relation_has_before_update_row_trigger(rte->relid))
+			{
+				/* The hypertable's row triggers are created on its chunks */
+				List	   *chunks = chunk_get_all_by_hypertable_id(ht->fd.id, 0);
+				ListCell   *lc_chunk;
+
+				foreach(lc_chunk, chunks)
+				{
+					chunk = lfirst(lc_chunk);
+
+					if (relation_has_before_update_row_trigger(chunk->table_id))
+						widen_chunk_time_range_to_slice(chunk, dim);
+				}
+			}
+
+			if (parse->commandType == CMD_UPDATE &&
+				query_writes_bloom_column(parse, rte->relid, ht))
+				chunk_bloom_filter_delete_by_hypertable_id(ht->fd.id);
+			return transient;
+		}
+
+		chunk = chunk_get_by_relid(rte->relid, 0, false);
+
+		if (chunk == NULL)
+			return transient;
+
+		ht = hypertable_cache_get_entry(hcache, chunk->hypertable_relid);
+
+		if (ht == NULL)
+			return transient;
+
+		dim = hyperspace_get_open_dimension(ht->space, 0);
+
+		if (parse->commandType == CMD_INSERT ||
+			query_assigns_column(parse, get_attnum(rte->relid, NameStr(dim->fd.column_name))))
+			chunk_time_range_invalidate(chunk->fd.id);
+		else if (relation_has_before_update_row_trigger(rte->relid))
+			widen_chunk_time_range_to_slice(chunk_get_by_id(chunk->fd.id, ht->space->num_dimensions, true),
+											dim);
+
+		if (query_writes_bloom_column(parse, rte->relid, ht))
+			chunk_bloom_filter_delete_by_chunk_id(chunk->fd.id);
+
+		/* Updates and deletes are logged by the chunk's trigger */
+		if (parse->commandType == CMD_INSERT && ht->has_continuous_aggs)
+		{
+			continuous_agg_invalidate_chunk(ht, chunk->fd.id);
+			transient = true;
+		}
+	}
+
+	return transient;
+}
+
+/*
+ * Check if a query, including its subqueries and CTEs, reads or writes a
+ * hypertable or a chunk.
+ */
+static bool
+query_involves_hypertables_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, RangeTblEntry))
+	{
+		RangeTblEntry *rte = (RangeTblEntry *) node;
+
+		return rte->rtekind == RTE_RELATION &&
+			hypertable_cache_relid_is_relevant(rte->relid);
+	}
+
+	if (IsA(node, Query))
+		return query_tree_walker((Query *) node, query_involves_hypertables_walker,
+								 context, QTW_EXAMINE_RTES);
+
+	return expression_tree_walker(node, query_involves_hypertables_walker, context);
+}
+
 static PlannedStmt *
 timescaledb_planner(Query *parse, int cursor_opts, ParamListInfo bound_params)
 {
 	PlannedStmt *plan_stmt = NULL;
+	bool		involves_hypertables;
+	bool		transient = false;
+
+	/*
+	 * Queries that only involve plain tables, such as those of OLTP
+	 * workloads sharing the database, are planned without pinning the
+	 * hypertable cache or walking the query and plan trees.
+	 */
+	involves_hypertables = extension_is_loaded() &&
+		query_involves_hypertables_walker((Node *) parse, NULL);
+
+	/*
+	 * Rewrite first() and last() to read a single row. This must happen
+	 * before the hypertables are marked, so that the subqueries that read
+	 * them are marked too.
+	 */
+	if (involves_hypertables && !guc_disable_optimizations && guc_bookend_optimization)
+	{
+		Cache	   *hcache = hypertable_cache_pin();
+
+		plan_agg_bookend_rewrite(parse, hcache);
+		cache_release(hcache);
+	}
+
+	/*
+	 * Invalidate the metadata of chunks the query can write to. A query that
+	 * is only explained never writes anything, so it is left alone.
+	 */
+	if (involves_hypertables && !process_utility_is_explain_only())
+	{
+		Cache	   *hcache = hypertable_cache_pin();
+
+		transient = invalidate_chunk_metadata(parse, hcache);
+		cache_release(hcache);
+	}
+
+	/*
+	 * Keep PostgreSQL from expanding hypertables into all of their chunks.
+	 * We expand them ourselves once we know the restrictions, see
+	 * timescaledb_get_relation_info_hook().
+	 */
+	if (involves_hypertables && should_expand_hypertables())
+	{
+		Cache	   *hcache = hypertable_cache_pin();
+
+		plan_expand_hypertable_mark(parse, hcache);
+		cache_release(hcache);
+	}
 
 	if (prev_planner_hook != NULL)
 	{
@@ -159,7 +447,11 @@ timescaledb_planner(Query *parse, int cursor_opts, ParamListInfo bound_params)
 		plan_stmt = standard_planner(parse, cursor_opts, bound_params);
 	}
 
-	if (extension_is_loaded())
+	/* Replan in every transaction, see invalidate_chunk_metadata() */
+	if (transient)
+		plan_stmt->transientPlan = true;
+
+	if (involves_hypertables)
 	{
 		ModifyTableWalkerCtx ctx = {
 			.parse = parse,
@@ -182,11 +474,73 @@ should_optimize_query(Hypertable *ht)
 		(guc_optimize_non_hypertables || ht != NULL);
 }
 
+static bool
+contain_param_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Param))
+		return true;
+
+	return expression_tree_walker(node, contain_param_walker, context);
+}
+
+static bool
+clause_references_dimension(Hypertable *ht, Index relid, Node *clause)
+{
+	Bitmapset  *attnos = NULL;
+	int			i;
+
+	pull_varattnos(clause, relid, &attnos);
 
-extern void sort_transform_optimization(PlannerInfo *root, RelOptInfo *rel);
+	for (i = 0; i < ht->space->num_dimensions; i++)
+	{
+		AttrNumber	attno = ht->space->dimensions[i].column_attno;
+
+		if (bms_is_member(attno - FirstLowInvalidHeapAttributeNumber, attnos))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Check if any of the clauses references a column with bloom filters. The
+ * filters can change after planning, so they are only checked at execution.
+ */
+static bool
+clauses_reference_bloom_column(Hypertable *ht, Index relid, List *restrictinfos)
+{
+	Bitmapset  *attnos = NULL;
+	List	   *columns;
+	ListCell   *lc;
+
+	if (!ht->has_bloom_filters)
+		return false;
+
+	foreach(lc, restrictinfos)
+		pull_varattnos((Node *) ((RestrictInfo *) lfirst(lc))->clause, relid, &attnos);
+
+	if (NULL == attnos)
+		return false;
+
+	columns = hypertable_bloom_column_get_all(ht->fd.id);
+
+	foreach(lc, columns)
+	{
+		AttrNumber	attno = get_attnum(ht->main_table_relid, lfirst(lc));
+
+		if (attno != InvalidAttrNumber &&
+			bms_is_member(attno - FirstLowInvalidHeapAttributeNumber, attnos))
+			return true;
+	}
+
+	return false;
+}
 
 static inline bool
-should_optimize_append(const Path *path)
+should_optimize_append(PlannerInfo *root, Hypertable *ht, Path *path)
 {
 	RelOptInfo *rel = path->parent;
 	ListCell   *lc;
@@ -196,20 +550,47 @@ should_optimize_append(const Path *path)
 		return false;
 
 	/*
-	 * If there are clauses that have mutable functions, this path is ripe for
-	 * execution-time optimization
+	 * If there are clauses that have mutable functions or parameters, this
+	 * path is ripe for execution-time optimization
 	 */
 	foreach(lc, rel->baserestrictinfo)
 	{
 		RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
 
-		if (contain_mutable_functions((Node *) rinfo->clause))
+		if (contain_mutable_functions((Node *) rinfo->clause) ||
+			contain_param_walker((Node *) rinfo->clause, NULL))
 			return true;
 	}
+
+	if (clauses_reference_bloom_column(ht, rel->relid, rel->baserestrictinfo))
+		return true;
+
+	/*
+	 * Join clauses on a dimension allow excluding chunks on each rescan of a
+	 * parameterized path (e.g., the inner side of a nested loop)
+	 */
+	if (path->param_info != NULL)
+	{
+		foreach(lc, path->param_info->ppi_clauses)
+		{
+			RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+
+			if (clause_references_dimension(ht, rel->relid, (Node *) rinfo->clause))
+				return true;
+		}
+	}
+
+	/*
+	 * Join clauses on the time dimension give bounds that exclude chunks at
+	 * run time, whichever side of the join the hypertable is on
+	 */
+	if (guc_runtime_join_exclusion &&
+		plan_join_exclusion_applicable(root, rel, ht, path))
+		return true;
+
 	return false;
 }
 
-
 static inline bool
 is_append_child(RelOptInfo *rel, RangeTblEntry *rte)
 {
@@ -244,6 +625,15 @@ timescaledb_set_rel_pathlist(PlannerInfo *root,
 	if (!extension_is_loaded() || IS_DUMMY_REL(rel) || !OidIsValid(rte->relid))
 		return;
 
+	/*
+	 * Compressed chunks are scanned by decompressing them, both as children
+	 * of a hypertable and as the result relations of an UPDATE or DELETE on
+	 * a hypertable, which are planned as base relations
+	 */
+	if (is_append_child(rel, rte) ||
+		(root->hasInheritedTarget && rti == root->parse->resultRelation))
+		decompress_chunk_set_rel_pathlist(root, rel, rti, rte);
+
 	/* quick abort if only optimizing hypertables */
 	if (!guc_optimize_non_hypertables && !(is_append_parent(rel, rte) || is_append_child(rel, rte)))
 		return;
@@ -254,6 +644,13 @@ timescaledb_set_rel_pathlist(PlannerInfo *root,
 	if (!should_optimize_query(ht))
 		goto out_release;
 
+	/*
+	 * The main table is the first child of a hypertable, so the other
+	 * children do not have paths yet
+	 */
+	if (guc_chunk_row_estimation && ht != NULL && is_append_child(rel, rte))
+		plan_chunk_estimate_rows(root, rel, ht);
+
 	if (guc_optimize_non_hypertables)
 	{
 		/* if optimizing all tables, apply optimization to any table */
@@ -302,6 +699,9 @@ timescaledb_set_rel_pathlist(PlannerInfo *root,
 	{
 		ListCell   *lc;
 
+		if (guc_ordered_append)
+			plan_ordered_append_add_path(root, rel, ht);
+
 		foreach(lc, rel->pathlist)
 		{
 			Path	  **pathptr = (Path **) &lfirst(lc);
@@ -311,18 +711,224 @@ timescaledb_set_rel_pathlist(PlannerInfo *root,
 			{
 				case T_AppendPath:
 				case T_MergeAppendPath:
-					if (should_optimize_append(path))
+					if (should_optimize_append(root, ht, path))
 						*pathptr = constraint_aware_append_path_create(root, ht, path);
 				default:
 					break;
 			}
 		}
+
+		/*
+		 * Let the processes of a parallel query claim whole chunks instead of
+		 * taking part in the scan of every chunk
+		 */
+		if (guc_constraint_aware_append &&
+			rel->consider_parallel &&
+			bms_is_empty(rel->lateral_relids))
+		{
+			Path	   *path = constraint_aware_append_parallel_path_create(root, ht, rel);
+
+			if (NULL != path)
+			{
+				add_partial_path(rel, path);
+
+				/* add_partial_path() frees the path if it is rejected */
+				if (list_member_ptr(rel->partial_pathlist, path))
+					add_path(rel, (Path *) create_gather_path(root, rel, path,
+															  rel->reltarget, NULL, NULL));
+			}
+		}
 	}
 
 out_release:
 	cache_release(hcache);
 }
 
+/*
+ * Estimate the size of a foreign chunk, after restricting its scan to the
+ * chunk's hypercube.
+ *
+ * All the foreign chunks on a data node point to the node's hypertable, so a
+ * scan of one of them would return the rows of every chunk on the node. The
+ * chunk's dimension constraints are therefore added to the restrictions of
+ * the scan before the FDW sees them, which makes the FDW send them to the
+ * data node, or apply them locally if they cannot be sent.
+ */
+static void
+foreign_chunk_get_rel_size(PlannerInfo *root, RelOptInfo *rel, Oid foreigntableid)
+{
+	Chunk	   *chunk = chunk_get_by_relid(foreigntableid, 1, true);
+	Relation	chunkrel = heap_open(foreigntableid, NoLock);
+	TupleConstr *constr = chunkrel->rd_att->constr;
+	int			i,
+				j;
+
+	for (i = 0; i < chunk->constraints->num_constraints && NULL != constr; i++)
+	{
+		ChunkConstraint *cc = chunk_constraints_get(chunk->constraints, i);
+
+		if (!is_dimension_constraint(cc))
+			continue;
+
+		for (j = 0; j < constr->num_check; j++)
+		{
+			Node	   *expr;
+			ListCell   *lc;
+
+			if (strcmp(constr->check[j].ccname, NameStr(cc->fd.constraint_name)) != 0)
+				continue;
+
+			expr = eval_const_expressions(root, stringToNode(constr->check[j].ccbin));
+			ChangeVarNodes(expr, 1, rel->relid, 0);
+
+			foreach(lc, make_ands_implicit((Expr *) expr))
+				rel->baserestrictinfo = lappend(rel->baserestrictinfo,
+												make_simple_restrictinfo(lfirst(lc)));
+		}
+	}
+
+	heap_close(chunkrel, NoLock);
+
+	GetFdwRoutineByRelId(foreigntableid)->GetForeignRelSize(root, rel, foreigntableid);
+}
+
+/*
+ * Expand hypertables marked by timescaledb_planner() into the chunks that
+ * match the query's restrictions. This is the last point before the planner
+ * builds the RelOptInfos of an append relation's children, so it is where
+ * the children need to be added.
+ *
+ * It is also where the chunks of an UPDATE or DELETE target can be excluded
+ * before the planner builds any paths for them.
+ */
+static void
+timescaledb_get_relation_info_hook(PlannerInfo *root,
+								   Oid relation_objectid,
+								   bool inhparent,
+								   RelOptInfo *rel)
+{
+	RangeTblEntry *rte;
+
+	if (prev_get_relation_info_hook != NULL)
+		prev_get_relation_info_hook(root, relation_objectid, inhparent, rel);
+
+	if (!extension_is_loaded())
+		return;
+
+	rte = planner_rt_fetch(rel->relid, root);
+
+	if (!inhparent && plan_expand_hypertable_is_marked(rte))
+	{
+		Cache	   *hcache = hypertable_cache_pin();
+		Hypertable *ht = hypertable_cache_get_entry(hcache, relation_objectid);
+
+		/* The hypertable is locked, so it cannot have gone away */
+		if (ht == NULL)
+			elog(ERROR, "could not find hypertable for relation %u", relation_objectid);
+
+		plan_expand_hypertable_chunks(ht, root, rel);
+
+		cache_release(hcache);
+	}
+	else if (!inhparent &&
+			 rte->relkind == RELKIND_FOREIGN_TABLE &&
+			 NULL != rel->fdwroutine &&
+			 NULL != chunk_get_by_relid(relation_objectid, 0, false))
+	{
+		/* A chunk on a data node of a distributed hypertable */
+		FdwRoutine *fdwroutine = palloc(sizeof(FdwRoutine));
+
+		memcpy(fdwroutine, rel->fdwroutine, sizeof(FdwRoutine));
+		fdwroutine->GetForeignRelSize = foreign_chunk_get_rel_size;
+		rel->fdwroutine = fdwroutine;
+	}
+	else if (!inhparent &&
+			 root->hasInheritedTarget &&
+			 rel->relid == root->parse->resultRelation &&
+			 should_expand_hypertables())
+	{
+		/*
+		 * A child of an UPDATE or DELETE target, planned by
+		 * inheritance_planner(). Exclude it if it is a chunk that cannot match
+		 * the query's restrictions.
+		 */
+		AppendRelInfo *appinfo = NULL;
+		ListCell   *lc;
+
+		foreach(lc, root->append_rel_list)
+		{
+			AppendRelInfo *ai = lfirst(lc);
+
+			if (ai->child_relid == rel->relid)
+			{
+				appinfo = ai;
+				break;
+			}
+		}
+
+		if (NULL != appinfo)
+		{
+			Cache	   *hcache = hypertable_cache_pin();
+			Hypertable *ht = hypertable_cache_get_entry(hcache, appinfo->parent_reloid);
+
+			if (ht != NULL)
+				plan_expand_hypertable_exclude_result_chunk(ht, root, rel, appinfo);
+
+			cache_release(hcache);
+		}
+	}
+}
+
+/*
+ * Add paths for the upper stages of a query over a hypertable. Aggregates
+ * over a hypertable can be computed chunk by chunk before they are combined,
+ * and a DISTINCT on a single column can skip scan the chunks.
+ */
+static void
+timescaledb_create_upper_paths_hook(PlannerInfo *root,
+									UpperRelationKind stage,
+									RelOptInfo *input_rel,
+									RelOptInfo *output_rel)
+{
+	RangeTblEntry *rte;
+	Cache	   *hcache;
+	Hypertable *ht;
+
+	if (prev_create_upper_paths_hook != NULL)
+		prev_create_upper_paths_hook(root, stage, input_rel, output_rel);
+
+	if (!extension_is_loaded())
+		return;
+
+	if (((stage == UPPERREL_GROUP_AGG && guc_chunk_aggregation) ||
+		 (stage == UPPERREL_DISTINCT && guc_skip_scan)) &&
+		input_rel->reloptkind == RELOPT_BASEREL &&
+		!IS_DUMMY_REL(input_rel))
+	{
+		rte = planner_rt_fetch(input_rel->relid, root);
+
+		if (is_append_parent(input_rel, rte))
+		{
+			hcache = hypertable_cache_pin();
+			ht = hypertable_cache_get_entry(hcache, rte->relid);
+
+			if (ht != NULL && should_optimize_query(ht))
+			{
+				if (stage == UPPERREL_GROUP_AGG)
+					plan_chunk_aggregate_add_paths(root, input_rel, output_rel, ht);
+				else
+					skip_scan_add_paths(root, input_rel, output_rel, ht);
+			}
+
+			cache_release(hcache);
+		}
+	}
+
+	/* Gap filling is not limited to hypertables, and goes on top of all paths */
+	if (stage == UPPERREL_GROUP_AGG)
+		gapfill_add_paths(root, output_rel);
+}
+
 void
 _planner_init(void)
 {
@@ -330,6 +936,10 @@ _planner_init(void)
 	planner_hook = timescaledb_planner;
 	prev_set_rel_pathlist_hook = set_rel_pathlist_hook;
 	set_rel_pathlist_hook = timescaledb_set_rel_pathlist;
+	prev_get_relation_info_hook = get_relation_info_hook;
+	get_relation_info_hook = timescaledb_get_relation_info_hook;
+	prev_create_upper_paths_hook = create_upper_paths_hook;
+	create_upper_paths_hook = timescaledb_create_upper_paths_hook;
 }
 
 void
@@ -337,4 +947,6 @@ _planner_fini(void)
 {
 	planner_hook = prev_planner_hook;
 	set_rel_pathlist_hook = prev_set_rel_pathlist_hook;
+	get_relation_info_hook = prev_get_relation_info_hook;
+	create_upper_paths_hook = prev_create_upper_paths_hook;
 }
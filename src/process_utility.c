@@ -10,6 +10,7 @@
 #include <catalog/pg_trigger.h>
 #include <catalog/pg_constraint_fn.h>
 #include <catalog/pg_constraint.h>
+#include <catalog/pg_type.h>
 #include <commands/copy.h>
 #include <commands/vacuum.h>
 #include <commands/defrem.h>
@@ -26,19 +27,27 @@
 #include <utils/guc.h>
 #include <utils/snapmgr.h>
 #include <parser/parse_utilcmd.h>
+#include <storage/lmgr.h>
 
 #include <miscadmin.h>
 
 #include "process_utility.h"
 #include "catalog.h"
 #include "chunk.h"
+#include "chunk_bloom_filter.h"
 #include "chunk_index.h"
+#include "chunk_maintenance.h"
+#include "chunk_time_range.h"
 #include "compat.h"
+#include "continuous_agg.h"
 #include "copy.h"
+#include "data_node.h"
 #include "errors.h"
 #include "event_trigger.h"
 #include "extension.h"
+#include "guc.h"
 #include "hypercube.h"
+#include "hypertable_analyze.h"
 #include "hypertable_cache.h"
 #include "dimension_vector.h"
 #include "indexing.h"
@@ -52,6 +61,9 @@ static ProcessUtility_hook_type prev_ProcessUtility_hook;
 
 static bool expect_chunk_modification = false;
 
+/* Set while a query is planned for an EXPLAIN without ANALYZE */
+static bool explain_only = false;
+
 typedef struct ProcessUtilityArgs
 {
 #if PG10
@@ -193,6 +205,23 @@ process_copy(Node *parsetree, const char *query_string, char *completion_tag)
 
 	if (ht == NULL)
 	{
+		Chunk	   *chunk = chunk_get_by_relid(relid, 0, false);
+
+		/*
+		 * Rows copied directly into a chunk can have any time in its slice,
+		 * and values that its bloom filters do not cover
+		 */
+		if (NULL != chunk)
+		{
+			chunk_time_range_invalidate(chunk->fd.id);
+			chunk_bloom_filter_delete_by_chunk_id(chunk->fd.id);
+
+			ht = hypertable_cache_get_entry(hcache, chunk->hypertable_relid);
+
+			if (NULL != ht)
+				continuous_agg_invalidate_chunk(ht, chunk->fd.id);
+		}
+
 		cache_release(hcache);
 		return false;
 	}
@@ -237,6 +266,43 @@ foreach_chunk(Hypertable *ht, process_chunk_t process_chunk, void *arg)
 	return n;
 }
 
+typedef void (*process_loaded_chunk_t) (Hypertable *ht, Chunk *chunk, void *arg);
+
+/*
+ * Applies a function to each chunk of a hypertable, like foreach_chunk(), but
+ * passes on the chunk itself. The metadata of all chunks is loaded up front,
+ * which is much cheaper than looking up each chunk by its relid.
+ *
+ * Returns the number of processed chunks, or -1 if the table was not a
+ * hypertable.
+ */
+static int
+foreach_loaded_chunk(Hypertable *ht, process_loaded_chunk_t process_chunk, void *arg)
+{
+	List	   *chunks;
+	ListCell   *lc;
+	int			n = 0;
+
+	if (NULL == ht)
+		return -1;
+
+	chunks = chunk_get_all_by_hypertable_id(ht->fd.id, ht->space->num_dimensions);
+
+	foreach(lc, chunks)
+	{
+		Chunk	   *chunk = lfirst(lc);
+
+		/* Skip chunks that have metadata but no table */
+		if (!OidIsValid(chunk->table_id))
+			continue;
+
+		process_chunk(ht, chunk, arg);
+		n++;
+	}
+
+	return n;
+}
+
 static int
 foreach_chunk_relid(Oid relid, process_chunk_t process_chunk, void *arg)
 {
@@ -269,15 +335,27 @@ typedef struct VacuumCtx
 {
 	VacuumStmt *stmt;
 	bool		is_toplevel;
+	List	   *chunks;
 } VacuumCtx;
 
-/* Vacuums a single chunk */
+/* Adds a chunk to the chunks to vacuum, unless it can be skipped */
 static void
-vacuum_chunk(Hypertable *ht, Oid chunk_relid, void *arg)
+vacuum_chunk_add(Hypertable *ht, Chunk *chunk, void *arg)
 {
 	VacuumCtx  *ctx = (VacuumCtx *) arg;
-	Chunk	   *chunk = chunk_get_by_relid(chunk_relid, ht->space->num_dimensions, true);
 
+	if ((guc_vacuum_skip_unchanged_chunks ||
+		 (guc_incremental_analyze && !(ctx->stmt->options & VACOPT_VACUUM))) &&
+		chunk_vacuum_is_unchanged(chunk->table_id, ctx->stmt->options))
+		return;
+
+	ctx->chunks = lappend(ctx->chunks, chunk);
+}
+
+/* Vacuums a single chunk */
+static void
+vacuum_chunk(VacuumCtx *ctx, Chunk *chunk)
+{
 	ctx->stmt->relation->relname = NameStr(chunk->fd.table_name);
 	ctx->stmt->relation->schemaname = NameStr(chunk->fd.schema_name);
 	ExecVacuum(ctx->stmt, ctx->is_toplevel);
@@ -291,6 +369,7 @@ process_vacuum(Node *parsetree, ProcessUtilityContext context)
 	VacuumCtx	ctx = {
 		.stmt = stmt,
 		.is_toplevel = (context == PROCESS_UTILITY_TOPLEVEL),
+		.chunks = NIL,
 	};
 	Oid			hypertable_oid;
 	Cache	   *hcache;
@@ -313,7 +392,20 @@ process_vacuum(Node *parsetree, ProcessUtilityContext context)
 
 	/* allow vacuum to be cross-commit */
 	hcache->release_on_commit = false;
-	foreach_chunk(ht, vacuum_chunk, &ctx);
+	foreach_loaded_chunk(ht, vacuum_chunk_add, &ctx);
+
+	if (!chunk_vacuum_parallel(stmt, ctx.is_toplevel, ctx.chunks))
+	{
+		ListCell   *lc;
+
+		foreach(lc, ctx.chunks)
+			vacuum_chunk(&ctx, lfirst(lc));
+	}
+
+	/* The unchanged chunks keep their statistics, which are merged too */
+	if (guc_incremental_analyze && (stmt->options & VACOPT_ANALYZE))
+		hypertable_analyze_merge_chunk_stats(ht, stmt->va_cols);
+
 	hcache->release_on_commit = true;
 
 	cache_release(hcache);
@@ -321,18 +413,6 @@ process_vacuum(Node *parsetree, ProcessUtilityContext context)
 	return true;
 }
 
-static void
-process_truncate_chunk(Hypertable *ht, Oid chunk_relid, void *arg)
-{
-	TruncateStmt *stmt = arg;
-	ObjectAddress objaddr = {
-		.classId = RelationRelationId,
-		.objectId = chunk_relid,
-	};
-
-	performDeletion(&objaddr, stmt->behavior, 0);
-}
-
 static bool
 relation_should_recurse(RangeVar *rv)
 {
@@ -351,6 +431,10 @@ relation_should_recurse(RangeVar *rv)
 
 /*
  * Truncate a hypertable.
+ *
+ * Truncating a hypertable invalidates all of its continuous aggregates'
+ * materializations, while truncating a chunk invalidates the chunk's time
+ * slice.
  */
 static bool
 process_truncate(ProcessUtilityArgs *args)
@@ -386,11 +470,20 @@ process_truncate(ProcessUtilityArgs *args)
 							 errhint("Do not specify the ONLY keyword, or use truncate"
 									 " only on the chunks directly.")));
 
-				/* Delete the metadata */
-				chunk_delete_by_hypertable_id(ht->fd.id);
+				continuous_agg_invalidate_all(ht);
+				chunk_drop_all(ht, stmt->behavior);
+			}
+			else
+			{
+				Chunk	   *chunk = chunk_get_by_relid(relid, 0, false);
+
+				if (NULL != chunk)
+				{
+					ht = hypertable_cache_get_entry(hcache, chunk->hypertable_relid);
 
-				/* Drop the chunk tables */
-				foreach_chunk(ht, process_truncate_chunk, stmt);
+					if (NULL != ht)
+						continuous_agg_invalidate_chunk(ht, chunk->fd.id);
+				}
 			}
 		}
 	}
@@ -400,19 +493,6 @@ process_truncate(ProcessUtilityArgs *args)
 	return true;
 }
 
-
-static void
-process_drop_table_chunk(Hypertable *ht, Oid chunk_relid, void *arg)
-{
-	DropStmt   *stmt = arg;
-	ObjectAddress objaddr = {
-		.classId = RelationRelationId,
-		.objectId = chunk_relid,
-	};
-
-	performDeletion(&objaddr, stmt->behavior, 0);
-}
-
 /*
  *  We need to drop hypertable chunks before the hypertable to avoid the need
  *  to CASCADE such drops;
@@ -446,8 +526,8 @@ process_drop_hypertable_chunks(DropStmt *stmt)
 				if (list_length(stmt->objects) != 1)
 					elog(ERROR, "Cannot drop a hypertable along with other objects");
 
-				/* Drop each chunk table */
-				foreach_chunk(ht, process_drop_table_chunk, stmt);
+				data_node_hypertable_delete_rows(ht);
+				chunk_drop_all(ht, stmt->behavior);
 			}
 
 			handled = true;
@@ -459,6 +539,25 @@ process_drop_hypertable_chunks(DropStmt *stmt)
 	return handled;
 }
 
+/*
+ * Delete the rows of chunks on data nodes from the nodes before the chunks are
+ * dropped.
+ */
+static void
+process_drop_foreign_chunks(DropStmt *stmt)
+{
+	ListCell   *lc;
+
+	foreach(lc, stmt->objects)
+	{
+		RangeVar   *relation = makeRangeVarFromNameList(lfirst(lc));
+		Oid			relid = RangeVarGetRelid(relation, NoLock, true);
+
+		if (OidIsValid(relid))
+			data_node_chunk_delete_rows(relid);
+	}
+}
+
 /* Note that DROP TABLESPACE does not have a hook in event triggers so cannot go
  * through process_ddl_sql_drop */
 static void
@@ -537,16 +636,54 @@ process_drop(Node *parsetree)
 		case OBJECT_TABLE:
 			process_drop_hypertable_chunks(stmt);
 			break;
+		case OBJECT_FOREIGN_TABLE:
+			process_drop_foreign_chunks(stmt);
+			break;
 		default:
 			break;
 	}
 }
 
+/* Adds a chunk to a list of chunks */
 static void
-reindex_chunk(Hypertable *ht, Oid chunk_relid, void *arg)
+add_chunk_to_list(Hypertable *ht, Chunk *chunk, void *arg)
+{
+	List	  **chunks = arg;
+
+	*chunks = lappend(*chunks, chunk);
+}
+
+/*
+ * Reindex the chunks of a hypertable in a transaction per chunk, if enabled
+ * with timescaledb.reindex_transaction_per_chunk.
+ */
+static bool
+reindex_transaction_per_chunk(Cache *hcache, Hypertable *ht, bool is_toplevel)
+{
+	List	   *chunks = NIL;
+	bool		handled;
+
+	if (!guc_reindex_transaction_per_chunk)
+		return false;
+
+	if (!pg_class_ownercheck(ht->main_table_relid, GetUserId()))
+		aclcheck_error(ACLCHECK_NOT_OWNER, ACL_KIND_CLASS,
+					   get_rel_name(ht->main_table_relid));
+
+	foreach_loaded_chunk(ht, add_chunk_to_list, &chunks);
+
+	/* The hypertable outlives the commits */
+	hcache->release_on_commit = false;
+	handled = chunk_reindex_transaction_per_chunk(is_toplevel, chunks);
+	hcache->release_on_commit = true;
+
+	return handled;
+}
+
+static void
+reindex_chunk(Hypertable *ht, Chunk *chunk, void *arg)
 {
 	ReindexStmt *stmt = (ReindexStmt *) arg;
-	Chunk	   *chunk = chunk_get_by_relid(chunk_relid, ht->space->num_dimensions, true);
 
 	switch (stmt->kind)
 	{
@@ -566,9 +703,13 @@ reindex_chunk(Hypertable *ht, Oid chunk_relid, void *arg)
 /*
  * Reindex a hypertable and all its chunks. Currently works only for REINDEX
  * TABLE.
+ *
+ * Outside a transaction block, and with
+ * timescaledb.reindex_transaction_per_chunk, each chunk is reindexed in a
+ * transaction of its own so that only one chunk at a time is blocked.
  */
 static bool
-process_reindex(Node *parsetree)
+process_reindex(Node *parsetree, ProcessUtilityContext context)
 {
 	ReindexStmt *stmt = (ReindexStmt *) parsetree;
 	Oid			relid;
@@ -596,7 +737,10 @@ process_reindex(Node *parsetree)
 			{
 				PreventCommandDuringRecovery("REINDEX");
 
-				if (foreach_chunk(ht, reindex_chunk, stmt) >= 0)
+				if (reindex_transaction_per_chunk(hcache, ht,
+												  context == PROCESS_UTILITY_TOPLEVEL))
+					ret = true;
+				else if (foreach_loaded_chunk(ht, reindex_chunk, stmt) >= 0)
 					ret = true;
 			}
 			break;
@@ -644,6 +788,9 @@ process_rename_column(Cache *hcache, Oid relid, RenameStmt *stmt)
 	if (NULL == ht)
 		return;
 
+	if (ht->has_bloom_filters)
+		chunk_bloom_filter_rename_column(ht, stmt->subname, stmt->newname);
+
 	dim = hyperspace_get_dimension_by_name(ht->space, DIMENSION_TYPE_ANY, stmt->subname);
 
 	if (NULL == dim)
@@ -675,10 +822,9 @@ process_rename_index(Cache *hcache, Oid relid, RenameStmt *stmt)
 }
 
 static void
-rename_hypertable_constraint(Hypertable *ht, Oid chunk_relid, void *arg)
+rename_hypertable_constraint(Hypertable *ht, Chunk *chunk, void *arg)
 {
 	RenameStmt *stmt = (RenameStmt *) arg;
-	Chunk	   *chunk = chunk_get_by_relid(chunk_relid, ht->space->num_dimensions, true);
 
 	chunk_constraint_rename_hypertable_constraint(chunk->fd.id, stmt->subname, stmt->newname);
 }
@@ -694,7 +840,7 @@ process_rename_constraint(Cache *hcache, Oid relid, RenameStmt *stmt)
 	if (NULL != ht)
 	{
 		relation_not_only(stmt->relation);
-		foreach_chunk(ht, rename_hypertable_constraint, stmt);
+		foreach_loaded_chunk(ht, rename_hypertable_constraint, stmt);
 	}
 	else
 	{
@@ -768,10 +914,9 @@ process_altertable_change_owner(Hypertable *ht, AlterTableCmd *cmd)
 }
 
 static void
-process_add_constraint_chunk(Hypertable *ht, Oid chunk_relid, void *arg)
+process_add_constraint_chunk(Hypertable *ht, Chunk *chunk, void *arg)
 {
 	Oid			hypertable_constraint_oid = *((Oid *) arg);
-	Chunk	   *chunk = chunk_get_by_relid(chunk_relid, ht->space->num_dimensions, true);
 
 	chunk_constraint_create_on_chunk(chunk, hypertable_constraint_oid);
 }
@@ -783,7 +928,7 @@ process_altertable_add_constraint(Hypertable *ht, const char *constraint_name)
 
 	Assert(constraint_name != NULL);
 
-	foreach_chunk(ht, process_add_constraint_chunk, &hypertable_constraint_oid);
+	foreach_loaded_chunk(ht, process_add_constraint_chunk, &hypertable_constraint_oid);
 }
 
 static void
@@ -928,21 +1073,206 @@ typedef struct CreateIndexInfo
  * "parent" index on the hypertable.
  */
 static void
-process_index_chunk(Hypertable *ht, Oid chunk_relid, void *arg)
+process_index_chunk(Hypertable *ht, Chunk *chunk, void *arg)
 {
 	CreateIndexInfo *info = (CreateIndexInfo *) arg;
-	IndexStmt  *stmt = transformIndexStmt(chunk_relid, info->stmt, NULL);
-	Chunk	   *chunk = chunk_get_by_relid(chunk_relid, ht->space->num_dimensions, true);
+	IndexStmt  *stmt = transformIndexStmt(chunk->table_id, info->stmt, NULL);
 
-	chunk_index_create_from_stmt(stmt, chunk->fd.id, chunk_relid, ht->fd.id, info->obj.objectId);
+	chunk_index_create_from_stmt(stmt, chunk->fd.id, chunk->table_id, ht->fd.id, info->obj.objectId);
 }
 
+/*
+ * Remove the timescaledb.transaction_per_chunk option from the options of a
+ * CREATE INDEX statement, since PostgreSQL does not know about it.
+ *
+ * Returns the value of the option, or false if not given.
+ */
+static bool
+index_stmt_remove_transaction_per_chunk(IndexStmt *stmt)
+{
+	ListCell   *lc,
+			   *prev = NULL;
+
+	foreach(lc, stmt->options)
+	{
+		DefElem    *def = lfirst(lc);
+
+		if (NULL != def->defnamespace &&
+			pg_strcasecmp(def->defnamespace, "timescaledb") == 0 &&
+			pg_strcasecmp(def->defname, "transaction_per_chunk") == 0)
+		{
+			bool		value = defGetBoolean(def);
+
+			stmt->options = list_delete_cell(stmt->options, lc, prev);
+			return value;
+		}
+
+		prev = lc;
+	}
+
+	return false;
+}
+
+static bool
+index_is_valid(Oid indexrelid)
+{
+	HeapTuple	tuple = SearchSysCache1(INDEXRELID, ObjectIdGetDatum(indexrelid));
+	bool		isvalid;
+
+	if (!HeapTupleIsValid(tuple))
+		elog(ERROR, "cache lookup failed for index %u", indexrelid);
+
+	isvalid = ((Form_pg_index) GETSTRUCT(tuple))->indisvalid;
+	ReleaseSysCache(tuple);
+
+	return isvalid;
+}
+
+/*
+ * Create the hypertable's index for CREATE INDEX ... WITH
+ * (timescaledb.transaction_per_chunk).
+ *
+ * The hypertable itself holds no data, so the index is created right away,
+ * but marked invalid until it exists on all chunks. With IF NOT EXISTS, an
+ * existing index on the hypertable is reused, which resumes a previous CREATE
+ * INDEX that failed on some chunk.
+ */
+static Oid
+index_create_on_hypertable(Hypertable *ht, Oid relid, IndexStmt *stmt)
+{
+	IndexStmt  *htstmt = copyObject(stmt);
+	ObjectAddress idxobj;
+	Oid			indexrelid;
+
+	htstmt->concurrent = false;
+	idxobj = DefineIndex(relid,
+						 htstmt,
+						 InvalidOid,
+						 false, /* is alter table */
+						 true,	/* check rights */
+#if PG10
+						 false, /* check not in use */
+#endif
+						 false, /* skip build */
+						 false);	/* quiet */
+
+	if (OidIsValid(idxobj.objectId))
+	{
+		index_set_state_flags(idxobj.objectId, INDEX_DROP_CLEAR_VALID);
+		CommandCounterIncrement();
+		return idxobj.objectId;
+	}
+
+	/* The index already exists (IF NOT EXISTS) */
+	indexrelid = get_relname_relid(stmt->idxname, get_rel_namespace(relid));
+
+	if (!OidIsValid(indexrelid) || IndexGetRelation(indexrelid, true) != relid)
+		ereport(ERROR,
+				(errcode(ERRCODE_DUPLICATE_TABLE),
+				 errmsg("relation \"%s\" is not an index on hypertable \"%s\"",
+						stmt->idxname, get_rel_name(relid))));
+
+	return indexrelid;
+}
+
+/*
+ * Create an index on a hypertable with a transaction per chunk.
+ *
+ * Creating an index on a hypertable in a single transaction blocks inserts
+ * into all chunks until the index exists on every chunk. Instead, the index
+ * is first created on the hypertable and then on each chunk in a transaction
+ * of its own, so that each chunk is only blocked while its own index is
+ * built, or not at all with CONCURRENTLY. The catalog mapping of a chunk
+ * index is committed with the index, so that CREATE INDEX IF NOT EXISTS can
+ * resume after a failure and only build the missing chunk indexes.
+ */
 static void
-process_index_start(Node *parsetree)
+process_index_transaction_per_chunk(Hypertable *ht, IndexStmt *stmt,
+									const char *query_string, bool is_toplevel)
 {
-	IndexStmt  *stmt = (IndexStmt *) parsetree;
+	LOCKMODE	lockmode = stmt->concurrent ? ShareUpdateExclusiveLock : ShareLock;
+	MemoryContext oldcontext = CurrentMemoryContext;
+	List	   *chunk_ids = NIL;
+	List	   *chunks;
+	ListCell   *lc;
+	Oid			relid;
+	Oid			indexrelid;
+
+	PreventTransactionChain(is_toplevel,
+							"CREATE INDEX ... WITH (timescaledb.transaction_per_chunk)");
+
+	relid = RangeVarGetRelidExtended(stmt->relation, ShareLock, false, false,
+									 RangeVarCallbackOwnsRelation, NULL);
+	stmt = transformIndexStmt(relid, stmt, query_string);
+	indexrelid = index_create_on_hypertable(ht, relid, stmt);
+
+	/* Remember the chunks by ID, since the chunks do not outlive the commit */
+	chunks = chunk_get_all_by_hypertable_id(ht->fd.id, ht->space->num_dimensions);
+
+	foreach(lc, chunks)
+	{
+		Chunk	   *chunk = lfirst(lc);
+
+		chunk_ids = lappend_int(chunk_ids, chunk->fd.id);
+	}
+
+	PopActiveSnapshot();
+	CommitTransactionCommand();
+
+	foreach(lc, chunk_ids)
+	{
+		CatalogSecurityContext sec_ctx;
+		Chunk	   *chunk;
+
+		StartTransactionCommand();
+		PushActiveSnapshot(GetTransactionSnapshot());
+
+		chunk = chunk_get_by_id(lfirst_int(lc), ht->space->num_dimensions, false);
+
+		/*
+		 * Skip chunks that were dropped in the meantime and chunks that
+		 * already have the index, e.g., because they were created after the
+		 * hypertable index or in a previous run
+		 */
+		if (NULL != chunk && OidIsValid(chunk->table_id))
+		{
+			LockRelationOid(chunk->table_id, lockmode);
+
+			if (NULL == chunk_index_get_by_hypertable_indexrelid(chunk, indexrelid))
+			{
+				IndexStmt  *chunkstmt = transformIndexStmt(chunk->table_id, copyObject(stmt), NULL);
+
+				catalog_become_owner(catalog_get(), &sec_ctx);
+				chunk_index_create_from_stmt(chunkstmt, chunk->fd.id, chunk->table_id,
+											 ht->fd.id, indexrelid);
+				catalog_restore_user(&sec_ctx);
+			}
+		}
+
+		/* A concurrent build pops the snapshot itself */
+		if (ActiveSnapshotSet())
+			PopActiveSnapshot();
+
+		CommitTransactionCommand();
+	}
+
+	/* All chunks have the index, so it is valid */
+	StartTransactionCommand();
+
+	if (!index_is_valid(indexrelid))
+		index_set_state_flags(indexrelid, INDEX_CREATE_SET_VALID);
+
+	/* Like VACUUM, this relies on the caller's memory surviving the commits */
+	MemoryContextSwitchTo(oldcontext);
+}
+
+static bool
+process_index_start(ProcessUtilityArgs *args)
+{
+	IndexStmt  *stmt = (IndexStmt *) args->parsetree;
 	Cache	   *hcache;
 	Hypertable *ht;
+	bool		handled = false;
 
 	Assert(IsA(stmt, IndexStmt));
 
@@ -951,17 +1281,37 @@ process_index_start(Node *parsetree)
 
 	if (NULL != ht)
 	{
+		bool		transaction_per_chunk = index_stmt_remove_transaction_per_chunk(stmt);
+
 		/* Make sure this index is allowed */
-		if (stmt->concurrent)
+		if (stmt->concurrent && !transaction_per_chunk)
 			ereport(ERROR,
 					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 					 errmsg("Hypertables currently do not support concurrent "
-							"index creation.")));
+							"index creation."),
+					 errhint("Use CREATE INDEX CONCURRENTLY ... WITH "
+							 "(timescaledb.transaction_per_chunk).")));
 
 		indexing_verify_index(ht->space, stmt);
+
+		if (transaction_per_chunk)
+		{
+			/* The hypertable outlives the commits */
+			hcache->release_on_commit = false;
+			process_index_transaction_per_chunk(ht, stmt, args->query_string,
+												args->context == PROCESS_UTILITY_TOPLEVEL);
+			hcache->release_on_commit = true;
+			handled = true;
+		}
 	}
+	else if (index_stmt_remove_transaction_per_chunk(stmt))
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("timescaledb.transaction_per_chunk is only supported on hypertables")));
 
 	cache_release(hcache);
+
+	return handled;
 }
 
 static bool
@@ -1003,7 +1353,7 @@ process_index_end(Node *parsetree, CollectedCommand *cmd)
 		catalog_become_owner(catalog_get(), &sec_ctx);
 
 		/* Recurse to each chunk and create a corresponding index */
-		foreach_chunk(ht, process_index_chunk, &info);
+		foreach_loaded_chunk(ht, process_index_chunk, &info);
 
 		catalog_restore_user(&sec_ctx);
 		handled = true;
@@ -1251,10 +1601,31 @@ process_alter_column_type_end(Hypertable *ht, AlterTableCmd *cmd)
 	Oid			new_type = TypenameGetTypid(typename_get_unqual_name(coldef->typeName));
 	Dimension  *dim = hyperspace_get_dimension_by_name(ht->space, DIMENSION_TYPE_ANY, cmd->name);
 
+	Oid			old_type;
+
+	/* The values of the new type can hash differently */
+	if (ht->has_bloom_filters)
+		chunk_bloom_filter_delete_by_column(ht, cmd->name);
+
 	if (NULL == dim)
 		return;
 
+	old_type = dim->fd.column_type;
 	dimension_set_type(dim, new_type);
+
+	/*
+	 * PostgreSQL re-adds the dimension constraints of the chunks for the new
+	 * type and checks them while rewriting the chunks. Recreating them from
+	 * the dimension slices costs another full scan of every chunk, which is
+	 * only needed when the re-added constraints can mean something else with
+	 * the new type, e.g., when a cast between time types depends on the time
+	 * zone. A conversion between integer types preserves the values, so the
+	 * constraints are left as they are.
+	 */
+	if (NULL == dim->partitioning &&
+		IS_INTEGER_TYPE(old_type) && IS_INTEGER_TYPE(new_type))
+		return;
+
 	process_utility_set_expect_chunk_modification(true);
 	chunk_recreate_all_constraints_for_dimension(ht->space, dim->fd.id);
 	process_utility_set_expect_chunk_modification(false);
@@ -1578,7 +1949,7 @@ process_create_trigger_start(Node *parsetree)
 	if (stmt->transitionRels != NIL)
 		ereport(ERROR,
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-				 errmsg("Hypertables do not support transition tables in triggers.")));
+				 errmsg("Hypertables do not support transition tables in row-level triggers.")));
 #endif
 }
 
@@ -1593,6 +1964,102 @@ process_create_trigger_end(Node *parsetree)
 	foreach_chunk_relation(stmt->relation, create_trigger_chunk, stmt);
 }
 
+static bool
+rangevar_may_be_hypertable(RangeVar *rv)
+{
+	return NULL != rv &&
+		hypertable_cache_relid_is_relevant(RangeVarGetRelid(rv, NoLock, true));
+}
+
+/*
+ * Check if a command can involve a hypertable or a chunk. Commands on plain
+ * tables, e.g., the COPYs and temporary table DDL of OLTP workloads, then
+ * skip the hypertable cache. Commands that we cannot check cheaply, or that
+ * need handling even on plain tables, are assumed to be relevant.
+ */
+static bool
+process_command_may_involve_hypertable(Node *parsetree)
+{
+	ListCell   *lc;
+
+	switch (nodeTag(parsetree))
+	{
+		case T_CopyStmt:
+			return rangevar_may_be_hypertable(((CopyStmt *) parsetree)->relation);
+		case T_IndexStmt:
+			return rangevar_may_be_hypertable(((IndexStmt *) parsetree)->relation);
+		case T_CreateTrigStmt:
+			return rangevar_may_be_hypertable(((CreateTrigStmt *) parsetree)->relation);
+		case T_TruncateStmt:
+			foreach(lc, ((TruncateStmt *) parsetree)->relations)
+			{
+				if (rangevar_may_be_hypertable(lfirst(lc)))
+					return true;
+			}
+			return false;
+		case T_AlterTableStmt:
+			{
+				AlterTableStmt *stmt = (AlterTableStmt *) parsetree;
+
+				/* Foreign keys of plain tables cannot reference hypertables */
+				foreach(lc, stmt->cmds)
+				{
+					AlterTableCmd *cmd = lfirst(lc);
+
+					if (cmd->subtype == AT_AddConstraint ||
+						cmd->subtype == AT_AddConstraintRecurse)
+						return true;
+				}
+
+				return stmt->relkind == OBJECT_TABLE &&
+					rangevar_may_be_hypertable(stmt->relation);
+			}
+		default:
+			return true;
+	}
+}
+
+/*
+ * An EXPLAIN without ANALYZE plans its query without running it, so the
+ * planner must not change any chunk metadata on behalf of the query.
+ */
+static bool
+process_explain(ProcessUtilityArgs *args)
+{
+	ExplainStmt *stmt = (ExplainStmt *) args->parsetree;
+	bool		prev_explain_only = explain_only;
+	bool		analyze = false;
+	ListCell   *lc;
+
+	foreach(lc, stmt->options)
+	{
+		DefElem    *opt = lfirst(lc);
+
+		if (strcmp(opt->defname, "analyze") == 0)
+			analyze = defGetBoolean(opt);
+	}
+
+	if (analyze)
+		return false;
+
+	explain_only = true;
+
+	PG_TRY();
+	{
+		prev_ProcessUtility(args);
+	}
+	PG_CATCH();
+	{
+		explain_only = prev_explain_only;
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	explain_only = prev_explain_only;
+
+	return true;
+}
+
 /*
  * Handle DDL commands before they have been processed by PostgreSQL.
  */
@@ -1601,6 +2068,9 @@ process_ddl_command_start(ProcessUtilityArgs *args)
 {
 	bool		handled = false;
 
+	if (!process_command_may_involve_hypertable(args->parsetree))
+		return false;
+
 	switch (nodeTag(args->parsetree))
 	{
 		case T_AlterObjectSchemaStmt:
@@ -1616,7 +2086,7 @@ process_ddl_command_start(ProcessUtilityArgs *args)
 			process_rename(args->parsetree);
 			break;
 		case T_IndexStmt:
-			process_index_start(args->parsetree);
+			handled = process_index_start(args);
 			break;
 		case T_CreateTrigStmt:
 			process_create_trigger_start(args->parsetree);
@@ -1647,11 +2117,14 @@ process_ddl_command_start(ProcessUtilityArgs *args)
 			handled = process_vacuum(args->parsetree, args->context);
 			break;
 		case T_ReindexStmt:
-			handled = process_reindex(args->parsetree);
+			handled = process_reindex(args->parsetree, args->context);
 			break;
 		case T_ClusterStmt:
 			handled = process_cluster_start(args->parsetree, args->context);
 			break;
+		case T_ExplainStmt:
+			handled = process_explain(args);
+			break;
 		default:
 			break;
 	}
@@ -1685,10 +2158,9 @@ process_ddl_command_end(CollectedCommand *cmd)
 }
 
 static void
-process_drop_constraint_on_chunk(Hypertable *ht, Oid chunk_relid, void *arg)
+process_drop_constraint_on_chunk(Hypertable *ht, Chunk *chunk, void *arg)
 {
 	char	   *hypertable_constraint_name = arg;
-	Chunk	   *chunk = chunk_get_by_relid(chunk_relid, ht->space->num_dimensions, true);
 
 	/* drop both metadata and table; sql_drop won't be called recursively */
 	chunk_constraint_delete_by_hypertable_constraint_name(chunk->fd.id, hypertable_constraint_name, true, true);
@@ -1713,7 +2185,7 @@ process_drop_table_constraint(EventTriggerDropObject *obj)
 		catalog_become_owner(catalog_get(), &sec_ctx);
 
 		/* Recurse to each chunk and drop the corresponding constraint */
-		foreach_chunk(ht, process_drop_constraint_on_chunk, constraint->constraint_name);
+		foreach_loaded_chunk(ht, process_drop_constraint_on_chunk, constraint->constraint_name);
 
 		catalog_restore_user(&sec_ctx);
 	}
@@ -1949,6 +2421,12 @@ process_utility_set_expect_chunk_modification(bool expect)
 	expect_chunk_modification = expect;
 }
 
+bool
+process_utility_is_explain_only(void)
+{
+	return explain_only;
+}
+
 static void
 process_utility_xact_abort(XactEvent event, void *arg)
 {
@@ -5,5 +5,6 @@
 #include <nodes/plannodes.h>
 
 extern void process_utility_set_expect_chunk_modification(bool expect);
+extern bool process_utility_is_explain_only(void);
 
 #endif							/* TIMESCALEDB_PROCESS_UTILITY_H */
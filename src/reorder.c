@@ -0,0 +1,769 @@
+#include <postgres.h>
+#include <access/genam.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <access/multixact.h>
+#include <access/relscan.h>
+#include <access/rewriteheap.h>
+#include <access/transam.h>
+#include <access/xact.h>
+#include <access/xlog.h>
+#include <catalog/dependency.h>
+#include <catalog/index.h>
+#include <catalog/indexing.h>
+#include <catalog/pg_am.h>
+#include <catalog/pg_class.h>
+#include <catalog/pg_index.h>
+#include <commands/cluster.h>
+#include <commands/defrem.h>
+#include <commands/tablecmds.h>
+#include <commands/vacuum.h>
+#include <miscadmin.h>
+#include <storage/bufmgr.h>
+#include <storage/lmgr.h>
+#include <storage/predicate.h>
+#include <utils/builtins.h>
+#include <utils/lsyscache.h>
+#include <utils/rel.h>
+#include <utils/relcache.h>
+#include <utils/syscache.h>
+#include <utils/tqual.h>
+#include <utils/tuplesort.h>
+
+#include "chunk.h"
+#include "chunk_bloom_filter.h"
+#include "chunk_index.h"
+#include "compress_chunk.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "reorder.h"
+#include "tablespace.h"
+#include "compat.h"
+
+/*
+ * Reorder a chunk, i.e., rewrite it sorted on one of its indexes, like
+ * CLUSTER, without blocking reads for the duration of the rewrite.
+ *
+ * CLUSTER takes an ACCESS EXCLUSIVE lock on the table while it copies the
+ * data and rebuilds the indexes. Instead, the chunk is only locked against
+ * writes (EXCLUSIVE) while the sorted copy and its indexes are built in a
+ * transient table. The lock is then upgraded to ACCESS EXCLUSIVE to swap the
+ * storage of the chunk, its TOAST table, and its indexes with those of the
+ * transient table, which only updates catalog rows.
+ *
+ * Since the chunk is locked against writes, this is meant for chunks that
+ * no longer receive inserts, e.g., chunks of past time intervals. The ACCESS
+ * EXCLUSIVE lock is held until the end of the transaction.
+ *
+ * Moving a chunk to other tablespaces works the same way: the transient table
+ * and its indexes are created in the new tablespaces, so that the swap moves
+ * the chunk. A move can reorder the chunk at the same time, or copy its
+ * tuples in their current order.
+ */
+
+typedef struct ReorderStats
+{
+	double		num_tuples;
+	double		tups_vacuumed;
+	double		tups_recently_dead;
+} ReorderStats;
+
+static void
+reform_and_rewrite_tuple(HeapTuple tuple, TupleDesc desc, Datum *values,
+						 bool *isnull, RewriteState rwstate)
+{
+	HeapTuple	copied;
+	int			i;
+
+	heap_deform_tuple(tuple, desc, values, isnull);
+
+	/* Do not copy the values of dropped columns */
+	for (i = 0; i < desc->natts; i++)
+		if (desc->attrs[i]->attisdropped)
+			isnull[i] = true;
+
+	copied = heap_form_tuple(desc, values, isnull);
+	rewrite_heap_tuple(rwstate, tuple, copied);
+	heap_freetuple(copied);
+}
+
+/*
+ * Copy the tuples of the old heap into the new heap, sorted on the index if
+ * one is given.
+ *
+ * Works like CLUSTER's copy with a sequential scan and sort: tuples that are
+ * dead to all transactions are discarded and the others keep their
+ * visibility information. The TOAST values of the new heap are written with
+ * the OIDs of the old TOAST table, so that the TOAST tables can be swapped by
+ * content.
+ */
+static void
+reorder_copy_data(Relation old_rel, Relation new_rel, Relation index_rel,
+				  TransactionId *frozen_xid, MultiXactId *cutoff_multi,
+				  ReorderStats *stats, int elevel)
+{
+	TupleDesc	desc = RelationGetDescr(old_rel);
+	Datum	   *values = palloc(desc->natts * sizeof(Datum));
+	bool	   *isnull = palloc(desc->natts * sizeof(bool));
+	bool		use_wal = XLogIsNeeded() && RelationNeedsWAL(new_rel);
+	TransactionId oldest_xmin;
+	RewriteState rwstate;
+	Tuplesortstate *tuplesort = NULL;
+	HeapScanDesc scan;
+	HeapTuple	tuple;
+
+	new_rel->rd_toastoid = old_rel->rd_rel->reltoastrelid;
+
+	vacuum_set_xid_limits(old_rel, 0, 0, 0, 0, &oldest_xmin, frozen_xid,
+						  NULL, cutoff_multi, NULL);
+
+	/* The new relfrozenxid and relminmxid cannot go backwards */
+	if (TransactionIdPrecedes(*frozen_xid, old_rel->rd_rel->relfrozenxid))
+		*frozen_xid = old_rel->rd_rel->relfrozenxid;
+	if (MultiXactIdPrecedes(*cutoff_multi, old_rel->rd_rel->relminmxid))
+		*cutoff_multi = old_rel->rd_rel->relminmxid;
+
+	rwstate = begin_heap_rewrite(old_rel, new_rel, oldest_xmin, *frozen_xid,
+								 *cutoff_multi, use_wal);
+
+	if (NULL != index_rel)
+	{
+		ereport(elevel,
+				(errmsg("reordering \"%s.%s\" using sequential scan and sort",
+						get_namespace_name(RelationGetNamespace(old_rel)),
+						RelationGetRelationName(old_rel))));
+
+		tuplesort = tuplesort_begin_cluster(desc, index_rel, maintenance_work_mem, false);
+	}
+	else
+		ereport(elevel,
+				(errmsg("copying \"%s.%s\" using sequential scan",
+						get_namespace_name(RelationGetNamespace(old_rel)),
+						RelationGetRelationName(old_rel))));
+
+	scan = heap_beginscan(old_rel, SnapshotAny, 0, NULL);
+
+	while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		Buffer		buf = scan->rs_cbuf;
+		bool		isdead;
+
+		CHECK_FOR_INTERRUPTS();
+
+		LockBuffer(buf, BUFFER_LOCK_SHARE);
+
+		switch (HeapTupleSatisfiesVacuum(tuple, oldest_xmin, buf))
+		{
+			case HEAPTUPLE_DEAD:
+				isdead = true;
+				break;
+			case HEAPTUPLE_RECENTLY_DEAD:
+				stats->tups_recently_dead += 1;
+				isdead = false;
+				break;
+			case HEAPTUPLE_LIVE:
+				isdead = false;
+				break;
+			case HEAPTUPLE_INSERT_IN_PROGRESS:
+			case HEAPTUPLE_DELETE_IN_PROGRESS:
+
+				/*
+				 * Other transactions cannot have writes in progress since
+				 * the chunk is locked against writes, so these are writes of
+				 * the current transaction
+				 */
+				isdead = false;
+				break;
+			default:
+				elog(ERROR, "unexpected HeapTupleSatisfiesVacuum result");
+				isdead = false; /* keep compiler quiet */
+				break;
+		}
+
+		LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+
+		if (isdead)
+		{
+			stats->tups_vacuumed += 1;
+			/* Keep the update chains of the new heap consistent */
+			rewrite_heap_dead_tuple(rwstate, tuple);
+			continue;
+		}
+
+		stats->num_tuples += 1;
+
+		if (NULL != tuplesort)
+			tuplesort_putheaptuple(tuplesort, tuple);
+		else
+			reform_and_rewrite_tuple(tuple, desc, values, isnull, rwstate);
+	}
+
+	heap_endscan(scan);
+
+	if (NULL != tuplesort)
+	{
+		tuplesort_performsort(tuplesort);
+
+		for (;;)
+		{
+			bool		should_free;
+
+			CHECK_FOR_INTERRUPTS();
+
+			tuple = tuplesort_getheaptuple_compat(tuplesort, true, &should_free);
+
+			if (NULL == tuple)
+				break;
+
+			reform_and_rewrite_tuple(tuple, desc, values, isnull, rwstate);
+
+			if (should_free)
+				heap_freetuple(tuple);
+		}
+
+		tuplesort_end(tuplesort);
+	}
+
+	/* Writes the remaining tuples and syncs the new heap if not WAL-logged */
+	end_heap_rewrite(rwstate);
+
+	new_rel->rd_toastoid = InvalidOid;
+
+	ereport(elevel,
+			(errmsg("\"%s\": found %.0f removable, %.0f nonremovable row versions",
+					RelationGetRelationName(old_rel),
+					stats->tups_vacuumed, stats->num_tuples),
+			 errdetail("%.0f dead row versions cannot be removed yet.",
+					   stats->tups_recently_dead)));
+
+	pfree(values);
+	pfree(isnull);
+}
+
+/*
+ * Create a copy of an index of the old heap on the new heap. The new heap has
+ * the same tuple descriptor as the old one, so the index definition applies
+ * unchanged. The copy is created in the given tablespace, or in the
+ * tablespace of the index if it is invalid.
+ */
+static Oid
+reorder_create_index_copy(Relation new_rel, Oid old_indexrelid, Oid tablespace)
+{
+	Relation	old_index_rel = index_open(old_indexrelid, AccessShareLock);
+	IndexInfo  *indexinfo = BuildIndexInfo(old_index_rel);
+	List	   *colnames = NIL;
+	HeapTuple	tuple;
+	Datum		reloptions;
+	Datum		indclass;
+	bool		isnull;
+	Oid			new_indexrelid;
+	int			i;
+
+	for (i = 0; i < old_index_rel->rd_rel->relnatts; i++)
+		colnames = lappend(colnames, pstrdup(NameStr(old_index_rel->rd_att->attrs[i]->attname)));
+
+	tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(old_indexrelid));
+
+	if (!HeapTupleIsValid(tuple))
+		elog(ERROR, "cache lookup failed for index relation %u", old_indexrelid);
+
+	if (!OidIsValid(tablespace))
+		tablespace = old_index_rel->rd_rel->reltablespace;
+
+	reloptions = SysCacheGetAttr(RELOID, tuple, Anum_pg_class_reloptions, &isnull);
+	indclass = SysCacheGetAttr(INDEXRELID, old_index_rel->rd_indextuple,
+							   Anum_pg_index_indclass, &isnull);
+	Assert(!isnull);
+
+	new_indexrelid = index_create(new_rel,
+								  ChooseRelationName(RelationGetRelationName(new_rel),
+													 NULL,
+													 "index",
+													 RelationGetNamespace(new_rel)),
+								  InvalidOid,
+								  InvalidOid,
+								  indexinfo,
+								  colnames,
+								  old_index_rel->rd_rel->relam,
+								  tablespace,
+								  old_index_rel->rd_indcollation,
+								  ((oidvector *) DatumGetPointer(indclass))->values,
+								  old_index_rel->rd_indoption,
+								  reloptions,
+								  false,	/* is primary */
+								  false,	/* is constraint */
+								  false,	/* deferrable */
+								  false,	/* init deferred */
+								  false,	/* allow system table mods */
+								  false,	/* skip build */
+								  false,	/* concurrent */
+								  true, /* is internal */
+								  false);	/* if not exists */
+
+	ReleaseSysCache(tuple);
+	index_close(old_index_rel, AccessShareLock);
+
+	return new_indexrelid;
+}
+
+/*
+ * Swap the storage, and the statistics that describe it, of two relations.
+ * The frozen XID and the multixact cutoff are set on the first relation if
+ * valid.
+ */
+static void
+reorder_swap_storage(Relation pg_class, Oid relid1, Oid relid2,
+					 TransactionId frozen_xid, MultiXactId cutoff_multi)
+{
+	HeapTuple	tuple1 = SearchSysCacheCopy1(RELOID, ObjectIdGetDatum(relid1));
+	HeapTuple	tuple2 = SearchSysCacheCopy1(RELOID, ObjectIdGetDatum(relid2));
+	Form_pg_class form1;
+	Form_pg_class form2;
+	Oid			relfilenode;
+	Oid			reltablespace;
+	int32		relpages;
+	float4		reltuples;
+	int32		relallvisible;
+
+	if (!HeapTupleIsValid(tuple1))
+		elog(ERROR, "cache lookup failed for relation %u", relid1);
+	if (!HeapTupleIsValid(tuple2))
+		elog(ERROR, "cache lookup failed for relation %u", relid2);
+
+	form1 = (Form_pg_class) GETSTRUCT(tuple1);
+	form2 = (Form_pg_class) GETSTRUCT(tuple2);
+
+	/* Only mapped relations, i.e., some system catalogs, have no relfilenode */
+	Assert(OidIsValid(form1->relfilenode) && OidIsValid(form2->relfilenode));
+
+	relfilenode = form1->relfilenode;
+	reltablespace = form1->reltablespace;
+	relpages = form1->relpages;
+	reltuples = form1->reltuples;
+	relallvisible = form1->relallvisible;
+
+	form1->relfilenode = form2->relfilenode;
+	form1->reltablespace = form2->reltablespace;
+	form1->relpages = form2->relpages;
+	form1->reltuples = form2->reltuples;
+	form1->relallvisible = form2->relallvisible;
+
+	form2->relfilenode = relfilenode;
+	form2->reltablespace = reltablespace;
+	form2->relpages = relpages;
+	form2->reltuples = reltuples;
+	form2->relallvisible = relallvisible;
+
+	if (TransactionIdIsValid(frozen_xid))
+	{
+		form1->relfrozenxid = frozen_xid;
+		form1->relminmxid = cutoff_multi;
+	}
+
+	/* Updating pg_class invalidates the relcache entries of both relations */
+	CatalogTupleUpdate(pg_class, &tuple1->t_self, tuple1);
+	CatalogTupleUpdate(pg_class, &tuple2->t_self, tuple2);
+
+	heap_freetuple(tuple1);
+	heap_freetuple(tuple2);
+}
+
+static Oid
+reorder_get_toast_index(Oid toastrelid)
+{
+	Relation	toast_rel = heap_open(toastrelid, AccessShareLock);
+	List	   *indexes = RelationGetIndexList(toast_rel);
+	Oid			indexrelid;
+
+	if (list_length(indexes) != 1)
+		elog(ERROR, "TOAST table %u does not have exactly one index", toastrelid);
+
+	indexrelid = linitial_oid(indexes);
+	list_free(indexes);
+	heap_close(toast_rel, AccessShareLock);
+
+	return indexrelid;
+}
+
+/*
+ * Rewrite a table, sorted on an index if one is given, holding an ACCESS
+ * EXCLUSIVE lock only to swap in the new storage. The caller has checked the
+ * index.
+ *
+ * The table and its TOAST table are rewritten into the given tablespace and
+ * the indexes into the given index tablespace. Invalid tablespaces keep the
+ * relations in their current tablespaces.
+ */
+static void
+reorder_rel(Oid table_relid, Oid index_relid, Oid tablespace,
+			Oid index_tablespace, bool verbose)
+{
+	int			elevel = verbose ? INFO : DEBUG2;
+	const char *stmt = OidIsValid(tablespace) ? "move_chunk" : "reorder_chunk";
+	Relation	old_rel;
+	Relation	new_rel;
+	Relation	index_rel = NULL;
+	Relation	pg_class;
+	Oid			new_relid;
+	Oid			toast_relid;
+	Oid			new_toast_relid = InvalidOid;
+	Oid			toast_indexrelid = InvalidOid;
+	Oid			new_toast_indexrelid = InvalidOid;
+	char		relpersistence;
+	List	   *old_indexes;
+	List	   *new_indexes = NIL;
+	ListCell   *lc_old,
+			   *lc_new;
+	TransactionId frozen_xid;
+	MultiXactId cutoff_multi;
+	ReorderStats stats = {0};
+	ObjectAddress new_heap_obj;
+
+	/* Block writes, but not reads, while the sorted copy is built */
+	old_rel = heap_open(table_relid, ExclusiveLock);
+
+	if (RELATION_IS_OTHER_TEMP(old_rel))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot reorder temporary tables of other sessions")));
+
+	CheckTableNotInUse(old_rel, stmt);
+
+	if (OidIsValid(index_relid))
+	{
+		check_index_is_clusterable(old_rel, index_relid, false, ExclusiveLock);
+
+		index_rel = index_open(index_relid, ExclusiveLock);
+
+		if (index_rel->rd_rel->relam != BTREE_AM_OID)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("cannot reorder on index \"%s\": only B-tree indexes are supported",
+							RelationGetRelationName(index_rel))));
+	}
+
+	if (!OidIsValid(tablespace))
+		tablespace = old_rel->rd_rel->reltablespace;
+
+	toast_relid = old_rel->rd_rel->reltoastrelid;
+	relpersistence = old_rel->rd_rel->relpersistence;
+
+	/* TOAST values are read, but not written, while the copy is built */
+	if (OidIsValid(toast_relid))
+		LockRelationOid(toast_relid, ExclusiveLock);
+
+	new_relid = make_new_heap(table_relid, tablespace, relpersistence, ExclusiveLock);
+	new_rel = heap_open(new_relid, AccessExclusiveLock);
+
+	if (OidIsValid(toast_relid) != OidIsValid(new_rel->rd_rel->reltoastrelid))
+		elog(ERROR, "TOAST table of \"%s\" does not match its copy",
+			 RelationGetRelationName(old_rel));
+
+	reorder_copy_data(old_rel, new_rel, index_rel, &frozen_xid, &cutoff_multi,
+					  &stats, elevel);
+
+	/* Build the indexes of the copy, in the same order as the chunk's */
+	old_indexes = RelationGetIndexList(old_rel);
+
+	foreach(lc_old, old_indexes)
+		new_indexes = lappend_oid(new_indexes,
+								  reorder_create_index_copy(new_rel, lfirst_oid(lc_old),
+															index_tablespace));
+
+	if (NULL != index_rel)
+		index_close(index_rel, NoLock);
+
+	/*
+	 * Swap in the new storage. This waits for the reads that are in progress
+	 * and blocks new ones, but is quick, since only catalog rows change.
+	 */
+	if (OidIsValid(toast_relid))
+	{
+		new_toast_relid = new_rel->rd_rel->reltoastrelid;
+		toast_indexrelid = reorder_get_toast_index(toast_relid);
+		new_toast_indexrelid = reorder_get_toast_index(new_toast_relid);
+	}
+
+	LockRelationOid(table_relid, AccessExclusiveLock);
+	TransferPredicateLocksToHeapRelation(old_rel);
+
+	pg_class = heap_open(RelationRelationId, RowExclusiveLock);
+
+	reorder_swap_storage(pg_class, table_relid, new_relid, frozen_xid, cutoff_multi);
+
+	if (OidIsValid(toast_relid))
+	{
+		reorder_swap_storage(pg_class, toast_relid, new_toast_relid,
+							 frozen_xid, cutoff_multi);
+		reorder_swap_storage(pg_class, toast_indexrelid, new_toast_indexrelid,
+							 InvalidTransactionId, InvalidMultiXactId);
+	}
+
+	forboth(lc_old, old_indexes, lc_new, new_indexes)
+		reorder_swap_storage(pg_class, lfirst_oid(lc_old), lfirst_oid(lc_new),
+							 InvalidTransactionId, InvalidMultiXactId);
+
+	heap_close(pg_class, RowExclusiveLock);
+
+	CommandCounterIncrement();
+
+	/* Remember the index for the next reorder or CLUSTER without an index */
+	if (OidIsValid(index_relid))
+		mark_index_clustered(old_rel, index_relid, true);
+
+	heap_close(new_rel, NoLock);
+	heap_close(old_rel, NoLock);
+
+	/*
+	 * Drop the transient table, which now has the old storage, with its
+	 * TOAST table and indexes
+	 */
+	new_heap_obj.classId = RelationRelationId;
+	new_heap_obj.objectId = new_relid;
+	new_heap_obj.objectSubId = 0;
+	performDeletion(&new_heap_obj, DROP_RESTRICT, PERFORM_DELETION_INTERNAL);
+
+	list_free(old_indexes);
+	list_free(new_indexes);
+}
+
+/*
+ * Check if a chunk was last reordered or clustered on an index.
+ */
+bool
+reorder_index_is_clustered(Oid index_relid)
+{
+	HeapTuple	tuple = SearchSysCache1(INDEXRELID, ObjectIdGetDatum(index_relid));
+	bool		isclustered;
+
+	if (!HeapTupleIsValid(tuple))
+		elog(ERROR, "cache lookup failed for index %u", index_relid);
+
+	isclustered = ((Form_pg_index) GETSTRUCT(tuple))->indisclustered;
+	ReleaseSysCache(tuple);
+
+	return isclustered;
+}
+
+/*
+ * Find the index that a chunk was last reordered or clustered on.
+ */
+static Oid
+reorder_get_clustered_index(Oid chunk_relid)
+{
+	Relation	rel = heap_open(chunk_relid, AccessShareLock);
+	List	   *indexes = RelationGetIndexList(rel);
+	Oid			index_relid = InvalidOid;
+	ListCell   *lc;
+
+	foreach(lc, indexes)
+	{
+		if (reorder_index_is_clustered(lfirst_oid(lc)))
+		{
+			index_relid = lfirst_oid(lc);
+			break;
+		}
+	}
+
+	list_free(indexes);
+	heap_close(rel, AccessShareLock);
+
+	return index_relid;
+}
+
+static Chunk *
+reorder_get_chunk(Oid chunk_relid)
+{
+	Chunk	   *chunk = chunk_get_by_relid(chunk_relid, 0, false);
+
+	if (NULL == chunk)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("\"%s\" is not a chunk", get_rel_name(chunk_relid))));
+
+	hypertable_permissions_check(chunk->hypertable_relid, GetUserId());
+
+	return chunk;
+}
+
+/*
+ * Get the index of a chunk to reorder on: either an index of the chunk, or the
+ * chunk's copy of an index of its hypertable.
+ */
+static Oid
+reorder_get_chunk_index(Chunk *chunk, Oid index_relid)
+{
+	if (IndexGetRelation(index_relid, true) == chunk->hypertable_relid)
+	{
+		ChunkIndexMapping *cim = chunk_index_get_by_hypertable_indexrelid(chunk, index_relid);
+
+		if (NULL == cim)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_OBJECT),
+					 errmsg("chunk \"%s\" has no copy of index \"%s\"",
+							get_rel_name(chunk->table_id), get_rel_name(index_relid))));
+
+		return cim->indexoid;
+	}
+
+	if (IndexGetRelation(index_relid, true) != chunk->table_id)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("\"%s\" is not an index of chunk \"%s\" or its hypertable",
+						get_rel_name(index_relid), get_rel_name(chunk->table_id))));
+
+	return index_relid;
+}
+
+/*
+ * Reorder a chunk on an index of the chunk, or on the chunk's copy of an index
+ * of its hypertable. Without an index, the chunk is reordered on the index it
+ * was last reordered or clustered on.
+ */
+void
+reorder_chunk(Oid chunk_relid, Oid index_relid, bool verbose)
+{
+	Chunk	   *chunk = reorder_get_chunk(chunk_relid);
+
+	if (!OidIsValid(index_relid))
+	{
+		index_relid = reorder_get_clustered_index(chunk_relid);
+
+		if (!OidIsValid(index_relid))
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_OBJECT),
+					 errmsg("there is no previously clustered index for chunk \"%s\"",
+							get_rel_name(chunk_relid))));
+	}
+	else
+		index_relid = reorder_get_chunk_index(chunk, index_relid);
+
+	reorder_rel(chunk_relid, index_relid, InvalidOid, InvalidOid, verbose);
+
+	/* A chunk is reordered once it is complete, so build its filters now */
+	chunk_bloom_filter_build(chunk);
+}
+
+/*
+ * Move a chunk, and its compressed table if it has one, to tablespaces that
+ * are attached to its hypertable. The indexes of the chunk are moved to the
+ * index tablespace, or to the data tablespace if none is given. With an
+ * index, the chunk is also reordered on it, like reorder_chunk().
+ */
+void
+move_chunk(Oid chunk_relid, Name tablespace, Name index_tablespace,
+		   Oid index_relid, bool verbose)
+{
+	Chunk	   *chunk = reorder_get_chunk(chunk_relid);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = hypertable_cache_get_entry(hcache, chunk->hypertable_relid);
+	Oid			tspc_oid;
+	Oid			index_tspc_oid;
+	CompressedChunk *cc;
+
+	tspc_oid = tablespace_get_attached_oid(ht, NameStr(*tablespace));
+	index_tspc_oid = NULL == index_tablespace ? tspc_oid :
+		tablespace_get_attached_oid(ht, NameStr(*index_tablespace));
+
+	cache_release(hcache);
+
+	if (OidIsValid(index_relid))
+		index_relid = reorder_get_chunk_index(chunk, index_relid);
+
+	reorder_rel(chunk_relid, index_relid, tspc_oid, index_tspc_oid, verbose);
+
+	if (OidIsValid(index_relid))
+		chunk_bloom_filter_build(chunk);
+
+	cc = compressed_chunk_get_by_chunk_id(chunk->fd.id);
+
+	if (NULL != cc)
+		reorder_rel(cc->compressed_relid, InvalidOid, tspc_oid, index_tspc_oid, verbose);
+}
+
+static Oid
+reorder_get_rel_tablespace(Oid relid)
+{
+	Oid			tspc_oid = get_rel_tablespace(relid);
+
+	/* Relations in the database's default tablespace have no tablespace set */
+	return OidIsValid(tspc_oid) ? tspc_oid : MyDatabaseTableSpace;
+}
+
+/*
+ * Check if a chunk and its indexes are in the given tablespaces, i.e., if
+ * move_chunk() would not move anything but the chunk's compressed table.
+ */
+bool
+move_chunk_is_in_tablespaces(Oid chunk_relid, Oid tablespace, Oid index_tablespace)
+{
+	Relation	rel;
+	List	   *indexes;
+	ListCell   *lc;
+	bool		result = true;
+
+	if (reorder_get_rel_tablespace(chunk_relid) != tablespace)
+		return false;
+
+	rel = heap_open(chunk_relid, AccessShareLock);
+	indexes = RelationGetIndexList(rel);
+
+	foreach(lc, indexes)
+	{
+		if (reorder_get_rel_tablespace(lfirst_oid(lc)) != index_tablespace)
+		{
+			result = false;
+			break;
+		}
+	}
+
+	list_free(indexes);
+	heap_close(rel, AccessShareLock);
+
+	return result;
+}
+
+TS_FUNCTION_INFO_V1(reorder_chunk_sql);
+
+Datum
+reorder_chunk_sql(PG_FUNCTION_ARGS)
+{
+	Oid			chunk_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Oid			index_relid = PG_ARGISNULL(1) ? InvalidOid : PG_GETARG_OID(1);
+	bool		verbose = PG_ARGISNULL(2) ? false : PG_GETARG_BOOL(2);
+
+	if (!OidIsValid(chunk_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid chunk: cannot be NULL")));
+
+	reorder_chunk(chunk_relid, index_relid, verbose);
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(move_chunk_sql);
+
+Datum
+move_chunk_sql(PG_FUNCTION_ARGS)
+{
+	Oid			chunk_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Name		tablespace = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1);
+	Name		index_tablespace = PG_ARGISNULL(2) ? NULL : PG_GETARG_NAME(2);
+	Oid			index_relid = PG_ARGISNULL(3) ? InvalidOid : PG_GETARG_OID(3);
+	bool		verbose = PG_ARGISNULL(4) ? false : PG_GETARG_BOOL(4);
+
+	if (!OidIsValid(chunk_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid chunk: cannot be NULL")));
+
+	if (NULL == tablespace)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid tablespace: cannot be NULL")));
+
+	move_chunk(chunk_relid, tablespace, index_tablespace, index_relid, verbose);
+
+	PG_RETURN_VOID();
+}
@@ -0,0 +1,12 @@
+#ifndef TIMESCALEDB_REORDER_H
+#define TIMESCALEDB_REORDER_H
+
+#include <postgres.h>
+
+extern void reorder_chunk(Oid chunk_relid, Oid index_relid, bool verbose);
+extern bool reorder_index_is_clustered(Oid index_relid);
+extern void move_chunk(Oid chunk_relid, Name tablespace, Name index_tablespace,
+		   Oid index_relid, bool verbose);
+extern bool move_chunk_is_in_tablespaces(Oid chunk_relid, Oid tablespace, Oid index_tablespace);
+
+#endif							/* TIMESCALEDB_REORDER_H */
@@ -5,8 +5,11 @@
 #include <storage/bufmgr.h>
 #include <utils/rel.h>
 #include <utils/tqual.h>
+#include <utils/array.h>
+#include <catalog/pg_type.h>
 
 #include "scanner.h"
+#include "timing.h"
 
 typedef union ScanDesc
 {
@@ -155,15 +158,26 @@ scanner_scan(ScannerCtx *ctx)
 	TupleDesc	tuple_desc;
 	bool		is_valid;
 	Scanner    *scanner;
+	TimingState timing;
 
 	InternalScannerCtx ictx = {
 		.sctx = ctx,
 	};
 
+	timing_begin(&timing, TIMING_CATALOG_SCAN);
+
 	if (OidIsValid(ctx->index))
 		scanner = &scanners[ScannerTypeIndex];
 	else
+	{
+		int			i;
+
+		for (i = 0; i < ctx->nkeys; i++)
+			if (ctx->scankey[i].sk_flags & SK_SEARCHARRAY)
+				elog(ERROR, "array scan keys require an index scan");
+
 		scanner = &scanners[ScannerTypeHeap];
+	}
 
 	scanner->openheap(&ictx);
 	scanner->beginscan(&ictx);
@@ -222,6 +236,8 @@ scanner_scan(ScannerCtx *ctx)
 	scanner->endscan(&ictx);
 	scanner->closeheap(&ictx);
 
+	timing_end(&timing, ctx->table);
+
 	return ictx.tinfo.count;
 }
 
@@ -247,3 +263,35 @@ scanner_scan_one(ScannerCtx *ctx, bool fail_if_not_found, char *item_type)
 			return false;
 	}
 }
+
+/*
+ * Initialize a scan key that matches any of the given int4 values.
+ *
+ * This makes it possible to do many lookups in a single index scan, e.g., to
+ * get the constraints of all chunks of a hypertable, instead of beginning and
+ * ending a scan for each key. The B-tree sorts and deduplicates the values, and
+ * then visits the matching entries in one traversal of the index. Only index
+ * scans support such keys and, to be efficient, the key should be on the
+ * index's leading column.
+ */
+void
+scanner_scankey_init_int32_array(ScanKey entry, AttrNumber attno, int32 *values, int num_values)
+{
+	Datum	   *elems = palloc(sizeof(Datum) * num_values);
+	ArrayType  *array;
+	int			i;
+
+	for (i = 0; i < num_values; i++)
+		elems[i] = Int32GetDatum(values[i]);
+
+	array = construct_array(elems, num_values, INT4OID, sizeof(int32), true, 'i');
+
+	ScanKeyEntryInitialize(entry,
+						   SK_SEARCHARRAY,
+						   attno,
+						   BTEqualStrategyNumber,
+						   INT4OID,
+						   InvalidOid,
+						   F_INT4EQ,
+						   PointerGetDatum(array));
+}
@@ -84,6 +84,7 @@ typedef struct ScannerCtx
  * tuples. */
 int			scanner_scan(ScannerCtx *ctx);
 bool		scanner_scan_one(ScannerCtx *ctx, bool fail_if_not_found, char *item_type);
+void		scanner_scankey_init_int32_array(ScanKey entry, AttrNumber attno, int32 *values, int num_values);
 
 
 #endif							/* TIMESCALEDB_SCANNER_H */
@@ -0,0 +1,468 @@
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <catalog/pg_class.h>
+#include <common/relpath.h>
+#include <funcapi.h>
+#include <storage/smgr.h>
+#include <utils/builtins.h>
+#include <utils/hsearch.h>
+#include <utils/lsyscache.h>
+#include <utils/rel.h>
+#include <utils/syscache.h>
+
+#include "catalog.h"
+#include "chunk.h"
+#include "compress_chunk.h"
+#include "errors.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "scanner.h"
+#include "compat.h"
+
+/*
+ * Size functions for hypertables.
+ *
+ * The sizes are calculated from the chunks as found in the catalog, opening
+ * each chunk and its indexes and TOAST table once. This avoids joining the
+ * catalog with pg_class and calling pg_total_relation_size() and friends per
+ * chunk, which look up every relation again by name and OID.
+ */
+
+typedef struct RelationSize
+{
+	int64		table_bytes;
+	int64		index_bytes;
+	int64		toast_bytes;	/* -1 if there is no TOAST table */
+	int64		total_bytes;
+} RelationSize;
+
+enum Anum_chunk_sizes
+{
+	Anum_chunk_sizes_chunk_id = 1,
+	Anum_chunk_sizes_table_bytes,
+	Anum_chunk_sizes_index_bytes,
+	Anum_chunk_sizes_toast_bytes,
+	Anum_chunk_sizes_total_bytes,
+	_Anum_chunk_sizes_max,
+};
+
+#define Natts_chunk_sizes \
+	(_Anum_chunk_sizes_max - 1)
+
+enum Anum_index_sizes
+{
+	Anum_index_sizes_index_name = 1,
+	Anum_index_sizes_total_bytes,
+	_Anum_index_sizes_max,
+};
+
+#define Natts_index_sizes \
+	(_Anum_index_sizes_max - 1)
+
+/*
+ * Get the size of all forks of a relation, like pg_table_size() without
+ * TOAST.
+ */
+static int64
+relation_fork_bytes(Relation rel)
+{
+	int64		bytes = 0;
+	ForkNumber	forknum;
+
+	RelationOpenSmgr(rel);
+
+	for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
+		if (smgrexists(rel->rd_smgr, forknum))
+			bytes += (int64) smgrnblocks(rel->rd_smgr, forknum) * BLCKSZ;
+
+	return bytes;
+}
+
+/*
+ * Get the size of the relation with the given OID, or -1 if it does not
+ * exist, e.g., because it was dropped concurrently.
+ */
+static int64
+relation_bytes(Oid relid)
+{
+	Relation	rel = try_relation_open(relid, AccessShareLock);
+	int64		bytes;
+
+	if (NULL == rel)
+		return -1;
+
+	bytes = relation_fork_bytes(rel);
+	relation_close(rel, AccessShareLock);
+
+	return bytes;
+}
+
+/*
+ * Get the size of the indexes of a relation, like pg_indexes_size().
+ */
+static int64
+relation_index_bytes(Relation rel)
+{
+	List	   *indexes = RelationGetIndexList(rel);
+	int64		bytes = 0;
+	ListCell   *lc;
+
+	foreach(lc, indexes)
+	{
+		int64		index_bytes = relation_bytes(lfirst_oid(lc));
+
+		if (index_bytes > 0)
+			bytes += index_bytes;
+	}
+
+	list_free(indexes);
+
+	return bytes;
+}
+
+/*
+ * Get the sizes of a table, its indexes, and its TOAST table with the TOAST
+ * table's index, like pg_total_relation_size() and its parts.
+ *
+ * Returns false if the table does not exist.
+ */
+static bool
+relation_get_size(Oid relid, RelationSize *size)
+{
+	Relation	rel = try_relation_open(relid, AccessShareLock);
+
+	if (NULL == rel)
+		return false;
+
+	size->table_bytes = relation_fork_bytes(rel);
+	size->index_bytes = relation_index_bytes(rel);
+	size->toast_bytes = -1;
+
+	if (OidIsValid(rel->rd_rel->reltoastrelid))
+	{
+		Relation	toastrel = try_relation_open(rel->rd_rel->reltoastrelid, AccessShareLock);
+
+		if (NULL != toastrel)
+		{
+			size->toast_bytes = relation_fork_bytes(toastrel) +
+				relation_index_bytes(toastrel);
+			relation_close(toastrel, AccessShareLock);
+		}
+	}
+
+	size->total_bytes = size->table_bytes + size->index_bytes +
+		Max(size->toast_bytes, 0);
+
+	relation_close(rel, AccessShareLock);
+
+	return true;
+}
+
+/*
+ * Add the size of a chunk's compressed table, if any, to the size of the
+ * chunk, since most of a compressed chunk's data is in its compressed table.
+ */
+static void
+chunk_add_compressed_size(Chunk *chunk, RelationSize *size)
+{
+	CompressedChunk *cc = compressed_chunk_get_by_chunk_id(chunk->fd.id);
+	RelationSize compressed_size;
+
+	if (NULL == cc || !OidIsValid(cc->compressed_relid) ||
+		!relation_get_size(cc->compressed_relid, &compressed_size))
+		return;
+
+	size->table_bytes += compressed_size.table_bytes;
+	size->index_bytes += compressed_size.index_bytes;
+	size->total_bytes += compressed_size.total_bytes;
+
+	if (compressed_size.toast_bytes >= 0)
+		size->toast_bytes = Max(size->toast_bytes, 0) + compressed_size.toast_bytes;
+}
+
+static Hypertable *
+size_get_hypertable(Cache *hcache, Oid table_relid)
+{
+	Hypertable *ht = hypertable_cache_get_entry(hcache, table_relid);
+
+	if (NULL == ht)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_HYPERTABLE_NOT_EXIST),
+				 errmsg("table \"%s\" is not a hypertable",
+						get_rel_name(table_relid))));
+
+	return ht;
+}
+
+static List *
+chunk_sizes_collect(Oid table_relid, TupleDesc tupdesc)
+{
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = size_get_hypertable(hcache, table_relid);
+	List	   *chunks = chunk_get_all_by_hypertable_id(ht->fd.id, 0);
+	List	   *tuples = NIL;
+	ListCell   *lc;
+
+	foreach(lc, chunks)
+	{
+		Chunk	   *chunk = lfirst(lc);
+		Datum		values[Natts_chunk_sizes];
+		bool		nulls[Natts_chunk_sizes] = {false};
+		RelationSize size;
+
+		if (!relation_get_size(chunk->table_id, &size))
+			continue;
+
+		if (ht->has_compressed_chunks)
+			chunk_add_compressed_size(chunk, &size);
+
+		values[Anum_chunk_sizes_chunk_id - 1] = Int32GetDatum(chunk->fd.id);
+		values[Anum_chunk_sizes_table_bytes - 1] = Int64GetDatum(size.table_bytes);
+		values[Anum_chunk_sizes_index_bytes - 1] = Int64GetDatum(size.index_bytes);
+		values[Anum_chunk_sizes_toast_bytes - 1] = Int64GetDatum(size.toast_bytes);
+		nulls[Anum_chunk_sizes_toast_bytes - 1] = size.toast_bytes < 0;
+		values[Anum_chunk_sizes_total_bytes - 1] = Int64GetDatum(size.total_bytes);
+
+		tuples = lappend(tuples, heap_form_tuple(tupdesc, values, nulls));
+	}
+
+	cache_release(hcache);
+
+	return tuples;
+}
+
+typedef struct ChunkNamespaceEntry
+{
+	int32		chunk_id;
+	Oid			namespaceid;
+} ChunkNamespaceEntry;
+
+typedef struct IndexSize
+{
+	NameData	hypertable_index_name;
+	int64		bytes;
+} IndexSize;
+
+typedef struct IndexSizesCtx
+{
+	HTAB	   *chunk_namespaces;
+	List	   *sizes;
+} IndexSizesCtx;
+
+static bool
+index_sizes_tuple_found(TupleInfo *ti, void *data)
+{
+	IndexSizesCtx *ctx = data;
+	Form_chunk_index form = (Form_chunk_index) GETSTRUCT(ti->tuple);
+	ChunkNamespaceEntry *entry = hash_search(ctx->chunk_namespaces, &form->chunk_id,
+											 HASH_FIND, NULL);
+	IndexSize  *size = NIL == ctx->sizes ? NULL : llast(ctx->sizes);
+	int64		bytes;
+
+	if (NULL == entry)
+		return true;
+
+	/* The tuples are ordered by hypertable index name */
+	if (NULL == size || namestrcmp(&size->hypertable_index_name,
+								   NameStr(form->hypertable_index_name)) != 0)
+	{
+		size = palloc0(sizeof(IndexSize));
+		size->hypertable_index_name = form->hypertable_index_name;
+		ctx->sizes = lappend(ctx->sizes, size);
+	}
+
+	bytes = relation_bytes(get_relname_relid(NameStr(form->index_name), entry->namespaceid));
+
+	if (bytes > 0)
+		size->bytes += bytes;
+
+	return true;
+}
+
+/*
+ * Collect the total size of each index of a hypertable across the hypertable's
+ * chunks. Indexes that have no chunk indexes, e.g., because the hypertable has
+ * no chunks, are left out.
+ *
+ * All chunk indexes are found with a single scan of the chunk_index catalog
+ * table, and the chunks' schemas with a single load of the chunks.
+ */
+static List *
+index_sizes_collect(Oid table_relid, TupleDesc tupdesc)
+{
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = size_get_hypertable(hcache, table_relid);
+	List	   *chunks = chunk_get_all_by_hypertable_id(ht->fd.id, 0);
+	Catalog    *catalog = catalog_get();
+	struct HASHCTL hctl = {
+		.keysize = sizeof(int32),
+		.entrysize = sizeof(ChunkNamespaceEntry),
+		.hcxt = CurrentMemoryContext,
+	};
+	IndexSizesCtx ctx = {
+		.chunk_namespaces = hash_create("chunk-namespace-htab", list_length(chunks) + 1,
+										&hctl, HASH_ELEM | HASH_CONTEXT | HASH_BLOBS),
+	};
+	ScanKeyData scankey[1];
+	ScannerCtx	scanctx = {
+		.table = catalog_table_get_id(catalog, CHUNK_INDEX),
+		.index = CATALOG_INDEX(catalog, CHUNK_INDEX, CHUNK_INDEX_HYPERTABLE_ID_HYPERTABLE_INDEX_NAME_IDX),
+		.nkeys = 1,
+		.scankey = scankey,
+		.tuple_found = index_sizes_tuple_found,
+		.data = &ctx,
+		.lockmode = AccessShareLock,
+		.scandirection = ForwardScanDirection,
+	};
+	List	   *tuples = NIL;
+	ListCell   *lc;
+
+	foreach(lc, chunks)
+	{
+		Chunk	   *chunk = lfirst(lc);
+		ChunkNamespaceEntry *entry = hash_search(ctx.chunk_namespaces, &chunk->fd.id,
+												 HASH_ENTER, NULL);
+
+		entry->namespaceid = get_rel_namespace(chunk->table_id);
+	}
+
+	ScanKeyInit(&scankey[0],
+				Anum_chunk_index_hypertable_id_hypertable_index_name_idx_hypertable_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(ht->fd.id));
+
+	scanner_scan(&scanctx);
+
+	foreach(lc, ctx.sizes)
+	{
+		IndexSize  *size = lfirst(lc);
+		Datum		values[Natts_index_sizes];
+		bool		nulls[Natts_index_sizes] = {false};
+
+		values[Anum_index_sizes_index_name - 1] =
+			CStringGetTextDatum(psprintf("%s.%s", NameStr(ht->fd.schema_name),
+										 NameStr(size->hypertable_index_name)));
+		values[Anum_index_sizes_total_bytes - 1] = Int64GetDatum(size->bytes);
+
+		tuples = lappend(tuples, heap_form_tuple(tupdesc, values, nulls));
+	}
+
+	hash_destroy(ctx.chunk_namespaces);
+	cache_release(hcache);
+
+	return tuples;
+}
+
+typedef List *(*size_collect_func) (Oid table_relid, TupleDesc tupdesc);
+
+/*
+ * Return the rows collected by a size function, one per call.
+ */
+static Datum
+size_srf(FunctionCallInfo fcinfo, size_collect_func collect)
+{
+	FuncCallContext *funcctx;
+	List	   *tuples;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			elog(ERROR, "Function returning record called in context that cannot accept type record");
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+		funcctx->user_fctx = collect(PG_GETARG_OID(0), funcctx->tuple_desc);
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	tuples = funcctx->user_fctx;
+
+	if (funcctx->call_cntr < (uint64) list_length(tuples))
+	{
+		HeapTuple	tuple = list_nth(tuples, funcctx->call_cntr);
+
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+TS_FUNCTION_INFO_V1(hypertable_chunk_sizes);
+
+/*
+ * Get the table, index, and TOAST size of each chunk of a hypertable.
+ */
+Datum
+hypertable_chunk_sizes(PG_FUNCTION_ARGS)
+{
+	return size_srf(fcinfo, chunk_sizes_collect);
+}
+
+TS_FUNCTION_INFO_V1(hypertable_index_sizes);
+
+/*
+ * Get the total size of each index of a hypertable across all chunks.
+ */
+Datum
+hypertable_index_sizes(PG_FUNCTION_ARGS)
+{
+	return size_srf(fcinfo, index_sizes_collect);
+}
+
+TS_FUNCTION_INFO_V1(hypertable_approximate_row_count);
+
+/*
+ * Get the approximate number of rows in a hypertable, as the sum of the row
+ * estimates (reltuples) of its chunks. The estimates are those of the last
+ * VACUUM or ANALYZE, so chunks that have not been vacuumed or analyzed yet
+ * count as empty. Compressed chunks count with the number of rows they had
+ * when they were compressed.
+ */
+Datum
+hypertable_approximate_row_count(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_GETARG_OID(0);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = size_get_hypertable(hcache, table_relid);
+	List	   *chunks = chunk_get_all_by_hypertable_id(ht->fd.id, 0);
+	double		row_count = 0;
+	ListCell   *lc;
+
+	foreach(lc, chunks)
+	{
+		Chunk	   *chunk = lfirst(lc);
+		HeapTuple	tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(chunk->table_id));
+
+		if (HeapTupleIsValid(tuple))
+		{
+			Form_pg_class form = (Form_pg_class) GETSTRUCT(tuple);
+
+			if (form->reltuples > 0)
+				row_count += form->reltuples;
+
+			ReleaseSysCache(tuple);
+		}
+	}
+
+	if (ht->has_compressed_chunks)
+	{
+		foreach(lc, chunks)
+		{
+			Chunk	   *chunk = lfirst(lc);
+			CompressedChunk *cc = compressed_chunk_get_by_chunk_id(chunk->fd.id);
+
+			if (NULL != cc)
+				row_count += cc->fd.num_rows;
+		}
+	}
+
+	cache_release(hcache);
+
+	PG_RETURN_INT64((int64) row_count);
+}
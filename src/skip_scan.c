@@ -0,0 +1,538 @@
+#include <postgres.h>
+#include <access/genam.h>
+#include <access/nbtree.h>
+#include <access/relscan.h>
+#include <catalog/pg_am.h>
+#include <catalog/pg_index.h>
+#include <executor/executor.h>
+#include <nodes/extensible.h>
+#include <nodes/nodeFuncs.h>
+#include <nodes/plannodes.h>
+#include <optimizer/pathnode.h>
+#include <optimizer/paths.h>
+#include <optimizer/tlist.h>
+#include <utils/datum.h>
+#include <utils/lsyscache.h>
+#include <utils/rel.h>
+#include <utils/selfuncs.h>
+
+#include "compat-msvc-enter.h"
+#include <optimizer/cost.h>
+#include "compat-msvc-exit.h"
+
+#include "skip_scan.h"
+#include "compat.h"
+
+/*
+ * SkipScan returns only the first tuple of each distinct value of the leading
+ * column of a btree index.
+ *
+ * For a query like
+ *
+ *	SELECT DISTINCT ON (device_id) * FROM metrics ORDER BY device_id, time DESC;
+ *
+ * the standard planner runs a Unique over the ordered scans of all chunks,
+ * which reads every tuple of every chunk even if there are only a few
+ * devices. With an index on (device_id, time DESC), the first tuple of each
+ * device in a chunk is the only one that the Unique keeps. SkipScan runs the
+ * chunk's index scan until it returns a tuple, and then restarts the scan
+ * with a key on the leading column that skips to the next device. The chunks
+ * are still merged below the Unique, which picks the first tuple of each
+ * device across chunks.
+ *
+ * The key is added to the index scan's own scan keys when the executor
+ * starts, so the plan shows the index scan as the planner made it.
+ */
+
+static void
+skip_scan_set_key(SkipScanState *state)
+{
+	ScanKey		key = state->skip_key;
+
+	switch (state->stage)
+	{
+		case SKIP_SCAN_NULLS:
+			ScanKeyEntryInitialize(key, state->skip_flags | SK_ISNULL | SK_SEARCHNULL, 1,
+								   InvalidStrategy, InvalidOid, InvalidOid, InvalidOid,
+								   (Datum) 0);
+			break;
+		case SKIP_SCAN_NOT_NULL:
+			ScanKeyEntryInitialize(key, state->skip_flags | SK_ISNULL | SK_SEARCHNOTNULL, 1,
+								   InvalidStrategy, InvalidOid, InvalidOid, InvalidOid,
+								   (Datum) 0);
+			break;
+		case SKIP_SCAN_VALUES:
+			ScanKeyEntryInitialize(key, state->skip_flags, 1, state->next_strategy,
+								   state->next_subtype, state->next_collation,
+								   state->next_proc, state->prev_value);
+			break;
+		case SKIP_SCAN_DONE:
+			return;
+	}
+
+	state->needs_rescan = true;
+}
+
+/*
+ * Move on to the next stage when the scan of the current one is exhausted,
+ * or when the tuple with a NULL was found.
+ */
+static void
+skip_scan_next_stage(SkipScanState *state)
+{
+	switch (state->stage)
+	{
+		case SKIP_SCAN_NULLS:
+			state->stage = state->nulls_first ? SKIP_SCAN_NOT_NULL : SKIP_SCAN_DONE;
+			break;
+		case SKIP_SCAN_NOT_NULL:
+		case SKIP_SCAN_VALUES:
+			state->stage = state->nulls_first ? SKIP_SCAN_DONE : SKIP_SCAN_NULLS;
+			break;
+		case SKIP_SCAN_DONE:
+			break;
+	}
+
+	skip_scan_set_key(state);
+}
+
+static void
+skip_scan_reset(SkipScanState *state)
+{
+	state->stage = state->nulls_first ? SKIP_SCAN_NULLS : SKIP_SCAN_NOT_NULL;
+	skip_scan_set_key(state);
+}
+
+/*
+ * Add the skip key to the scan keys of the index scan. The index scan was
+ * started with its own keys, and btree sizes its scan state by the number of
+ * keys, so the scan is started over with one more key.
+ */
+static ScanKey
+skip_scan_add_key(EState *estate, Relation heaprel, Relation indexrel, ScanKey *keys,
+				  int *num_keys, IndexRuntimeKeyInfo *runtime_keys, int num_runtime_keys,
+				  int num_orderbys, IndexScanDesc *scandesc)
+{
+	ScanKey		new_keys = palloc0(sizeof(ScanKeyData) * (*num_keys + 1));
+	int			i;
+
+	if (*num_keys > 0)
+		memcpy(new_keys, *keys, sizeof(ScanKeyData) * *num_keys);
+
+	/* Runtime keys point into the array of scan keys */
+	for (i = 0; i < num_runtime_keys; i++)
+		runtime_keys[i].scan_key = new_keys + (runtime_keys[i].scan_key - *keys);
+
+	*keys = new_keys;
+	(*num_keys)++;
+
+	if (NULL != *scandesc)
+		index_endscan(*scandesc);
+
+	*scandesc = index_beginscan(heaprel, indexrel, estate->es_snapshot, *num_keys, num_orderbys);
+
+	return &new_keys[*num_keys - 1];
+}
+
+static void
+skip_scan_begin(CustomScanState *node, EState *estate, int eflags)
+{
+	SkipScanState *state = (SkipScanState *) node;
+	CustomScan *cscan = (CustomScan *) node->ss.ps.plan;
+	Plan	   *subplan = linitial(cscan->custom_plans);
+	TargetEntry *tle;
+	Relation	indexrel;
+	ScanDirection dir;
+	int16		indoption;
+
+	state->child = ExecInitNode(subplan, estate, eflags);
+	node->custom_ps = list_make1(state->child);
+
+	if (eflags & EXEC_FLAG_EXPLAIN_ONLY)
+		return;
+
+	switch (nodeTag(state->child))
+	{
+		case T_IndexScanState:
+			{
+				IndexScanState *iss = (IndexScanState *) state->child;
+
+				indexrel = iss->iss_RelationDesc;
+				dir = ((IndexScan *) subplan)->indexorderdir;
+				state->skip_key = skip_scan_add_key(estate, iss->ss.ss_currentRelation, indexrel,
+													&iss->iss_ScanKeys, &iss->iss_NumScanKeys,
+													iss->iss_RuntimeKeys, iss->iss_NumRuntimeKeys,
+													iss->iss_NumOrderByKeys, &iss->iss_ScanDesc);
+				break;
+			}
+		case T_IndexOnlyScanState:
+			{
+				IndexOnlyScanState *ioss = (IndexOnlyScanState *) state->child;
+
+				indexrel = ioss->ioss_RelationDesc;
+				dir = ((IndexOnlyScan *) subplan)->indexorderdir;
+				state->skip_key = skip_scan_add_key(estate, ioss->ss.ss_currentRelation, indexrel,
+													&ioss->ioss_ScanKeys, &ioss->ioss_NumScanKeys,
+													ioss->ioss_RuntimeKeys, ioss->ioss_NumRuntimeKeys,
+													ioss->ioss_NumOrderByKeys, &ioss->ioss_ScanDesc);
+				ioss->ioss_ScanDesc->xs_want_itup = true;
+				break;
+			}
+		default:
+			elog(ERROR, "invalid child of SkipScan: %d", nodeTag(state->child));
+			return;
+	}
+
+	/*
+	 * The next distinct value is greater than the previous one if the scan
+	 * runs in the order of the leading column
+	 */
+	indoption = indexrel->rd_indoption[0];
+	state->skip_flags = indoption << SK_BT_INDOPTION_SHIFT;
+	state->nulls_first = ((indoption & INDOPTION_NULLS_FIRST) != 0) == ScanDirectionIsForward(dir);
+	state->next_strategy = ((indoption & INDOPTION_DESC) == 0) == ScanDirectionIsForward(dir) ?
+		BTGreaterStrategyNumber : BTLessStrategyNumber;
+	state->next_subtype = indexrel->rd_opcintype[0];
+	state->next_collation = indexrel->rd_indcollation[0];
+	state->next_proc = get_opcode(get_opfamily_member(indexrel->rd_opfamily[0],
+													  indexrel->rd_opcintype[0],
+													  indexrel->rd_opcintype[0],
+													  state->next_strategy));
+
+	if (!RegProcedureIsValid(state->next_proc))
+		elog(ERROR, "missing operator %d for the leading column of index \"%s\"",
+			 state->next_strategy, RelationGetRelationName(indexrel));
+
+	state->distinct_col = linitial_int(cscan->custom_private);
+	tle = list_nth(subplan->targetlist, state->distinct_col - 1);
+	get_typlenbyval(exprType((Node *) tle->expr), &state->distinct_typlen, &state->distinct_byval);
+
+	skip_scan_reset(state);
+}
+
+static TupleTableSlot *
+skip_scan_exec(CustomScanState *node)
+{
+	SkipScanState *state = (SkipScanState *) node;
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	TupleTableSlot *subslot;
+	Datum		value;
+	bool		isnull;
+
+	ResetExprContext(econtext);
+
+	while (state->stage != SKIP_SCAN_DONE)
+	{
+		/* Restart the scan only once the previous tuple has been consumed */
+		if (state->needs_rescan)
+		{
+			ExecReScan(state->child);
+			state->needs_rescan = false;
+		}
+
+		subslot = ExecProcNode(state->child);
+
+		if (TupIsNull(subslot))
+		{
+			skip_scan_next_stage(state);
+			continue;
+		}
+
+		if (state->stage == SKIP_SCAN_NULLS)
+			skip_scan_next_stage(state);
+		else
+		{
+			value = slot_getattr(subslot, state->distinct_col, &isnull);
+
+			if (!state->distinct_byval && state->stage == SKIP_SCAN_VALUES)
+				pfree(DatumGetPointer(state->prev_value));
+
+			state->prev_value = datumCopy(value, state->distinct_byval, state->distinct_typlen);
+			state->stage = SKIP_SCAN_VALUES;
+			skip_scan_set_key(state);
+		}
+
+		if (!node->ss.ps.ps_ProjInfo)
+			return subslot;
+
+		econtext->ecxt_scantuple = subslot;
+
+#if PG10
+		return ExecProject(node->ss.ps.ps_ProjInfo);
+#elif PG96
+		return ExecProject(node->ss.ps.ps_ProjInfo, NULL);
+#endif
+	}
+
+	return NULL;
+}
+
+static void
+skip_scan_end(CustomScanState *node)
+{
+	ExecEndNode(linitial(node->custom_ps));
+}
+
+static void
+skip_scan_rescan(CustomScanState *node)
+{
+	SkipScanState *state = (SkipScanState *) node;
+
+	if (state->skip_key != NULL)
+	{
+		if (!state->distinct_byval && state->stage == SKIP_SCAN_VALUES)
+			pfree(DatumGetPointer(state->prev_value));
+
+		skip_scan_reset(state);
+	}
+}
+
+static CustomExecMethods skip_scan_state_methods = {
+	.CustomName = "SkipScanState",
+	.BeginCustomScan = skip_scan_begin,
+	.ExecCustomScan = skip_scan_exec,
+	.EndCustomScan = skip_scan_end,
+	.ReScanCustomScan = skip_scan_rescan,
+};
+
+static Node *
+skip_scan_state_create(CustomScan *cscan)
+{
+	SkipScanState *state;
+
+	state = (SkipScanState *) newNode(sizeof(SkipScanState), T_CustomScanState);
+	state->csstate.methods = &skip_scan_state_methods;
+
+	return (Node *) state;
+}
+
+static CustomScanMethods skip_scan_plan_methods = {
+	.CustomName = "SkipScan",
+	.CreateCustomScanState = skip_scan_state_create,
+};
+
+static Plan *
+skip_scan_plan_create(PlannerInfo *root,
+					  RelOptInfo *rel,
+					  CustomPath *path,
+					  List *tlist,
+					  List *clauses,
+					  List *custom_plans)
+{
+	CustomScan *cscan = makeNode(CustomScan);
+	Plan	   *subplan = linitial(custom_plans);
+	IndexPath  *ipath = linitial(path->custom_paths);
+	AttrNumber	attno = ipath->indexinfo->indexkeys[0];
+	int			distinct_col = 0;
+	ListCell   *lc;
+
+	/* The index scan enforces the scan's quals */
+	foreach(lc, subplan->targetlist)
+	{
+		TargetEntry *tle = lfirst(lc);
+
+		if (IsA(tle->expr, Var) &&
+			((Var *) tle->expr)->varno == rel->relid &&
+			((Var *) tle->expr)->varattno == attno)
+		{
+			distinct_col = tle->resno;
+			break;
+		}
+	}
+
+	if (distinct_col == 0)
+		elog(ERROR, "distinct column not found in the target list of SkipScan");
+
+	cscan->scan.scanrelid = 0;
+	cscan->scan.plan.targetlist = tlist;
+	cscan->custom_plans = custom_plans;
+	cscan->custom_scan_tlist = subplan->targetlist;
+	cscan->custom_private = list_make1_int(distinct_col);
+	cscan->flags = path->flags;
+	cscan->methods = &skip_scan_plan_methods;
+
+	return &cscan->scan.plan;
+}
+
+static CustomPathMethods skip_scan_path_methods = {
+	.CustomName = "SkipScan",
+	.PlanCustomPath = skip_scan_plan_create,
+};
+
+/*
+ * Check if an index path of a chunk can be skip scanned: a btree index scan
+ * whose leading column is the distinct column, ordered like the query.
+ */
+static bool
+index_path_can_skip(Path *path, RelOptInfo *chunkrel, AttrNumber attno, List *pathkeys)
+{
+	IndexPath  *ipath = (IndexPath *) path;
+	ListCell   *lc;
+
+	if (!IsA(path, IndexPath) ||
+		(path->pathtype != T_IndexScan && path->pathtype != T_IndexOnlyScan) ||
+		ipath->indexinfo->relam != BTREE_AM_OID ||
+		ipath->indexinfo->indexkeys[0] != attno ||
+		ipath->indexorderbys != NIL ||
+		path->param_info != NULL ||
+		path->parallel_aware ||
+		!pathkeys_contained_in(pathkeys, path->pathkeys))
+		return false;
+
+	/* The distinct column must be returned to find the next value */
+	foreach(lc, path->pathtarget->exprs)
+	{
+		Var		   *var = lfirst(lc);
+
+		if (IsA(var, Var) && var->varno == chunkrel->relid && var->varattno == attno)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Create a SkipScan path over an index path. Each distinct value costs a
+ * descent of the index and the fetch of a tuple.
+ */
+static Path *
+skip_scan_path_create(PlannerInfo *root, RelOptInfo *chunkrel, IndexPath *ipath,
+					  double num_groups)
+{
+	SkipScanPath *path = (SkipScanPath *) newNode(sizeof(SkipScanPath), T_CustomPath);
+	double		tuples = Max(ipath->indexinfo->tuples, 2);
+	Cost		per_skip = random_page_cost +
+	ceil(log(tuples) / log(2.0)) * cpu_operator_cost +
+	cpu_index_tuple_cost + cpu_tuple_cost;
+
+	path->cpath.path.pathtype = T_CustomScan;
+	path->cpath.path.parent = chunkrel;
+	path->cpath.path.pathtarget = ipath->path.pathtarget;
+	path->cpath.path.param_info = NULL;
+	path->cpath.path.pathkeys = ipath->path.pathkeys;
+	path->cpath.path.rows = num_groups;
+	path->cpath.path.startup_cost = ipath->path.startup_cost;
+	path->cpath.path.total_cost = ipath->path.startup_cost + num_groups * per_skip;
+	path->cpath.flags = 0;
+	path->cpath.custom_paths = list_make1(ipath);
+	path->cpath.methods = &skip_scan_path_methods;
+
+	return &path->cpath.path;
+}
+
+/*
+ * Add a path for a DISTINCT or DISTINCT ON on a single column of a hypertable
+ * that skip scans the chunks which have a btree index that leads with the
+ * column, and merges the chunks below a Unique.
+ *
+ * Must be called from the create_upper_paths hook for the distinct stage,
+ * when the input relation is the hypertable's append relation.
+ */
+void
+skip_scan_add_paths(PlannerInfo *root, RelOptInfo *input_rel, RelOptInfo *output_rel,
+					Hypertable *ht)
+{
+	Query	   *parse = root->parse;
+	List	   *pathkeys;
+	TargetEntry *tle;
+	Var		   *var;
+	List	   *subpaths = NIL;
+	bool		skipped = false;
+	bool		has_deferred_data;
+	Path	   *path;
+	ListCell   *lc;
+
+	if (list_length(parse->distinctClause) != 1 ||
+		list_length(root->distinct_pathkeys) != 1 ||
+		parse->hasTargetSRFs ||
+		NULL == input_rel->cheapest_total_path)
+		return;
+
+	/* A DISTINCT ON needs the order of the ORDER BY within each value */
+	if (list_length(root->sort_pathkeys) > 1)
+		pathkeys = root->sort_pathkeys;
+	else
+		pathkeys = root->distinct_pathkeys;
+
+	if (linitial(pathkeys) != linitial(root->distinct_pathkeys))
+		return;
+
+	tle = get_sortgroupclause_tle(linitial(parse->distinctClause), parse->targetList);
+	var = (Var *) tle->expr;
+
+	if (!IsA(var, Var) || var->varno != input_rel->relid || var->varlevelsup != 0)
+		return;
+
+	has_deferred_data = hypertable_has_deferred_data(ht);
+
+	foreach(lc, root->append_rel_list)
+	{
+		AppendRelInfo *appinfo = lfirst(lc);
+		RelOptInfo *chunkrel;
+		Var		   *chunkvar;
+		Path	   *sorted;
+		Path	   *best = NULL;
+		ListCell   *lc_path;
+
+		if (appinfo->parent_relid != input_rel->relid)
+			continue;
+
+		chunkrel = root->simple_rel_array[appinfo->child_relid];
+
+		/*
+		 * The main table only holds the tuples of a deferred migration, in
+		 * which case it is merged like any chunk
+		 */
+		if (IS_DUMMY_REL(chunkrel) ||
+			(root->simple_rte_array[appinfo->child_relid]->relid == ht->main_table_relid &&
+			 !has_deferred_data))
+			continue;
+
+		if (NULL == chunkrel->cheapest_total_path)
+			return;
+
+		chunkvar = list_nth(appinfo->translated_vars, var->varattno - 1);
+
+		/* Chunks without a suitable index are sorted by the merge */
+		sorted = get_cheapest_path_for_pathkeys_compat(chunkrel->pathlist, pathkeys,
+													   NULL, TOTAL_COST);
+
+		if (NULL == sorted)
+			sorted = chunkrel->cheapest_total_path;
+
+		foreach(lc_path, chunkrel->pathlist)
+		{
+			Path	   *ipath = lfirst(lc_path);
+			double		num_groups;
+			Path	   *skip;
+
+			if (!index_path_can_skip(ipath, chunkrel, chunkvar->varattno, pathkeys))
+				continue;
+
+			num_groups = estimate_num_groups(root, list_make1(chunkvar), chunkrel->rows, NULL);
+			skip = skip_scan_path_create(root, chunkrel, (IndexPath *) ipath, num_groups);
+
+			if (skip->total_cost < sorted->total_cost &&
+				(NULL == best || skip->total_cost < best->total_cost))
+				best = skip;
+		}
+
+		if (NULL != best)
+			skipped = true;
+		else
+			best = sorted;
+
+		subpaths = lappend(subpaths, best);
+	}
+
+	if (!skipped)
+		return;
+
+	path = (Path *) create_merge_append_path_compat(root, input_rel, subpaths, pathkeys, NULL);
+	path = (Path *) create_projection_path(root, input_rel, path,
+										   input_rel->cheapest_total_path->pathtarget);
+
+	add_path(output_rel, (Path *) create_upper_unique_path(root, output_rel, path, 1,
+														   estimate_num_groups(root, list_make1(var),
+																			   input_rel->rows, NULL)));
+}
@@ -0,0 +1,51 @@
+#ifndef TIMESCALEDB_SKIP_SCAN_H
+#define TIMESCALEDB_SKIP_SCAN_H
+
+#include <postgres.h>
+#include <access/skey.h>
+#include <nodes/extensible.h>
+#include <nodes/relation.h>
+
+#include "hypertable.h"
+
+typedef struct SkipScanPath
+{
+	CustomPath	cpath;
+} SkipScanPath;
+
+/*
+ * The stages of a skip scan. The tuples with a NULL in the distinct column
+ * are found with a scan of their own, which comes first or last depending on
+ * where the index puts NULLs in the direction of the scan.
+ */
+typedef enum SkipScanStage
+{
+	SKIP_SCAN_NULLS,
+	SKIP_SCAN_NOT_NULL,
+	SKIP_SCAN_VALUES,
+	SKIP_SCAN_DONE,
+} SkipScanStage;
+
+typedef struct SkipScanState
+{
+	CustomScanState csstate;
+	PlanState  *child;
+	ScanKey		skip_key;
+	int			distinct_col;	/* column of the child's tuples */
+	bool		distinct_byval;
+	int16		distinct_typlen;
+	Datum		prev_value;
+	bool		nulls_first;	/* in the direction of the scan */
+	int			skip_flags;		/* index options of the leading column */
+	StrategyNumber next_strategy;
+	Oid			next_subtype;
+	Oid			next_collation;
+	RegProcedure next_proc;
+	SkipScanStage stage;
+	bool		needs_rescan;
+} SkipScanState;
+
+extern void skip_scan_add_paths(PlannerInfo *root, RelOptInfo *input_rel, RelOptInfo *output_rel,
+					Hypertable *ht);
+
+#endif							/* TIMESCALEDB_SKIP_SCAN_H */
@@ -0,0 +1,455 @@
+#include <postgres.h>
+#include <utils/memutils.h>
+#include <utils/hsearch.h>
+
+#include "slice_index.h"
+#include "dimension.h"
+#include "dimension_slice.h"
+#include "dimension_vector.h"
+#include "chunk_constraint.h"
+#include "hypercube.h"
+
+/*
+ * The slice index is an in-memory index of a hypertable's dimension slices
+ * and the chunks they bound. It is used to find the chunk that holds a point
+ * without scanning the dimension slice and chunk constraint catalog tables.
+ *
+ * For each dimension, the slices are kept in an array sorted on range start.
+ * Each entry also keeps the maximum range end of all entries up to, and
+ * including, itself. This makes the array a flattened interval tree: to find
+ * the slices that enclose a coordinate, we binary search for the last slice
+ * that starts at or before the coordinate and walk backwards until no earlier
+ * slice can reach the coordinate. Slices in a dimension normally do not
+ * overlap, so this typically visits a single entry.
+ *
+ * The index is a cache and can be incomplete, e.g., it does not know about
+ * chunks created by other backends after it was built. Callers should look
+ * in the catalog when the index does not have a chunk and add what they find.
+ * Removing or changing slices and chunks invalidates the hypertable cache,
+ * and the index with it.
+ */
+
+typedef struct SliceIndexEntry
+{
+	DimensionSlice *slice;
+	int64		max_range_end;
+	int32		num_chunks;
+	int32		capacity;
+	int32	   *chunk_ids;
+} SliceIndexEntry;
+
+typedef struct DimensionSliceIndex
+{
+	int32		dimension_id;
+	int32		num_entries;
+	int32		capacity;
+	SliceIndexEntry *entries;
+} DimensionSliceIndex;
+
+typedef struct SliceIndex
+{
+	MemoryContext mcxt;
+	int16		num_dimensions;
+	DimensionSliceIndex dimensions[FLEXIBLE_ARRAY_MEMBER];
+} SliceIndex;
+
+#define SLICE_INDEX_SIZE(num_dimensions)						\
+	(sizeof(SliceIndex) + sizeof(DimensionSliceIndex) * (num_dimensions))
+
+#define SLICE_INDEX_DEFAULT_CAPACITY 10
+
+/*
+ * Find the position of the first entry that starts after the given
+ * coordinate.
+ */
+static int32
+dimension_slice_index_upper_bound(DimensionSliceIndex *dsi, int64 coordinate)
+{
+	int32		low = 0;
+	int32		high = dsi->num_entries;
+
+	while (low < high)
+	{
+		int32		mid = low + (high - low) / 2;
+
+		if (dsi->entries[mid].slice->fd.range_start <= coordinate)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+static void
+dimension_slice_index_update_max_range_end(DimensionSliceIndex *dsi, int32 from)
+{
+	int32		i;
+
+	for (i = from; i < dsi->num_entries; i++)
+	{
+		SliceIndexEntry *entry = &dsi->entries[i];
+		int64		range_end = entry->slice->fd.range_end;
+
+		if (i > 0 && dsi->entries[i - 1].max_range_end > range_end)
+			entry->max_range_end = dsi->entries[i - 1].max_range_end;
+		else
+			entry->max_range_end = range_end;
+	}
+}
+
+static SliceIndexEntry *
+dimension_slice_index_find_entry(DimensionSliceIndex *dsi, DimensionSlice *slice)
+{
+	int32		i = dimension_slice_index_upper_bound(dsi, slice->fd.range_start);
+
+	while (--i >= 0 && dsi->entries[i].slice->fd.range_start == slice->fd.range_start)
+	{
+		if (dsi->entries[i].slice->fd.id == slice->fd.id)
+			return &dsi->entries[i];
+	}
+
+	return NULL;
+}
+
+/*
+ * Add a slice to a dimension's index, keeping the entries sorted. Must be
+ * called on the index's memory context.
+ */
+static SliceIndexEntry *
+dimension_slice_index_add_slice(DimensionSliceIndex *dsi, DimensionSlice *slice)
+{
+	SliceIndexEntry *entry = dimension_slice_index_find_entry(dsi, slice);
+	int32		pos;
+
+	if (NULL != entry)
+		return entry;
+
+	if (dsi->num_entries >= dsi->capacity)
+	{
+		dsi->capacity *= 2;
+		dsi->entries = repalloc(dsi->entries, sizeof(SliceIndexEntry) * dsi->capacity);
+	}
+
+	pos = dimension_slice_index_upper_bound(dsi, slice->fd.range_start);
+
+	if (pos < dsi->num_entries)
+		memmove(&dsi->entries[pos + 1], &dsi->entries[pos],
+				sizeof(SliceIndexEntry) * (dsi->num_entries - pos));
+
+	dsi->num_entries++;
+	entry = &dsi->entries[pos];
+	entry->slice = dimension_slice_copy(slice);
+	entry->num_chunks = 0;
+	entry->capacity = 0;
+	entry->chunk_ids = NULL;
+
+	dimension_slice_index_update_max_range_end(dsi, pos);
+
+	return entry;
+}
+
+static void
+slice_index_entry_add_chunk(SliceIndexEntry *entry, int32 chunk_id)
+{
+	int32		i;
+
+	for (i = 0; i < entry->num_chunks; i++)
+		if (entry->chunk_ids[i] == chunk_id)
+			return;
+
+	if (entry->num_chunks >= entry->capacity)
+	{
+		if (entry->capacity == 0)
+		{
+			entry->capacity = 4;
+			entry->chunk_ids = palloc(sizeof(int32) * entry->capacity);
+		}
+		else
+		{
+			entry->capacity *= 2;
+			entry->chunk_ids = repalloc(entry->chunk_ids, sizeof(int32) * entry->capacity);
+		}
+	}
+
+	entry->chunk_ids[entry->num_chunks++] = chunk_id;
+}
+
+static bool
+slice_index_entry_has_chunk(SliceIndexEntry *entry, int32 chunk_id)
+{
+	int32		i;
+
+	for (i = 0; i < entry->num_chunks; i++)
+		if (entry->chunk_ids[i] == chunk_id)
+			return true;
+
+	return false;
+}
+
+/*
+ * Find the entry in a dimension that encloses the coordinate and bounds the
+ * given chunk. If chunk_id is zero, return the entries enclosing the
+ * coordinate one by one, starting from "*pos".
+ */
+static SliceIndexEntry *
+dimension_slice_index_find(DimensionSliceIndex *dsi, int64 coordinate, int32 chunk_id, int32 *pos)
+{
+	int32		i;
+
+	if (NULL == pos || *pos < 0)
+		i = dimension_slice_index_upper_bound(dsi, coordinate);
+	else
+		i = *pos;
+
+	while (--i >= 0 && dsi->entries[i].max_range_end > coordinate)
+	{
+		SliceIndexEntry *entry = &dsi->entries[i];
+
+		if (entry->slice->fd.range_end <= coordinate)
+			continue;
+
+		if (chunk_id > 0 && !slice_index_entry_has_chunk(entry, chunk_id))
+			continue;
+
+		if (NULL != pos)
+			*pos = i;
+
+		return entry;
+	}
+
+	if (NULL != pos)
+		*pos = 0;
+
+	return NULL;
+}
+
+typedef struct SliceIndexLoadEntry
+{
+	int32		dimension_slice_id;
+	SliceIndexEntry *entry;
+} SliceIndexLoadEntry;
+
+typedef struct SliceIndexLoadCtx
+{
+	SliceIndex *index;
+	HTAB	   *htab;
+} SliceIndexLoadCtx;
+
+static void
+slice_index_load_chunk(int32 chunk_id, int32 dimension_slice_id, void *data)
+{
+	SliceIndexLoadCtx *ctx = data;
+	SliceIndexLoadEntry *load;
+	MemoryContext old;
+
+	load = hash_search(ctx->htab, &dimension_slice_id, HASH_FIND, NULL);
+
+	/* Not a slice of this hypertable */
+	if (NULL == load)
+		return;
+
+	old = MemoryContextSwitchTo(ctx->index->mcxt);
+	slice_index_entry_add_chunk(load->entry, chunk_id);
+	MemoryContextSwitchTo(old);
+}
+
+/*
+ * Fill in the chunks bounded by the already added slices.
+ *
+ * Rather than scanning the chunk constraints of each slice separately, the
+ * chunk constraint table is read once and each dimension constraint is mapped
+ * to its index entry through a temporary hash table. This bounds the cost of
+ * building the index, since this is what a new backend pays before its first
+ * insert into a hypertable with many chunks.
+ */
+static void
+slice_index_load_chunks(SliceIndex *index, int num_slices)
+{
+	struct HASHCTL hctl = {
+		.keysize = sizeof(int32),
+		.entrysize = sizeof(SliceIndexLoadEntry),
+		.hcxt = CurrentMemoryContext,
+	};
+	SliceIndexLoadCtx ctx = {
+		.index = index,
+		.htab = hash_create("slice-index-load", num_slices, &hctl,
+							HASH_ELEM | HASH_CONTEXT | HASH_BLOBS),
+	};
+	int			i;
+
+	/*
+	 * Entry pointers are stable from here on, since no more slices are added
+	 * while loading.
+	 */
+	for (i = 0; i < index->num_dimensions; i++)
+	{
+		DimensionSliceIndex *dsi = &index->dimensions[i];
+		int32		j;
+
+		for (j = 0; j < dsi->num_entries; j++)
+		{
+			SliceIndexEntry *entry = &dsi->entries[j];
+			SliceIndexLoadEntry *load;
+
+			load = hash_search(ctx.htab, &entry->slice->fd.id, HASH_ENTER, NULL);
+			load->entry = entry;
+		}
+	}
+
+	chunk_constraint_scan_dimension_constraints(slice_index_load_chunk, &ctx);
+	hash_destroy(ctx.htab);
+}
+
+/*
+ * Create the slice index for a hyperspace from the catalog.
+ *
+ * The index is allocated on its own memory context, created as a child of the
+ * given parent context.
+ */
+SliceIndex *
+slice_index_create(Hyperspace *hs, MemoryContext parent)
+{
+	MemoryContext mcxt = AllocSetContextCreate(parent,
+											   "slice index memory context",
+											   ALLOCSET_DEFAULT_SIZES);
+	MemoryContext old = MemoryContextSwitchTo(mcxt);
+	SliceIndex *index = palloc0(SLICE_INDEX_SIZE(hs->num_dimensions));
+	int			num_slices = 0;
+	int			i;
+
+	index->mcxt = mcxt;
+	index->num_dimensions = hs->num_dimensions;
+
+	for (i = 0; i < hs->num_dimensions; i++)
+	{
+		DimensionSliceIndex *dsi = &index->dimensions[i];
+
+		dsi->dimension_id = hs->dimensions[i].fd.id;
+		dsi->num_entries = 0;
+		dsi->capacity = SLICE_INDEX_DEFAULT_CAPACITY;
+		dsi->entries = palloc(sizeof(SliceIndexEntry) * dsi->capacity);
+	}
+
+	MemoryContextSwitchTo(old);
+
+	for (i = 0; i < hs->num_dimensions; i++)
+	{
+		DimensionSliceIndex *dsi = &index->dimensions[i];
+		DimensionVec *vec = dimension_slice_scan_by_dimension(dsi->dimension_id, 0);
+		int			j;
+
+		old = MemoryContextSwitchTo(mcxt);
+
+		for (j = 0; j < vec->num_slices; j++)
+			dimension_slice_index_add_slice(dsi, vec->slices[j]);
+
+		MemoryContextSwitchTo(old);
+		num_slices += vec->num_slices;
+	}
+
+	if (num_slices > 0)
+		slice_index_load_chunks(index, num_slices);
+
+	return index;
+}
+
+void
+slice_index_free(SliceIndex *index)
+{
+	MemoryContextDelete(index->mcxt);
+}
+
+/*
+ * Find the chunk that encloses a point.
+ *
+ * Returns the ID of the chunk, or zero if the index has no such chunk. If a
+ * chunk is found and "cube" is non-NULL, it is set to a newly allocated
+ * hypercube with copies of the chunk's slices.
+ */
+int32
+slice_index_find_chunk(SliceIndex *index, Point *p, Hypercube **cube)
+{
+	DimensionSliceIndex *first = &index->dimensions[0];
+	SliceIndexEntry *entry;
+	int32		pos = -1;
+
+	Assert(p->num_coords == index->num_dimensions);
+
+	/*
+	 * Every chunk bounded by a slice that encloses the point in the first
+	 * dimension is a candidate. The matching chunk is the one that also has
+	 * enclosing slices in all the other dimensions.
+	 */
+	while ((entry = dimension_slice_index_find(first, p->coordinates[0], 0, &pos)) != NULL)
+	{
+		int32		c;
+
+		for (c = 0; c < entry->num_chunks; c++)
+		{
+			int32		chunk_id = entry->chunk_ids[c];
+			int			i;
+
+			for (i = 1; i < index->num_dimensions; i++)
+				if (NULL == dimension_slice_index_find(&index->dimensions[i],
+													   p->coordinates[i],
+													   chunk_id, NULL))
+					break;
+
+			if (i < index->num_dimensions)
+				continue;
+
+			if (NULL != cube)
+			{
+				Hypercube  *hc = hypercube_alloc(index->num_dimensions);
+
+				/* The cube gets copies, since the caller can free its slices */
+				hypercube_add_slice(hc, dimension_slice_copy(entry->slice));
+
+				for (i = 1; i < index->num_dimensions; i++)
+				{
+					SliceIndexEntry *other = dimension_slice_index_find(&index->dimensions[i],
+																		p->coordinates[i],
+																		chunk_id, NULL);
+
+					hypercube_add_slice(hc, dimension_slice_copy(other->slice));
+				}
+
+				*cube = hc;
+			}
+
+			return chunk_id;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Add a chunk, and the slices of its hypercube, to the index.
+ */
+void
+slice_index_add_chunk(SliceIndex *index, int32 chunk_id, Hypercube *cube)
+{
+	MemoryContext old = MemoryContextSwitchTo(index->mcxt);
+	int			i;
+
+	for (i = 0; i < cube->num_slices; i++)
+	{
+		DimensionSlice *slice = cube->slices[i];
+		int			j;
+
+		for (j = 0; j < index->num_dimensions; j++)
+		{
+			if (index->dimensions[j].dimension_id == slice->fd.dimension_id)
+			{
+				SliceIndexEntry *entry = dimension_slice_index_add_slice(&index->dimensions[j], slice);
+
+				slice_index_entry_add_chunk(entry, chunk_id);
+				break;
+			}
+		}
+	}
+
+	MemoryContextSwitchTo(old);
+}
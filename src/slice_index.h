@@ -0,0 +1,16 @@
+#ifndef TIMESCALEDB_SLICE_INDEX_H
+#define TIMESCALEDB_SLICE_INDEX_H
+
+#include <postgres.h>
+
+typedef struct SliceIndex SliceIndex;
+typedef struct Hyperspace Hyperspace;
+typedef struct Hypercube Hypercube;
+typedef struct Point Point;
+
+extern SliceIndex *slice_index_create(Hyperspace *hs, MemoryContext parent);
+extern void slice_index_free(SliceIndex *index);
+extern int32 slice_index_find_chunk(SliceIndex *index, Point *p, Hypercube **cube);
+extern void slice_index_add_chunk(SliceIndex *index, int32 chunk_id, Hypercube *cube);
+
+#endif							/* TIMESCALEDB_SLICE_INDEX_H */
@@ -4,11 +4,17 @@
 #include <nodes/nodeFuncs.h>
 #include <nodes/plannodes.h>
 #include <parser/parsetree.h>
+#include <pgtime.h>
+#include <utils/builtins.h>
+#include <utils/datetime.h>
 #include <utils/guc.h>
 #include <optimizer/planner.h>
 #include <optimizer/paths.h>
+#include <parser/scansup.h>
 #include <utils/lsyscache.h>
 
+#include "sort_transform.h"
+
 /* This optimizations allows GROUP BY clauses that transform time in
  * order-preserving ways to use indexes on the time field. It works
  * by transforming sorting clauses from their more complex versions
@@ -19,9 +25,6 @@
  * to an ordering on time.
  */
 
-extern void sort_transform_optimization(PlannerInfo *root, RelOptInfo *rel);
-static Expr *sort_transform_expr(Expr *orig_expr);
-
 static Expr *
 transform_date_trunc(FuncExpr *func)
 {
@@ -50,10 +53,26 @@ transform_time_bucket(FuncExpr *func)
 	 *
 	 * proof: time_bucket(const1, time1) > time_bucket(const1,time2) iff time1
 	 * > time2
+	 *
+	 * The same holds for time_bucket_gapfill(const, var, start, finish),
+	 * which buckets like time_bucket.
 	 */
 	Expr	   *second;
+	Const	   *width;
 
-	if (list_length(func->args) != 2 || !IsA(linitial(func->args), Const))
+	if ((list_length(func->args) != 2 && list_length(func->args) != 4) ||
+		!IsA(linitial(func->args), Const))
+		return (Expr *) func;
+
+	/*
+	 * Integer widths are not checked to be positive, and a negative width
+	 * reverses the order
+	 */
+	width = linitial(func->args);
+	if (width->constisnull ||
+		(width->consttype == INT2OID && DatumGetInt16(width->constvalue) <= 0) ||
+		(width->consttype == INT4OID && DatumGetInt32(width->constvalue) <= 0) ||
+		(width->consttype == INT8OID && DatumGetInt64(width->constvalue) <= 0))
 		return (Expr *) func;
 
 	second = sort_transform_expr(lsecond(func->args));
@@ -115,6 +134,96 @@ transform_timestamptz_cast(FuncExpr *func)
 }
 
 
+static Expr *
+transform_date_cast(FuncExpr *func)
+{
+	/*
+	 * Transform cast from timestamp to date, as in the date variant of
+	 * time_bucket() with an offset. A timestamptz is cast at the session's
+	 * time zone, where a date can go backwards when the clocks do.
+	 *
+	 * date(var) => var
+	 *
+	 * proof: date(time1) > date(time2) implies time1 > time2
+	 */
+	Expr	   *first;
+
+	if (list_length(func->args) != 1 ||
+		exprType(linitial(func->args)) != TIMESTAMPOID)
+		return (Expr *) func;
+
+	first = sort_transform_expr(linitial(func->args));
+	if (!IsA(first, Var))
+		return (Expr *) func;
+
+	return (Expr *) copyObject(first);
+}
+
+/*
+ * Check if a time zone, as given to AT TIME ZONE, has a fixed offset from
+ * UTC. The zone is looked up the way timestamptz_zone() does it.
+ */
+static bool
+timezone_is_fixed(text *zone)
+{
+	char		tzname[TZ_STRLEN_MAX + 1];
+	char	   *lowzone;
+	int			type;
+	int			val;
+	pg_tz	   *tz;
+	long int	gmtoff;
+
+	text_to_cstring_buffer(zone, tzname, sizeof(tzname));
+	lowzone = downcase_truncate_identifier(tzname, strlen(tzname), false);
+	type = DecodeTimezoneAbbrev(0, lowzone, &val, &tz);
+
+	if (type == TZ || type == DTZ)
+		return true;
+
+	if (type != DYNTZ)
+		tz = pg_tzset(tzname);
+
+	return NULL != tz && pg_get_timezone_offset(tz, &gmtoff);
+}
+
+static Expr *
+transform_timezone(FuncExpr *func)
+{
+	/*
+	 * Transform AT TIME ZONE between timestamp and timestamptz for zones
+	 * with a fixed offset, e.g., UTC. Zones with daylight saving time are
+	 * not order preserving, since their local time repeats itself when the
+	 * clocks are set back.
+	 *
+	 * timezone(const, var) => var
+	 *
+	 * proof: timezone(const, time1) > timezone(const, time2) iff time1 >
+	 * time2
+	 */
+	Const	   *zone;
+	Oid			type;
+	Expr	   *second;
+
+	if (list_length(func->args) != 2 || !IsA(linitial(func->args), Const))
+		return (Expr *) func;
+
+	zone = linitial(func->args);
+	type = exprType(lsecond(func->args));
+
+	if (zone->constisnull || (type != TIMESTAMPOID && type != TIMESTAMPTZOID))
+		return (Expr *) func;
+
+	if (zone->consttype != INTERVALOID &&
+		(zone->consttype != TEXTOID || !timezone_is_fixed(DatumGetTextPP(zone->constvalue))))
+		return (Expr *) func;
+
+	second = sort_transform_expr(lsecond(func->args));
+	if (!IsA(second, Var))
+		return (Expr *) func;
+
+	return (Expr *) copyObject(second);
+}
+
 static inline Expr *
 transform_time_op_const_interval(OpExpr *op)
 {
@@ -229,7 +338,7 @@ transform_int_op_const(OpExpr *op)
  * Note that if orig_expr(X) = orig_expr(Y) then
  *			 the ordering under new_expr is unconstrained.
  * */
-static Expr *
+Expr *
 sort_transform_expr(Expr *orig_expr)
 {
 	if (IsA(orig_expr, FuncExpr))
@@ -239,12 +348,17 @@ sort_transform_expr(Expr *orig_expr)
 
 		if (strncmp(func_name, "date_trunc", NAMEDATALEN) == 0)
 			return transform_date_trunc(func);
-		if (strncmp(func_name, "time_bucket", NAMEDATALEN) == 0)
+		if (strncmp(func_name, "time_bucket", NAMEDATALEN) == 0 ||
+			strncmp(func_name, "time_bucket_gapfill", NAMEDATALEN) == 0)
 			return transform_time_bucket(func);
 		if (strncmp(func_name, "timestamp", NAMEDATALEN) == 0)
 			return transform_timestamp_cast(func);
 		if (strncmp(func_name, "timestamptz", NAMEDATALEN) == 0)
 			return transform_timestamptz_cast(func);
+		if (strncmp(func_name, "date", NAMEDATALEN) == 0)
+			return transform_date_cast(func);
+		if (strncmp(func_name, "timezone", NAMEDATALEN) == 0)
+			return transform_timezone(func);
 	}
 	if (IsA(orig_expr, OpExpr))
 	{
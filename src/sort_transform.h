@@ -0,0 +1,10 @@
+#ifndef TIMESCALEDB_SORT_TRANSFORM_H
+#define TIMESCALEDB_SORT_TRANSFORM_H
+
+#include <postgres.h>
+#include <nodes/relation.h>
+
+extern Expr *sort_transform_expr(Expr *orig_expr);
+extern void sort_transform_optimization(PlannerInfo *root, RelOptInfo *rel);
+
+#endif							/* TIMESCALEDB_SORT_TRANSFORM_H */
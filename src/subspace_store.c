@@ -1,4 +1,5 @@
 #include <postgres.h>
+#include <lib/ilist.h>
 
 #include "dimension.h"
 #include "dimension_slice.h"
@@ -13,6 +14,16 @@
  * first dimension point to a DimensionVec of the second dimension. This recurses
  * for the N dimensions. The leaf DimensionSlice points to the data being stored.
  *
+ * When the store is full, the least recently used object is evicted, across
+ * all dimensions. Any internal nodes that become empty are pruned from the
+ * tree.
+ *
+ * Nodes of closed dimensions also index their slices by partition number,
+ * which is calculated from the coordinate, so that lookups need no search.
+ * This only works as long as all slices of the node follow the dimension's
+ * current partitioning. When a node gets a slice that does not, e.g., of a
+ * chunk created before the number of partitions was changed, the node falls
+ * back to searching its vector.
  * */
 
 typedef struct SubspaceStoreInternalNode
@@ -20,47 +31,187 @@ typedef struct SubspaceStoreInternalNode
 	DimensionVec *vector;
 	size_t		descendants;
 	bool		last_internal_node;
+	int16		num_partitions;
+	DimensionSlice **partitions;	/* NULL if not indexed by partition */
 } SubspaceStoreInternalNode;
 
+/*
+ * A leaf wraps a stored object. It keeps the coordinates of the object's
+ * subspace so that the path to the leaf can be found again on eviction.
+ */
+typedef struct SubspaceStoreLeaf
+{
+	void	   *object;
+	void		(*object_free) (void *);
+	dlist_node	lru_node;
+	int64		coordinates[FLEXIBLE_ARRAY_MEMBER];
+} SubspaceStoreLeaf;
+
 typedef struct SubspaceStore
 {
 	MemoryContext mcxt;
 	int16		num_dimensions;
-/* limit growth of store by  limiting number of slices in first dimension,	0 for no limit */
+	/* limit growth of store by limiting the number of objects, 0 for no limit */
 	int16		max_items;
+	int16	   *num_partitions; /* per dimension, zero for open dimensions */
 	SubspaceStoreInternalNode *origin;	/* origin of the tree */
+	dlist_head	lru;			/* leaves, most recently used first */
+	uint64		hits;
+	uint64		misses;
+	uint64		evictions;
 } SubspaceStore;
 
 static inline SubspaceStoreInternalNode *
-subspace_store_internal_node_create(bool last_internal_node)
+subspace_store_internal_node_create(bool last_internal_node, int16 num_partitions)
 {
 	SubspaceStoreInternalNode *node = palloc(sizeof(SubspaceStoreInternalNode));
 
 	node->vector = dimension_vec_create(DIMENSION_VEC_DEFAULT_SIZE);
 	node->descendants = 0;
 	node->last_internal_node = last_internal_node;
+	node->num_partitions = num_partitions;
+	node->partitions = NULL;
+
+	if (num_partitions > 0)
+		node->partitions = palloc0(sizeof(DimensionSlice *) * num_partitions);
+
 	return node;
 }
 
 static inline void
-subspace_store_internal_node_free(void *node)
+subspace_store_internal_node_free(void *ptr)
 {
-	dimension_vec_free(((SubspaceStoreInternalNode *) node)->vector);
+	SubspaceStoreInternalNode *node = ptr;
+
+	dimension_vec_free(node->vector);
+
+	if (NULL != node->partitions)
+		pfree(node->partitions);
+
 	pfree(node);
 }
 
-static size_t
-subspace_store_internal_node_descendants(SubspaceStoreInternalNode *node, int index)
+/*
+ * Get the partition that a closed dimension coordinate falls in. This
+ * mirrors the default partitioning of closed dimensions.
+ */
+static inline int
+subspace_store_partition_index(int16 num_partitions, int64 coordinate)
 {
-	DimensionSlice *slice = dimension_vec_get(node->vector, index);
+	int64		interval = DIMENSION_SLICE_CLOSED_MAX / num_partitions;
+	int64		index = coordinate / interval;
+
+	/* The last partition also covers the remainder of the range */
+	return index >= num_partitions ? num_partitions - 1 : (int) index;
+}
+
+/*
+ * Get the partition of a slice, or -1 if the slice is not one of the
+ * partitions of the dimension's current partitioning.
+ */
+static int
+subspace_store_slice_partition_index(int16 num_partitions, const DimensionSlice *slice)
+{
+	int64		interval = DIMENSION_SLICE_CLOSED_MAX / num_partitions;
+	int			index = subspace_store_partition_index(num_partitions,
+													   Max(slice->fd.range_start, 0));
+	int64		range_start = index == 0 ? DIMENSION_SLICE_MINVALUE : index * interval;
+	int64		range_end = index == num_partitions - 1 ? DIMENSION_SLICE_MAXVALUE : (index + 1) * interval;
+
+	if (slice->fd.range_start != range_start || slice->fd.range_end != range_end)
+		return -1;
+
+	return index;
+}
+
+/*
+ * Find the slice of a node that contains a coordinate.
+ */
+static inline DimensionSlice *
+subspace_store_node_find_slice(SubspaceStoreInternalNode *node, int64 coordinate)
+{
+	if (NULL != node->partitions && coordinate >= 0)
+		return node->partitions[subspace_store_partition_index(node->num_partitions, coordinate)];
+
+	return dimension_vec_find_slice(node->vector, coordinate);
+}
+
+static void
+subspace_store_leaf_free(void *ptr)
+{
+	SubspaceStoreLeaf *leaf = ptr;
+
+	dlist_delete(&leaf->lru_node);
+
+	if (leaf->object_free != NULL)
+		leaf->object_free(leaf->object);
+
+	pfree(leaf);
+}
+
+/*
+ * Evict the least recently used object from the store.
+ *
+ * Returns false if the store is empty.
+ */
+bool
+subspace_store_evict_lru(SubspaceStore *store)
+{
+	SubspaceStoreLeaf *leaf;
+	SubspaceStoreInternalNode **path;
+	int		   *indexes;
+	SubspaceStoreInternalNode *node = store->origin;
+	int			i;
+
+	if (dlist_is_empty(&store->lru))
+		return false;
+
+	path = palloc(sizeof(SubspaceStoreInternalNode *) * store->num_dimensions);
+	indexes = palloc(sizeof(int) * store->num_dimensions);
+	leaf = dlist_container(SubspaceStoreLeaf, lru_node, dlist_tail_node(&store->lru));
+	store->evictions++;
 
-	if (slice == NULL)
-		return 0;
+	/* Find the path to the leaf */
+	for (i = 0; i < store->num_dimensions; i++)
+	{
+		path[i] = node;
+		indexes[i] = dimension_vec_find_slice_index_by_coordinate(node->vector,
+																  leaf->coordinates[i]);
+		Assert(indexes[i] >= 0);
+		node->descendants--;
+
+		if (!node->last_internal_node)
+			node = node->vector->slices[indexes[i]]->storage;
+	}
+
+	Assert(path[store->num_dimensions - 1]->vector->slices[indexes[store->num_dimensions - 1]]->storage == leaf);
+
+	/*
+	 * Remove the leaf's slice, and then the slices pointing to internal nodes
+	 * that became empty. Removing a slice frees its storage, i.e., the leaf
+	 * or the internal node.
+	 */
+	for (i = store->num_dimensions - 1; i >= 0; i--)
+	{
+		if (NULL != path[i]->partitions)
+		{
+			int			partition = subspace_store_partition_index(path[i]->num_partitions,
+																   Max(leaf->coordinates[i], 0));
+
+			Assert(path[i]->partitions[partition] == path[i]->vector->slices[indexes[i]]);
+			path[i]->partitions[partition] = NULL;
+		}
 
-	if (node->last_internal_node)
-		return 1;
+		dimension_vec_remove_slice(&path[i]->vector, indexes[i]);
 
-	return ((SubspaceStoreInternalNode *) slice->storage)->descendants;
+		if (path[i]->vector->num_slices > 0)
+			break;
+	}
+
+	pfree(path);
+	pfree(indexes);
+
+	return true;
 }
 
 SubspaceStore *
@@ -68,6 +219,7 @@ subspace_store_init(Hyperspace *space, MemoryContext mcxt, int16 max_items)
 {
 	MemoryContext old = MemoryContextSwitchTo(mcxt);
 	SubspaceStore *sst = palloc(sizeof(SubspaceStore));
+	int			i;
 
 	/*
 	 * make sure that the first dimension is a time dimension, otherwise the
@@ -75,10 +227,21 @@ subspace_store_init(Hyperspace *space, MemoryContext mcxt, int16 max_items)
 	 */
 	Assert(space->num_dimensions < 1 || space->dimensions[0].type == DIMENSION_TYPE_OPEN);
 
-	sst->origin = subspace_store_internal_node_create(space->num_dimensions == 1);
+	sst->num_partitions = palloc0(sizeof(int16) * Max(space->num_dimensions, 1));
+
+	for (i = 0; i < space->num_dimensions; i++)
+		if (space->dimensions[i].type == DIMENSION_TYPE_CLOSED)
+			sst->num_partitions[i] = space->dimensions[i].fd.num_slices;
+
+	sst->origin = subspace_store_internal_node_create(space->num_dimensions == 1,
+													  sst->num_partitions[0]);
 	sst->num_dimensions = space->num_dimensions;
 	sst->max_items = max_items;
 	sst->mcxt = mcxt;
+	sst->hits = 0;
+	sst->misses = 0;
+	sst->evictions = 0;
+	dlist_init(&sst->lru);
 	MemoryContextSwitchTo(old);
 	return sst;
 }
@@ -87,13 +250,20 @@ void
 subspace_store_add(SubspaceStore *store, const Hypercube *hc,
 				   void *object, void (*object_free) (void *))
 {
-	SubspaceStoreInternalNode *node = store->origin;
+	SubspaceStoreInternalNode *node;
+	SubspaceStoreLeaf *leaf;
 	DimensionSlice *last = NULL;
 	MemoryContext old = MemoryContextSwitchTo(store->mcxt);
 	int			i;
 
 	Assert(hc->num_slices == store->num_dimensions);
 
+	/* Make room for the new object */
+	if (store->max_items > 0 && store->origin->descendants >= store->max_items)
+		subspace_store_evict_lru(store);
+
+	node = store->origin;
+
 	for (i = 0; i < hc->num_slices; i++)
 	{
 		const DimensionSlice *target = hc->slices[i];
@@ -104,7 +274,8 @@ subspace_store_add(SubspaceStore *store, const Hypercube *hc,
 		if (node == NULL)
 		{
 			Assert(last != NULL);
-			last->storage = subspace_store_internal_node_create(i == hc->num_slices - 1);
+			last->storage = subspace_store_internal_node_create(i == hc->num_slices - 1,
+																store->num_partitions[i]);
 			last->storage_free = subspace_store_internal_node_free;
 			node = last->storage;
 		}
@@ -120,31 +291,24 @@ subspace_store_add(SubspaceStore *store, const Hypercube *hc,
 		{
 			DimensionSlice *copy;
 
-			if (store->max_items > 0 && i == 0 && node->descendants > store->max_items)
-			{
-				/*
-				 * At dimension 0 only keep store->max_slices_first_dimension
-				 * slices. This is to prevent this store from growing too
-				 * large. Always delete the oldest. Note that we made sure
-				 * that the first dimension is a time dimension when creating
-				 * the subspace_store.
-				 */
-				size_t		items_removed = subspace_store_internal_node_descendants(node, 0);
-
-				Assert(store->max_items + 1 == node->descendants);
-
-				dimension_vec_remove_slice(&node->vector, 0);
-
-				/*
-				 * Note we would have to do this to ancestors if this was not
-				 * the root.
-				 */
-				node->descendants -= items_removed;
-			}
 			copy = dimension_slice_copy(target);
 
 			dimension_vec_add_slice_sort(&node->vector, copy);
 			match = copy;
+
+			if (NULL != node->partitions)
+			{
+				int			partition = subspace_store_slice_partition_index(node->num_partitions, copy);
+
+				if (partition >= 0)
+					node->partitions[partition] = copy;
+				else
+				{
+					/* Mixed partitionings, so fall back to searching */
+					pfree(node->partitions);
+					node->partitions = NULL;
+				}
+			}
 		}
 
 		last = match;
@@ -153,8 +317,19 @@ subspace_store_add(SubspaceStore *store, const Hypercube *hc,
 	}
 
 	Assert(last != NULL && last->storage == NULL);
-	last->storage = object;		/* at the end we store the object */
-	last->storage_free = object_free;
+
+	/* at the end we store the object */
+	leaf = palloc(offsetof(SubspaceStoreLeaf, coordinates) +
+				  sizeof(int64) * store->num_dimensions);
+	leaf->object = object;
+	leaf->object_free = object_free;
+
+	for (i = 0; i < hc->num_slices; i++)
+		leaf->coordinates[i] = hc->slices[i]->fd.range_start;
+
+	dlist_push_head(&store->lru, &leaf->lru_node);
+	last->storage = leaf;
+	last->storage_free = subspace_store_leaf_free;
 	MemoryContextSwitchTo(old);
 }
 
@@ -163,28 +338,40 @@ void *
 subspace_store_get(SubspaceStore *store, Point *target)
 {
 	int			i;
-	DimensionVec *vec = store->origin->vector;
+	SubspaceStoreInternalNode *node = store->origin;
 	DimensionSlice *match = NULL;
+	SubspaceStoreLeaf *leaf;
 
 	Assert(target->cardinality == store->num_dimensions);
 
 	for (i = 0; i < target->cardinality; i++)
 	{
-		match = dimension_vec_find_slice(vec, target->coordinates[i]);
+		match = subspace_store_node_find_slice(node, target->coordinates[i]);
 
 		if (NULL == match)
+		{
+			store->misses++;
 			return NULL;
+		}
 
-		vec = ((SubspaceStoreInternalNode *) match->storage)->vector;
+		if (i < target->cardinality - 1)
+			node = match->storage;
 	}
 	Assert(match != NULL);
-	return match->storage;
+
+	/* Mark the object as the most recently used */
+	leaf = match->storage;
+	dlist_move_head(&store->lru, &leaf->lru_node);
+	store->hits++;
+
+	return leaf->object;
 }
 
 void
 subspace_store_free(SubspaceStore *store)
 {
 	subspace_store_internal_node_free(store->origin);
+	pfree(store->num_partitions);
 	pfree(store);
 }
 
@@ -193,3 +380,13 @@ subspace_store_mcxt(SubspaceStore *store)
 {
 	return store->mcxt;
 }
+
+void
+subspace_store_get_stats(SubspaceStore *store, SubspaceStoreStats *stats)
+{
+	stats->num_items = store->origin->descendants;
+	stats->max_items = store->max_items;
+	stats->hits = store->hits;
+	stats->misses = store->misses;
+	stats->evictions = store->evictions;
+}
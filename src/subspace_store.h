@@ -14,6 +14,15 @@ typedef struct Hypercube Hypercube;
 typedef struct Point Point;
 typedef struct SubspaceStore SubspaceStore;
 
+typedef struct SubspaceStoreStats
+{
+	int64		num_items;
+	int16		max_items;
+	uint64		hits;
+	uint64		misses;
+	uint64		evictions;
+} SubspaceStoreStats;
+
 extern SubspaceStore *subspace_store_init(Hyperspace *space, MemoryContext mcxt, int16 max_items);
 
 /* Store an object associate with the subspace represented by a hypercube */
@@ -24,7 +33,11 @@ extern void subspace_store_add(SubspaceStore *cache, const Hypercube *hc,
  * Return the object stored or NULL if this subspace is not in the store.
  */
 extern void *subspace_store_get(SubspaceStore *cache, Point *target);
+
+/* Evict the least recently used object. Returns false if the store is empty. */
+extern bool subspace_store_evict_lru(SubspaceStore *cache);
 extern void subspace_store_free(SubspaceStore *cache);
 extern MemoryContext subspace_store_mcxt(SubspaceStore *cache);
+extern void subspace_store_get_stats(SubspaceStore *cache, SubspaceStoreStats *stats);
 
 #endif							/* TIMESCALEDB_SUBSPACE_STORE_H */
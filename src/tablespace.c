@@ -5,10 +5,14 @@
 #include <utils/acl.h>
 #include <utils/builtins.h>
 #include <utils/fmgroids.h>
+#include <catalog/pg_tablespace.h>
 #include <commands/tablespace.h>
 #include <access/xact.h>
 #include <miscadmin.h>
 #include <funcapi.h>
+#ifndef WIN32
+#include <sys/statvfs.h>
+#endif
 
 #include "hypertable_cache.h"
 #include "errors.h"
@@ -118,7 +122,7 @@ tablespace_scan_internal(int indexid,
 {
 	Catalog    *catalog = catalog_get();
 	ScannerCtx	scanctx = {
-		.table = catalog->tables[TABLESPACE].id,
+		.table = catalog_table_get_id(catalog, TABLESPACE),
 		.index = CATALOG_INDEX(catalog, TABLESPACE, indexid),
 		.nkeys = nkeys,
 		.scankey = scankey,
@@ -154,6 +158,32 @@ tablespace_scan(int32 hypertable_id)
 	return tspcs;
 }
 
+/*
+ * Get the free space, in bytes, of the file system that a tablespace is on,
+ * or -1 if it is not known.
+ */
+int64
+tablespace_get_free_space(Oid tspc_oid)
+{
+#ifndef WIN32
+	struct statvfs buf;
+	char	   *path;
+
+	/* Paths are relative to the data directory */
+	if (tspc_oid == DEFAULTTABLESPACE_OID)
+		path = "base";
+	else if (tspc_oid == GLOBALTABLESPACE_OID)
+		path = "global";
+	else
+		path = psprintf("pg_tblspc/%u", tspc_oid);
+
+	if (statvfs(path, &buf) == 0)
+		return (int64) buf.f_bavail * buf.f_frsize;
+#endif
+
+	return -1;
+}
+
 
 typedef struct TablespaceScanInfo
 {
@@ -335,7 +365,7 @@ tablespace_insert(int32 hypertable_id, const char *tspcname)
 	Relation	rel;
 	int32		id;
 
-	rel = heap_open(catalog->tables[TABLESPACE].id, RowExclusiveLock);
+	rel = heap_open(catalog_table_get_id(catalog, TABLESPACE), RowExclusiveLock);
 	id = tablespace_insert_relation(rel, hypertable_id, tspcname);
 	heap_close(rel, RowExclusiveLock);
 
@@ -350,6 +380,7 @@ tablespace_tuple_delete(TupleInfo *ti, void *data)
 
 	catalog_become_owner(info->catalog, &sec_ctx);
 	catalog_delete_only(ti->scanrel, ti->tuple);
+	catalog_invalidate_cache_for_tuple(ti->scanrel, ti->tuple, CMD_DELETE);
 	catalog_restore_user(&sec_ctx);
 
 	return (info->stopcount == 0 || ti->count < info->stopcount);
@@ -540,6 +571,31 @@ tablespace_attach_internal(Name tspcname, Oid hypertable_oid, bool if_not_attach
 	cache_release(hcache);
 }
 
+/*
+ * Get the OID of a tablespace that chunks of a hypertable can be moved to,
+ * i.e., one that is attached to the hypertable. Attaching checks that the
+ * hypertable's owner can create tables in the tablespace.
+ */
+Oid
+tablespace_get_attached_oid(Hypertable *ht, const char *tspcname)
+{
+	Oid			tspc_oid = get_tablespace_oid(tspcname, true);
+
+	if (!OidIsValid(tspc_oid))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("tablespace \"%s\" does not exist", tspcname)));
+
+	if (!hypertable_has_tablespace(ht, tspc_oid))
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_TABLESPACE_NOT_ATTACHED),
+				 errmsg("tablespace \"%s\" is not attached to hypertable \"%s\"",
+						tspcname, get_rel_name(ht->main_table_relid)),
+				 errhint("Attach the tablespace to the hypertable with attach_tablespace().")));
+
+	return tspc_oid;
+}
+
 static int
 tablespace_detach_one(Oid hypertable_oid, const char *tspcname, Oid tspcoid, bool if_attached)
 {
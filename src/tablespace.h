@@ -6,6 +6,8 @@
 
 #include "catalog.h"
 
+typedef struct Hypertable Hypertable;
+
 typedef struct Tablespace
 {
 	FormData_tablespace fd;
@@ -24,7 +26,9 @@ extern bool tablespaces_delete(Tablespaces *tspcs, Oid tspc_oid);
 extern int	tablespaces_clear(Tablespaces *tspcs);
 extern bool tablespaces_contain(Tablespaces *tspcs, Oid tspc_oid);
 extern Tablespaces *tablespace_scan(int32 hypertable_id);
+extern int64 tablespace_get_free_space(Oid tspc_oid);
 extern void tablespace_attach_internal(Name tspcname, Oid hypertable_oid, bool if_not_attached);
+extern Oid	tablespace_get_attached_oid(Hypertable *ht, const char *tspcname);
 extern int	tablespace_delete(int32 hypertable_id, const char *tspcname);
 extern int	tablespace_count_attached(const char *tspcname);
 extern void tablespace_validate_revoke(GrantStmt *stmt);
@@ -0,0 +1,270 @@
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <funcapi.h>
+#include <miscadmin.h>
+#include <pgstat.h>
+#include <storage/proc.h>
+#include <storage/procarray.h>
+#include <utils/builtins.h>
+#include <utils/hsearch.h>
+#include <utils/memutils.h>
+
+#include "timing.h"
+#include "compat.h"
+
+/*
+ * Timing of metadata operations, to tell apart what an insert spends its time
+ * on during latency spikes.
+ *
+ * Each operation is timed per backend, and per relation for catalog scans,
+ * and shown by timing_stats(). While an operation runs, the backend reports
+ * an extension wait event that identifies the operation, so that a stalled
+ * backend can be diagnosed from pg_stat_activity. PostgreSQL shows all
+ * extension wait events as "Extension", so backend_wait_event() decodes the
+ * operation. Operations can nest, e.g., catalog scans during chunk creation,
+ * in which case the wait event of the outer operation is restored when the
+ * inner one ends. Wait events of the backend itself, e.g., for locks or I/O,
+ * take precedence while they last.
+ *
+ * Wait events are not reported on PostgreSQL 9.6, which lacks the extension
+ * wait event class.
+ */
+
+static const char *timing_operation_names[_TIMING_NUM_OPERATIONS] = {
+	[TIMING_CATALOG_SCAN] = "CatalogScan",
+	[TIMING_CHUNK_CREATE] = "ChunkCreate",
+	[TIMING_CHUNK_INDEX_CREATE] = "ChunkIndexCreate",
+	[TIMING_HYPERTABLE_CACHE_REBUILD] = "HypertableCacheRebuild",
+};
+
+/*
+ * Wait event IDs start after zero, which is the generic extension wait event
+ * used when waiting on latches.
+ */
+#define TIMING_WAIT_EVENT_ID(op) ((op) + 1)
+
+typedef struct TimingKey
+{
+	TimingOperation op;
+	Oid			relid;
+} TimingKey;
+
+typedef struct TimingEntry
+{
+	TimingKey	key;
+	uint64		calls;
+	instr_time	total;
+	instr_time	max;
+} TimingEntry;
+
+static HTAB *timing_entries = NULL;
+static instr_time timing_totals[_TIMING_NUM_OPERATIONS];
+
+static TimingEntry *
+timing_entry_get(TimingOperation op, Oid relid)
+{
+	TimingKey	key = {
+		.op = op,
+		.relid = relid,
+	};
+	TimingEntry *entry;
+	bool		found;
+
+	if (NULL == timing_entries)
+	{
+		HASHCTL		ctl = {
+			.keysize = sizeof(TimingKey),
+			.entrysize = sizeof(TimingEntry),
+			.hcxt = TopMemoryContext,
+		};
+
+		timing_entries = hash_create("Timing entries", 32, &ctl,
+									 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	entry = hash_search(timing_entries, &key, HASH_ENTER, &found);
+
+	if (!found)
+	{
+		entry->calls = 0;
+		INSTR_TIME_SET_ZERO(entry->total);
+		INSTR_TIME_SET_ZERO(entry->max);
+	}
+
+	return entry;
+}
+
+void
+timing_begin(TimingState *state, TimingOperation op)
+{
+	state->op = op;
+	state->prev_wait_event_info = 0;
+
+#if PG10
+	if (NULL != MyProc)
+		state->prev_wait_event_info = MyProc->wait_event_info;
+
+	pgstat_report_wait_start(PG_WAIT_EXTENSION | TIMING_WAIT_EVENT_ID(op));
+#endif
+
+	INSTR_TIME_SET_CURRENT(state->start);
+}
+
+/*
+ * End the timing of an operation. The relation is the catalog table for
+ * scans, and invalid otherwise.
+ */
+void
+timing_end(TimingState *state, Oid relid)
+{
+	TimingEntry *entry;
+	instr_time	duration;
+
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, state->start);
+
+#if PG10
+	if (state->prev_wait_event_info != 0)
+		pgstat_report_wait_start(state->prev_wait_event_info);
+	else
+		pgstat_report_wait_end();
+#endif
+
+	entry = timing_entry_get(state->op, relid);
+	entry->calls++;
+	INSTR_TIME_ADD(entry->total, duration);
+
+	if (INSTR_TIME_GET_MICROSEC(duration) > INSTR_TIME_GET_MICROSEC(entry->max))
+		entry->max = duration;
+
+	INSTR_TIME_ADD(timing_totals[state->op], duration);
+}
+
+/*
+ * Get the total time, in milliseconds, this backend has spent in an
+ * operation.
+ */
+double
+timing_get_total(TimingOperation op)
+{
+	return INSTR_TIME_GET_MILLISEC(timing_totals[op]);
+}
+
+enum Anum_timing_stats
+{
+	Anum_timing_stats_operation = 1,
+	Anum_timing_stats_relation,
+	Anum_timing_stats_calls,
+	Anum_timing_stats_total_time,
+	Anum_timing_stats_max_time,
+	_Anum_timing_stats_max,
+};
+
+#define Natts_timing_stats \
+	(_Anum_timing_stats_max - 1)
+
+static HeapTuple
+timing_entry_to_tuple(TimingEntry *entry, TupleDesc tupdesc)
+{
+	Datum		values[Natts_timing_stats];
+	bool		nulls[Natts_timing_stats] = {false};
+
+	values[Anum_timing_stats_operation - 1] =
+		CStringGetTextDatum(timing_operation_names[entry->key.op]);
+	values[Anum_timing_stats_relation - 1] = ObjectIdGetDatum(entry->key.relid);
+	nulls[Anum_timing_stats_relation - 1] = !OidIsValid(entry->key.relid);
+	values[Anum_timing_stats_calls - 1] = Int64GetDatum((int64) entry->calls);
+	values[Anum_timing_stats_total_time - 1] = Float8GetDatum(INSTR_TIME_GET_MILLISEC(entry->total));
+	values[Anum_timing_stats_max_time - 1] = Float8GetDatum(INSTR_TIME_GET_MILLISEC(entry->max));
+
+	return heap_form_tuple(tupdesc, values, nulls);
+}
+
+TS_FUNCTION_INFO_V1(timing_stats);
+
+/*
+ * Show the time this backend has spent in metadata operations. Times are in
+ * milliseconds.
+ */
+Datum
+timing_stats(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	List	   *rows;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupdesc;
+		HASH_SEQ_STATUS status;
+		TimingEntry *entry;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			elog(ERROR, "Function returning record called in context that cannot accept type record");
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+		rows = NIL;
+
+		/* Copy the entries, since timing continues while we return rows */
+		if (NULL != timing_entries)
+		{
+			hash_seq_init(&status, timing_entries);
+
+			while ((entry = hash_seq_search(&status)) != NULL)
+			{
+				TimingEntry *copy = palloc(sizeof(TimingEntry));
+
+				*copy = *entry;
+				rows = lappend(rows, copy);
+			}
+		}
+
+		funcctx->user_fctx = rows;
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	rows = funcctx->user_fctx;
+
+	if (funcctx->call_cntr < (uint64) list_length(rows))
+	{
+		TimingEntry *entry = list_nth(rows, funcctx->call_cntr);
+		HeapTuple	tuple = timing_entry_to_tuple(entry, funcctx->tuple_desc);
+
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+TS_FUNCTION_INFO_V1(backend_wait_event);
+
+/*
+ * Get the metadata operation a backend is currently in, according to its
+ * wait event, or NULL if it is not in one.
+ */
+Datum
+backend_wait_event(PG_FUNCTION_ARGS)
+{
+#if PG10
+	PGPROC	   *proc = BackendPidGetProc(PG_GETARG_INT32(0));
+	uint32		wait_event_info;
+	uint32		event_id;
+
+	if (NULL == proc)
+		PG_RETURN_NULL();
+
+	wait_event_info = *((volatile uint32 *) &proc->wait_event_info);
+	event_id = wait_event_info & 0x0000FFFF;
+
+	if ((wait_event_info & 0xFF000000) == PG_WAIT_EXTENSION &&
+		event_id >= TIMING_WAIT_EVENT_ID(0) &&
+		event_id < TIMING_WAIT_EVENT_ID(_TIMING_NUM_OPERATIONS))
+		PG_RETURN_TEXT_P(cstring_to_text(timing_operation_names[event_id - TIMING_WAIT_EVENT_ID(0)]));
+#endif
+
+	PG_RETURN_NULL();
+}
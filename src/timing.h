@@ -0,0 +1,31 @@
+#ifndef TIMESCALEDB_TIMING_H
+#define TIMESCALEDB_TIMING_H
+
+#include <postgres.h>
+#include <portability/instr_time.h>
+
+/*
+ * Operations on metadata that can stall inserts. Each is timed, and reported
+ * as a wait event while it runs.
+ */
+typedef enum TimingOperation
+{
+	TIMING_CATALOG_SCAN = 0,
+	TIMING_CHUNK_CREATE,
+	TIMING_CHUNK_INDEX_CREATE,
+	TIMING_HYPERTABLE_CACHE_REBUILD,
+	_TIMING_NUM_OPERATIONS,
+} TimingOperation;
+
+typedef struct TimingState
+{
+	TimingOperation op;
+	instr_time	start;
+	uint32		prev_wait_event_info;
+} TimingState;
+
+extern void timing_begin(TimingState *state, TimingOperation op);
+extern void timing_end(TimingState *state, Oid relid);
+extern double timing_get_total(TimingOperation op);
+
+#endif							/* TIMESCALEDB_TIMING_H */
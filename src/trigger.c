@@ -131,11 +131,18 @@ create_trigger_handler(Trigger *trigger, void *arg)
 	Chunk	   *chunk = arg;
 
 #if PG10
-	if (TRIGGER_USES_TRANSITION_TABLE(trigger->tgnewtable) ||
-		TRIGGER_USES_TRANSITION_TABLE(trigger->tgoldtable))
+
+	/*
+	 * Statement-level triggers only fire on the hypertable, which collects
+	 * the transition tables of all chunks. Row-level triggers are recreated
+	 * on each chunk, where transition tables are not supported.
+	 */
+	if (trigger_is_chunk_trigger(trigger) &&
+		(TRIGGER_USES_TRANSITION_TABLE(trigger->tgnewtable) ||
+		 TRIGGER_USES_TRANSITION_TABLE(trigger->tgoldtable)))
 		ereport(ERROR,
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-				 errmsg("Hypertables do not support transition tables in triggers.")));
+				 errmsg("Hypertables do not support transition tables in row-level triggers.")));
 #endif
 	if (trigger_is_chunk_trigger(trigger))
 		trigger_create_on_chunk(trigger->tgoid,
@@ -157,8 +164,9 @@ check_for_transition_table(Trigger *trigger, void *arg)
 {
 	bool	   *found = arg;
 
-	if (TRIGGER_USES_TRANSITION_TABLE(trigger->tgnewtable) ||
-		TRIGGER_USES_TRANSITION_TABLE(trigger->tgoldtable))
+	if (trigger_is_chunk_trigger(trigger) &&
+		(TRIGGER_USES_TRANSITION_TABLE(trigger->tgnewtable) ||
+		 TRIGGER_USES_TRANSITION_TABLE(trigger->tgoldtable)))
 	{
 		*found = true;
 		return false;
@@ -168,8 +176,12 @@ check_for_transition_table(Trigger *trigger, void *arg)
 }
 #endif
 
+/*
+ * Check if a relation has row-level triggers with transition tables, which
+ * cannot be recreated on chunks.
+ */
 bool
-relation_has_transition_table_trigger(Oid relid)
+relation_has_row_transition_table_trigger(Oid relid)
 {
 	bool		found = false;
 
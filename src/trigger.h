@@ -12,6 +12,6 @@
 extern Trigger *trigger_by_name(Oid relid, const char *name, bool missing_ok);
 extern void trigger_create_on_chunk(Oid trigger_oid, char *chunk_schema_name, char *chunk_table_name);
 extern void trigger_create_all_on_chunk(Hypertable *ht, Chunk *chunk);
-extern bool relation_has_transition_table_trigger(Oid relid);
+extern bool relation_has_row_transition_table_trigger(Oid relid);
 
 #endif							/* TIMESCALEDB_TRIGGER_H */
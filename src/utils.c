@@ -11,6 +11,7 @@
 #include <utils/datetime.h>
 #include <utils/lsyscache.h>
 #include <utils/syscache.h>
+#include <utils/memutils.h>
 
 #include "utils.h"
 #include "compat.h"
@@ -73,15 +74,12 @@ pg_microseconds_to_timestamp(PG_FUNCTION_ARGS)
 	PG_RETURN_TIMESTAMPTZ(timestamp);
 }
 
-TS_FUNCTION_INFO_V1(pg_timestamp_to_unix_microseconds);
-
 /*
  * Convert a Postgres TIMESTAMP to BIGINT microseconds relative the UNIX epoch.
  */
-Datum
-pg_timestamp_to_unix_microseconds(PG_FUNCTION_ARGS)
+static inline int64
+timestamp_to_unix_microseconds(TimestampTz timestamp)
 {
-	TimestampTz timestamp = PG_GETARG_TIMESTAMPTZ(0);
 	int64		epoch_diff_microseconds = (POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE) * USECS_PER_DAY;
 	int64		microseconds;
 
@@ -105,7 +103,15 @@ pg_timestamp_to_unix_microseconds(PG_FUNCTION_ARGS)
 		microseconds = (seconds * USECS_PER_SEC) + ((timestamp - seconds) * USECS_PER_SEC) + epoch_diff_microseconds;
 	}
 #endif
-	PG_RETURN_INT64(microseconds);
+	return microseconds;
+}
+
+TS_FUNCTION_INFO_V1(pg_timestamp_to_unix_microseconds);
+
+Datum
+pg_timestamp_to_unix_microseconds(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_INT64(timestamp_to_unix_microseconds(PG_GETARG_TIMESTAMPTZ(0)));
 }
 
 TS_FUNCTION_INFO_V1(pg_unix_microseconds_to_timestamp);
@@ -162,48 +168,79 @@ time_to_internal(PG_FUNCTION_ARGS)
 }
 
 
-/*	*/
-int64
-time_value_to_internal(Datum time_val, Oid type)
+static int64
+int8_value_to_internal(Datum time_val)
 {
-	if (type == INT8OID)
-	{
-		return DatumGetInt64(time_val);
-	}
-	if (type == INT4OID)
-	{
-		return (int64) DatumGetInt32(time_val);
-	}
-	if (type == INT2OID)
-	{
-		return (int64) DatumGetInt16(time_val);
-	}
-	if (type == TIMESTAMPOID)
-	{
-		/*
-		 * for timestamps, ignore timezones, make believe the timestamp is at
-		 * UTC
-		 */
-		Datum		res = DirectFunctionCall1(pg_timestamp_to_unix_microseconds, time_val);
+	return DatumGetInt64(time_val);
+}
 
-		return DatumGetInt64(res);
-	}
-	if (type == TIMESTAMPTZOID)
-	{
-		Datum		res = DirectFunctionCall1(pg_timestamp_to_unix_microseconds, time_val);
+static int64
+int4_value_to_internal(Datum time_val)
+{
+	return (int64) DatumGetInt32(time_val);
+}
 
-		return DatumGetInt64(res);
-	}
-	if (type == DATEOID)
-	{
-		Datum		tz = DirectFunctionCall1(date_timestamp, time_val);
-		Datum		res = DirectFunctionCall1(pg_timestamp_to_unix_microseconds, tz);
+static int64
+int2_value_to_internal(Datum time_val)
+{
+	return (int64) DatumGetInt16(time_val);
+}
 
-		return DatumGetInt64(res);
+/*
+ * Timestamps with and without time zone are both converted as if they were
+ * at UTC, i.e., timezones are ignored.
+ */
+static int64
+timestamp_value_to_internal(Datum time_val)
+{
+	return timestamp_to_unix_microseconds(DatumGetTimestampTz(time_val));
+}
+
+static int64
+date_value_to_internal(Datum time_val)
+{
+	Datum		ts = DirectFunctionCall1(date_timestamp, time_val);
+
+	return timestamp_to_unix_microseconds(DatumGetTimestamp(ts));
+}
+
+/*
+ * Get the function that converts values of a type into the internal time
+ * representation, or NULL if the type is not a time type. Callers that
+ * convert many values of the same type, e.g., the partitioning column of
+ * every inserted row, look the function up once instead of dispatching on
+ * the type for each value.
+ */
+TimeValueToInternalFunc
+time_value_to_internal_func(Oid type)
+{
+	switch (type)
+	{
+		case INT8OID:
+			return int8_value_to_internal;
+		case INT4OID:
+			return int4_value_to_internal;
+		case INT2OID:
+			return int2_value_to_internal;
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return timestamp_value_to_internal;
+		case DATEOID:
+			return date_value_to_internal;
+		default:
+			return NULL;
 	}
+}
+
+int64
+time_value_to_internal(Datum time_val, Oid type)
+{
+	TimeValueToInternalFunc func = time_value_to_internal_func(type);
 
-	elog(ERROR, "unkown time type oid '%d'", type);
-	return -1;
+	if (NULL == func)
+		elog(ERROR, "unkown time type oid '%d'", type);
+
+	return func(time_val);
 }
 
 /* Make a RangeVar from a regclass Oid */
@@ -248,6 +285,17 @@ create_fmgr(char *schema, char *function_name, int num_args)
 	return finfo;
 }
 
+/*
+ * Convert an interval to microseconds, taking a month to be 30 days.
+ */
+int64
+interval_to_usec(Interval *interval)
+{
+	return (interval->month * DAYS_PER_MONTH * USECS_PER_DAY)
+		+ (interval->day * USECS_PER_DAY)
+		+ interval->time;
+}
+
 static inline int64
 get_interval_period(Interval *interval)
 {
@@ -272,19 +320,118 @@ get_interval_period(Interval *interval)
 #endif
 }
 
-TS_FUNCTION_INFO_V1(timestamp_bucket);
-Datum
-timestamp_bucket(PG_FUNCTION_ARGS)
+static inline void
+check_period_is_daily(int64 period)
 {
-	Interval   *interval = PG_GETARG_INTERVAL_P(0);
-	Timestamp	timestamp = PG_GETARG_TIMESTAMP(1);
-	Timestamp	result;
-	int64		period = -1;
+#ifdef HAVE_INT64_TIMESTAMP
+	int64		day = USECS_PER_DAY;
+#else
+	int64		day = SECS_PER_DAY;
+#endif
+	if (period < day)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("interval must not have sub-day precision")
+				 ));
+	}
+	if (period % day != 0)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("interval must be a multiple of a day")
+				 ));
 
-	if (TIMESTAMP_NOT_FINITE(timestamp))
-		PG_RETURN_TIMESTAMP(timestamp);
+	}
+}
+
+/*
+ * Get the width of the buckets of a time_bucket() call, i.e., its first
+ * argument. The width is almost always a constant, so it is converted and
+ * checked only once per query and cached in fn_extra.
+ */
+static int64
+get_bucket_period(FunctionCallInfo fcinfo, bool daily)
+{
+	FmgrInfo   *flinfo = fcinfo->flinfo;
+	int64		period;
+
+	if (NULL != flinfo && NULL != flinfo->fn_extra)
+		return *((int64 *) flinfo->fn_extra);
+
+	period = get_interval_period(PG_GETARG_INTERVAL_P(0));
+
+	if (period <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("interval must be greater than 0")
+				 ));
+
+	/* check the period aligns on a date */
+	if (daily)
+		check_period_is_daily(period);
+
+	if (NULL != flinfo && get_fn_expr_arg_stable(flinfo, 0))
+	{
+		flinfo->fn_extra = MemoryContextAlloc(flinfo->fn_mcxt, sizeof(int64));
+		*((int64 *) flinfo->fn_extra) = period;
+	}
+
+	return period;
+}
+
+#ifdef HAVE_INT64_TIMESTAMP
+
+/* Round down to a multiple of the period, also for negative timestamps */
+static inline int64
+bucket_period(int64 timestamp, int64 period)
+{
+	int64		result = (timestamp / period) * period;
+
+	/*
+	 * Division truncates toward 0 in C99, so go down another period if the
+	 * timestamp is negative and not a multiple of the period.
+	 */
+	if (result > timestamp)
+		result -= period;
+
+	return result;
+}
+
+#define BUCKET_CASE(timestamp, width) \
+	case width: \
+		return bucket_period(timestamp, width)
+
+/*
+ * A division by a constant compiles to a much cheaper multiplication, so the
+ * most common widths get code paths of their own.
+ */
+static inline Timestamp
+bucket_timestamp(Timestamp timestamp, int64 period)
+{
+	switch (period)
+	{
+		BUCKET_CASE(timestamp, INT64CONST(1000));
+		BUCKET_CASE(timestamp, USECS_PER_SEC);
+		BUCKET_CASE(timestamp, 10 * USECS_PER_SEC);
+		BUCKET_CASE(timestamp, USECS_PER_MINUTE);
+		BUCKET_CASE(timestamp, 5 * USECS_PER_MINUTE);
+		BUCKET_CASE(timestamp, 10 * USECS_PER_MINUTE);
+		BUCKET_CASE(timestamp, 15 * USECS_PER_MINUTE);
+		BUCKET_CASE(timestamp, USECS_PER_HOUR);
+		BUCKET_CASE(timestamp, USECS_PER_DAY);
+		default:
+			return bucket_period(timestamp, period);
+	}
+}
+
+#else
+
+static inline Timestamp
+bucket_timestamp(Timestamp timestamp, int64 period)
+{
+	Timestamp	result;
 
-	period = get_interval_period(interval);
 	/* result = (timestamp / period) * period */
 	TMODULO(timestamp, result, period);
 	if (timestamp < 0)
@@ -301,86 +448,203 @@ timestamp_bucket(PG_FUNCTION_ARGS)
 	{
 		result *= period;
 	}
-	PG_RETURN_TIMESTAMP(result);
+	return result;
+}
+
+#endif							/* HAVE_INT64_TIMESTAMP */
+
+TS_FUNCTION_INFO_V1(timestamp_bucket);
+Datum
+timestamp_bucket(PG_FUNCTION_ARGS)
+{
+	Timestamp	timestamp = PG_GETARG_TIMESTAMP(1);
+
+	if (TIMESTAMP_NOT_FINITE(timestamp))
+		PG_RETURN_TIMESTAMP(timestamp);
+
+	PG_RETURN_TIMESTAMP(bucket_timestamp(timestamp, get_bucket_period(fcinfo, false)));
 }
 
 TS_FUNCTION_INFO_V1(timestamptz_bucket);
 Datum
 timestamptz_bucket(PG_FUNCTION_ARGS)
 {
-	Interval   *interval = PG_GETARG_INTERVAL_P(0);
 	TimestampTz timestamp = PG_GETARG_TIMESTAMPTZ(1);
-	TimestampTz result;
-	int64		period = -1;
 
 	if (TIMESTAMP_NOT_FINITE(timestamp))
 		PG_RETURN_TIMESTAMPTZ(timestamp);
 
-	period = get_interval_period(interval);
-	/* result = (timestamp / period) * period */
-	TMODULO(timestamp, result, period);
-	if (timestamp < 0)
-	{
-		/*
-		 * need to subtract another period if remainder < 0 this only happens
-		 * if timestamp is negative to begin with and there is a remainder
-		 * after division. Need to subtract another period since division
-		 * truncates toward 0 in C99.
-		 */
-		result = (result * period) - period;
-	}
-	else
-	{
-		result *= period;
-	}
-	PG_RETURN_TIMESTAMPTZ(result);
+	PG_RETURN_TIMESTAMPTZ(bucket_timestamp(timestamp, get_bucket_period(fcinfo, false)));
 }
 
-static inline void
-check_period_is_daily(int64 period)
+TS_FUNCTION_INFO_V1(date_bucket);
+
+Datum
+date_bucket(PG_FUNCTION_ARGS)
 {
+	DateADT		date = PG_GETARG_DATEADT(1);
+	int64		days;
+	int64		result;
+
+	if (DATE_NOT_FINITE(date))
+		PG_RETURN_DATEADT(date);
+
 #ifdef HAVE_INT64_TIMESTAMP
-	int64		day = USECS_PER_DAY;
+	days = get_bucket_period(fcinfo, true) / USECS_PER_DAY;
 #else
-	int64		day = SECS_PER_DAY;
+	days = get_bucket_period(fcinfo, true) / SECS_PER_DAY;
 #endif
-	if (period < day)
-	{
+
+	/*
+	 * Dates and timestamps share the same epoch, so bucketing the days is the
+	 * same as bucketing the date as a timestamp (NOT tz)
+	 */
+	result = (date / days) * days;
+	if (result > date)
+		result -= days;
+
+	if (result < PG_INT32_MIN)
 		ereport(ERROR,
-				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-				 errmsg("interval must not have sub-day precision")
-				 ));
-	}
-	if (period % day != 0)
-	{
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("date out of range")));
+
+	PG_RETURN_DATEADT((DateADT) result);
+}
+
+/*
+ * time_bucket() on integer time. As in the SQL functions these replace, the
+ * quotient is truncated toward 0.
+ */
+static inline void
+check_integer_period(int64 period, int64 timestamp, int64 min, const char *type_name)
+{
+	if (period == 0)
 		ereport(ERROR,
-				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-				 errmsg("interval must be a multiple of a day")
-				 ));
+				(errcode(ERRCODE_DIVISION_BY_ZERO),
+				 errmsg("division by zero")));
 
-	}
+	if (period == -1 && timestamp == min)
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("%s out of range", type_name)));
 }
 
-TS_FUNCTION_INFO_V1(date_bucket);
+TS_FUNCTION_INFO_V1(int16_bucket);
+Datum
+int16_bucket(PG_FUNCTION_ARGS)
+{
+	int16		period = PG_GETARG_INT16(0);
+	int16		timestamp = PG_GETARG_INT16(1);
+
+	check_integer_period(period, timestamp, PG_INT16_MIN, "smallint");
+
+	PG_RETURN_INT16((timestamp / period) * period);
+}
 
+TS_FUNCTION_INFO_V1(int32_bucket);
 Datum
-date_bucket(PG_FUNCTION_ARGS)
+int32_bucket(PG_FUNCTION_ARGS)
 {
-	Interval   *interval = PG_GETARG_INTERVAL_P(0);
-	DateADT		date = PG_GETARG_DATEADT(1);
-	Datum		converted_ts,
-				bucketed;
-	int64		period = -1;
+	int32		period = PG_GETARG_INT32(0);
+	int32		timestamp = PG_GETARG_INT32(1);
 
-	if (DATE_NOT_FINITE(date))
-		PG_RETURN_DATEADT(date);
+	check_integer_period(period, timestamp, PG_INT32_MIN, "integer");
 
-	period = get_interval_period(interval);
-	/* check the period aligns on a date */
-	check_period_is_daily(period);
+	PG_RETURN_INT32((timestamp / period) * period);
+}
+
+TS_FUNCTION_INFO_V1(int64_bucket);
+Datum
+int64_bucket(PG_FUNCTION_ARGS)
+{
+	int64		period = PG_GETARG_INT64(0);
+	int64		timestamp = PG_GETARG_INT64(1);
+
+	check_integer_period(period, timestamp, PG_INT64_MIN, "bigint");
+
+	PG_RETURN_INT64((timestamp / period) * period);
+}
+
+/*
+ * Get the total amount of memory allocated by a memory context and all its
+ * children.
+ */
+int64
+memory_context_total_space(MemoryContext context)
+{
+	MemoryContextCounters totals = {0};
+	MemoryContext child;
+	int64		total;
+
+	MemoryContextCountCompat(context, &totals);
+	total = totals.totalspace;
+
+	for (child = context->firstchild; child != NULL; child = child->nextchild)
+		total += memory_context_total_space(child);
+
+	return total;
+}
+
+/*
+ * Check if an expression is a time_bucket() call with a constant width on a
+ * column, i.e., "time_bucket(width, column)", and get the column and the
+ * width in the internal time units of the column. The variants with an offset
+ * are SQL functions that are inlined into other expressions and never match.
+ */
+Var *
+time_bucket_get_var(Node *expr, int64 *width)
+{
+	FuncExpr   *func;
+	Const	   *width_const;
+	char	   *func_name;
+
+	if (!IsA(expr, FuncExpr))
+		return NULL;
+
+	func = (FuncExpr *) expr;
+
+	if (list_length(func->args) != 2 ||
+		!IsA(linitial(func->args), Const) ||
+		!IsA(lsecond(func->args), Var))
+		return NULL;
+
+	func_name = get_func_name(func->funcid);
+
+	if (NULL == func_name || strncmp(func_name, "time_bucket", NAMEDATALEN) != 0)
+		return NULL;
+
+	width_const = linitial(func->args);
+
+	if (width_const->constisnull)
+		return NULL;
+
+	switch (width_const->consttype)
+	{
+		case INT2OID:
+			*width = DatumGetInt16(width_const->constvalue);
+			break;
+		case INT4OID:
+			*width = DatumGetInt32(width_const->constvalue);
+			break;
+		case INT8OID:
+			*width = DatumGetInt64(width_const->constvalue);
+			break;
+		case INTERVALOID:
+			{
+				Interval   *interval = DatumGetIntervalP(width_const->constvalue);
+
+				if (interval->month != 0)
+					return NULL;
+
+				*width = interval->time + (interval->day * USECS_PER_DAY);
+				break;
+			}
+		default:
+			return NULL;
+	}
+
+	if (*width <= 0)
+		return NULL;
 
-	/* convert to timestamp (NOT tz), bucket, convert back to date */
-	converted_ts = DirectFunctionCall1(date_timestamp, PG_GETARG_DATUM(1));
-	bucketed = DirectFunctionCall2(timestamp_bucket, PG_GETARG_DATUM(0), converted_ts);
-	return DirectFunctionCall1(timestamp_date, bucketed);
+	return lsecond(func->args);
 }
@@ -5,12 +5,18 @@
 #include <fmgr.h>
 #include <nodes/primnodes.h>
 #include <catalog/pg_proc.h>
+#include <utils/timestamp.h>
 
 /*
  * Convert a column value into the internal time representation.
  */
+typedef int64 (*TimeValueToInternalFunc) (Datum time_val);
+
+extern TimeValueToInternalFunc time_value_to_internal_func(Oid type);
 extern int64 time_value_to_internal(Datum time_val, Oid type);
 
+extern int64 interval_to_usec(Interval *interval);
+
 #if 0
 #define CACHE1_elog(a,b)				elog(a,b)
 #define CACHE2_elog(a,b,c)				elog(a,b,c)
@@ -30,6 +36,16 @@ extern int64 time_value_to_internal(Datum time_val, Oid type);
 extern FmgrInfo *create_fmgr(char *schema, char *function_name, int num_args);
 extern RangeVar *makeRangeVarFromRelid(Oid relid);
 extern int	int_cmp(const void *a, const void *b);
+extern int64 memory_context_total_space(MemoryContext context);
+extern Var *time_bucket_get_var(Node *expr, int64 *width);
+
+/* The C implementations of time_bucket() */
+extern PGDLLEXPORT Datum timestamp_bucket(PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum timestamptz_bucket(PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum date_bucket(PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum int16_bucket(PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum int32_bucket(PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum int64_bucket(PG_FUNCTION_ARGS);
 
 #define DATUM_GET(values, attno) \
 	values[attno-1]
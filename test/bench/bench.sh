@@ -0,0 +1,75 @@
+#!/usr/bin/env bash
+#
+# Run benchmarks against an existing PostgreSQL instance that has the
+# extension installed. Each run appends one CSV line per benchmark
+# configuration to ${BENCH_OUTPUT_DIR}/bench_<suite>.csv, so that results of
+# different builds can be compared.
+#
+# Usage: bench.sh <suite>
+#
+# The connection is set via the usual PG* environment variables, and the
+# benchmark configurations via the BENCH_* variables below.
+
+set -u
+set -e
+
+EXE_DIR=$(cd $(dirname $0) && pwd)
+SUITE=${1:-}
+PSQL=${PSQL:-psql}
+PGBENCH=${PGBENCH:-pgbench}
+BENCH_DBNAME=${BENCH_DBNAME:-bench}
+BENCH_OUTPUT_DIR=${BENCH_OUTPUT_DIR:-$(pwd)}
+BENCH_LABEL=${BENCH_LABEL:-$(cd ${EXE_DIR} && git rev-parse --short HEAD 2>/dev/null || echo unknown)}
+
+if [[ ! -f ${EXE_DIR}/bench_${SUITE}.sh ]]; then
+    echo "Usage: $0 <suite>" >&2
+    echo "Available suites:" $(cd ${EXE_DIR} && ls bench_*.sh | sed 's/bench_\(.*\)\.sh/\1/') >&2
+    exit 1
+fi
+
+BENCH_TMP_DIR=$(mktemp -d 2>/dev/null || mktemp -d -t 'timescaledb_bench')
+
+function cleanup {
+    rm -rf ${BENCH_TMP_DIR}
+}
+
+trap cleanup EXIT
+
+function bench_psql {
+    ${PSQL} -X -q -v ON_ERROR_STOP=1 -d ${BENCH_DBNAME} "$@"
+}
+
+# Recreate the benchmark database, so that every configuration starts
+# from the same state
+function bench_reset_db {
+    ${PSQL} -X -q -v ON_ERROR_STOP=1 -d postgres -c "DROP DATABASE IF EXISTS ${BENCH_DBNAME};" >/dev/null
+    ${PSQL} -X -q -v ON_ERROR_STOP=1 -d postgres -c "CREATE DATABASE ${BENCH_DBNAME};"
+    bench_psql -c "CREATE EXTENSION timescaledb;" >/dev/null
+}
+
+# Print the average, median, 95th and 99th percentile of a file with one
+# latency in milliseconds per line, separated by commas
+function latency_stats {
+    sort -g $1 | awk '
+        { v[NR] = $1; sum += $1 }
+        function pct(p,  i) { i = int(NR * p + 0.5); if (i < 1) i = 1; return v[i] }
+        END {
+            if (NR == 0) { print ",,,"; exit }
+            printf "%.3f,%.3f,%.3f,%.3f\n", sum / NR, pct(0.50), pct(0.95), pct(0.99)
+        }'
+}
+
+# Append a result line, writing the header first if the file is new
+function bench_result {
+    local file=$1 header=$2 line=$3
+
+    if [[ ! -f ${file} ]]; then
+        echo "label,${header}" > ${file}
+    fi
+
+    echo "${BENCH_LABEL},${line}" | tee -a ${file}
+}
+
+mkdir -p ${BENCH_OUTPUT_DIR}
+
+source ${EXE_DIR}/bench_${SUITE}.sh
@@ -0,0 +1,148 @@
+# Ingest benchmark, sourced by bench.sh
+#
+# Loads synthetic rows into an empty hypertable and reports rows/sec and
+# the latency of each statement (a row, a batch of rows, or a COPY) for
+# every combination of the configurations below.
+#
+# Rows are one second apart, so the chunk time interval is picked to give
+# the requested number of chunks. With "random" time order, rows are spread
+# randomly over the same time range instead of being inserted in time order.
+
+BENCH_ROWS=${BENCH_ROWS:-100000}
+BENCH_BATCH_SIZE=${BENCH_BATCH_SIZE:-1000}
+BENCH_CLIENTS=${BENCH_CLIENTS:-1}
+BENCH_METHODS=${BENCH_METHODS:-single prepared multi copy}
+BENCH_DIMENSIONS=${BENCH_DIMENSIONS:-1 2 3}
+BENCH_CHUNKS=${BENCH_CHUNKS:-10 100 1000}
+BENCH_TIME_ORDERS=${BENCH_TIME_ORDERS:-ordered random}
+
+RESULT_FILE=${BENCH_OUTPUT_DIR}/bench_ingest.csv
+RESULT_HEADER="method,dimensions,chunks,chunks_created,time_order,clients,batch_size,rows,rows_per_sec,lat_avg_ms,lat_p50_ms,lat_p95_ms,lat_p99_ms"
+
+# Create the hypertable and the function that generates the time of the
+# next row
+function ingest_setup {
+    local dimensions=$1 chunks=$2 time_order=$3
+    local partitions=1 time_expr
+
+    case ${dimensions} in
+        2) partitions=4 ;;
+        3) partitions=8 ;;
+    esac
+
+    local slices=$(( chunks / partitions > 0 ? chunks / partitions : 1 ))
+    local interval=$(( (BENCH_ROWS + slices - 1) / slices ))
+
+    if [[ ${time_order} == ordered ]]; then
+        time_expr="nextval('ingest_seq')"
+    else
+        time_expr="floor(random() * ${BENCH_ROWS})"
+    fi
+
+    bench_psql <<SQL >/dev/null
+DROP TABLE IF EXISTS ingest;
+DROP SEQUENCE IF EXISTS ingest_seq;
+CREATE SEQUENCE ingest_seq;
+CREATE TABLE ingest(time timestamptz NOT NULL, device int NOT NULL, location int NOT NULL, value float8);
+SELECT create_hypertable('ingest', 'time', chunk_time_interval => interval '${interval} seconds');
+$( (( dimensions >= 2 )) && echo "SELECT add_dimension('ingest', 'device', number_partitions => 4);" )
+$( (( dimensions >= 3 )) && echo "SELECT add_dimension('ingest', 'location', number_partitions => 2);" )
+CREATE OR REPLACE FUNCTION ingest_time() RETURNS timestamptz LANGUAGE SQL VOLATILE AS
+\$\$ SELECT '2018-01-01'::timestamptz + ${time_expr} * interval '1 second' \$\$;
+SQL
+}
+
+# Run a pgbench script and write the latency of each transaction to a file
+function ingest_pgbench {
+    local method=$1 rows_per_txn=$2 latency_file=$3
+    local script mode=simple
+    local txns=$(( BENCH_ROWS / (BENCH_CLIENTS * rows_per_txn) ))
+
+    case ${method} in
+        single) script=ingest_single.pgbench ;;
+        prepared) script=ingest_single.pgbench; mode=prepared ;;
+        multi) script=ingest_multi.pgbench ;;
+    esac
+
+    rm -f ${BENCH_TMP_DIR}/ingest_log*
+
+    ${PGBENCH} -n -d ${BENCH_DBNAME} \
+               -c ${BENCH_CLIENTS} -j ${BENCH_CLIENTS} -t ${txns} \
+               -M ${mode} -D batch_size=${BENCH_BATCH_SIZE} \
+               -f ${EXE_DIR}/${script} \
+               -l --log-prefix=${BENCH_TMP_DIR}/ingest_log \
+               > ${BENCH_TMP_DIR}/pgbench.out 2>&1 || {
+        cat ${BENCH_TMP_DIR}/pgbench.out >&2
+        exit 1
+    }
+
+    # The third field is the transaction latency in microseconds
+    cat ${BENCH_TMP_DIR}/ingest_log* | awk '{ print $3 / 1000 }' > ${latency_file}
+
+    echo $(( txns * BENCH_CLIENTS * rows_per_txn ))
+}
+
+# COPY batches of rows in a single session and write the latency of each
+# COPY to a file. The data is generated up front, so that only the COPY is
+# measured.
+function ingest_copy {
+    local latency_file=$1
+    local batches=$(( BENCH_ROWS / BENCH_BATCH_SIZE ))
+    local data_file=${BENCH_TMP_DIR}/ingest_data.csv
+
+    bench_psql -c "\\copy (SELECT ingest_time(), (random() * 99)::int + 1, (random() * 9)::int, random() * 100 FROM generate_series(1, $(( batches * BENCH_BATCH_SIZE )))) TO '${data_file}' CSV"
+    rm -f ${BENCH_TMP_DIR}/ingest_batch_*
+    split -l ${BENCH_BATCH_SIZE} ${data_file} ${BENCH_TMP_DIR}/ingest_batch_
+
+    (
+        echo "\\timing on"
+        for f in ${BENCH_TMP_DIR}/ingest_batch_*; do
+            echo "\\copy ingest FROM '${f}' CSV"
+        done
+    ) | bench_psql | awk '/^Time:/ { print $2 }' > ${latency_file}
+
+    echo $(( batches * BENCH_BATCH_SIZE ))
+}
+
+bench_reset_db
+
+for method in ${BENCH_METHODS}; do
+    for dimensions in ${BENCH_DIMENSIONS}; do
+        for chunks in ${BENCH_CHUNKS}; do
+            for time_order in ${BENCH_TIME_ORDERS}; do
+                latency_file=${BENCH_TMP_DIR}/latency
+                clients=${BENCH_CLIENTS}
+                batch_size=${BENCH_BATCH_SIZE}
+
+                ingest_setup ${dimensions} ${chunks} ${time_order}
+
+                case ${method} in
+                    single|prepared)
+                        batch_size=1
+                        rows=$(ingest_pgbench ${method} 1 ${latency_file})
+                        ;;
+                    multi)
+                        rows=$(ingest_pgbench ${method} ${BENCH_BATCH_SIZE} ${latency_file})
+                        ;;
+                    copy)
+                        clients=1
+                        rows=$(ingest_copy ${latency_file})
+                        ;;
+                    *)
+                        echo "Unknown ingest method: ${method}" >&2
+                        exit 1
+                        ;;
+                esac
+
+                # Throughput over the time spent in the statements themselves
+                rows_per_sec=$(awk -v rows=${rows} -v clients=${clients} \
+                                   '{ sum += $1 } END { printf "%.1f", sum > 0 ? rows * 1000 * clients / sum : 0 }' \
+                                   ${latency_file})
+                chunks_created=$(bench_psql -A -t -c "SELECT count(*) FROM _timescaledb_catalog.chunk")
+
+                bench_result ${RESULT_FILE} ${RESULT_HEADER} \
+                             "${method},${dimensions},${chunks},${chunks_created},${time_order},${clients},${batch_size},${rows},${rows_per_sec},$(latency_stats ${latency_file})"
+            done
+        done
+    done
+done
@@ -0,0 +1,115 @@
+# Query benchmark, sourced by bench.sh
+#
+# Creates a hypertable with each of the given numbers of chunks and reports,
+# for a set of representative queries, the planning and execution time, the
+# start-up time of the top plan node (which includes the run-time chunk
+# exclusion of ConstraintAwareAppend), the number of chunks left in the plan,
+# the number of relation locks the query takes, and the peak memory of the
+# backend that ran the queries.
+#
+# Each query first runs once to warm up the caches and is then measured
+# BENCH_QUERY_RUNS times, each in its own transaction. The peak memory is
+# read from /proc, so it is only reported when the server runs on the same
+# Linux host as the benchmark.
+#
+# Queries on hypertables with many chunks may need a larger
+# max_locks_per_transaction on the server. A query that fails is reported
+# with the number of errors and no timings.
+
+BENCH_QUERY_CHUNKS=${BENCH_QUERY_CHUNKS:-100 1000 10000 50000}
+BENCH_QUERY_RUNS=${BENCH_QUERY_RUNS:-20}
+BENCH_ROWS_PER_CHUNK=${BENCH_ROWS_PER_CHUNK:-10}
+
+RESULT_FILE=${BENCH_OUTPUT_DIR}/bench_query.csv
+RESULT_HEADER="query,chunks,chunks_created,chunks_in_plan,locks,runs,errors,plan_avg_ms,plan_p50_ms,plan_p95_ms,plan_p99_ms,exec_avg_ms,exec_p50_ms,exec_p95_ms,exec_p99_ms,startup_avg_ms,peak_rss_kb"
+
+# The queries refer to the end of the data, :'end_time', and to the middle
+# of it, :'mid_time'. The "recent" queries subtract an interval from a
+# timestamptz, which is only evaluated at execution time, so chunks are
+# excluded by ConstraintAwareAppend rather than by the planner.
+QUERY_NAMES=(point recent order_limit time_bucket)
+QUERIES=(
+    "SELECT * FROM query WHERE time = :'mid_time' AND device = 1"
+    "SELECT * FROM query WHERE time > :'end_time'::timestamptz - interval '1 day'"
+    "SELECT * FROM query ORDER BY time DESC LIMIT 10"
+    "SELECT time_bucket('1 hour', time) AS bucket, avg(value) FROM query WHERE time > :'end_time'::timestamptz - interval '1 day' GROUP BY bucket ORDER BY bucket"
+)
+
+# Create a hypertable with one-hour chunks. The rows are inserted a batch
+# of chunks per transaction, so that the lock table does not run out.
+function query_setup {
+    local chunks=$1
+    local batch=500
+
+    bench_psql <<SQL >/dev/null
+DROP TABLE IF EXISTS query;
+CREATE TABLE query(time timestamptz NOT NULL, device int NOT NULL, value float8);
+SELECT create_hypertable('query', 'time', chunk_time_interval => interval '1 hour');
+SQL
+
+    for (( start = 0; start < chunks; start += batch )); do
+        local end=$(( start + batch < chunks ? start + batch : chunks ))
+
+        echo "INSERT INTO query SELECT '2018-01-01 00:00:00+00'::timestamptz + i * interval '1 hour' / ${BENCH_ROWS_PER_CHUNK}, i % 10, random() FROM generate_series($(( start * BENCH_ROWS_PER_CHUNK )), $(( end * BENCH_ROWS_PER_CHUNK - 1 ))) i;"
+    done | bench_psql >/dev/null
+}
+
+# Run a query in a session of its own and print one line per measurement
+function query_run {
+    local chunks=$1 query=$2
+
+    (
+        cat <<SQL
+SELECT '2018-01-01 00:00:00+00'::timestamptz + ${chunks} * interval '1 hour' AS end_time,
+       '2018-01-01 00:00:00+00'::timestamptz + $(( chunks / 2 )) * interval '1 hour' AS mid_time,
+       pg_backend_pid() AS pid \gset
+\setenv BENCH_PID :pid
+${query};
+SQL
+        for (( i = 0; i < BENCH_QUERY_RUNS; i++ )); do
+            cat <<SQL
+BEGIN;
+\echo @run
+EXPLAIN (ANALYZE) ${query};
+SELECT 'locks', count(*) FROM pg_locks WHERE pid = pg_backend_pid() AND locktype = 'relation';
+ROLLBACK;
+SQL
+        done
+        echo "\\! grep VmHWM /proc/\$BENCH_PID/status 2>/dev/null || true"
+    ) | ${PSQL} -X -q -A -t -d ${BENCH_DBNAME} 2>&1 | awk '
+        /^@run/ { top = 1; run++ }
+        top && /actual time=/ { sub(/.*actual time=/, ""); sub(/\.\..*/, ""); print "startup", $0; top = 0 }
+        run == 1 && /Scan.* on _hyper_/ { chunks++ }
+        /^Planning time:/ { print "plan", $3 }
+        /^Execution time:/ { print "exec", $3 }
+        /^locks\|/ { split($0, f, "|"); print "locks", f[2] }
+        /^VmHWM:/ { print "rss", $2 }
+        /ERROR/ { print "error", 1; print $0 > "/dev/stderr" }
+        END { print "chunks", chunks + 0 }'
+}
+
+# Print a single value of a measurement, or nothing
+function query_value {
+    awk -v m=$1 '$1 == m { v = $2 } END { printf "%s", v }' $2
+}
+
+bench_reset_db
+
+for chunks in ${BENCH_QUERY_CHUNKS}; do
+    query_setup ${chunks}
+    chunks_created=$(bench_psql -A -t -c "SELECT count(*) FROM _timescaledb_catalog.chunk")
+
+    for (( q = 0; q < ${#QUERIES[@]}; q++ )); do
+        measurements=${BENCH_TMP_DIR}/measurements
+
+        query_run ${chunks} "${QUERIES[$q]}" > ${measurements}
+
+        awk '$1 == "plan" { print $2 }' ${measurements} > ${BENCH_TMP_DIR}/plan
+        awk '$1 == "exec" { print $2 }' ${measurements} > ${BENCH_TMP_DIR}/exec
+        startup_avg=$(awk '$1 == "startup" { sum += $2; n++ } END { if (n > 0) printf "%.3f", sum / n }' ${measurements})
+        errors=$(awk '$1 == "error" { n++ } END { print n + 0 }' ${measurements})
+
+        bench_result ${RESULT_FILE} ${RESULT_HEADER} \
+                     "${QUERY_NAMES[$q]},${chunks},${chunks_created},$(query_value chunks ${measurements}),$(query_value locks ${measurements}),${BENCH_QUERY_RUNS},${errors},$(latency_stats ${BENCH_TMP_DIR}/plan),$(latency_stats ${BENCH_TMP_DIR}/exec),${startup_avg},$(query_value rss ${measurements})"
+    done
+done
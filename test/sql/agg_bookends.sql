@@ -60,3 +60,20 @@ SELECT last(quantity, time) FROM btest_numeric;
 --check non-null element "overrides" NULL because it comes after.
 INSERT INTO btest_numeric VALUES('2020-01-20T09:00:43', 30.5);
 SELECT last(quantity, time) FROM btest_numeric;
+
+--comparison elements of different types, with values that replace each other in order
+SELECT first(t::text, t::bigint), last(t::text, t::bigint) FROM generate_series(1, 1000) t;
+SELECT first(t, t::float8 / 10), last(t, -t) FROM generate_series(1, 1000) t;
+SELECT first(t, '2017-01-01'::date + t % 7), last(t, '2017-01-01'::date + t % 7) FROM generate_series(1, 1000) t;
+SELECT first(t, '2017-01-01'::timestamptz - t * interval '1 hour'), last(t, '2017-01-01'::timestamp + t * interval '1 hour') FROM generate_series(1, 1000) t;
+--NaN is greater than all other values, like with the operators
+SELECT last(t, CASE WHEN t = 500 THEN 'NaN'::float8 ELSE t END) FROM generate_series(1, 1000) t;
+
+--first() and last() on the time column read a single row through the time index
+SELECT last(temp, time), last(gp, time) FROM "btest";
+SELECT first(temp, time) FROM "btest" WHERE gp = 2;
+SELECT last(temp, time) FROM "btest" HAVING last(temp, time) > 100;
+SELECT last(temp, time) FROM "btest" WHERE time < '2017-01-01';
+SET timescaledb.bookend_optimization = off;
+SELECT last(temp, time), last(gp, time) FROM "btest";
+RESET timescaledb.bookend_optimization;
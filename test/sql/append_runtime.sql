@@ -0,0 +1,99 @@
+-- EXPLAIN ANALYZE without timing information, which varies between runs
+CREATE OR REPLACE FUNCTION explain_analyze(query text)
+RETURNS SETOF text LANGUAGE PLPGSQL AS
+$BODY$
+DECLARE
+    line text;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF) ' || query LOOP
+        IF line NOT LIKE '%time:%' THEN
+            RETURN NEXT line;
+        END IF;
+    END LOOP;
+END;
+$BODY$;
+
+CREATE TABLE append_runtime(time bigint NOT NULL, value int);
+SELECT create_hypertable('append_runtime', 'time', chunk_time_interval => 1000);
+INSERT INTO append_runtime SELECT t, t FROM generate_series(0, 2999) t;
+
+CREATE TABLE append_runtime_outer(time bigint);
+INSERT INTO append_runtime_outer VALUES (500), (1500), (2500);
+
+ANALYZE append_runtime;
+ANALYZE append_runtime_outer;
+
+-- The inner side of the nested loop references the outer side through a
+-- parameter, so chunks can only be excluded at run time
+EXPLAIN (costs off)
+SELECT * FROM append_runtime_outer o,
+LATERAL (SELECT * FROM append_runtime a WHERE a.time > o.time ORDER BY a.time LIMIT 1) r;
+
+-- Each rescan only runs the chunks that match the current parameter
+-- value. The chunks are appended in time order, so every rescan stops
+-- in the first remaining chunk and each chunk runs once
+SELECT * FROM explain_analyze($$
+SELECT * FROM append_runtime_outer o,
+LATERAL (SELECT * FROM append_runtime a WHERE a.time > o.time ORDER BY a.time LIMIT 1) r
+$$);
+
+SELECT * FROM append_runtime_outer o,
+LATERAL (SELECT * FROM append_runtime a WHERE a.time > o.time ORDER BY a.time LIMIT 1) r
+ORDER BY o.time;
+
+-- Join clauses on the time dimension of a parameterized inner side
+SET enable_hashjoin = off;
+SET enable_mergejoin = off;
+SELECT * FROM append_runtime_outer o INNER JOIN append_runtime a ON (a.time = o.time + 1)
+ORDER BY o.time;
+RESET enable_hashjoin;
+RESET enable_mergejoin;
+
+-- Bounds on the join keys of the other side of a join exclude chunks at
+-- run time, even if the hypertable is not the parameterized inner side of a
+-- nested loop. Only the chunk that the range falls into is scanned.
+CREATE TABLE append_runtime_range(start bigint, stop bigint);
+INSERT INTO append_runtime_range VALUES (1200, 1202);
+ANALYZE append_runtime_range;
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+SELECT count(*) FROM explain_analyze($$
+SELECT * FROM append_runtime_range r INNER JOIN append_runtime a ON (a.time BETWEEN r.start AND r.stop)
+$$) WHERE explain_analyze LIKE '%never executed%';
+SELECT * FROM append_runtime_range r INNER JOIN append_runtime a ON (a.time BETWEEN r.start AND r.stop)
+ORDER BY a.time;
+RESET enable_indexscan;
+RESET enable_bitmapscan;
+
+-- The result should be the same as without optimizations
+SET timescaledb.disable_optimizations = ON;
+SELECT * FROM append_runtime_outer o,
+LATERAL (SELECT * FROM append_runtime a WHERE a.time > o.time ORDER BY a.time LIMIT 1) r
+ORDER BY o.time;
+RESET timescaledb.disable_optimizations;
+
+-- Restrictions that are all on dimensions exclude chunks by their dimension
+-- ranges alone. Other restrictions are also checked against the chunks'
+-- CHECK constraints, and must not exclude chunks by their dimension ranges.
+CREATE FUNCTION stable_int(v bigint) RETURNS bigint LANGUAGE SQL STABLE AS 'SELECT v';
+CREATE TABLE append_restrict(time bigint NOT NULL, value int CHECK (value >= 0));
+SELECT create_hypertable('append_restrict', 'time', chunk_time_interval => 1000);
+INSERT INTO append_restrict SELECT t, 2999 - t FROM generate_series(0, 2999) t;
+ANALYZE append_restrict;
+
+SELECT trim(line) AS chunks_left FROM explain_analyze($$
+SELECT count(*) FROM append_restrict WHERE time > stable_int(1500)
+$$) line WHERE line LIKE '%Chunks left%';
+SELECT count(*) FROM append_restrict WHERE time > stable_int(1500);
+
+-- The chunks' CHECK constraints refute the restriction on value
+SELECT trim(line) AS chunks_left FROM explain_analyze($$
+SELECT count(*) FROM append_restrict WHERE time > stable_int(500) AND value < stable_int(0)
+$$) line WHERE line LIKE '%Chunks left%';
+SELECT count(*) FROM append_restrict WHERE time > stable_int(500) AND value < stable_int(0);
+
+-- A restriction on a column that is not a dimension excludes no chunks
+SELECT trim(line) AS chunks_left FROM explain_analyze($$
+SELECT count(*) FROM append_restrict WHERE value > stable_int(2500)
+$$) line WHERE line LIKE '%Chunks left%';
+SELECT count(*) FROM append_restrict WHERE value > stable_int(2500);
@@ -0,0 +1,44 @@
+CREATE TABLE pctest(time bigint NOT NULL, device int, value double precision);
+SELECT create_hypertable('pctest', 'time', chunk_time_interval => 100);
+INSERT INTO pctest SELECT t, t % 2, t + 1 FROM generate_series(0, 999) t;
+INSERT INTO pctest SELECT t, 2, t - 1500 FROM generate_series(1000, 1999) t;
+INSERT INTO pctest VALUES (2000, 3, NULL);
+ANALYZE pctest;
+
+-- The estimates are within 1% of the exact percentiles, and the extremes
+-- are exact
+CREATE VIEW pctest_error AS
+SELECT device, percentile,
+       round((abs(approx_percentile(value, percentile) -
+                  percentile_disc(percentile) WITHIN GROUP (ORDER BY value)) /
+              abs(percentile_disc(percentile) WITHIN GROUP (ORDER BY value)))::numeric, 4) AS error
+FROM pctest, (VALUES (0), (0.01), (0.25), (0.5), (0.75), (0.9), (0.99), (1)) p(percentile)
+WHERE device < 3
+GROUP BY device, percentile;
+
+SELECT device, percentile FROM pctest_error WHERE error > 0.01;
+SELECT device, percentile, error FROM pctest_error WHERE percentile IN (0, 1) ORDER BY device, percentile;
+
+-- Combining the sketches of the chunks gives the same estimates
+SET timescaledb.chunk_aggregation = 'on';
+SELECT device, round(approx_percentile(value, 0.5)::numeric, 1) AS median,
+       round(approx_percentile(value, 0.99)::numeric, 1) AS p99
+FROM pctest GROUP BY device ORDER BY device;
+RESET timescaledb.chunk_aggregation;
+
+SELECT device, round(approx_percentile(value, 0.5)::numeric, 1) AS median,
+       round(approx_percentile(value, 0.99)::numeric, 1) AS p99
+FROM pctest GROUP BY device ORDER BY device;
+
+-- NULL values are not counted
+SELECT approx_percentile(value, 1) FROM (VALUES (1.0), (NULL), (3.0)) v(value);
+
+-- invalid arguments
+\set ON_ERROR_STOP 0
+SELECT approx_percentile(value, 1.5) FROM pctest;
+SELECT approx_percentile(value, NULL) FROM pctest;
+SELECT approx_percentile(value, random()) FROM pctest;
+SELECT approx_percentile(value, 0.5) FROM (VALUES (1.0), ('NaN')) v(value);
+\set ON_ERROR_STOP 1
+
+DROP VIEW pctest_error;
@@ -0,0 +1,66 @@
+CREATE TABLE policy_test(time timestamptz, temp float8);
+SELECT create_hypertable('policy_test', 'time', chunk_time_interval => interval '1 day');
+INSERT INTO policy_test VALUES ('2000-01-01 12:00', 1.0), ('2000-01-02 12:00', 2.0);
+
+SELECT add_drop_chunks_policy('policy_test', INTERVAL '1 year');
+SELECT add_create_chunks_ahead_policy('policy_test', 2, INTERVAL '1 hour');
+
+SELECT * FROM _timescaledb_catalog.bgw_job ORDER BY id;
+SELECT * FROM _timescaledb_catalog.bgw_policy_drop_chunks;
+SELECT * FROM _timescaledb_catalog.bgw_policy_create_chunks_ahead;
+
+-- The first run of a job is at least one schedule interval away
+SELECT job_id, next_start > now() AS scheduled, total_runs
+FROM _timescaledb_catalog.bgw_job_stat
+ORDER BY job_id;
+
+\set ON_ERROR_STOP 0
+SELECT add_drop_chunks_policy('policy_test', INTERVAL '1 month');
+SELECT add_drop_chunks_policy('policy_test', INTERVAL '-1 day');
+SELECT add_drop_chunks_policy('policy_test', INTERVAL '1 year', schedule_interval => INTERVAL '0');
+SELECT add_create_chunks_ahead_policy('policy_test', -1);
+SELECT alter_job_schedule(1, max_retries => -2);
+SELECT alter_job_schedule(42);
+\set ON_ERROR_STOP 1
+SELECT add_drop_chunks_policy('policy_test', INTERVAL '1 month', if_not_exists => true);
+
+SELECT alter_job_schedule(1, schedule_interval => INTERVAL '12 hours', max_runtime => INTERVAL '5 min', max_retries => 3);
+SELECT id, schedule_interval, max_runtime, max_retries, retry_period
+FROM _timescaledb_catalog.bgw_job
+ORDER BY id;
+
+-- Run the jobs in this session. The retention policy drops the chunks
+-- from 2000 and the pre-creation policy creates chunks for today and the
+-- next two days.
+SELECT count(*) FROM _timescaledb_catalog.chunk;
+SELECT _timescaledb_internal.bgw_job_run(1);
+SELECT count(*) FROM _timescaledb_catalog.chunk;
+SELECT * FROM policy_test;
+SELECT _timescaledb_internal.bgw_job_run(2);
+SELECT count(*) FROM _timescaledb_catalog.chunk;
+SELECT job_id, last_run_success, total_runs, total_failures, consecutive_failures
+FROM _timescaledb_catalog.bgw_job_stat
+ORDER BY job_id;
+
+SELECT remove_drop_chunks_policy('policy_test');
+\set ON_ERROR_STOP 0
+SELECT remove_drop_chunks_policy('policy_test');
+\set ON_ERROR_STOP 1
+SELECT remove_drop_chunks_policy('policy_test', if_exists => true);
+SELECT id, job_type FROM _timescaledb_catalog.bgw_job;
+SELECT job_id FROM _timescaledb_catalog.bgw_job_stat;
+
+-- Retention policies need a time column of a timestamp or date type
+CREATE TABLE policy_int(time bigint, temp float8);
+SELECT create_hypertable('policy_int', 'time', chunk_time_interval => 10);
+CREATE TABLE policy_plain(time timestamptz, temp float8);
+\set ON_ERROR_STOP 0
+SELECT add_drop_chunks_policy('policy_int', INTERVAL '1 day');
+SELECT add_drop_chunks_policy('policy_plain', INTERVAL '1 day');
+\set ON_ERROR_STOP 1
+
+-- Dropping a hypertable removes its jobs
+DROP TABLE policy_test;
+SELECT count(*) FROM _timescaledb_catalog.bgw_job;
+SELECT count(*) FROM _timescaledb_catalog.bgw_job_stat;
+SELECT count(*) FROM _timescaledb_catalog.bgw_policy_create_chunks_ahead;
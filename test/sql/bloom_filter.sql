@@ -0,0 +1,96 @@
+-- The number of chunks that ConstraintAwareAppend scans after exclusion
+CREATE OR REPLACE FUNCTION chunks_left(query text)
+RETURNS SETOF text LANGUAGE PLPGSQL AS
+$BODY$
+DECLARE
+    line text;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (COSTS OFF) ' || query LOOP
+        IF line LIKE '%Chunks left after exclusion%' THEN
+            RETURN NEXT trim(line);
+        END IF;
+    END LOOP;
+END;
+$BODY$;
+
+CREATE TABLE bloom_test(time bigint NOT NULL, trace_id text, data json);
+SELECT create_hypertable('bloom_test', 'time', chunk_time_interval => 100);
+INSERT INTO bloom_test SELECT t, 'trace-' || t FROM generate_series(0, 399) t;
+
+-- Only existing columns with a hashable type can have filters
+\set ON_ERROR_STOP 0
+SELECT add_bloom_filter('bloom_test', 'missing');
+SELECT add_bloom_filter('bloom_test', 'data');
+\set ON_ERROR_STOP 1
+SELECT add_bloom_filter('bloom_test', 'trace_id');
+\set ON_ERROR_STOP 0
+SELECT add_bloom_filter('bloom_test', 'trace_id');
+\set ON_ERROR_STOP 1
+SELECT add_bloom_filter('bloom_test', 'trace_id', if_not_exists => true);
+SELECT * FROM _timescaledb_catalog.hypertable_bloom_column;
+
+-- Chunks have no filters until they are built
+SELECT chunks_left('SELECT * FROM bloom_test WHERE trace_id = ''trace-150''');
+SELECT build_bloom_filters(format('%I.%I', schema_name, table_name)::regclass)
+FROM _timescaledb_catalog.chunk ORDER BY id;
+SELECT chunk_id, column_name, num_hashes, length(filter)
+FROM _timescaledb_catalog.chunk_bloom_filter ORDER BY chunk_id;
+
+-- Chunks whose filters do not contain the values are excluded
+SELECT chunks_left('SELECT * FROM bloom_test WHERE trace_id = ''trace-150''');
+SELECT * FROM bloom_test WHERE trace_id = 'trace-150';
+SELECT chunks_left('SELECT * FROM bloom_test WHERE trace_id IN (''trace-150'', ''trace-350'')');
+SELECT * FROM bloom_test WHERE trace_id IN ('trace-150', 'trace-350') ORDER BY time;
+SELECT chunks_left('SELECT * FROM bloom_test WHERE trace_id = ''trace-150'' OR time < 10');
+
+-- Prepared statements check the filters as they are when executed
+PREPARE trace_lookup(text) AS SELECT * FROM bloom_test WHERE trace_id = $1;
+EXECUTE trace_lookup('trace-250');
+
+-- Inserting into a chunk deletes its filters
+INSERT INTO bloom_test VALUES (160, 'trace-new');
+SELECT chunk_id, column_name FROM _timescaledb_catalog.chunk_bloom_filter ORDER BY chunk_id;
+SELECT * FROM bloom_test WHERE trace_id = 'trace-new';
+EXECUTE trace_lookup('trace-new');
+
+-- So does updating the column on the hypertable
+UPDATE bloom_test SET trace_id = 'trace-updated' WHERE time = 10;
+SELECT count(*) FROM _timescaledb_catalog.chunk_bloom_filter;
+SELECT * FROM bloom_test WHERE trace_id = 'trace-updated';
+
+-- Reordering a chunk builds its filters
+SELECT reorder_chunk('_timescaledb_internal._hyper_1_1_chunk', 'bloom_test_time_idx');
+SELECT chunk_id, column_name FROM _timescaledb_catalog.chunk_bloom_filter ORDER BY chunk_id;
+SELECT * FROM bloom_test WHERE trace_id = 'trace-updated';
+
+-- Updates through BEFORE UPDATE row triggers delete the filters, since the
+-- triggers can write any column
+CREATE FUNCTION rewrite_trace_id() RETURNS TRIGGER LANGUAGE PLPGSQL AS
+$BODY$
+BEGIN
+    NEW.trace_id := 'trace-triggered';
+    RETURN NEW;
+END;
+$BODY$;
+CREATE TRIGGER rewrite_trace_id BEFORE UPDATE ON bloom_test
+FOR EACH ROW EXECUTE PROCEDURE rewrite_trace_id();
+UPDATE bloom_test SET data = '{}' WHERE time = 20;
+SELECT count(*) FROM _timescaledb_catalog.chunk_bloom_filter;
+SELECT time, trace_id FROM bloom_test WHERE trace_id = 'trace-triggered';
+DROP TRIGGER rewrite_trace_id ON bloom_test;
+SELECT reorder_chunk('_timescaledb_internal._hyper_1_1_chunk', 'bloom_test_time_idx');
+
+-- The filters follow the renamed column
+ALTER TABLE bloom_test RENAME COLUMN trace_id TO request_id;
+SELECT * FROM _timescaledb_catalog.hypertable_bloom_column;
+SELECT chunk_id, column_name FROM _timescaledb_catalog.chunk_bloom_filter ORDER BY chunk_id;
+SELECT * FROM bloom_test WHERE request_id = 'trace-updated';
+
+-- Removing the column's filters deletes them from all chunks
+SELECT remove_bloom_filter('bloom_test', 'request_id');
+SELECT count(*) FROM _timescaledb_catalog.hypertable_bloom_column;
+SELECT count(*) FROM _timescaledb_catalog.chunk_bloom_filter;
+\set ON_ERROR_STOP 0
+SELECT remove_bloom_filter('bloom_test', 'request_id');
+\set ON_ERROR_STOP 1
+SELECT remove_bloom_filter('bloom_test', 'request_id', if_exists => true);
@@ -0,0 +1,43 @@
+CREATE TABLE adapt(time bigint NOT NULL, value int);
+SELECT create_hypertable('adapt', 'time', chunk_time_interval => 1000);
+
+-- Fill the first chunk with far more data than the targets below
+INSERT INTO adapt SELECT i % 1000, i FROM generate_series(0, 9999) i;
+
+-- The interval changes at most by a factor of 10 at a time
+SELECT _timescaledb_internal.calculate_chunk_interval('adapt', 1000, 8192);
+SELECT _timescaledb_internal.calculate_chunk_interval('adapt', 1000, 1024 * 1024 * 1024 * 1024::bigint);
+
+-- There are no chunks before the first chunk, so the interval is kept
+SELECT _timescaledb_internal.calculate_chunk_interval('adapt', 0, 8192);
+
+\set ON_ERROR_STOP 0
+SELECT _timescaledb_internal.calculate_chunk_interval('adapt', 1000, 0);
+SELECT set_adaptive_chunking('adapt', '0');
+CREATE TABLE regular(time bigint);
+SELECT set_adaptive_chunking('regular', '1MB');
+\set ON_ERROR_STOP 1
+
+SELECT set_adaptive_chunking('adapt', 'estimate') > 0;
+SELECT set_adaptive_chunking('adapt', '8kB');
+SELECT * FROM _timescaledb_catalog.chunk_sizing;
+
+-- A new chunk gets the adapted interval, which is kept for later chunks
+INSERT INTO adapt VALUES (1000, 1);
+SELECT s.range_start, s.range_end
+FROM _timescaledb_catalog.dimension_slice s
+INNER JOIN _timescaledb_catalog.dimension d ON (d.id = s.dimension_id)
+WHERE d.hypertable_id = 1
+ORDER BY s.range_start;
+SELECT interval_length FROM _timescaledb_catalog.dimension WHERE hypertable_id = 1;
+
+SELECT set_adaptive_chunking('adapt', 'off');
+SELECT * FROM _timescaledb_catalog.chunk_sizing;
+
+-- Without adaptive chunking, the interval stays as it is
+INSERT INTO adapt VALUES (5000, 1);
+SELECT interval_length FROM _timescaledb_catalog.dimension WHERE hypertable_id = 1;
+
+SELECT set_adaptive_chunking('adapt', '1MB');
+DROP TABLE adapt;
+SELECT * FROM _timescaledb_catalog.chunk_sizing;
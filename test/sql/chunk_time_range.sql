@@ -0,0 +1,78 @@
+-- The number of chunks that ConstraintAwareAppend scans after exclusion
+CREATE OR REPLACE FUNCTION chunks_left(query text)
+RETURNS SETOF text LANGUAGE PLPGSQL AS
+$BODY$
+DECLARE
+    line text;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (COSTS OFF) ' || query LOOP
+        IF line LIKE '%Chunks left after exclusion%' THEN
+            RETURN NEXT trim(line);
+        END IF;
+    END LOOP;
+END;
+$BODY$;
+
+CREATE FUNCTION stable_int(v bigint) RETURNS bigint LANGUAGE SQL STABLE AS 'SELECT v';
+
+CREATE TABLE range_test(time bigint NOT NULL, value int);
+SELECT create_hypertable('range_test', 'time', chunk_time_interval => 100);
+
+-- The range covers the inserted times, with a sixteenth of the interval as
+-- slack, within the chunk's slice
+INSERT INTO range_test VALUES (10, 1), (20, 2), (30, 3), (250, 4);
+SELECT * FROM _timescaledb_catalog.chunk_time_range ORDER BY chunk_id;
+
+-- The first chunk's slice matches, but its rows are too early
+SELECT chunks_left('SELECT * FROM range_test WHERE time > stable_int(50)');
+SELECT * FROM range_test WHERE time > stable_int(50) ORDER BY time;
+SELECT chunks_left('SELECT * FROM range_test WHERE time > stable_int(30)');
+SELECT * FROM range_test WHERE time > stable_int(30) ORDER BY time;
+
+-- Inserts widen the range
+INSERT INTO range_test VALUES (60, 5);
+SELECT * FROM _timescaledb_catalog.chunk_time_range ORDER BY chunk_id;
+SELECT chunks_left('SELECT * FROM range_test WHERE time > stable_int(50)');
+SELECT * FROM range_test WHERE time > stable_int(50) ORDER BY time;
+
+-- Inserting directly into a chunk makes its range unknown
+INSERT INTO _timescaledb_internal._hyper_1_1_chunk VALUES (90, 6);
+SELECT * FROM _timescaledb_catalog.chunk_time_range ORDER BY chunk_id;
+SELECT chunks_left('SELECT * FROM range_test WHERE time > stable_int(70)');
+SELECT * FROM range_test WHERE time > stable_int(70) ORDER BY time;
+
+-- So does updating the time column
+UPDATE range_test SET time = 210 WHERE time = 250;
+SELECT * FROM _timescaledb_catalog.chunk_time_range ORDER BY chunk_id;
+SELECT * FROM range_test WHERE time < stable_int(240) ORDER BY time;
+
+-- Dropping chunks removes their ranges
+SELECT drop_chunks(300, 'range_test');
+SELECT * FROM _timescaledb_catalog.chunk_time_range ORDER BY chunk_id;
+
+-- Updates of chunks with BEFORE UPDATE row triggers widen the ranges to the
+-- chunks' slices, since the triggers can change the time
+CREATE TABLE range_trigger_test(time bigint NOT NULL, value int);
+SELECT create_hypertable('range_trigger_test', 'time', chunk_time_interval => 100);
+INSERT INTO range_trigger_test VALUES (10, 1), (150, 2);
+
+CREATE FUNCTION shift_time() RETURNS TRIGGER LANGUAGE PLPGSQL AS
+$BODY$
+BEGIN
+    NEW.time := NEW.time + 40;
+    RETURN NEW;
+END;
+$BODY$;
+CREATE TRIGGER shift_time BEFORE UPDATE ON range_trigger_test
+FOR EACH ROW EXECUTE PROCEDURE shift_time();
+
+-- Explaining the update leaves the ranges alone
+\o /dev/null
+EXPLAIN (COSTS OFF) UPDATE range_trigger_test SET value = value + 1;
+\o
+SELECT * FROM _timescaledb_catalog.chunk_time_range ORDER BY chunk_id;
+
+UPDATE range_trigger_test SET value = value + 1;
+SELECT * FROM _timescaledb_catalog.chunk_time_range ORDER BY chunk_id;
+SELECT chunks_left('SELECT * FROM range_trigger_test WHERE time > stable_int(40)');
+SELECT * FROM range_trigger_test WHERE time > stable_int(40) ORDER BY time;
@@ -0,0 +1,67 @@
+CREATE TABLE cold_test(time timestamptz NOT NULL, device_id int, temp float8);
+SELECT create_hypertable('cold_test', 'time', chunk_time_interval => interval '1 day');
+
+-- Three chunks
+INSERT INTO cold_test
+SELECT t, 1, 1.0
+FROM generate_series('2000-01-01 00:00+00'::timestamptz, '2000-01-03 23:00+00', '1 hour') t;
+
+CREATE VIEW chunk_index_methods AS
+SELECT c.relname AS chunk, i.relname AS index, am.amname
+FROM pg_index x
+INNER JOIN pg_class c ON (c.oid = x.indrelid)
+INNER JOIN pg_class i ON (i.oid = x.indexrelid)
+INNER JOIN pg_am am ON (am.oid = i.relam)
+WHERE c.relnamespace = '_timescaledb_internal'::regnamespace
+ORDER BY c.relname, i.relname;
+
+SELECT * FROM chunk_index_methods;
+
+-- A cold_index policy rebuilds the chunks' copy of a hypertable index with
+-- another access method, the most recent chunk that does not use it first
+SELECT add_cold_index_policy('cold_test', 'cold_test_time_idx', INTERVAL '1 day');
+SELECT * FROM _timescaledb_catalog.bgw_policy_cold_index;
+
+CREATE TABLE cold_other(time timestamptz NOT NULL, device_id int, temp float8);
+SELECT create_hypertable('cold_other', 'time');
+CREATE UNIQUE INDEX cold_other_time_device_idx ON cold_other(time, device_id);
+CREATE INDEX cold_other_device_temp_idx ON cold_other(device_id, temp);
+CREATE TABLE cold_int(time bigint NOT NULL, temp float8);
+SELECT create_hypertable('cold_int', 'time', chunk_time_interval => 10);
+\set ON_ERROR_STOP 0
+SELECT add_cold_index_policy('cold_test', 'cold_test_time_idx', INTERVAL '1 day');
+SELECT add_cold_index_policy('cold_other', 'cold_test_time_idx', INTERVAL '1 day');
+SELECT add_cold_index_policy('cold_other', 'cold_other_time_device_idx', INTERVAL '1 day');
+SELECT add_cold_index_policy('cold_other', 'cold_other_device_temp_idx', INTERVAL '1 day', 'hash');
+SELECT add_cold_index_policy('cold_other', 'cold_other_time_idx', INTERVAL '1 day', 'nonexistent');
+SELECT add_cold_index_policy('cold_other', 'cold_other_time_idx', INTERVAL '-1 day');
+SELECT add_cold_index_policy('cold_int', 'cold_int_time_idx', INTERVAL '1 day');
+\set ON_ERROR_STOP 1
+
+SELECT _timescaledb_internal.bgw_job_run(1);
+SELECT * FROM chunk_index_methods;
+SELECT _timescaledb_internal.bgw_job_run(1);
+SELECT _timescaledb_internal.bgw_job_run(1);
+SELECT * FROM chunk_index_methods;
+SELECT _timescaledb_internal.bgw_job_run(1);
+SELECT job_id, last_run_success, total_runs, total_failures
+FROM _timescaledb_catalog.bgw_job_stat;
+
+-- The chunk indexes keep their names, so the mapping to the hypertable index
+-- is unchanged
+SELECT chunk_id, index_name, hypertable_index_name
+FROM _timescaledb_catalog.chunk_index
+ORDER BY chunk_id, index_name;
+
+-- New chunks get the hypertable index as is
+INSERT INTO cold_test VALUES ('2000-01-04 00:00+00', 1, 1.0);
+SELECT * FROM chunk_index_methods;
+SELECT count(*) FROM cold_test WHERE time < '2000-01-02 00:00+00';
+SELECT count(*) FROM cold_test WHERE time >= '2000-01-03 12:00+00';
+
+SELECT remove_cold_index_policy('cold_test');
+SELECT count(*) FROM _timescaledb_catalog.bgw_policy_cold_index;
+
+DROP TABLE cold_test;
+DROP TABLE cold_other;
+DROP TABLE cold_int;
@@ -0,0 +1,92 @@
+CREATE TABLE compress_test(time timestamptz NOT NULL, device_id int, temp float8, label text, note text);
+SELECT create_hypertable('compress_test', 'time', chunk_time_interval => interval '1 day');
+
+-- Two chunks, of 1439 and 1061 rows
+INSERT INTO compress_test
+SELECT '2000-01-01 00:00+00'::timestamptz + i * interval '1 minute', i % 3, i * 0.5,
+       CASE WHEN i % 5 = 0 THEN NULL ELSE 'label ' || (i % 2) END, 'row ' || i
+FROM generate_series(1, 2500) i;
+CREATE TABLE compress_expected AS SELECT * FROM compress_test;
+
+CREATE VIEW compress_diff AS
+SELECT count(*) FROM (
+    (SELECT * FROM compress_test EXCEPT ALL SELECT * FROM compress_expected)
+    UNION ALL
+    (SELECT * FROM compress_expected EXCEPT ALL SELECT * FROM compress_test)
+) d;
+
+-- Compress one chunk into batches by device and the other into batches of
+-- at most 1000 rows
+SELECT compress_chunk('_timescaledb_internal._hyper_1_1_chunk', 'device_id');
+SELECT compress_chunk('_timescaledb_internal._hyper_1_2_chunk');
+SELECT * FROM _timescaledb_catalog.compressed_chunk ORDER BY chunk_id;
+SELECT device_id, _ts_meta_count FROM _timescaledb_internal._compressed_chunk_1 ORDER BY device_id;
+SELECT _ts_meta_count FROM _timescaledb_internal._compressed_chunk_2 ORDER BY _ts_meta_count DESC;
+
+-- Each column is compressed with the algorithm for its type and data
+SELECT device_id,
+       _timescaledb_internal.compressed_column_algorithm(time) AS time,
+       _timescaledb_internal.compressed_column_algorithm(temp) AS temp,
+       _timescaledb_internal.compressed_column_algorithm(label) AS label,
+       _timescaledb_internal.compressed_column_algorithm(note) AS note
+FROM _timescaledb_internal._compressed_chunk_1
+ORDER BY device_id;
+SELECT _timescaledb_internal.compressed_column_algorithm(device_id) AS device_id
+FROM _timescaledb_internal._compressed_chunk_2
+LIMIT 1;
+
+-- The chunks are empty, but the hypertable returns the same rows
+SELECT count(*) FROM _timescaledb_internal._hyper_1_1_chunk;
+SELECT count(*) FROM compress_test;
+SELECT * FROM compress_diff;
+SELECT device_id, count(*), sum(temp), count(label)
+FROM compress_test
+GROUP BY device_id
+ORDER BY device_id;
+
+EXPLAIN (costs off) SELECT device_id, temp FROM compress_test;
+EXPLAIN (costs off) SELECT temp FROM compress_test WHERE device_id = 1;
+SELECT count(*), min(temp), max(temp) FROM compress_test WHERE device_id = 1;
+
+-- Rows inserted into a compressed chunk are returned with its compressed rows
+INSERT INTO compress_test VALUES ('2000-01-01 12:00:30+00', 1, 1000.25, 'new', 'inserted');
+SELECT count(*) FROM _timescaledb_internal._hyper_1_1_chunk;
+SELECT count(*) FROM compress_test;
+SELECT device_id, temp, label FROM compress_test WHERE note = 'inserted';
+
+\set ON_ERROR_STOP 0
+UPDATE compress_test SET temp = 0 WHERE device_id = 1;
+DELETE FROM compress_test WHERE note = 'inserted';
+SELECT * FROM compress_test WHERE device_id = 1 FOR UPDATE;
+SELECT compress_chunk(NULL);
+SELECT compress_chunk('compress_expected');
+SELECT compress_chunk('_timescaledb_internal._hyper_1_1_chunk');
+SELECT decompress_chunk('compress_expected');
+\set ON_ERROR_STOP 1
+
+-- Decompressing moves the rows back into the chunk and drops the
+-- compressed table
+SELECT decompress_chunk('_timescaledb_internal._hyper_1_1_chunk');
+SELECT count(*) FROM _timescaledb_internal._hyper_1_1_chunk;
+SELECT count(*) FROM pg_class WHERE relname = '_compressed_chunk_1';
+SELECT chunk_id FROM _timescaledb_catalog.compressed_chunk;
+DELETE FROM compress_test WHERE time = '2000-01-01 12:00:30+00' AND note = 'inserted';
+SELECT decompress_chunk('_timescaledb_internal._hyper_1_2_chunk');
+SELECT * FROM compress_diff;
+
+-- The indexes of the chunks have the decompressed rows
+SET enable_seqscan = off;
+SELECT count(*) FROM compress_test WHERE time >= '2000-01-01 00:00+00';
+RESET enable_seqscan;
+
+\set ON_ERROR_STOP 0
+SELECT decompress_chunk('_timescaledb_internal._hyper_1_2_chunk');
+SELECT compress_chunk('_timescaledb_internal._hyper_1_2_chunk', 'missing');
+\set ON_ERROR_STOP 1
+
+-- Dropping a compressed chunk drops its compressed table
+SELECT compress_chunk('_timescaledb_internal._hyper_1_2_chunk', 'label');
+SELECT count(*) FROM compress_test WHERE label IS NULL;
+DROP TABLE compress_test;
+SELECT count(*) FROM pg_class WHERE relname LIKE '_compressed_chunk_%';
+SELECT chunk_id FROM _timescaledb_catalog.compressed_chunk;
@@ -0,0 +1,83 @@
+CREATE TABLE conditions(time bigint NOT NULL, device int, value int);
+SELECT create_hypertable('conditions', 'time', chunk_time_interval => 10);
+INSERT INTO conditions SELECT t, d, t FROM generate_series(0, 29) t, generate_series(1, 2) d;
+
+CREATE OR REPLACE VIEW locked_chunks AS
+SELECT relation::regclass AS chunk FROM pg_locks
+WHERE locktype = 'relation' AND pid = pg_backend_pid()
+AND relation::regclass::text LIKE '%chunk'
+ORDER BY relation;
+
+-- Restrictions on a time_bucket() exclude chunks. Integer time is
+-- truncated toward zero, so bucket 20 may hold times from 11 to 29.
+BEGIN;
+SELECT count(*) FROM conditions WHERE time_bucket(10, time) = 20;
+SELECT * FROM locked_chunks;
+ROLLBACK;
+
+CREATE VIEW cond_summary AS
+SELECT time_bucket(10, time) AS bucket, device, sum(value) AS total, count(*) AS num
+FROM conditions
+GROUP BY bucket, device;
+
+\set ON_ERROR_STOP 0
+SELECT create_continuous_aggregate('conditions');
+CREATE VIEW not_grouped AS SELECT time, value FROM conditions;
+SELECT create_continuous_aggregate('not_grouped');
+CREATE VIEW no_bucket AS SELECT device, sum(value) FROM conditions GROUP BY device;
+SELECT create_continuous_aggregate('no_bucket');
+CREATE VIEW mutable AS
+SELECT time_bucket(10, time) AS bucket, sum(value) FROM conditions
+WHERE time < extract(epoch FROM now())
+GROUP BY bucket;
+SELECT create_continuous_aggregate('mutable');
+SELECT refresh_continuous_aggregate('no_bucket');
+\set ON_ERROR_STOP 1
+
+SELECT create_continuous_aggregate('cond_summary');
+SELECT mat_hypertable_id, raw_hypertable_id, user_view_name, bucket_width
+FROM _timescaledb_catalog.continuous_agg;
+SELECT * FROM cond_summary ORDER BY bucket, device;
+
+-- Nothing to refresh
+SELECT refresh_continuous_aggregate('cond_summary');
+
+-- Inserts are logged per statement, and only buckets 10 to 30 are refreshed
+INSERT INTO conditions VALUES (35, 1, 100), (12, 2, 1000);
+SELECT hypertable_id, lowest_modified_value, greatest_modified_value
+FROM _timescaledb_catalog.continuous_aggs_invalidation_log;
+SELECT refresh_continuous_aggregate('cond_summary');
+SELECT * FROM cond_summary ORDER BY bucket, device;
+
+-- Updates and deletes are logged by a trigger
+UPDATE conditions SET value = value + 1 WHERE time = 3 AND device = 1;
+SELECT refresh_continuous_aggregate('cond_summary');
+DELETE FROM conditions WHERE time >= 20 AND time < 30;
+SELECT refresh_continuous_aggregate('cond_summary');
+SELECT * FROM cond_summary ORDER BY bucket, device;
+SELECT count(*) FROM _timescaledb_catalog.continuous_aggs_invalidation_log;
+
+-- An update of many rows is logged as a single range
+UPDATE conditions SET value = value + 1 WHERE device = 2 AND time < 15;
+SELECT hypertable_id, lowest_modified_value, greatest_modified_value
+FROM _timescaledb_catalog.continuous_aggs_invalidation_log;
+SELECT refresh_continuous_aggregate('cond_summary');
+
+-- Inserts into a chunk log the chunk's time slice
+INSERT INTO _timescaledb_internal._hyper_1_1_chunk VALUES (5, 1, 1000);
+SELECT hypertable_id, lowest_modified_value, greatest_modified_value
+FROM _timescaledb_catalog.continuous_aggs_invalidation_log;
+SELECT refresh_continuous_aggregate('cond_summary');
+SELECT * FROM cond_summary ORDER BY bucket, device;
+
+-- Truncating the hypertable invalidates all buckets
+TRUNCATE conditions;
+SELECT hypertable_id, lowest_modified_value, greatest_modified_value
+FROM _timescaledb_catalog.continuous_aggs_invalidation_log;
+SELECT refresh_continuous_aggregate('cond_summary');
+SELECT * FROM cond_summary ORDER BY bucket, device;
+
+SELECT drop_continuous_aggregate('cond_summary');
+SELECT count(*) FROM _timescaledb_catalog.continuous_agg;
+SELECT count(*) FROM _timescaledb_catalog.hypertable;
+SELECT tgname FROM pg_trigger WHERE tgrelid = 'conditions'::regclass;
@@ -116,3 +116,31 @@ SELECT set_chunk_time_interval('chunk_test', NULL::BIGINT);
 SELECT set_chunk_time_interval('chunk_test2', NULL::BIGINT);
 SELECT set_chunk_time_interval('chunk_test2', NULL::INTERVAL);
 \set ON_ERROR_STOP 1
+
+-- Pre-create chunks ahead of time
+CREATE TABLE chunk_ahead(time BIGINT NOT NULL, device INTEGER, value FLOAT);
+SELECT * FROM create_hypertable('chunk_ahead', 'time', 'device', 2, chunk_time_interval => 10);
+INSERT INTO chunk_ahead VALUES (5, 1, 1.0);
+SELECT create_chunks_ahead('chunk_ahead', 2, 5);
+-- nothing new to create
+SELECT create_chunks_ahead('chunk_ahead', 2, 5);
+SELECT ds.range_start, ds.range_end, count(*) AS num_chunks
+FROM _timescaledb_catalog.chunk c
+INNER JOIN _timescaledb_catalog.hypertable h ON (c.hypertable_id = h.id)
+INNER JOIN _timescaledb_catalog.chunk_constraint cc ON (cc.chunk_id = c.id)
+INNER JOIN _timescaledb_catalog.dimension_slice ds ON (ds.id = cc.dimension_slice_id)
+INNER JOIN _timescaledb_catalog.dimension d ON (d.id = ds.dimension_id)
+WHERE h.table_name = 'chunk_ahead' AND d.column_name = 'time'
+GROUP BY ds.range_start, ds.range_end
+ORDER BY ds.range_start;
+-- inserts into the pre-created time range find the existing chunks
+INSERT INTO chunk_ahead VALUES (15, 1, 2.0), (25, 2, 3.0);
+SELECT count(*) FROM _timescaledb_catalog.chunk c
+INNER JOIN _timescaledb_catalog.hypertable h ON (c.hypertable_id = h.id)
+WHERE h.table_name = 'chunk_ahead';
+
+\set ON_ERROR_STOP 0
+-- integer time columns need an explicit start time
+SELECT create_chunks_ahead('chunk_ahead', 2);
+SELECT create_chunks_ahead('chunk_ahead', -1, 5);
+\set ON_ERROR_STOP 1
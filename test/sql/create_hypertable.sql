@@ -177,6 +177,48 @@ select * from only _timescaledb_internal._hyper_6_5_chunk;
 create table test_schema.test_migrate_empty(time timestamp, temp float);
 select create_hypertable('test_schema.test_migrate_empty', 'time', migrate_data => true);
 
+--deferred data migration in batches
+create table test_schema.test_migrate_batches(time timestamp, temp float);
+insert into test_schema.test_migrate_batches VALUES ('2004-12-19 10:23:54', 2.0), ('2004-10-19 10:23:54', 1.0), ('2004-10-20 10:23:54', 3.0);
+select create_hypertable('test_schema.test_migrate_batches', 'time', defer_migration => true);
+--data is still in the main table, but visible through the hypertable
+select count(*) from only test_schema.test_migrate_batches;
+select * from test_schema.test_migrate_batches order by time;
+--oldest rows are moved first
+select move_data_to_chunks('test_schema.test_migrate_batches', 2);
+select * from only test_schema.test_migrate_batches;
+select move_data_to_chunks('test_schema.test_migrate_batches', 2);
+select move_data_to_chunks('test_schema.test_migrate_batches', 2);
+select count(*) from only test_schema.test_migrate_batches;
+--the emptied main table is truncated, so that queries leave it out again
+select pg_relation_size('test_schema.test_migrate_batches');
+select * from test_schema.test_migrate_batches order by time;
+
+--queries must include the rows of a migration that is not finished yet
+create table test_schema.test_migrate_paths(time timestamp not null, device int, temp float);
+create index on test_schema.test_migrate_paths(device, time desc);
+insert into test_schema.test_migrate_paths VALUES
+('2004-10-19 10:00', 1, 1.0),
+('2004-10-20 10:00', 2, 2.0),
+('2004-12-19 10:00', 1, 3.0),
+('2004-12-20 10:00', 3, 4.0);
+\set ON_ERROR_STOP 0
+select create_hypertable('test_schema.test_migrate_paths', 'time', migrate_data => true, defer_migration => true);
+\set ON_ERROR_STOP 1
+select create_hypertable('test_schema.test_migrate_paths', 'time', chunk_time_interval => interval '1 day', defer_migration => true);
+select move_data_to_chunks('test_schema.test_migrate_paths', 2);
+--the two latest rows are still in the main table
+select * from only test_schema.test_migrate_paths order by time;
+select * from test_schema.test_migrate_paths where time > now() - interval '100 years' order by time;
+select * from test_schema.test_migrate_paths order by time desc limit 1;
+select time, temp from test_schema.test_migrate_paths order by time desc limit 3;
+select last(temp, time) from test_schema.test_migrate_paths;
+set timescaledb.chunk_aggregation = on;
+select count(*), sum(temp) from test_schema.test_migrate_paths;
+select device, count(*) from test_schema.test_migrate_paths group by device order by device;
+reset timescaledb.chunk_aggregation;
+select distinct on (device) device, time, temp from test_schema.test_migrate_paths order by device, time desc;
+
 -- Reset GRANTS
 \c single :ROLE_SUPERUSER
 REVOKE :ROLE_DEFAULT_PERM_USER FROM :ROLE_DEFAULT_PERM_USER_2;
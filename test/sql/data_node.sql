@@ -0,0 +1,107 @@
+\set ON_ERROR_STOP 0
+
+\c single :ROLE_SUPERUSER
+-- Data nodes need to use a wrapper named postgres_fdw. Attaching them does
+-- not need its handler.
+CREATE FOREIGN DATA WRAPPER postgres_fdw;
+CREATE FOREIGN DATA WRAPPER other_fdw;
+CREATE SERVER data_node_1 FOREIGN DATA WRAPPER postgres_fdw;
+CREATE SERVER data_node_2 FOREIGN DATA WRAPPER postgres_fdw;
+CREATE SERVER other_server FOREIGN DATA WRAPPER other_fdw;
+GRANT USAGE ON FOREIGN SERVER data_node_1 TO :ROLE_DEFAULT_PERM_USER;
+\c single :ROLE_DEFAULT_PERM_USER
+
+CREATE TABLE disttable(time timestamptz, device int, temp float);
+SELECT create_hypertable('disttable', 'time', 'device', 2);
+
+--check some error conditions
+SELECT attach_data_node(NULL, 'disttable');
+SELECT attach_data_node('data_node_1', NULL);
+SELECT attach_data_node('none_existing_node', 'disttable');
+SELECT attach_data_node('other_server', 'disttable');
+SELECT attach_data_node('data_node_1', 'none_existing_table');
+
+--the table owner needs usage on the server
+SELECT attach_data_node('data_node_2', 'disttable');
+
+SELECT attach_data_node('data_node_1', 'disttable');
+--attaching the same node twice should generate an error
+SELECT attach_data_node('data_node_1', 'disttable');
+--no error if if_not_attached is given
+SELECT attach_data_node('data_node_1', 'disttable', if_not_attached => true);
+
+\c single :ROLE_SUPERUSER
+GRANT USAGE ON FOREIGN SERVER data_node_2 TO :ROLE_DEFAULT_PERM_USER;
+\c single :ROLE_DEFAULT_PERM_USER
+SELECT attach_data_node('data_node_2', 'disttable');
+SELECT * FROM show_data_nodes('disttable');
+SELECT * FROM _timescaledb_catalog.hypertable_data_node;
+
+--chunks are created as foreign tables, so inserting needs the wrapper's
+--handler
+INSERT INTO disttable VALUES ('2018-01-01 00:00:00+00', 1, 1.0);
+SELECT count(*) FROM _timescaledb_catalog.chunk;
+
+SELECT detach_data_node('data_node_1', 'disttable');
+SELECT detach_data_node('data_node_1', 'disttable');
+SELECT detach_data_node('data_node_1', 'disttable', if_attached => true);
+SELECT * FROM show_data_nodes('disttable');
+
+--dropping the hypertable removes its data nodes
+DROP TABLE disttable;
+SELECT * FROM _timescaledb_catalog.hypertable_data_node;
+
+\c single :ROLE_SUPERUSER
+DROP SERVER data_node_1, data_node_2, other_server;
+DROP FOREIGN DATA WRAPPER postgres_fdw;
+DROP FOREIGN DATA WRAPPER other_fdw;
+
+--a loopback data node in the second test database
+\c single_2 :ROLE_SUPERUSER
+CREATE TABLE disttable(time timestamptz NOT NULL, device int, temp float);
+\c single :ROLE_SUPERUSER
+CREATE EXTENSION postgres_fdw;
+SELECT current_setting('port') AS "PORT" \gset
+CREATE SERVER loopback FOREIGN DATA WRAPPER postgres_fdw
+OPTIONS (dbname 'single_2', port :'PORT');
+CREATE USER MAPPING FOR :ROLE_SUPERUSER SERVER loopback;
+
+CREATE TABLE disttable(time timestamptz NOT NULL, device int, temp float);
+SELECT create_hypertable('disttable', 'time', chunk_time_interval => interval '1 day');
+SELECT attach_data_node('loopback', 'disttable');
+INSERT INTO disttable VALUES ('2018-01-01 00:00:00-08', 1, 1.0), ('2018-01-02 00:00:00-08', 2, 2.0),
+('2018-01-03 00:00:00-08', 3, 3.0), ('2018-01-04 00:00:00-08', 4, 4.0);
+SELECT * FROM disttable ORDER BY time;
+
+--a chunk only returns its own rows of the data node's table
+SELECT format('%I.%I', schema_name, table_name) AS "CHUNK"
+FROM _timescaledb_catalog.chunk ORDER BY id LIMIT 1 \gset
+SELECT * FROM :CHUNK;
+
+--dropping chunks on data nodes deletes their rows from the data node, so
+--they do not show up again in a new chunk for the same range
+SELECT drop_chunks('2018-01-02 00:00:00-08'::timestamptz, 'disttable');
+SELECT format('%I.%I', schema_name, table_name) AS "CHUNK"
+FROM _timescaledb_catalog.chunk ORDER BY id LIMIT 1 \gset
+DROP FOREIGN TABLE :CHUNK;
+SELECT count(*) FROM _timescaledb_catalog.chunk;
+\c single_2 :ROLE_SUPERUSER
+SELECT * FROM disttable ORDER BY time;
+\c single :ROLE_SUPERUSER
+INSERT INTO disttable VALUES ('2018-01-01 12:00:00-08', 5, 5.0);
+SELECT * FROM disttable ORDER BY time;
+
+--deleting through the hypertable removes the rows on the data node
+DELETE FROM disttable WHERE time < '2018-01-03 00:00:00-08';
+\c single_2 :ROLE_SUPERUSER
+SELECT * FROM disttable ORDER BY time;
+\c single :ROLE_SUPERUSER
+
+--so does dropping the hypertable
+DROP TABLE disttable;
+\c single_2 :ROLE_SUPERUSER
+SELECT count(*) FROM disttable;
+\c single :ROLE_SUPERUSER
+DROP USER MAPPING FOR :ROLE_SUPERUSER SERVER loopback;
+DROP SERVER loopback;
+DROP EXTENSION postgres_fdw;
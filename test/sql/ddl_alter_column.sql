@@ -49,3 +49,24 @@ ALTER TABLE alter_test ALTER COLUMN time_us TYPE timestamptz USING time_us::time
 ALTER TABLE ONLY alter_test RENAME COLUMN colorname TO colorname2;
 ALTER TABLE ONLY alter_test ALTER COLUMN colorname TYPE varchar(10);
 \set ON_ERROR_STOP 1
+
+-- changing the type of an integer dimension keeps the chunk
+-- constraints that PostgreSQL re-adds for the new type
+CREATE TABLE alter_int_test(time int NOT NULL, temp float);
+SELECT create_hypertable('alter_int_test', 'time', chunk_time_interval => 10);
+INSERT INTO alter_int_test VALUES (1, 1.0), (11, 2.0);
+ALTER TABLE alter_int_test ALTER COLUMN time TYPE bigint;
+
+SELECT d.column_type
+FROM _timescaledb_catalog.dimension d
+INNER JOIN _timescaledb_catalog.hypertable h ON (d.hypertable_id = h.id)
+WHERE h.table_name = 'alter_int_test';
+
+SELECT count(*) FROM pg_constraint
+WHERE contype = 'c' AND conrelid IN
+      (SELECT format('%I.%I', c.schema_name, c.table_name)::regclass
+       FROM _timescaledb_catalog.chunk c
+       INNER JOIN _timescaledb_catalog.hypertable h ON (c.hypertable_id = h.id)
+       WHERE h.table_name = 'alter_int_test');
+
+SELECT * FROM alter_int_test WHERE time > 5;
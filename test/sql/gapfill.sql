@@ -0,0 +1,49 @@
+\set ON_ERROR_STOP 0
+-- The custom plan provider of the top plan node of a query
+CREATE OR REPLACE FUNCTION top_custom_plan(query text)
+RETURNS text LANGUAGE PLPGSQL AS
+$BODY$
+DECLARE
+    plan json;
+BEGIN
+    EXECUTE 'EXPLAIN (FORMAT JSON) ' || query INTO plan;
+    RETURN plan->0->'Plan'->>'Custom Plan Provider';
+END;
+$BODY$;
+
+CREATE TABLE gapfill_test(time int NOT NULL, device int, value float);
+SELECT create_hypertable('gapfill_test', 'time', chunk_time_interval => 50);
+INSERT INTO gapfill_test VALUES (0, 1, 1.0), (5, 1, 2.0), (30, 1, 4.0), (10, 2, 10.0), (40, 2, 20.0);
+
+SELECT top_custom_plan('SELECT time_bucket_gapfill(10, time, 0, 50), device, avg(value)
+                        FROM gapfill_test GROUP BY 1, 2 ORDER BY 2, 1');
+
+-- Every device gets all buckets between start and finish, and locf() and
+-- interpolate() fill in the values of the missing buckets
+SELECT time_bucket_gapfill(10, time, 0, 50) AS t, device, avg(value),
+       locf(avg(value)), interpolate(avg(value))
+FROM gapfill_test GROUP BY 1, 2 ORDER BY 2, 1;
+
+-- Without grouping columns, and without any input
+SELECT time_bucket_gapfill(10, time, 0, 60), count(*)
+FROM gapfill_test WHERE device = 1 GROUP BY 1 ORDER BY 1;
+SELECT time_bucket_gapfill(10, time, 0, 30), count(*)
+FROM gapfill_test WHERE device = 3 GROUP BY 1 ORDER BY 1;
+
+-- Buckets outside of the range are returned as is, and the start is
+-- bucketed
+SELECT time_bucket_gapfill(10, time, 15, 30) AS t, device, sum(value)
+FROM gapfill_test GROUP BY 1, 2 ORDER BY 2, 1;
+
+-- Dates
+SELECT to_char(d, 'YYYY-MM-DD'), s FROM (
+    SELECT time_bucket_gapfill('1 day', d, '2018-01-01', '2018-01-04') AS d, sum(x) AS s
+    FROM (VALUES ('2018-01-02'::date, 1)) v(d, x) GROUP BY 1
+) q ORDER BY 1;
+
+-- Errors
+SELECT time_bucket_gapfill(10, time, 0, 50), time_bucket_gapfill(20, time, 0, 50), count(*)
+FROM gapfill_test GROUP BY 1, 2;
+SELECT time_bucket_gapfill(10, time, device, 50), count(*) FROM gapfill_test GROUP BY 1;
+SELECT time_bucket_gapfill(10, time, NULL, 50), count(*) FROM gapfill_test GROUP BY 1;
+SELECT time_bucket_gapfill(0, time, 0, 50), count(*) FROM gapfill_test GROUP BY 1;
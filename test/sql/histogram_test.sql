@@ -41,4 +41,14 @@ SELECT histogram(key, 1, 3, 1) FROM hitest1;
 -- standard 2 bucket
 SELECT qualify, histogram(score, 0, 10, 2) FROM hitest2 GROUP BY qualify;
 -- standard multi-bucket
-SELECT qualify, histogram(score, 0, 10, 5) FROM hitest2 GROUP BY qualify
+SELECT qualify, histogram(score, 0, 10, 5) FROM hitest2 GROUP BY qualify;
+
+-- NULL values are not counted
+SELECT histogram(key, 0, 9, 2) FROM (SELECT key FROM hitest1 UNION ALL SELECT NULL) t;
+
+-- invalid ranges
+\set ON_ERROR_STOP 0
+SELECT histogram(key, 5, 5, 2) FROM hitest1;
+SELECT histogram(key, 9, 0, 2) FROM hitest1;
+SELECT histogram(key, 0, 9, 0) FROM hitest1;
+\set ON_ERROR_STOP 1
@@ -0,0 +1,42 @@
+\c single :ROLE_SUPERUSER
+CREATE TABLE stats_test(time timestamptz NOT NULL, device int, temp float);
+SELECT create_hypertable('stats_test', 'time', chunk_time_interval => interval '1 day');
+
+-- Start from clean statistics, since they survive the test database
+SELECT _timescaledb_internal.hypertable_stats_reset();
+
+-- Create two chunks with an INSERT and another with COPY
+INSERT INTO stats_test VALUES ('2018-01-01 01:00', 1, 1.0),
+                              ('2018-01-01 02:00', 2, 2.0),
+                              ('2018-01-02 01:00', 1, 3.0);
+COPY stats_test FROM STDIN DELIMITER ',';
+2018-01-02 02:00,1,4.0
+2018-01-03 02:00,2,5.0
+\.
+
+-- Chunks created after a column is dropped have a different rowtype than
+-- the hypertable, so tuples inserted into them are converted
+ALTER TABLE stats_test DROP COLUMN device;
+INSERT INTO stats_test VALUES ('2018-01-04 01:00', 6.0);
+
+SELECT hypertable_schema, hypertable_name, rows_inserted, rows_copied, chunks_created,
+       chunk_create_time > 0 AS has_create_time, chunk_find_scans > 0 AS has_find_scans,
+       cache_evictions, tuples_converted
+FROM timescaledb_information.hypertable_stats;
+
+-- Each backend times the metadata operations it runs
+SELECT operation, relation, calls > 0 AS called, total_time >= max_time AS consistent
+FROM _timescaledb_internal.timing_stats()
+WHERE operation <> 'CatalogScan' OR relation = '_timescaledb_catalog.dimension_slice'::regclass
+ORDER BY operation;
+SELECT _timescaledb_internal.backend_wait_event(pg_backend_pid());
+
+SELECT _timescaledb_internal.hypertable_stats_reset();
+SELECT count(*) FROM timescaledb_information.hypertable_stats;
+
+-- Only privileged users can reset the statistics
+\c single :ROLE_DEFAULT_PERM_USER
+\set ON_ERROR_STOP 0
+SELECT _timescaledb_internal.hypertable_stats_reset();
+\set ON_ERROR_STOP 1
+SELECT count(*) FROM timescaledb_information.hypertable_stats;
@@ -66,11 +66,11 @@ RESET client_min_messages;
 
 
 
---non-aggregates use MergeAppend in both optimized and non-optimized
+--non-aggregates use MergeAppend in non-optimized and an ordered Append in optimized
 EXPLAIN (costs off) SELECT * FROM hyper_1 ORDER BY "time" DESC limit 2;
 SELECT * FROM hyper_1 ORDER BY "time" DESC limit 2;
 
---aggregates use MergeAppend only in optimized
+--aggregates use an ordered Append only in optimized
 EXPLAIN (costs off) SELECT date_trunc('minute', time) t, avg(series_0), min(series_1), avg(series_2) FROM hyper_1 GROUP BY t ORDER BY t DESC limit 2;
 
 EXPLAIN (costs off) SELECT date_trunc('minute', time) t, avg(series_0), min(series_1), avg(series_2)
@@ -149,6 +149,27 @@ FROM hyper_1_tz GROUP BY t ORDER BY t DESC limit 2;
 SELECT time_bucket('1 minute', time::timestamp) t, avg(series_0), min(series_1), avg(series_2)
 FROM hyper_1_tz GROUP BY t ORDER BY t DESC limit 2;
 
+EXPLAIN (costs off) SELECT time_bucket('1 minute', time AT TIME ZONE 'UTC') t, avg(series_0), min(series_1), avg(series_2)
+FROM hyper_1_tz GROUP BY t ORDER BY t DESC limit 2;
+SELECT time_bucket('1 minute', time AT TIME ZONE 'UTC') t, avg(series_0), min(series_1), avg(series_2)
+FROM hyper_1_tz GROUP BY t ORDER BY t DESC limit 2;
+
+--zones with daylight saving time are not order preserving and should not be optimized
+EXPLAIN (costs off) SELECT time_bucket('1 minute', time AT TIME ZONE 'PST8PDT') t, avg(series_0), min(series_1), avg(series_2)
+FROM hyper_1_tz GROUP BY t ORDER BY t DESC limit 2;
+SELECT time_bucket('1 minute', time AT TIME ZONE 'PST8PDT') t, avg(series_0), min(series_1), avg(series_2)
+FROM hyper_1_tz GROUP BY t ORDER BY t DESC limit 2;
+
+EXPLAIN (costs off) SELECT time::date t, avg(series_0), min(series_1), avg(series_2)
+FROM hyper_1 GROUP BY t ORDER BY t DESC limit 2;
+SELECT time::date t, trunc(avg(series_0)::numeric, 8) as avg_trunc1, min(series_1), trunc(avg(series_2)::numeric, 8) as avg_trunc2
+FROM hyper_1 GROUP BY t ORDER BY t DESC limit 2;
+
+EXPLAIN (costs off) SELECT time_bucket('1 day', time, INTERVAL '12 hours') t, avg(series_0), min(series_1), avg(series_2)
+FROM hyper_1_date GROUP BY t ORDER BY t DESC limit 2;
+SELECT time_bucket('1 day', time, INTERVAL '12 hours') t, trunc(avg(series_0)::numeric, 8) as avg_trunc1, min(series_1), trunc(avg(series_2)::numeric, 8) as avg_trunc2
+FROM hyper_1_date GROUP BY t ORDER BY t DESC limit 2;
+
 EXPLAIN (costs off) SELECT time_bucket(10, time) t, avg(series_0), min(series_1), avg(series_2)
 FROM hyper_1_int GROUP BY t ORDER BY t DESC limit 2;
 SELECT time_bucket(10, time) t, avg(series_0), min(series_1), avg(series_2)
@@ -0,0 +1,47 @@
+-- The estimated rows of the top plan node of a query
+CREATE OR REPLACE FUNCTION estimated_rows(query text)
+RETURNS bigint LANGUAGE PLPGSQL AS
+$BODY$
+DECLARE
+    plan json;
+BEGIN
+    EXECUTE 'EXPLAIN (FORMAT JSON) ' || query INTO plan;
+    RETURN (plan->0->'Plan'->>'Plan Rows')::bigint;
+END;
+$BODY$;
+
+CREATE TABLE analyze_test(time int NOT NULL, device int, value float) WITH (autovacuum_enabled = false);
+SELECT create_hypertable('analyze_test', 'time', chunk_time_interval => 20);
+
+-- Two chunks with a device each of their own and one shared device. Every
+-- fourth value is NULL.
+INSERT INTO analyze_test
+SELECT t, 1 + (t % 2), CASE WHEN t % 4 = 0 THEN NULL ELSE t END FROM generate_series(0, 19) t;
+INSERT INTO analyze_test
+SELECT t, 2 + (t % 2), CASE WHEN t % 4 = 0 THEN NULL ELSE t END FROM generate_series(20, 39) t;
+
+-- ANALYZE only analyzes the chunks, so the hypertable has no statistics
+ANALYZE analyze_test;
+SELECT attname, inherited, null_frac, n_distinct FROM pg_stats
+WHERE tablename = 'analyze_test' ORDER BY attname;
+
+-- With incremental ANALYZE, the chunk statistics are merged into the
+-- hypertable's statistics
+SET timescaledb.incremental_analyze = 'on';
+ANALYZE analyze_test;
+SELECT attname, inherited, null_frac, avg_width, n_distinct, most_common_vals,
+       most_common_freqs, array_length(histogram_bounds, 1) AS num_bounds
+FROM pg_stats WHERE tablename = 'analyze_test' ORDER BY attname;
+SELECT attname, histogram_bounds FROM pg_stats
+WHERE tablename = 'analyze_test' AND attname IN ('time', 'value') ORDER BY attname;
+
+-- A new chunk is analyzed and merged with the statistics of the others
+INSERT INTO analyze_test SELECT t, 4, t FROM generate_series(40, 59) t;
+ANALYZE analyze_test;
+SELECT attname, inherited, null_frac, avg_width, n_distinct, most_common_vals,
+       most_common_freqs, array_length(histogram_bounds, 1) AS num_bounds
+FROM pg_stats WHERE tablename = 'analyze_test' ORDER BY attname;
+
+-- The planner uses the merged statistics for the number of groups
+SELECT estimated_rows('SELECT device FROM analyze_test GROUP BY device');
+RESET timescaledb.incremental_analyze;
@@ -187,3 +187,45 @@ INSERT INTO index_expr_test VALUES ('2017-01-20T09:00:01', 17.5, '{"field": "val
 EXPLAIN (verbose, costs off)
 SELECT * FROM index_expr_test WHERE meta ->> 'field' = 'value1';
 SELECT * FROM index_expr_test WHERE meta ->> 'field' = 'value1';
+
+-- Create an index with a transaction per chunk
+CREATE TABLE index_tpc_test(time timestamptz, device integer, temp float);
+SELECT create_hypertable('index_tpc_test', 'time', chunk_time_interval => interval '1 day');
+INSERT INTO index_tpc_test VALUES ('2017-01-20T09:00:01', 1, 17.5), ('2017-01-21T09:00:01', 2, 18.5);
+CREATE TABLE index_tpc_plain(time timestamptz);
+
+\set ON_ERROR_STOP 0
+-- Cannot run in a transaction block
+BEGIN;
+CREATE INDEX index_tpc_test_device_idx ON index_tpc_test (device) WITH (timescaledb.transaction_per_chunk);
+ROLLBACK;
+-- Only supported on hypertables
+CREATE INDEX ON index_tpc_plain (time) WITH (timescaledb.transaction_per_chunk);
+\set ON_ERROR_STOP 1
+
+CREATE INDEX CONCURRENTLY index_tpc_test_device_idx ON index_tpc_test (device)
+WITH (timescaledb.transaction_per_chunk);
+
+SELECT count(*), bool_and(i.indisvalid) AS valid
+FROM pg_index i INNER JOIN pg_class c ON (c.oid = i.indexrelid)
+WHERE c.relname LIKE '%index_tpc_test_device_idx';
+SELECT count(*) FROM _timescaledb_catalog.chunk_index
+WHERE hypertable_index_name = 'index_tpc_test_device_idx';
+
+-- Resume after the index is missing on a chunk
+DO $$
+BEGIN
+    EXECUTE (SELECT format('DROP INDEX _timescaledb_internal.%I', index_name)
+             FROM _timescaledb_catalog.chunk_index
+             WHERE hypertable_index_name = 'index_tpc_test_device_idx'
+             ORDER BY chunk_id LIMIT 1);
+END
+$$;
+SELECT count(*) FROM _timescaledb_catalog.chunk_index
+WHERE hypertable_index_name = 'index_tpc_test_device_idx';
+
+CREATE INDEX IF NOT EXISTS index_tpc_test_device_idx ON index_tpc_test (device)
+WITH (timescaledb.transaction_per_chunk);
+
+SELECT count(*) FROM _timescaledb_catalog.chunk_index
+WHERE hypertable_index_name = 'index_tpc_test_device_idx';
@@ -90,3 +90,95 @@ WITH insert_cte as (
 		('2001-01-01 01:03:01', 1.0, 'device')
 	)
 SELECT 1 \g | grep -v "Planning" | grep -v "Execution"
+
+-- Batched routing of tuples to chunks, using a small batch size so
+-- that batches end both when full and when a new chunk is needed
+CREATE TABLE batch_test(time timestamp NOT NULL, temp float8, device int NOT NULL);
+SELECT create_hypertable('batch_test', 'time', 'device', 2, chunk_time_interval => interval '1 day');
+SET timescaledb.insert_batch_size = 3;
+INSERT INTO batch_test VALUES
+('2017-01-01 01:00', 1.0, 1),
+('2017-01-02 01:00', 2.0, 2),
+('2017-01-01 02:00', 3.0, 1),
+('2017-01-03 01:00', 4.0, 3),
+('2017-01-01 03:00', 5.0, 2),
+('2017-01-02 02:00', 6.0, 1),
+('2017-01-01 04:00', 7.0, 1);
+RESET timescaledb.insert_batch_size;
+SELECT * FROM batch_test ORDER BY time, device;
+
+-- Chunks created by background workers while the tuples for them are
+-- buffered. Chunks that the workers did not create in time are created
+-- by the insert itself, so the result is the same either way.
+CREATE TABLE async_test(time timestamp NOT NULL, temp float8);
+SELECT create_hypertable('async_test', 'time', chunk_time_interval => interval '1 day');
+SET timescaledb.async_chunk_create_timeout = '10s';
+INSERT INTO async_test VALUES
+('2017-01-01 01:00', 1.0),
+('2017-01-02 01:00', 2.0),
+('2017-01-01 02:00', 3.0),
+('2017-01-03 01:00', 4.0),
+('2017-01-02 02:00', 5.0);
+RESET timescaledb.async_chunk_create_timeout;
+SELECT * FROM async_test ORDER BY time;
+SELECT count(*) AS num_chunks
+FROM _timescaledb_catalog.chunk c
+INNER JOIN _timescaledb_catalog.hypertable h ON (c.hypertable_id = h.id)
+WHERE h.table_name = 'async_test';
+
+-- Chunks created by the insert are loaded without indexes that are
+-- built afterwards. Only one open chunk at a time, so that a chunk is
+-- evicted (and its indexes built) before it is reopened.
+CREATE TABLE defer_index_test(time timestamp NOT NULL, temp float8);
+SELECT create_hypertable('defer_index_test', 'time', chunk_time_interval => interval '1 day');
+CREATE INDEX ON defer_index_test(temp);
+SET timescaledb.defer_chunk_index_build = true;
+SET timescaledb.max_open_chunks_per_insert = 1;
+INSERT INTO defer_index_test VALUES
+('2017-01-01 01:00', 1.0),
+('2017-01-02 01:00', 2.0),
+('2017-01-01 02:00', 3.0),
+('2017-01-03 01:00', 4.0);
+RESET timescaledb.max_open_chunks_per_insert;
+RESET timescaledb.defer_chunk_index_build;
+SELECT count(*) AS num_chunk_indexes
+FROM pg_index i
+INNER JOIN pg_inherits inh ON (i.indrelid = inh.inhrelid)
+WHERE inh.inhparent = 'defer_index_test'::regclass;
+SET enable_seqscan = false;
+SELECT * FROM defer_index_test WHERE temp > 1.5 ORDER BY temp;
+RESET enable_seqscan;
+
+-- An open chunk takes more memory than the limit, so opening a chunk
+-- closes the previously opened one
+CREATE TABLE open_memory_test(time timestamp NOT NULL, temp float8);
+SELECT create_hypertable('open_memory_test', 'time', chunk_time_interval => interval '1 day');
+SELECT evictions AS evictions_before FROM _timescaledb_internal.cache_stats()
+WHERE cache_name = 'chunk_dispatch' \gset
+SET timescaledb.max_open_chunks_memory = '1kB';
+INSERT INTO open_memory_test VALUES
+('2017-01-01 01:00', 1.0),
+('2017-01-02 01:00', 2.0),
+('2017-01-01 02:00', 3.0);
+RESET timescaledb.max_open_chunks_memory;
+SELECT evictions > :evictions_before AS has_evictions
+FROM _timescaledb_internal.cache_stats()
+WHERE cache_name = 'chunk_dispatch';
+SELECT count(*) FROM open_memory_test;
+
+-- The planned constraints of a chunk are cached across statements, so
+-- check that a constraint added after an insert is enforced on the
+-- next insert into the same chunk.
+CREATE TABLE cis_cache_test(time timestamp NOT NULL, temp float8);
+SELECT create_hypertable('cis_cache_test', 'time', chunk_time_interval => interval '1 day');
+INSERT INTO cis_cache_test VALUES ('2017-01-01 01:00', 1.0);
+ALTER TABLE cis_cache_test ADD CONSTRAINT cis_cache_test_temp_check CHECK (temp < 100);
+DO $$
+BEGIN
+    INSERT INTO cis_cache_test VALUES ('2017-01-01 02:00', 200.0);
+EXCEPTION WHEN check_violation THEN
+    RAISE NOTICE 'check constraint enforced';
+END
+$$;
+INSERT INTO cis_cache_test VALUES ('2017-01-01 03:00', 3.0);
+SELECT * FROM cis_cache_test ORDER BY time;
@@ -150,6 +150,11 @@ INSERT INTO "nondefault_mem_settings" VALUES
 ('2002-03-20T09:00:00', 31.9),
 ('2003-03-20T09:00:00', 32.9);
 
+-- the single open chunk is evicted when switching chunks
+SELECT cache_name, max_entries, evictions > 0 AS has_evictions
+FROM _timescaledb_internal.cache_stats()
+WHERE cache_name = 'chunk_dispatch';
+
 --unlimited
 SET timescaledb.max_open_chunks_per_insert = 0;
 SET timescaledb.max_cached_chunks_per_hypertable = 0;
@@ -160,6 +165,17 @@ INSERT INTO "nondefault_mem_settings" VALUES
 
 SELECT * FROM "nondefault_mem_settings";
 
+-- a memory limit smaller than a single hypertable keeps only the most
+-- recently used hypertable in the cache
+SET timescaledb.hypertable_cache_memory_limit = '1kB';
+SELECT * FROM "1dim" LIMIT 0;
+SELECT * FROM "nondefault_mem_settings" LIMIT 0;
+SELECT cache_name, hypertable, max_memory_bytes
+FROM _timescaledb_internal.cache_stats()
+WHERE cache_name IN ('hypertable_cache', 'chunk_cache')
+ORDER BY cache_name DESC;
+RESET timescaledb.hypertable_cache_memory_limit;
+
 
 --test rollback
 BEGIN;
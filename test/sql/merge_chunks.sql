@@ -0,0 +1,39 @@
+CREATE TABLE merge(time bigint NOT NULL, value int);
+CREATE INDEX ON merge(value);
+SELECT create_hypertable('merge', 'time', chunk_time_interval => 10);
+INSERT INTO merge SELECT i, i FROM generate_series(0, 59) i;
+
+\set ON_ERROR_STOP 0
+SELECT merge_chunks('merge', '2017-01-01'::timestamptz, 30);
+SELECT merge_chunks('merge', 40, interval '1 day');
+CREATE TABLE regular(time bigint);
+SELECT merge_chunks('regular', 40, 30);
+\set ON_ERROR_STOP 1
+
+-- Only the first three chunks fit in the target interval
+SELECT merge_chunks('merge', 40, 30);
+SELECT c.table_name, cc.constraint_name, s.range_start, s.range_end
+FROM _timescaledb_catalog.chunk c
+INNER JOIN _timescaledb_catalog.chunk_constraint cc ON (cc.chunk_id = c.id)
+INNER JOIN _timescaledb_catalog.dimension_slice s ON (s.id = cc.dimension_slice_id)
+ORDER BY s.range_start;
+SELECT * FROM _timescaledb_catalog.dimension_slice ORDER BY id;
+SELECT count(*), min(time), max(time), sum(value) FROM merge;
+SELECT * FROM _timescaledb_internal._hyper_1_1_chunk WHERE value = 25;
+
+-- Chunks bigger than the target interval are not merged
+SELECT merge_chunks('merge');
+
+SELECT merge_chunks('merge', NULL, 100);
+SELECT c.table_name, cc.constraint_name, s.range_start, s.range_end
+FROM _timescaledb_catalog.chunk c
+INNER JOIN _timescaledb_catalog.chunk_constraint cc ON (cc.chunk_id = c.id)
+INNER JOIN _timescaledb_catalog.dimension_slice s ON (s.id = cc.dimension_slice_id)
+ORDER BY s.range_start;
+SELECT * FROM _timescaledb_catalog.dimension_slice ORDER BY id;
+SELECT count(*), min(time), max(time), sum(value) FROM merge;
+\dt "_timescaledb_internal".*
+
+-- New chunks are created next to the merged chunk
+INSERT INTO merge VALUES (60, 60);
+SELECT count(*) FROM merge;
@@ -0,0 +1,32 @@
+-- The microbenchmarks are only built in debug builds. Their timings vary, so
+-- only check that they run.
+CREATE OR REPLACE FUNCTION bench_subspace_store_add(hypertable REGCLASS, num_chunks INTEGER, max_items INTEGER)
+RETURNS FLOAT8 AS :MODULE_PATHNAME, 'bench_subspace_store_add' LANGUAGE C VOLATILE;
+CREATE OR REPLACE FUNCTION bench_subspace_store_get(hypertable REGCLASS, num_chunks INTEGER, iterations INTEGER)
+RETURNS FLOAT8 AS :MODULE_PATHNAME, 'bench_subspace_store_get' LANGUAGE C VOLATILE;
+CREATE OR REPLACE FUNCTION bench_dimension_vec_find_slice(num_slices INTEGER, iterations INTEGER)
+RETURNS FLOAT8 AS :MODULE_PATHNAME, 'bench_dimension_vec_find_slice' LANGUAGE C VOLATILE;
+CREATE OR REPLACE FUNCTION bench_calculate_point(row_value ANYELEMENT, iterations INTEGER, from_values BOOLEAN)
+RETURNS FLOAT8 AS :MODULE_PATHNAME, 'bench_calculate_point' LANGUAGE C VOLATILE;
+CREATE OR REPLACE FUNCTION bench_partitioning_func(row_value ANYELEMENT, iterations INTEGER)
+RETURNS FLOAT8 AS :MODULE_PATHNAME, 'bench_partitioning_func' LANGUAGE C VOLATILE;
+
+CREATE TABLE bench(time timestamptz NOT NULL, device text NOT NULL, location int NOT NULL, temp float);
+SELECT create_hypertable('bench', 'time', 'device', 4);
+SELECT add_dimension('bench', 'location', 2);
+INSERT INTO bench VALUES ('2018-01-01 01:00', 'dev1', 1, 1.0);
+
+SELECT bench_subspace_store_add('bench', 1000, 0) >= 0 AS add_unbounded,
+       bench_subspace_store_add('bench', 1000, 10) >= 0 AS add_evicting,
+       bench_subspace_store_get('bench', 1000, 10000) >= 0 AS get;
+SELECT bench_dimension_vec_find_slice(1, 10000) >= 0 AS find_one,
+       bench_dimension_vec_find_slice(1000, 10000) >= 0 AS find_many;
+SELECT bench_calculate_point(b, 10000, false) >= 0 AS from_tuple,
+       bench_calculate_point(b, 10000, true) >= 0 AS from_values,
+       bench_partitioning_func(b, 10000) >= 0 AS partitioning
+FROM bench b;
+
+\set ON_ERROR_STOP 0
+SELECT bench_subspace_store_get('bench', 0, 10);
+SELECT bench_calculate_point(1, 10, true);
+\set ON_ERROR_STOP 1
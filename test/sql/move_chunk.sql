@@ -0,0 +1,118 @@
+\c single :ROLE_SUPERUSER
+SET client_min_messages = ERROR;
+DROP TABLESPACE IF EXISTS tablespace1;
+DROP TABLESPACE IF EXISTS tablespace2;
+SET client_min_messages = NOTICE;
+CREATE TABLESPACE tablespace1 OWNER :ROLE_DEFAULT_PERM_USER LOCATION :TEST_TABLESPACE1_PATH;
+CREATE TABLESPACE tablespace2 OWNER :ROLE_DEFAULT_PERM_USER LOCATION :TEST_TABLESPACE2_PATH;
+\c single :ROLE_DEFAULT_PERM_USER
+
+CREATE TABLE move_test(time timestamptz NOT NULL, device_id int, temp float8, payload text);
+SELECT create_hypertable('move_test', 'time', chunk_time_interval => interval '1 day');
+CREATE INDEX move_test_device_time ON move_test(device_id, time DESC);
+
+-- Three chunks. The payload is large enough to be stored in the TOAST table.
+INSERT INTO move_test VALUES
+    ('2000-01-01 06:00+00', 2, 1.0, NULL),
+    ('2000-01-01 07:00+00', 1, 2.0, NULL),
+    ('2000-01-01 08:00+00', 2, 3.0, NULL),
+    ('2000-01-01 09:00+00', 1, 4.0, (SELECT string_agg(md5(i::text), '' ORDER BY i) FROM generate_series(1, 300) i)),
+    ('2000-01-02 06:00+00', 2, 5.0, NULL),
+    ('2000-01-02 07:00+00', 1, 6.0, NULL),
+    ('2000-01-03 06:00+00', 2, 7.0, NULL),
+    ('2000-01-03 07:00+00', 1, 8.0, NULL);
+
+CREATE VIEW chunk_tablespaces AS
+SELECT ch.table_name AS chunk,
+       coalesce(t.spcname, 'default') AS data,
+       (SELECT string_agg(DISTINCT coalesce(it.spcname, 'default'), ', ')
+        FROM pg_index i
+        INNER JOIN pg_class ic ON (ic.oid = i.indexrelid)
+        LEFT JOIN pg_tablespace it ON (it.oid = ic.reltablespace)
+        WHERE i.indrelid = c.oid) AS indexes,
+       coalesce(tt.spcname, 'default') AS toast
+FROM _timescaledb_catalog.chunk ch
+INNER JOIN pg_class c ON (c.oid = format('%I.%I', ch.schema_name, ch.table_name)::regclass)
+LEFT JOIN pg_class toast ON (toast.oid = c.reltoastrelid)
+LEFT JOIN pg_tablespace t ON (t.oid = c.reltablespace)
+LEFT JOIN pg_tablespace tt ON (tt.oid = toast.reltablespace)
+WHERE ch.hypertable_id = 1
+ORDER BY ch.id;
+
+SELECT * FROM chunk_tablespaces;
+
+-- Chunks can only be moved to tablespaces that are attached to their
+-- hypertable
+\set ON_ERROR_STOP 0
+SELECT move_chunk(NULL, 'tablespace1');
+SELECT move_chunk('_timescaledb_internal._hyper_1_1_chunk', NULL);
+SELECT move_chunk('move_test', 'tablespace1');
+SELECT move_chunk('_timescaledb_internal._hyper_1_1_chunk', 'tablespace_missing');
+SELECT move_chunk('_timescaledb_internal._hyper_1_1_chunk', 'tablespace1');
+\set ON_ERROR_STOP 1
+SELECT attach_tablespace('tablespace1', 'move_test');
+SELECT attach_tablespace('tablespace2', 'move_test');
+
+-- Move the data of a chunk to one tablespace and its indexes to another
+SELECT move_chunk('_timescaledb_internal._hyper_1_1_chunk', 'tablespace1', 'tablespace2');
+SELECT * FROM chunk_tablespaces;
+
+-- The data and the indexes were swapped in with the moved chunk
+SELECT payload = (SELECT string_agg(md5(i::text), '' ORDER BY i) FROM generate_series(1, 300) i) AS payload_intact
+FROM move_test
+WHERE payload IS NOT NULL;
+SET enable_seqscan = off;
+SELECT device_id, temp FROM move_test WHERE device_id = 1 ORDER BY time;
+RESET enable_seqscan;
+
+-- A chunk can be reordered while it is moved
+SELECT move_chunk('_timescaledb_internal._hyper_1_2_chunk', 'tablespace1', reorder_index => 'move_test_device_time');
+SELECT device_id, temp FROM _timescaledb_internal._hyper_1_2_chunk ORDER BY ctid;
+SELECT * FROM chunk_tablespaces;
+
+-- A compressed chunk is moved with its compressed table
+SELECT compress_chunk('_timescaledb_internal._hyper_1_3_chunk');
+SELECT move_chunk('_timescaledb_internal._hyper_1_3_chunk', 'tablespace2');
+SELECT * FROM chunk_tablespaces;
+SELECT coalesce(t.spcname, 'default') AS compressed
+FROM pg_class c
+LEFT JOIN pg_tablespace t ON (t.oid = c.reltablespace)
+WHERE c.relname = '_compressed_chunk_3';
+SELECT device_id, temp FROM move_test WHERE time >= '2000-01-03 00:00+00' ORDER BY time;
+
+-- A move_chunks policy moves the oldest chunk that is not in the policy's
+-- tablespaces in each run
+SELECT add_move_chunks_policy('move_test', INTERVAL '1 day', 'tablespace2');
+SELECT * FROM _timescaledb_catalog.bgw_policy_move_chunks;
+
+CREATE TABLE move_other(time timestamptz NOT NULL, temp float8);
+SELECT create_hypertable('move_other', 'time');
+CREATE TABLE move_int(time bigint NOT NULL, temp float8);
+SELECT create_hypertable('move_int', 'time', chunk_time_interval => 10);
+\set ON_ERROR_STOP 0
+SELECT add_move_chunks_policy('move_test', INTERVAL '1 day', 'tablespace2');
+SELECT add_move_chunks_policy('move_other', INTERVAL '1 day', NULL);
+SELECT add_move_chunks_policy('move_other', INTERVAL '1 day', 'tablespace1');
+SELECT add_move_chunks_policy('move_other', INTERVAL '-1 day', 'tablespace1');
+SELECT add_move_chunks_policy('move_int', INTERVAL '1 day', 'tablespace1');
+\set ON_ERROR_STOP 1
+
+SELECT _timescaledb_internal.bgw_job_run(1);
+SELECT * FROM chunk_tablespaces;
+SELECT _timescaledb_internal.bgw_job_run(1);
+SELECT * FROM chunk_tablespaces;
+SELECT _timescaledb_internal.bgw_job_run(1);
+SELECT * FROM chunk_tablespaces;
+SELECT job_id, last_run_success, total_runs, total_failures
+FROM _timescaledb_catalog.bgw_job_stat;
+SELECT count(*) FROM move_test;
+
+SELECT remove_move_chunks_policy('move_test');
+SELECT count(*) FROM _timescaledb_catalog.bgw_policy_move_chunks;
+
+DROP TABLE move_test;
+DROP TABLE move_other;
+DROP TABLE move_int;
+\c single :ROLE_SUPERUSER
+DROP TABLESPACE tablespace1;
+DROP TABLESPACE tablespace2;
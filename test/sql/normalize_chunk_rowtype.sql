@@ -0,0 +1,59 @@
+CREATE TABLE norm(time bigint NOT NULL, dropped int, value int CHECK (value >= 0));
+CREATE INDEX ON norm(value);
+SELECT create_hypertable('norm', 'time', chunk_time_interval => 10);
+INSERT INTO norm VALUES (1, 1, 1), (2, 2, 2);
+ALTER TABLE norm DROP COLUMN dropped;
+
+-- New chunks get the hypertable's layout, with a position for the dropped
+-- column, and inherit their columns and CHECK constraints
+INSERT INTO norm VALUES (11, 11), (12, 12);
+SELECT attrelid::regclass, attnum, attname, attislocal, attinhcount
+FROM pg_attribute
+WHERE attrelid = '_timescaledb_internal._hyper_1_2_chunk'::regclass
+AND attnum > 0 AND NOT attisdropped
+ORDER BY attnum;
+SELECT conname, contype, conislocal, coninhcount
+FROM pg_constraint
+WHERE conrelid = '_timescaledb_internal._hyper_1_2_chunk'::regclass
+ORDER BY conname;
+SELECT * FROM norm ORDER BY time;
+
+-- Chunks that already have the hypertable's layout are not rewritten
+SELECT normalize_chunk_rowtype('_timescaledb_internal._hyper_1_1_chunk');
+SELECT normalize_chunk_rowtype('_timescaledb_internal._hyper_1_2_chunk');
+
+\set ON_ERROR_STOP 0
+SELECT normalize_chunk_rowtype(NULL);
+SELECT normalize_chunk_rowtype('norm');
+\set ON_ERROR_STOP 1
+
+-- Chunks of hypertables with OIDs inherit their columns, so they lack the
+-- dropped column once the OIDs are removed
+CREATE TABLE norm_oids(time bigint NOT NULL, dropped int, value int) WITH (oids=true);
+CREATE INDEX ON norm_oids(value);
+SELECT create_hypertable('norm_oids', 'time', chunk_time_interval => 10);
+ALTER TABLE norm_oids DROP COLUMN dropped;
+INSERT INTO norm_oids VALUES (1, 1), (2, 2), (11, 11);
+ALTER TABLE norm_oids SET WITHOUT OIDS;
+SELECT attrelid::regclass, attnum, attname
+FROM pg_attribute
+WHERE attrelid = '_timescaledb_internal._hyper_2_3_chunk'::regclass
+AND attnum > 0 AND NOT attisdropped
+ORDER BY attnum;
+
+SELECT normalize_chunk_rowtype('_timescaledb_internal._hyper_2_3_chunk');
+SELECT normalize_chunk_rowtype('_timescaledb_internal._hyper_2_3_chunk');
+SELECT attrelid::regclass, attnum, attname, attislocal, attinhcount
+FROM pg_attribute
+WHERE attrelid = '_timescaledb_internal._hyper_2_3_chunk'::regclass
+AND attnum > 0 AND NOT attisdropped
+ORDER BY attnum;
+SELECT conname, contype, conislocal, coninhcount
+FROM pg_constraint
+WHERE conrelid = '_timescaledb_internal._hyper_2_3_chunk'::regclass
+ORDER BY conname;
+SELECT * FROM _timescaledb_catalog.chunk_index WHERE chunk_id = 3 ORDER BY index_name;
+
+-- The rewritten chunk keeps its rows and takes new ones
+INSERT INTO norm_oids VALUES (3, 3);
+SELECT * FROM norm_oids ORDER BY time;
@@ -46,3 +46,24 @@ SELECT histogram(i, 0, 100000, 5) FROM "test";
 
 EXPLAIN (costs off) SELECT histogram(i, 10,100000,5) FROM "test";
 SELECT histogram(i, 10, 100000, 5) FROM "test";
+
+--chunks are distributed among the processes of a parallel query by
+--ConstraintAwareAppend, when the chunks are too small for partial scans
+RESET force_parallel_mode;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+CREATE TABLE par_test(time bigint NOT NULL, value int);
+SELECT create_hypertable('par_test', 'time', chunk_time_interval => 10, create_default_indexes => false);
+INSERT INTO par_test SELECT x, x FROM generate_series(0, 39) x;
+
+EXPLAIN (costs off)
+SELECT * FROM par_test;
+SELECT count(*), sum(value) FROM par_test;
+
+--chunks excluded by the planner are not distributed
+EXPLAIN (costs off)
+SELECT * FROM par_test WHERE time < 20;
+SELECT count(*), sum(value) FROM par_test WHERE time < 20;
+
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
@@ -83,3 +83,69 @@ INSERT INTO part_custom_func VALUES ('2017-03-22T09:18:23', 23.4, 'dev1'),
                                     ('2017-03-22T09:18:23', 23.4, 'dev7');
 
 SELECT * FROM test.show_subtables('part_custom_func');
+
+-- Test that the specialized hashing for built-in types places rows in
+-- the same partitions as the partitioning function itself, for both
+-- the default and the legacy partitioning function
+CREATE OR REPLACE FUNCTION test_misplaced_rows(ht REGCLASS)
+    RETURNS BIGINT LANGUAGE PLPGSQL AS
+$BODY$
+DECLARE
+    dim RECORD;
+    misplaced BIGINT;
+BEGIN
+    SELECT d.* INTO STRICT dim
+    FROM _timescaledb_catalog.dimension d
+    INNER JOIN _timescaledb_catalog.hypertable h ON (d.hypertable_id = h.id)
+    WHERE format('%I.%I', h.schema_name, h.table_name)::regclass = ht
+    AND d.num_slices IS NOT NULL;
+    EXECUTE format($$
+        SELECT count(*) FROM %1$s t
+        INNER JOIN _timescaledb_catalog.chunk c
+        ON (format('%%I.%%I', c.schema_name, c.table_name)::regclass = t.tableoid)
+        INNER JOIN _timescaledb_catalog.chunk_constraint cc ON (cc.chunk_id = c.id)
+        INNER JOIN _timescaledb_catalog.dimension_slice ds
+        ON (ds.id = cc.dimension_slice_id AND ds.dimension_id = %2$s)
+        WHERE %3$I.%4$I(t.%5$I) < ds.range_start
+        OR %3$I.%4$I(t.%5$I) >= ds.range_end
+    $$, ht, dim.id, dim.partitioning_func_schema, dim.partitioning_func, dim.column_name)
+    INTO misplaced;
+    RETURN misplaced;
+END
+$BODY$;
+CREATE TABLE part_kernel_int2(time timestamptz NOT NULL, device int2);
+CREATE TABLE part_kernel_int4(time timestamptz NOT NULL, device int4);
+CREATE TABLE part_kernel_int8(time timestamptz NOT NULL, device int8);
+CREATE TABLE part_kernel_text(time timestamptz NOT NULL, device text);
+CREATE TABLE part_kernel_varchar(time timestamptz NOT NULL, device varchar(10));
+CREATE TABLE part_kernel_uuid(time timestamptz NOT NULL, device uuid);
+SELECT create_hypertable(format('part_kernel_%s', t)::regclass, 'time', 'device', 3)
+FROM unnest(ARRAY['int2', 'int4', 'int8', 'text', 'varchar', 'uuid']) t;
+CREATE TABLE part_legacy_int2(time timestamptz NOT NULL, device int2);
+CREATE TABLE part_legacy_int4(time timestamptz NOT NULL, device int4);
+CREATE TABLE part_legacy_int8(time timestamptz NOT NULL, device int8);
+CREATE TABLE part_legacy_text(time timestamptz NOT NULL, device text);
+CREATE TABLE part_legacy_varchar(time timestamptz NOT NULL, device varchar(10));
+CREATE TABLE part_legacy_uuid(time timestamptz NOT NULL, device uuid);
+SELECT create_hypertable(format('part_legacy_%s', t)::regclass, 'time', 'device', 3,
+                         partitioning_func => '_timescaledb_internal.get_partition_for_key')
+FROM unnest(ARRAY['int2', 'int4', 'int8', 'text', 'varchar', 'uuid']) t;
+
+INSERT INTO part_kernel_int2 SELECT '2017-03-22T09:18:23', i FROM generate_series(-50, 50) i;
+INSERT INTO part_kernel_int4 SELECT '2017-03-22T09:18:23', i * 100000 FROM generate_series(-50, 50) i;
+INSERT INTO part_kernel_int8 SELECT '2017-03-22T09:18:23', i * 10000000000 FROM generate_series(-50, 50) i;
+INSERT INTO part_kernel_text SELECT '2017-03-22T09:18:23', 'dev' || i FROM generate_series(-50, 50) i;
+INSERT INTO part_kernel_varchar SELECT '2017-03-22T09:18:23', 'dev' || i FROM generate_series(-50, 50) i;
+INSERT INTO part_kernel_uuid SELECT '2017-03-22T09:18:23', md5(i::text)::uuid FROM generate_series(-50, 50) i;
+INSERT INTO part_legacy_int2 SELECT * FROM part_kernel_int2;
+INSERT INTO part_legacy_int4 SELECT * FROM part_kernel_int4;
+INSERT INTO part_legacy_int8 SELECT * FROM part_kernel_int8;
+INSERT INTO part_legacy_text SELECT * FROM part_kernel_text;
+INSERT INTO part_legacy_varchar SELECT * FROM part_kernel_varchar;
+INSERT INTO part_legacy_uuid SELECT * FROM part_kernel_uuid;
+
+SELECT t AS hypertable, test_misplaced_rows(t)
+FROM unnest(ARRAY['part_kernel_int2', 'part_kernel_int4', 'part_kernel_int8',
+                  'part_kernel_text', 'part_kernel_varchar', 'part_kernel_uuid',
+                  'part_legacy_int2', 'part_legacy_int4', 'part_legacy_int8',
+                  'part_legacy_text', 'part_legacy_varchar', 'part_legacy_uuid']::regclass[]) t;
@@ -0,0 +1,23 @@
+CREATE TABLE chunk_agg(time bigint NOT NULL, device int, temp float);
+SELECT create_hypertable('chunk_agg', 'time', chunk_time_interval => 10);
+INSERT INTO chunk_agg SELECT t, t % 3, t FROM generate_series(0, 49) t;
+ANALYZE chunk_agg;
+
+-- Aggregating each chunk before combining the partial aggregates must
+-- give the same results as aggregating all chunks at once
+SET timescaledb.chunk_aggregation = 'on';
+
+SELECT device, count(*), sum(temp), avg(temp), min(time), max(time)
+FROM chunk_agg GROUP BY device ORDER BY device;
+
+SELECT time_bucket(20, time) AS bucket, first(temp, time), last(temp, time), histogram(temp, 0, 50, 5)
+FROM chunk_agg GROUP BY bucket ORDER BY bucket;
+
+SELECT device, sum(temp) FROM chunk_agg
+WHERE time >= 15 GROUP BY device HAVING count(*) > 11 ORDER BY device;
+
+SELECT count(*), first(device, time), last(device, time) FROM chunk_agg;
+
+SELECT count(*) FROM chunk_agg WHERE time < 0;
+
+RESET timescaledb.chunk_aggregation;
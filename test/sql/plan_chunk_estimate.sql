@@ -0,0 +1,28 @@
+-- The estimated rows of the top plan node of a query
+CREATE OR REPLACE FUNCTION estimated_rows(query text)
+RETURNS bigint LANGUAGE PLPGSQL AS
+$BODY$
+DECLARE
+    plan json;
+BEGIN
+    EXECUTE 'EXPLAIN (FORMAT JSON) ' || query INTO plan;
+    RETURN (plan->0->'Plan'->>'Plan Rows')::bigint;
+END;
+$BODY$;
+
+-- The chunks are never analyzed, so they have no statistics
+CREATE TABLE chunk_estimate(time bigint NOT NULL, value int) WITH (autovacuum_enabled = false);
+SELECT create_hypertable('chunk_estimate', 'time', chunk_time_interval => 1000);
+INSERT INTO chunk_estimate SELECT t, t FROM generate_series(0, 2999) t;
+
+-- The restrictions on time are estimated from the fraction of each chunk's
+-- time range that they cover. The main table adds one row.
+SELECT estimated_rows('SELECT * FROM chunk_estimate WHERE time >= 1000 AND time < 1250');
+SELECT estimated_rows('SELECT * FROM chunk_estimate WHERE time > 1500');
+SELECT estimated_rows('SELECT * FROM chunk_estimate WHERE time >= 1000 AND time < 1250 AND value = 5');
+
+-- With the estimation disabled, PostgreSQL uses default selectivities
+SET timescaledb.chunk_row_estimation = 'off';
+SELECT estimated_rows('SELECT * FROM chunk_estimate WHERE time >= 1000 AND time < 1250');
+SELECT estimated_rows('SELECT * FROM chunk_estimate WHERE time > 1500');
+RESET timescaledb.chunk_row_estimation;
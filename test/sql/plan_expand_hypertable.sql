@@ -0,0 +1,107 @@
+CREATE TABLE plan_expand(time bigint NOT NULL, device int, temp float);
+SELECT create_hypertable('plan_expand', 'time', chunk_time_interval => 10);
+INSERT INTO plan_expand SELECT t, t % 3, t FROM generate_series(0, 49) t;
+
+CREATE OR REPLACE VIEW locked_chunks AS
+SELECT relation::regclass AS chunk FROM pg_locks
+WHERE locktype = 'relation' AND pid = pg_backend_pid()
+AND relation::regclass::text LIKE '%chunk'
+ORDER BY relation;
+
+-- Only the chunks that match the restrictions should be locked
+-- (and planned)
+BEGIN;
+SELECT count(*) FROM plan_expand WHERE time < 15;
+SELECT * FROM locked_chunks;
+ROLLBACK;
+
+BEGIN;
+SELECT count(*) FROM plan_expand WHERE 25 <= time AND time < 30;
+SELECT * FROM locked_chunks;
+ROLLBACK;
+
+BEGIN;
+SELECT count(*) FROM plan_expand WHERE time = 42;
+SELECT * FROM locked_chunks;
+ROLLBACK;
+
+-- Restrictions in inner joins are used, outer join quals are not
+BEGIN;
+SELECT count(*) FROM plan_expand p INNER JOIN generate_series(0, 2) g ON (p.time > 39 AND p.device = g);
+SELECT * FROM locked_chunks;
+ROLLBACK;
+
+BEGIN;
+SELECT count(*) FROM plan_expand p LEFT JOIN generate_series(0, 2) g ON (p.time > 39 AND p.device = g);
+SELECT * FROM locked_chunks;
+ROLLBACK;
+
+-- Contradicting restrictions exclude all chunks
+SELECT count(*) FROM plan_expand WHERE time < 10 AND time > 40;
+
+-- Disabling plan-time exclusion expands all chunks
+SET timescaledb.plan_chunk_exclusion = off;
+BEGIN;
+SELECT count(*) FROM plan_expand WHERE time < 15;
+SELECT * FROM locked_chunks;
+ROLLBACK;
+RESET timescaledb.plan_chunk_exclusion;
+
+-- Space dimensions are excluded on equality
+CREATE TABLE plan_expand_space(time bigint NOT NULL, device int, temp float);
+SELECT create_hypertable('plan_expand_space', 'time', 'device', 2, chunk_time_interval => 10);
+INSERT INTO plan_expand_space VALUES (1, 1, 1.0), (2, 2, 2.0);
+
+BEGIN;
+SELECT * FROM plan_expand_space WHERE device = 1;
+SELECT * FROM locked_chunks;
+ROLLBACK;
+
+-- IN lists on the space dimension are excluded on the hashes of their values
+BEGIN;
+SELECT * FROM plan_expand_space WHERE device IN (1, 1);
+SELECT * FROM locked_chunks;
+ROLLBACK;
+
+BEGIN;
+SELECT * FROM plan_expand_space WHERE device IN (1, 2) ORDER BY time;
+SELECT * FROM locked_chunks;
+ROLLBACK;
+
+-- IN lists on the time dimension
+BEGIN;
+SELECT * FROM plan_expand WHERE time IN (5, 42, NULL) ORDER BY time;
+SELECT * FROM locked_chunks;
+ROLLBACK;
+
+-- Only values in all of the lists remain
+BEGIN;
+SELECT * FROM plan_expand WHERE time IN (5, 42) AND time IN (42, 43);
+SELECT * FROM locked_chunks;
+ROLLBACK;
+
+-- Lower bounds relative to the transaction time are used at plan time,
+-- since they only exclude more chunks in later transactions
+CREATE TABLE plan_expand_now(time timestamptz NOT NULL, temp float);
+SELECT create_hypertable('plan_expand_now', 'time', chunk_time_interval => interval '1 day');
+INSERT INTO plan_expand_now VALUES ('2000-01-01', 1.0), (now() + interval '1 hour', 2.0);
+
+BEGIN;
+SELECT count(*) FROM plan_expand_now WHERE time > now() - interval '1 day';
+SELECT * FROM locked_chunks;
+ROLLBACK;
+
+-- Upper bounds are left to execution time
+BEGIN;
+SELECT count(*) FROM plan_expand_now WHERE time < now() - interval '1 day';
+SELECT * FROM locked_chunks;
+ROLLBACK;
+
+-- The chunks of UPDATE and DELETE targets are excluded on the same
+-- restrictions, including those that constraint exclusion cannot use
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+EXPLAIN (costs off) DELETE FROM plan_expand_space WHERE device = 1;
+EXPLAIN (costs off) UPDATE plan_expand_now SET temp = 0 WHERE time > now() - interval '1 day';
+RESET enable_indexscan;
+RESET enable_bitmapscan;
@@ -47,3 +47,18 @@ SELECT * FROM test.show_indexes('_timescaledb_internal._hyper_1_1_chunk');
 SELECT * FROM _timescaledb_internal.chunk_index_replace('_timescaledb_internal."1_1_reindex_test_pkey"'::regclass, '_timescaledb_internal."_hyper_1_1_chunk_1_1_reindex_test_pkey"'::regclass);
 
 SELECT * FROM test.show_indexes('_timescaledb_internal._hyper_1_1_chunk');
+
+-- Reindex with a transaction per chunk. Chunk indexes are rebuilt side
+-- by side and swapped in, except for indexes that back constraints,
+-- which are reindexed in place.
+SET timescaledb.reindex_transaction_per_chunk = on;
+CREATE TEMP TABLE reindex_oids AS
+SELECT indexrelid FROM pg_index
+WHERE indrelid = '_timescaledb_internal._hyper_1_2_chunk'::regclass;
+REINDEX TABLE reindex_test;
+SELECT i.indexrelid::regclass, i.indexrelid IN (SELECT indexrelid FROM reindex_oids) AS same_index
+FROM pg_index i
+WHERE i.indrelid = '_timescaledb_internal._hyper_1_2_chunk'::regclass
+ORDER BY i.indexrelid;
+SELECT * FROM reindex_test WHERE time = '2017-04-20T09:00:01';
+RESET timescaledb.reindex_transaction_per_chunk;
@@ -0,0 +1,90 @@
+CREATE TABLE reorder_test(time timestamptz NOT NULL, device_id int, temp float8, payload text);
+SELECT create_hypertable('reorder_test', 'time', chunk_time_interval => interval '1 day');
+CREATE INDEX reorder_test_device_time ON reorder_test(device_id, time DESC);
+
+-- Three chunks, with rows of the devices interleaved. The payload is large
+-- enough to be stored in the TOAST table.
+INSERT INTO reorder_test VALUES
+    ('2000-01-01 06:00+00', 2, 1.0, NULL),
+    ('2000-01-01 07:00+00', 1, 2.0, NULL),
+    ('2000-01-01 08:00+00', 2, 3.0, NULL),
+    ('2000-01-01 09:00+00', 1, 4.0, (SELECT string_agg(md5(i::text), '' ORDER BY i) FROM generate_series(1, 300) i)),
+    ('2000-01-02 06:00+00', 2, 5.0, NULL),
+    ('2000-01-02 07:00+00', 1, 6.0, NULL),
+    ('2000-01-03 06:00+00', 2, 7.0, NULL),
+    ('2000-01-03 07:00+00', 1, 8.0, NULL);
+DELETE FROM reorder_test WHERE temp = 3.0;
+
+CREATE VIEW clustered_indexes AS
+SELECT c.table_name AS chunk, ci.hypertable_index_name
+FROM _timescaledb_catalog.chunk_index ci
+INNER JOIN _timescaledb_catalog.chunk c ON (c.id = ci.chunk_id)
+INNER JOIN pg_index i ON (i.indexrelid = format('%I.%I', c.schema_name, ci.index_name)::regclass)
+WHERE i.indisclustered
+ORDER BY c.id;
+
+SELECT device_id, temp FROM _timescaledb_internal._hyper_1_1_chunk ORDER BY ctid;
+
+-- Reorder on the chunk's copy of a hypertable index
+SELECT reorder_chunk('_timescaledb_internal._hyper_1_1_chunk', 'reorder_test_device_time');
+SELECT device_id, temp FROM _timescaledb_internal._hyper_1_1_chunk ORDER BY ctid;
+SELECT * FROM clustered_indexes;
+
+-- The data and the indexes were swapped in with the reordered chunk
+SELECT payload = (SELECT string_agg(md5(i::text), '' ORDER BY i) FROM generate_series(1, 300) i) AS payload_intact
+FROM reorder_test
+WHERE payload IS NOT NULL;
+SET enable_seqscan = off;
+SELECT device_id, temp FROM reorder_test WHERE device_id = 1 ORDER BY time;
+RESET enable_seqscan;
+
+-- Without an index, the chunk is reordered on its clustered index
+SELECT reorder_chunk('_timescaledb_internal._hyper_1_1_chunk');
+SELECT device_id, temp FROM _timescaledb_internal._hyper_1_1_chunk ORDER BY ctid;
+SELECT reorder_chunk('_timescaledb_internal._hyper_1_2_chunk', 'reorder_test_time_idx');
+SELECT * FROM clustered_indexes;
+
+CREATE TABLE reorder_plain(time timestamptz, temp float8);
+CREATE INDEX reorder_plain_time_idx ON reorder_plain(time);
+\set ON_ERROR_STOP 0
+SELECT reorder_chunk(NULL);
+SELECT reorder_chunk('reorder_test', 'reorder_test_device_time');
+SELECT reorder_chunk('_timescaledb_internal._hyper_1_3_chunk', 'reorder_plain_time_idx');
+SELECT reorder_chunk('_timescaledb_internal._hyper_1_3_chunk');
+\set ON_ERROR_STOP 1
+
+-- A reorder policy reorders the most recent chunk that is not ordered on
+-- the policy's index in each run
+SELECT add_reorder_policy('reorder_test', 'reorder_test_device_time');
+SELECT * FROM _timescaledb_catalog.bgw_policy_reorder;
+\set ON_ERROR_STOP 0
+SELECT add_reorder_policy('reorder_test', 'reorder_test_device_time');
+SELECT add_reorder_policy('reorder_test', 'reorder_plain_time_idx');
+SELECT add_reorder_policy('reorder_test', 'reorder_test_missing_idx');
+SELECT add_reorder_policy('reorder_test', 'reorder_test_device_time', INTERVAL '-1 day');
+SELECT add_reorder_policy('reorder_plain', 'reorder_plain_time_idx');
+\set ON_ERROR_STOP 1
+
+SELECT _timescaledb_internal.bgw_job_run(1);
+SELECT * FROM clustered_indexes;
+SELECT device_id, temp FROM _timescaledb_internal._hyper_1_3_chunk ORDER BY ctid;
+SELECT _timescaledb_internal.bgw_job_run(1);
+SELECT * FROM clustered_indexes;
+SELECT _timescaledb_internal.bgw_job_run(1);
+SELECT * FROM clustered_indexes;
+SELECT job_id, last_run_success, total_runs, total_failures
+FROM _timescaledb_catalog.bgw_job_stat;
+
+SELECT remove_reorder_policy('reorder_test');
+\set ON_ERROR_STOP 0
+SELECT remove_reorder_policy('reorder_test');
+\set ON_ERROR_STOP 1
+SELECT remove_reorder_policy('reorder_test', if_exists => true);
+SELECT count(*) FROM _timescaledb_catalog.bgw_policy_reorder;
+
+-- Reorder policies need a time column of a timestamp or date type
+CREATE TABLE reorder_int(time bigint NOT NULL, temp float8);
+SELECT create_hypertable('reorder_int', 'time', chunk_time_interval => 10);
+\set ON_ERROR_STOP 0
+SELECT add_reorder_policy('reorder_int', 'reorder_int_time_idx');
+\set ON_ERROR_STOP 1
@@ -0,0 +1,48 @@
+CREATE TABLE repart(time bigint NOT NULL, device int, value int);
+CREATE INDEX ON repart(device, time);
+SELECT create_hypertable('repart', 'time', 'device', 2, chunk_time_interval => 10);
+INSERT INTO repart SELECT t, d, t * d FROM generate_series(0, 29) t, generate_series(1, 100) d;
+
+\set ON_ERROR_STOP 0
+SELECT repartition_chunks('repart', '2017-01-01'::timestamptz);
+CREATE TABLE nospace(time bigint NOT NULL);
+SELECT create_hypertable('nospace', 'time', chunk_time_interval => 10);
+SELECT repartition_chunks('nospace');
+CREATE TABLE regular(time bigint);
+SELECT repartition_chunks('regular');
+\set ON_ERROR_STOP 1
+
+-- Chunks that match the current partitioning are left alone
+SELECT repartition_chunks('repart');
+
+SELECT set_number_partitions('repart', 4);
+
+-- Only the chunks that end after time 10 are repartitioned
+SELECT repartition_chunks('repart', 10);
+SELECT ts.range_start, ts.range_end, count(*) AS num_chunks
+FROM _timescaledb_catalog.chunk c
+INNER JOIN _timescaledb_catalog.chunk_constraint cc ON (cc.chunk_id = c.id)
+INNER JOIN _timescaledb_catalog.dimension_slice ts ON (ts.id = cc.dimension_slice_id)
+INNER JOIN _timescaledb_catalog.dimension d ON (d.id = ts.dimension_id)
+WHERE d.column_name = 'time'
+GROUP BY ts.range_start, ts.range_end
+ORDER BY ts.range_start;
+SELECT s.range_start, s.range_end
+FROM _timescaledb_catalog.dimension_slice s
+INNER JOIN _timescaledb_catalog.dimension d ON (d.id = s.dimension_id)
+WHERE d.column_name = 'device'
+ORDER BY s.range_start, s.range_end;
+SELECT count(*), sum(value), count(DISTINCT tableoid) FROM repart;
+SELECT count(*) FROM repart WHERE device = 42 AND time >= 10;
+
+SELECT repartition_chunks('repart');
+SELECT s.range_start, s.range_end
+FROM _timescaledb_catalog.dimension_slice s
+INNER JOIN _timescaledb_catalog.dimension d ON (d.id = s.dimension_id)
+WHERE d.column_name = 'device'
+ORDER BY s.range_start, s.range_end;
+SELECT count(*), sum(value), count(DISTINCT tableoid) FROM repart;
+
+-- New rows go to the repartitioned chunks
+INSERT INTO repart VALUES (15, 42, 0);
+SELECT count(*), count(DISTINCT tableoid) FROM repart;
@@ -7,6 +7,11 @@ SELECT * FROM chunk_relation_size_pretty('"public"."two_Partitions"');
 SELECT * FROM indexes_relation_size('"public"."two_Partitions"');
 SELECT * FROM indexes_relation_size_pretty('"public"."two_Partitions"');
 
+-- The row count is only known after VACUUM or ANALYZE
+SELECT hypertable_approximate_row_count('"public"."two_Partitions"');
+ANALYZE "two_Partitions";
+SELECT hypertable_approximate_row_count('"public"."two_Partitions"');
+
 CREATE TABLE timestamp_partitioned(time TIMESTAMP, value TEXT);
 SELECT * FROM create_hypertable('timestamp_partitioned', 'time', 'value', 2);
 
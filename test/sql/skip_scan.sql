@@ -0,0 +1,18 @@
+CREATE TABLE skip_scan(time bigint NOT NULL, device int, value int);
+SELECT create_hypertable('skip_scan', 'time', chunk_time_interval => 1000);
+CREATE INDEX ON skip_scan(device, time DESC);
+INSERT INTO skip_scan SELECT t, t % 5, t FROM generate_series(0, 2999) t;
+INSERT INTO skip_scan VALUES (1500, NULL, -1), (2500, NULL, -2);
+ANALYZE skip_scan;
+
+-- Skipping to the next device in each chunk must give the same results as
+-- reading all rows
+SELECT DISTINCT ON (device) * FROM skip_scan ORDER BY device, time DESC;
+SELECT DISTINCT ON (device) * FROM skip_scan ORDER BY device DESC, time;
+SELECT DISTINCT device FROM skip_scan ORDER BY device;
+SELECT DISTINCT ON (device) * FROM skip_scan WHERE time < 1500 AND value % 2 = 0
+ORDER BY device, time DESC;
+
+SET timescaledb.skip_scan = 'off';
+SELECT DISTINCT ON (device) * FROM skip_scan ORDER BY device, time DESC;
+RESET timescaledb.skip_scan;
@@ -173,5 +173,28 @@ SELECT * FROM show_tablespaces('tspace_1dim');
 DROP TABLESPACE tablespace1;
 --after detaching we should now be able to drop the tablespace
 SELECT detach_tablespace('tablespace1', 'tspace_1dim');
+
+--with spread placement, the chunks of a time slice go to distinct
+--tablespaces even when sticky placement, which only follows the first
+--space dimension, puts them together
+CREATE TABLE tspace_spread(time timestamp, temp float, device int, location int);
+SELECT create_hypertable('tspace_spread', 'time', 'device', 1);
+SELECT add_dimension('tspace_spread', 'location', 2);
+SELECT attach_tablespace('tablespace1', 'tspace_spread');
+SELECT attach_tablespace('tablespace2', 'tspace_spread');
+INSERT INTO tspace_spread SELECT '2017-01-20T09:00:01', 24.3, 1, l FROM generate_series(1, 16) l;
+SET timescaledb.tablespace_placement = 'spread';
+INSERT INTO tspace_spread SELECT '2017-03-20T09:00:01', 24.3, 1, l FROM generate_series(1, 16) l;
+SELECT count(*) AS num_chunks, count(DISTINCT cl.reltablespace) AS num_tablespaces
+FROM _timescaledb_catalog.chunk ch
+INNER JOIN _timescaledb_catalog.chunk_constraint cc ON (cc.chunk_id = ch.id)
+INNER JOIN _timescaledb_catalog.dimension_slice ds ON (ds.id = cc.dimension_slice_id)
+INNER JOIN _timescaledb_catalog.dimension d ON (d.id = ds.dimension_id AND d.column_name = 'time')
+INNER JOIN pg_class cl ON (cl.oid = format('%I.%I', ch.schema_name, ch.table_name)::regclass)
+WHERE d.hypertable_id = (SELECT id FROM _timescaledb_catalog.hypertable WHERE table_name = 'tspace_spread')
+GROUP BY ds.range_start
+ORDER BY ds.range_start;
+RESET timescaledb.tablespace_placement;
+DROP TABLE tspace_spread;
 DROP TABLESPACE tablespace1;
 DROP TABLESPACE tablespace2;
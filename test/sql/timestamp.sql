@@ -349,6 +349,33 @@ FROM unnest(ARRAY[
     date '2017-11-09'
     ]) AS time;
 
+-- Timestamps before the epoch are bucketed down, also with the widths
+-- that have fast paths
+SELECT time, time_bucket(INTERVAL '1 hour', time) AS hour,
+       time_bucket(INTERVAL '15 minutes', time) AS quarter,
+       time_bucket(INTERVAL '90 minutes', time) AS ninety
+FROM unnest(ARRAY[
+    TIMESTAMP '1999-12-31 23:59:59.999999',
+    TIMESTAMP '2000-01-01 00:00:00',
+    TIMESTAMP '1969-12-31 23:31:00'
+    ]) AS time;
+
+-- Integer time truncates toward 0
+SELECT time, time_bucket(10, time) AS int, time_bucket(10::smallint, time::smallint) AS smallint,
+       time_bucket(10::bigint, time::bigint) AS bigint
+FROM unnest(ARRAY[
+     '-11',
+     '-10',
+     '-9',
+     '9'
+    ]::int[]) AS time;
+
+\set ON_ERROR_STOP 0
+SELECT time_bucket(INTERVAL '0 second', TIMESTAMP '2011-01-02 01:01:01');
+SELECT time_bucket(INTERVAL '-1 hour', TIMESTAMPTZ '2011-01-02 01:01:01');
+SELECT time_bucket(0, 10);
+\set ON_ERROR_STOP 1
+
 
 -------------------------------------
 --- Test time input functions --
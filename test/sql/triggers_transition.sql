@@ -0,0 +1,75 @@
+-- Statement-level triggers with transition tables, which are only
+-- available on PostgreSQL 10 and later
+CREATE TABLE transition_test(time bigint NOT NULL, device int, dropme int, value int);
+SELECT create_hypertable('transition_test', 'time', chunk_time_interval => 10);
+
+CREATE OR REPLACE FUNCTION transition_test_fn()
+    RETURNS TRIGGER LANGUAGE PLPGSQL AS
+$BODY$
+BEGIN
+    RAISE NOTICE '% %: %', TG_TABLE_NAME, TG_OP,
+        (SELECT string_agg(r::text, ' ' ORDER BY r.time) FROM new_rows r);
+    RETURN NULL;
+END
+$BODY$;
+
+CREATE OR REPLACE FUNCTION double_value_fn()
+    RETURNS TRIGGER LANGUAGE PLPGSQL AS
+$BODY$
+BEGIN
+    NEW.value := NEW.value * 2;
+    RETURN NEW;
+END
+$BODY$;
+
+-- Row-level triggers are created on chunks, which do not support
+-- transition tables
+\set ON_ERROR_STOP 0
+CREATE TRIGGER transition_row_trigger
+    AFTER INSERT ON transition_test REFERENCING NEW TABLE AS new_rows
+    FOR EACH ROW EXECUTE PROCEDURE transition_test_fn();
+\set ON_ERROR_STOP 1
+
+CREATE TRIGGER transition_test_trigger
+    AFTER INSERT ON transition_test REFERENCING NEW TABLE AS new_rows
+    FOR EACH STATEMENT EXECUTE PROCEDURE transition_test_fn();
+
+-- The trigger fires once with the rows of all chunks
+INSERT INTO transition_test VALUES (1, 1, 0, 10), (15, 2, 0, 20), (25, 1, 0, 30);
+
+-- New chunks do not have the dropped column, so their rows are
+-- converted back to the hypertable's rowtype
+ALTER TABLE transition_test DROP COLUMN dropme;
+INSERT INTO transition_test VALUES (5, 1, 1), (45, 2, 2);
+
+-- Rows modified by BEFORE ROW triggers are captured as inserted
+CREATE TRIGGER double_value_trigger
+    BEFORE INSERT ON transition_test
+    FOR EACH ROW EXECUTE PROCEDURE double_value_fn();
+INSERT INTO transition_test VALUES (6, 1, 3), (55, 2, 4);
+DROP TRIGGER double_value_trigger ON transition_test;
+
+COPY transition_test FROM STDIN;
+8	1	7
+66	2	8
+75	1	9
+\.
+
+SELECT * FROM transition_test ORDER BY time;
+
+-- Tables with statement-level triggers with transition tables can be
+-- turned into hypertables, but not those with row-level ones
+CREATE TABLE transition_test2(time bigint NOT NULL, value int);
+CREATE TRIGGER transition_test2_trigger
+    AFTER INSERT ON transition_test2 REFERENCING NEW TABLE AS new_rows
+    FOR EACH STATEMENT EXECUTE PROCEDURE transition_test_fn();
+SELECT create_hypertable('transition_test2', 'time', chunk_time_interval => 10);
+INSERT INTO transition_test2 VALUES (1, 1), (11, 2), (21, 3);
+
+CREATE TABLE transition_test3(time bigint NOT NULL, value int);
+CREATE TRIGGER transition_test3_trigger
+    AFTER INSERT ON transition_test3 REFERENCING NEW TABLE AS new_rows
+    FOR EACH ROW EXECUTE PROCEDURE transition_test_fn();
+\set ON_ERROR_STOP 0
+SELECT create_hypertable('transition_test3', 'time');
+\set ON_ERROR_STOP 1
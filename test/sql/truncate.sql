@@ -69,3 +69,10 @@ TRUNCATE "two_Partitions", truncate_normal CASCADE;
 SELECT * FROM test.show_subtables('"two_Partitions"');
 SELECT * FROM "two_Partitions";
 SELECT * FROM truncate_normal;
+
+-- tables that inherit from a hypertable without being chunks are truncated
+-- like the chunks, but not dropped
+CREATE TABLE truncate_child () INHERITS ("two_Partitions");
+TRUNCATE "two_Partitions";
+SELECT * FROM test.show_subtables('"two_Partitions"');
+DROP TABLE truncate_child;
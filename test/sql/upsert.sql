@@ -71,3 +71,13 @@ WITH CTE AS (
     RETURNING *
 )
 SELECT * FROM CTE;
+
+-- Re-delivered rows across chunks with ON CONFLICT DO NOTHING are routed in
+-- batches. The first of two conflicting rows in a statement wins.
+CREATE TABLE upsert_redelivery(time int PRIMARY KEY, value int);
+SELECT create_hypertable('upsert_redelivery', 'time', chunk_time_interval => 10);
+INSERT INTO upsert_redelivery SELECT i, i FROM generate_series(0, 29, 2) i;
+INSERT INTO upsert_redelivery SELECT i % 30, i FROM generate_series(0, 59, 3) i
+ON CONFLICT (time) DO NOTHING;
+SELECT count(*), sum(time), sum(value) FROM upsert_redelivery;
+SELECT * FROM upsert_redelivery WHERE time % 2 = 1 ORDER BY time;
@@ -33,3 +33,50 @@ INSERT INTO vacuum_norm VALUES ('2017-01-20T09:00:01', 17.5),
                                ('2017-06-21T09:00:01', 11.0);
 
 VACUUM (VERBOSE, ANALYZE) vacuum_norm;
+
+-- Wait until the statistics collector has counted the given number of
+-- vacuums and dead rows of the chunks of a hypertable
+CREATE OR REPLACE FUNCTION wait_for_chunk_stats(hypertable REGCLASS, min_vacuums BIGINT, min_dead BIGINT)
+RETURNS VOID LANGUAGE PLPGSQL AS
+$BODY$
+DECLARE
+    stats RECORD;
+BEGIN
+    FOR i IN 1 .. 300 LOOP
+        SELECT sum(s.vacuum_count) AS vacuums, sum(s.n_dead_tup) AS dead INTO stats
+        FROM pg_stat_user_tables s
+        INNER JOIN pg_inherits inh ON (inh.inhrelid = s.relid)
+        WHERE inh.inhparent = hypertable;
+        EXIT WHEN stats.vacuums >= min_vacuums AND stats.dead >= min_dead;
+        PERFORM pg_sleep(0.1);
+        PERFORM pg_stat_clear_snapshot();
+    END LOOP;
+END;
+$BODY$;
+
+-- Skipping unchanged chunks, with the changed chunks vacuumed by workers
+CREATE TABLE vacuum_skip(time int NOT NULL, value int) WITH (autovacuum_enabled = false);
+SELECT create_hypertable('vacuum_skip', 'time', chunk_time_interval => 10);
+INSERT INTO vacuum_skip SELECT t, t FROM generate_series(0, 39) t;
+VACUUM vacuum_skip;
+SELECT wait_for_chunk_stats('vacuum_skip', 4, 0);
+
+SET timescaledb.vacuum_skip_unchanged_chunks = 'on';
+SET timescaledb.max_maintenance_workers = 2;
+DELETE FROM vacuum_skip WHERE time IN (15, 25);
+-- force the rate-limiting of pgstat_report_stat() to send the deleted rows
+SELECT pg_sleep(1.0);
+SELECT wait_for_chunk_stats('vacuum_skip', 4, 2);
+
+-- only the two chunks with deleted rows are vacuumed again
+VACUUM vacuum_skip;
+SELECT wait_for_chunk_stats('vacuum_skip', 6, 0);
+SELECT c.relname, s.vacuum_count, s.n_dead_tup
+FROM pg_stat_user_tables s
+INNER JOIN pg_class c ON (c.oid = s.relid)
+INNER JOIN pg_inherits inh ON (inh.inhrelid = s.relid)
+WHERE inh.inhparent = 'vacuum_skip'::regclass
+ORDER BY c.relname;
+
+RESET timescaledb.vacuum_skip_unchanged_chunks;
+RESET timescaledb.max_maintenance_workers;